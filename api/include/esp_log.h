@@ -45,6 +45,7 @@ extern "C" {
 #define esp_log_level_t		wise_log_level_t
 
 #define esp_log_write		wise_log_write
+#define esp_log_level_set	wise_log_level_set
 
 #define ESP_LOGE		WISE_LOGE
 #define ESP_LOGW		WISE_LOGW
@@ -46,6 +46,23 @@ extern "C" {
   * @return others : fail
   */
 typedef wise_err_t (*system_event_cb_t)(void *ctx, system_event_t *event);
+
+/** Subscribe to every event ID */
+#define WISE_EVENT_ANY		SYSTEM_EVENT_MAX
+
+/**
+  * @brief  Event loop statistics
+  */
+typedef struct {
+    uint32_t sent;        /**< events passed to wise_event_send */
+    uint32_t delivered;   /**< events dispatched to the handlers */
+    uint32_t coalesced;   /**< events merged into a queued one of the same ID */
+    uint32_t dropped;     /**< events dropped because the queue was full */
+    uint32_t by_ref;      /**< events passed by reference */
+    uint32_t queued;      /**< events in the queue now */
+    uint32_t max_depth;   /**< most events ever in the queue */
+} wise_event_stats_t;
+
 /**
   * @brief  Deinitialize event loop
   *
@@ -88,14 +105,53 @@ wise_err_t wise_event_loop_init(system_event_cb_t cb, void *ctx);
 system_event_cb_t wise_event_loop_set_cb(system_event_cb_t cb, void *ctx);
 
 /**
-  * @brief  Get the queue used by event loop
+  * @brief  Subscribe to an event
+  *
+  * @attention 1. cb is called in the event loop task for every event of ID id,
+  *               after the default handler and the callback of wise_event_loop_set_cb
+  *            2. Subscribers of WISE_EVENT_ANY get every event after those of its ID
+  *
+  * @param  system_event_id_t id : event ID, or WISE_EVENT_ANY
+  * @param  system_event_cb_t cb : callback
+  * @param  void *ctx : passed to cb
+  *
+  * @return WISE_OK : succeed
+  * @return WISE_ERR_NO_MEM : more than CONFIG_WISE_EVENT_SUBSCRIBERS subscribers
+  */
+wise_err_t wise_event_subscribe(system_event_id_t id, system_event_cb_t cb, void *ctx);
+
+/**
+  * @brief  Unsubscribe from an event
   *
-  * @attention : currently this API is used to initialize "q" parameter
-  * of wifi_init structure.
+  * @return WISE_OK : succeed
+  * @return WISE_ERR_NOT_FOUND : no such subscriber
+  */
+wise_err_t wise_event_unsubscribe(system_event_id_t id, system_event_cb_t cb, void *ctx);
+
+/**
+  * @brief  Coalesce events of an ID
   *
-  * @return QueueHandle_t : event queue handle
+  * @attention 1. An event of a coalescing ID that has not been handled yet is
+  *               replaced by a newer one, which never takes another queue slot
+  *            2. The newer event is delivered in the place of the one it replaced,
+  *               so only coalesce IDs whose latest event supersedes the earlier
+  *               ones, like SYSTEM_EVENT_SCAN_DONE, and not SYSTEM_EVENT_STA_STATE_CHANGE
+  *
+  * @param  system_event_id_t id : event ID
+  * @param  bool enable : true to coalesce
+  *
+  * @return WISE_OK : succeed
+  */
+wise_err_t wise_event_set_coalesce(system_event_id_t id, bool enable);
+
+/**
+  * @brief  Get event loop statistics
+  *
+  * @param  wise_event_stats_t *stats : filled in
+  *
+  * @return WISE_OK : succeed
   */
-osMessageQueueId_t wise_event_loop_get_queue(void);
+wise_err_t wise_event_loop_get_stats(wise_event_stats_t *stats);
 
 
 #ifdef __cplusplus
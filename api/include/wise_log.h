@@ -56,10 +56,25 @@ typedef enum {
  * This function is not intended to be used directly. Instead, use one of
  * WISE_LOGE, WISE_LOGW, WISE_LOGI, WISE_LOGD, WISE_LOGV macros.
  *
- * This function or these macros should not be used from an interrupt.
+ * This function or these macros should not be used from an interrupt,
+ * unless CONFIG_LOG_DEFERRED is enabled.
  */
 void wise_log_write(wise_log_level_t level, const char* tag, const char* format, ...) __attribute__ ((format (printf, 3, 4)));
 
+/**
+ * @brief Set log level for given tag
+ *
+ * Messages of @p tag with a level above @p level are dropped before
+ * their arguments are evaluated. Use "*" to set the level of all tags.
+ * @p tag must stay valid for the lifetime of the program.
+ */
+void wise_log_level_set(const char* tag, wise_log_level_t level);
+
+/**
+ * @brief Get log level for given tag
+ */
+wise_log_level_t wise_log_level_get(const char* tag);
+
 /** @cond */
 
 #ifndef LOG_LOCAL_LEVEL
@@ -111,12 +126,14 @@ void wise_log_write(wise_log_level_t level, const char* tag, const char* format,
         else                                 { wise_log_write(WISE_LOG_INFO,       tag, format, ##__VA_ARGS__); } \
     } while(0)
 
-/** runtime macro to output logs at a specified level. Also check the level with ``LOG_LOCAL_LEVEL``.
+/** runtime macro to output logs at a specified level. Also check the level with ``LOG_LOCAL_LEVEL``
+ *  and with the level set for ``tag``.
  *
  * @see ``printf``, ``WISE_LOG_LEVEL``
  */
 #define WISE_LOG_LEVEL_LOCAL(level, tag, format, ...) do {               \
-        if ( LOG_LOCAL_LEVEL >= level ) WISE_LOG_LEVEL(level, tag, format, ##__VA_ARGS__); \
+        if ( LOG_LOCAL_LEVEL >= level && wise_log_level_get(tag) >= level ) \
+            WISE_LOG_LEVEL(level, tag, format, ##__VA_ARGS__); \
     } while(0)
 
 #ifdef __cplusplus
@@ -178,6 +178,7 @@ int scm_uart_init(enum scm_uart_idx idx, struct scm_uart_cfg *cfg)
     uart_cfg.parity = cfg->parity;
     uart_cfg.stop_bits = cfg->stop_bits;
     uart_cfg.dma_en = cfg->dma_en;
+    uart_cfg.rx_idle = 0;
 
     arg.cfg = &uart_cfg;
     arg.cb = uart_notify;
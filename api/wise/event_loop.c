@@ -23,25 +23,127 @@
 #include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdio.h>
 
 #include "cmsis_os.h"
 
+#include <hal/kernel.h>
+#include <hal/irq.h>
+
 #include "lwip/netif.h"
 #include "lwip/netifapi.h"
 
+#include "mem_slab.h"
+
 #include "wise_err.h"
 #include "wise_log.h"
 #include "wise_wifi.h"
 #include "wise_event.h"
 #include "wise_event_loop.h"
 
+/*
+ * Events are queued in a ring of slots. The payload of an event is only
+ * as large as the event_info member its ID uses; up to
+ * CONFIG_WISE_EVENT_INLINE_SIZE bytes of it are kept in the slot, and
+ * larger events are copied once into a block of a mem_slab that is then
+ * handed to the handlers as is.
+ *
+ * An event of a coalescing ID that is still queued is overwritten by a
+ * newer one instead of taking another slot. Events that find the ring
+ * full are dropped and counted.
+ */
+
+#define EVENT_FLAG_PENDING	0x0001
+
+#define EVENT_INFO(m)		sizeof(((system_event_info_t *)0)->m)
+
+enum {
+	EVENT_INLINE,
+	EVENT_SLAB,
+	EVENT_HEAP,
+};
+
+struct wise_event_slot {
+	system_event_id_t id;
+	uint8_t where;
+	uint8_t len;
+	char ifname[8];
+	union {
+		uint32_t data[(CONFIG_WISE_EVENT_INLINE_SIZE + 3) / 4];
+		system_event_t *ref;
+	} u;
+};
+
+_Static_assert(SYSTEM_EVENT_MAX <= 32, "too many events for the coalesce mask");
+_Static_assert(CONFIG_WISE_EVENT_INLINE_SIZE <= 255, "inline payload too large");
+
+struct wise_event_sub {
+	system_event_cb_t cb;
+	void *ctx;
+	struct wise_event_sub *next;
+};
+
+/* Payload size per ID, 0 for the whole of event_info. */
+static const uint8_t s_event_info_size[SYSTEM_EVENT_MAX] = {
+	[SYSTEM_EVENT_SCAN_DONE]		= EVENT_INFO(scan_done),
+	[SYSTEM_EVENT_STA_CONNECTED]		= EVENT_INFO(connected),
+	[SYSTEM_EVENT_STA_DISCONNECTED]		= EVENT_INFO(disconnected),
+	[SYSTEM_EVENT_STA_AUTHMODE_CHANGE]	= EVENT_INFO(auth_change),
+	[SYSTEM_EVENT_STA_GOT_IP]		= EVENT_INFO(got_ip),
+	[SYSTEM_EVENT_STA_LOST_IP]		= EVENT_INFO(got_ip),
+	[SYSTEM_EVENT_STA_WPS_ER_FAILED]	= EVENT_INFO(sta_er_fail_reason),
+	[SYSTEM_EVENT_STA_WPS_ER_PIN]		= EVENT_INFO(sta_er_pin),
+	[SYSTEM_EVENT_STA_STATE_CHANGE]		= EVENT_INFO(sta_state_change),
+	[SYSTEM_EVENT_AP_STACONNECTED]		= EVENT_INFO(sta_connected),
+	[SYSTEM_EVENT_AP_STADISCONNECTED]	= EVENT_INFO(sta_disconnected),
+	[SYSTEM_EVENT_AP_PROBEREQRECVED]	= EVENT_INFO(ap_probereqrecved),
+	[SYSTEM_EVENT_GOT_IP6]			= EVENT_INFO(got_ip6),
+	[SYSTEM_EVENT_SCM_CHANNEL]		= EVENT_INFO(scm_channel_msg),
+	[SYSTEM_EVENT_SCM_LINK_UP]		= EVENT_INFO(connected),
+};
+
 static const char* TAG __maybe_unused = "event";
 static bool s_event_init_flag = false;
-static osMessageQueueId_t s_event_queue = NULL;
 static system_event_cb_t s_event_handler_cb = NULL;
 static void *s_event_ctx = NULL;
 static osThreadId_t *s_event_thread = NULL;
 
+static struct wise_event_slot s_event_ring[CONFIG_WISE_EVENT_QUEUE_LEN];
+static uint16_t s_event_head;
+static uint16_t s_event_used;
+/* Slot index + 1 of the queued event of a coalescing ID */
+static uint16_t s_event_pending[SYSTEM_EVENT_MAX];
+static uint32_t s_event_coalesce;
+static bool s_event_overflow;
+
+static struct mem_slab s_event_slab;
+static void *s_event_slab_buf;
+
+/* Per-ID subscriber lists, and one for any ID at SYSTEM_EVENT_MAX */
+static struct wise_event_sub *s_event_subs[SYSTEM_EVENT_MAX + 1];
+static struct wise_event_sub s_event_sub_pool[CONFIG_WISE_EVENT_SUBSCRIBERS];
+static int s_event_sub_used;
+
+static wise_event_stats_t s_event_stats;
+static uint16_t s_event_dropped[SYSTEM_EVENT_MAX];
+static uint16_t s_event_coalesced[SYSTEM_EVENT_MAX];
+
+static size_t wise_event_info_size(system_event_id_t id)
+{
+	if (id >= SYSTEM_EVENT_MAX || s_event_info_size[id] == 0)
+		return sizeof(system_event_info_t);
+
+	return s_event_info_size[id];
+}
+
+static void wise_event_ref_free(uint8_t where, system_event_t *ref)
+{
+	if (where == EVENT_SLAB)
+		mem_slab_free(&s_event_slab, ref);
+	else if (where == EVENT_HEAP)
+		free(ref);
+}
+
 static wise_err_t wise_event_post_to_user(system_event_t *event)
 {
 	if (s_event_handler_cb)
@@ -50,18 +152,86 @@ static wise_err_t wise_event_post_to_user(system_event_t *event)
 	return WISE_OK;
 }
 
+static void wise_event_post_to_subs(struct wise_event_sub *sub,
+				    system_event_t *event)
+{
+	system_event_cb_t cb;
+
+	for (; sub; sub = sub->next) {
+		cb = sub->cb;
+		if (cb && (*cb)(sub->ctx, event) != WISE_OK)
+			WISE_LOGW(TAG, "subscriber %p failed e=%d", cb,
+				  event->event_id);
+	}
+}
+
+static void wise_event_dispatch(system_event_t *evt)
+{
+	wise_err_t ret = wise_event_process_default(evt);
+	if (ret != WISE_OK)
+		WISE_LOGE(TAG, "default event handler failed!");
+	ret = wise_event_post_to_user(evt);
+	if (ret != WISE_OK)
+		WISE_LOGE(TAG, "post event to user fail!");
+
+	if (evt->event_id < SYSTEM_EVENT_MAX)
+		wise_event_post_to_subs(s_event_subs[evt->event_id], evt);
+	wise_event_post_to_subs(s_event_subs[SYSTEM_EVENT_MAX], evt);
+
+	s_event_stats.delivered++;
+}
+
+/*
+ * Take the oldest event off the ring, into @evt if it is inline.
+ * Returns the event to dispatch, or NULL if there is none.
+ */
+static system_event_t *wise_event_pop(system_event_t *evt, uint8_t *where)
+{
+	struct wise_event_slot *slot;
+	system_event_t *ret = evt;
+	unsigned long flags;
+
+	local_irq_save(flags);
+
+	if (s_event_used == 0) {
+		local_irq_restore(flags);
+		return NULL;
+	}
+
+	slot = &s_event_ring[s_event_head];
+	if (slot->id < SYSTEM_EVENT_MAX
+	    && s_event_pending[slot->id] == s_event_head + 1)
+		s_event_pending[slot->id] = 0;
+
+	*where = slot->where;
+	if (slot->where == EVENT_INLINE) {
+		memcpy(evt->ifname, slot->ifname, sizeof(evt->ifname));
+		evt->event_id = slot->id;
+		memcpy(&evt->event_info, slot->u.data, slot->len);
+	} else {
+		ret = slot->u.ref;
+	}
+
+	s_event_head = (s_event_head + 1) % CONFIG_WISE_EVENT_QUEUE_LEN;
+	s_event_used--;
+
+	local_irq_restore(flags);
+
+	return ret;
+}
+
 static void wise_event_loop_task(void *pvParameters)
 {
+	system_event_t evt, *e;
+	uint8_t where;
+
 	while (s_event_init_flag) {
-	    system_event_t evt;
-	    if (osMessageQueueGet(s_event_queue, &evt, NULL, osWaitForever) == osOK) {
-		    wise_err_t ret = wise_event_process_default(&evt);
-		    if (ret != WISE_OK)
-			    WISE_LOGE(TAG, "default event handler failed!");
-		    ret = wise_event_post_to_user(&evt);
-		    if (ret != WISE_OK)
-			    WISE_LOGE(TAG, "post event to user fail!");
-	    }
+		osThreadFlagsWait(EVENT_FLAG_PENDING, osFlagsWaitAny, osWaitForever);
+
+		while ((e = wise_event_pop(&evt, &where)) != NULL) {
+			wise_event_dispatch(e);
+			wise_event_ref_free(where, e);
+		}
 	}
 }
 
@@ -73,28 +243,203 @@ system_event_cb_t wise_event_loop_set_cb(system_event_cb_t cb, void *ctx)
 	return old_cb;
 }
 
+wise_err_t wise_event_subscribe(system_event_id_t id, system_event_cb_t cb,
+				void *ctx)
+{
+	struct wise_event_sub *sub;
+	unsigned long flags;
+
+	if (id > SYSTEM_EVENT_MAX || cb == NULL)
+		return WISE_ERR_INVALID_ARG;
+
+	local_irq_save(flags);
+
+	/*
+	 * Nodes stay on the list they were first put on, so that the loop
+	 * task can walk it without a lock; an unsubscribed one is reused.
+	 */
+	for (sub = s_event_subs[id]; sub; sub = sub->next) {
+		if (sub->cb == NULL)
+			break;
+	}
+	if (sub == NULL && s_event_sub_used < CONFIG_WISE_EVENT_SUBSCRIBERS) {
+		sub = &s_event_sub_pool[s_event_sub_used++];
+		sub->cb = NULL;
+		sub->next = s_event_subs[id];
+		s_event_subs[id] = sub;
+	}
+	if (sub) {
+		sub->ctx = ctx;
+		sub->cb = cb;
+	}
+
+	local_irq_restore(flags);
+
+	return sub ? WISE_OK : WISE_ERR_NO_MEM;
+}
+
+wise_err_t wise_event_unsubscribe(system_event_id_t id, system_event_cb_t cb,
+				  void *ctx)
+{
+	struct wise_event_sub *sub;
+	unsigned long flags;
+	wise_err_t ret = WISE_ERR_NOT_FOUND;
+
+	if (id > SYSTEM_EVENT_MAX)
+		return WISE_ERR_INVALID_ARG;
+
+	local_irq_save(flags);
+
+	for (sub = s_event_subs[id]; sub; sub = sub->next) {
+		if (sub->cb == cb && sub->ctx == ctx) {
+			sub->cb = NULL;
+			ret = WISE_OK;
+			break;
+		}
+	}
+
+	local_irq_restore(flags);
+
+	return ret;
+}
+
+wise_err_t wise_event_set_coalesce(system_event_id_t id, bool enable)
+{
+	unsigned long flags;
+
+	if (id >= SYSTEM_EVENT_MAX)
+		return WISE_ERR_INVALID_ARG;
+
+	local_irq_save(flags);
+
+	if (enable) {
+		s_event_coalesce |= 1UL << id;
+	} else {
+		s_event_coalesce &= ~(1UL << id);
+		s_event_pending[id] = 0;
+	}
+
+	local_irq_restore(flags);
+
+	return WISE_OK;
+}
+
 wise_err_t wise_event_send(system_event_t *event)
 {
-	if (s_event_queue == NULL) {
+	struct wise_event_slot *slot;
+	system_event_t *ref = NULL, *old_ref = NULL;
+	uint8_t where = EVENT_INLINE, old_where = EVENT_INLINE;
+	size_t len;
+	unsigned long flags;
+	uint16_t idx;
+	bool coalesce;
+
+	if (s_event_thread == NULL) {
 		WISE_LOGE(TAG, "Event loop not initialized via wise_event_loop_init, "
 				"but wise_event_send called");
 		return WISE_ERR_INVALID_STATE;
 	}
 
-	osStatus_t ret = osMessageQueuePut(s_event_queue, event, 0, 0);
-	if (ret != osOK) {
-		if (event)
+	if (event == NULL) {
+		WISE_LOGE(TAG, "e null");
+		return WISE_FAIL;
+	}
+
+	len = wise_event_info_size(event->event_id);
+	if (len > CONFIG_WISE_EVENT_INLINE_SIZE) {
+		/* Copied once here, and handed to the handlers from there. */
+		if (mem_slab_alloc_isr(&s_event_slab, (void **)&ref) == 0) {
+			where = EVENT_SLAB;
+		} else if ((ref = malloc(sizeof(*ref))) != NULL) {
+			where = EVENT_HEAP;
+		} else {
+			len = 0;
+		}
+		if (ref)
+			memcpy(ref, event, sizeof(*ref));
+	}
+
+	coalesce = event->event_id < SYSTEM_EVENT_MAX
+		&& (s_event_coalesce & (1UL << event->event_id));
+
+	local_irq_save(flags);
+
+	s_event_stats.sent++;
+
+	if (len == 0) {
+		slot = NULL;
+	} else if (coalesce && s_event_pending[event->event_id]) {
+		idx = s_event_pending[event->event_id] - 1;
+		slot = &s_event_ring[idx];
+		old_where = slot->where;
+		old_ref = slot->u.ref;
+		s_event_stats.coalesced++;
+		s_event_coalesced[event->event_id]++;
+	} else if (s_event_used < CONFIG_WISE_EVENT_QUEUE_LEN) {
+		idx = (s_event_head + s_event_used) % CONFIG_WISE_EVENT_QUEUE_LEN;
+		slot = &s_event_ring[idx];
+		s_event_used++;
+		if (s_event_used > s_event_stats.max_depth)
+			s_event_stats.max_depth = s_event_used;
+		if (coalesce)
+			s_event_pending[event->event_id] = idx + 1;
+	} else {
+		slot = NULL;
+	}
+
+	if (slot) {
+		slot->id = event->event_id;
+		slot->where = where;
+		if (where == EVENT_INLINE) {
+			slot->len = len;
+			memcpy(slot->ifname, event->ifname, sizeof(slot->ifname));
+			memcpy(slot->u.data, &event->event_info, len);
+		} else {
+			slot->u.ref = ref;
+			s_event_stats.by_ref++;
+		}
+		s_event_overflow = false;
+	} else {
+		s_event_stats.dropped++;
+		if (event->event_id < SYSTEM_EVENT_MAX)
+			s_event_dropped[event->event_id]++;
+		old_where = where;
+		old_ref = ref;
+	}
+
+	local_irq_restore(flags);
+
+	/* What got replaced, or did not make it */
+	if (old_where != EVENT_INLINE)
+		wise_event_ref_free(old_where, old_ref);
+
+	if (slot == NULL) {
+		/* Once per overflow; the rest only shows in the statistics. */
+		if (!s_event_overflow) {
+			s_event_overflow = true;
 			WISE_LOGE(TAG, "e=%d f", event->event_id);
-		else
-			WISE_LOGE(TAG, "e null");
+		}
 		return WISE_FAIL;
 	}
+
+	osThreadFlagsSet(s_event_thread, EVENT_FLAG_PENDING);
+
 	return WISE_OK;
 }
 
-osMessageQueueId_t wise_event_loop_get_queue(void)
+wise_err_t wise_event_loop_get_stats(wise_event_stats_t *stats)
 {
-	return s_event_queue;
+	unsigned long flags;
+
+	if (stats == NULL)
+		return WISE_ERR_INVALID_ARG;
+
+	local_irq_save(flags);
+	memcpy(stats, &s_event_stats, sizeof(*stats));
+	stats->queued = s_event_used;
+	local_irq_restore(flags);
+
+	return WISE_OK;
 }
 
 bool wise_event_get_init_flag(void) {
@@ -108,42 +453,112 @@ wise_err_t wise_event_loop_init(system_event_cb_t cb, void *ctx)
 		.stack_size = 3 * 1024,
 		.priority = osPriorityNormal,
 	};
+	size_t bsize = WB_UP(sizeof(system_event_t));
 
 	if (s_event_init_flag)
 		return WISE_FAIL;
 
 	s_event_init_flag = true;
 
-	s_event_queue = osMessageQueueNew(16, sizeof(system_event_t), NULL);
-	if (s_event_queue == NULL)
-		return WISE_ERR_NO_MEM;
+	s_event_head = s_event_used = 0;
+	memset(s_event_pending, 0, sizeof(s_event_pending));
+	memset(&s_event_stats, 0, sizeof(s_event_stats));
+	memset(s_event_dropped, 0, sizeof(s_event_dropped));
+	memset(s_event_coalesced, 0, sizeof(s_event_coalesced));
+	s_event_overflow = false;
 
-	s_event_thread = osThreadNew(wise_event_loop_task, NULL, &attr);
+	s_event_coalesce = 0;
+#ifdef CONFIG_WISE_EVENT_COALESCE_SCAN_DONE
+	s_event_coalesce |= 1UL << SYSTEM_EVENT_SCAN_DONE;
+#endif
 
-	if (s_event_thread == NULL)
+	s_event_slab_buf = malloc(bsize * CONFIG_WISE_EVENT_REF_NUM);
+	if (s_event_slab_buf == NULL
+	    || mem_slab_init(&s_event_slab, s_event_slab_buf, bsize,
+			     CONFIG_WISE_EVENT_REF_NUM)) {
+		free(s_event_slab_buf);
+		s_event_slab_buf = NULL;
+		s_event_init_flag = false;
 		return WISE_ERR_NO_MEM;
+	}
 
 	s_event_handler_cb = cb;
 	s_event_ctx = ctx;
 
+	s_event_thread = osThreadNew(wise_event_loop_task, NULL, &attr);
+
+	if (s_event_thread == NULL) {
+		mem_slab_deinit(&s_event_slab);
+		free(s_event_slab_buf);
+		s_event_slab_buf = NULL;
+		s_event_handler_cb = NULL;
+		s_event_ctx = NULL;
+		s_event_init_flag = false;
+		return WISE_ERR_NO_MEM;
+	}
+
 	return WISE_OK;
 }
 
 wise_err_t wise_event_loop_deinit(void)
 {
+	system_event_t evt, *e;
+	uint8_t where;
+
 	if (!s_event_init_flag)
 		return WISE_FAIL;
 
 	if (s_event_thread)
 		osThreadTerminate(s_event_thread);
+	s_event_thread = NULL;
+
+	/* Whatever is still queued goes unhandled. */
+	while ((e = wise_event_pop(&evt, &where)) != NULL)
+		wise_event_ref_free(where, e);
 
-	if (s_event_queue)
-		osMessageQueueDelete(s_event_queue);
+	if (s_event_slab_buf) {
+		mem_slab_deinit(&s_event_slab);
+		free(s_event_slab_buf);
+		s_event_slab_buf = NULL;
+	}
 
-	s_event_queue = NULL;
 	s_event_handler_cb = NULL;
 	s_event_ctx = NULL;
 	s_event_init_flag = false;
 
 	return WISE_OK;
 }
+
+#ifdef CONFIG_CMD_WISE_EVENT
+
+#include <cli.h>
+
+static int do_wevent(int argc, char *argv[])
+{
+	wise_event_stats_t st;
+	int i;
+
+	wise_event_loop_get_stats(&st);
+
+	printf("sent %u delivered %u queued %u max %u/%d\n",
+	       st.sent, st.delivered, st.queued, st.max_depth,
+	       CONFIG_WISE_EVENT_QUEUE_LEN);
+	printf("coalesced %u dropped %u by-ref %u\n",
+	       st.coalesced, st.dropped, st.by_ref);
+
+	for (i = 0; i < SYSTEM_EVENT_MAX; i++) {
+		if (!s_event_dropped[i] && !s_event_coalesced[i])
+			continue;
+		printf("  event %2d: coalesced %u dropped %u\n", i,
+		       s_event_coalesced[i], s_event_dropped[i]);
+	}
+
+	return CMD_RET_SUCCESS;
+}
+
+CMD(wevent, do_wevent,
+	"wevent",
+	"show wise event loop statistics"
+);
+
+#endif
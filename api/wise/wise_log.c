@@ -31,6 +31,12 @@
 #include <assert.h>
 #include <mutex.h>
 
+#include <hal/irq.h>
+#ifdef CONFIG_LOG_DEFERRED
+#include <hal/console.h>
+#include <blog.h>
+#endif
+
 #include "wise_log.h"
 
 #define LOG_COLOR           "\033[0;%dm"
@@ -58,9 +64,105 @@ static const char s_log_prefix[WISE_LOG_MAX] = {
 	'V', //  WISE_LOG_VERBOSE
 };
 
+struct wise_log_tag {
+	const char *name;
+	uint8_t level;
+};
+
+static struct wise_log_tag s_log_tags[CONFIG_LOG_TAG_MAX];
+static int s_log_ntags;
+static int s_log_last;
+static uint8_t s_log_default = CONFIG_LOG_DEFAULT_LEVEL;
+
 mutex wifi_log_mtx;
 static char log_buf[MAX_LOG_LENGTH];
 
+/*
+ * Look @tag up in the tag table, adding it if there is room.
+ * Tags are expected to be string literals or otherwise static, so the
+ * pointer is tried first and strcmp() is only needed for the first
+ * lookup from a new call site.
+ */
+static int wise_log_tag_find(const char *tag)
+{
+	unsigned long flags;
+	int i;
+
+	i = s_log_last;
+	if (i < s_log_ntags && s_log_tags[i].name == tag)
+		return i;
+
+	for (i = 0; i < s_log_ntags; i++)
+		if (s_log_tags[i].name == tag)
+			goto found;
+	for (i = 0; i < s_log_ntags; i++)
+		if (!strcmp(s_log_tags[i].name, tag))
+			goto found;
+
+	local_irq_save(flags);
+	/* Someone may have added it meanwhile. */
+	for (; i < s_log_ntags; i++)
+		if (!strcmp(s_log_tags[i].name, tag))
+			break;
+	if (i == s_log_ntags) {
+		if (i == CONFIG_LOG_TAG_MAX) {
+			local_irq_restore(flags);
+			return -1;
+		}
+		s_log_tags[i].name = tag;
+		s_log_tags[i].level = s_log_default;
+		s_log_ntags++;
+	}
+	local_irq_restore(flags);
+
+ found:
+	s_log_last = i;
+	return i;
+}
+
+/**
+ * @brief Get the log level of a tag
+ */
+wise_log_level_t wise_log_level_get(const char *tag)
+{
+	int i = wise_log_tag_find(tag);
+
+	return i < 0 ? s_log_default : s_log_tags[i].level;
+}
+
+/**
+ * @brief Set the log level of a tag, or of all tags with "*"
+ */
+void wise_log_level_set(const char *tag, wise_log_level_t level)
+{
+	int i;
+
+	if (level >= WISE_LOG_MAX)
+		level = WISE_LOG_VERBOSE;
+
+	if (!strcmp(tag, "*")) {
+		s_log_default = level;
+		for (i = 0; i < s_log_ntags; i++)
+			s_log_tags[i].level = level;
+		return;
+	}
+
+	i = wise_log_tag_find(tag);
+	if (i >= 0)
+		s_log_tags[i].level = level;
+}
+
+#ifdef CONFIG_LOG_DEFERRED
+/* Tag IDs in binary log records are table index + 1; 0 is printk. */
+const char *blog_tag_name(u16 tag)
+{
+	if (tag == BLOG_TAG_KERNEL || tag > s_log_ntags)
+		return "?";
+
+	return s_log_tags[tag - 1].name;
+}
+#endif
+
 static int wise_log_write_str(const char *s, bool color)
 {
 	int len = strlen(s);
@@ -89,15 +191,33 @@ static uint32_t wise_log_timestamp()
 void wise_log_write(wise_log_level_t level, const char *tag,  const char *fmt, ...)
 {
 	va_list va;
-	char prefix = level >= WISE_LOG_MAX ? 'N' : s_log_prefix[level];
+	char prefix;
+	uint32_t color;
+	uint32_t ts;
+	int offset = 0;
+	int i;
+
+	/* Filter before touching the arguments. */
+	i = wise_log_tag_find(tag);
+	if (level > (i < 0 ? s_log_default : s_log_tags[i].level))
+		return;
+
+#ifdef CONFIG_LOG_DEFERRED
+	va_start(va, fmt);
+	blog_vwrite(level, i < 0 ? BLOG_TAG_UNKNOWN : i + 1, fmt, va);
+	va_end(va);
+
+	klogd_kick();
+	return;
+#endif
+
+	prefix = level >= WISE_LOG_MAX ? 'N' : s_log_prefix[level];
 #ifdef CONFIG_LOG_COLORS
-	uint32_t color = level >= WISE_LOG_MAX ? 0 : s_log_color[level];
+	color = level >= WISE_LOG_MAX ? 0 : s_log_color[level];
 #else
-	uint32_t color = 0;
+	color = 0;
 #endif
-
-	uint32_t ts = wise_log_timestamp();
-	int offset = 0;
+	ts = wise_log_timestamp();
 
 	if(wifi_log_mtx.mid == NULL)
 		mtx_init(&wifi_log_mtx, NULL, NULL, MTX_DEF);
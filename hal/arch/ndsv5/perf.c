@@ -0,0 +1,360 @@
+/*
+ * Copyright 2024-2024 Senscomm Semiconductor Co., Ltd.	All rights reserved.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <FreeRTOS/FreeRTOS.h>
+#include <FreeRTOS/task.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <getopt.h>
+
+#include <hal/kernel.h>
+#include <hal/compiler.h>
+#include <hal/init.h>
+#include <hal/irq.h>
+#include <hal/kmem.h>
+#include <cli.h>
+
+#include "core_v5.h"
+#include "perf.h"
+
+#define CSR_MCOUNTINHIBIT	0x320
+#define CSR_MHPMEVENT(n)	(0x320 + (n))
+#define CSR_MCYCLE		0xb00
+#define CSR_MINSTRET		0xb02
+#define CSR_MHPMCOUNTER(n)	(0xb00 + (n))
+#define CSR_MCYCLEH		0xb80
+#define CSR_MINSTRETH		0xb82
+#define CSR_MHPMCOUNTERH(n)	(0xb80 + (n))
+
+/* mcycle, minstret and mhpmcounter3..6 in mcountinhibit */
+#define PERF_INHIBIT_ALL	0x7d
+
+/* Reading the halves of a 64-bit counter on RV32 needs a retry on carry. */
+#define read_csr64(lo, hi) ({					\
+	u32 __h, __l;						\
+	do {							\
+		__h = read_csr(hi);				\
+		__l = read_csr(lo);				\
+	} while (__h != read_csr(hi));				\
+	((u64)__h << 32) | __l;					\
+})
+
+/*
+ * mhpmevent encoding: event index in [8:4], event type in [3:0]
+ * (0: instruction commit, 1: micro-architecture, 2: misprediction).
+ */
+#define HPM_EV(type, idx)	(((idx) << 4) | (type))
+
+static const struct {
+	const char *name;
+	u16 sel;
+} perf_ev[PERF_EV_MAX] = {
+	[PERF_EV_NONE]		= { "none",		0 },
+	[PERF_EV_LOAD]		= { "load",		HPM_EV(0, 3) },
+	[PERF_EV_STORE]		= { "store",		HPM_EV(0, 4) },
+	[PERF_EV_BRANCH]	= { "branch",		HPM_EV(0, 8) },
+	[PERF_EV_BRANCH_TAKEN]	= { "branch_taken",	HPM_EV(0, 9) },
+	[PERF_EV_JALR]		= { "jalr",		HPM_EV(0, 11) },
+	[PERF_EV_ILM]		= { "ilm",		HPM_EV(1, 0) },
+	[PERF_EV_DLM]		= { "dlm",		HPM_EV(1, 1) },
+	[PERF_EV_ICACHE]	= { "icache",		HPM_EV(1, 2) },
+	[PERF_EV_ICACHE_MISS]	= { "icache_miss",	HPM_EV(1, 3) },
+	[PERF_EV_DCACHE]	= { "dcache",		HPM_EV(1, 4) },
+	[PERF_EV_DCACHE_MISS]	= { "dcache_miss",	HPM_EV(1, 5) },
+	[PERF_EV_ICACHE_STALL]	= { "icache_stall",	HPM_EV(1, 11) },
+	[PERF_EV_DCACHE_STALL]	= { "dcache_stall",	HPM_EV(1, 12) },
+	[PERF_EV_UNCACHED_FETCH] = { "uncached_fetch",	HPM_EV(1, 13) },
+	[PERF_EV_BRANCH_MISS]	= { "branch_miss",	HPM_EV(2, 0) },
+	[PERF_EV_TARGET_MISS]	= { "target_miss",	HPM_EV(2, 2) },
+};
+
+static enum perf_event perf_hpm[PERF_NR_HPM] = {
+	PERF_EV_ICACHE_MISS,
+	PERF_EV_DCACHE_MISS,
+	PERF_EV_BRANCH,
+	PERF_EV_BRANCH_MISS,
+};
+
+/* Task being counted by 'perf stat -t', NULL when counting everything. */
+extern void * volatile pxCurrentTCB;
+static void *perf_task;
+static bool perf_task_on;
+
+static void perf_hpm_write(int hpm, u32 sel)
+{
+	switch (hpm) {
+	case 0:
+		write_csr(CSR_MHPMEVENT(3), sel);
+		break;
+	case 1:
+		write_csr(CSR_MHPMEVENT(4), sel);
+		break;
+	case 2:
+		write_csr(CSR_MHPMEVENT(5), sel);
+		break;
+	case 3:
+		write_csr(CSR_MHPMEVENT(6), sel);
+		break;
+	}
+}
+
+/**
+ * perf_event_set() - select the event counted by mhpmcounter(3 + @hpm)
+ */
+int perf_event_set(int hpm, enum perf_event ev)
+{
+	if (hpm < 0 || hpm >= PERF_NR_HPM || ev >= PERF_EV_MAX)
+		return -EINVAL;
+
+	perf_hpm[hpm] = ev;
+	perf_hpm_write(hpm, perf_ev[ev].sel);
+
+	return 0;
+}
+
+enum perf_event perf_event_get(int hpm)
+{
+	if (hpm < 0 || hpm >= PERF_NR_HPM)
+		return PERF_EV_NONE;
+
+	return perf_hpm[hpm];
+}
+
+/**
+ * perf_read() - snapshot all counters
+ */
+void perf_read(struct perf_ctr *c)
+{
+	unsigned long flags;
+
+	local_irq_save(flags);
+	c->v[0] = read_csr64(CSR_MCYCLE, CSR_MCYCLEH);
+	c->v[1] = read_csr64(CSR_MINSTRET, CSR_MINSTRETH);
+	c->v[2] = read_csr64(CSR_MHPMCOUNTER(3), CSR_MHPMCOUNTERH(3));
+	c->v[3] = read_csr64(CSR_MHPMCOUNTER(4), CSR_MHPMCOUNTERH(4));
+	c->v[4] = read_csr64(CSR_MHPMCOUNTER(5), CSR_MHPMCOUNTERH(5));
+	c->v[5] = read_csr64(CSR_MHPMCOUNTER(6), CSR_MHPMCOUNTERH(6));
+	local_irq_restore(flags);
+}
+
+/**
+ * perf_end() - turn the snapshot taken by perf_begin() into the deltas
+ */
+void perf_end(struct perf_ctr *c)
+{
+	struct perf_ctr now;
+	int i;
+
+	perf_read(&now);
+	for (i = 0; i < PERF_NR_CTR; i++)
+		c->v[i] = now.v[i] - c->v[i];
+}
+
+void perf_print(const struct perf_ctr *c)
+{
+	u32 ipc = c->v[0] ? (u32)(c->v[1] * 100 / c->v[0]) : 0;
+	int i;
+
+	printf("%14llu  cycles\n", c->v[0]);
+	printf("%14llu  instructions  (%u.%02u IPC)\n", c->v[1],
+	       ipc / 100, ipc % 100);
+	for (i = 0; i < PERF_NR_HPM; i++) {
+		if (perf_hpm[i] == PERF_EV_NONE)
+			continue;
+		printf("%14llu  %s\n", c->v[2 + i], perf_ev[perf_hpm[i]].name);
+	}
+}
+
+/*
+ * Called on every return from trap (see portASM.S), after a possible
+ * context switch. Counting is turned on only while perf_task runs;
+ * interrupts taken meanwhile are charged to it.
+ */
+__ilm__ void perf_task_switch(void)
+{
+	bool on;
+
+	if (perf_task == NULL)
+		return;
+
+	on = (pxCurrentTCB == perf_task);
+	if (on == perf_task_on)
+		return;
+
+	write_csr(CSR_MCOUNTINHIBIT, on ? 0 : PERF_INHIBIT_ALL);
+	perf_task_on = on;
+}
+
+static void *perf_task_lookup(const char *name)
+{
+	TaskStatus_t *tasks;
+	void *handle = NULL;
+	int i, n;
+
+	n = uxTaskGetNumberOfTasks();
+	tasks = kmalloc(n * sizeof(*tasks));
+	if (tasks == NULL)
+		return NULL;
+
+	n = uxTaskGetSystemState(tasks, n, NULL);
+	for (i = 0; i < n; i++) {
+		if (!strcmp(tasks[i].pcTaskName, name)) {
+			handle = tasks[i].xHandle;
+			break;
+		}
+	}
+	kfree(tasks);
+
+	return handle;
+}
+
+static int perf_lookup(const char *name)
+{
+	int i;
+
+	for (i = 0; i < PERF_EV_MAX; i++)
+		if (!strcmp(name, perf_ev[i].name))
+			return i;
+
+	return -1;
+}
+
+/*
+ * perf CLI commands
+ */
+
+static int perf_list(int argc, char *argv[])
+{
+	int i, j;
+
+	for (i = 1; i < PERF_EV_MAX; i++) {
+		for (j = 0; j < PERF_NR_HPM; j++)
+			if (perf_hpm[j] == i)
+				break;
+		printf("  %c %s\n", j < PERF_NR_HPM ? '*' : ' ', perf_ev[i].name);
+	}
+
+	return CMD_RET_SUCCESS;
+}
+
+/* -e takes up to PERF_NR_HPM comma separated event names. */
+static int perf_parse_events(char *arg)
+{
+	enum perf_event ev[PERF_NR_HPM] = { PERF_EV_NONE, };
+	char *name;
+	int i = 0, e;
+
+	while ((name = strsep(&arg, ",")) != NULL) {
+		e = perf_lookup(name);
+		if (e < 0 || i == PERF_NR_HPM) {
+			printf("bad event %s\n", name);
+			return -EINVAL;
+		}
+		ev[i++] = e;
+	}
+
+	for (i = 0; i < PERF_NR_HPM; i++)
+		perf_event_set(i, ev[i]);
+
+	return 0;
+}
+
+static int perf_stat(int argc, char *argv[])
+{
+	struct perf_ctr c;
+	void *task = NULL;
+	int opt, ms = 1000;
+
+	optind = 1;
+	while ((opt = getopt(argc, argv, "e:t:")) != -1) {
+		switch (opt) {
+		case 'e':
+			if (perf_parse_events(optarg))
+				return CMD_RET_FAILURE;
+			break;
+		case 't':
+			task = perf_task_lookup(optarg);
+			if (task == NULL) {
+				printf("no task %s\n", optarg);
+				return CMD_RET_FAILURE;
+			}
+			break;
+		default:
+			return CMD_RET_USAGE;
+		}
+	}
+	if (optind < argc)
+		ms = atoi(argv[optind]);
+
+	if (task) {
+		write_csr(CSR_MCOUNTINHIBIT, PERF_INHIBIT_ALL);
+		perf_task_on = false;
+		perf_task = task;
+	}
+
+	perf_begin(&c);
+	vTaskDelay(pdMS_TO_TICKS(ms));
+	perf_end(&c);
+
+	if (task) {
+		perf_task = NULL;
+		write_csr(CSR_MCOUNTINHIBIT, 0);
+	}
+
+	perf_print(&c);
+
+	return CMD_RET_SUCCESS;
+}
+
+static const struct cli_cmd perf_cmd[] = {
+	CMDENTRY(list, perf_list, "", ""),
+	CMDENTRY(stat, perf_stat, "", ""),
+};
+
+static int do_perf(int argc, char *argv[])
+{
+	const struct cli_cmd *cmd;
+
+	argc--;
+	argv++;
+
+	if (argc == 0)
+		return CMD_RET_USAGE;
+
+	cmd = cli_find_cmd(argv[0], perf_cmd, ARRAY_SIZE(perf_cmd));
+	if (cmd == NULL)
+		return CMD_RET_USAGE;
+
+	return cmd->handler(argc, argv);
+}
+
+CMD(perf, do_perf,
+	"hardware performance counters",
+	"perf list" OR
+	"perf stat [-e event[,event...]] [-t task] [ms]"
+);
+
+static int perf_init(void)
+{
+	int i;
+
+	write_csr(CSR_MCOUNTINHIBIT, 0);
+	for (i = 0; i < PERF_NR_HPM; i++)
+		perf_hpm_write(i, perf_ev[perf_hpm[i]].sel);
+
+	return 0;
+}
+__initcall__(arch, perf_init);
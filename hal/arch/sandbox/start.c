@@ -0,0 +1,70 @@
+/*
+ * Copyright 2024-2024 Senscomm Semiconductor Co., Ltd.	All rights reserved.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#define __USE_NATIVE_HEADER__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <getopt.h>
+
+#include <hal/kernel.h>
+
+/*
+ * Sandbox entry point.
+ *
+ * Everything else is built with -Dmain=wise_main, so this is the only
+ * main() the host C runtime sees. It plays the part of reset_handler():
+ * there are no sections to relocate and no CPU to set up, so all that
+ * is left is to parse the command line and start the kernel.
+ */
+
+#undef main
+
+extern void start_kernel(void);
+
+const char *sandbox_flash_image;
+const char *sandbox_tap_name;
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "usage: %s [-f flash.img] [-t tapN]\n", prog);
+	exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[])
+{
+	int opt;
+
+	while ((opt = getopt(argc, argv, "f:t:h")) != -1) {
+		switch (opt) {
+		case 'f':
+			sandbox_flash_image = optarg;
+			break;
+		case 't':
+			sandbox_tap_name = optarg;
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+
+	/* A closed console or peer must not kill the whole system. */
+	signal(SIGPIPE, SIG_IGN);
+
+	start_kernel();
+
+	/* Never go back here! */
+	return EXIT_FAILURE;
+}
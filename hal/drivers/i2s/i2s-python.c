@@ -1016,7 +1016,7 @@ static int dma_rx_callback(void *priv, dma_isr_status status)
 #endif
 
 	/* Prepare to receive the next data block */
-	ret = mem_slab_alloc(stream->cfg.mem_slab, &stream->mem_block, 0);
+	ret = mem_slab_alloc_isr(stream->cfg.mem_slab, &stream->mem_block);
 	if (ret < 0) {
 		stream->state = I2S_STATE_ERROR;
 		goto rx_disable;
@@ -1046,7 +1046,7 @@ static int dma_rx_callback(void *priv, dma_isr_status status)
 
 rx_disable:
     if (mblk_tmp) {
-	    mem_slab_free(stream->cfg.mem_slab, mblk_tmp);
+	    mem_slab_free_isr(stream->cfg.mem_slab, mblk_tmp);
     }
 	stream->stream_disable(stream, dev);
 	return ret;
@@ -1068,7 +1068,7 @@ static int dma_tx_callback(void *priv, dma_isr_status status)
 	assert(stream->mem_block != NULL);
 
 	/* All block data sent */
-	mem_slab_free(stream->cfg.mem_slab, stream->mem_block);
+	mem_slab_free_isr(stream->cfg.mem_slab, stream->mem_block);
 	stream->mem_block = NULL;
 
 	if (status == DMA_STATUS_ABORTED) {
@@ -19,6 +19,10 @@
 #include <hal/uart.h>
 #include <hal/pm.h>
 #include <hal/dma.h>
+#ifdef CONFIG_SERIAL_ATCUART_DMA
+#include <hal/cpu.h>
+#include <cmsis_os.h>
+#endif
 
 #include <string.h>
 #include <stdio.h>
@@ -129,11 +133,33 @@ struct raw_access {
     struct uart_tr tr;
 
     uint8_t dma_en;
+    uint8_t rx_idle;
     struct device *dma_dev;
     struct dma_ctx tx_dma_ctx;
     struct dma_ctx rx_dma_ctx;
 };
 
+#ifdef CONFIG_SERIAL_ATCUART_DMA
+
+#define SDMA_RX_SIZE    CONFIG_SERIAL_ATCUART_DMA_RX_SIZE
+
+/* DMA for the serial port path, as opposed to raw access. */
+struct serial_dma {
+    uint8_t on;
+    uint8_t tx_on;                  /* TX ring is reachable by DMA */
+    struct device *dma_dev;
+    struct dma_ctrl tx_ctrl;
+    struct dma_ctrl rx_ctrl;
+    struct dma_desc_chain tx_desc[2];
+    struct dma_desc_chain rx_desc;
+    int tx_ch;
+    int rx_ch;
+    uint32_t tx_len;                /* ring bytes owned by the TX DMA */
+    uint8_t *rx_buf;
+    uint32_t rx_pos;                /* first byte not yet pushed */
+};
+#endif
+
 #if defined(CONFIG_SOC_SCM2010) || defined(CONFIG_SOC_TL7118)
 struct uart_ctx {
     uint32_t osc;
@@ -157,6 +183,10 @@ struct atcuart_port {
     } fifo;
     int rx_err;
     int fifo_ctl;
+    struct termios serial_termios; /* restored when raw access ends */
+#ifdef CONFIG_SERIAL_ATCUART_DMA
+    struct serial_dma sdma;
+#endif
 #if defined(CONFIG_SOC_SCM2010) || defined(CONFIG_SOC_TL7118)
     struct uart_ctx ctx;
 #endif
@@ -353,7 +383,8 @@ static void atcuart_set_baudrate(struct serial_port *port, int baud)
 }
 
 
-static int atcuart_set_termios(struct serial_port *port, struct termios *termios)
+static int __atcuart_set_termios(struct serial_port *port, struct termios *termios,
+        u32 rx_trig)
 {
     struct atcuart_port *atport = to_atcuart_port(port);
     struct device *dev = port->device;
@@ -390,8 +421,12 @@ static int atcuart_set_termios(struct serial_port *port, struct termios *termios
         lc |= UART_ATCUART_LCR_PEN;
     }
 
-    /* XXX: what would be the best values for FIFO thresholds ? */
-    fc |= (UART_ATCUART_FCR_RFIFOT_0 | UART_ATCUART_FCR_TFIFOT_0);
+#ifdef CONFIG_SERIAL_ATCUART_DMA
+    if (atport->sdma.on)
+        rx_trig = UART_ATCUART_FCR_RFIFOT_1 | UART_ATCUART_FCR_DMAE |
+            UART_ATCUART_FCR_TFIFOT_1;
+#endif
+    fc |= (rx_trig | UART_ATCUART_FCR_TFIFOT_0);
     fc |= (UART_ATCUART_FCR_FIFOE | UART_ATCUART_FCR_TFIFORST | UART_ATCUART_FCR_RFIFORST);
 
     mc = atcuart_readl(dev, OFT_ATCUART_MCR);
@@ -416,15 +451,66 @@ static int atcuart_set_termios(struct serial_port *port, struct termios *termios
     return 0;
 }
 
+/*
+ * The serial path raises RX interrupts a few bytes at a time and relies
+ * on the RX timeout for the tail, so the handler drains the FIFO in
+ * bursts. Raw PIO mode does not handle the timeout and stays at 1 byte.
+ */
+static int atcuart_set_termios(struct serial_port *port, struct termios *termios)
+{
+    return __atcuart_set_termios(port, termios, UART_ATCUART_FCR_RFIFOT_1);
+}
+
+/* Move as much as the TX FIFO takes from the ring, returns bytes moved. */
+static int atcuart_fill_tx(struct atcuart_port *atport, portBASE_TYPE *resched)
+{
+    struct serial_port *port = &atport->port;
+    u8 buf[16];
+    int i, n, total = 0;
+
+    while (!atcuart_fifo_is_full(atport)) {
+        n = min((int)sizeof(buf), atport->fifo.depth - atport->fifo.fill);
+        n = serial_tx_pull(port, buf, n, resched);
+        if (n == 0)
+            break;
+        for (i = 0; i < n; i++)
+            atcuart_port_putc(port, buf[i]);
+        total += n;
+    }
+
+    return total;
+}
+
+/* Push whatever sits in the RX FIFO. */
+static void atcuart_rx_pio(struct atcuart_port *atport, portBASE_TYPE *resched)
+{
+    struct device *serial = atport->port.device;
+    u8 buf[16];
+    int ret, len;
+
+    do {
+        for (len = 0; len < (int)sizeof(buf); len++) {
+            if ((ret = atcuart_getc(serial)) < 0)
+                break;
+            buf[len] = (u8)ret;
+        }
+        if (len)
+            serial_rx_push(&atport->port, buf, len, resched);
+    } while (len == (int)sizeof(buf));
+}
+
+#ifdef CONFIG_SERIAL_ATCUART_DMA
+static void atcuart_sdma_rx_idle(struct atcuart_port *atport,
+        portBASE_TYPE *resched);
+#endif
+
 static int atcuart_irq_serial(int irq, void *data)
 {
     struct atcuart_port *atport = data;
     struct serial_port *port = &atport->port;
     struct device *dev = port->device;
     struct device *serial = port->device;
-    char c;
     portBASE_TYPE resched = false;
-    int ret, len;
     u32 intid, lsr;
 
     intid = atcuart_readl(serial, OFT_ATCUART_IIR);
@@ -433,26 +519,21 @@ static int atcuart_irq_serial(int irq, void *data)
     if (intid == UART_ATCUART_IIR_INTRID_THR) {
         atport->fifo.fill = 0;
 
-        len = uxQueueMessagesWaitingFromISR(port->queue[TX]);
-        if (len == 0) {
+        if (atcuart_fill_tx(atport, &resched) == 0) {
             /* No more data to transmit - disable tx interrupt */
             atcuart_tx_enable(serial, false);
-            goto txdone;
-        }
-        while (len > 0 && !atcuart_fifo_is_full(atport)) {
-            xQueueReceiveFromISR(port->queue[TX], &c,
-                    &resched);
-            atcuart_port_putc(port, c);
-            len--;
         }
     }
-txdone:
     if (intid == UART_ATCUART_IIR_INTRID_RBR ||
             intid == UART_ATCUART_IIR_INTRID_RTI) {
-        while ((ret = atcuart_getc(serial)) >= 0) {
-            c = (char) (ret & 0xff);
-            xQueueSendFromISR(port->queue[RX], &c, &resched);
-        }
+#ifdef CONFIG_SERIAL_ATCUART_DMA
+        if (atport->sdma.rx_ch >= 0) {
+            /* The DMA takes the FIFO at the trigger level, not us. */
+            if (intid == UART_ATCUART_IIR_INTRID_RTI)
+                atcuart_sdma_rx_idle(atport, &resched);
+        } else
+#endif
+        atcuart_rx_pio(atport, &resched);
     }
     if (intid == UART_ATCUART_IIR_INTRID_LSR) {
         lsr = atcuart_readl(serial, OFT_ATCUART_LSR);
@@ -468,6 +549,8 @@ txdone:
     return 0;
 }
 
+static int atcuart_rx_end(struct device *dev);
+
 static int atcuart_irq_raw(int irq, void *data)
 {
     struct atcuart_port *atport = data;
@@ -508,7 +591,8 @@ static int atcuart_irq_raw(int irq, void *data)
         }
     }
 
-    if (intid == UART_ATCUART_IIR_INTRID_RBR) {
+    /* In DMA mode the DMA takes the FIFO at the trigger level, not us. */
+    if (intid == UART_ATCUART_IIR_INTRID_RBR && !raw->dma_en) {
         for (i = raw->tr.rx_oft; i < raw->tr.rx_len; i++) {
             ret = atcuart_getc(dev);
             if (ret < 0) {
@@ -534,7 +618,20 @@ static int atcuart_irq_raw(int irq, void *data)
     }
 
     if (intid == UART_ATCUART_IIR_INTRID_RTI) {
-        while ((ret = atcuart_getc(dev)) >= 0) {
+        if (raw->rx_idle && raw->rx_dma_ctx.dma_ch >= 0) {
+            /*
+             * The DMA leaves less than the trigger level in the FIFO,
+             * so a burst always ends with an RX timeout.
+             */
+            atcuart_rx_end(dev);
+            if (raw->cb) {
+                raw->event.type = UART_EVENT_RX_IDLE;
+                raw->event.err = UART_ERR_NO;
+                raw->cb(&raw->event, raw->cb_ctx);
+            }
+        } else {
+            while ((ret = atcuart_getc(dev)) >= 0) {
+            }
         }
     }
 
@@ -590,6 +687,315 @@ static int atcuart_irq(int irq, void *data)
     return 0;
 }
 
+static struct device *atcuart_dma_dev(struct device *dev)
+{
+    switch (dev_id(dev)) {
+        case 0:
+        case 1:
+            return device_get_by_name("dmac.0");
+        case 2:
+            return device_get_by_name("dmac.1");
+        default:
+            return NULL;
+    }
+}
+
+#ifdef CONFIG_SERIAL_ATCUART_DMA
+
+/*
+ * Serial port DMA.
+ *
+ * RX runs without a break into rx_buf: the channel is kept and reloaded
+ * from its completion handler, with the UART FIFO covering the gap. The
+ * DMA only takes the FIFO once it reaches the trigger level, so a burst
+ * ends with a few bytes left in it, which raises the RX timeout
+ * interrupt once the line has been quiet for four characters. New bytes
+ * are pushed into the RX ring when the buffer wraps and on that
+ * interrupt. Nothing polls, so an idle port costs nothing. The RX data
+ * interrupt at the trigger level is ignored while the DMA runs. Without
+ * an RX channel, RX falls back to those interrupts.
+ *
+ * TX sends the pending ring segments with one chained transfer and only
+ * releases them when it completes. If no channel is free, the FIFO is
+ * filled by interrupts as without DMA.
+ *
+ * All of this runs with interrupts disabled or from DMA interrupts.
+ */
+
+static void atcuart_sdma_rx_sync(struct atcuart_port *atport, uint32_t end,
+        portBASE_TYPE *resched)
+{
+    struct serial_dma *sd = &atport->sdma;
+
+    if (end <= sd->rx_pos)
+        return;
+
+    dcache_invalidate_range((unsigned long)sd->rx_buf + sd->rx_pos,
+            (unsigned long)sd->rx_buf + end);
+    serial_rx_push(&atport->port, sd->rx_buf + sd->rx_pos, end - sd->rx_pos,
+            resched);
+    sd->rx_pos = end;
+}
+
+static uint32_t atcuart_sdma_rx_end(struct serial_dma *sd)
+{
+    int left = dma_ch_get_trans_size(sd->dma_dev, sd->rx_ch);
+
+    return (left < 0 || left > SDMA_RX_SIZE) ? 0 : SDMA_RX_SIZE - left;
+}
+
+static int atcuart_sdma_rx_done(void *ctx, dma_isr_status status)
+{
+    struct atcuart_port *atport = ctx;
+    struct serial_dma *sd = &atport->sdma;
+    portBASE_TYPE resched = false;
+
+    if (status != DMA_STATUS_COMPLETE || sd->rx_ch < 0)
+        return -1;
+
+    atcuart_sdma_rx_sync(atport, SDMA_RX_SIZE, &resched);
+    sd->rx_pos = 0;
+    dma_reload(sd->dma_dev, sd->rx_ch, &sd->rx_desc, 1);
+
+    portYIELD_FROM_ISR(resched);
+
+    return 0;
+}
+
+static int atcuart_sdma_rx_start(struct atcuart_port *atport)
+{
+    struct serial_dma *sd = &atport->sdma;
+
+    sd->rx_pos = 0;
+    sd->rx_desc.dst_addr = (uint32_t)sd->rx_buf;
+    sd->rx_desc.len = SDMA_RX_SIZE;
+
+    if (dma_copy_hw(sd->dma_dev, true, &sd->rx_ctrl, &sd->rx_desc, 1,
+                atcuart_sdma_rx_done, atport, &sd->rx_ch)) {
+        sd->rx_ch = -1;
+        return -EBUSY;
+    }
+
+    return 0;
+}
+
+static void atcuart_sdma_rx_stop(struct atcuart_port *atport,
+        portBASE_TYPE *resched)
+{
+    struct serial_dma *sd = &atport->sdma;
+    unsigned long flags;
+
+    local_irq_save(flags);
+
+    if (sd->rx_ch >= 0) {
+        dma_ch_abort(sd->dma_dev, sd->rx_ch);
+        atcuart_sdma_rx_sync(atport, atcuart_sdma_rx_end(sd), resched);
+        dma_ch_rel(sd->dma_dev, sd->rx_ch);
+        sd->rx_ch = -1;
+    }
+
+    local_irq_restore(flags);
+}
+
+/*
+ * RX timeout: the line is quiet and the FIFO holds less than the trigger
+ * level, which the DMA leaves there. Stop the DMA so that it cannot take
+ * bytes from under us, push what it wrote and then the tail, and start
+ * over at the top of rx_buf. If no channel is left, RX goes on with
+ * interrupts.
+ */
+static void atcuart_sdma_rx_idle(struct atcuart_port *atport,
+        portBASE_TYPE *resched)
+{
+    atcuart_sdma_rx_stop(atport, resched);
+    atcuart_rx_pio(atport, resched);
+    atcuart_sdma_rx_start(atport);
+}
+
+static int atcuart_sdma_tx_done(void *ctx, dma_isr_status status);
+
+/* Returns -EBUSY if there is data to send but no channel to send it. */
+static int atcuart_sdma_tx_kick(struct atcuart_port *atport)
+{
+    struct serial_dma *sd = &atport->sdma;
+    uint8_t *seg[2];
+    uint32_t len[2], total;
+    int i, n;
+
+    if (sd->tx_ch >= 0)
+        return 0;
+
+    total = serial_tx_peek(&atport->port, seg, len);
+    if (total == 0)
+        return 0;
+
+    n = len[1] ? 2 : 1;
+    for (i = 0; i < n; i++) {
+        sd->tx_desc[i].src_addr = (uint32_t)seg[i];
+        sd->tx_desc[i].len = len[i];
+        dcache_flush_range((unsigned long)seg[i],
+                (unsigned long)seg[i] + len[i]);
+    }
+
+    if (dma_copy_hw(sd->dma_dev, false, &sd->tx_ctrl, sd->tx_desc, n,
+                atcuart_sdma_tx_done, atport, &sd->tx_ch)) {
+        sd->tx_ch = -1;
+        return -EBUSY;
+    }
+
+    sd->tx_len = total;
+    pm_stay(PM_DEVICE_UART);
+
+    return 0;
+}
+
+static int atcuart_sdma_tx_done(void *ctx, dma_isr_status status)
+{
+    struct atcuart_port *atport = ctx;
+    struct serial_dma *sd = &atport->sdma;
+    portBASE_TYPE resched = false;
+
+    if (status == DMA_STATUS_NONE || sd->tx_ch < 0)
+        return -1;
+
+    /* On error the bytes are dropped rather than retried forever. */
+    sd->tx_ch = -1;
+    serial_tx_done(&atport->port, sd->tx_len, &resched);
+    sd->tx_len = 0;
+    pm_relax(PM_DEVICE_UART);
+
+    if (atcuart_sdma_tx_kick(atport))
+        atcuart_fill_tx(atport, &resched);
+
+    portYIELD_FROM_ISR(resched);
+
+    return 0;
+}
+
+/* No RX channel: take the FIFO back from the DMA and move data by interrupts. */
+static void atcuart_sdma_fallback(struct atcuart_port *atport)
+{
+    struct device *dev = atport->port.device;
+
+    atport->fifo_ctl &= ~(UART_ATCUART_FCR_DMAE | UART_ATCUART_FCR_TFIFOT);
+    atcuart_writel(atport->fifo_ctl, dev, OFT_ATCUART_FCR);
+    atcuart_enable_interrupt(dev, UART_ATCUART_IER_ELSI | UART_ATCUART_IER_ERBI);
+    atport->sdma.on = 0;
+}
+
+/* Switch the FIFO and interrupts over and get RX going. */
+static void atcuart_sdma_start(struct atcuart_port *atport)
+{
+    struct serial_dma *sd = &atport->sdma;
+    struct device *dev = atport->port.device;
+    unsigned long flags;
+
+    if (!sd->dma_dev)
+        return;
+
+    local_irq_save(flags);
+
+    atport->fifo_ctl &= ~UART_ATCUART_FCR_RFIFOT;
+    atport->fifo_ctl |= UART_ATCUART_FCR_DMAE | UART_ATCUART_FCR_TFIFOT_1 |
+        UART_ATCUART_FCR_RFIFOT_1;
+    atcuart_writel(atport->fifo_ctl, dev, OFT_ATCUART_FCR);
+
+    if (atcuart_sdma_rx_start(atport) == 0) {
+        atcuart_writel(UART_ATCUART_IER_ELSI | UART_ATCUART_IER_ERBI, dev,
+                OFT_ATCUART_IER);
+        sd->on = 1;
+    } else {
+        atcuart_sdma_fallback(atport);
+    }
+
+    local_irq_restore(flags);
+
+    if (!sd->on)
+        printk("UART%d: no DMA channel, using interrupts\n", dev_id(dev));
+}
+
+/* Back to interrupt mode, e.g. for raw access. TX must be idle. */
+static void atcuart_sdma_stop(struct atcuart_port *atport)
+{
+    struct serial_dma *sd = &atport->sdma;
+
+    if (!sd->on)
+        return;
+
+    atcuart_sdma_rx_stop(atport, NULL);
+    sd->on = 0;
+}
+
+static void atcuart_sdma_init(struct atcuart_port *atport)
+{
+    struct serial_dma *sd = &atport->sdma;
+    struct serial_port *port = &atport->port;
+    struct device *dev = port->device;
+    uint8_t did = dev_id(dev);
+    uintptr_t p;
+
+    sd->tx_ch = sd->rx_ch = -1;
+
+    sd->dma_dev = atcuart_dma_dev(dev);
+    if (!sd->dma_dev)
+        return;
+
+    /* Whole cache lines only, so invalidating never hits a neighbour. */
+    p = (uintptr_t)kmalloc(SDMA_RX_SIZE + 64);
+    if (!p)
+        goto fail;
+    sd->rx_buf = (uint8_t *)((p + 32) & ~31UL);
+    if (!((uint32_t)sd->rx_buf & 0xF0000000))
+        goto fail;
+
+    sd->tx_ctrl.src_mode = DMA_MODE_NORMAL;
+    sd->tx_ctrl.dst_mode = DMA_MODE_HANDSHAKE;
+    sd->tx_ctrl.src_addr_ctrl = DMA_ADDR_CTRL_INCREMENT;
+    sd->tx_ctrl.dst_addr_ctrl = DMA_ADDR_CTRL_FIXED;
+    sd->tx_ctrl.src_width = DMA_WIDTH_BYTE;
+    sd->tx_ctrl.dst_width = DMA_WIDTH_BYTE;
+    sd->tx_ctrl.intr_mask = DMA_INTR_ABT_MASK;
+    sd->tx_ctrl.src_burst_size = DMA_SRC_BURST_SIZE_1;
+    sd->tx_desc[0].dst_addr = (uint32_t)(dev->base[0] + OFT_ATCUART_THR);
+    sd->tx_desc[1].dst_addr = sd->tx_desc[0].dst_addr;
+
+    sd->rx_ctrl.src_mode = DMA_MODE_HANDSHAKE;
+    sd->rx_ctrl.dst_mode = DMA_MODE_NORMAL;
+    sd->rx_ctrl.src_addr_ctrl = DMA_ADDR_CTRL_FIXED;
+    sd->rx_ctrl.dst_addr_ctrl = DMA_ADDR_CTRL_INCREMENT;
+    sd->rx_ctrl.src_width = DMA_WIDTH_BYTE;
+    sd->rx_ctrl.dst_width = DMA_WIDTH_BYTE;
+    sd->rx_ctrl.intr_mask = DMA_INTR_ABT_MASK;
+    sd->rx_ctrl.src_burst_size = DMA_SRC_BURST_SIZE_1;
+    sd->rx_desc.src_addr = (uint32_t)(dev->base[0] + OFT_ATCUART_RBR);
+
+    if (did == 2) {
+        sd->tx_ctrl.dst_req = DMA1_HW_REQ_UART2_TX;
+        sd->rx_ctrl.src_req = DMA1_HW_REQ_UART2_RX;
+    } else {
+        sd->tx_ctrl.dst_req = did ? DMA0_HW_REQ_UART1_TX : DMA0_HW_REQ_UART0_TX;
+        sd->rx_ctrl.src_req = did ? DMA0_HW_REQ_UART1_RX : DMA0_HW_REQ_UART0_RX;
+    }
+
+    sd->tx_on = ((uint32_t)port->ring[TX].buf & 0xF0000000) ? 1 : 0;
+
+    atcuart_sdma_start(atport);
+    return;
+
+fail:
+    if (p)
+        kfree((void *)p);
+    memset(sd, 0, sizeof(*sd));
+    sd->tx_ch = sd->rx_ch = -1;
+    printk("UART%d: DMA setup failed, using interrupts\n", did);
+}
+
+static int atcuart_sdma_busy(struct atcuart_port *atport)
+{
+    return atport->sdma.tx_ch >= 0;
+}
+
+#endif /* CONFIG_SERIAL_ATCUART_DMA */
 
 __iram__ int atcuart_port_init(struct serial_port *port)
 {
@@ -624,6 +1030,10 @@ __iram__ int atcuart_port_init(struct serial_port *port)
             dev_name(port->device), port->device->pri[0], atport);
     if (ret)
         goto free_pin;
+
+#ifdef CONFIG_SERIAL_ATCUART_DMA
+    atcuart_sdma_init(atport);
+#endif
     return 0;
 
 free_pin:
@@ -658,20 +1068,20 @@ int atcuart_console_write(struct serial_port *port, char *s, int n)
 void atcuart_port_start_tx(struct serial_port *port)
 {
     struct atcuart_port *atport = to_atcuart_port(port);
-    int len;
     unsigned long flags;
-    char ch;
 
     local_irq_save(flags);
 
-    if (atcuart_tx_stopped(port->device)) {
-        len = uxQueueMessagesWaitingFromISR(port->queue[TX]);
-        while (len-- > 0 && !atcuart_fifo_is_full(atport)) {
-            if (xQueueReceiveFromISR(port->queue[TX], &ch, 0) == pdPASS) {
-                atcuart_port_putc(port, ch);
-            }
-        }
+#ifdef CONFIG_SERIAL_ATCUART_DMA
+    if (atport->sdma.on && atport->sdma.tx_on &&
+            atcuart_tx_stopped(port->device) &&
+            atcuart_sdma_tx_kick(atport) == 0) {
+        local_irq_restore(flags);
+        return;
     }
+#endif
+    if (atcuart_tx_stopped(port->device))
+        atcuart_fill_tx(atport, NULL);
 
     local_irq_restore(flags);
 }
@@ -713,6 +1123,10 @@ int atcuart_port_ioctl(struct serial_port *port, unsigned cmd, void *arg)
             rx_len_arg = arg;
             *(rx_len_arg->len) = uart_get_rx_len(dev);
             return 0;
+        case IOCTL_UART_RX_STOP:
+            rx_len_arg = arg;
+            *(rx_len_arg->len) = uart_rx_stop(dev);
+            return 0;
         default:
             return -ENOTTY;
     }
@@ -768,13 +1182,7 @@ static int atcuart_raw_init(struct device *dev, struct uart_cfg *cfg, uart_cb cb
     }
 
     if (cfg->dma_en) {
-        if (did == 0) {
-            dma_dev = device_get_by_name("dmac.0");
-        } else if (did == 1) {
-            dma_dev = device_get_by_name("dmac.0");
-        } else if (did == 2) {
-            dma_dev = device_get_by_name("dmac.1");
-        }
+        dma_dev = atcuart_dma_dev(dev);
 
         if (!dma_dev) {
             printk("DMA is not enabled\n");
@@ -783,15 +1191,14 @@ static int atcuart_raw_init(struct device *dev, struct uart_cfg *cfg, uart_cb cb
     }
 
     port = &atport->port;
-    if (!port->initialized) {
-        int i, ret = 0;
+    if (port->initialized) {
+        /* Let whatever the serial path has queued go out first. */
+        while (serial_ring_count(&port->ring[TX]) || !atcuart_tx_empty(dev))
+            vTaskDelay(1);
+    } else {
+        int ret;
 
-        for (i = 0; i < 2; i++) {
-            port->queue[i] = xQueueCreate(CONFIG_SERIAL_BUFFER_SIZE, sizeof(char));
-            if (port->queue[i] == NULL) {
-                ret = -ENOMEM;
-            }
-        }
+        ret = serial_port_alloc(port);
 
         if (!ret) {
             if (port->ops->init) {
@@ -804,21 +1211,24 @@ static int atcuart_raw_init(struct device *dev, struct uart_cfg *cfg, uart_cb cb
         }
 
         if (ret) {
-            for (i = 0; i < 2; i++) {
-                if (port->queue[i]) {
-                    vQueueDelete(port->queue[i]);
-                }
-            }
+            serial_port_free(port);
 
             return ret;
         }
 
     }
 
+#ifdef CONFIG_SERIAL_ATCUART_DMA
+    atcuart_sdma_stop(atport);
+#endif
+
     memset(raw, 0, sizeof(struct raw_access));
     memset(&termios, 0, sizeof(termios));
+    memcpy(&atport->serial_termios, &port->oldtermios, sizeof(termios));
 
     termios.c_ispeed = cfg->baudrate;
+    /* Keep hardware flow control if the board wired it up. */
+    termios.c_cflag |= port->oldtermios.c_cflag & CRTSCTS;
 
     switch (cfg->parity) {
         case UART_ODD_PARITY:
@@ -855,7 +1265,7 @@ static int atcuart_raw_init(struct device *dev, struct uart_cfg *cfg, uart_cb cb
             break;
     }
 
-    atcuart_set_termios(&atport->port, &termios);
+    __atcuart_set_termios(&atport->port, &termios, UART_ATCUART_FCR_RFIFOT_0);
 
     raw->cb = cb;
     raw->cb_ctx = ctx;
@@ -909,6 +1319,8 @@ static int atcuart_raw_init(struct device *dev, struct uart_cfg *cfg, uart_cb cb
             atcuart_writel(atport->fifo_ctl, dev, OFT_ATCUART_FCR);
 
             actuart_raw_errata(dev);
+
+            raw->rx_idle = cfg->rx_idle;
         } else {
             raw->dma_en = 0;
             atport->fifo_ctl &= ~(UART_ATCUART_FCR_DMAE |
@@ -938,6 +1350,12 @@ static int atcuart_raw_deinit(struct device *dev)
 
     raw->enable = 0;
 
+    /* Hand the port back to the serial path as it was. */
+    atcuart_set_termios(&atport->port, &atport->serial_termios);
+#ifdef CONFIG_SERIAL_ATCUART_DMA
+    atcuart_sdma_start(atport);
+#endif
+
     return 0;
 }
 
@@ -958,6 +1376,10 @@ static int atcuart_dma_done_handler(void *ctx, dma_isr_status status)
             raw->tx_dma_ctx.dma_ch = -1;
         } else {
             raw->rx_dma_ctx.dma_ch = -1;
+            raw->tr.rx_oft = raw->tr.rx_len;
+            if (raw->rx_idle) {
+                atcuart_rx_enable(dev, false);
+            }
         }
     }
 
@@ -1104,15 +1526,26 @@ static int atcuart_recevie(struct device *dev, uint8_t *rx_buf, uint32_t rx_len)
         if (raw->rx_dma_ctx.dma_ch >= 0) {
             return -EINPROGRESS;
         }
+
+        raw->tr.rx_buf = rx_buf;
+        raw->tr.rx_len = rx_len;
+        raw->tr.rx_oft = 0;
+
         ret =  atcuart_dma_configure(dev, rx_buf, rx_len, 0);
 
         if (ret) {
+            raw->tr.rx_len = 0;
             return ret;
         }
 
-        raw->tr.rx_buf = rx_buf;
-        raw->tr.rx_len = rx_len;
-        raw->tr.rx_oft = 0;
+        if (raw->rx_idle) {
+            unsigned long flags;
+
+            /* For the RX timeout only; see atcuart_irq_raw(). */
+            local_irq_save(flags);
+            atcuart_rx_enable(dev, true);
+            local_irq_restore(flags);
+        }
 
     } else {
 
@@ -1182,7 +1615,7 @@ static int atcuart_get_rx_len(struct device *dev)
         return -EPERM;
     }
 
-    if (raw->dma_en) {
+    if (raw->dma_en && raw->rx_dma_ctx.dma_ch >= 0) {
         int yet_to_go = dma_ch_get_trans_size(raw->dma_dev, raw->rx_dma_ctx.dma_ch);
         len = raw->tr.rx_len - yet_to_go;
     } else {
@@ -1192,6 +1625,63 @@ static int atcuart_get_rx_len(struct device *dev)
     return len;
 }
 
+/*
+ * End the reception in progress with what has arrived so far. Bytes still
+ * sitting in the RX FIFO below the DMA trigger level are moved into the
+ * buffer as well. Called with interrupts disabled.
+ */
+static int atcuart_rx_end(struct device *dev)
+{
+    struct atcuart_port *atport = dev->driver_data;
+    struct raw_access *raw = &atport->raw;
+    int ret, len;
+
+    if (raw->dma_en) {
+        if (raw->rx_dma_ctx.dma_ch >= 0) {
+            dma_ch_abort(raw->dma_dev, raw->rx_dma_ctx.dma_ch);
+            raw->tr.rx_oft = raw->tr.rx_len -
+                dma_ch_get_trans_size(raw->dma_dev, raw->rx_dma_ctx.dma_ch);
+            raw->rx_dma_ctx.dma_ch = -1;
+        }
+        if (raw->rx_idle) {
+            atcuart_rx_enable(dev, false);
+        }
+    } else if (raw->tr.rx_oft != raw->tr.rx_len) {
+        atcuart_rx_enable(dev, false);
+    }
+
+    while (raw->tr.rx_oft < raw->tr.rx_len && (ret = atcuart_getc(dev)) >= 0) {
+        raw->tr.rx_buf[raw->tr.rx_oft++] = ret & 0xff;
+    }
+
+    len = raw->tr.rx_oft;
+    raw->tr.rx_len = len;
+
+    return len;
+}
+
+/*
+ * End the reception in progress early, without a completion callback.
+ * Returns the number of bytes received.
+ */
+static int atcuart_rx_stop(struct device *dev)
+{
+    struct atcuart_port *atport = dev->driver_data;
+    struct raw_access *raw = &atport->raw;
+    unsigned long flags;
+    int len;
+
+    if (!raw->enable) {
+        return -EPERM;
+    }
+
+    local_irq_save(flags);
+    len = atcuart_rx_end(dev);
+    local_irq_restore(flags);
+
+    return len;
+}
+
 __iram__ int atcuart_probe(struct device *dev)
 {
     struct atcuart_port *atport;
@@ -1288,7 +1778,17 @@ __iram__ int atcuart_suspend(struct device *dev, u32 *idle)
     if (!port->initialized)
         return 0;
 
+#ifdef CONFIG_SERIAL_ATCUART_DMA
+    if (atcuart_sdma_busy(atport))
+        return -EBUSY;
+#endif
+
 #if defined(CONFIG_SOC_SCM2010) || defined(CONFIG_SOC_TL7118)
+#ifdef CONFIG_SERIAL_ATCUART_DMA
+    /* Whatever RX DMA has stored goes to the ring before power is cut. */
+    if (atport->sdma.on)
+        atcuart_sdma_rx_stop(atport, NULL);
+#endif
     atport->ctx.osc = atcuart_readl(dev, OFT_ATCUART_OSC);
     atport->ctx.ier = atcuart_readl(dev, OFT_ATCUART_IER);
     atport->ctx.lcr = atcuart_readl(dev, OFT_ATCUART_LCR);
@@ -1307,8 +1807,8 @@ __iram__ int atcuart_suspend(struct device *dev, u32 *idle)
 #else
     u32 busy = 0;
 
-    busy |= uxQueueMessagesWaitingFromISR(port->queue[TX]) ? 1: 0;
-    busy |= uxQueueMessagesWaitingFromISR(port->queue[RX]) ? 1 << 1: 0;
+    busy |= serial_ring_count(&port->ring[TX]) ? 1: 0;
+    busy |= serial_ring_count(&port->ring[RX]) ? 1 << 1: 0;
     busy |= atcuart_tx_empty(dev) ? 0 : 1 << 2;
     busy |= (readl(atcuart_addr(dev, OFT_ATCUART_LSR)) &
             UART_ATCUART_LSR_DR) ? 1 << 3: 0;
@@ -1346,6 +1846,10 @@ __iram__ int atcuart_resume(struct device *dev)
 
     /* enable interrupt */
     atcuart_writel(atport->ctx.ier, dev, OFT_ATCUART_IER);
+#ifdef CONFIG_SERIAL_ATCUART_DMA
+    if (atport->sdma.on && atcuart_sdma_rx_start(atport))
+        atcuart_sdma_fallback(atport);
+#endif
 #endif
 
     return 0;
@@ -1359,6 +1863,7 @@ struct uart_ops uart_ops = {
     .receive	    = atcuart_recevie,
     .reset 		    = atcuart_reset,
     .get_rx_len 	= atcuart_get_rx_len,
+    .rx_stop 	    = atcuart_rx_stop,
 };
 
 /* important as static and all of functions should be located in here */
@@ -19,6 +19,7 @@
 #include <hal/device.h>
 #include <hal/serial.h>
 #include <hal/console.h>
+#include <hal/kmem.h>
 
 #include "vfs.h"
 
@@ -26,21 +27,170 @@ int g_serial_console_port = CONFIG_SERIAL_CONSOLE_PORT;
 
 static LIST_HEAD_DEF(serial_port);
 
+static int serial_ring_init(struct serial_ring *r, u32 size)
+{
+	memset(r, 0, sizeof(*r));
+
+	r->size = 1 << __fls(size - 1);
+	r->buf = kmalloc(r->size);
+	r->wait = xSemaphoreCreateBinary();
+	r->lock = xSemaphoreCreateMutex();
+	if (r->buf == NULL || r->wait == NULL || r->lock == NULL)
+		return -ENOMEM;
+
+	return 0;
+}
+
+static void serial_ring_free(struct serial_ring *r)
+{
+	if (r->buf)
+		kfree(r->buf);
+	if (r->wait)
+		vSemaphoreDelete(r->wait);
+	if (r->lock)
+		vSemaphoreDelete(r->lock);
+	memset(r, 0, sizeof(*r));
+}
+
+/* Copy in as much of @buf as fits. Producer side only. */
+static u32 serial_ring_put(struct serial_ring *r, const u8 *buf, u32 len)
+{
+	u32 head = r->head, off = head & (r->size - 1), n;
+
+	len = min(len, serial_ring_space(r));
+	n = min(len, r->size - off);
+	memcpy(r->buf + off, buf, n);
+	memcpy(r->buf, buf + n, len - n);
+	barrier();
+	r->head = head + len;
+
+	return len;
+}
+
+/* Copy out up to @len bytes. Consumer side only. */
+static u32 serial_ring_get(struct serial_ring *r, u8 *buf, u32 len)
+{
+	u32 tail = r->tail, off = tail & (r->size - 1), n;
+
+	len = min(len, serial_ring_count(r));
+	n = min(len, r->size - off);
+	memcpy(buf, r->buf + off, n);
+	memcpy(buf + n, r->buf, len - n);
+	barrier();
+	r->tail = tail + len;
+
+	return len;
+}
+
+int serial_port_alloc(struct serial_port *port)
+{
+	int i;
+
+	for (i = 0; i < 2; i++) {
+		if (serial_ring_init(&port->ring[i], CONFIG_SERIAL_BUFFER_SIZE)) {
+			serial_port_free(port);
+			return -ENOMEM;
+		}
+	}
+
+	return 0;
+}
+
+void serial_port_free(struct serial_port *port)
+{
+	int i;
+
+	for (i = 0; i < 2; i++)
+		serial_ring_free(&port->ring[i]);
+}
+
+static void serial_tx_wake(struct serial_ring *r, portBASE_TYPE *resched)
+{
+	if (r->thresh && serial_ring_space(r) >= r->thresh) {
+		r->thresh = 0;
+		xSemaphoreGiveFromISR(r->wait, resched);
+	}
+}
+
+int serial_tx_pull(struct serial_port *port, u8 *buf, int len,
+		   portBASE_TYPE *resched)
+{
+	struct serial_ring *r = &port->ring[TX];
+
+	len = serial_ring_get(r, buf, len);
+	serial_tx_wake(r, resched);
+
+	return len;
+}
+
+u32 serial_tx_peek(struct serial_port *port, u8 *seg[2], u32 len[2])
+{
+	struct serial_ring *r = &port->ring[TX];
+	u32 off = r->tail & (r->size - 1), count = serial_ring_count(r);
+
+	seg[0] = r->buf + off;
+	len[0] = min(count, r->size - off);
+	seg[1] = r->buf;
+	len[1] = count - len[0];
+
+	return count;
+}
+
+void serial_tx_done(struct serial_port *port, u32 len, portBASE_TYPE *resched)
+{
+	struct serial_ring *r = &port->ring[TX];
+
+	r->tail += len;
+	serial_tx_wake(r, resched);
+}
+
+int serial_rx_push(struct serial_port *port, const u8 *buf, int len,
+		   portBASE_TYPE *resched)
+{
+	struct serial_ring *r = &port->ring[RX];
+
+	/* Whatever does not fit is dropped, as the FIFO would. */
+	len = serial_ring_put(r, buf, len);
+	if (r->thresh && serial_ring_count(r) >= r->thresh) {
+		r->thresh = 0;
+		xSemaphoreGiveFromISR(r->wait, resched);
+	}
+
+	return len;
+}
+
+/*
+ * Block until @r has @need bytes (RX) or free slots (TX). The
+ * threshold is published before the level is checked, so an ISR that
+ * gets in between either sees it or has already moved the level.
+ */
+static void serial_ring_wait(struct serial_ring *r, int dir, u32 need)
+{
+	u32 level;
+
+	need = min(need, r->size / 2);
+	for (;;) {
+		r->thresh = need;
+		barrier();
+		level = (dir == RX) ? serial_ring_count(r) : serial_ring_space(r);
+		if (level >= need)
+			break;
+		xSemaphoreTake(r->wait, portMAX_DELAY);
+	}
+	r->thresh = 0;
+}
+
 int serial_open(struct file *file)
 {
 	struct serial_port *port = file->f_priv;
-	int i, ret = 0;
+	int ret = 0;
 
 	if (port->initialized)
 		return 0;
 
-	for (i = 0; i < 2; i++) {
-		port->queue[i] = xQueueCreate(CONFIG_SERIAL_BUFFER_SIZE, sizeof(char));
-		if (port->queue[i] == NULL) {
-			ret = -ENOMEM;
-			goto error;
-		}
-	}
+	ret = serial_port_alloc(port);
+	if (ret)
+		return ret;
 
 	if (port->ops->init)
 		ret = port->ops->init(port);
@@ -52,9 +202,7 @@ int serial_open(struct file *file)
  	return 0;
 
  error:
-	for (i = 0; i < 2; i++)
-		if (port->queue[i])
-			vQueueDelete(port->queue[i]);
+	serial_port_free(port);
 
 	return ret;
 }
@@ -62,75 +210,80 @@ int serial_open(struct file *file)
 ssize_t serial_write(struct file *file, void *buf, size_t size, off_t *pos)
 {
 	struct serial_port *port = file->f_priv;
-	void *ptr = buf;
-	size_t len, space;
-
-	space = uxQueueSpacesAvailable(port->queue[TX]);
-	len = min(size, space);
-try_again:
-	if (len == 0) {
-		if (file->f_flags & O_NONBLOCK)
-			return -EAGAIN;
+	struct serial_ring *r = &port->ring[TX];
+	size_t len;
 
-		xQueueSend(port->queue[TX], ptr++, -1);
-		size--;
-		space = uxQueueSpacesAvailable(port->queue[TX]);
-		len = min(size, space);
-	}
-	/* @len: number of writable bytes without blocking */
-	while (len > 0) {
-		/* Interrupted, then try again in case missing letters */
-		if (xQueueSend(port->queue[TX], ptr, 0) != pdPASS) {
-			len = 0;
-			goto try_again;
+	if (size == 0)
+		return 0;
+
+	xSemaphoreTake(r->lock, portMAX_DELAY);
+
+	if (serial_ring_space(r) == 0) {
+		if (file->f_flags & O_NONBLOCK) {
+			xSemaphoreGive(r->lock);
+			return -EAGAIN;
 		}
-		ptr++;
-		len--;
+		serial_ring_wait(r, TX, size);
 	}
-	if (ptr != buf)
+	/* As before, only what fits now; the caller comes back for the rest. */
+	len = serial_ring_put(r, buf, size);
+	if (len)
 		port->ops->start_tx(port);
 
-	return (ssize_t)(ptr - buf);
+	xSemaphoreGive(r->lock);
+
+	return (ssize_t)len;
 }
 
 ssize_t serial_read(struct file *file, void *buf, size_t size, off_t *pos)
 {
 	struct serial_port *port = file->f_priv;
-	void *ptr = buf;
+	struct serial_ring *r = &port->ring[RX];
+	u8 *ptr = buf;
+	size_t len;
 
-	if (file->f_flags & O_NONBLOCK &&
-			uxQueueMessagesWaiting(port->queue[RX]) == 0)
+	if (file->f_flags & O_NONBLOCK && serial_ring_count(r) == 0)
 		return -EAGAIN;
 
-	while (size > 0 &&
-	       xQueueReceive(port->queue[RX], ptr, -1) == pdPASS) {
-		ptr++;
-		size--;
+	xSemaphoreTake(r->lock, portMAX_DELAY);
+
+	while (size > 0) {
+		len = serial_ring_get(r, ptr, size);
+		ptr += len;
+		size -= len;
+		if (size == 0 || file->f_flags & O_NONBLOCK)
+			break;
+		serial_ring_wait(r, RX, size);
 	}
 
-	return (ssize_t)(ptr - buf);
+	xSemaphoreGive(r->lock);
+
+	return (ssize_t)(ptr - (u8 *)buf);
 }
 
 unsigned serial_poll(struct file *file, struct poll_table *pt, struct pollfd *pfd)
 {
 	struct serial_port *port = file->f_priv;
+	struct serial_ring *r;
 	unsigned mask = 0;
+	int i;
 
 	/*
-	 * NB: because of FreeRTOS queue set implementation limitation,
-	 * we drop the tx polling for the serial device.
-	 *
-	 * Alternatively, we can have another flags to file_op:poll() to
-	 * indicate which events (RD|WR|ERR) the caller is expecting
-	 * from this @file. This would be better.
+	 * The ring semaphores stand in for the old byte queues as queue
+	 * set members. A stale token would keep them from being added,
+	 * and the level is checked below anyway.
 	 */
-	if (pfd->events & POLLOUT)
-		poll_add_wait(file, port->queue[TX], pt);
-	if (pfd->events & POLLIN)
-		poll_add_wait(file, port->queue[RX], pt);
+	for (i = 0; i < 2; i++) {
+		if (!(pfd->events & (i == TX ? POLLOUT : POLLIN)))
+			continue;
+		r = &port->ring[i];
+		xSemaphoreTake(r->wait, 0);
+		r->thresh = 1;
+		poll_add_wait(file, r->wait, pt);
+	}
 
-	mask |= uxQueueSpacesAvailable(port->queue[TX]) ? POLLOUT : 0;
-	mask |= uxQueueMessagesWaiting(port->queue[RX]) ? POLLIN : 0;
+	mask |= serial_ring_space(&port->ring[TX]) ? POLLOUT : 0;
+	mask |= serial_ring_count(&port->ring[RX]) ? POLLIN : 0;
 	return mask;
 }
 
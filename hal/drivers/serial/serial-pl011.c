@@ -327,15 +327,14 @@ static int pl011_irq(int irq, void *data)
 	struct pl011_port *plport = data;
 	struct serial_port *port = &plport->port;
 	struct device *dev = port->device;
-	char c;
+	u8 c, buf[16];
 	portBASE_TYPE resched = false;
-	int ret;
+	int ret, len;
 	u32 status = pl011_readl(dev, OFT_PL011_MIS);
 
 	if (status & UART_PL011_IMSC_TXIM) {
 		while (!(pl011_fifo_is_full(dev))) {
-			ret = xQueueReceiveFromISR(port->queue[TX], &c, &resched);
-			if (ret == pdFALSE) {
+			if (serial_tx_pull(port, &c, 1, &resched) == 0) {
 				pl011_tx_enable(dev, false);
 				break;
 			}
@@ -343,10 +342,15 @@ static int pl011_irq(int irq, void *data)
 		}
 	}
 	if (status & (UART_PL011_IMSC_RTIM | UART_PL011_IMSC_RXIM)) {
-		while ((ret = pl011_getc(dev)) >= 0) {
-			c = (char) (ret & 0xff);
-			xQueueSendFromISR(port->queue[RX], &c, &resched);
-		}
+		do {
+			for (len = 0; len < (int)sizeof(buf); len++) {
+				if ((ret = pl011_getc(dev)) < 0)
+					break;
+				buf[len] = (u8)ret;
+			}
+			if (len)
+				serial_rx_push(port, buf, len, &resched);
+		} while (len == (int)sizeof(buf));
 	}
 
 	portEND_SWITCHING_ISR(resched);
@@ -422,17 +426,15 @@ static int pl011_port_putc(struct serial_port *port, char c)
 
 static void pl011_port_start_tx(struct serial_port *port)
 {
-	int len = uxQueueMessagesWaitingFromISR(port->queue[TX]);
 	unsigned long flags;
-	char ch;
+	u8 ch;
 
 	local_irq_save(flags);
 
 	if (pl011_tx_stopped(port->device)) {
-		while (len-- > 0 && !pl011_fifo_is_full(port->device)) {
-			xQueueReceive(port->queue[TX], &ch, 0);
+		while (!pl011_fifo_is_full(port->device) &&
+		       serial_tx_pull(port, &ch, 1, NULL))
 			pl011_port_putc(port, ch);
-		}
 	}
 
 	local_irq_restore(flags);
@@ -512,8 +514,8 @@ int pl011_suspend(struct device *dev, u32 *idle)
 	if (!port->initialized)
 		return 0;
 
-	busy |= uxQueueMessagesWaitingFromISR(port->queue[TX]) ? 1: 0;
-	busy |= uxQueueMessagesWaitingFromISR(port->queue[RX]) ? 1 << 1: 0;
+	busy |= serial_ring_count(&port->ring[TX]) ? 1: 0;
+	busy |= serial_ring_count(&port->ring[RX]) ? 1 << 1: 0;
 	busy |= pl011_fifo_is_empty(dev) ? 0 : 1 << 2;
 
 	return busy? -EBUSY: 0;
@@ -24,7 +24,6 @@
 
 #include <FreeRTOS/FreeRTOS.h>
 #include <FreeRTOS/stream_buffer.h>
-#include <FreeRTOS/serial.h> /* Demo/Common/include/ */
 
 #include <hal/kernel.h>
 #include <hal/device.h>
@@ -32,6 +31,8 @@
 #include <hal/serial.h>
 #include <hal/kmem.h>
 
+#include <host.h>
+
 struct sandbox_serial_port {
 	struct serial_port port;
 	bool initialized;
@@ -45,12 +46,12 @@ struct sandbox_serial_port {
 static int sandbox_serial_irq(int fd, void *data)
 {
 	struct sandbox_serial_port *sport = data;
-	char buf[256], *ptr = buf; /* don't worry */
+	char buf[256]; /* don't worry */
 	ssize_t len;
 	portBASE_TYPE resched = pdFALSE;
 
 	len = min(sizeof(buf),
-		  uxQueueSpacesAvailableFromISR(sport->port.queue[RX]));
+		  serial_ring_space(&sport->port.ring[RX]));
  restart:
 	len = read(fd, buf, len);
 	if (len == -1) {
@@ -60,8 +61,8 @@ static int sandbox_serial_irq(int fd, void *data)
 			printf("read: %s\n", strerror(errno));
 		goto out;
 	}
-	while (len-- > 0)
-		xQueueSendFromISR(sport->port.queue[RX], ptr++, &resched);
+	if (len > 0)
+		serial_rx_push(&sport->port, (u8 *)buf, len, &resched);
 
  out:
 	portEND_SWITCHING_ISR(resched);
@@ -98,20 +99,20 @@ static int sandbox_uart_init(struct serial_port *port)
 /* FIXME: reetrancy? */
 static void sandbox_uart_start_tx(struct serial_port *port)
 {
-	int ret, len = uxQueueMessagesWaiting(port->queue[TX]);
-	char ch;
-
-	while (len > 0) {
-		xQueueReceive(port->queue[TX], &ch, 0);
-	retry:
-		ret = write(1, &ch, 1);
-		if (ret < 0) {
-			if (errno == EINTR)
-				goto retry;
-			else
-				continue;
+	u8 buf[64];
+	int ret, len, off;
+
+	while ((len = serial_tx_pull(port, buf, sizeof(buf), NULL)) > 0) {
+		for (off = 0; off < len; off += ret) {
+		retry:
+			ret = write(1, buf + off, len - off);
+			if (ret < 0) {
+				if (errno == EINTR)
+					goto retry;
+				else
+					break;
+			}
 		}
-		len--;
 	}
 }
 
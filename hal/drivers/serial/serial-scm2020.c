@@ -330,8 +330,11 @@ int sc20uart_set_termios(struct serial_port *port, struct termios *termios)
 		lc |= SC20UART_LCR_PEN;
 	}
 
-	/* XXX: what would be the best values for FIFO thresholds ? */
-	fc |= SC20UART_FCR_ITL_0;
+	/*
+	 * Interrupt every 8 bytes and let the RX timeout pick up the tail,
+	 * so the handler drains the FIFO in bursts rather than per byte.
+	 */
+	fc |= SC20UART_FCR_ITL_1;
 	fc |= (SC20UART_FCR_TRFIFOE | SC20UART_FCR_RESETTF | SC20UART_FCR_RESETRF);
 
 	mc = sc20uart_readl(dev, OFT_SC20UART_MCR);
@@ -444,21 +447,36 @@ static int sc20uart_console_write(struct serial_port *port, char *s, int n)
 	return i;
 }
 
+/* Move as much as the TX FIFO takes from the ring, returns bytes moved. */
+static int sc20uart_fill_tx(struct sc20uart_port *atport,
+			    portBASE_TYPE *resched)
+{
+	struct serial_port *port = &atport->port;
+	u8 buf[16];
+	int i, n, total = 0;
+
+	while (!sc20uart_fifo_is_full(atport)) {
+		n = min((int)sizeof(buf), atport->fifo.depth - atport->fifo.fill);
+		n = serial_tx_pull(port, buf, n, resched);
+		if (n == 0)
+			break;
+		for (i = 0; i < n; i++)
+			sc20uart_port_putc(port, buf[i]);
+		total += n;
+	}
+
+	return total;
+}
+
 static void sc20uart_port_start_tx(struct serial_port *port)
 {
 	struct sc20uart_port *atport = to_sc20uart_port(port);
-	int len = uxQueueMessagesWaitingFromISR(port->queue[TX]);
 	unsigned long flags;
-	char ch;
 
 	local_irq_save(flags);
 
-	if (sc20uart_tx_stopped(port->device)) {
-		while (len-- > 0 && !sc20uart_fifo_is_full(atport)) {
-			xQueueReceive(port->queue[TX], &ch, 0);
-			sc20uart_port_putc(port, ch);
-		}
-	}
+	if (sc20uart_tx_stopped(port->device))
+		sc20uart_fill_tx(atport, NULL);
 
 	local_irq_restore(flags);
 }
@@ -469,7 +487,7 @@ static int sc20uart_irq(int irq, void *data)
 	struct serial_port *port = &atport->port;
 	struct device *dev = port->device;
 	struct device *serial = port->device;
-	char c;
+	u8 buf[16];
 	portBASE_TYPE resched = false;
 	int ret, len;
 	u32 intid, lsr;
@@ -483,26 +501,22 @@ static int sc20uart_irq(int irq, void *data)
 		else
 			atport->fifo.fill = atport->fifo.depth / 2;
 
-		len = uxQueueMessagesWaitingFromISR(port->queue[TX]);
-		if (len == 0) {
+		if (sc20uart_fill_tx(atport, &resched) == 0) {
 			/* No more data to transmit - disable tx interrupt */
 			sc20uart_tx_enable(serial, false);
-			goto txdone;
-		}
-		while (len-- > 0 && !sc20uart_fifo_is_full(atport)) {
-			xQueueReceiveFromISR(port->queue[TX], &c,
-					     &resched);
-			sc20uart_port_putc(port, c);
-			len--;
 		}
 	}
- txdone:
 	if (intid == SC20UART_IIR_INTRID_RBR ||
 	    intid == SC20UART_IIR_INTRID_RTI) {
-		while ((ret = sc20uart_getc(serial)) >= 0) {
-			c = (char) (ret & 0xff);
-			xQueueSendFromISR(port->queue[RX], &c, &resched);
-		}
+		do {
+			for (len = 0; len < (int)sizeof(buf); len++) {
+				if ((ret = sc20uart_getc(serial)) < 0)
+					break;
+				buf[len] = (u8)ret;
+			}
+			if (len)
+				serial_rx_push(port, buf, len, &resched);
+		} while (len == (int)sizeof(buf));
 	}
 	if (intid == SC20UART_IIR_INTRID_LSR) {
 		lsr = sc20uart_readl(serial, OFT_SC20UART_LSR);
@@ -652,8 +666,8 @@ int sc20uart_suspend(struct device *dev, u32 *idle)
 
 	if (!port->initialized)
 		return 0;
-	busy |= uxQueueMessagesWaitingFromISR(port->queue[TX]) ? 1: 0;
-	busy |= uxQueueMessagesWaitingFromISR(port->queue[RX]) ? 1 << 1: 0;
+	busy |= serial_ring_count(&port->ring[TX]) ? 1: 0;
+	busy |= serial_ring_count(&port->ring[RX]) ? 1 << 1: 0;
 	busy |= sc20uart_tx_empty(dev) ? 0 : 1 << 2;
 	busy |= (readl(sc20uart_addr(dev, OFT_SC20UART_LSR)) &
 		 SC20UART_LSR_DR) ? 1 << 3: 0;
@@ -72,6 +72,8 @@ static int sandbox_cmd_write(struct device *dev, const u8 *cmd, size_t cmdlen,
 			erase_size = 32 * 1024;
 		} else if (addr < 0x100000) {
 			erase_size = 8 * 1024;
+		} else {
+			erase_size = 64 * 1024;
 		}
 		printk("Erasing %p-%p (%d KiB)\n", dev->base[1] + addr,
 		       dev->base[1] + addr + erase_size, erase_size/1024);
@@ -106,16 +108,19 @@ static struct spi_flash_master_ops sandbox_flash_ops = {
 #include <sys/stat.h>
 #include <sys/mman.h>
 
+#include <soc.h>
+#include <host.h>
+
 static int sandbox_flash_probe(struct device *dev)
 {
 	struct spi_flash *flash;
+	const char *image = sandbox_flash_image ? : SANDBOX_SPI_IMAGE_FILE;
 	int fd;
 	struct stat stat;
 
-	fd = open(SANDBOX_SPI_IMAGE_FILE, O_RDWR);
+	fd = open(image, O_RDWR);
 	if (fd < 0) {
-		printk("SF: failed to open serial flash %s\n",
-		       SANDBOX_SPI_IMAGE_FILE);
+		printk("SF: failed to open serial flash %s\n", image);
 		return -ENODEV;
 	}
 	fstat(fd, &stat);
@@ -123,7 +128,9 @@ static int sandbox_flash_probe(struct device *dev)
 			    PROT_READ|PROT_WRITE,
 			    MAP_SHARED|MAP_32BIT, fd, 0);
 
-	if (dev->base[1] == NULL)
+	close(fd);
+
+	if (dev->base[1] == MAP_FAILED)
 		return -EINVAL;
 
 	flash = spi_flash_probe(dev);
@@ -689,7 +689,7 @@ sfdp_parse_param(struct spi_flash *flash, struct sfdp_param_hdr *hdr)
 	u16 ver = sfdp_param_version(hdr);
 	off_t addr = sfdp_param_address(hdr);
 	size_t size = sfdp_param_size(hdr);
-	int i, ret;
+	int i, ret = 0;
     sfdp_parser_t *best_parser;
 
 	dbg("SF: SFDP param (id=%04x, ver=%d.%d, ptp=%08x, len=%d)\n",
@@ -733,7 +733,7 @@ int spi_flash_probe_sfdp(struct spi_flash *flash)
 {
 	struct sfdp_hdr top;
 	struct sfdp_param_hdr pdir;
-	int i, ret;
+	int i, ret = 0;
 
 	spi_flash_read_sfdp(flash, 0x0, 8, &top);
 	if (memcmp(top.signature, "SFDP", 4))
@@ -918,7 +918,8 @@ struct spi_flash *spi_flash_probe(struct device *master)
 
     /* Select the fastest Multi I/O read mode, if any. */
     /* Again, flash->fast_read[0] is the fastest. */
-    for (i = 0; i < ARRAY_SIZE(flash->fast_read); i++) {
+    /* Masters without a memory mapped read command stick to READ. */
+    for (i = 0; ops->set_mm_rcmd && i < ARRAY_SIZE(flash->fast_read); i++) {
         struct fast_read_cmd *rcmd = &flash->fast_read[i];
         if (rcmd->opcode && ops->set_mm_rcmd(master, rcmd, true)) {
             bool qio = ops->is_quad_feasible ? ops->is_quad_feasible(master) : false;
@@ -1182,9 +1183,9 @@ int spi_flash_write(struct spi_flash *flash, u32 offset, size_t size,
 	size_t page_size, actual, len;
 	int ret;
 
-	if (((u32)buf >= (u32)flash->mem_base) &&
-	    ((u32)buf <= (u32)flash->mem_base + flash->size)) {
-		printk("Invalid buf address : 0x%08x\n", (u32)buf);
+	if (((uintptr_t)buf >= (uintptr_t)flash->mem_base) &&
+	    ((uintptr_t)buf <= (uintptr_t)flash->mem_base + flash->size)) {
+		printk("Invalid buf address : %p\n", buf);
 		errno = EINVAL;
 		return -1;
 	}
@@ -1233,7 +1234,7 @@ int spi_flash_read(struct spi_flash *flash, u32 offset, size_t size, void *buf)
 {
 	struct spi_flash_master_ops *ops = spi_flash_master_ops(flash->master);
 	size_t rlen, xlen;
-	int ret;
+	int ret = 0;
 
 #if 1
 	xlen =  ops->max_xfer_size;
@@ -25,20 +25,20 @@ static int sandbox_timer_probe(struct device *timer)
 	return 0;
 }
 
-static int sandbox_timer_setup(struct device *timer,
-		u32 config, u32 param, timer_isr isr)
+static int sandbox_timer_setup(struct device *timer, u8 ch,
+		u32 config, u32 param, timer_isr isr, void *ctx)
 {
 	return 0;
 }
 
-static int sandbox_timer_start(struct device *timer)
+static int sandbox_timer_start(struct device *timer, u8 ch)
 {
 	gettimeofday(&start, NULL);
 
 	return 0;
 }
 
-static int sandbox_timer_stop(struct device *timer)
+static int sandbox_timer_stop(struct device *timer, u8 ch)
 {
 	return 0;
 }
@@ -48,7 +48,7 @@ static unsigned long sandbox_timer_get_rate(struct device *timer)
 	return 1000000;
 }
 
-static u32 sandbox_timer_get_value(struct device *timer)
+static u32 sandbox_timer_get_value(struct device *timer, u8 ch)
 {
 	struct timeval now, tv;
 
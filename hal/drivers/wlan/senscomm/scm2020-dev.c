@@ -75,6 +75,7 @@
 
 #include "sys/ioctl.h"
 #include "vfs.h"
+#include "ktrace.h"
 
 /* Sanity checks */
 #if (CONFIG_MEMP_NUM_MBUF_CACHE <= (1 << CONFIG_RX_BUF_NUM_LOG2))
@@ -1601,6 +1602,8 @@ scm2020_mac_isr(int irq, void *data)
 	irqs = mac_readl(dev, REG_INTR_STATUS);
 	mac_writel(irqs, dev, REG_INTR_CLEAR);
 
+	ktrace_begin(KTRACE_MAC_ISR, irqs);
+
 #ifdef VERIFY_DTIM_PARSER
     /* Only for VIF0 for now. */
 	if (bfget_m(irqs, INTR_STATUS, RX_DTIM)) {
@@ -1626,6 +1629,7 @@ scm2020_mac_isr(int irq, void *data)
 	if (bfget_m(irqs, INTR_STATUS, RX_DTIM)) {
 		set_dtim_parser_int_inc(sc);
 #ifdef CONFIG_SCM2020_PM_DTIM_PARSER
+		ktrace_end(KTRACE_MAC_ISR, 0);
 		return 0;
 #endif
 	}
@@ -1664,6 +1668,7 @@ scm2020_mac_isr(int irq, void *data)
 		/* READ_PTR == WRITE_PTR can happen by manipulating REG_RX_BUF_CFG.EN */
 		if (read_ptr(sc, READ) == read_ptr(sc, WRITE)) {
 			printk("[%s, %d] Spurious interrupt (case 1) ignored\n", __func__, __LINE__);
+			ktrace_end(KTRACE_MAC_ISR, 0);
 			return 0; /* spurious */
 		}
 #ifdef VERIFY_DTIM_PARSER
@@ -1727,6 +1732,8 @@ scm2020_mac_isr(int irq, void *data)
 	}
 #endif
 
+	ktrace_end(KTRACE_MAC_ISR, 0);
+
 	return 0;
 }
 
@@ -1978,6 +1985,25 @@ scm2020_set_quiet(struct ieee80211_node *ni, u_int8_t *quiet_elm)
 	return 0;
 }
 
+#ifdef CONFIG_KTRACE
+/* rx_done and rx_desc_refill live in ROM; trace them from here. */
+static void
+rx_done_traced(void *data, int pending)
+{
+	ktrace_begin(KTRACE_WLAN_RX, pending);
+	rx_done(data, pending);
+	ktrace_end(KTRACE_WLAN_RX, 0);
+}
+
+static void
+rx_desc_refill_traced(void *data, int pending)
+{
+	ktrace_begin(KTRACE_WLAN_REFILL, pending);
+	rx_desc_refill(data, pending);
+	ktrace_end(KTRACE_WLAN_REFILL, 0);
+}
+#endif
+
 extern void scm2020_scan_end_chk(struct ieee80211com *ic, struct ieee80211vap *vap);
 __iram__ static int
 scm2020_attach(struct device *dev)
@@ -2032,8 +2058,13 @@ scm2020_attach(struct device *dev)
 		memcpy(sc->phy.rx_lut, rx_lut_r2, sizeof(rx_lut_r2));
 	}
 
+#ifdef CONFIG_KTRACE
+	TASK_INIT(&sc->rx.refill_task, 0, rx_desc_refill_traced, sc);
+	TASK_INIT(&sc->rx.handler_task, 10, rx_done_traced, sc);
+#else
 	TASK_INIT(&sc->rx.refill_task, 0, rx_desc_refill, sc);
 	TASK_INIT(&sc->rx.handler_task, 10, rx_done, sc);
+#endif
 	TASK_INIT(&sc->tx.reclaim_task, 0, tx_reclaim, sc);
 	TASK_INIT(&sc->txq_drop_task, 0, scm2020_txq_drop, sc);
 	TASK_INIT(&sc->ps_chk_bcn_miss_task, 0, scm2020_sta_ps_bmiss, sc);
@@ -2480,6 +2511,24 @@ scm2020_wlan_ctl_vap(struct device *dev, struct ieee80211vap *vap,
 	return err;
 }
 
+static int
+scm2020_wlan_txq_depth(struct device *dev, int ac)
+{
+	struct sc_softc *sc = dev->driver_data;
+	struct sc_tx_queue *txq;
+	int i, depth = 0;
+
+	for (i = 0; i < SC_NR_TXQ; i++) {
+		txq = &sc->txq[i];
+		if (txq->ac != ac)
+			continue;
+		depth += _IF_QLEN(&txq->ifq) + _IF_QLEN(&txq->queue) +
+			_IF_QLEN(&txq->sched) + _IF_QLEN(&txq->retry);
+	}
+
+	return depth;
+}
+
 __iram__ static int
 scm2020_wlan_version(struct device *dev, char *buf, int size)
 {
@@ -2546,6 +2595,7 @@ __dram__ struct wlan_ops scm2020_wlan_ops = {
 	.remove_vap = scm2020_wlan_remove_vap,
 	.get_vap = scm2020_wlan_get_vap,
 	.ctl_vap = scm2020_wlan_ctl_vap,
+	.txq_depth = scm2020_wlan_txq_depth,
 };
 
 static declare_driver(scm2020_wlan) = {
@@ -0,0 +1,31 @@
+/*
+ * Copyright 2024-2024 Senscomm Semiconductor Co., Ltd.	All rights reserved.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __FREERTOS_TICK_CONFIG_H__
+#define __FREERTOS_TICK_CONFIG_H__
+
+#include <stdint.h>
+
+/*
+ * The sandbox has no machine timer; mtime is the host monotonic clock
+ * counted at XTAL_CLOCK_HZ / MTIME_CLK_DIV. The tick itself is a timerfd
+ * (see port.c) and there is no mtimecmp to program.
+ */
+
+uint64_t sandbox_mtime(void);
+
+static inline uint64_t prvReadMtime( void )
+{
+	return sandbox_mtime();
+}
+
+#endif /* __FREERTOS_TICK_CONFIG_H__ */
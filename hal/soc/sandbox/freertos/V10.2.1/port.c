@@ -0,0 +1,374 @@
+/*
+ * Copyright 2024-2024 Senscomm Semiconductor Co., Ltd.	All rights reserved.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#define __USE_NATIVE_HEADER__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <signal.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/timerfd.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include <hal/irq.h>
+#include <soc.h>
+
+#include "FreeRTOS_tick_config.h"
+#include "host.h"
+
+/*
+ * FreeRTOS sandbox port.
+ *
+ * Each task runs on a host thread of its own, created by
+ * pxPortInitialiseStack() and parked on a condition variable until the
+ * scheduler picks it. Exactly one of them (the one of pxCurrentTCB)
+ * is ever let go; a context switch wakes the next thread and parks the
+ * previous one.
+ *
+ * An interrupt is SIG_IRQ sent to the running thread by the virtual
+ * interrupt controller (irq.c); the signal handler runs the handlers
+ * and switches tasks if one of them asked for it, so interrupts preempt
+ * tasks the way they do on the target. Masking interrupts is blocking
+ * SIG_IRQ in the calling thread, and critical nesting is kept in the
+ * TCB by the kernel (portCRITICAL_NESTING_IN_TCB).
+ *
+ * The tick is one more virtual interrupt, on a timerfd.
+ */
+
+#define SIG_IRQ		SIGUSR1
+
+struct sandbox_thread {
+	pthread_t pthread;
+	TaskFunction_t code;
+	void *param;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	bool run;
+	bool dying;
+};
+
+extern void * volatile pxCurrentTCB;
+
+static sigset_t irq_sigset;
+static struct sandbox_thread * volatile running;
+static volatile bool scheduler_running;
+static volatile bool in_isr;
+static volatile bool switch_pending;
+static int tick_fd = -1;
+
+/* pxTopOfStack, the first member of a TCB, holds the thread. */
+static struct sandbox_thread *thread_of(void *tcb)
+{
+	return *(struct sandbox_thread **)tcb;
+}
+
+static void thread_resume(struct sandbox_thread *t)
+{
+	pthread_mutex_lock(&t->lock);
+	t->run = true;
+	pthread_cond_signal(&t->cond);
+	pthread_mutex_unlock(&t->lock);
+}
+
+static void thread_suspend(struct sandbox_thread *t)
+{
+	pthread_mutex_lock(&t->lock);
+	while (!t->run)
+		pthread_cond_wait(&t->cond, &t->lock);
+	t->run = false;
+	pthread_mutex_unlock(&t->lock);
+
+	if (t->dying)
+		pthread_exit(NULL);
+}
+
+/* Before anything, main() included, can mask interrupts. */
+static void __attribute__((constructor)) port_sigset_init(void)
+{
+	sigemptyset(&irq_sigset);
+	sigaddset(&irq_sigset, SIG_IRQ);
+}
+
+static bool irq_masked(void)
+{
+	sigset_t cur;
+
+	pthread_sigmask(SIG_SETMASK, NULL, &cur);
+
+	return sigismember(&cur, SIG_IRQ);
+}
+
+void vPortDisableInterrupts(void)
+{
+	pthread_sigmask(SIG_BLOCK, &irq_sigset, NULL);
+}
+
+void vPortEnableInterrupts(void)
+{
+	pthread_sigmask(SIG_UNBLOCK, &irq_sigset, NULL);
+
+	/*
+	 * An interrupt raised while another thread was running (and got
+	 * switched out with it masked) is still pending; take it now.
+	 */
+	if (scheduler_running && (switch_pending || sandbox_irq_pending()))
+		pthread_kill(pthread_self(), SIG_IRQ);
+}
+
+uint32_t ulPortSetInterruptMask(void)
+{
+	uint32_t masked = irq_masked();
+
+	vPortDisableInterrupts();
+
+	return masked;
+}
+
+void vPortClearInterruptMask(uint32_t ulMask)
+{
+	if (!ulMask)
+		vPortEnableInterrupts();
+}
+
+/* Called with interrupts masked. */
+static void port_switch(void)
+{
+	struct sandbox_thread *prev = running, *next;
+
+	switch_pending = false;
+	vTaskSwitchContext();
+	next = thread_of(pxCurrentTCB);
+	if (next == prev)
+		return;
+
+	running = next;
+	thread_resume(next);
+	thread_suspend(prev);
+}
+
+void vPortYield(void)
+{
+	uint32_t mask = ulPortSetInterruptMask();
+
+	port_switch();
+	vPortClearInterruptMask(mask);
+}
+
+BaseType_t xPortIsInsideInterrupt(void)
+{
+	return in_isr ? pdTRUE : pdFALSE;
+}
+
+void vPortYieldFromISR(void)
+{
+	if (in_isr)
+		switch_pending = true;
+	else
+		vPortYield();
+}
+
+void vPortWaitForInterrupt(void)
+{
+	sigset_t none;
+
+	vPortDisableInterrupts();
+	if (!switch_pending && !sandbox_irq_pending()) {
+		sigemptyset(&none);
+		sigsuspend(&none);
+	}
+	vPortEnableInterrupts();
+}
+
+static void port_irq_signal(int sig)
+{
+	int saved_errno = errno;
+
+	/*
+	 * A stale signal on a thread that is not running any more stays
+	 * unhandled; whoever runs now picks up the pending interrupts
+	 * the next time it enables them.
+	 */
+	if (!scheduler_running || running->pthread != pthread_self())
+		goto out;
+
+	do {
+		in_isr = true;
+		sandbox_irq_dispatch();
+		in_isr = false;
+		if (switch_pending)
+			port_switch();
+	} while (sandbox_irq_pending() || switch_pending);
+
+ out:
+	errno = saved_errno;
+}
+
+/* Called from the interrupt controller thread. */
+void sandbox_cpu_interrupt(void)
+{
+	struct sandbox_thread *t = running;
+
+	if (scheduler_running && t)
+		pthread_kill(t->pthread, SIG_IRQ);
+}
+
+static void *port_thread_entry(void *arg)
+{
+	struct sandbox_thread *t = arg;
+
+	thread_suspend(t);
+
+	/* Tasks start with interrupts enabled. */
+	vPortEnableInterrupts();
+
+	t->code(t->param);
+
+	/* Tasks are not supposed to return. */
+	vTaskDelete(NULL);
+
+	return NULL;
+}
+
+StackType_t *pxPortInitialiseStack(StackType_t *pxTopOfStack,
+				   TaskFunction_t pxCode, void *pvParameters)
+{
+	struct sandbox_thread *t;
+	pthread_attr_t attr;
+	sigset_t all, old;
+
+	/*
+	 * The task stack is not used by the host thread, which has one
+	 * of its own; its top holds the thread bookkeeping instead.
+	 */
+	t = (struct sandbox_thread *)(((uintptr_t)(pxTopOfStack + 1)
+				       - sizeof(*t)) & ~(uintptr_t)portBYTE_ALIGNMENT_MASK);
+	t->code = pxCode;
+	t->param = pvParameters;
+	t->run = false;
+	t->dying = false;
+	pthread_mutex_init(&t->lock, NULL);
+	pthread_cond_init(&t->cond, NULL);
+
+	/* Start with everything blocked; port_thread_entry() unblocks SIG_IRQ. */
+	sigfillset(&all);
+	pthread_sigmask(SIG_SETMASK, &all, &old);
+
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+	if (pthread_create(&t->pthread, &attr, port_thread_entry, t))
+		configASSERT(0);
+	pthread_attr_destroy(&attr);
+
+	pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+	return (StackType_t *)t;
+}
+
+void vPortCleanUpTCB(void *pxTCB)
+{
+	struct sandbox_thread *t = thread_of(pxTCB);
+
+	/* The stack holding *t is freed right after this returns. */
+	t->dying = true;
+	thread_resume(t);
+	pthread_join(t->pthread, NULL);
+	pthread_cond_destroy(&t->cond);
+	pthread_mutex_destroy(&t->lock);
+}
+
+static int port_tick(int irq, void *data)
+{
+	uint64_t n;
+
+	if (read(tick_fd, &n, sizeof(n)) != sizeof(n))
+		return 0;
+
+	/* Catch up with ticks the host was too busy to deliver. */
+	while (n--) {
+		if (xTaskIncrementTick() != pdFALSE)
+			switch_pending = true;
+	}
+
+	return 0;
+}
+
+#define MTIME_HZ	(CONFIG_XTAL_CLOCK_HZ / CONFIG_MTIME_CLK_DIV)
+
+uint64_t sandbox_mtime(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * MTIME_HZ + ts.tv_nsec / (1000000000 / MTIME_HZ);
+}
+
+void vConfigureTickInterrupt(void)
+{
+	struct itimerspec its = {
+		.it_interval.tv_nsec = 1000000000 / configTICK_RATE_HZ,
+		.it_value.tv_nsec = 1000000000 / configTICK_RATE_HZ,
+	};
+
+	tick_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	configASSERT(tick_fd >= 0);
+
+	timerfd_settime(tick_fd, 0, &its, NULL);
+	request_irq(tick_fd, port_tick, "tick", 0, NULL);
+}
+
+void vClearTickInterrupt(void)
+{
+}
+
+BaseType_t _xPortStartScheduler(void)
+{
+	struct sigaction sa = {
+		.sa_handler = port_irq_signal,
+		.sa_flags = SA_RESTART,
+	};
+	sigset_t none;
+
+	/* SIG_IRQ itself is blocked while the handler runs. */
+	sigemptyset(&sa.sa_mask);
+	sigaction(SIG_IRQ, &sa, NULL);
+
+	configSETUP_TICK_INTERRUPT();
+
+	running = thread_of(pxCurrentTCB);
+	scheduler_running = true;
+	thread_resume(running);
+
+	/*
+	 * The thread that called main() has nothing left to do but keep
+	 * the process alive; it never runs FreeRTOS code again.
+	 */
+	sigfillset(&none);
+	pthread_sigmask(SIG_SETMASK, &none, NULL);
+	for (;;)
+		pause();
+
+	return pdFAIL;
+}
+
+__func_tab__ BaseType_t (*xPortStartScheduler)(void) = _xPortStartScheduler;
+
+void vPortEndScheduler(void)
+{
+	scheduler_running = false;
+	exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright 2024-2024 Senscomm Semiconductor Co., Ltd.	All rights reserved.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef PORTMACRO_H
+#define PORTMACRO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * FreeRTOS port for the sandbox (Linux host, native or i386).
+ *
+ * Every task is a host thread and only the one pxCurrentTCB points to
+ * is allowed to run. "Interrupts" are a signal sent to that thread,
+ * and masking them is blocking the signal. See port.c.
+ */
+
+#define portCHAR		char
+#define portFLOAT		float
+#define portDOUBLE		double
+#define portLONG		long
+#define portSHORT		short
+#define portSTACK_TYPE		uint32_t
+#define portBASE_TYPE		int32_t
+#define portUBASE_TYPE		uint32_t
+#define portMAX_DELAY		( TickType_t ) 0xffffffffUL
+#define portPOINTER_SIZE_TYPE	uintptr_t
+
+typedef portSTACK_TYPE StackType_t;
+typedef portBASE_TYPE BaseType_t;
+typedef portUBASE_TYPE UBaseType_t;
+typedef portUBASE_TYPE TickType_t;
+
+#define portTICK_TYPE_IS_ATOMIC	1
+
+#define portSTACK_GROWTH	( -1 )
+#define portTICK_PERIOD_MS	( ( TickType_t ) 1000 / configTICK_RATE_HZ )
+#define portBYTE_ALIGNMENT	8
+
+/* Scheduler utilities */
+extern void vPortYield( void );
+extern void vPortYieldFromISR( void );
+extern BaseType_t xPortIsInsideInterrupt( void );
+
+#define portYIELD()			vPortYield()
+#define portEND_SWITCHING_ISR( xSwitchRequired ) \
+	do { if( xSwitchRequired ) vPortYieldFromISR(); } while( 0 )
+#define portYIELD_FROM_ISR( x )		portEND_SWITCHING_ISR( x )
+
+/* Critical section management */
+#define portCRITICAL_NESTING_IN_TCB	1
+
+extern void vTaskEnterCritical( void );
+extern void vTaskExitCritical( void );
+extern uint32_t ulPortSetInterruptMask( void );
+extern void vPortClearInterruptMask( uint32_t ulMask );
+extern void vPortDisableInterrupts( void );
+extern void vPortEnableInterrupts( void );
+
+#define portSET_INTERRUPT_MASK_FROM_ISR()		ulPortSetInterruptMask()
+#define portCLEAR_INTERRUPT_MASK_FROM_ISR( x )		vPortClearInterruptMask( x )
+#define portDISABLE_INTERRUPTS()			vPortDisableInterrupts()
+#define portENABLE_INTERRUPTS()				vPortEnableInterrupts()
+#define portENTER_CRITICAL()				vTaskEnterCritical()
+#define portEXIT_CRITICAL()				vTaskExitCritical()
+
+/* The host thread of a task is torn down with the task. */
+extern void vPortCleanUpTCB( void *pxTCB );
+#define portCLEAN_UP_TCB( pxTCB )	vPortCleanUpTCB( pxTCB )
+
+/* What the idle task does with nothing to do: sleep until an interrupt. */
+extern void vPortWaitForInterrupt( void );
+#define portWAIT_FOR_INTERRUPT()	vPortWaitForInterrupt()
+
+#ifndef configUSE_PORT_OPTIMISED_TASK_SELECTION
+	#define configUSE_PORT_OPTIMISED_TASK_SELECTION 1
+#endif
+
+#if( configUSE_PORT_OPTIMISED_TASK_SELECTION == 1 )
+	#if( configMAX_PRIORITIES > 32 )
+		#error configUSE_PORT_OPTIMISED_TASK_SELECTION can only be set to 1 when configMAX_PRIORITIES is less than or equal to 32.
+	#endif
+
+	#define portRECORD_READY_PRIORITY( uxPriority, uxReadyPriorities ) ( uxReadyPriorities ) |= ( 1UL << ( uxPriority ) )
+	#define portRESET_READY_PRIORITY( uxPriority, uxReadyPriorities ) ( uxReadyPriorities ) &= ~( 1UL << ( uxPriority ) )
+	#define portGET_HIGHEST_PRIORITY( uxTopPriority, uxReadyPriorities ) uxTopPriority = ( 31UL - __builtin_clz( uxReadyPriorities ) )
+#endif
+
+#define portTASK_FUNCTION_PROTO( vFunction, pvParameters ) void vFunction( void *pvParameters )
+#define portTASK_FUNCTION( vFunction, pvParameters ) void vFunction( void *pvParameters )
+
+#define portNOP()
+#define portINLINE	__inline
+#ifndef portFORCE_INLINE
+	#define portFORCE_INLINE inline __attribute__(( always_inline))
+#endif
+#define portMEMORY_BARRIER() __asm volatile( "" ::: "memory" )
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PORTMACRO_H */
@@ -0,0 +1,45 @@
+/*
+ * Copyright 2024-2024 Senscomm Semiconductor Co., Ltd.	All rights reserved.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __SANDBOX_HOST_H__
+#define __SANDBOX_HOST_H__
+
+/*
+ * Host system calls.
+ *
+ * include/unistd.h and include/fcntl.h turn these names into calls to
+ * the wise vfs, so sandbox code that talks to the host kernel includes
+ * this after everything else.
+ */
+
+#include <stddef.h>
+#include <sys/types.h>
+
+#undef open
+#undef close
+#undef read
+#undef write
+#undef fcntl
+#undef fstat
+
+int open(const char *pathname, int flags, ...);
+int close(int fd);
+ssize_t read(int fd, void *buf, size_t count);
+ssize_t write(int fd, const void *buf, size_t count);
+int pipe(int fds[2]);
+int pause(void);
+int fcntl(int fd, int cmd, ...);
+struct stat;
+int fstat(int fd, struct stat *st);
+int ioctl(int fd, unsigned long request, ...);
+
+#endif /* __SANDBOX_HOST_H__ */
@@ -0,0 +1,268 @@
+/*
+ * Copyright 2024-2024 Senscomm Semiconductor Co., Ltd.	All rights reserved.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#define __USE_NATIVE_HEADER__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <pthread.h>
+
+#include <hal/kernel.h>
+#include <hal/init.h>
+#include <hal/irq.h>
+#include <hal/console.h>
+
+#include "soc.h"
+#include "host.h"
+
+/*
+ * Virtual interrupt controller.
+ *
+ * An interrupt line is a host file descriptor, and its number is the
+ * fd itself. A host thread poll()s the enabled lines; when one becomes
+ * readable it is latched pending, masked off the poll set (like a
+ * level-triggered source until serviced) and the running task thread
+ * is interrupted. sandbox_irq_dispatch() runs from that interrupt and
+ * unmasks every line it has served.
+ */
+
+#define IRQ_WORDS	((CONFIG_NR_IRQ + 31) / 32)
+
+struct irq_entry {
+	const char *name;
+	int (*handler)(int, void *);
+	void *priv;
+	unsigned priority;
+	u32 count;
+	bool enabled;
+};
+
+static struct irq_entry irq_table[CONFIG_NR_IRQ];
+
+/* Shared with the poll thread. */
+static volatile u32 irq_pending[IRQ_WORDS];
+static volatile u32 irq_busy[IRQ_WORDS];
+static int wake_fd[2] = { -1, -1 };
+
+static void irq_set(volatile u32 *map, int irq)
+{
+	__atomic_or_fetch(&map[irq / 32], 1U << (irq % 32), __ATOMIC_SEQ_CST);
+}
+
+static void irq_clear(volatile u32 *map, int irq)
+{
+	__atomic_and_fetch(&map[irq / 32], ~(1U << (irq % 32)), __ATOMIC_SEQ_CST);
+}
+
+static bool irq_test(volatile u32 *map, int irq)
+{
+	return __atomic_load_n(&map[irq / 32], __ATOMIC_SEQ_CST) & (1U << (irq % 32));
+}
+
+/* Have the poll thread rebuild its fd set. */
+static void irq_wake(void)
+{
+	char c = 0;
+
+	if (wake_fd[1] >= 0)
+		write(wake_fd[1], &c, 1);
+}
+
+static void *irq_poll_thread(void *arg)
+{
+	struct pollfd fds[CONFIG_NR_IRQ + 1];
+	int nfds, i, n;
+	char buf[16];
+
+	for (;;) {
+		fds[0].fd = wake_fd[0];
+		fds[0].events = POLLIN;
+		nfds = 1;
+
+		for (i = 0; i < CONFIG_NR_IRQ; i++) {
+			if (!irq_table[i].enabled || irq_test(irq_busy, i))
+				continue;
+			fds[nfds].fd = i;
+			fds[nfds].events = POLLIN;
+			nfds++;
+		}
+
+		n = poll(fds, nfds, -1);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			printf("irq: poll: %s\n", strerror(errno));
+			return NULL;
+		}
+
+		if (fds[0].revents)
+			read(wake_fd[0], buf, sizeof(buf));
+
+		n = 0;
+		for (i = 1; i < nfds; i++) {
+			if (!fds[i].revents)
+				continue;
+			irq_set(irq_busy, fds[i].fd);
+			irq_set(irq_pending, fds[i].fd);
+			n++;
+		}
+
+		if (n)
+			sandbox_cpu_interrupt();
+	}
+
+	return NULL;
+}
+
+bool sandbox_irq_pending(void)
+{
+	int i;
+
+	for (i = 0; i < IRQ_WORDS; i++)
+		if (__atomic_load_n(&irq_pending[i], __ATOMIC_SEQ_CST))
+			return true;
+
+	return false;
+}
+
+/* Called with interrupts masked, from port_irq_signal(). */
+void sandbox_irq_dispatch(void)
+{
+	struct irq_entry *irq;
+	u32 map;
+	int i, j;
+
+	for (i = 0; i < IRQ_WORDS; i++) {
+		map = __atomic_exchange_n(&irq_pending[i], 0, __ATOMIC_SEQ_CST);
+		while (map) {
+			j = __builtin_ctz(map);
+			map &= map - 1;
+			irq = &irq_table[i * 32 + j];
+			if (irq->handler && irq->enabled) {
+				irq->count++;
+				irq->handler(i * 32 + j, irq->priv);
+			}
+			irq_clear(irq_busy, i * 32 + j);
+		}
+	}
+
+	irq_wake();
+}
+
+int request_irq(int irq, int (*handler)(int, void *), const char *name,
+		unsigned priority, void *priv)
+{
+	struct irq_entry *i;
+
+	if (irq < 0 || irq >= CONFIG_NR_IRQ) {
+		printk("irq: %s: fd %d out of range (NR_IRQ=%d)\n",
+		       name, irq, CONFIG_NR_IRQ);
+		return -EINVAL;
+	}
+
+	i = &irq_table[irq];
+	/* A host fd cannot be shared. */
+	if (i->handler)
+		return -EBUSY;
+
+	i->name = name;
+	i->handler = handler;
+	i->priv = priv;
+	i->priority = priority;
+	i->count = 0;
+	i->enabled = true;
+
+	irq_wake();
+
+	return 0;
+}
+
+void free_irq(int irq, const char *name)
+{
+	struct irq_entry *i;
+
+	if (irq < 0 || irq >= CONFIG_NR_IRQ)
+		return;
+
+	i = &irq_table[irq];
+	if (!i->handler || strcmp(i->name, name))
+		return;
+
+	i->enabled = false;
+	i->handler = NULL;
+	irq_clear(irq_pending, irq);
+
+	irq_wake();
+}
+
+void enable_irq(int irq)
+{
+	if (irq < 0 || irq >= CONFIG_NR_IRQ)
+		return;
+
+	irq_table[irq].enabled = true;
+	irq_wake();
+}
+
+void disable_irq(int irq)
+{
+	if (irq < 0 || irq >= CONFIG_NR_IRQ)
+		return;
+
+	irq_table[irq].enabled = false;
+	irq_wake();
+}
+
+int get_irq_stat(char *buf, size_t size)
+{
+	struct irq_entry *irq;
+	int i;
+	char *end = buf + size;
+
+	buf += snprintk(buf, end - buf, "IRQ:%8s%8s   %8s\n", "CPU0", "PRIO", "");
+
+	for (i = 0; i < CONFIG_NR_IRQ; i++) {
+		irq = &irq_table[i];
+		if (irq->handler == NULL)
+			continue;
+
+		buf += snprintk(buf, end - buf, "%3d:%8d%8d   %s\n",
+				i, irq->count, irq->priority, irq->name);
+		if (buf > end)
+			return -1;
+	}
+
+	return 0;
+}
+
+static int sandbox_irq_init(void)
+{
+	pthread_t thread;
+	sigset_t all, old;
+
+	if (pipe(wake_fd) < 0)
+		return -errno;
+
+	/* Interrupts go to task threads only, never to this one. */
+	sigfillset(&all);
+	pthread_sigmask(SIG_SETMASK, &all, &old);
+	pthread_create(&thread, NULL, irq_poll_thread, NULL);
+	pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+	return 0;
+}
+__initcall__(arch, sandbox_irq_init);
@@ -0,0 +1,1315 @@
+/*
+ * Copyright 2024-2024 Senscomm Semiconductor Co., Ltd.	All rights reserved.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Sandbox CMSIS-RTOS2 over FreeRTOS (kernel/cmsis-freertos only
+ * carries the Kconfig for the ROM one).
+ *
+ * CMSIS priorities (osPriorityIdle..osPriorityISR) are spread evenly
+ * over the configMAX_PRIORITIES FreeRTOS levels.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+#include "timers.h"
+#include "event_groups.h"
+#include "xqueue.h"
+
+#include <hal/timer.h>
+#include <cmsis_os.h>
+
+#define IS_IRQ()		(xPortIsInsideInterrupt() == pdTRUE)
+
+#define MAX_BITS_TASK_NOTIFY	31U
+#define MAX_BITS_EVENT_GROUPS	24U
+
+#define THREAD_FLAGS_INVALID_BITS	(~((1UL << MAX_BITS_TASK_NOTIFY) - 1U))
+#define EVENT_FLAGS_INVALID_BITS	(~((1UL << MAX_BITS_EVENT_GROUPS) - 1U))
+
+#define CMSIS_PRIO_LEVELS	(osPriorityISR + 8)
+
+static osKernelState_t KernelState = osKernelInactive;
+
+int g_os_low_memory_th = CONFIG_LOW_MEMORY_LOW_THRESHOLD;
+
+static UBaseType_t to_rtos_prio(osPriority_t prio)
+{
+	return (UBaseType_t)prio * configMAX_PRIORITIES / CMSIS_PRIO_LEVELS;
+}
+
+static osPriority_t to_cmsis_prio(UBaseType_t prio)
+{
+	return (osPriority_t)(prio * CMSIS_PRIO_LEVELS / configMAX_PRIORITIES);
+}
+
+static TickType_t to_ticks(uint32_t timeout)
+{
+	return timeout == osWaitForever ? portMAX_DELAY : (TickType_t)timeout;
+}
+
+/* Kernel */
+
+osStatus_t osKernelInitialize(void)
+{
+	if (IS_IRQ())
+		return osErrorISR;
+
+	if (KernelState != osKernelInactive)
+		return osError;
+
+	KernelState = osKernelReady;
+
+	return osOK;
+}
+
+osStatus_t osKernelGetInfo(osVersion_t *version, char *id_buf, uint32_t id_size)
+{
+	if (version) {
+		version->api = 20010003U;
+		version->kernel = 10002001U;
+	}
+
+	if (id_buf && id_size)
+		strlcpy(id_buf, "FreeRTOS " tskKERNEL_VERSION_NUMBER, id_size);
+
+	return osOK;
+}
+
+osKernelState_t osKernelGetState(void)
+{
+	switch (xTaskGetSchedulerState()) {
+	case taskSCHEDULER_RUNNING:
+		return osKernelRunning;
+	case taskSCHEDULER_SUSPENDED:
+		return osKernelLocked;
+	case taskSCHEDULER_NOT_STARTED:
+	default:
+		return KernelState == osKernelReady ? osKernelReady
+			: osKernelInactive;
+	}
+}
+
+osStatus_t osKernelStart(void)
+{
+	if (IS_IRQ())
+		return osErrorISR;
+
+	if (KernelState != osKernelReady)
+		return osError;
+
+	KernelState = osKernelRunning;
+	vTaskStartScheduler();
+
+	/* Only vTaskEndScheduler() brings us back here. */
+	return osOK;
+}
+
+int32_t osKernelLock(void)
+{
+	if (IS_IRQ())
+		return osErrorISR;
+
+	switch (xTaskGetSchedulerState()) {
+	case taskSCHEDULER_SUSPENDED:
+		return 1;
+	case taskSCHEDULER_RUNNING:
+		vTaskSuspendAll();
+		return 0;
+	default:
+		return osError;
+	}
+}
+
+int32_t osKernelUnlock(void)
+{
+	if (IS_IRQ())
+		return osErrorISR;
+
+	switch (xTaskGetSchedulerState()) {
+	case taskSCHEDULER_SUSPENDED:
+		if (xTaskResumeAll() != pdTRUE &&
+		    xTaskGetSchedulerState() == taskSCHEDULER_SUSPENDED)
+			return osError;
+		return 1;
+	case taskSCHEDULER_RUNNING:
+		return 0;
+	default:
+		return osError;
+	}
+}
+
+int32_t osKernelRestoreLock(int32_t lock)
+{
+	if (IS_IRQ())
+		return osErrorISR;
+
+	switch (xTaskGetSchedulerState()) {
+	case taskSCHEDULER_SUSPENDED:
+	case taskSCHEDULER_RUNNING:
+		if (lock == 1) {
+			vTaskSuspendAll();
+			return 1;
+		}
+		if (lock != 0)
+			return osError;
+		if (xTaskResumeAll() != pdTRUE &&
+		    xTaskGetSchedulerState() != taskSCHEDULER_RUNNING)
+			return osError;
+		return 0;
+	default:
+		return osError;
+	}
+}
+
+uint32_t osKernelSuspend(void)
+{
+	/* No tickless idle in the sandbox. */
+	return 0;
+}
+
+void osKernelResume(uint32_t sleep_ticks)
+{
+	(void)sleep_ticks;
+}
+
+uint32_t osKernelGetTickCount(void)
+{
+	return IS_IRQ() ? xTaskGetTickCountFromISR() : xTaskGetTickCount();
+}
+
+uint32_t osKernelGetTickFreq(void)
+{
+	return configTICK_RATE_HZ;
+}
+
+uint32_t osKernelGetSysTimerCount(void)
+{
+	return ktime();
+}
+
+uint32_t osKernelGetSysTimerFreq(void)
+{
+	return time_hz;
+}
+
+uint32_t osKernelGetFreeHeapSize(void)
+{
+	return xPortGetFreeHeapSize();
+}
+
+uint32_t osKernelGetMinEverFreeHeapSize(void)
+{
+	return xPortGetMinimumEverFreeHeapSize();
+}
+
+/*
+ * Scanning makes the WLAN stack allocate in bursts, so the low memory
+ * line goes up to the high threshold while any scan is going on.
+ */
+void osKernelUpdateStatus(uint32_t status)
+{
+	if (status & (OS_WIFI_MANUAL_SCANNING | OS_WIFI_CONNECT_SCANNNING))
+		g_os_low_memory_th = CONFIG_LOW_MEMORY_HIGH_THRESHOLD;
+	else
+		g_os_low_memory_th = CONFIG_LOW_MEMORY_LOW_THRESHOLD;
+}
+
+/* Threads */
+
+osThreadId_t osThreadNew(osThreadFunc_t func, void *argument,
+			 const osThreadAttr_t *attr)
+{
+	const char *name = NULL;
+	uint32_t stack = configMINIMAL_STACK_SIZE * sizeof(StackType_t);
+	UBaseType_t prio = to_rtos_prio(osPriorityNormal);
+	TaskHandle_t h = NULL;
+
+	if (IS_IRQ() || func == NULL)
+		return NULL;
+
+	if (attr) {
+		name = attr->name;
+		if (attr->priority != osPriorityNone) {
+			if (attr->priority < osPriorityIdle ||
+			    attr->priority > osPriorityISR)
+				return NULL;
+			prio = to_rtos_prio(attr->priority);
+		}
+		if (attr->stack_size)
+			stack = attr->stack_size;
+
+		if (attr->cb_mem && attr->cb_size >= sizeof(StaticTask_t) &&
+		    attr->stack_mem && attr->stack_size) {
+			return xTaskCreateStatic((TaskFunction_t)func, name,
+						 stack / sizeof(StackType_t),
+						 argument, prio,
+						 attr->stack_mem,
+						 attr->cb_mem);
+		}
+		if (attr->cb_mem || attr->stack_mem)
+			return NULL;
+	}
+
+	if (xTaskCreate((TaskFunction_t)func, name,
+			(uint16_t)(stack / sizeof(StackType_t)),
+			argument, prio, &h) != pdPASS)
+		return NULL;
+
+	return h;
+}
+
+const char *osThreadGetName(osThreadId_t thread_id)
+{
+	if (IS_IRQ() || thread_id == NULL)
+		return NULL;
+
+	return pcTaskGetName(thread_id);
+}
+
+osThreadId_t osThreadGetId(void)
+{
+	return xTaskGetCurrentTaskHandle();
+}
+
+osThreadState_t osThreadGetState(osThreadId_t thread_id)
+{
+	if (IS_IRQ() || thread_id == NULL)
+		return osThreadError;
+
+	switch (eTaskGetState(thread_id)) {
+	case eRunning:
+		return osThreadRunning;
+	case eReady:
+		return osThreadReady;
+	case eBlocked:
+	case eSuspended:
+		return osThreadBlocked;
+	case eDeleted:
+		return osThreadTerminated;
+	case eInvalid:
+	default:
+		return osThreadError;
+	}
+}
+
+uint32_t osThreadGetStackSize(osThreadId_t thread_id)
+{
+	TaskStatus_t info;
+
+	if (IS_IRQ() || thread_id == NULL)
+		return 0;
+
+	vTaskGetInfo(thread_id, &info, pdFALSE, eInvalid);
+
+	return info.pxEndOfStack ?
+		(uint32_t)((uint8_t *)info.pxEndOfStack -
+			   (uint8_t *)info.pxStackBase) : 0;
+}
+
+uint32_t osThreadGetStackSpace(osThreadId_t thread_id)
+{
+	if (IS_IRQ() || thread_id == NULL)
+		return 0;
+
+	return uxTaskGetStackHighWaterMark(thread_id) * sizeof(StackType_t);
+}
+
+osStatus_t osThreadSetPriority(osThreadId_t thread_id, osPriority_t priority)
+{
+	if (IS_IRQ())
+		return osErrorISR;
+
+	if (thread_id == NULL ||
+	    priority < osPriorityIdle || priority > osPriorityISR)
+		return osErrorParameter;
+
+	vTaskPrioritySet(thread_id, to_rtos_prio(priority));
+
+	return osOK;
+}
+
+osPriority_t osThreadGetPriority(osThreadId_t thread_id)
+{
+	if (IS_IRQ() || thread_id == NULL)
+		return osPriorityError;
+
+	return to_cmsis_prio(uxTaskPriorityGet(thread_id));
+}
+
+osStatus_t osThreadYield(void)
+{
+	if (IS_IRQ())
+		return osErrorISR;
+
+	taskYIELD();
+
+	return osOK;
+}
+
+osStatus_t osThreadSuspend(osThreadId_t thread_id)
+{
+	if (IS_IRQ())
+		return osErrorISR;
+
+	if (thread_id == NULL)
+		return osErrorParameter;
+
+	vTaskSuspend(thread_id);
+
+	return osOK;
+}
+
+osStatus_t osThreadResume(osThreadId_t thread_id)
+{
+	if (IS_IRQ())
+		return osErrorISR;
+
+	if (thread_id == NULL)
+		return osErrorParameter;
+
+	vTaskResume(thread_id);
+
+	return osOK;
+}
+
+osStatus_t osThreadDetach(osThreadId_t thread_id)
+{
+	(void)thread_id;
+
+	/* Every thread is detached already. */
+	return osOK;
+}
+
+osStatus_t osThreadJoin(osThreadId_t thread_id)
+{
+	(void)thread_id;
+
+	return osError;
+}
+
+__NO_RETURN void osThreadExit(void)
+{
+	vTaskDelete(NULL);
+	for (;;)
+		;
+}
+
+osStatus_t osThreadTerminate(osThreadId_t thread_id)
+{
+	eTaskState state;
+
+	if (IS_IRQ())
+		return osErrorISR;
+
+	if (thread_id == NULL)
+		return osErrorParameter;
+
+	state = eTaskGetState(thread_id);
+	if (state == eDeleted)
+		return osErrorResource;
+
+	vTaskDelete(thread_id);
+
+	return osOK;
+}
+
+uint32_t osThreadGetCount(void)
+{
+	return IS_IRQ() ? 0 : uxTaskGetNumberOfTasks();
+}
+
+uint32_t osThreadEnumerate(osThreadId_t *thread_array, uint32_t array_items)
+{
+	TaskStatus_t *task;
+	uint32_t i, count;
+
+	if (IS_IRQ() || thread_array == NULL || array_items == 0)
+		return 0;
+
+	vTaskSuspendAll();
+
+	count = uxTaskGetNumberOfTasks();
+	task = pvPortMalloc(count * sizeof(TaskStatus_t));
+	if (task) {
+		count = uxTaskGetSystemState(task, count, NULL);
+		for (i = 0; i < count && i < array_items; i++)
+			thread_array[i] = task[i].xHandle;
+		count = i;
+	} else {
+		count = 0;
+	}
+
+	(void)xTaskResumeAll();
+
+	vPortFree(task);
+
+	return count;
+}
+
+/* Thread flags, kept in the task notification value */
+
+uint32_t osThreadFlagsSet(osThreadId_t thread_id, uint32_t flags)
+{
+	BaseType_t yield = pdFALSE;
+	uint32_t rflags;
+
+	if (thread_id == NULL || (flags & THREAD_FLAGS_INVALID_BITS))
+		return osFlagsErrorParameter;
+
+	if (IS_IRQ()) {
+		(void)xTaskNotifyFromISR(thread_id, flags, eSetBits, &yield);
+		(void)xTaskNotifyAndQueryFromISR(thread_id, 0, eNoAction,
+						 &rflags, NULL);
+		portYIELD_FROM_ISR(yield);
+	} else {
+		(void)xTaskNotify(thread_id, flags, eSetBits);
+		(void)xTaskNotifyAndQuery(thread_id, 0, eNoAction, &rflags);
+	}
+
+	return rflags;
+}
+
+uint32_t osThreadFlagsClear(uint32_t flags)
+{
+	TaskHandle_t h = xTaskGetCurrentTaskHandle();
+	uint32_t rflags, cflags;
+
+	if (IS_IRQ())
+		return osFlagsErrorISR;
+
+	if (flags & THREAD_FLAGS_INVALID_BITS)
+		return osFlagsErrorParameter;
+
+	if (xTaskNotifyAndQuery(h, 0, eNoAction, &cflags) != pdPASS)
+		return osFlagsError;
+
+	rflags = cflags;
+	cflags &= ~flags;
+
+	if (xTaskNotify(h, cflags, eSetValueWithOverwrite) != pdPASS)
+		return osFlagsError;
+
+	return rflags;
+}
+
+uint32_t osThreadFlagsGet(void)
+{
+	uint32_t rflags;
+
+	if (IS_IRQ())
+		return osFlagsErrorISR;
+
+	if (xTaskNotifyAndQuery(xTaskGetCurrentTaskHandle(), 0, eNoAction,
+				&rflags) != pdPASS)
+		return osFlagsError;
+
+	return rflags;
+}
+
+uint32_t osThreadFlagsWait(uint32_t flags, uint32_t options, uint32_t timeout)
+{
+	uint32_t rflags = 0, nval, clear;
+	TickType_t t0, td, tout;
+	BaseType_t rval;
+
+	if (IS_IRQ())
+		return osFlagsErrorISR;
+
+	if (flags & THREAD_FLAGS_INVALID_BITS)
+		return osFlagsErrorParameter;
+
+	clear = (options & osFlagsNoClear) ? 0 : flags;
+	tout = timeout;
+	t0 = xTaskGetTickCount();
+
+	for (;;) {
+		rval = xTaskNotifyWait(0, clear, &nval, to_ticks(tout));
+		if (rval != pdPASS)
+			return tout ? osFlagsErrorTimeout : osFlagsErrorResource;
+
+		rflags &= flags;
+		rflags |= nval;
+
+		if (options & osFlagsWaitAll) {
+			if ((flags & rflags) == flags)
+				break;
+		} else if (flags & rflags) {
+			break;
+		}
+
+		if (timeout == osWaitForever)
+			continue;
+
+		td = xTaskGetTickCount() - t0;
+		if (td >= timeout)
+			return osFlagsErrorTimeout;
+		tout = timeout - td;
+	}
+
+	return rflags;
+}
+
+/* Generic wait */
+
+osStatus_t osDelay(uint32_t ticks)
+{
+	if (IS_IRQ())
+		return osErrorISR;
+
+	if (ticks)
+		vTaskDelay(ticks);
+
+	return osOK;
+}
+
+osStatus_t osDelayUntil(uint32_t ticks)
+{
+	TickType_t tcnt, delay;
+
+	if (IS_IRQ())
+		return osErrorISR;
+
+	tcnt = xTaskGetTickCount();
+	delay = (TickType_t)ticks - tcnt;
+
+	/* Already in the past, or too far ahead to tell. */
+	if (delay == 0 || (delay >> (sizeof(TickType_t) * 8 - 1)))
+		return osErrorParameter;
+
+	vTaskDelayUntil(&tcnt, delay);
+
+	return osOK;
+}
+
+/* Timers */
+
+struct os_timer_cb {
+	osTimerFunc_t func;
+	void *arg;
+};
+
+static void os_timer_callback(TimerHandle_t h)
+{
+	struct os_timer_cb *cb = pvTimerGetTimerID(h);
+
+	if (cb)
+		cb->func(cb->arg);
+}
+
+osTimerId_t osTimerNew(osTimerFunc_t func, osTimerType_t type, void *argument,
+		       const osTimerAttr_t *attr)
+{
+	struct os_timer_cb *cb;
+	TimerHandle_t h;
+
+	if (IS_IRQ() || func == NULL)
+		return NULL;
+
+	cb = pvPortMalloc(sizeof(*cb));
+	if (cb == NULL)
+		return NULL;
+
+	cb->func = func;
+	cb->arg = argument;
+
+	if (attr && attr->cb_mem && attr->cb_size >= sizeof(StaticTimer_t))
+		h = xTimerCreateStatic(attr->name, 1,
+				       type == osTimerPeriodic ? pdTRUE : pdFALSE,
+				       cb, os_timer_callback, attr->cb_mem);
+	else
+		h = xTimerCreate(attr ? attr->name : NULL, 1,
+				 type == osTimerPeriodic ? pdTRUE : pdFALSE,
+				 cb, os_timer_callback);
+
+	if (h == NULL)
+		vPortFree(cb);
+
+	return h;
+}
+
+const char *osTimerGetName(osTimerId_t timer_id)
+{
+	if (IS_IRQ() || timer_id == NULL)
+		return NULL;
+
+	return pcTimerGetName(timer_id);
+}
+
+osStatus_t osTimerStart(osTimerId_t timer_id, uint32_t ticks)
+{
+	if (IS_IRQ())
+		return osErrorISR;
+
+	if (timer_id == NULL || ticks == 0)
+		return osErrorParameter;
+
+	if (xTimerChangePeriod(timer_id, ticks, portMAX_DELAY) != pdPASS)
+		return osErrorResource;
+
+	return osOK;
+}
+
+osStatus_t osTimerStop(osTimerId_t timer_id)
+{
+	if (IS_IRQ())
+		return osErrorISR;
+
+	if (timer_id == NULL)
+		return osErrorParameter;
+
+	if (xTimerIsTimerActive(timer_id) == pdFALSE)
+		return osErrorResource;
+
+	if (xTimerStop(timer_id, portMAX_DELAY) != pdPASS)
+		return osError;
+
+	return osOK;
+}
+
+uint32_t osTimerIsRunning(osTimerId_t timer_id)
+{
+	if (IS_IRQ() || timer_id == NULL)
+		return 0;
+
+	return xTimerIsTimerActive(timer_id) == pdTRUE;
+}
+
+osStatus_t osTimerDelete(osTimerId_t timer_id)
+{
+	struct os_timer_cb *cb;
+
+	if (IS_IRQ())
+		return osErrorISR;
+
+	if (timer_id == NULL)
+		return osErrorParameter;
+
+	cb = pvTimerGetTimerID(timer_id);
+
+	if (xTimerDelete(timer_id, portMAX_DELAY) != pdPASS)
+		return osErrorResource;
+
+	vPortFree(cb);
+
+	return osOK;
+}
+
+/* Event flags */
+
+osEventFlagsId_t osEventFlagsNew(const osEventFlagsAttr_t *attr)
+{
+	if (IS_IRQ())
+		return NULL;
+
+	if (attr && attr->cb_mem && attr->cb_size >= sizeof(StaticEventGroup_t))
+		return xEventGroupCreateStatic(attr->cb_mem);
+
+	return xEventGroupCreate();
+}
+
+const char *osEventFlagsGetName(osEventFlagsId_t ef_id)
+{
+	(void)ef_id;
+
+	return NULL;
+}
+
+uint32_t osEventFlagsSet(osEventFlagsId_t ef_id, uint32_t flags)
+{
+	BaseType_t yield = pdFALSE;
+
+	if (ef_id == NULL || (flags & EVENT_FLAGS_INVALID_BITS))
+		return osFlagsErrorParameter;
+
+	if (IS_IRQ()) {
+		if (xEventGroupSetBitsFromISR(ef_id, flags, &yield) != pdPASS)
+			return osFlagsErrorResource;
+		portYIELD_FROM_ISR(yield);
+		return flags;
+	}
+
+	return xEventGroupSetBits(ef_id, flags);
+}
+
+uint32_t osEventFlagsClear(osEventFlagsId_t ef_id, uint32_t flags)
+{
+	uint32_t rflags;
+
+	if (ef_id == NULL || (flags & EVENT_FLAGS_INVALID_BITS))
+		return osFlagsErrorParameter;
+
+	if (IS_IRQ()) {
+		rflags = xEventGroupGetBitsFromISR(ef_id);
+		if (xEventGroupClearBitsFromISR(ef_id, flags) != pdPASS)
+			return osFlagsErrorResource;
+		return rflags;
+	}
+
+	return xEventGroupClearBits(ef_id, flags);
+}
+
+uint32_t osEventFlagsGet(osEventFlagsId_t ef_id)
+{
+	if (ef_id == NULL)
+		return 0;
+
+	return IS_IRQ() ? xEventGroupGetBitsFromISR(ef_id)
+		: xEventGroupGetBits(ef_id);
+}
+
+uint32_t osEventFlagsWait(osEventFlagsId_t ef_id, uint32_t flags,
+			  uint32_t options, uint32_t timeout)
+{
+	BaseType_t all, clear;
+	uint32_t rflags;
+
+	if (IS_IRQ())
+		return osFlagsErrorISR;
+
+	if (ef_id == NULL || (flags & EVENT_FLAGS_INVALID_BITS))
+		return osFlagsErrorParameter;
+
+	all = (options & osFlagsWaitAll) ? pdTRUE : pdFALSE;
+	clear = (options & osFlagsNoClear) ? pdFALSE : pdTRUE;
+
+	rflags = xEventGroupWaitBits(ef_id, flags, clear, all, to_ticks(timeout));
+
+	if (all == pdTRUE ? (flags & rflags) != flags : !(flags & rflags))
+		return timeout ? osFlagsErrorTimeout : osFlagsErrorResource;
+
+	return rflags;
+}
+
+osStatus_t osEventFlagsDelete(osEventFlagsId_t ef_id)
+{
+	if (IS_IRQ())
+		return osErrorISR;
+
+	if (ef_id == NULL)
+		return osErrorParameter;
+
+	vEventGroupDelete(ef_id);
+
+	return osOK;
+}
+
+/*
+ * Mutexes. The low bit of the handle tells a recursive one apart;
+ * every FreeRTOS object is at least pointer aligned.
+ */
+
+#define MUTEX_RECURSIVE		1U
+
+static SemaphoreHandle_t mutex_handle(osMutexId_t mutex_id)
+{
+	return (SemaphoreHandle_t)((uintptr_t)mutex_id & ~(uintptr_t)MUTEX_RECURSIVE);
+}
+
+static bool mutex_recursive(osMutexId_t mutex_id)
+{
+	return (uintptr_t)mutex_id & MUTEX_RECURSIVE;
+}
+
+osMutexId_t osMutexNew(const osMutexAttr_t *attr)
+{
+	bool rmtx = attr && (attr->attr_bits & osMutexRecursive);
+	SemaphoreHandle_t h;
+
+	if (IS_IRQ())
+		return NULL;
+
+	if (attr && (attr->attr_bits & osMutexRobust))
+		return NULL;
+
+	if (attr && attr->cb_mem && attr->cb_size >= sizeof(StaticQueue_t))
+		h = rmtx ? xSemaphoreCreateRecursiveMutexStatic(attr->cb_mem)
+			: xSemaphoreCreateMutexStatic(attr->cb_mem);
+	else
+		h = rmtx ? xSemaphoreCreateRecursiveMutex()
+			: xSemaphoreCreateMutex();
+
+	if (h == NULL)
+		return NULL;
+
+	return (osMutexId_t)((uintptr_t)h | (rmtx ? MUTEX_RECURSIVE : 0));
+}
+
+const char *osMutexGetName(osMutexId_t mutex_id)
+{
+	(void)mutex_id;
+
+	return NULL;
+}
+
+osStatus_t osMutexAcquire(osMutexId_t mutex_id, uint32_t timeout)
+{
+	SemaphoreHandle_t h = mutex_handle(mutex_id);
+	BaseType_t ret;
+
+	if (IS_IRQ())
+		return osErrorISR;
+
+	if (h == NULL)
+		return osErrorParameter;
+
+	if (mutex_recursive(mutex_id))
+		ret = xSemaphoreTakeRecursive(h, to_ticks(timeout));
+	else
+		ret = xSemaphoreTake(h, to_ticks(timeout));
+
+	if (ret != pdPASS)
+		return timeout ? osErrorTimeout : osErrorResource;
+
+	return osOK;
+}
+
+osStatus_t osMutexRelease(osMutexId_t mutex_id)
+{
+	SemaphoreHandle_t h = mutex_handle(mutex_id);
+	BaseType_t ret;
+
+	if (IS_IRQ())
+		return osErrorISR;
+
+	if (h == NULL)
+		return osErrorParameter;
+
+	if (mutex_recursive(mutex_id))
+		ret = xSemaphoreGiveRecursive(h);
+	else
+		ret = xSemaphoreGive(h);
+
+	return ret == pdPASS ? osOK : osErrorResource;
+}
+
+osThreadId_t osMutexGetOwner(osMutexId_t mutex_id)
+{
+	SemaphoreHandle_t h = mutex_handle(mutex_id);
+
+	if (IS_IRQ() || h == NULL)
+		return NULL;
+
+	return xSemaphoreGetMutexHolder(h);
+}
+
+osStatus_t osMutexDelete(osMutexId_t mutex_id)
+{
+	SemaphoreHandle_t h = mutex_handle(mutex_id);
+
+	if (IS_IRQ())
+		return osErrorISR;
+
+	if (h == NULL)
+		return osErrorParameter;
+
+	vSemaphoreDelete(h);
+
+	return osOK;
+}
+
+/* Semaphores */
+
+osSemaphoreId_t osSemaphoreNew(uint32_t max_count, uint32_t initial_count,
+			       const osSemaphoreAttr_t *attr)
+{
+	bool stat = attr && attr->cb_mem && attr->cb_size >= sizeof(StaticQueue_t);
+	SemaphoreHandle_t h;
+
+	if (IS_IRQ() || max_count == 0 || initial_count > max_count)
+		return NULL;
+
+	if (max_count == 1) {
+		h = stat ? xSemaphoreCreateBinaryStatic(attr->cb_mem)
+			: xSemaphoreCreateBinary();
+		if (h && initial_count)
+			xSemaphoreGive(h);
+	} else {
+		h = stat ? xSemaphoreCreateCountingStatic(max_count,
+							  initial_count,
+							  attr->cb_mem)
+			: xSemaphoreCreateCounting(max_count, initial_count);
+	}
+
+	return h;
+}
+
+const char *osSemaphoreGetName(osSemaphoreId_t semaphore_id)
+{
+	(void)semaphore_id;
+
+	return NULL;
+}
+
+osStatus_t osSemaphoreAcquire(osSemaphoreId_t semaphore_id, uint32_t timeout)
+{
+	BaseType_t yield = pdFALSE;
+
+	if (semaphore_id == NULL)
+		return osErrorParameter;
+
+	if (IS_IRQ()) {
+		if (timeout)
+			return osErrorParameter;
+		if (xSemaphoreTakeFromISR(semaphore_id, &yield) != pdPASS)
+			return osErrorResource;
+		portYIELD_FROM_ISR(yield);
+		return osOK;
+	}
+
+	if (xSemaphoreTake(semaphore_id, to_ticks(timeout)) != pdPASS)
+		return timeout ? osErrorTimeout : osErrorResource;
+
+	return osOK;
+}
+
+osStatus_t osSemaphoreRelease(osSemaphoreId_t semaphore_id)
+{
+	BaseType_t yield = pdFALSE;
+
+	if (semaphore_id == NULL)
+		return osErrorParameter;
+
+	if (IS_IRQ()) {
+		if (xSemaphoreGiveFromISR(semaphore_id, &yield) != pdTRUE)
+			return osErrorResource;
+		portYIELD_FROM_ISR(yield);
+		return osOK;
+	}
+
+	return xSemaphoreGive(semaphore_id) == pdPASS ? osOK : osErrorResource;
+}
+
+/* Works on message queues as well, which vfs poll relies on. */
+uint32_t osSemaphoreGetCount(osSemaphoreId_t semaphore_id)
+{
+	if (semaphore_id == NULL)
+		return 0;
+
+	return IS_IRQ() ? uxQueueMessagesWaitingFromISR(semaphore_id)
+		: uxQueueMessagesWaiting(semaphore_id);
+}
+
+osStatus_t osSemaphoreDelete(osSemaphoreId_t semaphore_id)
+{
+	if (IS_IRQ())
+		return osErrorISR;
+
+	if (semaphore_id == NULL)
+		return osErrorParameter;
+
+	vSemaphoreDelete(semaphore_id);
+
+	return osOK;
+}
+
+/* Message queues */
+
+osMessageQueueId_t osMessageQueueNew(uint32_t msg_count, uint32_t msg_size,
+				     const osMessageQueueAttr_t *attr)
+{
+	if (IS_IRQ() || msg_count == 0 || msg_size == 0)
+		return NULL;
+
+	if (attr && attr->cb_mem && attr->cb_size >= sizeof(StaticQueue_t) &&
+	    attr->mq_mem && attr->mq_size >= msg_count * msg_size)
+		return xQueueCreateStatic(msg_count, msg_size, attr->mq_mem,
+					  attr->cb_mem);
+
+	if (attr && (attr->cb_mem || attr->mq_mem))
+		return NULL;
+
+	return xQueueCreate(msg_count, msg_size);
+}
+
+const char *osMessageQueueGetName(osMessageQueueId_t mq_id)
+{
+	(void)mq_id;
+
+	return NULL;
+}
+
+osStatus_t osMessageQueuePut(osMessageQueueId_t mq_id, const void *msg_ptr,
+			     uint8_t msg_prio, uint32_t timeout)
+{
+	BaseType_t yield = pdFALSE;
+
+	(void)msg_prio;
+
+	if (mq_id == NULL || msg_ptr == NULL)
+		return osErrorParameter;
+
+	if (IS_IRQ()) {
+		if (timeout)
+			return osErrorParameter;
+		if (xQueueSendToBackFromISR(mq_id, msg_ptr, &yield) != pdTRUE)
+			return osErrorResource;
+		portYIELD_FROM_ISR(yield);
+		return osOK;
+	}
+
+	if (xQueueSendToBack(mq_id, msg_ptr, to_ticks(timeout)) != pdPASS)
+		return timeout ? osErrorTimeout : osErrorResource;
+
+	return osOK;
+}
+
+osStatus_t osMessageQueueGet(osMessageQueueId_t mq_id, void *msg_ptr,
+			     uint8_t *msg_prio, uint32_t timeout)
+{
+	BaseType_t yield = pdFALSE;
+
+	(void)msg_prio;
+
+	if (mq_id == NULL || msg_ptr == NULL)
+		return osErrorParameter;
+
+	if (IS_IRQ()) {
+		if (timeout)
+			return osErrorParameter;
+		if (xQueueReceiveFromISR(mq_id, msg_ptr, &yield) != pdPASS)
+			return osErrorResource;
+		portYIELD_FROM_ISR(yield);
+		return osOK;
+	}
+
+	if (xQueueReceive(mq_id, msg_ptr, to_ticks(timeout)) != pdPASS)
+		return timeout ? osErrorTimeout : osErrorResource;
+
+	return osOK;
+}
+
+uint32_t osMessageQueueGetCapacity(osMessageQueueId_t mq_id)
+{
+	StaticQueue_t *mq = mq_id;
+
+	return mq ? mq->uxDummy4[1] : 0;
+}
+
+uint32_t osMessageQueueGetMsgSize(osMessageQueueId_t mq_id)
+{
+	StaticQueue_t *mq = mq_id;
+
+	return mq ? mq->uxDummy4[2] : 0;
+}
+
+uint32_t osMessageQueueGetCount(osMessageQueueId_t mq_id)
+{
+	return osSemaphoreGetCount(mq_id);
+}
+
+uint32_t osMessageQueueGetSpace(osMessageQueueId_t mq_id)
+{
+	if (mq_id == NULL)
+		return 0;
+
+	return IS_IRQ() ? uxQueueSpacesAvailableFromISR(mq_id)
+		: uxQueueSpacesAvailable(mq_id);
+}
+
+osStatus_t osMessageQueueReset(osMessageQueueId_t mq_id)
+{
+	if (IS_IRQ())
+		return osErrorISR;
+
+	if (mq_id == NULL)
+		return osErrorParameter;
+
+	(void)xQueueReset(mq_id);
+
+	return osOK;
+}
+
+osStatus_t osMessageQueueDelete(osMessageQueueId_t mq_id)
+{
+	if (IS_IRQ())
+		return osErrorISR;
+
+	if (mq_id == NULL)
+		return osErrorParameter;
+
+	vQueueDelete(mq_id);
+
+	return osOK;
+}
+
+uint32_t osMessageQueueGetNumberOfTasksWaitingToReceive(osMessageQueueId_t mq_id)
+{
+	if (mq_id == NULL)
+		return 0;
+
+	return IS_IRQ() ? uxQueueGetNumberOfTasksWaitingToReceiveFromISR(mq_id)
+		: uxQueueGetNumberOfTasksWaitingToReceive(mq_id);
+}
+
+/*
+ * Memory pools: a fixed array of blocks, a free list through them
+ * and a counting semaphore for the free ones.
+ */
+
+struct os_mempool {
+	const char *name;
+	SemaphoreHandle_t sem;
+	uint32_t bl_cnt;
+	uint32_t bl_sz;
+	uint8_t *mem;
+	void *free;
+};
+
+osMemoryPoolId_t osMemoryPoolNew(uint32_t block_count, uint32_t block_size,
+				 const osMemoryPoolAttr_t *attr)
+{
+	struct os_mempool *mp;
+	uint32_t i;
+
+	if (IS_IRQ() || block_count == 0 || block_size == 0)
+		return NULL;
+
+	block_size = (block_size + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+
+	mp = pvPortMalloc(sizeof(*mp) + block_count * block_size);
+	if (mp == NULL)
+		return NULL;
+
+	mp->sem = xSemaphoreCreateCounting(block_count, block_count);
+	if (mp->sem == NULL) {
+		vPortFree(mp);
+		return NULL;
+	}
+
+	mp->name = attr ? attr->name : NULL;
+	mp->bl_cnt = block_count;
+	mp->bl_sz = block_size;
+	mp->mem = (uint8_t *)(mp + 1);
+	mp->free = NULL;
+	for (i = block_count; i > 0; i--) {
+		void **bl = (void **)(mp->mem + (i - 1) * block_size);
+
+		*bl = mp->free;
+		mp->free = bl;
+	}
+
+	return mp;
+}
+
+const char *osMemoryPoolGetName(osMemoryPoolId_t mp_id)
+{
+	struct os_mempool *mp = mp_id;
+
+	return mp ? mp->name : NULL;
+}
+
+void *osMemoryPoolAlloc(osMemoryPoolId_t mp_id, uint32_t timeout)
+{
+	struct os_mempool *mp = mp_id;
+	void **bl;
+	uint32_t mask;
+
+	if (mp == NULL || (IS_IRQ() && timeout))
+		return NULL;
+
+	if (osSemaphoreAcquire(mp->sem, timeout) != osOK)
+		return NULL;
+
+	mask = osCriticalSectionEnter();
+	bl = mp->free;
+	mp->free = *bl;
+	osCriticalSectionExit(mask);
+
+	return bl;
+}
+
+osStatus_t osMemoryPoolFree(osMemoryPoolId_t mp_id, void *block)
+{
+	struct os_mempool *mp = mp_id;
+	uint8_t *p = block;
+	uint32_t mask;
+
+	if (mp == NULL || p < mp->mem || p >= mp->mem + mp->bl_cnt * mp->bl_sz ||
+	    (p - mp->mem) % mp->bl_sz)
+		return osErrorParameter;
+
+	mask = osCriticalSectionEnter();
+	*(void **)block = mp->free;
+	mp->free = block;
+	osCriticalSectionExit(mask);
+
+	return osSemaphoreRelease(mp->sem);
+}
+
+uint32_t osMemoryPoolGetCapacity(osMemoryPoolId_t mp_id)
+{
+	struct os_mempool *mp = mp_id;
+
+	return mp ? mp->bl_cnt : 0;
+}
+
+uint32_t osMemoryPoolGetBlockSize(osMemoryPoolId_t mp_id)
+{
+	struct os_mempool *mp = mp_id;
+
+	return mp ? mp->bl_sz : 0;
+}
+
+uint32_t osMemoryPoolGetCount(osMemoryPoolId_t mp_id)
+{
+	struct os_mempool *mp = mp_id;
+
+	return mp ? mp->bl_cnt - osSemaphoreGetCount(mp->sem) : 0;
+}
+
+uint32_t osMemoryPoolGetSpace(osMemoryPoolId_t mp_id)
+{
+	struct os_mempool *mp = mp_id;
+
+	return mp ? osSemaphoreGetCount(mp->sem) : 0;
+}
+
+osStatus_t osMemoryPoolDelete(osMemoryPoolId_t mp_id)
+{
+	struct os_mempool *mp = mp_id;
+
+	if (IS_IRQ())
+		return osErrorISR;
+
+	if (mp == NULL)
+		return osErrorParameter;
+
+	vSemaphoreDelete(mp->sem);
+	vPortFree(mp);
+
+	return osOK;
+}
+
+/* Critical sections */
+
+uint32_t osCriticalSectionEnter(void)
+{
+	if (IS_IRQ())
+		return taskENTER_CRITICAL_FROM_ISR();
+
+	taskENTER_CRITICAL();
+
+	return 0;
+}
+
+void osCriticalSectionExit(uint32_t mask)
+{
+	if (IS_IRQ())
+		taskEXIT_CRITICAL_FROM_ISR(mask);
+	else
+		taskEXIT_CRITICAL();
+}
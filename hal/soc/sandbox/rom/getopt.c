@@ -0,0 +1,221 @@
+/*
+ * Copyright 2024-2024 Senscomm Semiconductor Co., Ltd.	All rights reserved.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Sandbox <getopt.h>. The tree calls getopt() and friends through the
+ * ROM function pointers, which would otherwise bind to the host libc
+ * functions themselves.
+ *
+ * No argument permutation: scanning stops at the first non-option.
+ * Setting optind to 0 starts over, as CLI commands do on every run.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <getopt.h>
+
+#include <hal/compiler.h>
+
+char *optarg;
+int optind = 1;
+int opterr = 1;
+int optopt = '?';
+
+static char *nextchar;
+
+static int getopt_short(int argc, char *const argv[], const char *optstring)
+{
+	const char *spec;
+	int c = *nextchar++;
+
+	spec = c == ':' ? NULL : strchr(optstring, c);
+	if (spec == NULL) {
+		optopt = c;
+		if (opterr && *optstring != ':')
+			fprintf(stderr, "%s: invalid option -- '%c'\n", argv[0], c);
+		if (*nextchar == '\0') {
+			optind++;
+			nextchar = NULL;
+		}
+		return '?';
+	}
+
+	if (spec[1] != ':') {
+		if (*nextchar == '\0') {
+			optind++;
+			nextchar = NULL;
+		}
+		return c;
+	}
+
+	/* Takes an argument, in this word or the next one. */
+	if (*nextchar != '\0') {
+		optarg = nextchar;
+		optind++;
+	} else if (spec[2] == ':') {
+		optarg = NULL;
+		optind++;
+	} else if (optind + 1 < argc) {
+		optarg = argv[optind + 1];
+		optind += 2;
+	} else {
+		optopt = c;
+		optind++;
+		nextchar = NULL;
+		if (*optstring == ':')
+			return ':';
+		if (opterr)
+			fprintf(stderr, "%s: option requires an argument -- '%c'\n",
+				argv[0], c);
+		return '?';
+	}
+	nextchar = NULL;
+
+	return c;
+}
+
+static int getopt_long_option(int argc, char *const argv[],
+			      const char *optstring,
+			      const struct option *longopts, int *longindex)
+{
+	const struct option *o, *match = NULL;
+	char *name = nextchar, *eq;
+	size_t len;
+	int ambiguous = 0;
+
+	eq = strchr(name, '=');
+	len = eq ? (size_t)(eq - name) : strlen(name);
+
+	for (o = longopts; o->name; o++) {
+		if (strncmp(o->name, name, len))
+			continue;
+		if (strlen(o->name) == len) {
+			match = o;
+			ambiguous = 0;
+			break;
+		}
+		if (match)
+			ambiguous = 1;
+		else
+			match = o;
+	}
+
+	optind++;
+	nextchar = NULL;
+
+	if (match == NULL || ambiguous) {
+		optopt = 0;
+		if (opterr && *optstring != ':')
+			fprintf(stderr, "%s: %s option '--%.*s'\n", argv[0],
+				ambiguous ? "ambiguous" : "unrecognized",
+				(int)len, name);
+		return '?';
+	}
+
+	optarg = NULL;
+	if (eq) {
+		if (match->has_arg == no_argument) {
+			optopt = match->val;
+			if (opterr && *optstring != ':')
+				fprintf(stderr, "%s: option '--%s' doesn't allow an argument\n",
+					argv[0], match->name);
+			return '?';
+		}
+		optarg = eq + 1;
+	} else if (match->has_arg == required_argument) {
+		if (optind >= argc) {
+			optopt = match->val;
+			if (*optstring == ':')
+				return ':';
+			if (opterr)
+				fprintf(stderr, "%s: option '--%s' requires an argument\n",
+					argv[0], match->name);
+			return '?';
+		}
+		optarg = argv[optind++];
+	}
+
+	if (longindex)
+		*longindex = match - longopts;
+	if (match->flag) {
+		*match->flag = match->val;
+		return 0;
+	}
+
+	return match->val;
+}
+
+static int getopt_scan(int argc, char *const argv[], const char *optstring,
+		       const struct option *longopts, int *longindex,
+		       int long_only)
+{
+	char *arg;
+
+	optarg = NULL;
+
+	if (optind == 0) {
+		optind = 1;
+		nextchar = NULL;
+	}
+
+	if (*optstring == '+' || *optstring == '-')
+		optstring++;
+
+	if (nextchar == NULL || *nextchar == '\0') {
+		if (optind >= argc)
+			return -1;
+		arg = argv[optind];
+		if (arg[0] != '-' || arg[1] == '\0')
+			return -1;
+		if (!strcmp(arg, "--")) {
+			optind++;
+			return -1;
+		}
+		if (longopts && arg[1] == '-') {
+			nextchar = arg + 2;
+			return getopt_long_option(argc, argv, optstring,
+						  longopts, longindex);
+		}
+		nextchar = arg + 1;
+		if (long_only && longopts &&
+		    (arg[2] != '\0' || !strchr(optstring, arg[1])))
+			return getopt_long_option(argc, argv, optstring,
+						  longopts, longindex);
+	}
+
+	return getopt_short(argc, argv, optstring);
+}
+
+int _getopt(int argc, char *const argv[], const char *optstring)
+{
+	return getopt_scan(argc, argv, optstring, NULL, NULL, 0);
+}
+
+__func_tab__ int (*getopt)(int argc, char *const argv[], const char *optstring) = _getopt;
+
+int _getopt_long(int argc, char *const argv[], const char *shortopts,
+		 const struct option *longopts, int *longind)
+{
+	return getopt_scan(argc, argv, shortopts, longopts, longind, 0);
+}
+
+__func_tab__ int (*getopt_long)(int argc, char *const argv[], const char *shortopts,
+		const struct option *longopts, int *longind) = _getopt_long;
+
+int _getopt_long_only(int argc, char *const argv[], const char *shortopts,
+		      const struct option *longopts, int *longind)
+{
+	return getopt_scan(argc, argv, shortopts, longopts, longind, 1);
+}
+
+__func_tab__ int (*getopt_long_only)(int argc, char *const argv[], const char *shortopts,
+		const struct option *longopts, int *longind) = _getopt_long_only;
@@ -0,0 +1,331 @@
+/*
+ * Copyright 2024-2024 Senscomm Semiconductor Co., Ltd.	All rights reserved.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Sandbox FreeRTOS kernel: heap_5 style allocator over the regions
+ * soc.c hands to vPortDefineHeapRegions(), and the os_*alloc()
+ * wrappers over it.
+ *
+ * Keeping the heap inside the firmware, rather than passing through
+ * to the host malloc(), keeps the free/min-ever numbers, and so the
+ * low memory paths, the way they are on the target.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include <hal/compiler.h>
+
+#define heapMINIMUM_BLOCK_SIZE	( ( size_t ) ( xHeapStructSize << 1 ) )
+#define heapBITS_PER_BYTE	( ( size_t ) 8 )
+
+typedef struct A_BLOCK_LINK
+{
+	struct A_BLOCK_LINK *pxNextFreeBlock;
+	size_t xBlockSize;
+} BlockLink_t;
+
+static const size_t xHeapStructSize = ( sizeof( BlockLink_t ) + ( ( size_t ) ( portBYTE_ALIGNMENT - 1 ) ) ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK );
+
+static BlockLink_t xStart, *pxEnd = NULL;
+
+static size_t xFreeBytesRemaining = 0U;
+static size_t xMinimumEverFreeBytesRemaining = 0U;
+
+/* The top bit of xBlockSize marks a block as allocated. */
+static size_t xBlockAllocatedBit = 0;
+
+static void prvInsertBlockIntoFreeList( BlockLink_t *pxBlockToInsert )
+{
+	BlockLink_t *pxIterator;
+	uint8_t *puc;
+
+	for( pxIterator = &xStart; pxIterator->pxNextFreeBlock < pxBlockToInsert; pxIterator = pxIterator->pxNextFreeBlock )
+	{
+	}
+
+	/* Merge with the block before, then with the one after. */
+	puc = ( uint8_t * ) pxIterator;
+	if( ( puc + pxIterator->xBlockSize ) == ( uint8_t * ) pxBlockToInsert )
+	{
+		pxIterator->xBlockSize += pxBlockToInsert->xBlockSize;
+		pxBlockToInsert = pxIterator;
+	}
+
+	puc = ( uint8_t * ) pxBlockToInsert;
+	if( ( puc + pxBlockToInsert->xBlockSize ) == ( uint8_t * ) pxIterator->pxNextFreeBlock )
+	{
+		if( pxIterator->pxNextFreeBlock != pxEnd )
+		{
+			pxBlockToInsert->xBlockSize += pxIterator->pxNextFreeBlock->xBlockSize;
+			pxBlockToInsert->pxNextFreeBlock = pxIterator->pxNextFreeBlock->pxNextFreeBlock;
+		}
+		else
+		{
+			pxBlockToInsert->pxNextFreeBlock = pxEnd;
+		}
+	}
+	else
+	{
+		pxBlockToInsert->pxNextFreeBlock = pxIterator->pxNextFreeBlock;
+	}
+
+	if( pxIterator != pxBlockToInsert )
+	{
+		pxIterator->pxNextFreeBlock = pxBlockToInsert;
+	}
+}
+
+void *_pvPortMalloc( size_t xWantedSize )
+{
+	BlockLink_t *pxBlock, *pxPreviousBlock, *pxNewBlockLink;
+	void *pvReturn = NULL;
+
+	/* vPortDefineHeapRegions() has to come first. */
+	configASSERT( pxEnd );
+
+	vTaskSuspendAll();
+	{
+		if( ( xWantedSize & xBlockAllocatedBit ) == 0 && xWantedSize > 0 )
+		{
+			xWantedSize += xHeapStructSize;
+
+			if( ( xWantedSize & portBYTE_ALIGNMENT_MASK ) != 0x00 )
+			{
+				xWantedSize += ( portBYTE_ALIGNMENT - ( xWantedSize & portBYTE_ALIGNMENT_MASK ) );
+			}
+
+			if( xWantedSize <= xFreeBytesRemaining )
+			{
+				pxPreviousBlock = &xStart;
+				pxBlock = xStart.pxNextFreeBlock;
+				while( ( pxBlock->xBlockSize < xWantedSize ) && ( pxBlock->pxNextFreeBlock != NULL ) )
+				{
+					pxPreviousBlock = pxBlock;
+					pxBlock = pxBlock->pxNextFreeBlock;
+				}
+
+				if( pxBlock != pxEnd )
+				{
+					pvReturn = ( void * ) ( ( ( uint8_t * ) pxPreviousBlock->pxNextFreeBlock ) + xHeapStructSize );
+					pxPreviousBlock->pxNextFreeBlock = pxBlock->pxNextFreeBlock;
+
+					/* Split what is too big, and keep the rest free. */
+					if( ( pxBlock->xBlockSize - xWantedSize ) > heapMINIMUM_BLOCK_SIZE )
+					{
+						pxNewBlockLink = ( void * ) ( ( ( uint8_t * ) pxBlock ) + xWantedSize );
+						pxNewBlockLink->xBlockSize = pxBlock->xBlockSize - xWantedSize;
+						pxBlock->xBlockSize = xWantedSize;
+						prvInsertBlockIntoFreeList( pxNewBlockLink );
+					}
+
+					xFreeBytesRemaining -= pxBlock->xBlockSize;
+					if( xFreeBytesRemaining < xMinimumEverFreeBytesRemaining )
+					{
+						xMinimumEverFreeBytesRemaining = xFreeBytesRemaining;
+					}
+
+					pxBlock->xBlockSize |= xBlockAllocatedBit;
+					pxBlock->pxNextFreeBlock = NULL;
+				}
+			}
+		}
+	}
+	( void ) xTaskResumeAll();
+
+	return pvReturn;
+}
+
+__func_tab__ void *(*pvPortMalloc)( size_t xWantedSize ) = _pvPortMalloc;
+
+void _vPortFree( void *pv )
+{
+	uint8_t *puc = ( uint8_t * ) pv;
+	BlockLink_t *pxLink;
+
+	if( pv == NULL )
+	{
+		return;
+	}
+
+	puc -= xHeapStructSize;
+	pxLink = ( void * ) puc;
+
+	configASSERT( ( pxLink->xBlockSize & xBlockAllocatedBit ) != 0 );
+	configASSERT( pxLink->pxNextFreeBlock == NULL );
+
+	if( ( pxLink->xBlockSize & xBlockAllocatedBit ) != 0 && pxLink->pxNextFreeBlock == NULL )
+	{
+		pxLink->xBlockSize &= ~xBlockAllocatedBit;
+
+		vTaskSuspendAll();
+		{
+			xFreeBytesRemaining += pxLink->xBlockSize;
+			prvInsertBlockIntoFreeList( ( ( BlockLink_t * ) pxLink ) );
+		}
+		( void ) xTaskResumeAll();
+	}
+}
+
+__func_tab__ void (*vPortFree)( void *pv ) = _vPortFree;
+
+size_t xPortGetFreeHeapSize( void )
+{
+	return xFreeBytesRemaining;
+}
+
+size_t xPortGetMinimumEverFreeHeapSize( void )
+{
+	return xMinimumEverFreeBytesRemaining;
+}
+
+void vPortInitialiseBlocks( void )
+{
+}
+
+void _vPortDefineHeapRegions( const HeapRegion_t * const pxHeapRegions )
+{
+	BlockLink_t *pxFirstFreeBlockInRegion = NULL, *pxPreviousFreeBlock;
+	size_t xAlignedHeap;
+	size_t xTotalRegionSize, xTotalHeapSize = 0;
+	BaseType_t xDefinedRegions = 0;
+	size_t xAddress;
+	const HeapRegion_t *pxHeapRegion;
+
+	configASSERT( pxEnd == NULL );
+
+	pxHeapRegion = &( pxHeapRegions[ xDefinedRegions ] );
+
+	while( pxHeapRegion->xSizeInBytes > 0 )
+	{
+		xTotalRegionSize = pxHeapRegion->xSizeInBytes;
+
+		xAddress = ( size_t ) pxHeapRegion->pucStartAddress;
+		if( ( xAddress & portBYTE_ALIGNMENT_MASK ) != 0 )
+		{
+			xAddress += ( portBYTE_ALIGNMENT - 1 );
+			xAddress &= ~portBYTE_ALIGNMENT_MASK;
+			xTotalRegionSize -= xAddress - ( size_t ) pxHeapRegion->pucStartAddress;
+		}
+
+		xAlignedHeap = xAddress;
+
+		if( xDefinedRegions == 0 )
+		{
+			xStart.pxNextFreeBlock = ( BlockLink_t * ) xAlignedHeap;
+			xStart.xBlockSize = ( size_t ) 0;
+		}
+		else
+		{
+			/* Regions have to come in address order. */
+			configASSERT( pxEnd != NULL );
+			configASSERT( xAddress > ( size_t ) pxEnd );
+		}
+
+		pxPreviousFreeBlock = pxEnd;
+
+		/* Each region ends with a marker that chains to the next one. */
+		xAddress = xAlignedHeap + xTotalRegionSize;
+		xAddress -= xHeapStructSize;
+		xAddress &= ~portBYTE_ALIGNMENT_MASK;
+		pxEnd = ( BlockLink_t * ) xAddress;
+		pxEnd->xBlockSize = 0;
+		pxEnd->pxNextFreeBlock = NULL;
+
+		pxFirstFreeBlockInRegion = ( BlockLink_t * ) xAlignedHeap;
+		pxFirstFreeBlockInRegion->xBlockSize = xAddress - ( size_t ) pxFirstFreeBlockInRegion;
+		pxFirstFreeBlockInRegion->pxNextFreeBlock = pxEnd;
+
+		if( pxPreviousFreeBlock != NULL )
+		{
+			pxPreviousFreeBlock->pxNextFreeBlock = pxFirstFreeBlockInRegion;
+		}
+
+		xTotalHeapSize += pxFirstFreeBlockInRegion->xBlockSize;
+
+		xDefinedRegions++;
+		pxHeapRegion = &( pxHeapRegions[ xDefinedRegions ] );
+	}
+
+	xMinimumEverFreeBytesRemaining = xTotalHeapSize;
+	xFreeBytesRemaining = xTotalHeapSize;
+
+	configASSERT( xTotalHeapSize );
+
+	xBlockAllocatedBit = ( ( size_t ) 1 ) << ( ( sizeof( size_t ) * heapBITS_PER_BYTE ) - 1 );
+}
+
+__func_tab__ void (*vPortDefineHeapRegions)( const HeapRegion_t * const pxHeapRegions ) = _vPortDefineHeapRegions;
+
+/*
+ * The os_*alloc() family (include/stdlib.h), which the tree's
+ * malloc/free macros expand to.
+ */
+
+void *os_malloc(size_t size)
+{
+	return pvPortMalloc(size);
+}
+
+void os_free(void *ptr)
+{
+	vPortFree(ptr);
+}
+
+void *os_zalloc(size_t size)
+{
+	void *p = pvPortMalloc(size);
+
+	if (p)
+		memset(p, 0, size);
+
+	return p;
+}
+
+void *os_calloc(size_t nmemb, size_t size)
+{
+	if (size && nmemb > (size_t)-1 / size)
+		return NULL;
+
+	return os_zalloc(nmemb * size);
+}
+
+void *os_realloc(void *ptr, size_t size)
+{
+	BlockLink_t *pxLink;
+	size_t old;
+	void *p;
+
+	if (ptr == NULL)
+		return pvPortMalloc(size);
+
+	if (size == 0) {
+		vPortFree(ptr);
+		return NULL;
+	}
+
+	pxLink = (BlockLink_t *)((uint8_t *)ptr - xHeapStructSize);
+	old = (pxLink->xBlockSize & ~xBlockAllocatedBit) - xHeapStructSize;
+	if (size <= old)
+		return ptr;
+
+	p = pvPortMalloc(size);
+	if (p) {
+		memcpy(p, ptr, old);
+		vPortFree(ptr);
+	}
+
+	return p;
+}
@@ -0,0 +1,406 @@
+/*
+ * Copyright 2024-2024 Senscomm Semiconductor Co., Ltd.	All rights reserved.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Sandbox libifconfig: the lib/libifconfig API over interface ioctls
+ * on a lazily opened socket per address family.
+ */
+
+#include <sys/types.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/sockio.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "libifconfig_internal.h"
+
+#ifdef CONFIG_NET80211
+#include <net80211/ieee80211_ioctl.h>
+#endif
+
+ifconfig_handle_t *ifconfig_open(void)
+{
+	struct ifconfig_handle *h;
+	int i;
+
+	h = calloc(1, sizeof(*h));
+	if (h == NULL)
+		return NULL;
+
+	for (i = 0; i <= AF_MAX; i++)
+		h->sockets[i] = -1;
+
+	return h;
+}
+
+void ifconfig_close(ifconfig_handle_t *h)
+{
+	int i;
+
+	if (h == NULL)
+		return;
+
+	for (i = 0; i <= AF_MAX; i++) {
+		if (h->sockets[i] != -1)
+			close(h->sockets[i]);
+	}
+	free(h);
+}
+
+ifconfig_errtype ifconfig_err_errtype(ifconfig_handle_t *h)
+{
+	return h->error.errtype;
+}
+
+int ifconfig_err_errno(ifconfig_handle_t *h)
+{
+	return h->error.errcode;
+}
+
+unsigned long ifconfig_err_ioctlreq(ifconfig_handle_t *h)
+{
+	return h->error.ioctl_request;
+}
+
+int ifconfig_socket(ifconfig_handle_t *h, const int addressfamily, int *s)
+{
+	int af = addressfamily;
+
+	if (af < 0 || af > AF_MAX) {
+		h->error.errtype = OTHER;
+		h->error.errcode = EINVAL;
+		return -1;
+	}
+
+	if (h->sockets[af] != -1) {
+		*s = h->sockets[af];
+		return 0;
+	}
+
+	/* lwIP only knows AF_INET datagram sockets for these ioctls. */
+	*s = socket(AF_INET, SOCK_DGRAM, 0);
+	if (*s < 0) {
+		h->error.errtype = SOCKET;
+		h->error.errcode = errno;
+		return -1;
+	}
+	h->sockets[af] = *s;
+
+	return 0;
+}
+
+int ifconfig_ioctlwrap_ret(ifconfig_handle_t *h, unsigned long request,
+    int rcode)
+{
+	if (rcode != 0) {
+		h->error.errtype = IOCTL;
+		h->error.ioctl_request = request;
+		h->error.errcode = errno;
+	}
+
+	return rcode;
+}
+
+int ifconfig_ioctlwrap(ifconfig_handle_t *h, const int addressfamily,
+    unsigned long request, struct ifreq *ifr)
+{
+	int s;
+
+	if (ifconfig_socket(h, addressfamily, &s) != 0)
+		return -1;
+
+	return ifconfig_ioctlwrap_ret(h, request, ioctl(s, request, ifr));
+}
+
+static int ifconfig_ifreq(ifconfig_handle_t *h, const char *name,
+    unsigned long request, struct ifreq *ifr)
+{
+	strlcpy(ifr->ifr_name, name, sizeof(ifr->ifr_name));
+
+	return ifconfig_ioctlwrap(h, AF_INET, request, ifr);
+}
+
+int ifconfig_set_mtu(ifconfig_handle_t *h, const char *name, const int mtu)
+{
+	struct ifreq ifr;
+
+	memset(&ifr, 0, sizeof(ifr));
+	ifr.ifr_mtu = mtu;
+
+	return ifconfig_ifreq(h, name, SIOCSIFMTU, &ifr);
+}
+
+int ifconfig_get_mtu(ifconfig_handle_t *h, const char *name, int *mtu)
+{
+	struct ifreq ifr;
+
+	memset(&ifr, 0, sizeof(ifr));
+	if (ifconfig_ifreq(h, name, SIOCGIFMTU, &ifr) != 0)
+		return -1;
+	*mtu = ifr.ifr_mtu;
+
+	return 0;
+}
+
+int ifconfig_set_media(ifconfig_handle_t *h, const char *name, struct ifmediareq *req)
+{
+	/* ifconfig passes a struct ifreq with ifr_media set. */
+	return ifconfig_ifreq(h, name, SIOCSIFMEDIA, (struct ifreq *)req);
+}
+
+int ifconfig_get_media(ifconfig_handle_t *h, const char *name, struct ifmediareq *req)
+{
+	return ifconfig_ifreq(h, name, SIOCGIFMEDIA, (struct ifreq *)req);
+}
+
+int ifconfig_set_metric(ifconfig_handle_t *h, const char *name,
+    const int metric)
+{
+	struct ifreq ifr;
+
+	memset(&ifr, 0, sizeof(ifr));
+	ifr.ifr_metric = metric;
+
+	return ifconfig_ifreq(h, name, SIOCSIFMETRIC, &ifr);
+}
+
+int ifconfig_get_metric(ifconfig_handle_t *h, const char *name, int *metric)
+{
+	struct ifreq ifr;
+
+	memset(&ifr, 0, sizeof(ifr));
+	if (ifconfig_ifreq(h, name, SIOCGIFMETRIC, &ifr) != 0)
+		return -1;
+	*metric = ifr.ifr_metric;
+
+	return 0;
+}
+
+int ifconfig_set_flags(ifconfig_handle_t *h, const char *name, int value)
+{
+	struct ifreq ifr;
+
+	memset(&ifr, 0, sizeof(ifr));
+	ifr.ifr_flags = value & 0xffff;
+	ifr.ifr_flagshigh = value >> 16;
+
+	return ifconfig_ifreq(h, name, SIOCSIFFLAGS, &ifr);
+}
+
+int ifconfig_get_flags(ifconfig_handle_t *h, const char *name, int *value)
+{
+	struct ifreq ifr;
+
+	memset(&ifr, 0, sizeof(ifr));
+	if (ifconfig_ifreq(h, name, SIOCGIFFLAGS, &ifr) != 0)
+		return -1;
+	*value = (ifr.ifr_flags & 0xffff) | (ifr.ifr_flagshigh << 16);
+
+	return 0;
+}
+
+int ifconfig_get_linkstate(ifconfig_handle_t *h, const char *name, int *value)
+{
+	struct ifreq ifr;
+
+	memset(&ifr, 0, sizeof(ifr));
+	if (ifconfig_ifreq(h, name, SIOCGLINKSTATE, &ifr) != 0)
+		return -1;
+	*value = ifr.ifr_linkstate;
+
+	return 0;
+}
+
+int ifconfig_set_txqlen(ifconfig_handle_t *h, const char *name, const int qlen)
+{
+	struct ifreq ifr;
+
+	memset(&ifr, 0, sizeof(ifr));
+	ifr.ifr_txqlen = qlen;
+
+	return ifconfig_ifreq(h, name, SIOCSIFTXQLEN, &ifr);
+}
+
+int ifconfig_get_txqlen(ifconfig_handle_t *h, const char *name, int *qlen)
+{
+	struct ifreq ifr;
+
+	/* Not every interface has a queue; -1 tells ifconfig to skip it. */
+	memset(&ifr, 0, sizeof(ifr));
+	if (ifconfig_ifreq(h, name, SIOCGIFTXQLEN, &ifr) != 0)
+		*qlen = -1;
+	else
+		*qlen = ifr.ifr_txqlen;
+
+	return 0;
+}
+
+static int ifconfig_set_sockaddr(ifconfig_handle_t *h, const char *name,
+    unsigned long request, const struct sockaddr *addr)
+{
+	struct ifreq ifr;
+
+	memset(&ifr, 0, sizeof(ifr));
+	memcpy(&ifr.ifr_addr, addr, sizeof(ifr.ifr_addr));
+
+	return ifconfig_ifreq(h, name, request, &ifr);
+}
+
+static int ifconfig_get_sockaddr(ifconfig_handle_t *h, const char *name,
+    unsigned long request, struct sockaddr *addr)
+{
+	struct ifreq ifr;
+
+	memset(&ifr, 0, sizeof(ifr));
+	if (ifconfig_ifreq(h, name, request, &ifr) != 0)
+		return -1;
+	memcpy(addr, &ifr.ifr_addr, sizeof(*addr));
+
+	return 0;
+}
+
+int ifconfig_set_addr(ifconfig_handle_t *h, const char *name,
+    const struct sockaddr addr)
+{
+	return ifconfig_set_sockaddr(h, name, SIOCSIFADDR, &addr);
+}
+
+int ifconfig_get_addr(ifconfig_handle_t *h, const char *name,
+    struct sockaddr *addr)
+{
+	return ifconfig_get_sockaddr(h, name, SIOCGIFADDR, addr);
+}
+
+int ifconfig_set_broadaddr(ifconfig_handle_t *h, const char *name,
+    const struct sockaddr addr)
+{
+	return ifconfig_set_sockaddr(h, name, SIOCSIFBRDADDR, &addr);
+}
+
+int ifconfig_get_broadaddr(ifconfig_handle_t *h, const char *name,
+    struct sockaddr *addr)
+{
+	return ifconfig_get_sockaddr(h, name, SIOCGIFBRDADDR, addr);
+}
+
+int ifconfig_set_netmask(ifconfig_handle_t *h, const char *name,
+    const struct sockaddr addr)
+{
+	return ifconfig_set_sockaddr(h, name, SIOCSIFNETMASK, &addr);
+}
+
+int ifconfig_get_netmask(ifconfig_handle_t *h, const char *name,
+    struct sockaddr *addr)
+{
+	return ifconfig_get_sockaddr(h, name, SIOCGIFNETMASK, addr);
+}
+
+int ifconfig_set_gateway(ifconfig_handle_t *h, const char *name,
+    const struct sockaddr addr)
+{
+	return ifconfig_set_sockaddr(h, name, SIOCSIFGWADDR, &addr);
+}
+
+int ifconfig_get_gateway(ifconfig_handle_t *h, const char *name,
+    struct sockaddr *addr)
+{
+	return ifconfig_get_sockaddr(h, name, SIOCGIFGWADDR, addr);
+}
+
+int ifconfig_set_hwaddr(ifconfig_handle_t *h, const char *name,
+		const struct sockaddr addr)
+{
+	return ifconfig_set_sockaddr(h, name, SIOCSIFHWADDR, &addr);
+}
+
+int ifconfig_get_hwaddr(ifconfig_handle_t *h, const char *name,
+		struct sockaddr *addr)
+{
+	return ifconfig_get_sockaddr(h, name, SIOCGIFHWADDR, addr);
+}
+
+int ifconfig_get_stats(ifconfig_handle_t *h, const char *name,
+		struct ifstat *stats)
+{
+	/* Interfaces without counters (lo) just show none. */
+	memset(stats, 0, sizeof(*stats));
+	if (ifconfig_ifreq(h, name, SIOCGIFSTATUS, (struct ifreq *)stats) != 0)
+		stats->ascii[0] = '\0';
+
+	return 0;
+}
+
+#ifdef CONFIG_NET80211
+
+int ifconfig_set80211(ifconfig_handle_t *h, const char *name,
+		int type, int val, int len, void *data)
+{
+	struct ieee80211req ireq;
+
+	memset(&ireq, 0, sizeof(ireq));
+	strlcpy(ireq.i_name, name, sizeof(ireq.i_name));
+	ireq.i_type = type;
+	ireq.i_val = val;
+	ireq.i_len = len;
+	ireq.i_data = data;
+
+	return ifconfig_ioctlwrap(h, AF_INET, SIOCS80211, (struct ifreq *)&ireq);
+}
+
+int ifconfig_get80211len(ifconfig_handle_t *h, const char *name,
+		int type, void *data, int len, int *plen)
+{
+	struct ieee80211req ireq;
+
+	memset(&ireq, 0, sizeof(ireq));
+	strlcpy(ireq.i_name, name, sizeof(ireq.i_name));
+	ireq.i_type = type;
+	ireq.i_len = len;
+	ireq.i_data = data;
+
+	if (ifconfig_ioctlwrap(h, AF_INET, SIOCG80211, (struct ifreq *)&ireq) != 0)
+		return -1;
+	if (plen)
+		*plen = ireq.i_len;
+
+	return 0;
+}
+
+int ifconfig_get80211(ifconfig_handle_t *h, const char *name,
+		int type, void *data, int len)
+{
+	return ifconfig_get80211len(h, name, type, data, len, NULL);
+}
+
+int ifconfig_get80211val(ifconfig_handle_t *h, const char *name,
+		int type, int len, int *val)
+{
+	struct ieee80211req ireq;
+
+	memset(&ireq, 0, sizeof(ireq));
+	strlcpy(ireq.i_name, name, sizeof(ireq.i_name));
+	ireq.i_type = type;
+	ireq.i_len = len;
+
+	if (ifconfig_ioctlwrap(h, AF_INET, SIOCG80211, (struct ifreq *)&ireq) != 0)
+		return -1;
+	*val = ireq.i_val;
+
+	return 0;
+}
+
+#endif
@@ -0,0 +1,466 @@
+/*
+ * Copyright 2024-2024 Senscomm Semiconductor Co., Ltd.	All rights reserved.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Sandbox <stdio.h>: unbuffered FILE streams over VFS file
+ * descriptors, formatted by the host vsnprintf(), plus the odd
+ * string routines the host libc may lack.
+ *
+ * Until init() has opened the console as stdin/stdout/stderr, output
+ * goes to printk().
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <hal/kernel.h>
+#include <hal/kmem.h>
+#include <hal/compiler.h>
+#include <hal/console.h>
+
+struct os_file {
+	int fd;
+	int ungot;
+	int error;
+};
+
+#define os_file(stream)	((struct os_file *)(stream))
+
+FILE *os_stdin, *os_stdout, *os_stderr;
+
+/* Streams */
+
+FILE *_os_fdopen(int fd, const char *mode)
+{
+	struct os_file *f;
+
+	if (fd < 0)
+		return NULL;
+
+	f = kmalloc(sizeof(*f));
+	if (f == NULL) {
+		errno = ENOMEM;
+		return NULL;
+	}
+	f->fd = fd;
+	f->ungot = EOF;
+	f->error = 0;
+
+	return f;
+}
+
+__func_tab__ FILE *(*os_fdopen)(int fd, const char *mode) = _os_fdopen;
+
+FILE *_os_fopen(const char *pathname, const char *mode)
+{
+	int flags, fd;
+	FILE *f;
+
+	switch (mode[0]) {
+	case 'r':
+		flags = O_RDONLY;
+		break;
+	case 'w':
+		flags = O_WRONLY | O_CREAT | O_TRUNC;
+		break;
+	case 'a':
+		flags = O_WRONLY | O_CREAT | O_APPEND;
+		break;
+	default:
+		errno = EINVAL;
+		return NULL;
+	}
+	if (strchr(mode, '+'))
+		flags = (flags & ~(O_RDONLY | O_WRONLY)) | O_RDWR;
+
+	fd = os_open(pathname, flags, 0666);
+	if (fd < 0)
+		return NULL;
+
+	f = os_fdopen(fd, mode);
+	if (f == NULL)
+		os_close(fd);
+
+	return f;
+}
+
+__func_tab__ FILE *(*os_fopen)(const char *pathname, const char *mode) = _os_fopen;
+
+int _os_fclose(FILE *stream)
+{
+	int ret;
+
+	if (stream == NULL)
+		return EOF;
+
+	ret = os_close(os_file(stream)->fd);
+	kfree(stream);
+
+	return ret < 0 ? EOF : 0;
+}
+
+__func_tab__ int (*os_fclose)(FILE *stream) = _os_fclose;
+
+int os_ferror(FILE *stream)
+{
+	return stream ? os_file(stream)->error : 1;
+}
+
+int os_setvbuf(FILE *stream, char *buf, int mode, size_t size)
+{
+	/* Every stream is unbuffered. */
+	return 0;
+}
+
+size_t _os_fwrite(const void *ptr, size_t size, size_t nmemb, FILE *stream)
+{
+	size_t len = size * nmemb, done = 0;
+	ssize_t ret;
+
+	if (stream == NULL || len == 0)
+		return 0;
+
+	while (done < len) {
+		ret = os_write(os_file(stream)->fd, (const char *)ptr + done,
+			       len - done);
+		if (ret <= 0) {
+			os_file(stream)->error = 1;
+			break;
+		}
+		done += ret;
+	}
+
+	return done / size;
+}
+
+__func_tab__ size_t (*os_fwrite)(const void *ptr, size_t size, size_t nmemb, FILE *stream) = _os_fwrite;
+
+size_t _os_fread(void *ptr, size_t size, size_t nmemb, FILE *stream)
+{
+	struct os_file *f = os_file(stream);
+	size_t len = size * nmemb, done = 0;
+	ssize_t ret;
+
+	if (f == NULL || len == 0)
+		return 0;
+
+	if (f->ungot != EOF) {
+		*(unsigned char *)ptr = f->ungot;
+		f->ungot = EOF;
+		done++;
+	}
+
+	while (done < len) {
+		ret = os_read(f->fd, (char *)ptr + done, len - done);
+		if (ret < 0)
+			f->error = 1;
+		if (ret <= 0)
+			break;
+		done += ret;
+	}
+
+	return done / size;
+}
+
+__func_tab__ size_t (*os_fread)(void *ptr, size_t size, size_t nmemb, FILE *stream) = _os_fread;
+
+int _os_fputc(int c, FILE *stream)
+{
+	unsigned char ch = c;
+
+	return os_fwrite(&ch, 1, 1, stream) == 1 ? ch : EOF;
+}
+
+__func_tab__ int (*os_fputc)(int c, FILE *stream) = _os_fputc;
+
+int os_putc(int c, FILE *stream)
+{
+	return os_fputc(c, stream);
+}
+
+int _os_fputs(const char *s, FILE *stream)
+{
+	size_t len = strlen(s);
+
+	return os_fwrite(s, 1, len, stream) == len ? (int)len : EOF;
+}
+
+__func_tab__ int (*os_fputs)(const char *s, FILE *stream) = _os_fputs;
+
+int _os_fgetc(FILE *stream)
+{
+	unsigned char ch;
+
+	return os_fread(&ch, 1, 1, stream) == 1 ? ch : EOF;
+}
+
+__func_tab__ int (*os_fgetc)(FILE *stream) = _os_fgetc;
+
+int os_getc(FILE *stream)
+{
+	return os_fgetc(stream);
+}
+
+char *_os_fgets(char *s, int size, FILE *stream)
+{
+	int i = 0, c;
+
+	while (i < size - 1) {
+		c = os_fgetc(stream);
+		if (c == EOF)
+			break;
+		s[i++] = c;
+		if (c == '\n')
+			break;
+	}
+	if (i == 0)
+		return NULL;
+	s[i] = '\0';
+
+	return s;
+}
+
+__func_tab__ char *(*os_fgets)(char *s, int size, FILE *stream) = _os_fgets;
+
+int _os_ungetc(int c, FILE *stream)
+{
+	if (stream == NULL || c == EOF || os_file(stream)->ungot != EOF)
+		return EOF;
+
+	os_file(stream)->ungot = (unsigned char)c;
+
+	return (unsigned char)c;
+}
+
+__func_tab__ int (*os_ungetc)(int c, FILE *stream) = _os_ungetc;
+
+/* Console */
+
+int os_putchar(int c)
+{
+	if (os_stdout == NULL) {
+		printk("%c", c);
+		return c;
+	}
+
+	return os_fputc(c, os_stdout);
+}
+
+int _os_puts(const char *s)
+{
+	if (os_fputs(s, os_stdout) == EOF)
+		return EOF;
+
+	return os_putchar('\n');
+}
+
+__func_tab__ int (*os_puts)(const char *s) = _os_puts;
+
+int os_getchar(void)
+{
+	return os_fgetc(os_stdin);
+}
+
+/* One character from stdin within @timeout ms, or -1. */
+int _getchar_timeout(unsigned timeout)
+{
+	struct pollfd pfd = {
+		.fd = STDIN_FILENO,
+		.events = POLLIN,
+	};
+
+	if (os_stdin == NULL)
+		return -1;
+
+	if (os_file(os_stdin)->ungot == EOF &&
+	    os_poll(&pfd, 1, timeout) <= 0)
+		return -1;
+
+	return os_fgetc(os_stdin);
+}
+
+__func_tab__ int (*getchar_timeout)(unsigned timeout) = _getchar_timeout;
+
+/* Formatted output */
+
+int os_vasprintf(char **ptr, const char *fmt, va_list ap)
+{
+	va_list aq;
+	int len;
+
+	va_copy(aq, ap);
+	len = vsnprintf(NULL, 0, fmt, aq);
+	va_end(aq);
+
+	*ptr = NULL;
+	if (len < 0)
+		return len;
+
+	*ptr = kmalloc(len + 1);
+	if (*ptr == NULL)
+		return -1;
+
+	return vsnprintf(*ptr, len + 1, fmt, ap);
+}
+
+int os_asprintf(char **ptr, const char *fmt, ...)
+{
+	va_list ap;
+	int len;
+
+	va_start(ap, fmt);
+	len = os_vasprintf(ptr, fmt, ap);
+	va_end(ap);
+
+	return len;
+}
+
+int os_vfprintf(FILE *stream, const char *format, va_list ap)
+{
+	char buf[128], *p = buf;
+	va_list aq;
+	int len;
+
+	va_copy(aq, ap);
+	len = vsnprintf(buf, sizeof(buf), format, aq);
+	va_end(aq);
+
+	if (len < 0)
+		return len;
+
+	if (len >= sizeof(buf)) {
+		p = kmalloc(len + 1);
+		if (p == NULL)
+			return -1;
+		vsnprintf(p, len + 1, format, ap);
+	}
+
+	if (stream == NULL)
+		printk("%s", p);
+	else if (os_fwrite(p, 1, len, stream) != len)
+		len = -1;
+
+	if (p != buf)
+		kfree(p);
+
+	return len;
+}
+
+int os_vprintf(const char *format, va_list ap)
+{
+	return os_vfprintf(os_stdout, format, ap);
+}
+
+int _os_fprintf(FILE *stream, const char *format, ...)
+{
+	va_list ap;
+	int len;
+
+	va_start(ap, format);
+	len = os_vfprintf(stream, format, ap);
+	va_end(ap);
+
+	return len;
+}
+
+__func_tab__ int (*os_fprintf)(FILE *stream, const char *format, ...) = _os_fprintf;
+
+int _os_printf(const char *format, ...)
+{
+	va_list ap;
+	int len;
+
+	va_start(ap, format);
+	len = os_vfprintf(os_stdout, format, ap);
+	va_end(ap);
+
+	return len;
+}
+
+__func_tab__ int (*os_printf)(const char *format, ...) = _os_printf;
+
+int _os_sprintf(char *str, const char *format, ...)
+{
+	va_list ap;
+	int len;
+
+	va_start(ap, format);
+	len = vsprintf(str, format, ap);
+	va_end(ap);
+
+	return len;
+}
+
+__func_tab__ int (*os_sprintf)(char *str, const char *format, ...) = _os_sprintf;
+
+int _os_snprintf(char *str, size_t size, const char *format, ...)
+{
+	va_list ap;
+	int len;
+
+	va_start(ap, format);
+	len = vsnprintf(str, size, format, ap);
+	va_end(ap);
+
+	return len;
+}
+
+__func_tab__ int (*os_snprintf)(char *str, size_t size, const char *format, ...) = _os_snprintf;
+
+void os_perror(const char *s)
+{
+	if (s && *s)
+		os_fprintf(os_stderr, "%s: %s\n", s, strerror(errno));
+	else
+		os_fprintf(os_stderr, "%s\n", strerror(errno));
+}
+
+/* Strings */
+
+char *strdup(const char *s)
+{
+	size_t len = strlen(s) + 1;
+	char *d = malloc(len);
+
+	if (d)
+		memcpy(d, s, len);
+
+	return d;
+}
+
+size_t strlcpy(char *dst, const char *src, size_t size)
+{
+	size_t len = strlen(src);
+
+	if (size) {
+		size_t n = len >= size ? size - 1 : len;
+
+		memcpy(dst, src, n);
+		dst[n] = '\0';
+	}
+
+	return len;
+}
+
+size_t strlcat(char *dst, const char *src, size_t size)
+{
+	size_t dlen = strnlen(dst, size);
+
+	if (dlen == size)
+		return size + strlen(src);
+
+	return dlen + strlcpy(dst + dlen, src, size - dlen);
+}
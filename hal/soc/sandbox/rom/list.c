@@ -0,0 +1,95 @@
+/*
+ * Copyright 2024-2024 Senscomm Semiconductor Co., Ltd.	All rights reserved.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * FreeRTOS list.h, for the sandbox kernel (see tasks.c).
+ */
+
+#include <stdlib.h>
+
+#include "FreeRTOS.h"
+#include "list.h"
+
+void vListInitialise( List_t * const pxList )
+{
+	pxList->pxIndex = ( ListItem_t * ) &( pxList->xListEnd );
+	pxList->xListEnd.xItemValue = portMAX_DELAY;
+	pxList->xListEnd.pxNext = ( ListItem_t * ) &( pxList->xListEnd );
+	pxList->xListEnd.pxPrevious = ( ListItem_t * ) &( pxList->xListEnd );
+	pxList->uxNumberOfItems = ( UBaseType_t ) 0U;
+}
+
+void vListInitialiseItem( ListItem_t * const pxItem )
+{
+	pxItem->pxContainer = NULL;
+}
+
+/* Insert at the "end", i.e. right before pxIndex, so that
+ * listGET_OWNER_OF_NEXT_ENTRY() reaches it last. */
+void vListInsertEnd( List_t * const pxList, ListItem_t * const pxNewListItem )
+{
+	ListItem_t * const pxIndex = pxList->pxIndex;
+
+	pxNewListItem->pxNext = pxIndex;
+	pxNewListItem->pxPrevious = pxIndex->pxPrevious;
+	pxIndex->pxPrevious->pxNext = pxNewListItem;
+	pxIndex->pxPrevious = pxNewListItem;
+
+	pxNewListItem->pxContainer = pxList;
+	( pxList->uxNumberOfItems )++;
+}
+
+/* Insert in ascending xItemValue order, after any items of equal value. */
+void vListInsert( List_t * const pxList, ListItem_t * const pxNewListItem )
+{
+	ListItem_t *pxIterator;
+	const TickType_t xValueOfInsertion = pxNewListItem->xItemValue;
+
+	if( xValueOfInsertion == portMAX_DELAY )
+	{
+		pxIterator = pxList->xListEnd.pxPrevious;
+	}
+	else
+	{
+		for( pxIterator = ( ListItem_t * ) &( pxList->xListEnd );
+		     pxIterator->pxNext->xItemValue <= xValueOfInsertion;
+		     pxIterator = pxIterator->pxNext )
+		{
+		}
+	}
+
+	pxNewListItem->pxNext = pxIterator->pxNext;
+	pxNewListItem->pxNext->pxPrevious = pxNewListItem;
+	pxNewListItem->pxPrevious = pxIterator;
+	pxIterator->pxNext = pxNewListItem;
+
+	pxNewListItem->pxContainer = pxList;
+	( pxList->uxNumberOfItems )++;
+}
+
+UBaseType_t uxListRemove( ListItem_t * const pxItemToRemove )
+{
+	List_t * const pxList = pxItemToRemove->pxContainer;
+
+	pxItemToRemove->pxNext->pxPrevious = pxItemToRemove->pxPrevious;
+	pxItemToRemove->pxPrevious->pxNext = pxItemToRemove->pxNext;
+
+	if( pxList->pxIndex == pxItemToRemove )
+	{
+		pxList->pxIndex = pxItemToRemove->pxPrevious;
+	}
+
+	pxItemToRemove->pxContainer = NULL;
+	( pxList->uxNumberOfItems )--;
+
+	return pxList->uxNumberOfItems;
+}
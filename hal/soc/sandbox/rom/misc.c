@@ -0,0 +1,48 @@
+/*
+ * Copyright 2024-2024 Senscomm Semiconductor Co., Ltd.	All rights reserved.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Sandbox odds and ends the ROM would otherwise provide.
+ */
+
+#include <hal/types.h>
+#include <hal/compiler.h>
+#include <hal/pm.h>
+
+#include <freebsd/mutex.h>
+
+int time_hz = CONFIG_TIMER_HZ;
+
+/* The host never sleeps on its own, so there is nothing to hold off. */
+void _pm_staytimeout(u32 ms)
+{
+}
+
+__func_tab__ void (*pm_staytimeout)(u32 ms) = _pm_staytimeout;
+
+/* FreeBSD compat mutexes, see include/freebsd/mutex.h. */
+
+void mtx_init(struct mtx *m, const char *name, const char *type, int opts)
+{
+	osMutexAttr_t attr = {
+		.name = name,
+		.attr_bits = (opts & MTX_RECURSE) ? osMutexRecursive : 0,
+	};
+
+	m->mid = osMutexNew(&attr);
+}
+
+void mtx_destroy(struct mtx *m)
+{
+	osMutexDelete(m->mid);
+	m->mid = NULL;
+}
@@ -0,0 +1,1307 @@
+/*
+ * Copyright 2024-2024 Senscomm Semiconductor Co., Ltd.	All rights reserved.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Sandbox FreeRTOS kernel: queues, semaphores, mutexes and queue sets
+ * (see tasks.c), plus the xqueue.h extensions.
+ *
+ * Unlike xQueueAddToSet(), queue_insert_set() takes a member that is
+ * not empty: the set only reports what is sent to it from then on,
+ * which is all vfs poll needs, since it checks the levels itself.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "xqueue.h"
+
+#define queueUNLOCKED			( ( int8_t ) -1 )
+#define queueLOCKED_UNMODIFIED		( ( int8_t ) 0 )
+
+#define queueSEMAPHORE_QUEUE_ITEM_LENGTH ( ( UBaseType_t ) 0 )
+#define queueMUTEX_GIVE_BLOCK_TIME	( ( TickType_t ) 0U )
+
+#if( configUSE_PREEMPTION == 0 )
+	#define queueYIELD_IF_USING_PREEMPTION()
+#else
+	#define queueYIELD_IF_USING_PREEMPTION() portYIELD_WITHIN_API()
+#endif
+
+typedef struct QueuePointers
+{
+	int8_t *pcTail;
+	int8_t *pcReadFrom;
+} QueuePointers_t;
+
+typedef struct SemaphoreData
+{
+	TaskHandle_t xMutexHolder;
+	UBaseType_t uxRecursiveCallCount;
+} SemaphoreData_t;
+
+/* The layout must match StaticQueue_t. */
+typedef struct QueueDefinition
+{
+	int8_t *pcHead;
+	int8_t *pcWriteTo;
+
+	union
+	{
+		QueuePointers_t xQueue;
+		SemaphoreData_t xSemaphore;
+	} u;
+
+	List_t xTasksWaitingToSend;
+	List_t xTasksWaitingToReceive;
+
+	volatile UBaseType_t uxMessagesWaiting;
+	UBaseType_t uxLength;
+	UBaseType_t uxItemSize;
+
+	volatile int8_t cRxLock;
+	volatile int8_t cTxLock;
+
+	uint8_t ucStaticallyAllocated;
+
+	struct QueueDefinition *pxQueueSetContainer;
+
+	UBaseType_t uxQueueNumber;
+	uint8_t ucQueueType;
+} xQUEUE;
+
+typedef xQUEUE Queue_t;
+
+/* A mutex has no storage: pcHead is NULL and pcTail is the holder. */
+#define uxQueueType			pcHead
+#define queueQUEUE_IS_MUTEX		NULL
+
+static void prvUnlockQueue( Queue_t * const pxQueue );
+static BaseType_t prvIsQueueEmpty( const Queue_t *pxQueue );
+static BaseType_t prvIsQueueFull( const Queue_t *pxQueue );
+static BaseType_t prvCopyDataToQueue( Queue_t * const pxQueue, const void *pvItemToQueue, const BaseType_t xPosition );
+static void prvCopyDataFromQueue( Queue_t * const pxQueue, void * const pvBuffer );
+static BaseType_t prvNotifyQueueSetContainer( const Queue_t * const pxQueue );
+static UBaseType_t prvGetDisinheritPriorityAfterTimeout( const Queue_t * const pxQueue );
+
+#define prvLockQueue( pxQueue )							\
+	taskENTER_CRITICAL();							\
+	{									\
+		if( ( pxQueue )->cRxLock == queueUNLOCKED )			\
+		{								\
+			( pxQueue )->cRxLock = queueLOCKED_UNMODIFIED;		\
+		}								\
+		if( ( pxQueue )->cTxLock == queueUNLOCKED )			\
+		{								\
+			( pxQueue )->cTxLock = queueLOCKED_UNMODIFIED;		\
+		}								\
+	}									\
+	taskEXIT_CRITICAL()
+
+/*-----------------------------------------------------------
+ * Creation and deletion
+ *----------------------------------------------------------*/
+
+BaseType_t xQueueGenericReset( QueueHandle_t xQueue, BaseType_t xNewQueue )
+{
+	Queue_t * const pxQueue = xQueue;
+
+	configASSERT( pxQueue );
+
+	taskENTER_CRITICAL();
+	{
+		pxQueue->u.xQueue.pcTail = pxQueue->pcHead + ( pxQueue->uxLength * pxQueue->uxItemSize );
+		pxQueue->uxMessagesWaiting = ( UBaseType_t ) 0U;
+		pxQueue->pcWriteTo = pxQueue->pcHead;
+		pxQueue->u.xQueue.pcReadFrom = pxQueue->pcHead + ( ( pxQueue->uxLength - 1U ) * pxQueue->uxItemSize );
+		pxQueue->cRxLock = queueUNLOCKED;
+		pxQueue->cTxLock = queueUNLOCKED;
+
+		if( xNewQueue == pdFALSE )
+		{
+			/* Tasks waiting to read stay blocked; one writer may go. */
+			if( listLIST_IS_EMPTY( &( pxQueue->xTasksWaitingToSend ) ) == pdFALSE )
+			{
+				if( xTaskRemoveFromEventList( &( pxQueue->xTasksWaitingToSend ) ) != pdFALSE )
+				{
+					queueYIELD_IF_USING_PREEMPTION();
+				}
+			}
+		}
+		else
+		{
+			vListInitialise( &( pxQueue->xTasksWaitingToSend ) );
+			vListInitialise( &( pxQueue->xTasksWaitingToReceive ) );
+		}
+	}
+	taskEXIT_CRITICAL();
+
+	return pdPASS;
+}
+
+static void prvInitialiseNewQueue( const UBaseType_t uxQueueLength, const UBaseType_t uxItemSize, uint8_t *pucQueueStorage, const uint8_t ucQueueType, Queue_t *pxNewQueue )
+{
+	if( uxItemSize == ( UBaseType_t ) 0 )
+	{
+		/* pcHead must not be NULL, as NULL marks a mutex. */
+		pxNewQueue->pcHead = ( int8_t * ) pxNewQueue;
+	}
+	else
+	{
+		pxNewQueue->pcHead = ( int8_t * ) pucQueueStorage;
+	}
+
+	pxNewQueue->uxLength = uxQueueLength;
+	pxNewQueue->uxItemSize = uxItemSize;
+	( void ) xQueueGenericReset( pxNewQueue, pdTRUE );
+
+	pxNewQueue->ucQueueType = ucQueueType;
+	pxNewQueue->uxQueueNumber = 0;
+	pxNewQueue->pxQueueSetContainer = NULL;
+}
+
+QueueHandle_t xQueueGenericCreate( const UBaseType_t uxQueueLength, const UBaseType_t uxItemSize, const uint8_t ucQueueType )
+{
+	Queue_t *pxNewQueue;
+	size_t xQueueSizeInBytes;
+	uint8_t *pucQueueStorage;
+
+	configASSERT( uxQueueLength > ( UBaseType_t ) 0 );
+
+	xQueueSizeInBytes = ( size_t ) ( uxQueueLength * uxItemSize );
+
+	pxNewQueue = ( Queue_t * ) pvPortMalloc( sizeof( Queue_t ) + xQueueSizeInBytes );
+	if( pxNewQueue != NULL )
+	{
+		pucQueueStorage = ( uint8_t * ) pxNewQueue + sizeof( Queue_t );
+		pxNewQueue->ucStaticallyAllocated = pdFALSE;
+		prvInitialiseNewQueue( uxQueueLength, uxItemSize, pucQueueStorage, ucQueueType, pxNewQueue );
+	}
+
+	return pxNewQueue;
+}
+
+QueueHandle_t xQueueGenericCreateStatic( const UBaseType_t uxQueueLength, const UBaseType_t uxItemSize, uint8_t *pucQueueStorage, StaticQueue_t *pxStaticQueue, const uint8_t ucQueueType )
+{
+	Queue_t *pxNewQueue;
+
+	configASSERT( uxQueueLength > ( UBaseType_t ) 0 );
+	configASSERT( pxStaticQueue != NULL );
+	configASSERT( !( ( pucQueueStorage != NULL ) && ( uxItemSize == 0 ) ) );
+	configASSERT( !( ( pucQueueStorage == NULL ) && ( uxItemSize != 0 ) ) );
+	configASSERT( sizeof( StaticQueue_t ) == sizeof( Queue_t ) );
+
+	pxNewQueue = ( Queue_t * ) pxStaticQueue;
+	if( pxNewQueue != NULL )
+	{
+		pxNewQueue->ucStaticallyAllocated = pdTRUE;
+		prvInitialiseNewQueue( uxQueueLength, uxItemSize, pucQueueStorage, ucQueueType, pxNewQueue );
+	}
+
+	return pxNewQueue;
+}
+
+static void prvInitialiseMutex( Queue_t *pxNewQueue )
+{
+	if( pxNewQueue != NULL )
+	{
+		pxNewQueue->u.xSemaphore.xMutexHolder = NULL;
+		pxNewQueue->uxQueueType = queueQUEUE_IS_MUTEX;
+		pxNewQueue->u.xSemaphore.uxRecursiveCallCount = 0;
+
+		/* Start in the available state. */
+		( void ) xQueueGenericSend( pxNewQueue, NULL, ( TickType_t ) 0U, queueSEND_TO_BACK );
+	}
+}
+
+QueueHandle_t xQueueCreateMutex( const uint8_t ucQueueType )
+{
+	QueueHandle_t xNewQueue;
+
+	xNewQueue = xQueueGenericCreate( ( UBaseType_t ) 1, queueSEMAPHORE_QUEUE_ITEM_LENGTH, ucQueueType );
+	prvInitialiseMutex( ( Queue_t * ) xNewQueue );
+
+	return xNewQueue;
+}
+
+QueueHandle_t xQueueCreateMutexStatic( const uint8_t ucQueueType, StaticQueue_t *pxStaticQueue )
+{
+	QueueHandle_t xNewQueue;
+
+	xNewQueue = xQueueGenericCreateStatic( ( UBaseType_t ) 1, queueSEMAPHORE_QUEUE_ITEM_LENGTH, NULL, pxStaticQueue, ucQueueType );
+	prvInitialiseMutex( ( Queue_t * ) xNewQueue );
+
+	return xNewQueue;
+}
+
+TaskHandle_t xQueueGetMutexHolder( QueueHandle_t xSemaphore )
+{
+	TaskHandle_t pxReturn;
+	Queue_t * const pxSemaphore = ( Queue_t * ) xSemaphore;
+
+	taskENTER_CRITICAL();
+	{
+		if( pxSemaphore->uxQueueType == queueQUEUE_IS_MUTEX )
+		{
+			pxReturn = pxSemaphore->u.xSemaphore.xMutexHolder;
+		}
+		else
+		{
+			pxReturn = NULL;
+		}
+	}
+	taskEXIT_CRITICAL();
+
+	return pxReturn;
+}
+
+TaskHandle_t xQueueGetMutexHolderFromISR( QueueHandle_t xSemaphore )
+{
+	configASSERT( xSemaphore );
+
+	if( ( ( Queue_t * ) xSemaphore )->uxQueueType == queueQUEUE_IS_MUTEX )
+	{
+		return ( ( Queue_t * ) xSemaphore )->u.xSemaphore.xMutexHolder;
+	}
+
+	return NULL;
+}
+
+QueueHandle_t xQueueCreateCountingSemaphore( const UBaseType_t uxMaxCount, const UBaseType_t uxInitialCount )
+{
+	QueueHandle_t xHandle;
+
+	configASSERT( uxMaxCount != 0 );
+	configASSERT( uxInitialCount <= uxMaxCount );
+
+	xHandle = xQueueGenericCreate( uxMaxCount, queueSEMAPHORE_QUEUE_ITEM_LENGTH, queueQUEUE_TYPE_COUNTING_SEMAPHORE );
+	if( xHandle != NULL )
+	{
+		( ( Queue_t * ) xHandle )->uxMessagesWaiting = uxInitialCount;
+	}
+
+	return xHandle;
+}
+
+QueueHandle_t xQueueCreateCountingSemaphoreStatic( const UBaseType_t uxMaxCount, const UBaseType_t uxInitialCount, StaticQueue_t *pxStaticQueue )
+{
+	QueueHandle_t xHandle;
+
+	configASSERT( uxMaxCount != 0 );
+	configASSERT( uxInitialCount <= uxMaxCount );
+
+	xHandle = xQueueGenericCreateStatic( uxMaxCount, queueSEMAPHORE_QUEUE_ITEM_LENGTH, NULL, pxStaticQueue, queueQUEUE_TYPE_COUNTING_SEMAPHORE );
+	if( xHandle != NULL )
+	{
+		( ( Queue_t * ) xHandle )->uxMessagesWaiting = uxInitialCount;
+	}
+
+	return xHandle;
+}
+
+void vQueueDelete( QueueHandle_t xQueue )
+{
+	Queue_t * const pxQueue = xQueue;
+
+	configASSERT( pxQueue );
+
+	if( pxQueue->ucStaticallyAllocated == ( uint8_t ) pdFALSE )
+	{
+		vPortFree( pxQueue );
+	}
+}
+
+/*-----------------------------------------------------------
+ * Recursive mutexes
+ *----------------------------------------------------------*/
+
+BaseType_t xQueueGiveMutexRecursive( QueueHandle_t xMutex )
+{
+	BaseType_t xReturn;
+	Queue_t * const pxMutex = ( Queue_t * ) xMutex;
+
+	configASSERT( pxMutex );
+
+	if( pxMutex->u.xSemaphore.xMutexHolder == xTaskGetCurrentTaskHandle() )
+	{
+		( pxMutex->u.xSemaphore.uxRecursiveCallCount )--;
+
+		if( pxMutex->u.xSemaphore.uxRecursiveCallCount == ( UBaseType_t ) 0 )
+		{
+			( void ) xQueueGenericSend( pxMutex, NULL, queueMUTEX_GIVE_BLOCK_TIME, queueSEND_TO_BACK );
+		}
+
+		xReturn = pdPASS;
+	}
+	else
+	{
+		xReturn = pdFAIL;
+	}
+
+	return xReturn;
+}
+
+BaseType_t xQueueTakeMutexRecursive( QueueHandle_t xMutex, TickType_t xTicksToWait )
+{
+	BaseType_t xReturn;
+	Queue_t * const pxMutex = ( Queue_t * ) xMutex;
+
+	configASSERT( pxMutex );
+
+	if( pxMutex->u.xSemaphore.xMutexHolder == xTaskGetCurrentTaskHandle() )
+	{
+		( pxMutex->u.xSemaphore.uxRecursiveCallCount )++;
+		xReturn = pdPASS;
+	}
+	else
+	{
+		xReturn = xQueueSemaphoreTake( pxMutex, xTicksToWait );
+
+		if( xReturn != pdFAIL )
+		{
+			( pxMutex->u.xSemaphore.uxRecursiveCallCount )++;
+		}
+	}
+
+	return xReturn;
+}
+
+/*-----------------------------------------------------------
+ * Send
+ *----------------------------------------------------------*/
+
+/* Wake one reader, of the set if the queue is in one. Call in a critical section. */
+static BaseType_t prvWakeReader( Queue_t * const pxQueue, BaseType_t xPreviousMessagesWaiting, BaseType_t xCopyPosition )
+{
+	if( pxQueue->pxQueueSetContainer != NULL )
+	{
+		/* Overwriting a full queue adds nothing to read. */
+		if( ( xCopyPosition == queueOVERWRITE ) && ( xPreviousMessagesWaiting != ( BaseType_t ) 0 ) )
+		{
+			return pdFALSE;
+		}
+
+		return prvNotifyQueueSetContainer( pxQueue );
+	}
+
+	if( listLIST_IS_EMPTY( &( pxQueue->xTasksWaitingToReceive ) ) == pdFALSE )
+	{
+		return xTaskRemoveFromEventList( &( pxQueue->xTasksWaitingToReceive ) );
+	}
+
+	return pdFALSE;
+}
+
+BaseType_t xQueueGenericSend( QueueHandle_t xQueue, const void * const pvItemToQueue, TickType_t xTicksToWait, const BaseType_t xCopyPosition )
+{
+	BaseType_t xEntryTimeSet = pdFALSE, xYieldRequired;
+	TimeOut_t xTimeOut;
+	Queue_t * const pxQueue = xQueue;
+
+	configASSERT( pxQueue );
+	configASSERT( !( ( pvItemToQueue == NULL ) && ( pxQueue->uxItemSize != ( UBaseType_t ) 0U ) ) );
+	configASSERT( !( ( xCopyPosition == queueOVERWRITE ) && ( pxQueue->uxLength != 1 ) ) );
+	configASSERT( !( ( xTaskGetSchedulerState() == taskSCHEDULER_SUSPENDED ) && ( xTicksToWait != 0 ) ) );
+
+	for( ;; )
+	{
+		taskENTER_CRITICAL();
+		{
+			if( ( pxQueue->uxMessagesWaiting < pxQueue->uxLength ) || ( xCopyPosition == queueOVERWRITE ) )
+			{
+				const UBaseType_t uxPreviousMessagesWaiting = pxQueue->uxMessagesWaiting;
+
+				xYieldRequired = prvCopyDataToQueue( pxQueue, pvItemToQueue, xCopyPosition );
+
+				if( prvWakeReader( pxQueue, ( BaseType_t ) uxPreviousMessagesWaiting, xCopyPosition ) != pdFALSE )
+				{
+					queueYIELD_IF_USING_PREEMPTION();
+				}
+				else if( xYieldRequired != pdFALSE )
+				{
+					/* Gave back a mutex with an inherited priority. */
+					queueYIELD_IF_USING_PREEMPTION();
+				}
+
+				taskEXIT_CRITICAL();
+				return pdPASS;
+			}
+			else
+			{
+				if( xTicksToWait == ( TickType_t ) 0 )
+				{
+					taskEXIT_CRITICAL();
+					return errQUEUE_FULL;
+				}
+				else if( xEntryTimeSet == pdFALSE )
+				{
+					vTaskInternalSetTimeOutState( &xTimeOut );
+					xEntryTimeSet = pdTRUE;
+				}
+			}
+		}
+		taskEXIT_CRITICAL();
+
+		vTaskSuspendAll();
+		prvLockQueue( pxQueue );
+
+		if( xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait ) == pdFALSE )
+		{
+			if( prvIsQueueFull( pxQueue ) != pdFALSE )
+			{
+				vTaskPlaceOnEventList( &( pxQueue->xTasksWaitingToSend ), xTicksToWait );
+				prvUnlockQueue( pxQueue );
+
+				if( xTaskResumeAll() == pdFALSE )
+				{
+					portYIELD_WITHIN_API();
+				}
+			}
+			else
+			{
+				prvUnlockQueue( pxQueue );
+				( void ) xTaskResumeAll();
+			}
+		}
+		else
+		{
+			prvUnlockQueue( pxQueue );
+			( void ) xTaskResumeAll();
+
+			return errQUEUE_FULL;
+		}
+	}
+}
+
+BaseType_t xQueueGenericSendFromISR( QueueHandle_t xQueue, const void * const pvItemToQueue, BaseType_t * const pxHigherPriorityTaskWoken, const BaseType_t xCopyPosition )
+{
+	BaseType_t xReturn;
+	UBaseType_t uxSavedInterruptStatus;
+	Queue_t * const pxQueue = xQueue;
+
+	configASSERT( pxQueue );
+	configASSERT( !( ( pvItemToQueue == NULL ) && ( pxQueue->uxItemSize != ( UBaseType_t ) 0U ) ) );
+	configASSERT( !( ( xCopyPosition == queueOVERWRITE ) && ( pxQueue->uxLength != 1 ) ) );
+
+	uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+	{
+		if( ( pxQueue->uxMessagesWaiting < pxQueue->uxLength ) || ( xCopyPosition == queueOVERWRITE ) )
+		{
+			const int8_t cTxLock = pxQueue->cTxLock;
+			const UBaseType_t uxPreviousMessagesWaiting = pxQueue->uxMessagesWaiting;
+
+			( void ) prvCopyDataToQueue( pxQueue, pvItemToQueue, xCopyPosition );
+
+			if( cTxLock == queueUNLOCKED )
+			{
+				if( prvWakeReader( pxQueue, ( BaseType_t ) uxPreviousMessagesWaiting, xCopyPosition ) != pdFALSE )
+				{
+					if( pxHigherPriorityTaskWoken != NULL )
+					{
+						*pxHigherPriorityTaskWoken = pdTRUE;
+					}
+				}
+			}
+			else
+			{
+				/* prvUnlockQueue() does the waking. */
+				pxQueue->cTxLock = ( int8_t ) ( cTxLock + 1 );
+			}
+
+			xReturn = pdPASS;
+		}
+		else
+		{
+			xReturn = errQUEUE_FULL;
+		}
+	}
+	portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+
+	return xReturn;
+}
+
+BaseType_t xQueueGiveFromISR( QueueHandle_t xQueue, BaseType_t * const pxHigherPriorityTaskWoken )
+{
+	return xQueueGenericSendFromISR( xQueue, NULL, pxHigherPriorityTaskWoken, queueSEND_TO_BACK );
+}
+
+/*-----------------------------------------------------------
+ * Receive
+ *----------------------------------------------------------*/
+
+BaseType_t xQueueReceive( QueueHandle_t xQueue, void * const pvBuffer, TickType_t xTicksToWait )
+{
+	BaseType_t xEntryTimeSet = pdFALSE;
+	TimeOut_t xTimeOut;
+	Queue_t * const pxQueue = xQueue;
+
+	configASSERT( pxQueue );
+	configASSERT( !( ( ( pvBuffer ) == NULL ) && ( ( pxQueue )->uxItemSize != ( UBaseType_t ) 0U ) ) );
+	configASSERT( !( ( xTaskGetSchedulerState() == taskSCHEDULER_SUSPENDED ) && ( xTicksToWait != 0 ) ) );
+
+	for( ;; )
+	{
+		taskENTER_CRITICAL();
+		{
+			const UBaseType_t uxMessagesWaiting = pxQueue->uxMessagesWaiting;
+
+			if( uxMessagesWaiting > ( UBaseType_t ) 0 )
+			{
+				prvCopyDataFromQueue( pxQueue, pvBuffer );
+				pxQueue->uxMessagesWaiting = uxMessagesWaiting - ( UBaseType_t ) 1;
+
+				if( listLIST_IS_EMPTY( &( pxQueue->xTasksWaitingToSend ) ) == pdFALSE )
+				{
+					if( xTaskRemoveFromEventList( &( pxQueue->xTasksWaitingToSend ) ) != pdFALSE )
+					{
+						queueYIELD_IF_USING_PREEMPTION();
+					}
+				}
+
+				taskEXIT_CRITICAL();
+				return pdPASS;
+			}
+			else
+			{
+				if( xTicksToWait == ( TickType_t ) 0 )
+				{
+					taskEXIT_CRITICAL();
+					return errQUEUE_EMPTY;
+				}
+				else if( xEntryTimeSet == pdFALSE )
+				{
+					vTaskInternalSetTimeOutState( &xTimeOut );
+					xEntryTimeSet = pdTRUE;
+				}
+			}
+		}
+		taskEXIT_CRITICAL();
+
+		vTaskSuspendAll();
+		prvLockQueue( pxQueue );
+
+		if( xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait ) == pdFALSE )
+		{
+			if( prvIsQueueEmpty( pxQueue ) != pdFALSE )
+			{
+				vTaskPlaceOnEventList( &( pxQueue->xTasksWaitingToReceive ), xTicksToWait );
+				prvUnlockQueue( pxQueue );
+
+				if( xTaskResumeAll() == pdFALSE )
+				{
+					portYIELD_WITHIN_API();
+				}
+			}
+			else
+			{
+				prvUnlockQueue( pxQueue );
+				( void ) xTaskResumeAll();
+			}
+		}
+		else
+		{
+			prvUnlockQueue( pxQueue );
+			( void ) xTaskResumeAll();
+
+			if( prvIsQueueEmpty( pxQueue ) != pdFALSE )
+			{
+				return errQUEUE_EMPTY;
+			}
+		}
+	}
+}
+
+BaseType_t xQueueSemaphoreTake( QueueHandle_t xQueue, TickType_t xTicksToWait )
+{
+	BaseType_t xEntryTimeSet = pdFALSE;
+	TimeOut_t xTimeOut;
+	Queue_t * const pxQueue = xQueue;
+	BaseType_t xInheritanceOccurred = pdFALSE;
+
+	configASSERT( ( pxQueue ) );
+	configASSERT( pxQueue->uxItemSize == 0 );
+	configASSERT( !( ( xTaskGetSchedulerState() == taskSCHEDULER_SUSPENDED ) && ( xTicksToWait != 0 ) ) );
+
+	for( ;; )
+	{
+		taskENTER_CRITICAL();
+		{
+			const UBaseType_t uxSemaphoreCount = pxQueue->uxMessagesWaiting;
+
+			if( uxSemaphoreCount > ( UBaseType_t ) 0 )
+			{
+				pxQueue->uxMessagesWaiting = uxSemaphoreCount - ( UBaseType_t ) 1;
+
+				if( pxQueue->uxQueueType == queueQUEUE_IS_MUTEX )
+				{
+					pxQueue->u.xSemaphore.xMutexHolder = pvTaskIncrementMutexHeldCount();
+				}
+
+				if( listLIST_IS_EMPTY( &( pxQueue->xTasksWaitingToSend ) ) == pdFALSE )
+				{
+					if( xTaskRemoveFromEventList( &( pxQueue->xTasksWaitingToSend ) ) != pdFALSE )
+					{
+						queueYIELD_IF_USING_PREEMPTION();
+					}
+				}
+
+				taskEXIT_CRITICAL();
+				return pdPASS;
+			}
+			else
+			{
+				if( xTicksToWait == ( TickType_t ) 0 )
+				{
+					configASSERT( xInheritanceOccurred == pdFALSE );
+					taskEXIT_CRITICAL();
+					return errQUEUE_EMPTY;
+				}
+				else if( xEntryTimeSet == pdFALSE )
+				{
+					vTaskInternalSetTimeOutState( &xTimeOut );
+					xEntryTimeSet = pdTRUE;
+				}
+			}
+		}
+		taskEXIT_CRITICAL();
+
+		vTaskSuspendAll();
+		prvLockQueue( pxQueue );
+
+		if( xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait ) == pdFALSE )
+		{
+			if( prvIsQueueEmpty( pxQueue ) != pdFALSE )
+			{
+				if( pxQueue->uxQueueType == queueQUEUE_IS_MUTEX )
+				{
+					taskENTER_CRITICAL();
+					{
+						xInheritanceOccurred = xTaskPriorityInherit( pxQueue->u.xSemaphore.xMutexHolder );
+					}
+					taskEXIT_CRITICAL();
+				}
+
+				vTaskPlaceOnEventList( &( pxQueue->xTasksWaitingToReceive ), xTicksToWait );
+				prvUnlockQueue( pxQueue );
+
+				if( xTaskResumeAll() == pdFALSE )
+				{
+					portYIELD_WITHIN_API();
+				}
+			}
+			else
+			{
+				prvUnlockQueue( pxQueue );
+				( void ) xTaskResumeAll();
+			}
+		}
+		else
+		{
+			prvUnlockQueue( pxQueue );
+			( void ) xTaskResumeAll();
+
+			if( prvIsQueueEmpty( pxQueue ) != pdFALSE )
+			{
+				/* Timed out: give back whatever priority was lent. */
+				if( xInheritanceOccurred != pdFALSE )
+				{
+					taskENTER_CRITICAL();
+					{
+						UBaseType_t uxHighestWaitingPriority;
+
+						uxHighestWaitingPriority = prvGetDisinheritPriorityAfterTimeout( pxQueue );
+						vTaskPriorityDisinheritAfterTimeout( pxQueue->u.xSemaphore.xMutexHolder, uxHighestWaitingPriority );
+					}
+					taskEXIT_CRITICAL();
+				}
+
+				return errQUEUE_EMPTY;
+			}
+		}
+	}
+}
+
+BaseType_t xQueuePeek( QueueHandle_t xQueue, void * const pvBuffer, TickType_t xTicksToWait )
+{
+	BaseType_t xEntryTimeSet = pdFALSE;
+	TimeOut_t xTimeOut;
+	int8_t *pcOriginalReadPosition;
+	Queue_t * const pxQueue = xQueue;
+
+	configASSERT( pxQueue );
+	configASSERT( !( ( ( pvBuffer ) == NULL ) && ( ( pxQueue )->uxItemSize != ( UBaseType_t ) 0U ) ) );
+	configASSERT( !( ( xTaskGetSchedulerState() == taskSCHEDULER_SUSPENDED ) && ( xTicksToWait != 0 ) ) );
+
+	for( ;; )
+	{
+		taskENTER_CRITICAL();
+		{
+			const UBaseType_t uxMessagesWaiting = pxQueue->uxMessagesWaiting;
+
+			if( uxMessagesWaiting > ( UBaseType_t ) 0 )
+			{
+				pcOriginalReadPosition = pxQueue->u.xQueue.pcReadFrom;
+				prvCopyDataFromQueue( pxQueue, pvBuffer );
+				pxQueue->u.xQueue.pcReadFrom = pcOriginalReadPosition;
+
+				/* Others waiting to read can have it too. */
+				if( listLIST_IS_EMPTY( &( pxQueue->xTasksWaitingToReceive ) ) == pdFALSE )
+				{
+					if( xTaskRemoveFromEventList( &( pxQueue->xTasksWaitingToReceive ) ) != pdFALSE )
+					{
+						queueYIELD_IF_USING_PREEMPTION();
+					}
+				}
+
+				taskEXIT_CRITICAL();
+				return pdPASS;
+			}
+			else
+			{
+				if( xTicksToWait == ( TickType_t ) 0 )
+				{
+					taskEXIT_CRITICAL();
+					return errQUEUE_EMPTY;
+				}
+				else if( xEntryTimeSet == pdFALSE )
+				{
+					vTaskInternalSetTimeOutState( &xTimeOut );
+					xEntryTimeSet = pdTRUE;
+				}
+			}
+		}
+		taskEXIT_CRITICAL();
+
+		vTaskSuspendAll();
+		prvLockQueue( pxQueue );
+
+		if( xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait ) == pdFALSE )
+		{
+			if( prvIsQueueEmpty( pxQueue ) != pdFALSE )
+			{
+				vTaskPlaceOnEventList( &( pxQueue->xTasksWaitingToReceive ), xTicksToWait );
+				prvUnlockQueue( pxQueue );
+
+				if( xTaskResumeAll() == pdFALSE )
+				{
+					portYIELD_WITHIN_API();
+				}
+			}
+			else
+			{
+				prvUnlockQueue( pxQueue );
+				( void ) xTaskResumeAll();
+			}
+		}
+		else
+		{
+			prvUnlockQueue( pxQueue );
+			( void ) xTaskResumeAll();
+
+			if( prvIsQueueEmpty( pxQueue ) != pdFALSE )
+			{
+				return errQUEUE_EMPTY;
+			}
+		}
+	}
+}
+
+BaseType_t xQueueReceiveFromISR( QueueHandle_t xQueue, void * const pvBuffer, BaseType_t * const pxHigherPriorityTaskWoken )
+{
+	BaseType_t xReturn;
+	UBaseType_t uxSavedInterruptStatus;
+	Queue_t * const pxQueue = xQueue;
+
+	configASSERT( pxQueue );
+	configASSERT( !( ( pvBuffer == NULL ) && ( pxQueue->uxItemSize != ( UBaseType_t ) 0U ) ) );
+
+	uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+	{
+		const UBaseType_t uxMessagesWaiting = pxQueue->uxMessagesWaiting;
+
+		if( uxMessagesWaiting > ( UBaseType_t ) 0 )
+		{
+			const int8_t cRxLock = pxQueue->cRxLock;
+
+			prvCopyDataFromQueue( pxQueue, pvBuffer );
+			pxQueue->uxMessagesWaiting = uxMessagesWaiting - ( UBaseType_t ) 1;
+
+			if( cRxLock == queueUNLOCKED )
+			{
+				if( listLIST_IS_EMPTY( &( pxQueue->xTasksWaitingToSend ) ) == pdFALSE )
+				{
+					if( xTaskRemoveFromEventList( &( pxQueue->xTasksWaitingToSend ) ) != pdFALSE )
+					{
+						if( pxHigherPriorityTaskWoken != NULL )
+						{
+							*pxHigherPriorityTaskWoken = pdTRUE;
+						}
+					}
+				}
+			}
+			else
+			{
+				pxQueue->cRxLock = ( int8_t ) ( cRxLock + 1 );
+			}
+
+			xReturn = pdPASS;
+		}
+		else
+		{
+			xReturn = pdFAIL;
+		}
+	}
+	portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+
+	return xReturn;
+}
+
+BaseType_t xQueuePeekFromISR( QueueHandle_t xQueue, void * const pvBuffer )
+{
+	BaseType_t xReturn;
+	UBaseType_t uxSavedInterruptStatus;
+	int8_t *pcOriginalReadPosition;
+	Queue_t * const pxQueue = xQueue;
+
+	configASSERT( pxQueue );
+	configASSERT( pxQueue->uxItemSize != 0 );
+
+	uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+	{
+		if( pxQueue->uxMessagesWaiting > ( UBaseType_t ) 0 )
+		{
+			pcOriginalReadPosition = pxQueue->u.xQueue.pcReadFrom;
+			prvCopyDataFromQueue( pxQueue, pvBuffer );
+			pxQueue->u.xQueue.pcReadFrom = pcOriginalReadPosition;
+
+			xReturn = pdPASS;
+		}
+		else
+		{
+			xReturn = pdFAIL;
+		}
+	}
+	portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+
+	return xReturn;
+}
+
+/*-----------------------------------------------------------
+ * Queue state
+ *----------------------------------------------------------*/
+
+UBaseType_t uxQueueMessagesWaiting( const QueueHandle_t xQueue )
+{
+	UBaseType_t uxReturn;
+
+	configASSERT( xQueue );
+
+	taskENTER_CRITICAL();
+	{
+		uxReturn = ( ( Queue_t * ) xQueue )->uxMessagesWaiting;
+	}
+	taskEXIT_CRITICAL();
+
+	return uxReturn;
+}
+
+UBaseType_t uxQueueSpacesAvailable( const QueueHandle_t xQueue )
+{
+	UBaseType_t uxReturn;
+	Queue_t * const pxQueue = xQueue;
+
+	configASSERT( pxQueue );
+
+	taskENTER_CRITICAL();
+	{
+		uxReturn = pxQueue->uxLength - pxQueue->uxMessagesWaiting;
+	}
+	taskEXIT_CRITICAL();
+
+	return uxReturn;
+}
+
+UBaseType_t uxQueueMessagesWaitingFromISR( const QueueHandle_t xQueue )
+{
+	configASSERT( xQueue );
+
+	return ( ( Queue_t * ) xQueue )->uxMessagesWaiting;
+}
+
+UBaseType_t uxQueueSpacesAvailableFromISR( const QueueHandle_t xQueue )
+{
+	Queue_t * const pxQueue = xQueue;
+
+	configASSERT( pxQueue );
+
+	return pxQueue->uxLength - pxQueue->uxMessagesWaiting;
+}
+
+UBaseType_t uxQueueGetNumberOfTasksWaitingToReceive( const QueueHandle_t xQueue )
+{
+	UBaseType_t uxReturn;
+
+	configASSERT( xQueue );
+
+	taskENTER_CRITICAL();
+	{
+		uxReturn = listCURRENT_LIST_LENGTH( &( ( Queue_t * ) xQueue )->xTasksWaitingToReceive );
+	}
+	taskEXIT_CRITICAL();
+
+	return uxReturn;
+}
+
+UBaseType_t uxQueueGetNumberOfTasksWaitingToReceiveFromISR( const QueueHandle_t xQueue )
+{
+	configASSERT( xQueue );
+
+	return listCURRENT_LIST_LENGTH( &( ( Queue_t * ) xQueue )->xTasksWaitingToReceive );
+}
+
+BaseType_t xQueueIsQueueEmptyFromISR( const QueueHandle_t xQueue )
+{
+	configASSERT( xQueue );
+
+	return ( ( Queue_t * ) xQueue )->uxMessagesWaiting == ( UBaseType_t ) 0 ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xQueueIsQueueFullFromISR( const QueueHandle_t xQueue )
+{
+	configASSERT( xQueue );
+
+	return ( ( Queue_t * ) xQueue )->uxMessagesWaiting == ( ( Queue_t * ) xQueue )->uxLength ? pdTRUE : pdFALSE;
+}
+
+UBaseType_t uxQueueGetQueueNumber( QueueHandle_t xQueue )
+{
+	return ( ( Queue_t * ) xQueue )->uxQueueNumber;
+}
+
+void vQueueSetQueueNumber( QueueHandle_t xQueue, UBaseType_t uxQueueNumber )
+{
+	( ( Queue_t * ) xQueue )->uxQueueNumber = uxQueueNumber;
+}
+
+uint8_t ucQueueGetQueueType( QueueHandle_t xQueue )
+{
+	return ( ( Queue_t * ) xQueue )->ucQueueType;
+}
+
+/* For the timer task: block on a queue without the scheduler's help. */
+void vQueueWaitForMessageRestricted( QueueHandle_t xQueue, TickType_t xTicksToWait, const BaseType_t xWaitIndefinitely )
+{
+	Queue_t * const pxQueue = xQueue;
+
+	prvLockQueue( pxQueue );
+	if( pxQueue->uxMessagesWaiting == ( UBaseType_t ) 0U )
+	{
+		vTaskPlaceOnEventListRestricted( &( pxQueue->xTasksWaitingToReceive ), xTicksToWait, xWaitIndefinitely );
+	}
+	prvUnlockQueue( pxQueue );
+}
+
+/*-----------------------------------------------------------
+ * Queue sets
+ *----------------------------------------------------------*/
+
+QueueSetHandle_t xQueueCreateSet( const UBaseType_t uxEventQueueLength )
+{
+	return xQueueGenericCreate( uxEventQueueLength, ( UBaseType_t ) sizeof( Queue_t * ), queueQUEUE_TYPE_SET );
+}
+
+BaseType_t queue_insert_set( QueueSetMemberHandle_t xQueueOrSemaphore, QueueSetHandle_t xQueueSet )
+{
+	BaseType_t xReturn;
+
+	taskENTER_CRITICAL();
+	{
+		if( ( ( Queue_t * ) xQueueOrSemaphore )->pxQueueSetContainer != NULL )
+		{
+			xReturn = pdFAIL;
+		}
+		else
+		{
+			( ( Queue_t * ) xQueueOrSemaphore )->pxQueueSetContainer = xQueueSet;
+			xReturn = pdPASS;
+		}
+	}
+	taskEXIT_CRITICAL();
+
+	return xReturn;
+}
+
+BaseType_t xQueueAddToSet( QueueSetMemberHandle_t xQueueOrSemaphore, QueueSetHandle_t xQueueSet )
+{
+	/* Items already in the queue would never be reported. */
+	if( ( ( Queue_t * ) xQueueOrSemaphore )->uxMessagesWaiting != ( UBaseType_t ) 0 )
+	{
+		return pdFAIL;
+	}
+
+	return queue_insert_set( xQueueOrSemaphore, xQueueSet );
+}
+
+BaseType_t queue_remove_set( QueueSetMemberHandle_t xQueueOrSemaphore, QueueSetHandle_t xQueueSet )
+{
+	BaseType_t xReturn;
+	Queue_t * const pxQueueOrSemaphore = ( Queue_t * ) xQueueOrSemaphore;
+
+	taskENTER_CRITICAL();
+	{
+		if( pxQueueOrSemaphore->pxQueueSetContainer != xQueueSet )
+		{
+			xReturn = pdFAIL;
+		}
+		else
+		{
+			pxQueueOrSemaphore->pxQueueSetContainer = NULL;
+			xReturn = pdPASS;
+		}
+	}
+	taskEXIT_CRITICAL();
+
+	return xReturn;
+}
+
+BaseType_t xQueueRemoveFromSet( QueueSetMemberHandle_t xQueueOrSemaphore, QueueSetHandle_t xQueueSet )
+{
+	/* The set still holds events for the items in the queue. */
+	if( ( ( Queue_t * ) xQueueOrSemaphore )->uxMessagesWaiting != ( UBaseType_t ) 0 )
+	{
+		return pdFAIL;
+	}
+
+	return queue_remove_set( xQueueOrSemaphore, xQueueSet );
+}
+
+QueueSetMemberHandle_t xQueueSelectFromSet( QueueSetHandle_t xQueueSet, TickType_t const xTicksToWait )
+{
+	QueueSetMemberHandle_t xReturn = NULL;
+
+	( void ) xQueueReceive( ( QueueHandle_t ) xQueueSet, &xReturn, xTicksToWait );
+
+	return xReturn;
+}
+
+QueueSetMemberHandle_t xQueueSelectFromSetFromISR( QueueSetHandle_t xQueueSet )
+{
+	QueueSetMemberHandle_t xReturn = NULL;
+
+	( void ) xQueueReceiveFromISR( ( QueueHandle_t ) xQueueSet, &xReturn, NULL );
+
+	return xReturn;
+}
+
+/* Called in a critical section. */
+static BaseType_t prvNotifyQueueSetContainer( const Queue_t * const pxQueue )
+{
+	Queue_t *pxQueueSetContainer = pxQueue->pxQueueSetContainer;
+	BaseType_t xReturn = pdFALSE;
+
+	configASSERT( pxQueueSetContainer );
+
+	/*
+	 * A full set already has a reader to wake; with queue_insert_set()
+	 * members it may be a little behind, so do not assert on it.
+	 */
+	if( pxQueueSetContainer->uxMessagesWaiting < pxQueueSetContainer->uxLength )
+	{
+		const int8_t cTxLock = pxQueueSetContainer->cTxLock;
+
+		xReturn = prvCopyDataToQueue( pxQueueSetContainer, &pxQueue, queueSEND_TO_BACK );
+
+		if( cTxLock == queueUNLOCKED )
+		{
+			if( listLIST_IS_EMPTY( &( pxQueueSetContainer->xTasksWaitingToReceive ) ) == pdFALSE )
+			{
+				if( xTaskRemoveFromEventList( &( pxQueueSetContainer->xTasksWaitingToReceive ) ) != pdFALSE )
+				{
+					xReturn = pdTRUE;
+				}
+			}
+		}
+		else
+		{
+			pxQueueSetContainer->cTxLock = ( int8_t ) ( cTxLock + 1 );
+		}
+	}
+
+	return xReturn;
+}
+
+/*-----------------------------------------------------------
+ * Internals
+ *----------------------------------------------------------*/
+
+static UBaseType_t prvGetDisinheritPriorityAfterTimeout( const Queue_t * const pxQueue )
+{
+	if( listCURRENT_LIST_LENGTH( &( pxQueue->xTasksWaitingToReceive ) ) > 0U )
+	{
+		return ( UBaseType_t ) configMAX_PRIORITIES - ( UBaseType_t ) listGET_ITEM_VALUE_OF_HEAD_ENTRY( &( pxQueue->xTasksWaitingToReceive ) );
+	}
+
+	return tskIDLE_PRIORITY;
+}
+
+static BaseType_t prvCopyDataToQueue( Queue_t * const pxQueue, const void *pvItemToQueue, const BaseType_t xPosition )
+{
+	BaseType_t xReturn = pdFALSE;
+	UBaseType_t uxMessagesWaiting;
+
+	uxMessagesWaiting = pxQueue->uxMessagesWaiting;
+
+	if( pxQueue->uxItemSize == ( UBaseType_t ) 0 )
+	{
+		if( pxQueue->uxQueueType == queueQUEUE_IS_MUTEX )
+		{
+			xReturn = xTaskPriorityDisinherit( pxQueue->u.xSemaphore.xMutexHolder );
+			pxQueue->u.xSemaphore.xMutexHolder = NULL;
+		}
+	}
+	else if( xPosition == queueSEND_TO_BACK )
+	{
+		( void ) memcpy( ( void * ) pxQueue->pcWriteTo, pvItemToQueue, ( size_t ) pxQueue->uxItemSize );
+		pxQueue->pcWriteTo += pxQueue->uxItemSize;
+		if( pxQueue->pcWriteTo >= pxQueue->u.xQueue.pcTail )
+		{
+			pxQueue->pcWriteTo = pxQueue->pcHead;
+		}
+	}
+	else
+	{
+		( void ) memcpy( ( void * ) pxQueue->u.xQueue.pcReadFrom, pvItemToQueue, ( size_t ) pxQueue->uxItemSize );
+		pxQueue->u.xQueue.pcReadFrom -= pxQueue->uxItemSize;
+		if( pxQueue->u.xQueue.pcReadFrom < pxQueue->pcHead )
+		{
+			pxQueue->u.xQueue.pcReadFrom = ( pxQueue->u.xQueue.pcTail - pxQueue->uxItemSize );
+		}
+
+		if( xPosition == queueOVERWRITE )
+		{
+			if( uxMessagesWaiting > ( UBaseType_t ) 0 )
+			{
+				/* One in, one out. */
+				--uxMessagesWaiting;
+			}
+		}
+	}
+
+	pxQueue->uxMessagesWaiting = uxMessagesWaiting + ( UBaseType_t ) 1;
+
+	return xReturn;
+}
+
+static void prvCopyDataFromQueue( Queue_t * const pxQueue, void * const pvBuffer )
+{
+	if( pxQueue->uxItemSize != ( UBaseType_t ) 0 )
+	{
+		pxQueue->u.xQueue.pcReadFrom += pxQueue->uxItemSize;
+		if( pxQueue->u.xQueue.pcReadFrom >= pxQueue->u.xQueue.pcTail )
+		{
+			pxQueue->u.xQueue.pcReadFrom = pxQueue->pcHead;
+		}
+		( void ) memcpy( ( void * ) pvBuffer, ( void * ) pxQueue->u.xQueue.pcReadFrom, ( size_t ) pxQueue->uxItemSize );
+	}
+}
+
+/* Catch up with what ISRs did to the queue while it was locked. */
+static void prvUnlockQueue( Queue_t * const pxQueue )
+{
+	taskENTER_CRITICAL();
+	{
+		int8_t cTxLock = pxQueue->cTxLock;
+
+		while( cTxLock > queueLOCKED_UNMODIFIED )
+		{
+			if( pxQueue->pxQueueSetContainer != NULL )
+			{
+				if( prvNotifyQueueSetContainer( pxQueue ) != pdFALSE )
+				{
+					vTaskMissedYield();
+				}
+			}
+			else
+			{
+				if( listLIST_IS_EMPTY( &( pxQueue->xTasksWaitingToReceive ) ) == pdFALSE )
+				{
+					if( xTaskRemoveFromEventList( &( pxQueue->xTasksWaitingToReceive ) ) != pdFALSE )
+					{
+						vTaskMissedYield();
+					}
+				}
+				else
+				{
+					break;
+				}
+			}
+
+			--cTxLock;
+		}
+
+		pxQueue->cTxLock = queueUNLOCKED;
+	}
+	taskEXIT_CRITICAL();
+
+	taskENTER_CRITICAL();
+	{
+		int8_t cRxLock = pxQueue->cRxLock;
+
+		while( cRxLock > queueLOCKED_UNMODIFIED )
+		{
+			if( listLIST_IS_EMPTY( &( pxQueue->xTasksWaitingToSend ) ) == pdFALSE )
+			{
+				if( xTaskRemoveFromEventList( &( pxQueue->xTasksWaitingToSend ) ) != pdFALSE )
+				{
+					vTaskMissedYield();
+				}
+
+				--cRxLock;
+			}
+			else
+			{
+				break;
+			}
+		}
+
+		pxQueue->cRxLock = queueUNLOCKED;
+	}
+	taskEXIT_CRITICAL();
+}
+
+static BaseType_t prvIsQueueEmpty( const Queue_t *pxQueue )
+{
+	BaseType_t xReturn;
+
+	taskENTER_CRITICAL();
+	{
+		xReturn = ( pxQueue->uxMessagesWaiting == ( UBaseType_t ) 0 ) ? pdTRUE : pdFALSE;
+	}
+	taskEXIT_CRITICAL();
+
+	return xReturn;
+}
+
+static BaseType_t prvIsQueueFull( const Queue_t *pxQueue )
+{
+	BaseType_t xReturn;
+
+	taskENTER_CRITICAL();
+	{
+		xReturn = ( pxQueue->uxMessagesWaiting == pxQueue->uxLength ) ? pdTRUE : pdFALSE;
+	}
+	taskEXIT_CRITICAL();
+
+	return xReturn;
+}
@@ -0,0 +1,2025 @@
+/*
+ * Copyright 2024-2024 Senscomm Semiconductor Co., Ltd.	All rights reserved.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Sandbox FreeRTOS kernel: tasks.
+ *
+ * On the target, the FreeRTOS kernel lives in ROM and prebuilt/. The
+ * sandbox has neither, so this directory provides the part of the
+ * V10.2.1 kernel API the tree uses, on top of the sandbox port
+ * (hal/soc/sandbox/freertos). It keeps the FreeRTOS data structures
+ * and scheduling rules: fixed priority preemption, round robin among
+ * equal priorities on the tick, priority inheritance for mutexes, and
+ * a per task errno (configUSE_POSIX_ERRNO).
+ *
+ * What it does not have: MPU wrappers, tickless idle, co-routines,
+ * trace hooks and the task list formatting helpers.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "timers.h"
+
+#include <hal/compiler.h>
+
+#define tskSTACK_FILL_BYTE		( 0xa5U )
+
+#define taskNOT_WAITING_NOTIFICATION	( ( uint8_t ) 0 )
+#define taskWAITING_NOTIFICATION	( ( uint8_t ) 1 )
+#define taskNOTIFICATION_RECEIVED	( ( uint8_t ) 2 )
+
+#define taskEVENT_LIST_ITEM_VALUE_IN_USE	0x80000000UL
+
+#define tskDYNAMICALLY_ALLOCATED_STACK_AND_TCB	( ( uint8_t ) 0 )
+#define tskSTATICALLY_ALLOCATED_STACK_AND_TCB	( ( uint8_t ) 2 )
+
+/* The layout must match StaticTask_t. */
+typedef struct tskTaskControlBlock
+{
+	volatile StackType_t *pxTopOfStack;	/* The port keeps its thread here. */
+	ListItem_t xStateListItem;
+	ListItem_t xEventListItem;
+	UBaseType_t uxPriority;
+	StackType_t *pxStack;
+	char pcTaskName[ configMAX_TASK_NAME_LEN ];
+	StackType_t *pxEndOfStack;
+	UBaseType_t uxCriticalNesting;
+	UBaseType_t uxTCBNumber;
+	UBaseType_t uxTaskNumber;
+	UBaseType_t uxBasePriority;
+	UBaseType_t uxMutexesHeld;
+	uint32_t ulRunTimeCounter;
+	volatile uint32_t ulNotifiedValue;
+	volatile uint8_t ucNotifyState;
+	uint8_t ucStaticallyAllocated;
+	uint8_t ucDelayAborted;
+	int iTaskErrno;
+	void *pvThreadLocalStoragePointers[ configNUM_THREAD_LOCAL_STORAGE_POINTERS ];
+	TlsDeleteCallbackFunction_t pvThreadLocalStoragePointersDelCallback[ configNUM_THREAD_LOCAL_STORAGE_POINTERS ];
+} tskTCB;
+
+typedef tskTCB TCB_t;
+
+PRIVILEGED_DATA TCB_t * volatile pxCurrentTCB = NULL;
+
+/* configUSE_POSIX_ERRNO: swapped in and out with the task. */
+int FreeRTOS_errno = 0;
+
+PRIVILEGED_DATA static List_t pxReadyTasksLists[ configMAX_PRIORITIES ];
+PRIVILEGED_DATA static List_t xDelayedTaskList1;
+PRIVILEGED_DATA static List_t xDelayedTaskList2;
+PRIVILEGED_DATA static List_t * volatile pxDelayedTaskList;
+PRIVILEGED_DATA static List_t * volatile pxOverflowDelayedTaskList;
+PRIVILEGED_DATA static List_t xPendingReadyList;
+PRIVILEGED_DATA static List_t xTasksWaitingTermination;
+PRIVILEGED_DATA static volatile UBaseType_t uxDeletedTasksWaitingCleanUp = ( UBaseType_t ) 0U;
+PRIVILEGED_DATA static List_t xSuspendedTaskList;
+
+PRIVILEGED_DATA static volatile UBaseType_t uxCurrentNumberOfTasks = ( UBaseType_t ) 0U;
+PRIVILEGED_DATA static volatile TickType_t xTickCount = ( TickType_t ) 0U;
+PRIVILEGED_DATA static volatile UBaseType_t uxTopReadyPriority = tskIDLE_PRIORITY;
+PRIVILEGED_DATA static volatile BaseType_t xSchedulerRunning = pdFALSE;
+PRIVILEGED_DATA static volatile UBaseType_t uxPendedTicks = ( UBaseType_t ) 0U;
+PRIVILEGED_DATA static volatile BaseType_t xYieldPending = pdFALSE;
+PRIVILEGED_DATA static volatile BaseType_t xNumOfOverflows = ( BaseType_t ) 0;
+PRIVILEGED_DATA static UBaseType_t uxTaskNumber = ( UBaseType_t ) 0U;
+PRIVILEGED_DATA static volatile TickType_t xNextTaskUnblockTime = ( TickType_t ) 0U;
+PRIVILEGED_DATA static TaskHandle_t xIdleTaskHandle = NULL;
+PRIVILEGED_DATA static volatile UBaseType_t uxSchedulerSuspended = ( UBaseType_t ) pdFALSE;
+
+PRIVILEGED_DATA static uint32_t ulTaskSwitchedInTime = 0UL;
+PRIVILEGED_DATA static uint32_t ulTotalRunTime = 0UL;
+
+#define prvGetTCBFromHandle( pxHandle ) ( ( ( pxHandle ) == NULL ) ? pxCurrentTCB : ( pxHandle ) )
+
+#if ( configUSE_PORT_OPTIMISED_TASK_SELECTION == 0 )
+
+#define taskRECORD_READY_PRIORITY( uxPriority )						\
+	do {										\
+		if( ( uxPriority ) > uxTopReadyPriority )				\
+			uxTopReadyPriority = ( uxPriority );				\
+	} while( 0 )
+
+#define taskSELECT_HIGHEST_PRIORITY( uxTopPriority )					\
+	do {										\
+		uxTopPriority = uxTopReadyPriority;					\
+		while( listLIST_IS_EMPTY( &( pxReadyTasksLists[ uxTopPriority ] ) ) )	\
+		{									\
+			configASSERT( uxTopPriority );					\
+			--uxTopPriority;						\
+		}									\
+		uxTopReadyPriority = uxTopPriority;					\
+	} while( 0 )
+
+/* uxTopReadyPriority only ever goes down when a task is selected. */
+#define taskRESET_READY_PRIORITY( uxPriority )
+#define portRESET_READY_PRIORITY( uxPriority, uxTopReadyPriority )
+
+#else
+
+#define taskRECORD_READY_PRIORITY( uxPriority )	portRECORD_READY_PRIORITY( uxPriority, uxTopReadyPriority )
+
+#define taskSELECT_HIGHEST_PRIORITY( uxTopPriority )	portGET_HIGHEST_PRIORITY( uxTopPriority, uxTopReadyPriority )
+
+#define taskRESET_READY_PRIORITY( uxPriority )						\
+	do {										\
+		if( listCURRENT_LIST_LENGTH( &( pxReadyTasksLists[ ( uxPriority ) ] ) ) == ( UBaseType_t ) 0 ) \
+			portRESET_READY_PRIORITY( ( uxPriority ), ( uxTopReadyPriority ) ); \
+	} while( 0 )
+
+#endif
+
+#define prvAddTaskToReadyList( pxTCB )							\
+	do {										\
+		taskRECORD_READY_PRIORITY( ( pxTCB )->uxPriority );			\
+		vListInsertEnd( &( pxReadyTasksLists[ ( pxTCB )->uxPriority ] ), &( ( pxTCB )->xStateListItem ) ); \
+	} while( 0 )
+
+#define taskSWITCH_DELAYED_LISTS()							\
+	do {										\
+		List_t *pxTemp;								\
+		configASSERT( ( listLIST_IS_EMPTY( pxDelayedTaskList ) ) );		\
+		pxTemp = pxDelayedTaskList;						\
+		pxDelayedTaskList = pxOverflowDelayedTaskList;				\
+		pxOverflowDelayedTaskList = pxTemp;					\
+		xNumOfOverflows++;							\
+		prvResetNextTaskUnblockTime();						\
+	} while( 0 )
+
+#if( configUSE_PREEMPTION == 0 )
+	#define taskYIELD_IF_USING_PREEMPTION()
+#else
+	#define taskYIELD_IF_USING_PREEMPTION() portYIELD_WITHIN_API()
+#endif
+
+static portTASK_FUNCTION_PROTO( prvIdleTask, pvParameters );
+static void prvResetNextTaskUnblockTime( void );
+static void prvAddCurrentTaskToDelayedList( TickType_t xTicksToWait, const BaseType_t xCanBlockIndefinitely );
+
+/*-----------------------------------------------------------
+ * Critical sections (portCRITICAL_NESTING_IN_TCB)
+ *----------------------------------------------------------*/
+
+void vTaskEnterCritical( void )
+{
+	portDISABLE_INTERRUPTS();
+
+	if( xSchedulerRunning != pdFALSE )
+	{
+		( pxCurrentTCB->uxCriticalNesting )++;
+	}
+}
+
+void vTaskExitCritical( void )
+{
+	if( xSchedulerRunning != pdFALSE )
+	{
+		if( pxCurrentTCB->uxCriticalNesting > 0U )
+		{
+			( pxCurrentTCB->uxCriticalNesting )--;
+
+			if( pxCurrentTCB->uxCriticalNesting == 0U )
+			{
+				portENABLE_INTERRUPTS();
+			}
+		}
+	}
+}
+
+/*-----------------------------------------------------------
+ * Task creation and deletion
+ *----------------------------------------------------------*/
+
+static void prvInitialiseTaskLists( void )
+{
+	UBaseType_t uxPriority;
+
+	for( uxPriority = ( UBaseType_t ) 0U; uxPriority < ( UBaseType_t ) configMAX_PRIORITIES; uxPriority++ )
+	{
+		vListInitialise( &( pxReadyTasksLists[ uxPriority ] ) );
+	}
+
+	vListInitialise( &xDelayedTaskList1 );
+	vListInitialise( &xDelayedTaskList2 );
+	vListInitialise( &xPendingReadyList );
+	vListInitialise( &xTasksWaitingTermination );
+	vListInitialise( &xSuspendedTaskList );
+
+	pxDelayedTaskList = &xDelayedTaskList1;
+	pxOverflowDelayedTaskList = &xDelayedTaskList2;
+}
+
+static void prvInitialiseNewTask( TaskFunction_t pxTaskCode,
+				  const char * const pcName,
+				  const uint32_t ulStackDepth,
+				  void * const pvParameters,
+				  UBaseType_t uxPriority,
+				  TaskHandle_t * const pxCreatedTask,
+				  TCB_t *pxNewTCB )
+{
+	StackType_t *pxTopOfStack;
+	UBaseType_t x;
+
+	( void ) memset( pxNewTCB->pxStack, ( int ) tskSTACK_FILL_BYTE, ( size_t ) ulStackDepth * sizeof( StackType_t ) );
+
+	pxTopOfStack = &( pxNewTCB->pxStack[ ulStackDepth - ( uint32_t ) 1 ] );
+	pxTopOfStack = ( StackType_t * ) ( ( ( portPOINTER_SIZE_TYPE ) pxTopOfStack ) & ( ~( ( portPOINTER_SIZE_TYPE ) portBYTE_ALIGNMENT_MASK ) ) );
+	pxNewTCB->pxEndOfStack = pxTopOfStack;
+
+	if( pcName != NULL )
+	{
+		for( x = ( UBaseType_t ) 0; x < ( UBaseType_t ) configMAX_TASK_NAME_LEN; x++ )
+		{
+			pxNewTCB->pcTaskName[ x ] = pcName[ x ];
+
+			if( pcName[ x ] == ( char ) 0x00 )
+			{
+				break;
+			}
+		}
+
+		pxNewTCB->pcTaskName[ configMAX_TASK_NAME_LEN - 1 ] = '\0';
+	}
+	else
+	{
+		pxNewTCB->pcTaskName[ 0 ] = 0x00;
+	}
+
+	if( uxPriority >= ( UBaseType_t ) configMAX_PRIORITIES )
+	{
+		uxPriority = ( UBaseType_t ) configMAX_PRIORITIES - ( UBaseType_t ) 1U;
+	}
+
+	pxNewTCB->uxPriority = uxPriority;
+	pxNewTCB->uxBasePriority = uxPriority;
+	pxNewTCB->uxMutexesHeld = 0;
+
+	vListInitialiseItem( &( pxNewTCB->xStateListItem ) );
+	vListInitialiseItem( &( pxNewTCB->xEventListItem ) );
+
+	listSET_LIST_ITEM_OWNER( &( pxNewTCB->xStateListItem ), pxNewTCB );
+	listSET_LIST_ITEM_VALUE( &( pxNewTCB->xEventListItem ), ( TickType_t ) configMAX_PRIORITIES - ( TickType_t ) uxPriority );
+	listSET_LIST_ITEM_OWNER( &( pxNewTCB->xEventListItem ), pxNewTCB );
+
+	pxNewTCB->uxCriticalNesting = ( UBaseType_t ) 0U;
+	pxNewTCB->ulRunTimeCounter = 0UL;
+	pxNewTCB->ulNotifiedValue = 0;
+	pxNewTCB->ucNotifyState = taskNOT_WAITING_NOTIFICATION;
+	pxNewTCB->ucDelayAborted = pdFALSE;
+	pxNewTCB->iTaskErrno = 0;
+
+	for( x = 0; x < ( UBaseType_t ) configNUM_THREAD_LOCAL_STORAGE_POINTERS; x++ )
+	{
+		pxNewTCB->pvThreadLocalStoragePointers[ x ] = NULL;
+		pxNewTCB->pvThreadLocalStoragePointersDelCallback[ x ] = NULL;
+	}
+
+	pxNewTCB->pxTopOfStack = pxPortInitialiseStack( pxTopOfStack, pxTaskCode, pvParameters );
+
+	if( pxCreatedTask != NULL )
+	{
+		*pxCreatedTask = ( TaskHandle_t ) pxNewTCB;
+	}
+}
+
+static void prvAddNewTaskToReadyList( TCB_t *pxNewTCB )
+{
+	taskENTER_CRITICAL();
+	{
+		uxCurrentNumberOfTasks++;
+
+		if( pxCurrentTCB == NULL )
+		{
+			pxCurrentTCB = pxNewTCB;
+
+			if( uxCurrentNumberOfTasks == ( UBaseType_t ) 1 )
+			{
+				prvInitialiseTaskLists();
+			}
+		}
+		else if( xSchedulerRunning == pdFALSE )
+		{
+			if( pxCurrentTCB->uxPriority <= pxNewTCB->uxPriority )
+			{
+				pxCurrentTCB = pxNewTCB;
+			}
+		}
+
+		uxTaskNumber++;
+		pxNewTCB->uxTCBNumber = uxTaskNumber;
+
+		prvAddTaskToReadyList( pxNewTCB );
+	}
+	taskEXIT_CRITICAL();
+
+	if( xSchedulerRunning != pdFALSE )
+	{
+		if( pxCurrentTCB->uxPriority < pxNewTCB->uxPriority )
+		{
+			taskYIELD_IF_USING_PREEMPTION();
+		}
+	}
+}
+
+BaseType_t xTaskCreate( TaskFunction_t pxTaskCode,
+			const char * const pcName,
+			const configSTACK_DEPTH_TYPE usStackDepth,
+			void * const pvParameters,
+			UBaseType_t uxPriority,
+			TaskHandle_t * const pxCreatedTask )
+{
+	TCB_t *pxNewTCB;
+	StackType_t *pxStack;
+
+	pxStack = pvPortMalloc( ( ( ( size_t ) usStackDepth ) * sizeof( StackType_t ) ) );
+	if( pxStack == NULL )
+	{
+		return errCOULD_NOT_ALLOCATE_REQUIRED_MEMORY;
+	}
+
+	pxNewTCB = pvPortMalloc( sizeof( TCB_t ) );
+	if( pxNewTCB == NULL )
+	{
+		vPortFree( pxStack );
+		return errCOULD_NOT_ALLOCATE_REQUIRED_MEMORY;
+	}
+
+	pxNewTCB->pxStack = pxStack;
+	pxNewTCB->ucStaticallyAllocated = tskDYNAMICALLY_ALLOCATED_STACK_AND_TCB;
+
+	prvInitialiseNewTask( pxTaskCode, pcName, ( uint32_t ) usStackDepth, pvParameters, uxPriority, pxCreatedTask, pxNewTCB );
+	prvAddNewTaskToReadyList( pxNewTCB );
+
+	return pdPASS;
+}
+
+TaskHandle_t xTaskCreateStatic( TaskFunction_t pxTaskCode,
+				const char * const pcName,
+				const uint32_t ulStackDepth,
+				void * const pvParameters,
+				UBaseType_t uxPriority,
+				StackType_t * const puxStackBuffer,
+				StaticTask_t * const pxTaskBuffer )
+{
+	TCB_t *pxNewTCB;
+	TaskHandle_t xReturn = NULL;
+
+	configASSERT( sizeof( StaticTask_t ) == sizeof( TCB_t ) );
+
+	if( ( pxTaskBuffer != NULL ) && ( puxStackBuffer != NULL ) )
+	{
+		pxNewTCB = ( TCB_t * ) pxTaskBuffer;
+		pxNewTCB->pxStack = ( StackType_t * ) puxStackBuffer;
+		pxNewTCB->ucStaticallyAllocated = tskSTATICALLY_ALLOCATED_STACK_AND_TCB;
+
+		prvInitialiseNewTask( pxTaskCode, pcName, ulStackDepth, pvParameters, uxPriority, &xReturn, pxNewTCB );
+		prvAddNewTaskToReadyList( pxNewTCB );
+	}
+
+	return xReturn;
+}
+
+static void prvDeleteTCB( TCB_t *pxTCB )
+{
+	UBaseType_t x;
+
+	for( x = 0; x < ( UBaseType_t ) configNUM_THREAD_LOCAL_STORAGE_POINTERS; x++ )
+	{
+		if( pxTCB->pvThreadLocalStoragePointersDelCallback[ x ] != NULL )
+		{
+			pxTCB->pvThreadLocalStoragePointersDelCallback[ x ]( ( int ) x, pxTCB->pvThreadLocalStoragePointers[ x ] );
+		}
+	}
+
+	portCLEAN_UP_TCB( pxTCB );
+
+	if( pxTCB->ucStaticallyAllocated == tskDYNAMICALLY_ALLOCATED_STACK_AND_TCB )
+	{
+		vPortFree( pxTCB->pxStack );
+		vPortFree( pxTCB );
+	}
+}
+
+static void prvCheckTasksWaitingTermination( void )
+{
+	TCB_t *pxTCB;
+
+	while( uxDeletedTasksWaitingCleanUp > ( UBaseType_t ) 0U )
+	{
+		taskENTER_CRITICAL();
+		{
+			pxTCB = listGET_OWNER_OF_HEAD_ENTRY( ( &xTasksWaitingTermination ) );
+			( void ) uxListRemove( &( pxTCB->xStateListItem ) );
+			--uxCurrentNumberOfTasks;
+			--uxDeletedTasksWaitingCleanUp;
+		}
+		taskEXIT_CRITICAL();
+
+		prvDeleteTCB( pxTCB );
+	}
+}
+
+void vTaskDelete( TaskHandle_t xTaskToDelete )
+{
+	TCB_t *pxTCB;
+
+	taskENTER_CRITICAL();
+	{
+		pxTCB = prvGetTCBFromHandle( xTaskToDelete );
+
+		if( uxListRemove( &( pxTCB->xStateListItem ) ) == ( UBaseType_t ) 0 )
+		{
+			taskRESET_READY_PRIORITY( pxTCB->uxPriority );
+		}
+
+		if( listLIST_ITEM_CONTAINER( &( pxTCB->xEventListItem ) ) != NULL )
+		{
+			( void ) uxListRemove( &( pxTCB->xEventListItem ) );
+		}
+
+		uxTaskNumber++;
+
+		if( pxTCB == pxCurrentTCB )
+		{
+			/* A task cannot free its own stack: the idle task will. */
+			vListInsertEnd( &xTasksWaitingTermination, &( pxTCB->xStateListItem ) );
+			++uxDeletedTasksWaitingCleanUp;
+		}
+		else
+		{
+			--uxCurrentNumberOfTasks;
+			prvResetNextTaskUnblockTime();
+		}
+	}
+	taskEXIT_CRITICAL();
+
+	if( pxTCB != pxCurrentTCB )
+	{
+		prvDeleteTCB( pxTCB );
+	}
+
+	if( xSchedulerRunning != pdFALSE )
+	{
+		if( pxTCB == pxCurrentTCB )
+		{
+			configASSERT( uxSchedulerSuspended == 0 );
+			portYIELD_WITHIN_API();
+		}
+	}
+}
+
+/*-----------------------------------------------------------
+ * Delays
+ *----------------------------------------------------------*/
+
+void vTaskDelayUntil( TickType_t * const pxPreviousWakeTime, const TickType_t xTimeIncrement )
+{
+	TickType_t xTimeToWake;
+	BaseType_t xAlreadyYielded, xShouldDelay = pdFALSE;
+
+	configASSERT( pxPreviousWakeTime );
+	configASSERT( ( xTimeIncrement > 0U ) );
+	configASSERT( uxSchedulerSuspended == 0 );
+
+	vTaskSuspendAll();
+	{
+		const TickType_t xConstTickCount = xTickCount;
+
+		xTimeToWake = *pxPreviousWakeTime + xTimeIncrement;
+
+		if( xConstTickCount < *pxPreviousWakeTime )
+		{
+			if( ( xTimeToWake < *pxPreviousWakeTime ) && ( xTimeToWake > xConstTickCount ) )
+			{
+				xShouldDelay = pdTRUE;
+			}
+		}
+		else
+		{
+			if( ( xTimeToWake < *pxPreviousWakeTime ) || ( xTimeToWake > xConstTickCount ) )
+			{
+				xShouldDelay = pdTRUE;
+			}
+		}
+
+		*pxPreviousWakeTime = xTimeToWake;
+
+		if( xShouldDelay != pdFALSE )
+		{
+			prvAddCurrentTaskToDelayedList( xTimeToWake - xConstTickCount, pdFALSE );
+		}
+	}
+	xAlreadyYielded = xTaskResumeAll();
+
+	if( xAlreadyYielded == pdFALSE )
+	{
+		portYIELD_WITHIN_API();
+	}
+}
+
+void vTaskDelay( const TickType_t xTicksToDelay )
+{
+	BaseType_t xAlreadyYielded = pdFALSE;
+
+	if( xTicksToDelay > ( TickType_t ) 0U )
+	{
+		configASSERT( uxSchedulerSuspended == 0 );
+		vTaskSuspendAll();
+		{
+			prvAddCurrentTaskToDelayedList( xTicksToDelay, pdFALSE );
+		}
+		xAlreadyYielded = xTaskResumeAll();
+	}
+
+	if( xAlreadyYielded == pdFALSE )
+	{
+		portYIELD_WITHIN_API();
+	}
+}
+
+BaseType_t xTaskAbortDelay( TaskHandle_t xTask )
+{
+	TCB_t *pxTCB = xTask;
+	BaseType_t xReturn;
+
+	configASSERT( pxTCB );
+
+	vTaskSuspendAll();
+	{
+		if( eTaskGetState( xTask ) == eBlocked )
+		{
+			xReturn = pdPASS;
+
+			( void ) uxListRemove( &( pxTCB->xStateListItem ) );
+
+			taskENTER_CRITICAL();
+			{
+				if( listLIST_ITEM_CONTAINER( &( pxTCB->xEventListItem ) ) != NULL )
+				{
+					( void ) uxListRemove( &( pxTCB->xEventListItem ) );
+					pxTCB->ucDelayAborted = pdTRUE;
+				}
+			}
+			taskEXIT_CRITICAL();
+
+			prvAddTaskToReadyList( pxTCB );
+
+			if( pxTCB->uxPriority > pxCurrentTCB->uxPriority )
+			{
+				xYieldPending = pdTRUE;
+			}
+		}
+		else
+		{
+			xReturn = pdFAIL;
+		}
+	}
+	( void ) xTaskResumeAll();
+
+	return xReturn;
+}
+
+/*-----------------------------------------------------------
+ * Task state and priority
+ *----------------------------------------------------------*/
+
+eTaskState eTaskGetState( TaskHandle_t xTask )
+{
+	eTaskState eReturn;
+	List_t const *pxStateList, *pxDelayedList, *pxOverflowedDelayedList;
+	const TCB_t * const pxTCB = xTask;
+
+	configASSERT( pxTCB );
+
+	if( pxTCB == pxCurrentTCB )
+	{
+		return eRunning;
+	}
+
+	taskENTER_CRITICAL();
+	{
+		pxStateList = listLIST_ITEM_CONTAINER( &( pxTCB->xStateListItem ) );
+		pxDelayedList = pxDelayedTaskList;
+		pxOverflowedDelayedList = pxOverflowDelayedTaskList;
+	}
+	taskEXIT_CRITICAL();
+
+	if( ( pxStateList == pxDelayedList ) || ( pxStateList == pxOverflowedDelayedList ) )
+	{
+		eReturn = eBlocked;
+	}
+	else if( pxStateList == &xSuspendedTaskList )
+	{
+		/* Blocked indefinitely on an event, or waiting for a notification. */
+		if( ( listLIST_ITEM_CONTAINER( &( pxTCB->xEventListItem ) ) == NULL ) &&
+		    ( pxTCB->ucNotifyState != taskWAITING_NOTIFICATION ) )
+		{
+			eReturn = eSuspended;
+		}
+		else
+		{
+			eReturn = eBlocked;
+		}
+	}
+	else if( ( pxStateList == &xTasksWaitingTermination ) || ( pxStateList == NULL ) )
+	{
+		eReturn = eDeleted;
+	}
+	else
+	{
+		eReturn = eReady;
+	}
+
+	return eReturn;
+}
+
+UBaseType_t uxTaskPriorityGet( const TaskHandle_t xTask )
+{
+	TCB_t const *pxTCB;
+	UBaseType_t uxReturn;
+
+	taskENTER_CRITICAL();
+	{
+		pxTCB = prvGetTCBFromHandle( xTask );
+		uxReturn = pxTCB->uxPriority;
+	}
+	taskEXIT_CRITICAL();
+
+	return uxReturn;
+}
+
+UBaseType_t uxTaskPriorityGetFromISR( const TaskHandle_t xTask )
+{
+	TCB_t const *pxTCB;
+	UBaseType_t uxReturn, uxSavedInterruptState;
+
+	uxSavedInterruptState = portSET_INTERRUPT_MASK_FROM_ISR();
+	{
+		pxTCB = prvGetTCBFromHandle( xTask );
+		uxReturn = pxTCB->uxPriority;
+	}
+	portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptState );
+
+	return uxReturn;
+}
+
+void vTaskPrioritySet( TaskHandle_t xTask, UBaseType_t uxNewPriority )
+{
+	TCB_t *pxTCB;
+	UBaseType_t uxCurrentBasePriority, uxPriorityUsedOnEntry;
+	BaseType_t xYieldRequired = pdFALSE;
+
+	if( uxNewPriority >= ( UBaseType_t ) configMAX_PRIORITIES )
+	{
+		uxNewPriority = ( UBaseType_t ) configMAX_PRIORITIES - ( UBaseType_t ) 1U;
+	}
+
+	taskENTER_CRITICAL();
+	{
+		pxTCB = prvGetTCBFromHandle( xTask );
+		uxCurrentBasePriority = pxTCB->uxBasePriority;
+
+		if( uxCurrentBasePriority != uxNewPriority )
+		{
+			if( uxNewPriority > uxCurrentBasePriority )
+			{
+				if( ( pxTCB != pxCurrentTCB ) && ( uxNewPriority >= pxCurrentTCB->uxPriority ) )
+				{
+					xYieldRequired = pdTRUE;
+				}
+			}
+			else if( pxTCB == pxCurrentTCB )
+			{
+				xYieldRequired = pdTRUE;
+			}
+
+			uxPriorityUsedOnEntry = pxTCB->uxPriority;
+
+			/* An inherited priority stays until the mutex is given back. */
+			if( pxTCB->uxBasePriority == pxTCB->uxPriority )
+			{
+				pxTCB->uxPriority = uxNewPriority;
+			}
+			pxTCB->uxBasePriority = uxNewPriority;
+
+			if( ( listGET_LIST_ITEM_VALUE( &( pxTCB->xEventListItem ) ) & taskEVENT_LIST_ITEM_VALUE_IN_USE ) == 0UL )
+			{
+				listSET_LIST_ITEM_VALUE( &( pxTCB->xEventListItem ), ( ( TickType_t ) configMAX_PRIORITIES - ( TickType_t ) uxNewPriority ) );
+			}
+
+			if( listIS_CONTAINED_WITHIN( &( pxReadyTasksLists[ uxPriorityUsedOnEntry ] ), &( pxTCB->xStateListItem ) ) != pdFALSE )
+			{
+				if( uxListRemove( &( pxTCB->xStateListItem ) ) == ( UBaseType_t ) 0 )
+				{
+					portRESET_READY_PRIORITY( uxPriorityUsedOnEntry, uxTopReadyPriority );
+				}
+				prvAddTaskToReadyList( pxTCB );
+			}
+
+			if( xYieldRequired != pdFALSE )
+			{
+				taskYIELD_IF_USING_PREEMPTION();
+			}
+		}
+	}
+	taskEXIT_CRITICAL();
+}
+
+/*-----------------------------------------------------------
+ * Suspend and resume
+ *----------------------------------------------------------*/
+
+void vTaskSuspend( TaskHandle_t xTaskToSuspend )
+{
+	TCB_t *pxTCB;
+
+	taskENTER_CRITICAL();
+	{
+		pxTCB = prvGetTCBFromHandle( xTaskToSuspend );
+
+		if( uxListRemove( &( pxTCB->xStateListItem ) ) == ( UBaseType_t ) 0 )
+		{
+			taskRESET_READY_PRIORITY( pxTCB->uxPriority );
+		}
+
+		if( listLIST_ITEM_CONTAINER( &( pxTCB->xEventListItem ) ) != NULL )
+		{
+			( void ) uxListRemove( &( pxTCB->xEventListItem ) );
+		}
+
+		vListInsertEnd( &xSuspendedTaskList, &( pxTCB->xStateListItem ) );
+
+		if( pxTCB->ucNotifyState == taskWAITING_NOTIFICATION )
+		{
+			pxTCB->ucNotifyState = taskNOT_WAITING_NOTIFICATION;
+		}
+	}
+	taskEXIT_CRITICAL();
+
+	if( xSchedulerRunning != pdFALSE )
+	{
+		taskENTER_CRITICAL();
+		{
+			prvResetNextTaskUnblockTime();
+		}
+		taskEXIT_CRITICAL();
+	}
+
+	if( pxTCB == pxCurrentTCB )
+	{
+		if( xSchedulerRunning != pdFALSE )
+		{
+			configASSERT( uxSchedulerSuspended == 0 );
+			portYIELD_WITHIN_API();
+		}
+		else if( listCURRENT_LIST_LENGTH( &xSuspendedTaskList ) == uxCurrentNumberOfTasks )
+		{
+			pxCurrentTCB = NULL;
+		}
+		else
+		{
+			vTaskSwitchContext();
+		}
+	}
+}
+
+static BaseType_t prvTaskIsTaskSuspended( const TaskHandle_t xTask )
+{
+	const TCB_t * const pxTCB = xTask;
+
+	if( listIS_CONTAINED_WITHIN( &xSuspendedTaskList, &( pxTCB->xStateListItem ) ) == pdFALSE )
+	{
+		return pdFALSE;
+	}
+
+	/* Not resumed from an ISR yet, and not blocked indefinitely either. */
+	if( listIS_CONTAINED_WITHIN( &xPendingReadyList, &( pxTCB->xEventListItem ) ) != pdFALSE )
+	{
+		return pdFALSE;
+	}
+
+	return listIS_CONTAINED_WITHIN( NULL, &( pxTCB->xEventListItem ) );
+}
+
+void vTaskResume( TaskHandle_t xTaskToResume )
+{
+	TCB_t * const pxTCB = xTaskToResume;
+
+	configASSERT( xTaskToResume );
+
+	if( ( pxTCB != pxCurrentTCB ) && ( pxTCB != NULL ) )
+	{
+		taskENTER_CRITICAL();
+		{
+			if( prvTaskIsTaskSuspended( pxTCB ) != pdFALSE )
+			{
+				( void ) uxListRemove( &( pxTCB->xStateListItem ) );
+				prvAddTaskToReadyList( pxTCB );
+
+				if( pxTCB->uxPriority >= pxCurrentTCB->uxPriority )
+				{
+					taskYIELD_IF_USING_PREEMPTION();
+				}
+			}
+		}
+		taskEXIT_CRITICAL();
+	}
+}
+
+BaseType_t xTaskResumeFromISR( TaskHandle_t xTaskToResume )
+{
+	BaseType_t xYieldRequired = pdFALSE;
+	TCB_t * const pxTCB = xTaskToResume;
+	UBaseType_t uxSavedInterruptStatus;
+
+	configASSERT( xTaskToResume );
+
+	uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+	{
+		if( prvTaskIsTaskSuspended( pxTCB ) != pdFALSE )
+		{
+			if( uxSchedulerSuspended == ( UBaseType_t ) pdFALSE )
+			{
+				if( pxTCB->uxPriority >= pxCurrentTCB->uxPriority )
+				{
+					xYieldRequired = pdTRUE;
+				}
+
+				( void ) uxListRemove( &( pxTCB->xStateListItem ) );
+				prvAddTaskToReadyList( pxTCB );
+			}
+			else
+			{
+				vListInsertEnd( &( xPendingReadyList ), &( pxTCB->xEventListItem ) );
+			}
+		}
+	}
+	portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+
+	return xYieldRequired;
+}
+
+/*-----------------------------------------------------------
+ * Scheduler control
+ *----------------------------------------------------------*/
+
+void vTaskStartScheduler( void )
+{
+	BaseType_t xReturn;
+
+	xReturn = xTaskCreate( prvIdleTask,
+			       configIDLE_TASK_NAME,
+			       configMINIMAL_STACK_SIZE,
+			       ( void * ) NULL,
+			       tskIDLE_PRIORITY,
+			       &xIdleTaskHandle );
+
+#if ( configUSE_TIMERS == 1 )
+	if( xReturn == pdPASS )
+	{
+		xReturn = xTimerCreateTimerTask();
+	}
+#endif
+
+	if( xReturn == pdPASS )
+	{
+		portDISABLE_INTERRUPTS();
+
+		xNextTaskUnblockTime = portMAX_DELAY;
+		xSchedulerRunning = pdTRUE;
+		xTickCount = ( TickType_t ) 0U;
+
+		portCONFIGURE_TIMER_FOR_RUN_TIME_STATS();
+
+		/* Tasks start with their interrupts enabled (see port.c). */
+		if( xPortStartScheduler() != pdFALSE )
+		{
+			/* Does not return. */
+		}
+	}
+
+	configASSERT( xReturn != errCOULD_NOT_ALLOCATE_REQUIRED_MEMORY );
+}
+
+void vTaskEndScheduler( void )
+{
+	portDISABLE_INTERRUPTS();
+	xSchedulerRunning = pdFALSE;
+	vPortEndScheduler();
+}
+
+void vTaskSuspendAll( void )
+{
+	++uxSchedulerSuspended;
+	portMEMORY_BARRIER();
+}
+
+BaseType_t xTaskResumeAll( void )
+{
+	TCB_t *pxTCB = NULL;
+	BaseType_t xAlreadyYielded = pdFALSE;
+
+	configASSERT( uxSchedulerSuspended );
+
+	taskENTER_CRITICAL();
+	{
+		--uxSchedulerSuspended;
+
+		if( uxSchedulerSuspended == ( UBaseType_t ) pdFALSE )
+		{
+			if( uxCurrentNumberOfTasks > ( UBaseType_t ) 0U )
+			{
+				/* Tasks readied by ISRs in the meantime. */
+				while( listLIST_IS_EMPTY( &xPendingReadyList ) == pdFALSE )
+				{
+					pxTCB = listGET_OWNER_OF_HEAD_ENTRY( ( &xPendingReadyList ) );
+					( void ) uxListRemove( &( pxTCB->xEventListItem ) );
+					( void ) uxListRemove( &( pxTCB->xStateListItem ) );
+					prvAddTaskToReadyList( pxTCB );
+
+					if( pxTCB->uxPriority >= pxCurrentTCB->uxPriority )
+					{
+						xYieldPending = pdTRUE;
+					}
+				}
+
+				if( pxTCB != NULL )
+				{
+					prvResetNextTaskUnblockTime();
+				}
+
+				/* Ticks that came in while suspended. */
+				{
+					UBaseType_t uxPendedCounts = uxPendedTicks;
+
+					if( uxPendedCounts > ( UBaseType_t ) 0U )
+					{
+						do
+						{
+							if( xTaskIncrementTick() != pdFALSE )
+							{
+								xYieldPending = pdTRUE;
+							}
+							--uxPendedCounts;
+						} while( uxPendedCounts > ( UBaseType_t ) 0U );
+
+						uxPendedTicks = 0;
+					}
+				}
+
+				if( xYieldPending != pdFALSE )
+				{
+#if( configUSE_PREEMPTION != 0 )
+					xAlreadyYielded = pdTRUE;
+#endif
+					taskYIELD_IF_USING_PREEMPTION();
+				}
+			}
+		}
+	}
+	taskEXIT_CRITICAL();
+
+	return xAlreadyYielded;
+}
+
+BaseType_t xTaskGetSchedulerState( void )
+{
+	if( xSchedulerRunning == pdFALSE )
+	{
+		return taskSCHEDULER_NOT_STARTED;
+	}
+
+	if( uxSchedulerSuspended == ( UBaseType_t ) pdFALSE )
+	{
+		return taskSCHEDULER_RUNNING;
+	}
+
+	return taskSCHEDULER_SUSPENDED;
+}
+
+/*-----------------------------------------------------------
+ * Task utilities
+ *----------------------------------------------------------*/
+
+TickType_t xTaskGetTickCount( void )
+{
+	TickType_t xTicks;
+
+	portTICK_TYPE_ENTER_CRITICAL();
+	{
+		xTicks = xTickCount;
+	}
+	portTICK_TYPE_EXIT_CRITICAL();
+
+	return xTicks;
+}
+
+TickType_t xTaskGetTickCountFromISR( void )
+{
+	return xTickCount;
+}
+
+UBaseType_t uxTaskGetNumberOfTasks( void )
+{
+	return uxCurrentNumberOfTasks;
+}
+
+char *pcTaskGetName( TaskHandle_t xTaskToQuery )
+{
+	TCB_t *pxTCB;
+
+	pxTCB = prvGetTCBFromHandle( xTaskToQuery );
+	configASSERT( pxTCB );
+
+	return &( pxTCB->pcTaskName[ 0 ] );
+}
+
+static TCB_t *prvSearchForNameWithinSingleList( List_t *pxList, const char pcNameToQuery[] )
+{
+	ListItem_t const *pxItem;
+	TCB_t *pxTCB;
+
+	for( pxItem = listGET_HEAD_ENTRY( pxList );
+	     pxItem != listGET_END_MARKER( pxList );
+	     pxItem = listGET_NEXT( pxItem ) )
+	{
+		pxTCB = listGET_LIST_ITEM_OWNER( pxItem );
+
+		if( strncmp( pxTCB->pcTaskName, pcNameToQuery, configMAX_TASK_NAME_LEN ) == 0 )
+		{
+			return pxTCB;
+		}
+	}
+
+	return NULL;
+}
+
+TaskHandle_t xTaskGetHandle( const char *pcNameToQuery )
+{
+	UBaseType_t uxQueue = configMAX_PRIORITIES;
+	TCB_t *pxTCB;
+
+	configASSERT( strlen( pcNameToQuery ) < configMAX_TASK_NAME_LEN );
+
+	vTaskSuspendAll();
+	{
+		do
+		{
+			uxQueue--;
+			pxTCB = prvSearchForNameWithinSingleList( ( List_t * ) &( pxReadyTasksLists[ uxQueue ] ), pcNameToQuery );
+
+			if( pxTCB != NULL )
+			{
+				break;
+			}
+		} while( uxQueue > ( UBaseType_t ) tskIDLE_PRIORITY );
+
+		if( pxTCB == NULL )
+		{
+			pxTCB = prvSearchForNameWithinSingleList( ( List_t * ) pxDelayedTaskList, pcNameToQuery );
+		}
+		if( pxTCB == NULL )
+		{
+			pxTCB = prvSearchForNameWithinSingleList( ( List_t * ) pxOverflowDelayedTaskList, pcNameToQuery );
+		}
+		if( pxTCB == NULL )
+		{
+			pxTCB = prvSearchForNameWithinSingleList( &xSuspendedTaskList, pcNameToQuery );
+		}
+		if( pxTCB == NULL )
+		{
+			pxTCB = prvSearchForNameWithinSingleList( &xTasksWaitingTermination, pcNameToQuery );
+		}
+	}
+	( void ) xTaskResumeAll();
+
+	return pxTCB;
+}
+
+TaskHandle_t xTaskGetIdleTaskHandle( void )
+{
+	configASSERT( ( xIdleTaskHandle != NULL ) );
+
+	return xIdleTaskHandle;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle( void )
+{
+	return pxCurrentTCB;
+}
+
+static configSTACK_DEPTH_TYPE prvTaskCheckFreeStackSpace( const uint8_t *pucStackByte )
+{
+	uint32_t ulCount = 0U;
+
+	while( *pucStackByte == ( uint8_t ) tskSTACK_FILL_BYTE )
+	{
+		pucStackByte -= portSTACK_GROWTH;
+		ulCount++;
+	}
+
+	ulCount /= ( uint32_t ) sizeof( StackType_t );
+
+	return ( configSTACK_DEPTH_TYPE ) ulCount;
+}
+
+/*
+ * The host thread of a task runs on a stack of its own, so this tells
+ * what is left of the (unused) FreeRTOS stack, which is all of it but
+ * the port bookkeeping at the top.
+ */
+UBaseType_t uxTaskGetStackHighWaterMark( TaskHandle_t xTask )
+{
+	TCB_t *pxTCB = prvGetTCBFromHandle( xTask );
+
+	return ( UBaseType_t ) prvTaskCheckFreeStackSpace( ( uint8_t * ) pxTCB->pxStack );
+}
+
+configSTACK_DEPTH_TYPE uxTaskGetStackHighWaterMark2( TaskHandle_t xTask )
+{
+	TCB_t *pxTCB = prvGetTCBFromHandle( xTask );
+
+	return prvTaskCheckFreeStackSpace( ( uint8_t * ) pxTCB->pxStack );
+}
+
+void vTaskSetThreadLocalStoragePointerAndDelCallback( TaskHandle_t xTaskToSet, BaseType_t xIndex, void *pvValue, TlsDeleteCallbackFunction_t pvDelCallback )
+{
+	TCB_t *pxTCB;
+
+	if( xIndex < configNUM_THREAD_LOCAL_STORAGE_POINTERS )
+	{
+		taskENTER_CRITICAL();
+		pxTCB = prvGetTCBFromHandle( xTaskToSet );
+		pxTCB->pvThreadLocalStoragePointers[ xIndex ] = pvValue;
+		pxTCB->pvThreadLocalStoragePointersDelCallback[ xIndex ] = pvDelCallback;
+		taskEXIT_CRITICAL();
+	}
+}
+
+void vTaskSetThreadLocalStoragePointer( TaskHandle_t xTaskToSet, BaseType_t xIndex, void *pvValue )
+{
+	vTaskSetThreadLocalStoragePointerAndDelCallback( xTaskToSet, xIndex, pvValue, NULL );
+}
+
+void *pvTaskGetThreadLocalStoragePointer( TaskHandle_t xTaskToQuery, BaseType_t xIndex )
+{
+	TCB_t *pxTCB;
+
+	if( xIndex < configNUM_THREAD_LOCAL_STORAGE_POINTERS )
+	{
+		pxTCB = prvGetTCBFromHandle( xTaskToQuery );
+		return pxTCB->pvThreadLocalStoragePointers[ xIndex ];
+	}
+
+	return NULL;
+}
+
+void vTaskGetInfo( TaskHandle_t xTask, TaskStatus_t *pxTaskStatus, BaseType_t xGetFreeStackSpace, eTaskState eState )
+{
+	TCB_t *pxTCB;
+
+	pxTCB = prvGetTCBFromHandle( xTask );
+
+	pxTaskStatus->xHandle = ( TaskHandle_t ) pxTCB;
+	pxTaskStatus->pcTaskName = ( const char * ) &( pxTCB->pcTaskName[ 0 ] );
+	pxTaskStatus->uxCurrentPriority = pxTCB->uxPriority;
+	pxTaskStatus->pxStackBase = pxTCB->pxStack;
+	pxTaskStatus->pxEndOfStack = pxTCB->pxEndOfStack;
+	pxTaskStatus->xTaskNumber = pxTCB->uxTCBNumber;
+	pxTaskStatus->uxBasePriority = pxTCB->uxBasePriority;
+	pxTaskStatus->ulRunTimeCounter = pxTCB->ulRunTimeCounter;
+
+	if( eState != eInvalid )
+	{
+		if( pxTCB == pxCurrentTCB )
+		{
+			pxTaskStatus->eCurrentState = eRunning;
+		}
+		else
+		{
+			pxTaskStatus->eCurrentState = eState;
+
+			if( eState == eSuspended )
+			{
+				vTaskSuspendAll();
+				{
+					if( listLIST_ITEM_CONTAINER( &( pxTCB->xEventListItem ) ) != NULL )
+					{
+						pxTaskStatus->eCurrentState = eBlocked;
+					}
+				}
+				( void ) xTaskResumeAll();
+			}
+		}
+	}
+	else
+	{
+		pxTaskStatus->eCurrentState = eTaskGetState( pxTCB );
+	}
+
+	if( xGetFreeStackSpace != pdFALSE )
+	{
+		pxTaskStatus->usStackHighWaterMark = prvTaskCheckFreeStackSpace( ( uint8_t * ) pxTCB->pxStack );
+	}
+	else
+	{
+		pxTaskStatus->usStackHighWaterMark = 0;
+	}
+}
+
+static UBaseType_t prvListTasksWithinSingleList( TaskStatus_t *pxTaskStatusArray, List_t *pxList, eTaskState eState )
+{
+	ListItem_t const *pxItem;
+	UBaseType_t uxTask = 0;
+
+	for( pxItem = listGET_HEAD_ENTRY( pxList );
+	     pxItem != listGET_END_MARKER( pxList );
+	     pxItem = listGET_NEXT( pxItem ) )
+	{
+		vTaskGetInfo( listGET_LIST_ITEM_OWNER( pxItem ), &( pxTaskStatusArray[ uxTask ] ), pdTRUE, eState );
+		uxTask++;
+	}
+
+	return uxTask;
+}
+
+UBaseType_t uxTaskGetSystemState( TaskStatus_t * const pxTaskStatusArray, const UBaseType_t uxArraySize, uint32_t * const pulTotalRunTime )
+{
+	UBaseType_t uxTask = 0, uxQueue = configMAX_PRIORITIES;
+
+	vTaskSuspendAll();
+	{
+		if( uxArraySize >= uxCurrentNumberOfTasks )
+		{
+			do
+			{
+				uxQueue--;
+				uxTask += prvListTasksWithinSingleList( &( pxTaskStatusArray[ uxTask ] ), &( pxReadyTasksLists[ uxQueue ] ), eReady );
+			} while( uxQueue > ( UBaseType_t ) tskIDLE_PRIORITY );
+
+			uxTask += prvListTasksWithinSingleList( &( pxTaskStatusArray[ uxTask ] ), ( List_t * ) pxDelayedTaskList, eBlocked );
+			uxTask += prvListTasksWithinSingleList( &( pxTaskStatusArray[ uxTask ] ), ( List_t * ) pxOverflowDelayedTaskList, eBlocked );
+			uxTask += prvListTasksWithinSingleList( &( pxTaskStatusArray[ uxTask ] ), &xTasksWaitingTermination, eDeleted );
+			uxTask += prvListTasksWithinSingleList( &( pxTaskStatusArray[ uxTask ] ), &xSuspendedTaskList, eSuspended );
+
+			if( pulTotalRunTime != NULL )
+			{
+				*pulTotalRunTime = portGET_RUN_TIME_COUNTER_VALUE();
+			}
+		}
+	}
+	( void ) xTaskResumeAll();
+
+	return uxTask;
+}
+
+UBaseType_t uxTaskGetTaskNumber( TaskHandle_t xTask )
+{
+	return xTask != NULL ? ( ( TCB_t * ) xTask )->uxTaskNumber : 0U;
+}
+
+void vTaskSetTaskNumber( TaskHandle_t xTask, const UBaseType_t uxHandle )
+{
+	if( xTask != NULL )
+	{
+		( ( TCB_t * ) xTask )->uxTaskNumber = uxHandle;
+	}
+}
+
+/*-----------------------------------------------------------
+ * Tick and context switch
+ *----------------------------------------------------------*/
+
+static void prvResetNextTaskUnblockTime( void )
+{
+	TCB_t *pxTCB;
+
+	if( listLIST_IS_EMPTY( pxDelayedTaskList ) != pdFALSE )
+	{
+		xNextTaskUnblockTime = portMAX_DELAY;
+	}
+	else
+	{
+		pxTCB = listGET_OWNER_OF_HEAD_ENTRY( pxDelayedTaskList );
+		xNextTaskUnblockTime = listGET_LIST_ITEM_VALUE( &( ( pxTCB )->xStateListItem ) );
+	}
+}
+
+BaseType_t xTaskIncrementTick( void )
+{
+	TCB_t *pxTCB;
+	TickType_t xItemValue;
+	BaseType_t xSwitchRequired = pdFALSE;
+
+	if( uxSchedulerSuspended != ( UBaseType_t ) pdFALSE )
+	{
+		++uxPendedTicks;
+		return pdFALSE;
+	}
+
+	{
+		const TickType_t xConstTickCount = xTickCount + ( TickType_t ) 1;
+
+		xTickCount = xConstTickCount;
+
+		if( xConstTickCount == ( TickType_t ) 0U )
+		{
+			taskSWITCH_DELAYED_LISTS();
+		}
+
+		if( xConstTickCount >= xNextTaskUnblockTime )
+		{
+			for( ;; )
+			{
+				if( listLIST_IS_EMPTY( pxDelayedTaskList ) != pdFALSE )
+				{
+					xNextTaskUnblockTime = portMAX_DELAY;
+					break;
+				}
+
+				pxTCB = listGET_OWNER_OF_HEAD_ENTRY( pxDelayedTaskList );
+				xItemValue = listGET_LIST_ITEM_VALUE( &( pxTCB->xStateListItem ) );
+
+				if( xConstTickCount < xItemValue )
+				{
+					xNextTaskUnblockTime = xItemValue;
+					break;
+				}
+
+				( void ) uxListRemove( &( pxTCB->xStateListItem ) );
+
+				if( listLIST_ITEM_CONTAINER( &( pxTCB->xEventListItem ) ) != NULL )
+				{
+					( void ) uxListRemove( &( pxTCB->xEventListItem ) );
+				}
+
+				prvAddTaskToReadyList( pxTCB );
+
+#if ( configUSE_PREEMPTION == 1 )
+				if( pxTCB->uxPriority >= pxCurrentTCB->uxPriority )
+				{
+					xSwitchRequired = pdTRUE;
+				}
+#endif
+			}
+		}
+
+#if ( ( configUSE_PREEMPTION == 1 ) && ( configUSE_TIME_SLICING == 1 ) )
+		if( listCURRENT_LIST_LENGTH( &( pxReadyTasksLists[ pxCurrentTCB->uxPriority ] ) ) > ( UBaseType_t ) 1 )
+		{
+			xSwitchRequired = pdTRUE;
+		}
+#endif
+	}
+
+#if ( configUSE_PREEMPTION == 1 )
+	if( xYieldPending != pdFALSE )
+	{
+		xSwitchRequired = pdTRUE;
+	}
+#endif
+
+	return xSwitchRequired;
+}
+
+void vTaskSwitchContext( void )
+{
+	UBaseType_t uxTopPriority;
+	uint32_t ulNow;
+
+	if( uxSchedulerSuspended != ( UBaseType_t ) pdFALSE )
+	{
+		xYieldPending = pdTRUE;
+		return;
+	}
+
+	xYieldPending = pdFALSE;
+
+	ulNow = portGET_RUN_TIME_COUNTER_VALUE();
+	if( ulNow > ulTaskSwitchedInTime )
+	{
+		pxCurrentTCB->ulRunTimeCounter += ( ulNow - ulTaskSwitchedInTime );
+	}
+	ulTaskSwitchedInTime = ulNow;
+	ulTotalRunTime = ulNow;
+
+	pxCurrentTCB->iTaskErrno = FreeRTOS_errno;
+
+	taskSELECT_HIGHEST_PRIORITY( uxTopPriority );
+	configASSERT( listCURRENT_LIST_LENGTH( &( pxReadyTasksLists[ uxTopPriority ] ) ) > 0 );
+	listGET_OWNER_OF_NEXT_ENTRY( pxCurrentTCB, &( pxReadyTasksLists[ uxTopPriority ] ) );
+
+	FreeRTOS_errno = pxCurrentTCB->iTaskErrno;
+}
+
+/*-----------------------------------------------------------
+ * Event lists (used by queue.c and the timer/event group code)
+ *----------------------------------------------------------*/
+
+void vTaskPlaceOnEventList( List_t * const pxEventList, const TickType_t xTicksToWait )
+{
+	configASSERT( pxEventList );
+
+	vListInsert( pxEventList, &( pxCurrentTCB->xEventListItem ) );
+	prvAddCurrentTaskToDelayedList( xTicksToWait, pdTRUE );
+}
+
+void vTaskPlaceOnUnorderedEventList( List_t * pxEventList, const TickType_t xItemValue, const TickType_t xTicksToWait )
+{
+	configASSERT( pxEventList );
+	configASSERT( uxSchedulerSuspended != 0 );
+
+	listSET_LIST_ITEM_VALUE( &( pxCurrentTCB->xEventListItem ), xItemValue | taskEVENT_LIST_ITEM_VALUE_IN_USE );
+	vListInsertEnd( pxEventList, &( pxCurrentTCB->xEventListItem ) );
+	prvAddCurrentTaskToDelayedList( xTicksToWait, pdTRUE );
+}
+
+void vTaskPlaceOnEventListRestricted( List_t * const pxEventList, TickType_t xTicksToWait, const BaseType_t xWaitIndefinitely )
+{
+	configASSERT( pxEventList );
+
+	vListInsertEnd( pxEventList, &( pxCurrentTCB->xEventListItem ) );
+
+	if( xWaitIndefinitely != pdFALSE )
+	{
+		xTicksToWait = portMAX_DELAY;
+	}
+
+	prvAddCurrentTaskToDelayedList( xTicksToWait, xWaitIndefinitely );
+}
+
+BaseType_t xTaskRemoveFromEventList( const List_t * const pxEventList )
+{
+	TCB_t *pxUnblockedTCB;
+
+	pxUnblockedTCB = listGET_OWNER_OF_HEAD_ENTRY( pxEventList );
+	configASSERT( pxUnblockedTCB );
+	( void ) uxListRemove( &( pxUnblockedTCB->xEventListItem ) );
+
+	if( uxSchedulerSuspended == ( UBaseType_t ) pdFALSE )
+	{
+		( void ) uxListRemove( &( pxUnblockedTCB->xStateListItem ) );
+		prvAddTaskToReadyList( pxUnblockedTCB );
+		prvResetNextTaskUnblockTime();
+	}
+	else
+	{
+		vListInsertEnd( &( xPendingReadyList ), &( pxUnblockedTCB->xEventListItem ) );
+	}
+
+	if( pxUnblockedTCB->uxPriority > pxCurrentTCB->uxPriority )
+	{
+		xYieldPending = pdTRUE;
+		return pdTRUE;
+	}
+
+	return pdFALSE;
+}
+
+void vTaskRemoveFromUnorderedEventList( ListItem_t * pxEventListItem, const TickType_t xItemValue )
+{
+	TCB_t *pxUnblockedTCB;
+
+	configASSERT( uxSchedulerSuspended != pdFALSE );
+
+	listSET_LIST_ITEM_VALUE( pxEventListItem, xItemValue | taskEVENT_LIST_ITEM_VALUE_IN_USE );
+
+	pxUnblockedTCB = listGET_LIST_ITEM_OWNER( pxEventListItem );
+	configASSERT( pxUnblockedTCB );
+	( void ) uxListRemove( pxEventListItem );
+
+	( void ) uxListRemove( &( pxUnblockedTCB->xStateListItem ) );
+	prvAddTaskToReadyList( pxUnblockedTCB );
+
+	if( pxUnblockedTCB->uxPriority > pxCurrentTCB->uxPriority )
+	{
+		xYieldPending = pdTRUE;
+	}
+}
+
+TickType_t uxTaskResetEventItemValue( void )
+{
+	TickType_t uxReturn;
+
+	uxReturn = listGET_LIST_ITEM_VALUE( &( pxCurrentTCB->xEventListItem ) );
+	listSET_LIST_ITEM_VALUE( &( pxCurrentTCB->xEventListItem ), ( ( TickType_t ) configMAX_PRIORITIES - ( TickType_t ) pxCurrentTCB->uxPriority ) );
+
+	return uxReturn;
+}
+
+void vTaskSetTimeOutState( TimeOut_t * const pxTimeOut )
+{
+	configASSERT( pxTimeOut );
+
+	taskENTER_CRITICAL();
+	{
+		pxTimeOut->xOverflowCount = xNumOfOverflows;
+		pxTimeOut->xTimeOnEntering = xTickCount;
+	}
+	taskEXIT_CRITICAL();
+}
+
+void vTaskInternalSetTimeOutState( TimeOut_t * const pxTimeOut )
+{
+	pxTimeOut->xOverflowCount = xNumOfOverflows;
+	pxTimeOut->xTimeOnEntering = xTickCount;
+}
+
+BaseType_t xTaskCheckForTimeOut( TimeOut_t * const pxTimeOut, TickType_t * const pxTicksToWait )
+{
+	BaseType_t xReturn;
+
+	configASSERT( pxTimeOut );
+	configASSERT( pxTicksToWait );
+
+	taskENTER_CRITICAL();
+	{
+		const TickType_t xConstTickCount = xTickCount;
+		const TickType_t xElapsedTime = xConstTickCount - pxTimeOut->xTimeOnEntering;
+
+		if( pxCurrentTCB->ucDelayAborted != ( uint8_t ) pdFALSE )
+		{
+			pxCurrentTCB->ucDelayAborted = pdFALSE;
+			xReturn = pdTRUE;
+		}
+		else if( *pxTicksToWait == portMAX_DELAY )
+		{
+			xReturn = pdFALSE;
+		}
+		else if( ( xNumOfOverflows != pxTimeOut->xOverflowCount ) && ( xConstTickCount >= pxTimeOut->xTimeOnEntering ) )
+		{
+			/* The tick count wrapped all the way around since entry. */
+			xReturn = pdTRUE;
+		}
+		else if( xElapsedTime < *pxTicksToWait )
+		{
+			*pxTicksToWait -= xElapsedTime;
+			vTaskInternalSetTimeOutState( pxTimeOut );
+			xReturn = pdFALSE;
+		}
+		else
+		{
+			*pxTicksToWait = 0;
+			xReturn = pdTRUE;
+		}
+	}
+	taskEXIT_CRITICAL();
+
+	return xReturn;
+}
+
+void vTaskMissedYield( void )
+{
+	xYieldPending = pdTRUE;
+}
+
+/*-----------------------------------------------------------
+ * Priority inheritance
+ *----------------------------------------------------------*/
+
+BaseType_t xTaskPriorityInherit( TaskHandle_t const pxMutexHolder )
+{
+	TCB_t * const pxMutexHolderTCB = pxMutexHolder;
+	BaseType_t xReturn = pdFALSE;
+
+	if( pxMutexHolder == NULL )
+	{
+		return pdFALSE;
+	}
+
+	if( pxMutexHolderTCB->uxPriority < pxCurrentTCB->uxPriority )
+	{
+		if( ( listGET_LIST_ITEM_VALUE( &( pxMutexHolderTCB->xEventListItem ) ) & taskEVENT_LIST_ITEM_VALUE_IN_USE ) == 0UL )
+		{
+			listSET_LIST_ITEM_VALUE( &( pxMutexHolderTCB->xEventListItem ), ( TickType_t ) configMAX_PRIORITIES - ( TickType_t ) pxCurrentTCB->uxPriority );
+		}
+
+		if( listIS_CONTAINED_WITHIN( &( pxReadyTasksLists[ pxMutexHolderTCB->uxPriority ] ), &( pxMutexHolderTCB->xStateListItem ) ) != pdFALSE )
+		{
+			if( uxListRemove( &( pxMutexHolderTCB->xStateListItem ) ) == ( UBaseType_t ) 0 )
+			{
+				portRESET_READY_PRIORITY( pxMutexHolderTCB->uxPriority, uxTopReadyPriority );
+			}
+
+			pxMutexHolderTCB->uxPriority = pxCurrentTCB->uxPriority;
+			prvAddTaskToReadyList( pxMutexHolderTCB );
+		}
+		else
+		{
+			pxMutexHolderTCB->uxPriority = pxCurrentTCB->uxPriority;
+		}
+
+		xReturn = pdTRUE;
+	}
+	else if( pxMutexHolderTCB->uxBasePriority < pxCurrentTCB->uxPriority )
+	{
+		/* Already inherited from someone else. */
+		xReturn = pdTRUE;
+	}
+
+	return xReturn;
+}
+
+BaseType_t xTaskPriorityDisinherit( TaskHandle_t const pxMutexHolder )
+{
+	TCB_t * const pxTCB = pxMutexHolder;
+	BaseType_t xReturn = pdFALSE;
+
+	if( pxMutexHolder == NULL )
+	{
+		return pdFALSE;
+	}
+
+	configASSERT( pxTCB == pxCurrentTCB );
+	configASSERT( pxTCB->uxMutexesHeld );
+	( pxTCB->uxMutexesHeld )--;
+
+	if( ( pxTCB->uxPriority != pxTCB->uxBasePriority ) && ( pxTCB->uxMutexesHeld == ( UBaseType_t ) 0 ) )
+	{
+		if( uxListRemove( &( pxTCB->xStateListItem ) ) == ( UBaseType_t ) 0 )
+		{
+			taskRESET_READY_PRIORITY( pxTCB->uxPriority );
+		}
+
+		pxTCB->uxPriority = pxTCB->uxBasePriority;
+		listSET_LIST_ITEM_VALUE( &( pxTCB->xEventListItem ), ( TickType_t ) configMAX_PRIORITIES - ( TickType_t ) pxTCB->uxPriority );
+		prvAddTaskToReadyList( pxTCB );
+
+		xReturn = pdTRUE;
+	}
+
+	return xReturn;
+}
+
+void vTaskPriorityDisinheritAfterTimeout( TaskHandle_t const pxMutexHolder, UBaseType_t uxHighestPriorityWaitingTask )
+{
+	TCB_t * const pxTCB = pxMutexHolder;
+	UBaseType_t uxPriorityUsedOnEntry, uxPriorityToUse;
+	const UBaseType_t uxOnlyOneMutexHeld = ( UBaseType_t ) 1;
+
+	if( pxMutexHolder == NULL )
+	{
+		return;
+	}
+
+	configASSERT( pxTCB->uxMutexesHeld );
+
+	if( pxTCB->uxBasePriority < uxHighestPriorityWaitingTask )
+	{
+		uxPriorityToUse = uxHighestPriorityWaitingTask;
+	}
+	else
+	{
+		uxPriorityToUse = pxTCB->uxBasePriority;
+	}
+
+	if( ( pxTCB->uxPriority != uxPriorityToUse ) && ( pxTCB->uxMutexesHeld == uxOnlyOneMutexHeld ) )
+	{
+		configASSERT( pxTCB != pxCurrentTCB );
+
+		uxPriorityUsedOnEntry = pxTCB->uxPriority;
+		pxTCB->uxPriority = uxPriorityToUse;
+
+		if( ( listGET_LIST_ITEM_VALUE( &( pxTCB->xEventListItem ) ) & taskEVENT_LIST_ITEM_VALUE_IN_USE ) == 0UL )
+		{
+			listSET_LIST_ITEM_VALUE( &( pxTCB->xEventListItem ), ( TickType_t ) configMAX_PRIORITIES - ( TickType_t ) uxPriorityToUse );
+		}
+
+		if( listIS_CONTAINED_WITHIN( &( pxReadyTasksLists[ uxPriorityUsedOnEntry ] ), &( pxTCB->xStateListItem ) ) != pdFALSE )
+		{
+			if( uxListRemove( &( pxTCB->xStateListItem ) ) == ( UBaseType_t ) 0 )
+			{
+				portRESET_READY_PRIORITY( uxPriorityUsedOnEntry, uxTopReadyPriority );
+			}
+
+			prvAddTaskToReadyList( pxTCB );
+		}
+	}
+}
+
+TaskHandle_t pvTaskIncrementMutexHeldCount( void )
+{
+	if( pxCurrentTCB != NULL )
+	{
+		( pxCurrentTCB->uxMutexesHeld )++;
+	}
+
+	return pxCurrentTCB;
+}
+
+/*-----------------------------------------------------------
+ * Task notifications
+ *----------------------------------------------------------*/
+
+uint32_t ulTaskNotifyTake( BaseType_t xClearCountOnExit, TickType_t xTicksToWait )
+{
+	uint32_t ulReturn;
+
+	taskENTER_CRITICAL();
+	{
+		if( pxCurrentTCB->ulNotifiedValue == 0UL )
+		{
+			pxCurrentTCB->ucNotifyState = taskWAITING_NOTIFICATION;
+
+			if( xTicksToWait > ( TickType_t ) 0 )
+			{
+				prvAddCurrentTaskToDelayedList( xTicksToWait, pdTRUE );
+				portYIELD_WITHIN_API();
+			}
+		}
+	}
+	taskEXIT_CRITICAL();
+
+	taskENTER_CRITICAL();
+	{
+		ulReturn = pxCurrentTCB->ulNotifiedValue;
+
+		if( ulReturn != 0UL )
+		{
+			if( xClearCountOnExit != pdFALSE )
+			{
+				pxCurrentTCB->ulNotifiedValue = 0UL;
+			}
+			else
+			{
+				pxCurrentTCB->ulNotifiedValue = ulReturn - ( uint32_t ) 1;
+			}
+		}
+
+		pxCurrentTCB->ucNotifyState = taskNOT_WAITING_NOTIFICATION;
+	}
+	taskEXIT_CRITICAL();
+
+	return ulReturn;
+}
+
+BaseType_t xTaskNotifyWait( uint32_t ulBitsToClearOnEntry, uint32_t ulBitsToClearOnExit, uint32_t *pulNotificationValue, TickType_t xTicksToWait )
+{
+	BaseType_t xReturn;
+
+	taskENTER_CRITICAL();
+	{
+		if( pxCurrentTCB->ucNotifyState != taskNOTIFICATION_RECEIVED )
+		{
+			pxCurrentTCB->ulNotifiedValue &= ~ulBitsToClearOnEntry;
+			pxCurrentTCB->ucNotifyState = taskWAITING_NOTIFICATION;
+
+			if( xTicksToWait > ( TickType_t ) 0 )
+			{
+				prvAddCurrentTaskToDelayedList( xTicksToWait, pdTRUE );
+				portYIELD_WITHIN_API();
+			}
+		}
+	}
+	taskEXIT_CRITICAL();
+
+	taskENTER_CRITICAL();
+	{
+		if( pulNotificationValue != NULL )
+		{
+			*pulNotificationValue = pxCurrentTCB->ulNotifiedValue;
+		}
+
+		if( pxCurrentTCB->ucNotifyState != taskNOTIFICATION_RECEIVED )
+		{
+			xReturn = pdFALSE;
+		}
+		else
+		{
+			pxCurrentTCB->ulNotifiedValue &= ~ulBitsToClearOnExit;
+			xReturn = pdTRUE;
+		}
+
+		pxCurrentTCB->ucNotifyState = taskNOT_WAITING_NOTIFICATION;
+	}
+	taskEXIT_CRITICAL();
+
+	return xReturn;
+}
+
+/* Called in a critical section or with interrupts masked. */
+static BaseType_t prvNotify( TCB_t * const pxTCB, uint32_t ulValue, eNotifyAction eAction, uint32_t *pulPreviousNotificationValue, uint8_t *pucOriginalNotifyState )
+{
+	BaseType_t xReturn = pdPASS;
+
+	if( pulPreviousNotificationValue != NULL )
+	{
+		*pulPreviousNotificationValue = pxTCB->ulNotifiedValue;
+	}
+
+	*pucOriginalNotifyState = pxTCB->ucNotifyState;
+	pxTCB->ucNotifyState = taskNOTIFICATION_RECEIVED;
+
+	switch( eAction )
+	{
+		case eSetBits:
+			pxTCB->ulNotifiedValue |= ulValue;
+			break;
+
+		case eIncrement:
+			( pxTCB->ulNotifiedValue )++;
+			break;
+
+		case eSetValueWithOverwrite:
+			pxTCB->ulNotifiedValue = ulValue;
+			break;
+
+		case eSetValueWithoutOverwrite:
+			if( *pucOriginalNotifyState != taskNOTIFICATION_RECEIVED )
+			{
+				pxTCB->ulNotifiedValue = ulValue;
+			}
+			else
+			{
+				xReturn = pdFAIL;
+			}
+			break;
+
+		case eNoAction:
+			break;
+
+		default:
+			configASSERT( 0 );
+			break;
+	}
+
+	return xReturn;
+}
+
+BaseType_t xTaskGenericNotify( TaskHandle_t xTaskToNotify, uint32_t ulValue, eNotifyAction eAction, uint32_t *pulPreviousNotificationValue )
+{
+	TCB_t * const pxTCB = xTaskToNotify;
+	BaseType_t xReturn;
+	uint8_t ucOriginalNotifyState;
+
+	configASSERT( xTaskToNotify );
+
+	taskENTER_CRITICAL();
+	{
+		xReturn = prvNotify( pxTCB, ulValue, eAction, pulPreviousNotificationValue, &ucOriginalNotifyState );
+
+		if( ucOriginalNotifyState == taskWAITING_NOTIFICATION )
+		{
+			( void ) uxListRemove( &( pxTCB->xStateListItem ) );
+			prvAddTaskToReadyList( pxTCB );
+			configASSERT( listLIST_ITEM_CONTAINER( &( pxTCB->xEventListItem ) ) == NULL );
+			prvResetNextTaskUnblockTime();
+
+			if( pxTCB->uxPriority > pxCurrentTCB->uxPriority )
+			{
+				taskYIELD_IF_USING_PREEMPTION();
+			}
+		}
+	}
+	taskEXIT_CRITICAL();
+
+	return xReturn;
+}
+
+BaseType_t xTaskGenericNotifyFromISR( TaskHandle_t xTaskToNotify, uint32_t ulValue, eNotifyAction eAction, uint32_t *pulPreviousNotificationValue, BaseType_t *pxHigherPriorityTaskWoken )
+{
+	TCB_t * const pxTCB = xTaskToNotify;
+	BaseType_t xReturn;
+	uint8_t ucOriginalNotifyState;
+	UBaseType_t uxSavedInterruptStatus;
+
+	configASSERT( xTaskToNotify );
+
+	uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+	{
+		xReturn = prvNotify( pxTCB, ulValue, eAction, pulPreviousNotificationValue, &ucOriginalNotifyState );
+
+		if( ucOriginalNotifyState == taskWAITING_NOTIFICATION )
+		{
+			configASSERT( listLIST_ITEM_CONTAINER( &( pxTCB->xEventListItem ) ) == NULL );
+
+			if( uxSchedulerSuspended == ( UBaseType_t ) pdFALSE )
+			{
+				( void ) uxListRemove( &( pxTCB->xStateListItem ) );
+				prvAddTaskToReadyList( pxTCB );
+			}
+			else
+			{
+				vListInsertEnd( &( xPendingReadyList ), &( pxTCB->xEventListItem ) );
+			}
+
+			if( pxTCB->uxPriority > pxCurrentTCB->uxPriority )
+			{
+				if( pxHigherPriorityTaskWoken != NULL )
+				{
+					*pxHigherPriorityTaskWoken = pdTRUE;
+				}
+				xYieldPending = pdTRUE;
+			}
+		}
+	}
+	portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+
+	return xReturn;
+}
+
+void vTaskNotifyGiveFromISR( TaskHandle_t xTaskToNotify, BaseType_t *pxHigherPriorityTaskWoken )
+{
+	( void ) xTaskGenericNotifyFromISR( xTaskToNotify, 0, eIncrement, NULL, pxHigherPriorityTaskWoken );
+}
+
+BaseType_t xTaskNotifyStateClear( TaskHandle_t xTask )
+{
+	TCB_t *pxTCB;
+	BaseType_t xReturn;
+
+	pxTCB = prvGetTCBFromHandle( xTask );
+
+	taskENTER_CRITICAL();
+	{
+		if( pxTCB->ucNotifyState == taskNOTIFICATION_RECEIVED )
+		{
+			pxTCB->ucNotifyState = taskNOT_WAITING_NOTIFICATION;
+			xReturn = pdPASS;
+		}
+		else
+		{
+			xReturn = pdFAIL;
+		}
+	}
+	taskEXIT_CRITICAL();
+
+	return xReturn;
+}
+
+/*-----------------------------------------------------------
+ * Internals
+ *----------------------------------------------------------*/
+
+static void prvAddCurrentTaskToDelayedList( TickType_t xTicksToWait, const BaseType_t xCanBlockIndefinitely )
+{
+	TickType_t xTimeToWake;
+	const TickType_t xConstTickCount = xTickCount;
+
+	pxCurrentTCB->ucDelayAborted = pdFALSE;
+
+	if( uxListRemove( &( pxCurrentTCB->xStateListItem ) ) == ( UBaseType_t ) 0 )
+	{
+		portRESET_READY_PRIORITY( pxCurrentTCB->uxPriority, uxTopReadyPriority );
+	}
+
+	if( ( xTicksToWait == portMAX_DELAY ) && ( xCanBlockIndefinitely != pdFALSE ) )
+	{
+		vListInsertEnd( &xSuspendedTaskList, &( pxCurrentTCB->xStateListItem ) );
+		return;
+	}
+
+	xTimeToWake = xConstTickCount + xTicksToWait;
+	listSET_LIST_ITEM_VALUE( &( pxCurrentTCB->xStateListItem ), xTimeToWake );
+
+	if( xTimeToWake < xConstTickCount )
+	{
+		vListInsert( pxOverflowDelayedTaskList, &( pxCurrentTCB->xStateListItem ) );
+	}
+	else
+	{
+		vListInsert( pxDelayedTaskList, &( pxCurrentTCB->xStateListItem ) );
+
+		if( xTimeToWake < xNextTaskUnblockTime )
+		{
+			xNextTaskUnblockTime = xTimeToWake;
+		}
+	}
+}
+
+/*
+ * The idle task frees what deleted tasks left behind and otherwise
+ * sleeps until the next interrupt, so an idle sandbox does not spin
+ * a host CPU.
+ */
+static portTASK_FUNCTION( prvIdleTask, pvParameters )
+{
+	( void ) pvParameters;
+
+	for( ;; )
+	{
+		prvCheckTasksWaitingTermination();
+
+#if ( ( configUSE_PREEMPTION == 1 ) && ( configIDLE_SHOULD_YIELD == 1 ) )
+		if( listCURRENT_LIST_LENGTH( &( pxReadyTasksLists[ tskIDLE_PRIORITY ] ) ) > ( UBaseType_t ) 1 )
+		{
+			taskYIELD();
+			continue;
+		}
+#endif
+
+		portWAIT_FOR_INTERRUPT();
+	}
+}
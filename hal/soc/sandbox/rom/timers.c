@@ -0,0 +1,631 @@
+/*
+ * Copyright 2024-2024 Senscomm Semiconductor Co., Ltd.	All rights reserved.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Sandbox FreeRTOS kernel: software timers and the timer task
+ * (see tasks.c).
+ */
+
+#include <stdlib.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "timers.h"
+
+#if ( configUSE_TIMERS == 1 )
+
+#define tmrNO_DELAY		( TickType_t ) 0U
+
+#define tmrSTATUS_IS_ACTIVE			( ( uint8_t ) 0x01 )
+#define tmrSTATUS_IS_STATICALLY_ALLOCATED	( ( uint8_t ) 0x02 )
+#define tmrSTATUS_IS_AUTORELOAD			( ( uint8_t ) 0x04 )
+
+/* The layout must match StaticTimer_t. */
+typedef struct tmrTimerControl
+{
+	const char *pcTimerName;
+	ListItem_t xTimerListItem;
+	TickType_t xTimerPeriodInTicks;
+	void *pvTimerID;
+	TimerCallbackFunction_t pxCallbackFunction;
+	UBaseType_t uxTimerNumber;
+	uint8_t ucStatus;
+} xTIMER;
+
+typedef xTIMER Timer_t;
+
+typedef struct tmrTimerParameters
+{
+	TickType_t xMessageValue;
+	Timer_t *pxTimer;
+} TimerParameter_t;
+
+typedef struct tmrCallbackParameters
+{
+	PendedFunction_t pxCallbackFunction;
+	void *pvParameter1;
+	uint32_t ulParameter2;
+} CallbackParameters_t;
+
+typedef struct tmrTimerQueueMessage
+{
+	BaseType_t xMessageID;
+	union
+	{
+		TimerParameter_t xTimerParameters;
+		CallbackParameters_t xCallbackParameters;
+	} u;
+} DaemonTaskMessage_t;
+
+PRIVILEGED_DATA static List_t xActiveTimerList1;
+PRIVILEGED_DATA static List_t xActiveTimerList2;
+PRIVILEGED_DATA static List_t *pxCurrentTimerList;
+PRIVILEGED_DATA static List_t *pxOverflowTimerList;
+
+PRIVILEGED_DATA static QueueHandle_t xTimerQueue = NULL;
+PRIVILEGED_DATA static TaskHandle_t xTimerTaskHandle = NULL;
+
+static void prvCheckForValidListAndQueue( void );
+static void prvSwitchTimerLists( void );
+static portTASK_FUNCTION_PROTO( prvTimerTask, pvParameters );
+
+BaseType_t xTimerCreateTimerTask( void )
+{
+	BaseType_t xReturn = pdFAIL;
+
+	prvCheckForValidListAndQueue();
+
+	if( xTimerQueue != NULL )
+	{
+		xReturn = xTaskCreate( prvTimerTask,
+				       configTIMER_SERVICE_TASK_NAME,
+				       configTIMER_TASK_STACK_DEPTH,
+				       NULL,
+				       ( ( UBaseType_t ) configTIMER_TASK_PRIORITY ) | portPRIVILEGE_BIT,
+				       &xTimerTaskHandle );
+	}
+
+	configASSERT( xReturn );
+	return xReturn;
+}
+
+static void prvInitialiseNewTimer( const char * const pcTimerName,
+				   const TickType_t xTimerPeriodInTicks,
+				   const UBaseType_t uxAutoReload,
+				   void * const pvTimerID,
+				   TimerCallbackFunction_t pxCallbackFunction,
+				   Timer_t *pxNewTimer )
+{
+	configASSERT( ( xTimerPeriodInTicks > 0 ) );
+
+	prvCheckForValidListAndQueue();
+
+	pxNewTimer->pcTimerName = pcTimerName;
+	pxNewTimer->xTimerPeriodInTicks = xTimerPeriodInTicks;
+	pxNewTimer->pvTimerID = pvTimerID;
+	pxNewTimer->pxCallbackFunction = pxCallbackFunction;
+	pxNewTimer->uxTimerNumber = 0;
+	vListInitialiseItem( &( pxNewTimer->xTimerListItem ) );
+
+	if( uxAutoReload != pdFALSE )
+	{
+		pxNewTimer->ucStatus |= tmrSTATUS_IS_AUTORELOAD;
+	}
+}
+
+TimerHandle_t xTimerCreate( const char * const pcTimerName,
+			    const TickType_t xTimerPeriodInTicks,
+			    const UBaseType_t uxAutoReload,
+			    void * const pvTimerID,
+			    TimerCallbackFunction_t pxCallbackFunction )
+{
+	Timer_t *pxNewTimer;
+
+	pxNewTimer = ( Timer_t * ) pvPortMalloc( sizeof( Timer_t ) );
+	if( pxNewTimer != NULL )
+	{
+		pxNewTimer->ucStatus = 0x00;
+		prvInitialiseNewTimer( pcTimerName, xTimerPeriodInTicks, uxAutoReload, pvTimerID, pxCallbackFunction, pxNewTimer );
+	}
+
+	return pxNewTimer;
+}
+
+TimerHandle_t xTimerCreateStatic( const char * const pcTimerName,
+				  const TickType_t xTimerPeriodInTicks,
+				  const UBaseType_t uxAutoReload,
+				  void * const pvTimerID,
+				  TimerCallbackFunction_t pxCallbackFunction,
+				  StaticTimer_t *pxTimerBuffer )
+{
+	Timer_t *pxNewTimer;
+
+	configASSERT( sizeof( StaticTimer_t ) == sizeof( Timer_t ) );
+	configASSERT( pxTimerBuffer );
+
+	pxNewTimer = ( Timer_t * ) pxTimerBuffer;
+	if( pxNewTimer != NULL )
+	{
+		pxNewTimer->ucStatus = tmrSTATUS_IS_STATICALLY_ALLOCATED;
+		prvInitialiseNewTimer( pcTimerName, xTimerPeriodInTicks, uxAutoReload, pvTimerID, pxCallbackFunction, pxNewTimer );
+	}
+
+	return pxNewTimer;
+}
+
+BaseType_t xTimerGenericCommand( TimerHandle_t xTimer, const BaseType_t xCommandID, const TickType_t xOptionalValue, BaseType_t * const pxHigherPriorityTaskWoken, const TickType_t xTicksToWait )
+{
+	BaseType_t xReturn = pdFAIL;
+	DaemonTaskMessage_t xMessage;
+
+	configASSERT( xTimer );
+
+	if( xTimerQueue == NULL )
+	{
+		return pdFAIL;
+	}
+
+	xMessage.xMessageID = xCommandID;
+	xMessage.u.xTimerParameters.xMessageValue = xOptionalValue;
+	xMessage.u.xTimerParameters.pxTimer = xTimer;
+
+	if( xCommandID < tmrFIRST_FROM_ISR_COMMAND )
+	{
+		if( xTaskGetSchedulerState() == taskSCHEDULER_RUNNING )
+		{
+			xReturn = xQueueSendToBack( xTimerQueue, &xMessage, xTicksToWait );
+		}
+		else
+		{
+			xReturn = xQueueSendToBack( xTimerQueue, &xMessage, tmrNO_DELAY );
+		}
+	}
+	else
+	{
+		xReturn = xQueueSendToBackFromISR( xTimerQueue, &xMessage, pxHigherPriorityTaskWoken );
+	}
+
+	return xReturn;
+}
+
+TaskHandle_t xTimerGetTimerDaemonTaskHandle( void )
+{
+	configASSERT( ( xTimerTaskHandle != NULL ) );
+	return xTimerTaskHandle;
+}
+
+TickType_t xTimerGetPeriod( TimerHandle_t xTimer )
+{
+	Timer_t *pxTimer = xTimer;
+
+	configASSERT( xTimer );
+	return pxTimer->xTimerPeriodInTicks;
+}
+
+void vTimerSetReloadMode( TimerHandle_t xTimer, const UBaseType_t uxAutoReload )
+{
+	Timer_t *pxTimer = xTimer;
+
+	configASSERT( xTimer );
+	taskENTER_CRITICAL();
+	{
+		if( uxAutoReload != pdFALSE )
+		{
+			pxTimer->ucStatus |= tmrSTATUS_IS_AUTORELOAD;
+		}
+		else
+		{
+			pxTimer->ucStatus &= ~tmrSTATUS_IS_AUTORELOAD;
+		}
+	}
+	taskEXIT_CRITICAL();
+}
+
+TickType_t xTimerGetExpiryTime( TimerHandle_t xTimer )
+{
+	Timer_t *pxTimer = xTimer;
+
+	configASSERT( xTimer );
+	return listGET_LIST_ITEM_VALUE( &( pxTimer->xTimerListItem ) );
+}
+
+const char *pcTimerGetName( TimerHandle_t xTimer )
+{
+	Timer_t *pxTimer = xTimer;
+
+	configASSERT( xTimer );
+	return pxTimer->pcTimerName;
+}
+
+BaseType_t xTimerIsTimerActive( TimerHandle_t xTimer )
+{
+	BaseType_t xReturn;
+	Timer_t *pxTimer = xTimer;
+
+	configASSERT( xTimer );
+
+	taskENTER_CRITICAL();
+	{
+		xReturn = ( pxTimer->ucStatus & tmrSTATUS_IS_ACTIVE ) ? pdTRUE : pdFALSE;
+	}
+	taskEXIT_CRITICAL();
+
+	return xReturn;
+}
+
+void *pvTimerGetTimerID( const TimerHandle_t xTimer )
+{
+	Timer_t * const pxTimer = xTimer;
+	void *pvReturn;
+
+	configASSERT( xTimer );
+
+	taskENTER_CRITICAL();
+	{
+		pvReturn = pxTimer->pvTimerID;
+	}
+	taskEXIT_CRITICAL();
+
+	return pvReturn;
+}
+
+void vTimerSetTimerID( TimerHandle_t xTimer, void *pvNewID )
+{
+	Timer_t * const pxTimer = xTimer;
+
+	configASSERT( xTimer );
+
+	taskENTER_CRITICAL();
+	{
+		pxTimer->pvTimerID = pvNewID;
+	}
+	taskEXIT_CRITICAL();
+}
+
+BaseType_t xTimerPendFunctionCallFromISR( PendedFunction_t xFunctionToPend, void *pvParameter1, uint32_t ulParameter2, BaseType_t *pxHigherPriorityTaskWoken )
+{
+	DaemonTaskMessage_t xMessage;
+
+	xMessage.xMessageID = tmrCOMMAND_EXECUTE_CALLBACK_FROM_ISR;
+	xMessage.u.xCallbackParameters.pxCallbackFunction = xFunctionToPend;
+	xMessage.u.xCallbackParameters.pvParameter1 = pvParameter1;
+	xMessage.u.xCallbackParameters.ulParameter2 = ulParameter2;
+
+	return xQueueSendFromISR( xTimerQueue, &xMessage, pxHigherPriorityTaskWoken );
+}
+
+BaseType_t xTimerPendFunctionCall( PendedFunction_t xFunctionToPend, void *pvParameter1, uint32_t ulParameter2, TickType_t xTicksToWait )
+{
+	DaemonTaskMessage_t xMessage;
+
+	configASSERT( xTimerQueue );
+
+	xMessage.xMessageID = tmrCOMMAND_EXECUTE_CALLBACK;
+	xMessage.u.xCallbackParameters.pxCallbackFunction = xFunctionToPend;
+	xMessage.u.xCallbackParameters.pvParameter1 = pvParameter1;
+	xMessage.u.xCallbackParameters.ulParameter2 = ulParameter2;
+
+	return xQueueSendToBack( xTimerQueue, &xMessage, xTicksToWait );
+}
+
+UBaseType_t uxTimerGetTimerNumber( TimerHandle_t xTimer )
+{
+	return ( ( Timer_t * ) xTimer )->uxTimerNumber;
+}
+
+void vTimerSetTimerNumber( TimerHandle_t xTimer, UBaseType_t uxTimerNumber )
+{
+	( ( Timer_t * ) xTimer )->uxTimerNumber = uxTimerNumber;
+}
+
+/*-----------------------------------------------------------
+ * The timer task
+ *----------------------------------------------------------*/
+
+static BaseType_t prvInsertTimerInActiveList( Timer_t * const pxTimer, const TickType_t xNextExpiryTime, const TickType_t xTimeNow, const TickType_t xCommandTime )
+{
+	BaseType_t xProcessTimerNow = pdFALSE;
+
+	listSET_LIST_ITEM_VALUE( &( pxTimer->xTimerListItem ), xNextExpiryTime );
+	listSET_LIST_ITEM_OWNER( &( pxTimer->xTimerListItem ), pxTimer );
+
+	if( xNextExpiryTime <= xTimeNow )
+	{
+		/* Already due, unless the period is smaller than the delay in processing the command. */
+		if( ( ( TickType_t ) ( xTimeNow - xCommandTime ) ) >= pxTimer->xTimerPeriodInTicks )
+		{
+			xProcessTimerNow = pdTRUE;
+		}
+		else
+		{
+			vListInsert( pxOverflowTimerList, &( pxTimer->xTimerListItem ) );
+		}
+	}
+	else
+	{
+		if( ( xTimeNow < xCommandTime ) && ( xNextExpiryTime >= xCommandTime ) )
+		{
+			/* The tick count overflowed since the command was issued and the expiry has passed. */
+			xProcessTimerNow = pdTRUE;
+		}
+		else
+		{
+			vListInsert( pxCurrentTimerList, &( pxTimer->xTimerListItem ) );
+		}
+	}
+
+	return xProcessTimerNow;
+}
+
+static void prvProcessExpiredTimer( const TickType_t xNextExpireTime, const TickType_t xTimeNow )
+{
+	BaseType_t xResult;
+	Timer_t * const pxTimer = ( Timer_t * ) listGET_OWNER_OF_HEAD_ENTRY( pxCurrentTimerList );
+
+	( void ) uxListRemove( &( pxTimer->xTimerListItem ) );
+
+	if( ( pxTimer->ucStatus & tmrSTATUS_IS_AUTORELOAD ) != 0 )
+	{
+		if( prvInsertTimerInActiveList( pxTimer, ( xNextExpireTime + pxTimer->xTimerPeriodInTicks ), xTimeNow, xNextExpireTime ) != pdFALSE )
+		{
+			xResult = xTimerGenericCommand( pxTimer, tmrCOMMAND_START_DONT_TRACE, xNextExpireTime, NULL, tmrNO_DELAY );
+			configASSERT( xResult );
+			( void ) xResult;
+		}
+	}
+	else
+	{
+		pxTimer->ucStatus &= ~tmrSTATUS_IS_ACTIVE;
+	}
+
+	pxTimer->pxCallbackFunction( ( TimerHandle_t ) pxTimer );
+}
+
+static TickType_t prvGetNextExpireTime( BaseType_t * const pxListWasEmpty )
+{
+	TickType_t xNextExpireTime;
+
+	*pxListWasEmpty = listLIST_IS_EMPTY( pxCurrentTimerList );
+	if( *pxListWasEmpty == pdFALSE )
+	{
+		xNextExpireTime = listGET_ITEM_VALUE_OF_HEAD_ENTRY( pxCurrentTimerList );
+	}
+	else
+	{
+		/* Wake on the tick count overflow, to switch lists. */
+		xNextExpireTime = ( TickType_t ) 0U;
+	}
+
+	return xNextExpireTime;
+}
+
+static TickType_t prvSampleTimeNow( BaseType_t * const pxTimerListsWereSwitched )
+{
+	TickType_t xTimeNow;
+	PRIVILEGED_DATA static TickType_t xLastTime = ( TickType_t ) 0U;
+
+	xTimeNow = xTaskGetTickCount();
+
+	if( xTimeNow < xLastTime )
+	{
+		prvSwitchTimerLists();
+		*pxTimerListsWereSwitched = pdTRUE;
+	}
+	else
+	{
+		*pxTimerListsWereSwitched = pdFALSE;
+	}
+
+	xLastTime = xTimeNow;
+
+	return xTimeNow;
+}
+
+static void prvProcessTimerOrBlockTask( const TickType_t xNextExpireTime, BaseType_t xListWasEmpty )
+{
+	TickType_t xTimeNow;
+	BaseType_t xTimerListsWereSwitched;
+
+	vTaskSuspendAll();
+	{
+		xTimeNow = prvSampleTimeNow( &xTimerListsWereSwitched );
+		if( xTimerListsWereSwitched == pdFALSE )
+		{
+			if( ( xListWasEmpty == pdFALSE ) && ( xNextExpireTime <= xTimeNow ) )
+			{
+				( void ) xTaskResumeAll();
+				prvProcessExpiredTimer( xNextExpireTime, xTimeNow );
+			}
+			else
+			{
+				if( xListWasEmpty != pdFALSE )
+				{
+					/* Nothing but the overflow list to wait for, or nothing at all. */
+					xListWasEmpty = listLIST_IS_EMPTY( pxOverflowTimerList );
+				}
+
+				vQueueWaitForMessageRestricted( xTimerQueue, ( xNextExpireTime - xTimeNow ), xListWasEmpty );
+
+				if( xTaskResumeAll() == pdFALSE )
+				{
+					portYIELD_WITHIN_API();
+				}
+			}
+		}
+		else
+		{
+			( void ) xTaskResumeAll();
+		}
+	}
+}
+
+static void prvProcessReceivedCommands( void )
+{
+	DaemonTaskMessage_t xMessage;
+	Timer_t *pxTimer;
+	BaseType_t xTimerListsWereSwitched, xResult;
+	TickType_t xTimeNow;
+
+	while( xQueueReceive( xTimerQueue, &xMessage, tmrNO_DELAY ) != pdFAIL )
+	{
+		if( xMessage.xMessageID < ( BaseType_t ) 0 )
+		{
+			const CallbackParameters_t * const pxCallback = &( xMessage.u.xCallbackParameters );
+
+			configASSERT( pxCallback );
+			pxCallback->pxCallbackFunction( pxCallback->pvParameter1, pxCallback->ulParameter2 );
+			continue;
+		}
+
+		pxTimer = xMessage.u.xTimerParameters.pxTimer;
+
+		if( listIS_CONTAINED_WITHIN( NULL, &( pxTimer->xTimerListItem ) ) == pdFALSE )
+		{
+			( void ) uxListRemove( &( pxTimer->xTimerListItem ) );
+		}
+
+		/* After the list removal, in case the lists get switched here. */
+		xTimeNow = prvSampleTimeNow( &xTimerListsWereSwitched );
+
+		switch( xMessage.xMessageID )
+		{
+			case tmrCOMMAND_START:
+			case tmrCOMMAND_START_FROM_ISR:
+			case tmrCOMMAND_RESET:
+			case tmrCOMMAND_RESET_FROM_ISR:
+			case tmrCOMMAND_START_DONT_TRACE:
+				pxTimer->ucStatus |= tmrSTATUS_IS_ACTIVE;
+				if( prvInsertTimerInActiveList( pxTimer, xMessage.u.xTimerParameters.xMessageValue + pxTimer->xTimerPeriodInTicks, xTimeNow, xMessage.u.xTimerParameters.xMessageValue ) != pdFALSE )
+				{
+					pxTimer->pxCallbackFunction( ( TimerHandle_t ) pxTimer );
+
+					if( ( pxTimer->ucStatus & tmrSTATUS_IS_AUTORELOAD ) != 0 )
+					{
+						xResult = xTimerGenericCommand( pxTimer, tmrCOMMAND_START_DONT_TRACE, xMessage.u.xTimerParameters.xMessageValue + pxTimer->xTimerPeriodInTicks, NULL, tmrNO_DELAY );
+						configASSERT( xResult );
+						( void ) xResult;
+					}
+					else
+					{
+						pxTimer->ucStatus &= ~tmrSTATUS_IS_ACTIVE;
+					}
+				}
+				break;
+
+			case tmrCOMMAND_STOP:
+			case tmrCOMMAND_STOP_FROM_ISR:
+				pxTimer->ucStatus &= ~tmrSTATUS_IS_ACTIVE;
+				break;
+
+			case tmrCOMMAND_CHANGE_PERIOD:
+			case tmrCOMMAND_CHANGE_PERIOD_FROM_ISR:
+				pxTimer->ucStatus |= tmrSTATUS_IS_ACTIVE;
+				pxTimer->xTimerPeriodInTicks = xMessage.u.xTimerParameters.xMessageValue;
+				configASSERT( ( pxTimer->xTimerPeriodInTicks > 0 ) );
+				( void ) prvInsertTimerInActiveList( pxTimer, ( xTimeNow + pxTimer->xTimerPeriodInTicks ), xTimeNow, xTimeNow );
+				break;
+
+			case tmrCOMMAND_DELETE:
+				if( ( pxTimer->ucStatus & tmrSTATUS_IS_STATICALLY_ALLOCATED ) == ( uint8_t ) 0 )
+				{
+					vPortFree( pxTimer );
+				}
+				else
+				{
+					pxTimer->ucStatus &= ~tmrSTATUS_IS_ACTIVE;
+				}
+				break;
+
+			default:
+				break;
+		}
+	}
+}
+
+static void prvSwitchTimerLists( void )
+{
+	TickType_t xNextExpireTime, xReloadTime;
+	List_t *pxTemp;
+	Timer_t *pxTimer;
+	BaseType_t xResult;
+
+	/* Everything left in the current list expired before the overflow. */
+	while( listLIST_IS_EMPTY( pxCurrentTimerList ) == pdFALSE )
+	{
+		xNextExpireTime = listGET_ITEM_VALUE_OF_HEAD_ENTRY( pxCurrentTimerList );
+
+		pxTimer = ( Timer_t * ) listGET_OWNER_OF_HEAD_ENTRY( pxCurrentTimerList );
+		( void ) uxListRemove( &( pxTimer->xTimerListItem ) );
+
+		pxTimer->pxCallbackFunction( ( TimerHandle_t ) pxTimer );
+
+		if( ( pxTimer->ucStatus & tmrSTATUS_IS_AUTORELOAD ) != 0 )
+		{
+			xReloadTime = ( xNextExpireTime + pxTimer->xTimerPeriodInTicks );
+			if( xReloadTime > xNextExpireTime )
+			{
+				listSET_LIST_ITEM_VALUE( &( pxTimer->xTimerListItem ), xReloadTime );
+				listSET_LIST_ITEM_OWNER( &( pxTimer->xTimerListItem ), pxTimer );
+				vListInsert( pxCurrentTimerList, &( pxTimer->xTimerListItem ) );
+			}
+			else
+			{
+				xResult = xTimerGenericCommand( pxTimer, tmrCOMMAND_START_DONT_TRACE, xNextExpireTime, NULL, tmrNO_DELAY );
+				configASSERT( xResult );
+				( void ) xResult;
+			}
+		}
+		else
+		{
+			pxTimer->ucStatus &= ~tmrSTATUS_IS_ACTIVE;
+		}
+	}
+
+	pxTemp = pxCurrentTimerList;
+	pxCurrentTimerList = pxOverflowTimerList;
+	pxOverflowTimerList = pxTemp;
+}
+
+static portTASK_FUNCTION( prvTimerTask, pvParameters )
+{
+	TickType_t xNextExpireTime;
+	BaseType_t xListWasEmpty;
+
+	( void ) pvParameters;
+
+	for( ;; )
+	{
+		xNextExpireTime = prvGetNextExpireTime( &xListWasEmpty );
+		prvProcessTimerOrBlockTask( xNextExpireTime, xListWasEmpty );
+		prvProcessReceivedCommands();
+	}
+}
+
+static void prvCheckForValidListAndQueue( void )
+{
+	taskENTER_CRITICAL();
+	{
+		if( xTimerQueue == NULL )
+		{
+			vListInitialise( &xActiveTimerList1 );
+			vListInitialise( &xActiveTimerList2 );
+			pxCurrentTimerList = &xActiveTimerList1;
+			pxOverflowTimerList = &xActiveTimerList2;
+
+			xTimerQueue = xQueueCreate( ( UBaseType_t ) configTIMER_QUEUE_LENGTH, sizeof( DaemonTaskMessage_t ) );
+		}
+	}
+	taskEXIT_CRITICAL();
+}
+
+#endif /* configUSE_TIMERS == 1 */
@@ -0,0 +1,1019 @@
+/*
+ * Copyright 2024-2024 Senscomm Semiconductor Co., Ltd.	All rights reserved.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Sandbox VFS: the file descriptor table, devfs, the path based calls
+ * and poll/select, following what hal/fs/patch/vfsp.c patches into
+ * the ROM one.
+ *
+ * The <unistd.h> family maps open(), read(), stat() and the like to
+ * the os_*() pointers with function-like macros, so the filesystem and
+ * fops methods of the same names are called through parentheses here.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+#include <hal/kernel.h>
+#include <hal/init.h>
+#include <hal/kmem.h>
+#include <hal/compiler.h>
+#include <hal/console.h>
+#include <cmsis_os.h>
+
+#include "vfs.h"
+#include "xqueue.h"
+
+static struct file *vfs_fds[CONFIG_VFS_MAX_FDS];
+
+/* Holds a slot between get_free_fd() and install_fd(). */
+static struct file vfs_res;
+
+static LIST_HEAD_DEF(vfs_mounts);
+
+static osMutexId_t vfs_mtx;
+
+void _vfs_lock(void)
+{
+	if (vfs_mtx)
+		osMutexAcquire(vfs_mtx, osWaitForever);
+}
+
+__func_tab__ void (*vfs_lock)(void) = _vfs_lock;
+
+void _vfs_unlock(void)
+{
+	if (vfs_mtx)
+		osMutexRelease(vfs_mtx);
+}
+
+__func_tab__ void (*vfs_unlock)(void) = _vfs_unlock;
+
+/* File descriptors */
+
+int _vfs_get_free_fd(void)
+{
+	int fd;
+
+	vfs_lock();
+	for (fd = 0; fd < ARRAY_SIZE(vfs_fds); fd++) {
+		if (vfs_fds[fd] == NULL) {
+			vfs_fds[fd] = &vfs_res;
+			vfs_unlock();
+			return fd;
+		}
+	}
+	vfs_unlock();
+
+	return -ENFILE;
+}
+
+__func_tab__ int (*vfs_get_free_fd)(void) = _vfs_get_free_fd;
+
+void _vfs_free_fd(int fd)
+{
+	vfs_lock();
+	vfs_fds[fd] = NULL;
+	vfs_unlock();
+}
+
+__func_tab__ void (*vfs_free_fd)(int fd) = _vfs_free_fd;
+
+void _vfs_install_fd(int fd, struct file *file)
+{
+	vfs_fds[fd] = file;
+	file->f_fd = fd;
+}
+
+__func_tab__ void (*vfs_install_fd)(int fd, struct file *file) = _vfs_install_fd;
+
+struct file *_vfs_fd_to_file(int fd)
+{
+	struct file *file;
+
+	if (fd < 0 || fd >= ARRAY_SIZE(vfs_fds))
+		return NULL;
+
+	file = vfs_fds[fd];
+
+	return file == &vfs_res ? NULL : file;
+}
+
+__func_tab__ struct file *(*vfs_fd_to_file)(int fd) = _vfs_fd_to_file;
+
+/* File objects */
+
+void _vfs_init_file(struct file *file)
+{
+	memset(file, 0, sizeof(*file));
+	INIT_LIST_HEAD(&file->f_list);
+	file->f_lock = osMutexNew(NULL);
+	file->f_fd = -1;
+}
+
+__func_tab__ void (*vfs_init_file)(struct file *file) = _vfs_init_file;
+
+struct file *_vfs_alloc_file(void)
+{
+	struct file *file = kmalloc(sizeof(*file));
+
+	if (file == NULL)
+		return NULL;
+
+	vfs_init_file(file);
+	if (file->f_lock == NULL) {
+		kfree(file);
+		return NULL;
+	}
+
+	return file;
+}
+
+__func_tab__ struct file *(*vfs_alloc_file)(void) = _vfs_alloc_file;
+
+static bool vfs_put_file(struct file *file)
+{
+	osMutexAcquire(file->f_lock, osWaitForever);
+
+	if (!atomic_dec_and_test(&file->f_refcnt)) {
+		osMutexRelease(file->f_lock);
+		return false;
+	}
+
+	list_del_init(&file->f_list);
+	if (file->f_path)
+		kfree(file->f_path);
+	file->f_path = NULL;
+	osMutexRelease(file->f_lock);
+	osMutexDelete(file->f_lock);
+
+	return true;
+}
+
+void _vfs_destroy_file(struct file *file)
+{
+	vfs_put_file(file);
+}
+
+__func_tab__ void (*vfs_destroy_file)(struct file *file) = _vfs_destroy_file;
+
+void _vfs_free_file(struct file *file)
+{
+	if (vfs_put_file(file))
+		kfree(file);
+}
+
+__func_tab__ void (*vfs_free_file)(struct file *file) = _vfs_free_file;
+
+/* Filesystems */
+
+static bool vfs_path_under(const char *path, const char *root)
+{
+	size_t n = strlen(root);
+
+	if (strncmp(path, root, n))
+		return false;
+
+	return root[n - 1] == '/' || path[n] == '\0' || path[n] == '/';
+}
+
+struct filesystem *_vfs_find_filesystem(const char *pathname)
+{
+	struct filesystem *fs, *best = NULL;
+
+	if (pathname == NULL)
+		return NULL;
+
+	vfs_lock();
+	list_for_each_entry(fs, &vfs_mounts, fs_list) {
+		if (!vfs_path_under(pathname, fs->root))
+			continue;
+		if (best == NULL || strlen(fs->root) > strlen(best->root))
+			best = fs;
+	}
+	vfs_unlock();
+
+	return best;
+}
+
+__func_tab__ struct filesystem *(*vfs_find_filesystem)(const char *pathname) = _vfs_find_filesystem;
+
+static int vfs_init(void)
+{
+	struct filesystem *fs;
+	int ret;
+
+	vfs_mtx = osMutexNew(NULL);
+
+	for (fs = filesystem_start(); fs < filesystem_end(); fs++) {
+		ret = fs->mount ? fs->mount(fs, fs->source, fs->root, 0, NULL) : 0;
+		if (ret < 0) {
+			printk("VFS: %s on %s failed (%d)\n", fs->name,
+			       fs->root, ret);
+			continue;
+		}
+		vfs_lock();
+		list_add_tail(&fs->fs_list, &vfs_mounts);
+		vfs_unlock();
+	}
+
+	return 0;
+}
+__initcall__(filesystem, vfs_init);
+
+/* devfs */
+
+static struct devfs_data devfs_data = {
+	.files = LIST_HEAD_INIT(devfs_data.files),
+};
+
+struct file *_vfs_register_device_file(char *pathname, struct fops *fops,
+				       void *data)
+{
+	struct file *file = vfs_alloc_file();
+
+	if (file == NULL)
+		return NULL;
+
+	file->f_path = kmalloc(strlen(pathname) + 1);
+	if (file->f_path == NULL) {
+		vfs_free_file(file);
+		return NULL;
+	}
+	strcpy(file->f_path, pathname);
+	file->f_fops = fops;
+	file->f_priv = data;
+	file->f_type = FTYPE_DEVICE_FILE;
+	atomic_inc(&file->f_refcnt);
+
+	vfs_lock();
+	list_add_tail(&file->f_list, &devfs_data.files);
+	devfs_data.nr_files++;
+	vfs_unlock();
+
+	return file;
+}
+
+__func_tab__ struct file *(*vfs_register_device_file)(char *pathname, struct fops *fops, void *data) = _vfs_register_device_file;
+
+static struct file *devfs_lookup(const char *pathname)
+{
+	struct file *file, *found = NULL;
+
+	vfs_lock();
+	list_for_each_entry(file, &devfs_data.files, f_list) {
+		if (!strcmp(file->f_path, pathname)) {
+			found = file;
+			break;
+		}
+	}
+	vfs_unlock();
+
+	return found;
+}
+
+int devfs_mount(struct filesystem *fs, const char *source,
+		const char *target, unsigned long flags, const void *data)
+{
+	fs->private = &devfs_data;
+
+	return 0;
+}
+
+int devfs_open(struct file **filep, const char *pathname, int flags,
+	       mode_t mode)
+{
+	struct file *file = devfs_lookup(pathname);
+
+	if (file == NULL)
+		return -ENOENT;
+
+	*filep = file;
+
+	return 0;
+}
+
+int devfs_stat(const char *pathname, struct stat *sb)
+{
+	memset(sb, 0, sizeof(*sb));
+
+	if (!strcmp(pathname, "/dev") || !strcmp(pathname, "/dev/")) {
+		sb->st_mode = S_IFDIR | 0755;
+		return 0;
+	}
+
+	if (devfs_lookup(pathname) == NULL)
+		return -ENOENT;
+
+	sb->st_mode = S_IFCHR | 0666;
+
+	return 0;
+}
+
+struct devfs_DIR {
+	DIR dir;
+	int pos;
+	struct dirent de;
+};
+
+DIR *devfs_opendir(const char *pathname)
+{
+	struct devfs_DIR *d;
+
+	if (strcmp(pathname, "/dev") && strcmp(pathname, "/dev/")) {
+		errno = ENOTDIR;
+		return NULL;
+	}
+
+	d = kzalloc(sizeof(*d));
+	if (d == NULL) {
+		errno = ENOMEM;
+		return NULL;
+	}
+	d->dir.dir = d;
+
+	return &d->dir;
+}
+
+int devfs_closedir(DIR *dir)
+{
+	kfree(dir->dir);
+
+	return 0;
+}
+
+struct dirent *devfs_readdir(DIR *dir)
+{
+	struct devfs_DIR *d = dir->dir;
+	struct file *file;
+	struct dirent *de = NULL;
+	int i = 0;
+
+	vfs_lock();
+	list_for_each_entry(file, &devfs_data.files, f_list) {
+		if (i++ < d->pos)
+			continue;
+		d->de.d_ino = d->pos++;
+		/* Full paths, as spiffs has them, so stat() works on them. */
+		strlcpy(d->de.d_name, file->f_path, sizeof(d->de.d_name));
+		de = &d->de;
+		break;
+	}
+	vfs_unlock();
+
+	return de;
+}
+
+FILESYSTEM(devfs) = {
+	.name		= "devfs",
+	.root		= "/dev",
+	.fs_list	= LIST_HEAD_INIT(filesystem(devfs)->fs_list),
+	.mount		= devfs_mount,
+	.open		= devfs_open,
+	.stat		= devfs_stat,
+	.opendir	= devfs_opendir,
+	.closedir	= devfs_closedir,
+	.readdir	= devfs_readdir,
+};
+
+/* Path based calls */
+
+static int _os_open(const char *pathname, int flags, ...)
+{
+	struct file *file = NULL;
+	struct filesystem *fs;
+	int fd, ret;
+
+	if ((fd = vfs_get_free_fd()) < 0) {
+		errno = -fd;
+		return -1;
+	}
+	if ((fs = vfs_find_filesystem(pathname)) == NULL || fs->open == NULL) {
+		errno = ENOENT;
+		goto error;
+	}
+	ret = (fs->open)(&file, pathname, flags, 0);
+	if (ret < 0 || file == NULL) {
+		errno = ret < 0 ? -ret : ENOENT;
+		goto error;
+	}
+	file_get(file);
+	if (file->f_fops && file->f_fops->open) {
+		if ((ret = (file->f_fops->open)(file)) < 0) {
+			file_put(file);
+			if (file->f_type != FTYPE_DEVICE_FILE)
+				vfs_free_file(file);
+			errno = -ret;
+			goto error;
+		}
+	}
+	atomic_inc(&file->f_refcnt);
+	file->f_flags = flags;
+	file->f_fs = fs;
+	/* Device files keep the path they were registered with. */
+	if (file->f_type != FTYPE_DEVICE_FILE && file->f_path == NULL)
+		file->f_path = strdup(pathname);
+
+	vfs_install_fd(fd, file);
+	file_put(file);
+
+	return fd;
+
+ error:
+	vfs_free_fd(fd);
+	return -1;
+}
+
+__func_tab__ int (*os_open)(const char *pathname, int flags, ...) = _os_open;
+
+static int _os_creat(const char *pathname, mode_t mode)
+{
+	return os_open(pathname, O_CREAT | O_WRONLY | O_TRUNC, mode);
+}
+
+__func_tab__ int (*os_creat)(const char *pathname, mode_t mode) = _os_creat;
+
+static int _os_close(int fd)
+{
+	struct file *file = vfs_fd_to_file(fd);
+	int ret = 0;
+
+	if (file == NULL) {
+		errno = EBADF;
+		return -1;
+	}
+	file_get(file);
+	vfs_free_fd(fd);
+	file_put(file);
+
+	/* Device files are singletons and stay. */
+	if (file->f_fops && file->f_fops->release)
+		ret = (file->f_fops->release)(file);
+	else if (file->f_type != FTYPE_DEVICE_FILE)
+		vfs_free_file(file);
+
+	if (ret < 0) {
+		errno = -ret;
+		ret = -1;
+	}
+
+	return ret;
+}
+
+__func_tab__ int (*os_close)(int fd) = _os_close;
+
+static int _os_dup(int oldfd)
+{
+	struct file *file = vfs_fd_to_file(oldfd);
+	int fd;
+
+	if (file == NULL) {
+		errno = EBADF;
+		return -1;
+	}
+	if ((fd = vfs_get_free_fd()) < 0) {
+		errno = -fd;
+		return -1;
+	}
+	file_get(file);
+	vfs_install_fd(fd, file);
+
+	return fd;
+}
+
+__func_tab__ int (*os_dup)(int fd) = _os_dup;
+
+static int _os_stat(const char *pathname, struct stat *statbuf)
+{
+	struct filesystem *fs = vfs_find_filesystem(pathname);
+	int ret;
+
+	if (fs == NULL || fs->stat == NULL) {
+		errno = ENOENT;
+		return -1;
+	}
+	ret = (fs->stat)(pathname, statbuf);
+	if (ret < 0) {
+		errno = -ret;
+		return -1;
+	}
+
+	return 0;
+}
+
+__func_tab__ int (*os_stat)(const char *pathname, struct stat *statbuf) = _os_stat;
+
+static int _os_fstat(int fd, struct stat *statbuf)
+{
+	struct file *file = vfs_fd_to_file(fd);
+
+	if (file == NULL) {
+		errno = EBADF;
+		return -1;
+	}
+
+	if (file->f_path && file->f_type == FTYPE_GENERIC_FILE)
+		return os_stat(file->f_path, statbuf);
+
+	memset(statbuf, 0, sizeof(*statbuf));
+	statbuf->st_mode = file->f_type == FTYPE_SOCKET ? S_IFSOCK : S_IFCHR;
+
+	return 0;
+}
+
+__func_tab__ int (*os_fstat)(int fd, struct stat *statbuf) = _os_fstat;
+
+static int _os_fsync(int fd)
+{
+	struct file *file = vfs_fd_to_file(fd);
+	int ret = 0;
+
+	if (file == NULL) {
+		errno = EBADF;
+		return -1;
+	}
+	if (file->f_fops && file->f_fops->fsync)
+		ret = (file->f_fops->fsync)(file);
+	if (ret < 0) {
+		errno = -ret;
+		return -1;
+	}
+
+	return 0;
+}
+
+__func_tab__ int (*os_fsync)(int fd) = _os_fsync;
+
+static ssize_t _os_read(int fd, void *buf, size_t count)
+{
+	struct file *file = vfs_fd_to_file(fd);
+	ssize_t ret;
+
+	if (file == NULL) {
+		errno = EBADF;
+		return -1;
+	}
+	if (file->f_fops == NULL || file->f_fops->read == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+	file_get(file);
+	ret = (file->f_fops->read)(file, buf, count, &file->f_pos);
+	file_put(file);
+	if (ret < 0) {
+		errno = -ret;
+		return -1;
+	}
+
+	return ret;
+}
+
+__func_tab__ ssize_t (*os_read)(int fd, void *buf, size_t count) = _os_read;
+
+static ssize_t _os_write(int fd, const void *buf, size_t count)
+{
+	struct file *file = vfs_fd_to_file(fd);
+	ssize_t ret;
+
+	if (file == NULL) {
+		errno = EBADF;
+		return -1;
+	}
+	if (file->f_fops == NULL || file->f_fops->write == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+	file_get(file);
+	ret = (file->f_fops->write)(file, (void *)buf, count, &file->f_pos);
+	file_put(file);
+	if (ret < 0) {
+		errno = -ret;
+		return -1;
+	}
+
+	return ret;
+}
+
+__func_tab__ ssize_t (*os_write)(int fd, const void *buf, size_t count) = _os_write;
+
+static off_t _os_lseek(int fd, off_t offset, int whence)
+{
+	struct file *file = vfs_fd_to_file(fd);
+	off_t ret;
+
+	if (file == NULL) {
+		errno = EBADF;
+		return -1;
+	}
+	if (file->f_fops == NULL || file->f_fops->llseek == NULL) {
+		errno = ESPIPE;
+		return -1;
+	}
+	ret = (file->f_fops->llseek)(file, offset, whence);
+	if (ret < 0) {
+		errno = -ret;
+		return -1;
+	}
+
+	return ret;
+}
+
+__func_tab__ off_t (*os_lseek)(int fd, off_t offset, int whence) = _os_lseek;
+
+static int _os_fcntl(int fd, int cmd, ...)
+{
+	struct file *file = vfs_fd_to_file(fd);
+	va_list ap;
+	int ret;
+
+	if (file == NULL) {
+		errno = EBADF;
+		return -1;
+	}
+
+	va_start(ap, cmd);
+	if (file->f_fops && file->f_fops->fcntl) {
+		ret = (file->f_fops->fcntl)(file, cmd, ap);
+	} else if (cmd == F_GETFL) {
+		ret = file->f_flags;
+	} else if (cmd == F_SETFL) {
+		file->f_flags = va_arg(ap, int);
+		ret = 0;
+	} else {
+		ret = -EINVAL;
+	}
+	va_end(ap);
+
+	if (ret < 0) {
+		errno = -ret;
+		return -1;
+	}
+
+	return ret;
+}
+
+__func_tab__ int (*os_fcntl)(int fd, int cmd, ...) = _os_fcntl;
+
+static int _os_ioctl(int fd, unsigned long request, void *arg)
+{
+	struct file *file = vfs_fd_to_file(fd);
+	int ret;
+
+	if (file == NULL) {
+		errno = EBADF;
+		return -1;
+	}
+	if (file->f_fops == NULL || file->f_fops->ioctl == NULL) {
+		errno = ENOTTY;
+		return -1;
+	}
+	ret = (file->f_fops->ioctl)(file, request, arg);
+	if (ret < 0) {
+		errno = -ret;
+		return -1;
+	}
+
+	return ret;
+}
+
+__func_tab__ int (*os_ioctl)(int fd, unsigned long request, void *arg) = _os_ioctl;
+
+static int _os_remove(const char *pathname)
+{
+	struct filesystem *fs = vfs_find_filesystem(pathname);
+	int ret;
+
+	if (fs == NULL || fs->remove == NULL) {
+		errno = ENOENT;
+		return -1;
+	}
+	ret = (fs->remove)(pathname);
+	if (ret < 0) {
+		errno = -ret;
+		return -1;
+	}
+
+	return 0;
+}
+
+__func_tab__ int (*os_remove)(const char *pathname) = _os_remove;
+
+static int _os_rename(const char *oldpath, const char *newpath)
+{
+	struct filesystem *fs = vfs_find_filesystem(oldpath);
+	int ret;
+
+	if (fs == NULL || fs->rename == NULL) {
+		errno = ENOENT;
+		return -1;
+	}
+	if (fs != vfs_find_filesystem(newpath)) {
+		errno = EXDEV;
+		return -1;
+	}
+	ret = (fs->rename)(oldpath, newpath);
+	if (ret < 0) {
+		errno = -ret;
+		return -1;
+	}
+
+	return 0;
+}
+
+__func_tab__ int (*os_rename)(const char *oldpath, const char *newpath) = _os_rename;
+
+/*
+ * A DIR handed out by os_opendir() remembers the filesystem it came
+ * from, for readdir() and closedir().
+ */
+struct vfs_DIR {
+	DIR dir;
+	struct filesystem *fs;
+	DIR *fs_dir;
+};
+
+static DIR *_os_opendir(const char *name)
+{
+	struct filesystem *fs = vfs_find_filesystem(name);
+	struct vfs_DIR *d;
+	DIR *fs_dir;
+
+	if (fs == NULL || fs->opendir == NULL) {
+		errno = ENOENT;
+		return NULL;
+	}
+	fs_dir = (fs->opendir)(name);
+	if (fs_dir == NULL)
+		return NULL;
+
+	d = kmalloc(sizeof(*d));
+	if (d == NULL) {
+		(fs->closedir)(fs_dir);
+		errno = ENOMEM;
+		return NULL;
+	}
+	d->dir.dir = d;
+	d->fs = fs;
+	d->fs_dir = fs_dir;
+
+	return &d->dir;
+}
+
+__func_tab__ DIR *(*os_opendir)(const char *name) = _os_opendir;
+
+static int _os_closedir(DIR *dirp)
+{
+	struct vfs_DIR *d = dirp->dir;
+	int ret = 0;
+
+	if (d->fs->closedir)
+		ret = (d->fs->closedir)(d->fs_dir);
+	kfree(d);
+
+	return ret;
+}
+
+__func_tab__ int (*os_closedir)(DIR *dirp) = _os_closedir;
+
+static struct dirent *_os_readdir(DIR *dirp)
+{
+	struct vfs_DIR *d = dirp->dir;
+
+	if (d->fs->readdir == NULL)
+		return NULL;
+
+	return (d->fs->readdir)(d->fs_dir);
+}
+
+__func_tab__ struct dirent *(*os_readdir)(DIR *dirp) = _os_readdir;
+
+/*
+ * poll and select
+ *
+ * fops->poll() reports the current level of a file and hands the
+ * queues and semaphores that will signal a change to poll_add_wait(),
+ * which puts them in the queue set of the poll table. Nothing ready
+ * means waiting on the set, then asking every file again.
+ */
+
+struct poll_wait {
+	struct list_head list;
+	QueueSetMemberHandle_t wait;
+};
+
+#define POLL_QSET_LEN	32
+
+/*
+ * A binary semaphore that is already given does not signal the set
+ * again, so the wait on it is cut into slices.
+ */
+#define POLL_SLICE	pdMS_TO_TICKS(100)
+
+int _poll_add_wait(struct file *filp, QueueSetMemberHandle_t wait,
+		   struct poll_table *pt)
+{
+	struct poll_wait *pw;
+
+	if (pt == NULL || wait == NULL)
+		return 0;
+
+	list_for_each_entry(pw, &pt->head, list) {
+		if (pw->wait == wait)
+			return 0;
+	}
+
+	pw = kmalloc(sizeof(*pw));
+	if (pw == NULL) {
+		pt->error = -ENOMEM;
+		return pt->error;
+	}
+
+	/* Somebody else polling it already; the slices cover for that. */
+	if (queue_insert_set(wait, pt->qset) != pdPASS) {
+		kfree(pw);
+		return 0;
+	}
+
+	pw->wait = wait;
+	list_add_tail(&pw->list, &pt->head);
+
+	return 0;
+}
+
+__func_tab__ int (*poll_add_wait)(struct file *filp, QueueSetMemberHandle_t wait, struct poll_table *table) = _poll_add_wait;
+
+static void poll_free_table(struct poll_table *pt)
+{
+	struct poll_wait *pw, *tmp;
+
+	list_for_each_entry_safe(pw, tmp, &pt->head, list) {
+		queue_remove_set(pw->wait, pt->qset);
+		list_del(&pw->list);
+		kfree(pw);
+	}
+	vQueueDelete(pt->qset);
+}
+
+static int poll_scan(struct pollfd *fds, nfds_t nfds, struct poll_table *pt)
+{
+	struct file *file;
+	unsigned mask;
+	int i, n = 0;
+
+	for (i = 0; i < nfds; i++) {
+		fds[i].revents = 0;
+		if (fds[i].fd < 0)
+			continue;
+		file = vfs_fd_to_file(fds[i].fd);
+		if (file == NULL) {
+			fds[i].revents = POLLNVAL;
+			n++;
+			continue;
+		}
+		if (file->f_fops == NULL || file->f_fops->poll == NULL)
+			mask = POLLIN | POLLOUT;
+		else
+			mask = (file->f_fops->poll)(file, pt, &fds[i]);
+		fds[i].revents = mask & (fds[i].events | POLLERR | POLLHUP);
+		if (fds[i].revents)
+			n++;
+	}
+
+	return n;
+}
+
+static int _os_poll(struct pollfd *fds, nfds_t nfds, int timeout)
+{
+	struct poll_table pt;
+	TickType_t t0, left, slice;
+	int n;
+
+	if (nfds == 0) {
+		if (timeout > 0)
+			osDelay(pdMS_TO_TICKS(timeout));
+		return 0;
+	}
+
+	pt.qset = xQueueCreateSet(POLL_QSET_LEN);
+	if (pt.qset == NULL) {
+		errno = ENOMEM;
+		return -1;
+	}
+	INIT_LIST_HEAD(&pt.head);
+	pt.error = 0;
+
+	t0 = xTaskGetTickCount();
+	left = timeout < 0 ? portMAX_DELAY : pdMS_TO_TICKS(timeout);
+
+	for (;;) {
+		n = poll_scan(fds, nfds, &pt);
+		if (n || pt.error || left == 0)
+			break;
+
+		slice = left < POLL_SLICE ? left : POLL_SLICE;
+		while (xQueueSelectFromSet(pt.qset, slice)) {
+			/* Drain, so that the set can signal again. */
+			slice = 0;
+		}
+
+		if (timeout >= 0) {
+			TickType_t td = xTaskGetTickCount() - t0;
+
+			left = td >= pdMS_TO_TICKS(timeout) ? 0
+				: pdMS_TO_TICKS(timeout) - td;
+		}
+	}
+
+	poll_free_table(&pt);
+
+	if (pt.error) {
+		errno = -pt.error;
+		return -1;
+	}
+
+	return n;
+}
+
+__func_tab__ int (*os_poll)(struct pollfd *fds, nfds_t nfds, int timeout) = _os_poll;
+
+static int _os_select(int nfds, fd_set *readfds, fd_set *writefds,
+		      fd_set *exceptfds, struct timeval *timeout)
+{
+	struct pollfd *pfd;
+	int i, n = 0, ret, msec;
+
+	msec = timeout ? timeout->tv_sec * 1000 +
+		(timeout->tv_usec + 999) / 1000 : -1;
+
+	pfd = kzalloc(sizeof(*pfd) * (nfds ? nfds : 1));
+	if (pfd == NULL) {
+		errno = ENOMEM;
+		return -1;
+	}
+
+	for (i = 0; i < nfds; i++) {
+		short events = 0;
+
+		if (readfds && FD_ISSET(i, readfds))
+			events |= POLLIN;
+		if (writefds && FD_ISSET(i, writefds))
+			events |= POLLOUT;
+		if (exceptfds && FD_ISSET(i, exceptfds))
+			events |= POLLPRI;
+		if (events) {
+			pfd[n].fd = i;
+			pfd[n].events = events;
+			n++;
+		}
+	}
+
+	ret = os_poll(pfd, n, msec);
+	if (ret < 0)
+		goto out;
+
+	if (readfds)
+		FD_ZERO(readfds);
+	if (writefds)
+		FD_ZERO(writefds);
+	if (exceptfds)
+		FD_ZERO(exceptfds);
+
+	for (i = 0, ret = 0; i < n; i++) {
+		if (pfd[i].revents & POLLNVAL) {
+			errno = EBADF;
+			ret = -1;
+			goto out;
+		}
+		if (readfds && (pfd[i].revents & (POLLIN | POLLERR | POLLHUP))) {
+			FD_SET(pfd[i].fd, readfds);
+			ret++;
+		}
+		if (writefds && (pfd[i].revents & (POLLOUT | POLLERR))) {
+			FD_SET(pfd[i].fd, writefds);
+			ret++;
+		}
+		if (exceptfds && (pfd[i].revents & POLLPRI)) {
+			FD_SET(pfd[i].fd, exceptfds);
+			ret++;
+		}
+	}
+
+ out:
+	kfree(pfd);
+
+	return ret;
+}
+
+__func_tab__ int (*os_select)(int nfds, fd_set *readfds, fd_set *writefds, fd_set *exceptfds, struct timeval *timeout) = _os_select;
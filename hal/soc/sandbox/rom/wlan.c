@@ -0,0 +1,60 @@
+/*
+ * Copyright 2024-2024 Senscomm Semiconductor Co., Ltd.	All rights reserved.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Sandbox stand-in for the WLAN driver and net80211 entry points that
+ * the repeater and scdc link against. net80211 only ships as a RISC-V
+ * archive, so the host has no WLAN device: wlandev() finds nothing and
+ * both stay idle until one is attached.
+ */
+
+#include <hal/kernel.h>
+#include <hal/compiler.h>
+#include <hal/wlan.h>
+
+#include "kernel.h"
+#include "compat_if.h"
+#include "if_media.h"
+#include <net80211/ieee80211_var.h>
+
+struct device *_wlandev(int inst)
+{
+	return NULL;
+}
+
+__func_tab__ struct device *(*wlandev)(int inst) = _wlandev;
+
+/* Scan channel list and reassociation flag that fwil fills in. */
+struct ieee80211_scan_freq_list g_scan_freq;
+u32 freq_24GHz[STA_24G_SCAN_CH_MAX] = {
+	2412, 2417, 2422, 2427, 2432, 2437, 2442,
+	2447, 2452, 2457, 2462, 2467, 2472, 2484,
+};
+int g_hosted_reassoc;
+
+void _ieee80211_scan_iterate(struct ieee80211vap *vap,
+		ieee80211_scan_iter_func f, void *arg)
+{
+}
+
+__func_tab__ void (*ieee80211_scan_iterate)(struct ieee80211vap *vap,
+		ieee80211_scan_iter_func f, void *arg) = _ieee80211_scan_iterate;
+
+void _ieee80211_restore_privacye(struct ieee80211vap *vap)
+{
+}
+
+__func_tab__ void (*ieee80211_restore_privacye)(struct ieee80211vap *vap) = _ieee80211_restore_privacye;
+
+void ieee80211_del_rxs(struct mbuf *m)
+{
+}
@@ -0,0 +1,127 @@
+/*
+ * Copyright 2024-2024 Senscomm Semiconductor Co., Ltd.	All rights reserved.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <string.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <soc.h>
+#include <cmsis_os.h>
+#include <FreeRTOS/FreeRTOS.h>
+#include <FreeRTOS/task.h>
+#include <hal/kernel.h>
+#include <hal/device.h>
+#include <hal/machine.h>
+#include <hal/console.h>
+#include <hal/init.h>
+#include <hal/timer.h>
+
+#include <cli.h>
+
+/*
+ * There is no memory map to speak of; the heap is a plain array in the
+ * host process, sized by CONFIG_HEAP1_SIZE.
+ */
+size_t heap_total_size = CONFIG_HEAP1_SIZE;
+
+static u8 ucHeap[ CONFIG_HEAP1_SIZE ] __aligned(portBYTE_ALIGNMENT);
+
+static HeapRegion_t xHeapRegions[] = {
+  { ucHeap, CONFIG_HEAP1_SIZE },
+  { NULL,   0                     }
+};
+
+void heap_init(void)
+{
+	vPortDefineHeapRegions (xHeapRegions);
+}
+
+/* Sandbox SOC "IPs", all backed by the host */
+#ifdef CONFIG_SERIAL
+static declare_device_single(uart, 3) = {
+	.name = "sandbox-uart.0",
+};
+#endif
+
+#ifdef CONFIG_TIMER
+static declare_device_single(timer, 3) = {
+	.name = "timer.0",
+};
+#endif
+
+int sandbox_early_init(void)
+{
+	heap_init();
+
+	return 0;
+}
+__initcall__(early, sandbox_early_init);
+
+void hal_timer_init(void)
+{
+#ifdef CONFIG_WALL_TIMER
+	struct device *timer;
+
+	timer = device_get_by_name("timer.0");
+	if (!timer) {
+		printk("timer not found\n");
+		return;
+	}
+	device_bind_driver(timer, NULL);
+
+	timer_setup(timer, 0, HAL_TIMER_FREERUN, time_hz, NULL, NULL);
+	timer_start(timer, 0);
+	register_timer(timer);
+#endif
+}
+
+void park(void)
+{
+	hal_fini(subsystem);
+	hal_fini(filesystem);
+	hal_fini(early);
+	hal_fini(arch);
+
+	driver_deinit();
+}
+
+#ifdef CONFIG_CMD_RESET
+
+int do_reset(int argc, char *argv[])
+{
+	park();
+
+	/* There is nothing to reset to; leave it to whoever started us. */
+	vTaskEndScheduler();
+
+	/* will never be reached */
+
+	return CMD_RET_SUCCESS;
+}
+
+CMD(reset, do_reset,
+	"reset",
+	"exit the sandbox"
+);
+
+#endif
+
+void soc_init(void)
+{
+	printk("SOC: sandbox\n");
+
+#ifdef CONFIG_SANDBOX_TAP
+extern int sandbox_tapif_init(void);
+	if (sandbox_tapif_init() < 0) {
+		printk("sandbox_tapif_init: error!\n");
+	}
+#endif
+}
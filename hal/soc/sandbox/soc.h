@@ -0,0 +1,36 @@
+/*
+ * Copyright 2024-2024 Senscomm Semiconductor Co., Ltd.	All rights reserved.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __SOC_H__
+#define __SOC_H__
+
+#include <stdbool.h>
+
+/*
+ * Sandbox "SoC".
+ *
+ * There are no fixed interrupt lines: a host file descriptor is its
+ * own interrupt number and fires while it is readable (see irq.c).
+ */
+
+/* irq.c: virtual interrupt controller */
+bool sandbox_irq_pending(void);
+void sandbox_irq_dispatch(void);
+
+/* freertos port.c: deliver an interrupt to the running task */
+void sandbox_cpu_interrupt(void);
+
+/* hal/arch/sandbox/start.c: command line */
+extern const char *sandbox_flash_image;
+extern const char *sandbox_tap_name;
+
+#endif
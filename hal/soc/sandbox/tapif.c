@@ -0,0 +1,207 @@
+/*
+ * Copyright 2024-2024 Senscomm Semiconductor Co., Ltd.	All rights reserved.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+
+#include <FreeRTOS/FreeRTOS.h>
+#include <FreeRTOS/task.h>
+#include <FreeRTOS/semphr.h>
+
+#include <hal/kernel.h>
+#include <hal/irq.h>
+#include <hal/console.h>
+
+#include "lwip/netifapi.h"
+#include "lwip/etharp.h"
+#include "netif/ethernet.h"
+
+#include "freebsd/kernel.h"
+#include "freebsd/compat_if.h"
+#include "freebsd/if_var.h"
+#include "freebsd/if_types.h"
+#include "freebsd/ethernet.h"
+
+#include "soc.h"
+#include "host.h"
+
+/*
+ * lwIP netif over a host TAP device.
+ *
+ * The TAP fd is a virtual interrupt line; its handler only masks the
+ * line and kicks the "tapif" task, which drains the fd into the stack
+ * through tcpip_input() and unmasks the line again, the way a NIC
+ * driver defers RX to a task on the target.
+ *
+ * The host side is set up with e.g.
+ *   ip tuntap add dev tap0 mode tap user $USER
+ *   ip addr add 192.168.7.1/24 dev tap0 && ip link set tap0 up
+ */
+
+/* <linux/if_tun.h>, which cannot coexist with include/freebsd */
+#define TUNSETIFF	0x400454ca
+#define IFF_TAP		0x0002
+#define IFF_NO_PI	0x1000
+
+struct tap_ifreq {
+	char name[16];
+	short flags;
+	char pad[14];
+};
+
+#define TAP_MTU		1500
+#define TAP_FRAME_MAX	(TAP_MTU + SIZEOF_ETH_HDR + 4)
+
+static struct netif tap_netif;
+static SemaphoreHandle_t tap_rx_sem;
+static int tap_fd = -1;
+
+static err_t tapif_linkoutput(struct netif *netif, struct pbuf *p)
+{
+	u8 frame[TAP_FRAME_MAX];
+	u16 len;
+
+	if (p->tot_len > sizeof(frame))
+		return ERR_BUF;
+
+	len = pbuf_copy_partial(p, frame, p->tot_len, 0);
+	if (write(tap_fd, frame, len) != len) {
+		LINK_STATS_INC(link.err);
+		return ERR_IF;
+	}
+
+	LINK_STATS_INC(link.xmit);
+
+	return ERR_OK;
+}
+
+static int tapif_irq(int irq, void *data)
+{
+	portBASE_TYPE resched = pdFALSE;
+
+	disable_irq(irq);
+	xSemaphoreGiveFromISR(tap_rx_sem, &resched);
+	portEND_SWITCHING_ISR(resched);
+
+	return 0;
+}
+
+static void tapif_rx_task(void *arg)
+{
+	u8 frame[TAP_FRAME_MAX];
+	struct pbuf *p;
+	int len;
+
+	for (;;) {
+		xSemaphoreTake(tap_rx_sem, portMAX_DELAY);
+
+		while ((len = read(tap_fd, frame, sizeof(frame))) > 0) {
+			p = pbuf_alloc(PBUF_RAW, len, PBUF_POOL);
+			if (!p) {
+				LINK_STATS_INC(link.memerr);
+				continue;
+			}
+			pbuf_take(p, frame, len);
+			LINK_STATS_INC(link.recv);
+			if (tap_netif.input(p, &tap_netif) != ERR_OK)
+				pbuf_free(p);
+		}
+
+		enable_irq(tap_fd);
+	}
+}
+
+extern err_t ethernetif_ioctl(struct netif *, const long, const void *);
+
+static err_t tapif_init(struct netif *netif)
+{
+	struct ifnet *ifp;
+
+	/* The ifnet that ifconfig and friends see, as for lo. */
+	ifp = if_alloc(IFT_ETHER);
+	if (!ifp)
+		return ERR_MEM;
+
+	ifp->if_mtu = TAP_MTU;
+	ifp->if_flags = IFF_UP | IFF_BROADCAST | IFF_MULTICAST;
+	ifp->if_link_state = LINK_STATE_UP;
+	ifp->if_ioctl = ether_ioctl;
+
+	netif->state = ifp;
+	netif_set_ioctl_fn(netif, ethernetif_ioctl);
+
+	netif->name[0] = 't';
+	netif->name[1] = 'p';
+	netif->output = etharp_output;
+	netif->linkoutput = tapif_linkoutput;
+	netif->mtu = TAP_MTU;
+	netif->flags = NETIF_FLAG_BROADCAST | NETIF_FLAG_ETHARP |
+		NETIF_FLAG_ETHERNET | NETIF_FLAG_LINK_UP;
+
+	/* Locally administered */
+	netif->hwaddr_len = ETH_HWADDR_LEN;
+	netif->hwaddr[0] = 0x02;
+	netif->hwaddr[1] = 0x5c;
+	netif->hwaddr[2] = 0x4d;
+	netif->hwaddr[3] = 0x00;
+	netif->hwaddr[4] = 0x00;
+	netif->hwaddr[5] = 0x02;
+
+	return ERR_OK;
+}
+
+int sandbox_tapif_init(void)
+{
+	struct tap_ifreq ifr;
+	ip4_addr_t addr, netmask, gw;
+	int fd;
+
+	fd = open("/dev/net/tun", O_RDWR);
+	if (fd < 0) {
+		printk("tapif: /dev/net/tun: %d\n", errno);
+		return -errno;
+	}
+
+	memset(&ifr, 0, sizeof(ifr));
+	ifr.flags = IFF_TAP | IFF_NO_PI;
+	strncpy(ifr.name, sandbox_tap_name ? : CONFIG_SANDBOX_TAP_NAME,
+		sizeof(ifr.name) - 1);
+	if (ioctl(fd, TUNSETIFF, &ifr) < 0) {
+		printk("tapif: %s: %d\n", ifr.name, errno);
+		close(fd);
+		return -errno;
+	}
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+	tap_fd = fd;
+
+	tap_rx_sem = xSemaphoreCreateBinary();
+	if (!tap_rx_sem)
+		return -ENOMEM;
+
+	if (xTaskCreate(tapif_rx_task, "tapif", 1024, NULL,
+			configMAX_PRIORITIES - 2, NULL) != pdPASS)
+		return -ENOMEM;
+
+	ip4addr_aton(CONFIG_SANDBOX_TAP_IPADDR, &addr);
+	ip4addr_aton(CONFIG_SANDBOX_TAP_NETMASK, &netmask);
+	ip4addr_aton(CONFIG_SANDBOX_TAP_GW, &gw);
+
+	netifapi_netif_add(&tap_netif, &addr, &netmask, &gw, NULL,
+			   tapif_init, tcpip_input);
+	netifapi_netif_set_default(&tap_netif);
+	netifapi_netif_set_up(&tap_netif);
+
+	printk("tapif: %s %s\n", ifr.name, CONFIG_SANDBOX_TAP_IPADDR);
+
+	return request_irq(fd, tapif_irq, "tapif", 0, NULL);
+}
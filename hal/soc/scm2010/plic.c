@@ -17,6 +17,7 @@
 #include <hal/console.h>
 #include <hal/kmem.h>
 #include <hal/init.h>
+#include <hal/timer.h>
 
 #include <stdio.h>
 #include <string.h>
@@ -47,11 +48,27 @@
 	__nds__plic_disable_interrupt(i);			\
 } while (0)
 
+#ifdef CONFIG_CPU_ACCT
+#define IRQ_HIST	10
+
+volatile u32 irq_time;
+
+static __ilm__ int irq_hist_idx(u32 us)
+{
+	return us < 2 ? 0 : min(__fls(us) - 1, IRQ_HIST - 1);
+}
+#endif
+
 struct irq_entry {
 	const char *name;
 	int (*handler)(int, void *);
 	int priority;
 	int count;
+#ifdef CONFIG_CPU_ACCT
+	u64 time;			/* ktime() ticks in the handler */
+	u32 max;
+	u32 hist[IRQ_HIST];		/* log2 of usec, see irq_hist_idx() */
+#endif
 #ifdef DEBUG_CLAIM_COMPL
 	int claim;
 	int completion;
@@ -77,9 +94,20 @@ __ilm__ void irq_handler(int irqnr)
 		return;
 	}
 	while (irq) {
+#ifdef CONFIG_CPU_ACCT
+		u32 t = ktime();
+#endif
 		if (irq->handler)
 			ret = irq->handler(irqnr, irq->priv);
 
+#ifdef CONFIG_CPU_ACCT
+		t = ktime() - t;
+		irq_time += t;
+		irq->time += t;
+		irq->max = max(irq->max, t);
+		irq->hist[irq_hist_idx(tick_to_us(t))]++;
+#endif
+
 		if (ret < 0)
 			warn("IRQ: irq %d not properly handled (ret=%d)\n", irqnr, ret);
 
@@ -191,6 +219,8 @@ int get_irq_stat(char *buf, size_t size)
 
 #ifdef DEBUG_CLAIM_COMPL
 	buf += snprintk(buf, end - buf, "IRQ:%8s%8s%10s%8s   %8s\n", "Claimed", "Served", "Completed", "PRIO", "");
+#elif defined(CONFIG_CPU_ACCT)
+	buf += snprintk(buf, end - buf, "IRQ:%8s%8s%12s%7s%7s   %8s\n", "CPU0", "PRIO", "TIME(us)", "AVG", "MAX", "");
 #else
 	buf += snprintk(buf, end - buf, "IRQ:%8s%8s   %8s\n", "CPU0", "PRIO", "");
 #endif
@@ -203,6 +233,12 @@ int get_irq_stat(char *buf, size_t size)
 #ifdef DEBUG_CLAIM_COMPL
 		buf += snprintk(buf, end - buf, "%3d:%8d%8d%10d%8d   %s",
 				i, irq->claim, irq->count, irq->completion, irq->priority, irq->name);
+#elif defined(CONFIG_CPU_ACCT)
+		buf += snprintk(buf, end - buf, "%3d:%8d%8d%12llu%7u%7u   %s",
+				i, irq->count, irq->priority,
+				irq->time * (1000000 / time_hz),
+				irq->count ? tick_to_us(irq->time / irq->count) : 0,
+				tick_to_us(irq->max), irq->name);
 #else
 		buf += snprintk(buf, end - buf, "%3d:%8d%8d   %s",
 				i, irq->count, irq->priority, irq->name);
@@ -221,6 +257,41 @@ int get_irq_stat(char *buf, size_t size)
 	return 0;
 }
 
+#ifdef CONFIG_CPU_ACCT
+/*
+ * Handler duration histogram, one line per handler; column n counts
+ * calls that took [2^n, 2^(n+1)) usec, the first one [0, 2) and the
+ * last one all longer calls.
+ */
+int get_irq_hist(char *buf, size_t size)
+{
+	struct irq_entry *irq;
+	char *end = buf + size;
+	int i, j;
+
+	buf += snprintk(buf, end - buf, "IRQ:");
+	for (j = 0; j < IRQ_HIST - 1; j++)
+		buf += snprintk(buf, end - buf, "%6s%-3d", "<", 2 << j);
+	buf += snprintk(buf, end - buf, "%5s%-4d", ">=", 1 << (IRQ_HIST - 1));
+	buf += snprintk(buf, end - buf, "  (us)\n");
+
+	for (i = 0; i < CONFIG_NR_IRQ; i++) {
+		for (irq = irq_table[i]; irq != NULL; irq = irq->next) {
+			if (irq->count == 0)
+				continue;
+			buf += snprintk(buf, end - buf, "%3d:", i);
+			for (j = 0; j < IRQ_HIST; j++)
+				buf += snprintk(buf, end - buf, "%9u", irq->hist[j]);
+			buf += snprintk(buf, end - buf, "   %s\n", irq->name);
+			if (buf > end)
+				return -1;
+		}
+	}
+
+	return 0;
+}
+#endif
+
 void enable_irq(int irq)
 {
     enable_int(irq);
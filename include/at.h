@@ -95,6 +95,7 @@ void at_echo(int on);
 void at_print_args(int argc, char *argv[]);
 char *at_strip_args(char *args);
 int at_printf(const char* format, ...);
+int at_write(const void *buf, size_t len);
 int at_process_cmd(int argc, char *argv[], AT_CAT type);
 int at_parse_line(char **s, char *argv[], AT_CAT *type);
 
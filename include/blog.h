@@ -0,0 +1,111 @@
+/*
+ * Copyright 2024-2024 Senscomm Semiconductor Co., Ltd.	All rights reserved.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __BLOG_H__
+#define __BLOG_H__
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <errno.h>
+
+#include <hal/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Deferred binary log.
+ *
+ * Producers (printk, wise_log_write) do not format anything. They store
+ * a record made of a timestamp, a level, a tag ID, the format string
+ * pointer and the raw arguments into a ring, and the text is rendered
+ * later by klogd (or by scripts/blog_decode.py from a memory dump).
+ *
+ * Arguments are marshalled by walking the format string, so records
+ * only make sense with formats that live as long as the image does
+ * (string literals). %s arguments are copied into the record.
+ */
+
+#define BLOG_TAG_KERNEL		0	/* printk */
+#define BLOG_TAG_UNKNOWN	0xffff
+
+#define BLOG_F_COMMIT		(1 << 0)	/* payload is complete */
+#define BLOG_F_PAD		(1 << 1)	/* filler up to the end of the ring */
+#define BLOG_F_TEXT		(1 << 2)	/* payload is preformatted text */
+
+/**
+ * struct blog_rec - record header, followed by the marshalled arguments
+ *
+ * @size: record size in words (unsigned long), header included
+ * @level: log level (0 for printk)
+ * @flags: BLOG_F_xxx
+ * @tag: tag ID, see blog_tag_name()
+ * @ts: timestamp in microseconds
+ * @fmt: format string, or NULL for BLOG_F_TEXT records
+ */
+struct blog_rec {
+	u16 size;
+	u8 level;
+	volatile u8 flags;
+	u16 tag;
+	u16 reserved;
+	u32 ts;
+	const char *fmt;
+	unsigned long arg[];
+};
+
+#ifdef CONFIG_BLOG
+
+/**
+ * struct blog - ring control block
+ *
+ * @head: producer index, in words, free running
+ * @tail: consumer index, in words, free running
+ * @dropped: records lost because the ring was full
+ * @draining: set while a consumer walks the ring
+ * @ring: record storage
+ */
+struct blog {
+	volatile unsigned long head;
+	volatile unsigned long tail;
+	unsigned long dropped;
+	unsigned long draining;
+	unsigned long ring[CONFIG_BLOG_BUF_LEN / sizeof(unsigned long)];
+};
+
+int blog_vwrite(u8 level, u16 tag, const char *fmt, va_list ap);
+int blog_drain(void (*putc)(int, void *), void *arg);
+
+#else
+
+static __inline__ int blog_vwrite(u8 level, u16 tag, const char *fmt,
+				  va_list ap)
+{
+	return -ENOTSUP;
+}
+
+static __inline__ int blog_drain(void (*putc)(int, void *), void *arg)
+{
+	return 0;
+}
+
+#endif
+
+/* Provided by the tag owner (wise_log) to render tag IDs. */
+const char *blog_tag_name(u16 tag);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BLOG_H__ */
@@ -28,5 +28,18 @@ extern struct mbuf*	(*m_frompbuf)(struct pbuf *, int head);
 
 extern struct pbuf*	(*m_topbuf)(struct mbuf *);
 
+#ifdef CONFIG_FREEBSD_MBUF_PBUF_ZEROCOPY
+
+/*
+ * A received mbuf lent to lwIP as a PBUF_REF pbuf (see m_topbuf).
+ * The mbuf is freed when lwIP frees the pbuf.
+ */
+struct m_pbuf {
+	struct pbuf_custom pc;
+	struct mbuf *m;
+};
+
+#endif
+
 
 #endif	/* _FBSD_LWIP_GLUE_H_ */
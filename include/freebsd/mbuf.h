@@ -83,6 +83,7 @@
 #define EXT_CLUSTER		1		// 2048 bytes
 #define EXT_FIXED		2		// custom ext_buf permanently attached by wlan driver
 #define EXT_IPCRING		3		// data in IPC receive ring
+#define EXT_PBUF		4		// payload of a referenced lwIP pbuf
 #define EXT_NET_DRV		100		// custom ext_buf provided by net driver
 
 #define CSUM_IP			0x0001
@@ -157,8 +158,8 @@ struct ext {
 	 * Free method and optional argument pointer
 	 */
 	m_ext_free_t	*ext_free;
-	uint32_t		ext_arg1;
-	uint32_t		ext_arg2;
+	uintptr_t		ext_arg1;
+	uintptr_t		ext_arg2;
 
 };
 
@@ -228,7 +229,7 @@ extern struct mbuf*	(*m_gethdr)(int, short);
 extern struct mbuf*	(*m_getcl)(int, short, int);
 extern int			(*m_clget)(struct mbuf*, int);
 extern void			(*m_dyna_extadd)(struct mbuf *memoryBuffer, caddr_t buffer, u_int size,
-						m_ext_free_t freef, uint32_t arg1, uint32_t arg2, int flags, int type);
+						m_ext_free_t freef, uintptr_t arg1, uintptr_t arg2, int flags, int type);
 extern struct mbuf*	(*m_getext)(int how, short type);
 extern struct mbuf*	(*m_getexthdr)(int how, short type);
 extern struct mbuf*	(*m_free)(struct mbuf*);
@@ -299,6 +300,10 @@ struct m_tag*	m_tag_locate(struct mbuf*, u_int32_t, int, struct m_tag*);
 
 extern struct pbuf*	(*m_topbuf)(struct mbuf *);
 struct pbuf* m_topbuf_nofreem(struct mbuf *mb);
+#ifdef CONFIG_FREEBSD_MBUF_PBUF_ZEROCOPY
+struct pbuf* m_topbuf_share(struct mbuf *mb, struct mbuf **mo);
+struct mbuf* m_pbuf_getm(struct pbuf *p);
+#endif
 
 struct m_tag*		m_tag_copy(struct m_tag*, int);
 int					m_tag_copy_chain(struct mbuf*, struct mbuf*, int);
@@ -21,6 +21,8 @@
 extern "C" {
 #endif
 
+struct timezone;
+
 int _os_gettimeofday(struct timeval *tv, struct timezone *tz);
 
 int _gettimeofday(struct timeval *t, struct timezone *tz);
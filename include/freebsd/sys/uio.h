@@ -16,7 +16,8 @@
 /* XXX: native header not available */
 #if 0 /*def __USE_NATIVE_HEADER__*/
 #include_next <sys/uio.h>
-#else
+#elif !defined(__iovec_defined)
+#define __iovec_defined 1
 struct iovec {
 	void *iov_base;
 	size_t iov_len;
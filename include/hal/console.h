@@ -36,6 +36,7 @@ extern int (*register_console)(struct console *con);
 
 void console_flush(void);
 void klogd(void *ptr);
+void klogd_kick(void);
 
 int snprintk(char *str, size_t size, const char *format, ...);
 int db_printf(const char *fmt, ...);
@@ -27,6 +27,10 @@ extern int request_irq(int irq,
 
 extern void free_irq(int irq, const char *name);
 extern int get_irq_stat(char *buf, size_t size);
+#ifdef CONFIG_CPU_ACCT
+extern volatile uint32_t irq_time;
+extern int get_irq_hist(char *buf, size_t size);
+#endif
 extern void enable_irq(int irq);
 extern void disable_irq(int irq);
 #ifdef CONFIG_ARM_CORTEX_A7
@@ -12,6 +12,6 @@
 #ifndef __SANDBOX_IO_H__
 #define __SANDBOX_IO_H__
 
-/* Just use generic routines in hal/io.h"
+/* Just use generic routines in hal/io.h */
 
 #endif /* __SANDBOX_IO_H__ */
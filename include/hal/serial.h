@@ -21,6 +21,7 @@
 
 #include <FreeRTOS/FreeRTOS.h>
 #include <FreeRTOS/xqueue.h>
+#include <FreeRTOS/semphr.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -40,19 +41,67 @@ typedef QueueHandle_t queue_t;
 typedef enum { TXD = 0, RXD = 1, CTS = 2, RTS = 3 } uart_pin_t;
 enum { TX = 0, RX = 1 };
 
+/*
+ * Single producer, single consumer byte ring between a port's tasks and
+ * its interrupt handler. TX is filled by tasks and drained by the ISR,
+ * RX the other way around. Each side only ever writes its own index, so
+ * neither needs a lock against the other; tasks serialize among
+ * themselves with @lock.
+ *
+ * @thresh is set by a task before it blocks on @wait: the number of
+ * bytes (RX) or free slots (TX) it needs. The ISR gives @wait only once
+ * that is met; 0 means nobody is waiting.
+ */
+struct serial_ring {
+	u8 *buf;
+	u32 size;		/* power of two */
+	volatile u32 head;	/* producer */
+	volatile u32 tail;	/* consumer */
+	volatile u32 thresh;
+	SemaphoreHandle_t wait;
+	SemaphoreHandle_t lock;
+};
+
+static inline u32 serial_ring_count(struct serial_ring *r)
+{
+	return r->head - r->tail;
+}
+
+static inline u32 serial_ring_space(struct serial_ring *r)
+{
+	return r->size - (r->head - r->tail);
+}
+
 struct serial_port {
 	int id;
 	struct device *device;
 	struct serial_port_ops *ops;
 	struct list_head list;
 	struct termios oldtermios;
-	queue_t queue[2];
+	struct serial_ring ring[2];
 	int initialized;
 };
 
 extern int register_serial_port(struct serial_port *);
 int uart_get_baudrate(struct termios *);
 
+int serial_port_alloc(struct serial_port *port);
+void serial_port_free(struct serial_port *port);
+
+/* For interrupt handlers and for start_tx() with interrupts disabled. */
+int serial_tx_pull(struct serial_port *port, u8 *buf, int len,
+		   portBASE_TYPE *resched);
+int serial_rx_push(struct serial_port *port, const u8 *buf, int len,
+		   portBASE_TYPE *resched);
+
+/*
+ * Zero-copy TX for DMA: peek returns the pending bytes as up to two
+ * segments without consuming them; done releases @len of them once the
+ * transfer is over.
+ */
+u32 serial_tx_peek(struct serial_port *port, u8 *seg[2], u32 len[2]);
+void serial_tx_done(struct serial_port *port, u32 len, portBASE_TYPE *resched);
+
 #ifdef __cplusplus
 }
 #endif
@@ -29,6 +29,7 @@ extern "C" {
 #define IOCTL_UART_RX		    3
 #define IOCTL_UART_RESET	    4
 #define IOCTL_UART_GET_RX_LEN	5
+#define IOCTL_UART_RX_STOP	    6
 
 enum uart_baudrate {
 	UART_BDR_50		= 50,
@@ -74,11 +75,14 @@ struct uart_cfg {
 	enum uart_parity parity;
 	enum uart_stop_bits stop_bits;
 	uint8_t dma_en;
+	uint8_t rx_idle;	/* DMA only: end a reception early with
+				 * UART_EVENT_RX_IDLE when the line goes quiet */
 };
 
 enum uart_event_type {
 	UART_EVENT_TX_CMPL,
 	UART_EVENT_RX_CMPL,
+	UART_EVENT_RX_IDLE,	/* uart_get_rx_len() tells how much arrived */
 };
 
 enum uart_err {
@@ -127,6 +131,7 @@ struct uart_ops {
 	int (*receive)(struct device *dev, uint8_t *rx_buf, uint32_t rx_len);
 	int (*reset)(struct device *dev);
 	int (*get_rx_len)(struct device *dev);
+	int (*rx_stop)(struct device *dev);
 };
 
 #define uart_ops(x)		((struct uart_ops *)(x)->driver->ops)
@@ -179,6 +184,17 @@ static __inline__ int uart_get_rx_len(struct device *dev)
 	return uart_ops(dev)->get_rx_len(dev);
 }
 
+static __inline__ int uart_rx_stop(struct device *dev)
+{
+	if (!dev)
+		return -ENODEV;
+
+	if (!uart_ops(dev)->rx_stop)
+		return -ENOSYS;
+
+	return uart_ops(dev)->rx_stop(dev);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -112,6 +112,14 @@ struct wlan_ops {
 	int (*ctl_vap)(struct device *dev, struct ieee80211vap *,
 			u_long cmd, caddr_t data);
 
+	/*
+	 * Get the number of frames held in the transmit queues of an AC
+	 * @dev: wlan device
+	 * @ac: WME access category
+	 * @return: frames queued or in flight, -ve on error
+	 */
+	int (*txq_depth)(struct device *dev, int ac);
+
 };
 
 #define wlan_ops(x)	((struct wlan_ops *)(x)->driver->ops)
@@ -220,6 +228,17 @@ static __inline__ int wlan_ctl_vap(struct device *dev, struct ieee80211vap *vap,
 	return wlan_ops(dev)->ctl_vap(dev, vap, cmd, data);
 }
 
+static __inline__ int wlan_txq_depth(struct device *dev, int ac)
+{
+	if (!dev)
+		return -ENODEV;
+
+	if (!wlan_ops(dev)->txq_depth)
+		return -ENOSYS;
+
+	return wlan_ops(dev)->txq_depth(dev, ac);
+}
+
 /* 0 ~ (n-1): okay, -1: invalid vap */
 __ilm__ static inline int get_vap_idx(struct device *dev,
 		struct ieee80211vap *vap)
@@ -0,0 +1,128 @@
+/*
+ * Copyright 2024-2024 Senscomm Semiconductor Co., Ltd.	All rights reserved.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __KTRACE_H__
+#define __KTRACE_H__
+
+#include <hal/types.h>
+
+#ifdef CONFIG_KTRACE
+#include <hal/irq.h>
+#include <hal/timer.h>
+
+#include <FreeRTOS/FreeRTOS.h>
+#include <FreeRTOS/task.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Hot path event tracer.
+ *
+ * Every tracepoint stores one fixed size event (raw ktime() stamp, event
+ * ID, phase, task and a 32-bit argument) into a ring that is overwritten
+ * when full. The 'ktrace' command dumps it as text, which
+ * scripts/ktrace2json.py turns into Chrome trace (Perfetto) JSON.
+ *
+ * Events fired from interrupt handlers are listed before
+ * KTRACE_TASK_FIRST so that no task lookup is done for them; they are
+ * shown on their own track.
+ */
+enum ktrace_id {
+	KTRACE_MAC_ISR,			/* arg: REG_INTR_STATUS */
+	KTRACE_TASK_FIRST,
+	KTRACE_WLAN_RX = KTRACE_TASK_FIRST, /* arg: pending */
+	KTRACE_WLAN_REFILL,		/* arg: pending */
+	KTRACE_ETHER_INPUT,		/* arg: pbuf length */
+	KTRACE_TCPIP_MSG,		/* arg: message type */
+	KTRACE_SCDC_DATA,		/* arg: mbuf length */
+	KTRACE_SDIO_WRITE,		/* arg: length */
+	KTRACE_MAX,
+};
+
+enum ktrace_ph {
+	KTRACE_PH_BEGIN,
+	KTRACE_PH_END,
+	KTRACE_PH_INSTANT,
+};
+
+/**
+ * struct ktrace_ev - one event
+ *
+ * @ts: ktime() at the tracepoint
+ * @id: enum ktrace_id
+ * @ph: enum ktrace_ph
+ * @ctx: current task, NULL for interrupt events
+ * @arg: event specific
+ */
+struct ktrace_ev {
+	u32 ts;
+	u16 id;
+	u16 ph;
+	void *ctx;
+	u32 arg;
+};
+
+#ifdef CONFIG_KTRACE
+
+#define KTRACE_ENTRIES	CONFIG_KTRACE_ENTRIES
+
+extern struct ktrace_ev ktrace_ring[KTRACE_ENTRIES];
+extern volatile u32 ktrace_head;
+extern volatile u32 ktrace_mask;
+
+static __inline__ __attribute__((always_inline)) void
+ktrace(enum ktrace_id id, enum ktrace_ph ph, u32 arg)
+{
+	struct ktrace_ev *ev;
+	unsigned long flags;
+	u32 i;
+
+	if (!(ktrace_mask & (1 << id)))
+		return;
+
+	/*
+	 * Claim the slot with interrupts masked, for the reason given at
+	 * blog_reserve() in kernel/blog.c. Stamp it there as well, so that
+	 * an interrupt event cannot take a later slot with an earlier stamp.
+	 */
+	local_irq_save(flags);
+	i = ktrace_head++;
+	ev = &ktrace_ring[i & (KTRACE_ENTRIES - 1)];
+	ev->ts = ktime();
+	local_irq_restore(flags);
+
+	ev->id = id;
+	ev->ph = ph;
+	ev->ctx = id < KTRACE_TASK_FIRST ? NULL : xTaskGetCurrentTaskHandle();
+	ev->arg = arg;
+}
+
+#define ktrace_begin(id, arg)	ktrace(id, KTRACE_PH_BEGIN, arg)
+#define ktrace_end(id, arg)	ktrace(id, KTRACE_PH_END, arg)
+#define ktrace_instant(id, arg)	ktrace(id, KTRACE_PH_INSTANT, arg)
+
+#else
+
+#define ktrace_begin(id, arg)	do { } while (0)
+#define ktrace_end(id, arg)	do { } while (0)
+#define ktrace_instant(id, arg)	do { } while (0)
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __KTRACE_H__ */
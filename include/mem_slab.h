@@ -39,30 +39,34 @@ extern "C" {
  * @block_size: size in bytes of each block
  * @num_used: number of blocks in use
  * @max_used: maximum number of blocks ever used
+ * @num_wait: number of allocations that had to wait for a block
+ * @num_fail: number of allocations that failed or timed out
  */
 struct mem_slab_info {
 	uint32_t num_blocks;
 	size_t   block_size;
 	uint32_t num_used;
 	uint32_t max_used;
+	uint32_t num_wait;
+	uint32_t num_fail;
 };
 
 /**
  * struct mem_slab
  *
- * @wait_q: queue on which clients wait for a free block
- * @free_block: a free block just returned to an empty memory slab
+ * @wait_sem: semaphore on which clients wait for a free block
+ * @waiters: number of clients waiting on @wait_sem
  * @buffer: buffer of memory slab
- * @free_list: list of free memory blocks
+ * @free_head: tagged index of the first free block (see mem_slab.c)
  * @info: configuration and statistics
  * @list: list of memory slabs
  */
 struct mem_slab {
-	osMessageQueueId_t wait_q;
-	StaticQueue_t cb;
-	void *free_block;
+	osSemaphoreId_t wait_sem;
+	StaticSemaphore_t cb;
+	uint32_t waiters;
 	char *buffer;
-	char *free_list;
+	uint32_t free_head;
 	struct mem_slab_info info;
 	struct list_head list;
 };
@@ -77,10 +81,9 @@ struct mem_slab {
 #define MEM_SLAB_INITIALIZER(_slab_buffer, _slab_block_size,        \
                                    _slab_num_blocks)                \
 	{                                                               \
-	.free_block = NULL,                                             \
 	.buffer = _slab_buffer,                                         \
-	.free_list = NULL,                                              \
-	.info = {_slab_num_blocks, _slab_block_size, 0, 0}              \
+	.free_head = 0,                                                 \
+	.info = {_slab_num_blocks, _slab_block_size, 0, 0, 0, 0}        \
 	}
 
 /**
@@ -118,6 +121,20 @@ int mem_slab_deinit(struct mem_slab *slab);
 int mem_slab_alloc(struct mem_slab *slab, void **mem, uint32_t timeout);
 void mem_slab_free(struct mem_slab *slab, void *mem);
 
+/*
+ * Never block and take no lock, so that they can be called from
+ * interrupt handlers. A slab holds at most 65535 blocks.
+ */
+int mem_slab_alloc_isr(struct mem_slab *slab, void **mem);
+void mem_slab_free_isr(struct mem_slab *slab, void *mem);
+
+/*
+ * Allocate up to @n blocks into @mem, returning how many were, or
+ * free @n blocks, with a single update of the free list.
+ */
+int mem_slab_alloc_batch(struct mem_slab *slab, void **mem, int n);
+void mem_slab_free_batch(struct mem_slab *slab, void **mem, int n);
+
 #ifdef __cplusplus
 }
 #endif
@@ -21,102 +21,46 @@ extern "C" {
 #endif
 
 /*
- * sample code to record mbuf timestamp,
- * it links array by set m_ext.ext_arg2,
- * please check it before use it.
+ * Per-packet stage stamps.
+ *
+ * A packet larger than MTSMP_LEN_THR gets a stage record attached as an
+ * mbuf packet tag when it enters the stack (mtsmp_start()); every later
+ * layer stamps its stage into it (mtsmp_stamp()). A pbuf that lends
+ * a received mbuf to lwIP carries the record of that mbuf.
+ * When the mbuf is freed, which for TX is right after the MAC reports
+ * completion, the record is closed: the time between each two
+ * consecutive stamped stages and from the first stage to the release
+ * is added to a log-linear histogram of that stage pair.
+ * 'mtsmp' prints p50/p90/p99 per pair.
  */
 
-#ifdef CONFIG_SUPPORT_MTSMP
-struct m_timestamp_in
-{
-  void *   m_in;
-  uint32_t start_t;
-  uint32_t end_t;
+enum mtsmp_stage {
+	MTSMP_RX_DRV,		/* frame handed up by the WLAN driver */
+	MTSMP_RX_LWIP,		/* taken up by the tcpip thread */
+	MTSMP_RX_SOCK,		/* picked up by a socket reader */
+	MTSMP_RX_HOST,		/* written to the host (SCDC) */
+	MTSMP_TX_HOST,		/* received from the host (SCDC) */
+	MTSMP_TX_LWIP,		/* lwIP netif output */
+	MTSMP_DONE,		/* mbuf released, e.g. MAC TX done */
+	MTSMP_STAGES,
 };
 
-struct m_timestamp_out
-{
-  void *   m_out;
-  uint8_t  subframes;
-  uint32_t start_t;
-  uint32_t end_t;
-};
-
-#define COUNT_NUM 100
-#define PACKET_LEN_THR 1000
-
-struct m_timestamp
-{
-  int outcount;
-  int incount;
-  struct m_timestamp_in in[COUNT_NUM];
-  struct m_timestamp_out out[COUNT_NUM];
-};
-
-extern struct m_timestamp mbuf_timestamp;
-
-#define tsmp_init() memset(&mbuf_timestamp, 0, sizeof(mbuf_timestamp))
-
-#define tsmp_get_count(what) mbuf_timestamp.what
-#define tsmp_set_count(what, value) mbuf_timestamp.what = value
-#define tsmp_inc_count(what) mbuf_timestamp.what++
+#define MTSMP_LEN_THR	1000
 
-#define tsmp_get_idx(m) (m->m_ext.ext_arg2 - 1)
-#define tsmp_set_idx(m, i) do { m->m_ext.ext_arg2 = i; } while (0)
+struct mbuf;
+struct pbuf;
 
-#define tsmp_get(what) mbuf_timestamp.what
-#define tsmp_set(i, what, value) \
-do { \
- if ((uint32_t) i < COUNT_NUM) \
-    mbuf_timestamp.what = value; \
-} while (0)
-
-#define tsmp_time(i, what) \
-do { \
-    tsmp_set(i, what, ktime()); \
-} while (0)
-
-#define tsmp_diff(st, ed) abs(mbuf_timestamp.ed - mbuf_timestamp.st)
-#define tsmp_valid(what) (mbuf_timestamp.what.end_t != 0)
-#define tsmp_avg(t,c) do { (t = t/c); } while (0)
-
-#define tsmp_time_out(m, what) tsmp_time(tsmp_get_idx(m), out[tsmp_get_idx(m)].what)
-#define tsmp_diff_out(i, st, ed) tsmp_diff(out[i].st, out[i].ed)
-#define tsmp_get_out(i, what) tsmp_get(out[i].what)
-#define tsmp_set_out(m, what, value) tsmp_set(tsmp_get_idx(m), out[tsmp_get_idx(m)].what, value)
-
-#define tsmp_clean_out(m) \
-do { \
-  uint8_t i = tsmp_get_idx(m); \
-  if (i <= COUNT_NUM) \
-    memset(&mbuf_timestamp.out[i], 0, sizeof(mbuf_timestamp.out[i])); \
-} while (0)
-
-#define tsmp_diff_in(i, st, ed) tsmp_diff(in[i].st, in[i].ed)
-#define tsmp_get_in(i, what) tsmp_get(in[i].what)
-#define tsmp_set_in(m, what, value) tsmp_set(tsmp_get_idx(m), in[tsmp_get_idx(m)].what, value)
-
-#define tsmp_clean_in(m) \
-do { \
-  uint8_t i = tsmp_get_idx(m); \
-  if (i <= COUNT_NUM) \
-    memset(&mbuf_timestamp.in[i], 0, sizeof(mbuf_timestamp.in[i])); \
-} while (0)
+#ifdef CONFIG_SUPPORT_MTSMP
 
-#define tsmp_time_in(m, what) tsmp_time(tsmp_get_idx(m), in[tsmp_get_idx(m)].what)
+void mtsmp_start(struct mbuf *m, enum mtsmp_stage stage);
+void mtsmp_stamp(struct mbuf *m, enum mtsmp_stage stage);
+void mtsmp_stamp_pbuf(struct pbuf *p, enum mtsmp_stage stage);
 
 #else
-#define tsmp_get_idx(m)
-#define tsmp_set_idx(m, i)
-#define tsmp_set(i, what, value)
-#define tsmp_time(i, what)
-#define tsmp_clean_in(m)
-
-#define tsmp_time_out(m, what)
-#define tsmp_set_out(m, what, value)
 
-#define tsmp_time_in(m, what)
-#define tsmp_set_in(m, what, value)
+#define mtsmp_start(m, stage)		do { } while (0)
+#define mtsmp_stamp(m, stage)		do { } while (0)
+#define mtsmp_stamp_pbuf(p, stage)	do { } while (0)
 
 #endif
 
@@ -0,0 +1,93 @@
+/*
+ * Copyright 2024-2024 Senscomm Semiconductor Co., Ltd.	All rights reserved.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __PERF_H__
+#define __PERF_H__
+
+#include <hal/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Hardware performance counters (NDS V5 HPM).
+ *
+ * mcycle and minstret always count; the four programmable counters
+ * mhpmcounter3..6 count one enum perf_event each, as selected with
+ * perf_event_set(). A snapshot of all of them is a struct perf_ctr.
+ *
+ * Counting a code region:
+ *
+ *	struct perf_ctr c;
+ *
+ *	perf_begin(&c);
+ *	...
+ *	perf_end(&c);
+ *	perf_print(&c);
+ */
+
+enum perf_event {
+	PERF_EV_NONE,
+	PERF_EV_LOAD,			/* integer loads retired */
+	PERF_EV_STORE,			/* integer stores retired */
+	PERF_EV_BRANCH,			/* conditional branches retired */
+	PERF_EV_BRANCH_TAKEN,		/* taken conditional branches */
+	PERF_EV_JALR,			/* indirect jumps and calls */
+	PERF_EV_ILM,			/* ILM accesses */
+	PERF_EV_DLM,			/* DLM accesses */
+	PERF_EV_ICACHE,			/* I-cache accesses */
+	PERF_EV_ICACHE_MISS,		/* I-cache misses */
+	PERF_EV_DCACHE,			/* D-cache accesses */
+	PERF_EV_DCACHE_MISS,		/* D-cache misses */
+	PERF_EV_ICACHE_STALL,		/* cycles waiting for I-cache fill */
+	PERF_EV_DCACHE_STALL,		/* cycles waiting for D-cache fill */
+	PERF_EV_UNCACHED_FETCH,		/* uncached instruction fetches */
+	PERF_EV_BRANCH_MISS,		/* conditional branch mispredicts */
+	PERF_EV_TARGET_MISS,		/* branch target mispredicts */
+	PERF_EV_MAX,
+};
+
+#define PERF_NR_HPM	4
+/* mcycle, minstret, mhpmcounter3..6 */
+#define PERF_NR_CTR	(2 + PERF_NR_HPM)
+
+struct perf_ctr {
+	u64 v[PERF_NR_CTR];
+};
+
+#ifdef CONFIG_PERF
+
+int perf_event_set(int hpm, enum perf_event ev);
+enum perf_event perf_event_get(int hpm);
+void perf_read(struct perf_ctr *c);
+void perf_end(struct perf_ctr *c);
+void perf_print(const struct perf_ctr *c);
+
+static inline void perf_begin(struct perf_ctr *c)
+{
+	perf_read(c);
+}
+
+#else
+
+#define perf_begin(c)		do { } while (0)
+#define perf_end(c)		do { } while (0)
+#define perf_print(c)		do { } while (0)
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __PERF_H__ */
@@ -33,6 +33,12 @@
 #ifndef _SYS_POLL_H_
 #define	_SYS_POLL_H_
 
+#ifdef __USE_NATIVE_HEADER__
+
+#include_next <poll.h>
+
+#else                           /* __USE_NATIVE_HEADER__ */
+
 #include <sys/cdefs.h>
 
 #ifndef _KERNEL
@@ -134,4 +140,6 @@ __END_DECLS
 }
 #endif
 
+#endif                          /* __USE_NATIVE_HEADER__ */
+
 #endif /* !_SYS_POLL_H_ */
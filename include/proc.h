@@ -45,6 +45,12 @@ static inline const char *task_name(thread_t th)
 	return tsk.pcTaskName;
 }
 
+#ifdef CONFIG_CPU_ACCT
+uint64_t task_cpu_time(thread_t task);
+uint64_t irq_cpu_time(void);
+void task_cpu_time_prune(threadinfo_t *tasks, int n);
+#endif
+
 int task_is_freezable(thread_t task);
 int task_suspend(int pid);
 int task_resume(int pid);
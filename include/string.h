@@ -27,6 +27,12 @@ extern "C" {
 char *os_strndup2(const char *s, size_t n);
 char *os_strcasestr2(const char *str, const char *substr);
 
+#ifdef CONFIG_SANDBOX
+/* Not in every host libc (glibc < 2.38); hal/soc/sandbox/rom has them. */
+size_t strlcpy(char *dst, const char *src, size_t size);
+size_t strlcat(char *dst, const char *src, size_t size);
+#endif
+
 #undef strndup
 #define strndup os_strndup2
 
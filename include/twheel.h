@@ -0,0 +1,72 @@
+/*
+ * Copyright 2024-2024 Senscomm Semiconductor Co., Ltd.	All rights reserved.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __TWHEEL_H__
+#define __TWHEEL_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <hal/kernel.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Software timers on a hierarchical timer wheel driven by the system
+ * timer, for code that would otherwise have an osTimer of its own.
+ *
+ * Arming and cancelling are O(1) and safe from interrupt handlers.
+ * Callbacks run in the "twheel" task, all timers that expire together
+ * in one go, unless the timer has TWHEEL_ISR, in which case they run
+ * from the system timer interrupt with interrupts disabled.
+ */
+
+typedef void (*twheel_func_t)(void *arg);
+
+/* flags */
+#define TWHEEL_PERIODIC		(1 << 0)
+#define TWHEEL_ISR		(1 << 1)
+
+/**
+ * struct twheel_timer
+ *
+ * @func: callback
+ * @arg: argument to @func
+ * @flags: TWHEEL_xxx
+ * @state: where the timer is, see twheel.c
+ * @expires: wheel tick at which the timer expires
+ * @period: period in wheel ticks of a periodic timer
+ * @list: slot in the wheel, or the list of expired timers
+ */
+struct twheel_timer {
+	twheel_func_t func;
+	void *arg;
+	uint8_t flags;
+	uint8_t state;
+	uint32_t expires;
+	uint32_t period;
+	struct list_head list;
+};
+
+void twheel_timer_init(struct twheel_timer *t, twheel_func_t func, void *arg,
+		       unsigned flags);
+int twheel_timer_start(struct twheel_timer *t, uint32_t ms);
+int twheel_timer_stop(struct twheel_timer *t);
+bool twheel_timer_is_running(struct twheel_timer *t);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TWHEEL_H__ */
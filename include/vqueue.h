@@ -16,14 +16,31 @@
 #include <stdint.h>
 #include <freebsd/errors.h>
 #include "vfs.h"
+#include "mem_slab.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/*
+ * The message of a zero-copy vqueue, see vqueue_zc().
+ * Only the pointer is queued; the payload changes hands with it.
+ */
+struct vqueue_msg {
+    void *ptr;
+    size_t len;
+};
+
 int vqueue(int count, int size);
+int vqueue_zc(int count, struct mem_slab *slab);
 int vqueue_put(int fd, const void *msg_ptr, uint8_t msg_prio, uint32_t timeout);
 int vqueue_get(int fd, void *msg_ptr, uint8_t *msg_prio, uint32_t timeout);
+int vqueue_put_batch(int fd, const void *msgs, int n, uint32_t timeout);
+int vqueue_get_batch(int fd, void *msgs, int n, uint32_t timeout);
+int vqueue_send(int fd, void *ptr, size_t len, uint32_t timeout);
+int vqueue_recv(int fd, void **ptr, size_t *len, uint32_t timeout);
+void *vqueue_msg_alloc(int fd, uint32_t timeout);
+void vqueue_msg_free(int fd, void *ptr);
 int vqueue_capacity(int fd);
 int vqueue_msg_size(int fd);
 int vqueue_count(int fd);
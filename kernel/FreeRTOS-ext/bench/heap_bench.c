@@ -0,0 +1,171 @@
+/*
+ * Copyright 2022-2024 Senscomm Semiconductor Co., Ltd.	All rights reserved.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Host-side alloc/free latency benchmark for the FreeRTOS-ext heaps.
+ *
+ * The heap implementation under test is #included as HEAP_SRC, so the
+ * same driver is built once per allocator (see Makefile).  The workload
+ * keeps a set of live blocks and randomly allocates or frees one of them,
+ * with a size mix that roughly follows what the Wi-Fi/lwIP/mbedTLS
+ * threads ask for, and reports latency percentiles per operation.
+ *
+ * Usage: heap_bench_xxx [iterations] [heap KB] [live blocks] [seed]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include HEAP_SRC
+
+/* Provided by the ROM on target. */
+size_t xFreeBytesRemaining;
+size_t xMinimumEverFreeBytesRemaining;
+void *(*pvPortMalloc)( size_t xWantedSize ) = p_pvPortMalloc;
+void (*vPortFree)( void *pv ) = p_vPortFree;
+void (*vPortDefineHeapRegions)( const HeapRegion_t * const pxHeapRegions ) = p_vPortDefineHeapRegions;
+
+#ifdef BENCH_HEAP5
+void (*prvInsertBlockIntoFreeList)( BlockLink_t *pxBlockToInsert ) = p_prvInsertBlockIntoFreeList;
+#endif
+
+static uint32_t seed = 0x12345678;
+
+static uint32_t rnd(void)
+{
+	/* xorshift32 */
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	return seed;
+}
+
+static size_t rnd_size(void)
+{
+	uint32_t p = rnd() % 100;
+
+	if (p < 60)
+		return 16 + rnd() % 112;	/* small control blocks */
+	else if (p < 85)
+		return 128 + rnd() % 384;	/* timers, queues, contexts */
+	else if (p < 97)
+		return 1536 + rnd() % 192;	/* frame sized buffers */
+	else
+		return 2048 + rnd() % 6144;	/* TLS records and such */
+}
+
+static inline uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static void report(const char *what, uint32_t *lat, size_t n)
+{
+	uint64_t sum = 0;
+	size_t i;
+
+	if (!n) {
+		printf("%-6s: no samples\n", what);
+		return;
+	}
+
+	qsort(lat, n, sizeof(*lat), cmp_u32);
+	for (i = 0; i < n; i++)
+		sum += lat[i];
+
+	printf("%-6s: n %8zu avg %6llu p50 %6u p90 %6u p99 %6u p99.9 %6u max %7u ns\n",
+	       what, n, (unsigned long long)(sum / n),
+	       lat[n / 2], lat[n * 90 / 100], lat[n * 99 / 100],
+	       lat[n * 999 / 1000], lat[n - 1]);
+}
+
+int main(int argc, char *argv[])
+{
+	size_t iterations = argc > 1 ? strtoul(argv[1], NULL, 0) : 1000000;
+	size_t heap_size = (argc > 2 ? strtoul(argv[2], NULL, 0) : 192) * 1024;
+	size_t nlive = argc > 3 ? strtoul(argv[3], NULL, 0) : 512;
+	HeapRegion_t regions[2] = {{0}};
+	uint32_t *malloc_lat, *free_lat;
+	size_t nmalloc = 0, nfree = 0, nfail = 0;
+	void **live;
+	uint8_t *heap;
+	uint64_t t;
+	size_t i, slot, total;
+	void *p;
+
+	if (argc > 4)
+		seed = strtoul(argv[4], NULL, 0);
+
+	heap = aligned_alloc(portBYTE_ALIGNMENT, heap_size);
+	live = calloc(nlive, sizeof(*live));
+	malloc_lat = malloc(iterations * sizeof(*malloc_lat));
+	free_lat = malloc(iterations * sizeof(*free_lat));
+	if (!heap || !live || !malloc_lat || !free_lat) {
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+
+	regions[0].pucStartAddress = heap;
+	regions[0].xSizeInBytes = heap_size;
+	p_vPortDefineHeapRegions(regions);
+	total = xFreeBytesRemaining;
+
+	for (i = 0; i < iterations; i++) {
+		slot = rnd() % nlive;
+		if (live[slot]) {
+			p = live[slot];
+			t = now_ns();
+			p_vPortFree(p);
+			free_lat[nfree++] = (uint32_t)(now_ns() - t);
+			live[slot] = NULL;
+		} else {
+			size_t size = rnd_size();
+
+			t = now_ns();
+			p = p_pvPortMalloc(size);
+			malloc_lat[nmalloc++] = (uint32_t)(now_ns() - t);
+			if (p)
+				memset(p, 0xa5, size);
+			else
+				nfail++;
+			live[slot] = p;
+		}
+	}
+
+	printf("%s: %zu ops, %zu KB heap, %zu live slots, %zu failed, min free %zu B\n",
+	       HEAP_NAME, iterations, heap_size / 1024, nlive, nfail,
+	       xMinimumEverFreeBytesRemaining);
+	report("malloc", malloc_lat, nmalloc);
+	report("free", free_lat, nfree);
+
+	for (i = 0; i < nlive; i++)
+		p_vPortFree(live[i]);
+
+	if (xFreeBytesRemaining != total) {
+		printf("leaked %zu B\n", total - xFreeBytesRemaining);
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,40 @@
+/*
+ * Host stand-in for FreeRTOS.h, just enough to build the heap
+ * implementations of FreeRTOS-ext as a plain Linux program.
+ */
+#ifndef __BENCH_FREERTOS_H__
+#define __BENCH_FREERTOS_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef void *TaskHandle_t;
+
+#define pdFALSE		( ( BaseType_t ) 0 )
+#define pdTRUE		( ( BaseType_t ) 1 )
+#define pdPASS		( pdTRUE )
+#define pdFAIL		( pdFALSE )
+
+#define configSUPPORT_DYNAMIC_ALLOCATION	1
+#define configUSE_MALLOC_DEBUG				0
+#define configUSE_MALLOC_FAILED_HOOK		0
+#define configASSERT( x )					assert( x )
+
+#define portBYTE_ALIGNMENT			16
+#define portBYTE_ALIGNMENT_MASK		( 0x000f )
+
+#define mtCOVERAGE_TEST_MARKER()
+#define traceMALLOC( pvAddress, uiSize )
+#define traceFREE( pvAddress, uiSize )
+
+typedef struct HeapRegion
+{
+	uint8_t *pucStartAddress;
+	size_t xSizeInBytes;
+} HeapRegion_t;
+
+#endif /* __BENCH_FREERTOS_H__ */
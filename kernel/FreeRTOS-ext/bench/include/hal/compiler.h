@@ -0,0 +1,7 @@
+#ifndef __BENCH_COMPILER_H__
+#define __BENCH_COMPILER_H__
+
+#define __maybe_unused __attribute__((unused))
+#define __ilm__
+
+#endif /* __BENCH_COMPILER_H__ */
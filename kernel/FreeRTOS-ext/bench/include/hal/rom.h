@@ -0,0 +1,13 @@
+/*
+ * Host stand-in for hal/rom.h.  There is no ROM to patch; the benchmark
+ * calls the p_xxx implementations directly.
+ */
+#ifndef __BENCH_ROM_H__
+#define __BENCH_ROM_H__
+
+#define PATCH(fn, d, s) \
+	static const void *__patch_##fn[2] __attribute__((used)) = { \
+		(const void *)(d), (const void *)(s) \
+	}
+
+#endif /* __BENCH_ROM_H__ */
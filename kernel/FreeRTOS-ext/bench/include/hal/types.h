@@ -0,0 +1,8 @@
+#ifndef __BENCH_TYPES_H__
+#define __BENCH_TYPES_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#endif /* __BENCH_TYPES_H__ */
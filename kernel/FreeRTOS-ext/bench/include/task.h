@@ -0,0 +1,17 @@
+/*
+ * Host stand-in for task.h.  The benchmark is single threaded, so the
+ * scheduler lock is a no-op.
+ */
+#ifndef __BENCH_TASK_H__
+#define __BENCH_TASK_H__
+
+static inline void vTaskSuspendAll( void )
+{
+}
+
+static inline BaseType_t xTaskResumeAll( void )
+{
+	return pdFALSE;
+}
+
+#endif /* __BENCH_TASK_H__ */
@@ -0,0 +1,1338 @@
+/*
+ * Copyright 2022-2024 Senscomm Semiconductor Co., Ltd.	All rights reserved.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Two-level segregated-fit (TLSF) implementation of pvPortMalloc() and
+ * vPortFree() that plugs into the ROM heap in place of heap_5_ext.c.
+ *
+ * Free blocks are kept in size-class lists indexed by a first level
+ * (power of two) and a second level (linear subdivision of that power of
+ * two).  Two bitmaps record which lists are non-empty, so that both
+ * allocation and free run in constant time regardless of how fragmented
+ * the heap is:
+ *
+ * - malloc rounds the request up to the next size class and picks the
+ *   first non-empty list at or above it with two find-first-set lookups.
+ * - free merges the block with its physical neighbours, which are found
+ *   through the pxPrevPhysBlock link and the block size, instead of
+ *   walking an address-ordered list.
+ *
+ * Heap regions are defined exactly as for heap_5, i.e. through
+ * vPortDefineHeapRegions() with an array of HeapRegion_t in ascending
+ * address order.  Each region is terminated by a zero sized block that is
+ * marked as allocated, so coalescing never crosses a region boundary.
+ *
+ * The per-block owner/canary information of USE_MALLOC_DEBUG and the
+ * caller recording of MEM_HEAP_DEBUG are kept, and so are the "heap list"
+ * and "heap check" commands (vPortMemoryScan, vPortCheckIntegrity).
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <hal/types.h>
+#include <hal/compiler.h>
+#include <hal/rom.h>
+
+/* Defining MPU_WRAPPERS_INCLUDED_FROM_API_FILE prevents task.h from redefining
+all the API functions to use the MPU wrappers.  That should only be done when
+task.h is included from an application file. */
+#define MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#ifndef CONFIG_LINK_TO_ROM
+	#error "Not support HEAP memory debug"
+#endif
+
+#undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#if( configSUPPORT_DYNAMIC_ALLOCATION == 0 )
+	#error This file must not be used if configSUPPORT_DYNAMIC_ALLOCATION is 0
+#endif
+
+/* Block sizes must not get too small. */
+#define heapMINIMUM_BLOCK_SIZE	( ( size_t ) ( xHeapStructSize << 1 ) )
+
+/* Assumes 8bit bytes! */
+#define heapBITS_PER_BYTE		( ( size_t ) 8 )
+
+/* log2 of portBYTE_ALIGNMENT. */
+#if portBYTE_ALIGNMENT == 32
+	#define heapALIGNMENT_LOG2	5
+#elif portBYTE_ALIGNMENT == 16
+	#define heapALIGNMENT_LOG2	4
+#elif portBYTE_ALIGNMENT == 8
+	#define heapALIGNMENT_LOG2	3
+#elif portBYTE_ALIGNMENT == 4
+	#define heapALIGNMENT_LOG2	2
+#else
+	#error "Unsupported portBYTE_ALIGNMENT"
+#endif
+
+/* Number of second level lists per first level, as log2. */
+#define heapSL_INDEX_LOG2		4
+#define heapSL_INDEX_COUNT		( 1 << heapSL_INDEX_LOG2 )
+
+/* Blocks smaller than heapSMALL_BLOCK_SIZE all live in first level 0,
+linearly split into heapSL_INDEX_COUNT lists of portBYTE_ALIGNMENT steps. */
+#define heapFL_INDEX_SHIFT		( heapSL_INDEX_LOG2 + heapALIGNMENT_LOG2 )
+#define heapSMALL_BLOCK_SIZE	( ( size_t ) 1 << heapFL_INDEX_SHIFT )
+
+/* Largest block (exclusive) that can be kept in the lists, as log2. */
+#define heapFL_INDEX_MAX		24
+#define heapFL_INDEX_COUNT		( heapFL_INDEX_MAX - heapFL_INDEX_SHIFT + 1 )
+
+/* Define the block header.  Free blocks are doubly linked into one of the
+size-class lists; every block, free or not, links to the block physically in
+front of it so that free() can coalesce in constant time. */
+typedef struct A_BLOCK_LINK
+{
+#if( configUSE_MALLOC_DEBUG == 1 )
+    uint32_t ulHeadCanary;                  /*<< The head canary. */
+#endif
+	struct A_BLOCK_LINK *pxNextFreeBlock;	/*<< The next free block in the list. */
+	size_t xBlockSize;						/*<< The size of the block. */
+	struct A_BLOCK_LINK *pxPrevFreeBlock;	/*<< The previous free block in the list. */
+	struct A_BLOCK_LINK *pxPrevPhysBlock;	/*<< The block physically in front of this one. */
+#if( configUSE_MALLOC_DEBUG == 1 )
+    TaskHandle_t xOwner;                    /*<< The buffer owner. */
+    size_t xWantedSize;
+#ifdef CONFIG_MEM_HEAP_DEBUG
+	char xFuncName[CONFIG_MEM_HEAP_DEBUG_FUNCNAMELEN];
+#endif /* CONFIG_MEM_HEAP_DEBUG */
+#endif /* configUSE_MALLOC_DEBUG */
+} BlockLink_t;
+
+/* One TLSF instance, i.e. the bitmaps and the list heads of a heap. */
+typedef struct TLSF_CONTROL
+{
+	uint32_t ulFLBitmap;
+	uint32_t ulSLBitmap[ heapFL_INDEX_COUNT ];
+	BlockLink_t *pxBlocks[ heapFL_INDEX_COUNT ][ heapSL_INDEX_COUNT ];
+} TlsfControl_t;
+
+#if( configUSE_MALLOC_DEBUG == 1 )
+
+#ifndef ARRAY_SIZE
+#define ARRAY_SIZE( x ) ( sizeof( x ) / sizeof( x[ 0 ] ) )
+#endif
+
+#define xstr(s) str(s)
+#define str(s) #s
+#define FMT "%-" xstr(configMAX_TASK_NAME_LEN) "s"
+#ifdef CONFIG_MEM_HEAP_DEBUG
+#define FMTF "%-" xstr(CONFIG_MEM_HEAP_DEBUG_FUNCNAMELEN) "s"
+#endif
+
+#define OPTIMIZE_FAST __attribute__((optimize("O3")))
+
+/* Canary patterns. */
+#define HEAD_CANARY_PATTERN     ( 0xCAFE1234 )
+#define TAIL_CANARY_PATTERN     ( 0xDEAF5678 )
+
+void vPortAddToAllocList( BlockLink_t *pxLink );
+BaseType_t xPortRemoveFromAllocList( BlockLink_t *pxLink );
+void vPortUpdateFreeBlockList( void );
+
+BlockLink_t *pxAllocList[ configSIZE_ALLOC_LIST ] = {0};
+BlockLink_t *pxAllocListCopy[ configSIZE_ALLOC_LIST ] = {0};
+
+typedef struct
+{
+    char *vma;
+    size_t size;
+} tMemoryRegion;
+
+extern char __data_start[], __data_end[];
+extern char __bss_start[], __bss_end[];
+extern char __heap_start[], __heap_end[];
+#ifdef CONFIG_N22_ONLY
+extern char __heapext1_start[], __heapext1_end[];
+extern char __heapext2_start[], __heapext2_end[];
+#endif
+
+tMemoryRegion ram[5];
+
+#endif
+
+#ifdef CONFIG_SUPPORT_DMA_DYNAMIC_ALLOC
+#define DMA_BUFFER_MARK		( 0xFFFFFFFF )
+#endif
+
+/*-----------------------------------------------------------*/
+
+/* The size of the structure placed at the beginning of each allocated memory
+block must by correctly byte aligned. */
+static const size_t xHeapStructSize	= ( sizeof( BlockLink_t ) + ( ( size_t ) ( portBYTE_ALIGNMENT - 1 ) ) ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK );
+
+/* The general purpose heap, and the heap DMA capable buffers are carved
+from.  pxTlsfDMA points to xTlsf if both are the same memory. */
+static TlsfControl_t xTlsf;
+static BaseType_t xTlsfInitialised = pdFALSE;
+static uint8_t *pucHeapStart = NULL;
+#ifdef CONFIG_SUPPORT_DMA_DYNAMIC_ALLOC
+static TlsfControl_t xTlsfDMA;
+static TlsfControl_t *pxTlsfDMA = NULL;
+#endif
+
+/* Keeps track of the number of free bytes remaining, but says nothing about
+fragmentation. */
+extern size_t xFreeBytesRemaining;
+extern size_t xMinimumEverFreeBytesRemaining;
+
+/* Gets set to the top bit of an size_t type.  When this bit in the xBlockSize
+member of an BlockLink_t structure is set then the block belongs to the
+application.  When the bit is free the block is still part of the free heap
+space. */
+static size_t _xBlockAllocatedBit = 0;
+
+#ifdef CONFIG_MEM_HEAP_PERIOD_TIME_DEBUG
+
+static size_t _xFreeBytesStart = 0;
+static size_t _xFreeBytes = 0;
+static size_t _xMinimumEverFreeBytes = 0;
+
+void xPortCheckMemStart( void )
+{
+	_xFreeBytesStart = xFreeBytesRemaining;
+	_xFreeBytes = xFreeBytesRemaining;
+	_xMinimumEverFreeBytes = xFreeBytesRemaining;
+}
+
+void xPortCheckMemEnd( void )
+{
+	printf("Increase   %d bytes during the period \n", _xFreeBytesStart - _xMinimumEverFreeBytes);
+}
+
+#endif /* CONFIG_MEM_HEAP_PERIOD_TIME_DEBUG */
+
+/*-----------------------------------------------------------*/
+
+static inline BaseType_t prvFfs( uint32_t ulWord )
+{
+	return ( BaseType_t ) __builtin_ctz( ulWord );
+}
+
+static inline BaseType_t prvFls( size_t xSize )
+{
+	return ( BaseType_t ) ( ( sizeof( unsigned long ) * heapBITS_PER_BYTE ) - 1 - __builtin_clzl( ( unsigned long ) xSize ) );
+}
+
+/*
+ * Returns the list a free block of xSize bytes belongs to.
+ */
+static inline void prvMappingInsert( size_t xSize, BaseType_t *pxFL, BaseType_t *pxSL )
+{
+BaseType_t xFL, xSL;
+
+	if( xSize < heapSMALL_BLOCK_SIZE )
+	{
+		xFL = 0;
+		xSL = ( BaseType_t ) ( xSize >> heapALIGNMENT_LOG2 );
+	}
+	else
+	{
+		xFL = prvFls( xSize );
+		xSL = ( BaseType_t ) ( xSize >> ( xFL - heapSL_INDEX_LOG2 ) ) ^ heapSL_INDEX_COUNT;
+		xFL -= ( heapFL_INDEX_SHIFT - 1 );
+
+		/* A region larger than the top size class still has to go
+		somewhere; keep it in the last list. */
+		if( xFL >= heapFL_INDEX_COUNT )
+		{
+			xFL = heapFL_INDEX_COUNT - 1;
+			xSL = heapSL_INDEX_COUNT - 1;
+		}
+	}
+
+	*pxFL = xFL;
+	*pxSL = xSL;
+}
+
+/*
+ * Returns the first list whose blocks are all large enough for xSize bytes,
+ * i.e. rounds xSize up to the next size class.
+ */
+static inline void prvMappingSearch( size_t xSize, BaseType_t *pxFL, BaseType_t *pxSL )
+{
+	if( xSize >= heapSMALL_BLOCK_SIZE )
+	{
+		xSize += ( ( size_t ) 1 << ( prvFls( xSize ) - heapSL_INDEX_LOG2 ) ) - 1;
+	}
+
+	if( ( xSize >> heapFL_INDEX_MAX ) != 0 )
+	{
+		*pxFL = heapFL_INDEX_COUNT;
+		*pxSL = 0;
+		return;
+	}
+
+	prvMappingInsert( xSize, pxFL, pxSL );
+}
+
+static __ilm__ void prvInsertFreeBlock( TlsfControl_t *pxControl, BlockLink_t *pxBlock )
+{
+BaseType_t xFL, xSL;
+BlockLink_t *pxHead;
+
+	prvMappingInsert( pxBlock->xBlockSize, &xFL, &xSL );
+
+	pxHead = pxControl->pxBlocks[ xFL ][ xSL ];
+	pxBlock->pxNextFreeBlock = pxHead;
+	pxBlock->pxPrevFreeBlock = NULL;
+	if( pxHead != NULL )
+	{
+		pxHead->pxPrevFreeBlock = pxBlock;
+	}
+	pxControl->pxBlocks[ xFL ][ xSL ] = pxBlock;
+
+	pxControl->ulFLBitmap |= ( 1UL << xFL );
+	pxControl->ulSLBitmap[ xFL ] |= ( 1UL << xSL );
+
+#if( configUSE_MALLOC_DEBUG == 1 )
+	pxBlock->ulHeadCanary = HEAD_CANARY_PATTERN;
+#endif
+}
+
+static __ilm__ void prvRemoveFreeBlock( TlsfControl_t *pxControl, BlockLink_t *pxBlock )
+{
+BaseType_t xFL, xSL;
+
+	prvMappingInsert( pxBlock->xBlockSize, &xFL, &xSL );
+
+	if( pxBlock->pxNextFreeBlock != NULL )
+	{
+		pxBlock->pxNextFreeBlock->pxPrevFreeBlock = pxBlock->pxPrevFreeBlock;
+	}
+
+	if( pxBlock->pxPrevFreeBlock != NULL )
+	{
+		pxBlock->pxPrevFreeBlock->pxNextFreeBlock = pxBlock->pxNextFreeBlock;
+	}
+	else
+	{
+		configASSERT( pxControl->pxBlocks[ xFL ][ xSL ] == pxBlock );
+
+		pxControl->pxBlocks[ xFL ][ xSL ] = pxBlock->pxNextFreeBlock;
+		if( pxBlock->pxNextFreeBlock == NULL )
+		{
+			/* The list went empty. */
+			pxControl->ulSLBitmap[ xFL ] &= ~( 1UL << xSL );
+			if( pxControl->ulSLBitmap[ xFL ] == 0 )
+			{
+				pxControl->ulFLBitmap &= ~( 1UL << xFL );
+			}
+		}
+	}
+}
+
+/*
+ * Takes the first block out of the first non-empty list that is at least as
+ * large as xWantedSize, or returns NULL if there is none.
+ */
+static __ilm__ BlockLink_t *prvTakeFreeBlock( TlsfControl_t *pxControl, size_t xWantedSize )
+{
+BaseType_t xFL, xSL;
+uint32_t ulMap;
+BlockLink_t *pxBlock;
+
+	prvMappingSearch( xWantedSize, &xFL, &xSL );
+	if( xFL >= heapFL_INDEX_COUNT )
+	{
+		return NULL;
+	}
+
+	ulMap = pxControl->ulSLBitmap[ xFL ] & ( ~0UL << xSL );
+	if( ulMap == 0 )
+	{
+		/* Nothing left in this first level; go up to the next non-empty one. */
+		ulMap = ( xFL + 1 < heapFL_INDEX_COUNT ) ? ( pxControl->ulFLBitmap & ( ~0UL << ( xFL + 1 ) ) ) : 0;
+		if( ulMap == 0 )
+		{
+			return NULL;
+		}
+
+		xFL = prvFfs( ulMap );
+		ulMap = pxControl->ulSLBitmap[ xFL ];
+	}
+	xSL = prvFfs( ulMap );
+
+	pxBlock = pxControl->pxBlocks[ xFL ][ xSL ];
+	configASSERT( pxBlock != NULL );
+
+	prvRemoveFreeBlock( pxControl, pxBlock );
+
+	return pxBlock;
+}
+
+static inline BlockLink_t *prvNextPhysBlock( BlockLink_t *pxBlock )
+{
+	return ( BlockLink_t * ) ( ( ( uint8_t * ) pxBlock ) + ( pxBlock->xBlockSize & ~_xBlockAllocatedBit ) );
+}
+
+static __ilm__ void prvReleaseBlock( TlsfControl_t *pxControl, BlockLink_t *pxBlock )
+{
+BlockLink_t *pxNeighbour;
+
+	/* Merge with the block in front of it if that one is free. */
+	pxNeighbour = pxBlock->pxPrevPhysBlock;
+	if( ( pxNeighbour != NULL ) && ( ( pxNeighbour->xBlockSize & _xBlockAllocatedBit ) == 0 ) )
+	{
+		prvRemoveFreeBlock( pxControl, pxNeighbour );
+		pxNeighbour->xBlockSize += pxBlock->xBlockSize;
+		pxBlock = pxNeighbour;
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	/* Merge with the block behind it if that one is free.  The end marker of
+	a region is always marked as allocated. */
+	pxNeighbour = prvNextPhysBlock( pxBlock );
+	if( ( pxNeighbour->xBlockSize & _xBlockAllocatedBit ) == 0 )
+	{
+		prvRemoveFreeBlock( pxControl, pxNeighbour );
+		pxBlock->xBlockSize += pxNeighbour->xBlockSize;
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	prvNextPhysBlock( pxBlock )->pxPrevPhysBlock = pxBlock;
+
+	prvInsertFreeBlock( pxControl, pxBlock );
+}
+
+/*
+ * Carves xWantedSize bytes (header included) out of the heap described by
+ * pxControl, and does the bookkeeping common to all the malloc variants.
+ */
+static __ilm__ void *prvTlsfMalloc( TlsfControl_t *pxControl, size_t xWantedSize, size_t xOrgWantedSize )
+{
+BlockLink_t *pxBlock, *pxNewBlockLink;
+
+	( void ) xOrgWantedSize;
+
+	pxBlock = prvTakeFreeBlock( pxControl, xWantedSize );
+	if( pxBlock == NULL )
+	{
+		return NULL;
+	}
+
+	/* If the block is larger than required it can be split into two.  The
+	block behind it is never free (free blocks are always coalesced), so the
+	remainder needs no merging. */
+	if( ( pxBlock->xBlockSize - xWantedSize ) > heapMINIMUM_BLOCK_SIZE )
+	{
+		pxNewBlockLink = ( void * ) ( ( ( uint8_t * ) pxBlock ) + xWantedSize );
+		pxNewBlockLink->xBlockSize = pxBlock->xBlockSize - xWantedSize;
+		pxNewBlockLink->pxPrevPhysBlock = pxBlock;
+		prvNextPhysBlock( pxNewBlockLink )->pxPrevPhysBlock = pxNewBlockLink;
+		pxBlock->xBlockSize = xWantedSize;
+
+		prvInsertFreeBlock( pxControl, pxNewBlockLink );
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+#if( configUSE_MALLOC_DEBUG == 1 )
+	/* Record the current task handle. */
+	if( xTaskGetCurrentTaskHandle() && ( xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED ) )
+	{
+		pxBlock->xOwner = xTaskGetCurrentTaskHandle();
+	}
+	else
+	{
+		pxBlock->xOwner = NULL;
+	}
+
+	/* Record the wanted size. */
+	pxBlock->xWantedSize = xOrgWantedSize;
+#endif
+
+#ifdef CONFIG_MEM_HEAP_PERIOD_TIME_DEBUG
+	_xFreeBytes -= pxBlock->xBlockSize;
+
+	if (_xFreeBytes < _xMinimumEverFreeBytes)
+		_xMinimumEverFreeBytes = _xFreeBytes;
+#endif /* CONFIG_MEM_HEAP_PERIOD_TIME_DEBUG */
+
+	xFreeBytesRemaining -= pxBlock->xBlockSize;
+
+	if( xFreeBytesRemaining < xMinimumEverFreeBytesRemaining )
+	{
+		xMinimumEverFreeBytesRemaining = xFreeBytesRemaining;
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	/* The block is being returned - it is allocated and owned by the
+	application and is in no list. */
+	pxBlock->xBlockSize |= _xBlockAllocatedBit;
+	pxBlock->pxNextFreeBlock = NULL;
+	pxBlock->pxPrevFreeBlock = NULL;
+
+	/* Return the memory space pointed to - jumping over the BlockLink_t
+	structure at its start. */
+	return ( void * ) ( ( ( uint8_t * ) pxBlock ) + xHeapStructSize );
+}
+
+/*
+ * Adds the header, tail canary and alignment padding to a requested size.
+ * Returns 0 if the request can't be satisfied at all.
+ */
+static inline size_t prvAdjustWantedSize( size_t xWantedSize )
+{
+	/* Check the requested block size is not so large that the top bit is
+	set.  The top bit of the block size member of the BlockLink_t structure
+	is used to determine who owns the block - the application or the
+	kernel, so it must be free. */
+	if( ( xWantedSize == 0 ) || ( ( xWantedSize & _xBlockAllocatedBit ) != 0 ) )
+	{
+		return 0;
+	}
+
+	/* The wanted size is increased so it can contain a BlockLink_t
+	structure in addition to the requested amount of bytes. */
+	xWantedSize += xHeapStructSize;
+
+#if( configUSE_MALLOC_DEBUG == 1 )
+	xWantedSize += sizeof(uint32_t); /* Room for the tail canary. */
+#endif
+
+	/* Ensure that blocks are always aligned to the required number
+	of bytes. */
+	if( ( xWantedSize & portBYTE_ALIGNMENT_MASK ) != 0x00 )
+	{
+		/* Byte alignment required. */
+		xWantedSize += ( portBYTE_ALIGNMENT - ( xWantedSize & portBYTE_ALIGNMENT_MASK ) );
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	if( xWantedSize > xFreeBytesRemaining )
+	{
+		return 0;
+	}
+
+	return xWantedSize;
+}
+
+static void prvMallocDone( void *pvReturn )
+{
+#if( configUSE_MALLOC_DEBUG == 1 )
+    if( pvReturn != NULL )
+    {
+        vPortAddToAllocList( ( BlockLink_t * ) ( (uint32_t) pvReturn - xHeapStructSize ) );
+    }
+#endif
+
+	( void ) xTaskResumeAll();
+
+	#if( configUSE_MALLOC_FAILED_HOOK == 1 )
+	{
+		if( pvReturn == NULL )
+		{
+			extern void vApplicationMallocFailedHook( void );
+			vApplicationMallocFailedHook();
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+	#endif
+}
+
+#ifdef CONFIG_MEM_HEAP_DEBUG
+static inline void prvRecordCaller( void *pvReturn, const char *xFuncName )
+{
+BlockLink_t *pxBlock = ( BlockLink_t * ) ( ( ( uint8_t * ) pvReturn ) - xHeapStructSize );
+
+	memset(pxBlock->xFuncName, '\0', CONFIG_MEM_HEAP_DEBUG_FUNCNAMELEN);
+	strncpy(pxBlock->xFuncName, xFuncName, CONFIG_MEM_HEAP_DEBUG_FUNCNAMELEN);
+}
+#endif
+
+/*-----------------------------------------------------------*/
+
+#ifdef CONFIG_SUPPORT_DMA_DYNAMIC_ALLOC
+
+static __ilm__ void *prvTlsfMallocDMA( size_t xWantedSize, size_t xOrgWantedSize )
+{
+void *pvReturn;
+
+	pvReturn = prvTlsfMalloc( pxTlsfDMA, xWantedSize, xOrgWantedSize );
+	if( pvReturn != NULL && pxTlsfDMA != &xTlsf )
+	{
+		/* Tell vPortFree() which heap to give it back to. */
+		( ( BlockLink_t * ) ( ( ( uint8_t * ) pvReturn ) - xHeapStructSize ) )->pxNextFreeBlock = ( void * ) DMA_BUFFER_MARK;
+	}
+
+	return pvReturn;
+}
+
+#ifdef CONFIG_MEM_HEAP_DEBUG
+__ilm__ void *pvPortMallocDMA( size_t xWantedSize, const char *xFuncName )
+#else
+__ilm__ void *pvPortMallocDMA( size_t xWantedSize )
+#endif
+{
+size_t xOrgWantedSize = xWantedSize;
+void *pvReturn = NULL;
+
+	/* The heap must be initialised before the first call to
+	prvPortMalloc(). */
+	configASSERT( pxTlsfDMA );
+
+	vTaskSuspendAll();
+	{
+		xWantedSize = prvAdjustWantedSize( xWantedSize );
+		if( xWantedSize > 0 )
+		{
+			pvReturn = prvTlsfMallocDMA( xWantedSize, xOrgWantedSize );
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+
+#ifdef CONFIG_MEM_HEAP_DEBUG
+		if( pvReturn != NULL )
+		{
+			prvRecordCaller( pvReturn, xFuncName );
+		}
+#endif
+
+		traceMALLOC( pvReturn, xWantedSize );
+	}
+
+	prvMallocDone( pvReturn );
+
+	return pvReturn;
+}
+
+#endif /* CONFIG_SUPPORT_DMA_DYNAMIC_ALLOC */
+
+void *p_pvPortMalloc( size_t xWantedSize );
+extern void *(*pvPortMalloc)( size_t xWantedSize );
+PATCH(pvPortMalloc, &pvPortMalloc, &p_pvPortMalloc);
+
+static void conv_to_str(char *out, uint32_t in) __maybe_unused;
+static void conv_to_str(char *out, uint32_t in)
+{
+	int i;
+	uint8_t b;
+	for (i = 0; i < 8; i++) {
+		b = (in >> (4 * (7 - i))) & 0xf;
+		*(out + i) = b < 10 ? '0' + b : 'a' + (b - 10);
+	}
+}
+
+__ilm__ void *p_pvPortMalloc( size_t xWantedSize )
+{
+size_t xOrgWantedSize = xWantedSize;
+void *pvReturn = NULL;
+
+	/* The heap must be initialised before the first call to
+	prvPortMalloc(). */
+	configASSERT( xTlsfInitialised );
+
+	vTaskSuspendAll();
+	{
+		xWantedSize = prvAdjustWantedSize( xWantedSize );
+		if( xWantedSize > 0 )
+		{
+			pvReturn = prvTlsfMalloc( &xTlsf, xWantedSize, xOrgWantedSize );
+
+#ifdef CONFIG_SUPPORT_DMA_DYNAMIC_ALLOC
+			if( ( pvReturn == NULL ) && ( pxTlsfDMA != NULL ) && ( pxTlsfDMA != &xTlsf ) )
+			{
+				pvReturn = prvTlsfMallocDMA( xWantedSize, xOrgWantedSize );
+			}
+#endif
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+
+#ifdef CONFIG_MEM_HEAP_DEBUG
+#if CONFIG_MEM_HEAP_DEBUG_FUNCNAMELEN < 14
+#error "FUNCNAMELEN is too small."
+#endif
+		if( pvReturn != NULL )
+		{
+			/* There is nothing to record but the return address. */
+			BlockLink_t *pxBlock = ( BlockLink_t * ) ( ( ( uint8_t * ) pvReturn ) - xHeapStructSize );
+			uint32_t ra = (uint32_t)__builtin_return_address(0);
+
+			memset(pxBlock->xFuncName, '\0', CONFIG_MEM_HEAP_DEBUG_FUNCNAMELEN);
+			pxBlock->xFuncName[0] = 'r';
+			pxBlock->xFuncName[1] = 'o';
+			pxBlock->xFuncName[2] = '-';
+			conv_to_str(pxBlock->xFuncName + 3, ra);
+		}
+#endif
+
+		traceMALLOC( pvReturn, xWantedSize );
+	}
+
+	prvMallocDone( pvReturn );
+
+	return pvReturn;
+}
+
+#ifdef CONFIG_MEM_HEAP_DEBUG
+
+/* This is the same with pvPortMalloc except for recording caller's name. */
+
+__ilm__ void *pvPortMallocDbg( size_t xWantedSize, const char *xFuncName )
+{
+size_t xOrgWantedSize = xWantedSize;
+void *pvReturn = NULL;
+
+	/* The heap must be initialised before the first call to
+	prvPortMalloc(). */
+	configASSERT( xTlsfInitialised );
+
+	vTaskSuspendAll();
+	{
+		xWantedSize = prvAdjustWantedSize( xWantedSize );
+		if( xWantedSize > 0 )
+		{
+			pvReturn = prvTlsfMalloc( &xTlsf, xWantedSize, xOrgWantedSize );
+
+#ifdef CONFIG_SUPPORT_DMA_DYNAMIC_ALLOC
+			if( ( pvReturn == NULL ) && ( pxTlsfDMA != NULL ) && ( pxTlsfDMA != &xTlsf ) )
+			{
+				pvReturn = prvTlsfMallocDMA( xWantedSize, xOrgWantedSize );
+			}
+#endif
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+
+		if( pvReturn != NULL )
+		{
+			prvRecordCaller( pvReturn, xFuncName );
+		}
+
+		traceMALLOC( pvReturn, xWantedSize );
+	}
+
+	prvMallocDone( pvReturn );
+
+	return pvReturn;
+}
+
+#endif
+
+/*-----------------------------------------------------------*/
+
+void p_vPortFree( void *pv );
+extern void (*vPortFree)( void *pv );
+PATCH(vPortFree, &vPortFree, &p_vPortFree);
+
+__ilm__ void p_vPortFree( void *pv )
+{
+uint8_t *puc = ( uint8_t * ) pv;
+BlockLink_t *pxLink;
+TlsfControl_t *pxControl = &xTlsf;
+
+	if( pv != NULL )
+	{
+		/* The memory being freed will have an BlockLink_t structure immediately
+		before it. */
+		puc -= xHeapStructSize;
+
+		/* This casting is to keep the compiler from issuing warnings. */
+		pxLink = ( void * ) puc;
+
+		/* Check the block is actually allocated. */
+		configASSERT( ( pxLink->xBlockSize & _xBlockAllocatedBit ) != 0 );
+#ifdef CONFIG_SUPPORT_DMA_DYNAMIC_ALLOC
+		configASSERT( ( pxLink->pxNextFreeBlock == NULL ) ||
+				      ( (uint32_t)pxLink->pxNextFreeBlock == DMA_BUFFER_MARK ) );
+#else
+		configASSERT( pxLink->pxNextFreeBlock == NULL );
+#endif
+
+		if( ( pxLink->xBlockSize & _xBlockAllocatedBit ) != 0 )
+		{
+#ifdef CONFIG_SUPPORT_DMA_DYNAMIC_ALLOC
+			if( ( pxLink->pxNextFreeBlock == NULL ) ||
+				( (uint32_t) pxLink->pxNextFreeBlock == DMA_BUFFER_MARK) )
+#else
+			if( pxLink->pxNextFreeBlock == NULL )
+#endif
+			{
+				/* The block is being returned to the heap - it is no longer
+				allocated. */
+				pxLink->xBlockSize &= ~_xBlockAllocatedBit;
+
+				vTaskSuspendAll();
+				{
+					/* Add this block to the list of free blocks. */
+					xFreeBytesRemaining += pxLink->xBlockSize;
+
+#ifdef CONFIG_MEM_HEAP_PERIOD_TIME_DEBUG
+					_xFreeBytes += pxLink->xBlockSize;
+#endif
+
+					traceFREE( pv, pxLink->xBlockSize );
+#if( configUSE_MALLOC_DEBUG == 1 )
+                    pxLink->xOwner = NULL;
+                    (void ) xPortRemoveFromAllocList( pxLink );
+#endif
+
+#ifdef CONFIG_SUPPORT_DMA_DYNAMIC_ALLOC
+					if ( ((uint32_t)pxLink->pxNextFreeBlock == DMA_BUFFER_MARK ) )
+					{
+						pxControl = pxTlsfDMA;
+						pxLink->pxNextFreeBlock = NULL;
+					}
+#endif
+
+					prvReleaseBlock( pxControl, pxLink );
+				}
+				( void ) xTaskResumeAll();
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Adds the regions in pxHeapRegions to the heap described by pxControl and
+ * returns the number of bytes made available.
+ */
+static size_t prvAddHeapRegions( TlsfControl_t *pxControl, const HeapRegion_t * const pxHeapRegions )
+{
+BlockLink_t *pxFirstFreeBlockInRegion, *pxEnd = NULL;
+size_t xAlignedHeap;
+size_t xTotalRegionSize, xTotalHeapSize = 0;
+BaseType_t xDefinedRegions = 0;
+size_t xAddress;
+const HeapRegion_t *pxHeapRegion;
+
+	pxHeapRegion = &( pxHeapRegions[ xDefinedRegions ] );
+
+	while( pxHeapRegion->xSizeInBytes > 0 )
+	{
+		xTotalRegionSize = pxHeapRegion->xSizeInBytes;
+
+		/* Ensure the heap region starts on a correctly aligned boundary. */
+		xAddress = ( size_t ) pxHeapRegion->pucStartAddress;
+		if( ( xAddress & portBYTE_ALIGNMENT_MASK ) != 0 )
+		{
+			xAddress += ( portBYTE_ALIGNMENT - 1 );
+			xAddress &= ~portBYTE_ALIGNMENT_MASK;
+
+			/* Adjust the size for the bytes lost to alignment. */
+			xTotalRegionSize -= xAddress - ( size_t ) pxHeapRegion->pucStartAddress;
+		}
+
+		xAlignedHeap = xAddress;
+
+		/* Check blocks are passed in with increasing start addresses. */
+		configASSERT( ( pxEnd == NULL ) || ( xAddress > ( size_t ) pxEnd ) );
+
+		/* pxEnd marks the end of the region.  It is a zero sized block that
+		looks allocated so that free() never merges across it. */
+		xAddress = xAlignedHeap + xTotalRegionSize;
+		xAddress -= xHeapStructSize;
+		xAddress &= ~portBYTE_ALIGNMENT_MASK;
+		pxEnd = ( BlockLink_t * ) xAddress;
+
+		/* To start with there is a single free block in this region that is
+		sized to take up the entire heap region minus the space taken by the
+		end marker. */
+		pxFirstFreeBlockInRegion = ( BlockLink_t * ) xAlignedHeap;
+		pxFirstFreeBlockInRegion->xBlockSize = xAddress - ( size_t ) pxFirstFreeBlockInRegion;
+		pxFirstFreeBlockInRegion->pxPrevPhysBlock = NULL;
+
+		pxEnd->xBlockSize = _xBlockAllocatedBit;
+		pxEnd->pxNextFreeBlock = NULL;
+		pxEnd->pxPrevFreeBlock = NULL;
+		pxEnd->pxPrevPhysBlock = pxFirstFreeBlockInRegion;
+
+		prvInsertFreeBlock( pxControl, pxFirstFreeBlockInRegion );
+
+		xTotalHeapSize += pxFirstFreeBlockInRegion->xBlockSize;
+
+		/* Move onto the next HeapRegion_t structure. */
+		xDefinedRegions++;
+		pxHeapRegion = &( pxHeapRegions[ xDefinedRegions ] );
+	}
+
+	return xTotalHeapSize;
+}
+
+void p_vPortDefineHeapRegions( const HeapRegion_t * const pxHeapRegions );
+extern void (*vPortDefineHeapRegions)( const HeapRegion_t * const pxHeapRegions );
+PATCH(vPortDefineHeapRegions, &vPortDefineHeapRegions, &p_vPortDefineHeapRegions);
+
+void p_vPortDefineHeapRegions( const HeapRegion_t * const pxHeapRegions )
+{
+size_t xTotalHeapSize;
+
+	/* Can only call once! */
+	configASSERT( xTlsfInitialised == pdFALSE );
+
+	/* Work out the position of the top bit in a size_t variable. */
+	_xBlockAllocatedBit = ( ( size_t ) 1 ) << ( ( sizeof( size_t ) * heapBITS_PER_BYTE ) - 1 );
+
+	memset( &xTlsf, 0, sizeof( xTlsf ) );
+
+	xTotalHeapSize = prvAddHeapRegions( &xTlsf, pxHeapRegions );
+	pucHeapStart = pxHeapRegions[ 0 ].pucStartAddress;
+
+	xMinimumEverFreeBytesRemaining = xTotalHeapSize;
+	xFreeBytesRemaining = xTotalHeapSize;
+
+	/* Check something was actually defined before it is accessed. */
+	configASSERT( xTotalHeapSize );
+
+	xTlsfInitialised = pdTRUE;
+
+#if( configUSE_MALLOC_DEBUG == 1 )
+
+    ram[0].vma = __data_start;
+    ram[0].size = ( __data_end - __data_start );
+    ram[1].vma = __bss_start;
+    ram[1].size = ( __bss_end - __bss_start );
+    ram[2].vma = __heap_start;
+    ram[2].size = ( __heap_end - __heap_start );
+#ifdef CONFIG_N22_ONLY
+    ram[3].vma = __heapext1_start;
+    ram[3].size = ( __heapext1_end - __heapext1_start );
+    ram[4].vma = __heapext2_start;
+    ram[4].size = ( __heapext2_end - __heapext2_start );
+#endif
+
+#endif
+}
+
+#ifdef CONFIG_SUPPORT_DMA_DYNAMIC_ALLOC
+
+void vPortDefineHeapRegionsDMA( const HeapRegion_t * const pxHeapRegions )
+{
+size_t xTotalHeapSize;
+
+	/* Can only call after vPortDefineHeapRegions */
+	configASSERT( xTlsfInitialised );
+
+	/* Can only call once! */
+	configASSERT( pxTlsfDMA == NULL );
+
+	/* Check if the nonDMA area and DMA region are the same */
+	if( pxHeapRegions[ 0 ].pucStartAddress == pucHeapStart )
+	{
+		pxTlsfDMA = &xTlsf;
+		return;
+	}
+
+	memset( &xTlsfDMA, 0, sizeof( xTlsfDMA ) );
+
+	xTotalHeapSize = prvAddHeapRegions( &xTlsfDMA, pxHeapRegions );
+
+	xMinimumEverFreeBytesRemaining += xTotalHeapSize;
+	xFreeBytesRemaining += xTotalHeapSize;
+
+	/* Check something was actually defined before it is accessed. */
+	configASSERT( xTotalHeapSize );
+
+	pxTlsfDMA = &xTlsfDMA;
+}
+
+#endif /* CONFIG_SUPPORT_DMA_DYNAMIC_ALLOC */
+
+#if( configUSE_MALLOC_DEBUG == 1 )
+/* Additional functions to scan memory (buffer overflow, memory leaks). */
+
+#define GET_BUFFER_ADDRESS(x) ( uint32_t * ) ( ( uint32_t ) x + xHeapStructSize )
+#define HEAD_CANARY(x)        (x->ulHeadCanary)
+#define TAIL_CANARY(x)      * ( uint32_t * ) ( ( uint32_t ) x + ( x->xBlockSize & ~_xBlockAllocatedBit ) - 4 )
+
+void OPTIMIZE_FAST vPortAddToAllocList( BlockLink_t *pxLink )
+{
+    uint32_t ulPos;
+
+    HEAD_CANARY(pxLink) = HEAD_CANARY_PATTERN;
+    TAIL_CANARY(pxLink) = TAIL_CANARY_PATTERN;
+
+	for( ulPos = 0; ulPos < ARRAY_SIZE( pxAllocList ); ulPos++ )
+    {
+        /* Find the first empty slot and take it. */
+        if( pxAllocList[ ulPos ] == NULL )
+        {
+            pxAllocList[ ulPos ] = pxLink;
+            break;
+        }
+    }
+}
+
+BaseType_t OPTIMIZE_FAST xPortRemoveFromAllocList( BlockLink_t *pxLink )
+{
+    uint32_t ulPos;
+
+    for( ulPos = 0; ulPos < ARRAY_SIZE( pxAllocList ); ulPos++ )
+    {
+        if( pxAllocList[ ulPos ] == pxLink )
+        {
+            pxAllocList[ ulPos ] = NULL;
+            return pdPASS;
+        }
+    }
+
+    return pdFAIL;
+}
+
+/*
+ * Calls pxFn for every block in every free list of pxControl.
+ */
+static void prvForEachFreeBlock( TlsfControl_t *pxControl, void ( *pxFn )( BlockLink_t * ) )
+{
+    BaseType_t xFL, xSL;
+    BlockLink_t *pxIterator;
+
+    for( xFL = 0; xFL < heapFL_INDEX_COUNT; xFL++ )
+    {
+        for( xSL = 0; xSL < heapSL_INDEX_COUNT; xSL++ )
+        {
+            for( pxIterator = pxControl->pxBlocks[ xFL ][ xSL ]; pxIterator != NULL; pxIterator = pxIterator->pxNextFreeBlock )
+            {
+                pxFn( pxIterator );
+            }
+        }
+    }
+}
+
+static void prvSetHeadCanary( BlockLink_t *pxBlock )
+{
+    HEAD_CANARY( pxBlock ) = HEAD_CANARY_PATTERN;
+}
+
+static void prvCheckHeadCanary( BlockLink_t *pxBlock )
+{
+    configASSERT( HEAD_CANARY( pxBlock ) == HEAD_CANARY_PATTERN );
+    configASSERT( ( pxBlock->xBlockSize & _xBlockAllocatedBit ) == 0 );
+}
+
+/* Free blocks get their head canary when they are put into a list; this is
+only kept for those who want to re-arm all of them at once. */
+void OPTIMIZE_FAST vPortUpdateFreeBlockList( void )
+{
+    prvForEachFreeBlock( &xTlsf, prvSetHeadCanary );
+
+#ifdef CONFIG_SUPPORT_DMA_DYNAMIC_ALLOC
+	if ( ( pxTlsfDMA != NULL ) && ( pxTlsfDMA != &xTlsf ) )
+	{
+		prvForEachFreeBlock( pxTlsfDMA, prvSetHeadCanary );
+	}
+#endif
+}
+
+bool OPTIMIZE_FAST vPortIsAlive( TaskHandle_t task )
+{
+	uint32_t i, count;
+	TaskStatus_t *tasks;
+	bool alive = false;
+
+    count = uxTaskGetNumberOfTasks();
+#ifdef CONFIG_MEM_HEAP_DEBUG
+	tasks = pvPortMallocDbg( count * sizeof(TaskStatus_t), __func__ );
+#else
+	tasks = pvPortMalloc( count * sizeof(TaskStatus_t) );
+#endif
+    if( tasks != NULL )
+	{
+      count = uxTaskGetSystemState( tasks, count, NULL );
+
+      for( i = 0U; i < count; i++ )
+	  {
+		  if( tasks[i].xHandle == task )
+		  {
+			  alive = true;
+			  break;
+		  }
+      }
+    }
+
+	vPortFree(tasks);
+
+	return alive;
+}
+
+void OPTIMIZE_FAST vPortCheckIntegrity( void )
+{
+    uint32_t ulPos;
+    TaskStatus_t xTaskStatus;
+    uint32_t ulBufAddr;
+    size_t xBufSize;
+    uint8_t ucCheckHead;
+    uint8_t ucCheckTail;
+    BlockLink_t *pxBlockLink;
+	bool alive = true;
+
+    /* Copy into the local backup. */
+    vTaskEnterCritical();
+    memcpy( pxAllocListCopy, pxAllocList, ARRAY_SIZE( pxAllocListCopy ) * sizeof(BlockLink_t *) );
+    vTaskExitCritical();
+
+    /* Check free blocks. */
+    vTaskSuspendAll();
+    prvForEachFreeBlock( &xTlsf, prvCheckHeadCanary );
+
+#ifdef CONFIG_SUPPORT_DMA_DYNAMIC_ALLOC
+	if ( ( pxTlsfDMA != NULL ) && ( pxTlsfDMA != &xTlsf ) )
+	{
+		prvForEachFreeBlock( pxTlsfDMA, prvCheckHeadCanary );
+	}
+#endif
+    ( void ) xTaskResumeAll();
+
+    /* Check allocated blocks. */
+    for( ulPos = 0; ulPos < ARRAY_SIZE( pxAllocListCopy ); ulPos++ )
+    {
+        pxBlockLink = pxAllocListCopy[ulPos];
+
+        if( pxBlockLink == NULL )
+        {
+            continue;
+        }
+
+        ucCheckHead = ( HEAD_CANARY( pxBlockLink ) == HEAD_CANARY_PATTERN ? 1 : 0 );
+        ucCheckTail = ( TAIL_CANARY( pxBlockLink ) == TAIL_CANARY_PATTERN ? 1 : 0 );
+        if( ucCheckHead == 0 || ucCheckTail == 0 )
+        {
+            printf( "Detected buffer overflow at %s.\n", ucCheckHead ? "tail" : "head" );
+            if( pxBlockLink->xOwner )
+            {
+				alive = vPortIsAlive( pxBlockLink->xOwner );
+				if( alive )
+                {
+                	vTaskGetInfo( pxBlockLink->xOwner, &xTaskStatus, 0, 0 );
+                }
+                ulBufAddr = ( uint32_t ) pxBlockLink + xHeapStructSize;
+                xBufSize =  pxBlockLink->xWantedSize;
+                printf( "Block owner %s address %lx size %lu\n",
+						alive == false ? "(deceased)" : xTaskStatus.pcTaskName,
+						ulBufAddr, xBufSize );
+            }
+            configASSERT( 0 );
+        }
+    }
+    printf("Okay.\n");
+}
+
+static uint32_t ulAllocAddress;
+
+StackType_t *pxSearchInStack( TaskHandle_t xTask)
+{
+    TaskStatus_t xTaskStatus;
+    StackType_t *pxStack;
+    uint8_t ucFound = 0;
+
+    /* Only support a stack growing up for now.
+     * Refer to xTaskCreate.
+     */
+    configASSERT( portSTACK_GROWTH < 0 );
+
+    /* Get the task information. */
+    vTaskGetInfo(xTask, &xTaskStatus, 0, 0);
+
+    for( pxStack = ( StackType_t *) xTask; pxStack > xTaskStatus.pxStackBase; pxStack-- )
+    {
+        if( *pxStack == ulAllocAddress)
+        {
+            ucFound = 1;
+            break;
+        }
+    }
+
+    return ( ucFound ? pxStack : NULL );
+}
+
+#ifdef CONFIG_MEM_HEAP_DEBUG
+
+static void vCopyName(char *pcDest, const char *pcSrc, uint32_t ulDestSz)
+{
+	uint32_t ulPos;
+	const char *pc;
+
+	memset(pcDest, 0, ulDestSz);
+
+	for ( ulPos = 0, pc = pcSrc; ulPos < ulDestSz; ulPos++, pc++ )
+	{
+		if (isalnum( ( int ) *pc ) || ( *pc == '_' ) || ( *pc == ' ' ) || ( *pc == '-' ) )
+		{
+			pcDest[ulPos] = *pc;
+		}
+		else
+		{
+			break;
+		}
+	}
+}
+
+#endif
+
+void OPTIMIZE_FAST vPortMemoryScan( void )
+{
+    uint32_t ulPos;
+    uint32_t ulIndex;
+    TaskHandle_t xTask;
+    TaskStatus_t xTaskStatus;
+    size_t xBufSize;
+    BlockLink_t *pxBlockLink;
+	char xTaskName[configMAX_TASK_NAME_LEN];
+#ifdef CONFIG_MEM_HEAP_DEBUG
+	char xFuncName[CONFIG_MEM_HEAP_DEBUG_FUNCNAMELEN];
+#endif
+#ifdef CONFIG_MEM_HEAP_SEARCH_REF
+    uint8_t ucFound; /* 0 : not found, 1 : in stack, 2 : data, 3 : bss, 4-6 : heap  */
+    const char *location[] = { "nowhere", "stack", "data", "bss", "heap", "heapext1", "heapext2" };
+	uint32_t *pulAddr, *pulEnd;
+#endif
+	bool alive = true;
+
+    vTaskEnterCritical();
+
+    /* Copy into the local backup. */
+    memcpy( pxAllocListCopy, pxAllocList, ARRAY_SIZE( pxAllocListCopy ) * sizeof(BlockLink_t *) );
+
+    /* Cycle through pointer array until null pointer is found. */
+    for( ulPos = 0, ulIndex = 0; ulPos < ARRAY_SIZE( pxAllocListCopy ); ulPos++ )
+    {
+        pxBlockLink = pxAllocListCopy[ulPos];
+
+        if( pxBlockLink == NULL )
+        {
+            continue;
+        }
+
+        /* Get address of allocated buffer that will be searched in the memory. */
+        ulAllocAddress = xHeapStructSize + ( uint32_t ) pxBlockLink;
+        /* Get buffer owner. */
+        xTask = ( TaskHandle_t ) pxBlockLink->xOwner;
+        if( xTask )
+        {
+            alive = vPortIsAlive( xTask );
+            if( alive )
+            {
+                /* Get the task information. */
+                vTaskGetInfo(xTask, &xTaskStatus, 0, 0);
+                strncpy( xTaskName, xTaskStatus.pcTaskName, ( sizeof(xTaskName) - 1 ) );
+            }
+            else
+            {
+               strncpy( xTaskName, "(deceased)", ( sizeof(xTaskName) - 1 ) );
+            }
+        }
+
+#ifdef CONFIG_MEM_HEAP_SEARCH_REF
+        ucFound = 0;
+        /* Only check if there is buffer owner who is alive. */
+        if( xTask != NULL && alive )
+        {
+            if( ( pulAddr = pxSearchInStack( xTask ) ) != NULL )
+            {
+				ucFound = 1;
+            }
+			else
+            {
+                /* Scan defined memory regions if we still don't have reference. */
+                for (int i = 0; i < 5; i++) {
+                    /* Calculate start address. */
+                    pulAddr = ( uint32_t * ) ram[i].vma;
+                    /* Calculate end address. */
+                    pulEnd = ( uint32_t * ) ( ( uint32_t ) ram[i].vma + ram[i].size );
+                    /* Scan memory. */
+                    while( pulAddr < pulEnd )
+                    {
+						/* Let's skip this obvious reference.
+						 */
+						if( ( i == 1 ) && ( pulAddr == &ulAllocAddress ) )
+						{
+							pulAddr++;
+							continue;
+						}
+                        /* Check if we have reference pointers. */
+                        if( ( *pulAddr == ulAllocAddress ) )
+                        {
+                            ucFound = 2 + i;
+                            break;
+                        }
+                        pulAddr++;
+                    }
+                    if( pulAddr < pulEnd )
+                    {
+                        break;
+                    }
+                }
+            }
+        }
+#endif
+
+        xBufSize = pxBlockLink->xWantedSize;
+
+#ifdef CONFIG_MEM_HEAP_DEBUG
+
+		vCopyName( xFuncName, pxBlockLink->xFuncName, ( sizeof(xFuncName) - 1 ) );
+
+#ifdef CONFIG_MEM_HEAP_SEARCH_REF
+        printf("[%4lu] "FMT""FMTF" address %8lx size %5lu at %8s %p\n",
+                ulIndex, xTask ? xTaskName : "(none)", xFuncName, ulAllocAddress,
+				xBufSize, location[ ucFound ], ucFound ? pulAddr : NULL);
+#else /* CONFIG_MEM_HEAP_SEARCH_REF */
+        printf("[%4lu] "FMT""FMTF" address %8lx size %5lu\n", ulIndex,
+				xTask ? xTaskName : "(none)", xFuncName, ulAllocAddress, xBufSize);
+#endif
+
+#else
+#ifdef CONFIG_MEM_HEAP_SEARCH_REF
+        printf("[%4lu] "FMT" address %8lx size %5lu at %8s %p\n",
+                ulIndex, xTask ? xTaskName : "(none)", ulAllocAddress,
+                xBufSize, location[ ucFound ], ucFound ? pulAddr : NULL);
+#else
+        printf("[%4lu] "FMT" address %8lx size %5lu\n", ulIndex,
+				xTask ? xTaskName : "(none)", ulAllocAddress, xBufSize);
+#endif
+#endif
+		ulIndex++;
+    }
+
+    vTaskExitCritical();
+}
+#endif
@@ -0,0 +1,463 @@
+/*
+ * Copyright 2024-2024 Senscomm Semiconductor Co., Ltd.	All rights reserved.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include <hal/kernel.h>
+#include <hal/compiler.h>
+#include <hal/irq.h>
+#include <hal/io.h>
+#include <hal/timer.h>
+
+#include "blog.h"
+
+/*
+ * Ring layout
+ *
+ * Records are contiguous runs of words. A record that would straddle the
+ * end of the ring is preceded by a BLOG_F_PAD record covering the rest of
+ * it. Producers only mask interrupts for the few instructions it takes to
+ * move @head (see blog_reserve()), marshal into a local buffer beforehand
+ * and publish the record by setting BLOG_F_COMMIT. The consumer stops at
+ * the first record that is reserved but not yet committed, so output
+ * stays in order.
+ */
+
+#define BLOG_WORDS	(CONFIG_BLOG_BUF_LEN / sizeof(unsigned long))
+#define BLOG_IDX(i)	((i) & (BLOG_WORDS - 1))
+#define BLOG_HDR_WORDS	(sizeof(struct blog_rec) / sizeof(unsigned long))
+#define BLOG_REC_WORDS	(128 / sizeof(unsigned long))
+#define BLOG_QUAD_WORDS	(sizeof(u64) / sizeof(unsigned long))
+#define BLOG_SPEC_MAX	16
+
+_Static_assert((BLOG_WORDS & (BLOG_WORDS - 1)) == 0,
+	       "CONFIG_BLOG_BUF_LEN must be a power of 2");
+
+__kernel__ struct blog blog;
+
+enum {
+	BLOG_ARG_NONE,		/* %% */
+	BLOG_ARG_INT,
+	BLOG_ARG_LONG,
+	BLOG_ARG_QUAD,
+	BLOG_ARG_PTR,
+	BLOG_ARG_STR,
+	BLOG_ARG_BITS,		/* %b: int and a bit description string */
+	BLOG_ARG_BAD,		/* cannot be deferred */
+};
+
+struct blog_spec {
+	const char *start;
+	const char *end;
+	int nstars;
+	int kind;
+};
+
+/*
+ * Parse the conversion at @p (which points at a '%') with the same
+ * grammar as kvprintf(). %n and %D, which write through or read behind
+ * a caller's pointer, cannot be deferred.
+ */
+static void blog_parse(const char *p, struct blog_spec *s)
+{
+	int lflag = 0, qflag = 0;
+	int ch;
+
+	s->start = p++;
+	s->nstars = 0;
+	for (;;) {
+		switch (ch = *p++) {
+		case '.': case '#': case '+': case '-':
+		case '0': case '1': case '2': case '3': case '4':
+		case '5': case '6': case '7': case '8': case '9':
+		case 'h':
+			continue;
+		case '*':
+			s->nstars++;
+			continue;
+		case 'l':
+			lflag++;
+			continue;
+		case 'q': case 'j':
+			qflag = 1;
+			continue;
+		case 'z': case 't':
+			lflag = lflag ? lflag : 1;
+			continue;
+		case '%':
+			s->kind = BLOG_ARG_NONE;
+			break;
+		case 'c': case 'd': case 'i': case 'o': case 'u':
+		case 'x': case 'X': case 'r': case 'y':
+			if (qflag || lflag > 1)
+				s->kind = BLOG_ARG_QUAD;
+			else if (lflag)
+				s->kind = BLOG_ARG_LONG;
+			else
+				s->kind = BLOG_ARG_INT;
+			break;
+		case 'p':
+			s->kind = BLOG_ARG_PTR;
+			break;
+		case 's':
+			s->kind = BLOG_ARG_STR;
+			break;
+		case 'b':
+			s->kind = BLOG_ARG_BITS;
+			break;
+		case '\0':
+			p--;
+			/* fall through */
+		default:
+			s->kind = BLOG_ARG_BAD;
+			break;
+		}
+		break;
+	}
+	s->end = p;
+	if (s->nstars > 2 || s->end - s->start >= BLOG_SPEC_MAX)
+		s->kind = BLOG_ARG_BAD;
+}
+
+struct blog_text {
+	char *str;
+	size_t remain;
+};
+
+static void blog_text_putc(int ch, void *arg)
+{
+	struct blog_text *t = arg;
+
+	if (t->remain >= 2) {
+		*t->str++ = ch;
+		t->remain--;
+	}
+}
+
+static unsigned long *blog_reserve(unsigned n)
+{
+	struct blog_rec *rec;
+	unsigned long flags;
+	unsigned pos, pad;
+
+	/*
+	 * There is a single hart, so masking interrupts around the update
+	 * of @head costs no more than the atomic_xxx() primitives would,
+	 * and unlike them covers the wrap and overflow checks as well.
+	 * The section is straight-line code, so no producer, ISR or task,
+	 * ever waits or retries here, which is what lock-free would buy.
+	 */
+	local_irq_save(flags);
+	pos = BLOG_IDX(blog.head);
+	pad = pos + n > BLOG_WORDS ? BLOG_WORDS - pos : 0;
+	if (blog.head + pad + n - blog.tail > BLOG_WORDS) {
+		blog.dropped++;
+		local_irq_restore(flags);
+		return NULL;
+	}
+	if (pad) {
+		rec = (struct blog_rec *)&blog.ring[pos];
+		rec->size = pad;
+		rec->flags = BLOG_F_PAD | BLOG_F_COMMIT;
+		blog.head += pad;
+	}
+	rec = (struct blog_rec *)&blog.ring[BLOG_IDX(blog.head)];
+	rec->size = n;
+	rec->flags = 0;
+	blog.head += n;
+	local_irq_restore(flags);
+
+	return (unsigned long *)rec;
+}
+
+/**
+ * blog_vwrite() - queue a log record
+ *
+ * Safe from any context, including interrupt handlers.
+ * Returns 0, or -ENOBUFS if the ring was full and the record was dropped.
+ */
+int blog_vwrite(u8 level, u16 tag, const char *fmt, va_list ap)
+{
+	unsigned long buf[BLOG_REC_WORDS];
+	struct blog_rec *rec = (struct blog_rec *)buf;
+	struct blog_spec s;
+	struct blog_text t;
+	unsigned n = BLOG_HDR_WORDS;
+	const char *p, *str;
+	unsigned long *dst;
+	size_t len;
+	va_list aq;
+	u8 flags;
+	u64 q;
+	int i;
+
+	if (fmt == NULL)
+		fmt = "(fmt null)\n";
+
+	rec->level = level;
+	rec->flags = 0;
+	rec->tag = tag;
+	rec->reserved = 0;
+	rec->ts = tick_to_us(ktime());
+	rec->fmt = fmt;
+
+	va_copy(aq, ap);
+	for (p = strchr(fmt, '%'); p; p = strchr(s.end, '%')) {
+		blog_parse(p, &s);
+		if (s.kind == BLOG_ARG_BAD ||
+		    n + s.nstars + 2 * BLOG_QUAD_WORDS > BLOG_REC_WORDS)
+			goto text;
+		for (i = 0; i < s.nstars; i++)
+			buf[n++] = va_arg(ap, int);
+		switch (s.kind) {
+		case BLOG_ARG_INT:
+			buf[n++] = va_arg(ap, int);
+			break;
+		case BLOG_ARG_LONG:
+			buf[n++] = va_arg(ap, unsigned long);
+			break;
+		case BLOG_ARG_QUAD:
+			q = va_arg(ap, u64);
+			memcpy(&buf[n], &q, sizeof(q));
+			n += BLOG_QUAD_WORDS;
+			break;
+		case BLOG_ARG_PTR:
+			buf[n++] = (unsigned long)va_arg(ap, void *);
+			break;
+		case BLOG_ARG_BITS:
+			buf[n++] = va_arg(ap, int);
+			buf[n++] = (unsigned long)va_arg(ap, char *);
+			break;
+		case BLOG_ARG_STR:
+			str = va_arg(ap, const char *);
+			if (str == NULL)
+				str = "(null)";
+			len = strnlen(str, (BLOG_REC_WORDS - n) *
+				      sizeof(unsigned long) - 1);
+			memcpy(&buf[n], str, len);
+			((char *)&buf[n])[len] = '\0';
+			n += (len + sizeof(unsigned long)) /
+				sizeof(unsigned long);
+			break;
+		}
+	}
+	goto commit;
+
+ text:
+	/* Render it now; the record carries the text instead. */
+	n = BLOG_HDR_WORDS;
+	t.str = (char *)&buf[n];
+	t.remain = (BLOG_REC_WORDS - n) * sizeof(unsigned long);
+	kvprintf(fmt, blog_text_putc, &t, 10, aq);
+	*t.str++ = '\0';
+	n += (t.str - (char *)&buf[n] + sizeof(unsigned long) - 1) /
+		sizeof(unsigned long);
+	rec->flags = BLOG_F_TEXT;
+	rec->fmt = NULL;
+
+ commit:
+	va_end(aq);
+	rec->size = n;
+
+	dst = blog_reserve(n);
+	if (dst == NULL)
+		return -ENOBUFS;
+
+	flags = rec->flags;
+	rec->flags = 0;
+	memcpy(dst, buf, n * sizeof(unsigned long));
+	barrier();
+	((struct blog_rec *)dst)->flags = flags | BLOG_F_COMMIT;
+
+	return 0;
+}
+
+/*
+ * Rendering
+ */
+
+struct blog_out {
+	void (*putc)(int, void *);
+	void *arg;
+	int last;
+};
+
+static struct blog_out blog_out = {
+	.last = '\n',
+};
+
+static void blog_putc(int ch, void *arg)
+{
+	struct blog_out *o = arg;
+
+	o->putc(ch, o->arg);
+	o->last = ch;
+}
+
+static void blog_printf(struct blog_out *o, const char *fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	kvprintf(fmt, blog_putc, o, 10, ap);
+	va_end(ap);
+}
+
+#define blog_fmt(o, spec, s, star, ...) do {				\
+	if ((s)->nstars == 0)						\
+		blog_printf(o, spec, __VA_ARGS__);			\
+	else if ((s)->nstars == 1)					\
+		blog_printf(o, spec, (star)[0], __VA_ARGS__);		\
+	else								\
+		blog_printf(o, spec, (star)[0], (star)[1], __VA_ARGS__); \
+} while (0)
+
+__weak const char *blog_tag_name(u16 tag)
+{
+	return "?";
+}
+
+static void blog_render(struct blog_out *o, struct blog_rec *rec)
+{
+	static const char prefix[] = "NEWIDV";
+	unsigned long *a = rec->arg;
+	char spec[BLOG_SPEC_MAX];
+	struct blog_spec s;
+	const char *p;
+	int star[2];
+	u64 q;
+	int i;
+
+	if (rec->tag == BLOG_TAG_KERNEL) {
+		if (o->last == '\n')
+			blog_printf(o, "[%06u.%06u] ", rec->ts / 1000000,
+				    rec->ts % 1000000);
+	} else {
+		if (o->last != '\n')
+			blog_putc('\n', o);
+		blog_printf(o, "%c (%u) %s: ",
+			    rec->level < sizeof(prefix) - 1 ?
+			    prefix[rec->level] : 'N',
+			    rec->ts / 1000, blog_tag_name(rec->tag));
+	}
+
+	if (rec->flags & BLOG_F_TEXT) {
+		blog_printf(o, "%s", (char *)a);
+		goto out;
+	}
+
+	for (p = rec->fmt; *p; p = s.end) {
+		if (*p != '%') {
+			blog_putc(*p, o);
+			s.end = p + 1;
+			continue;
+		}
+		blog_parse(p, &s);
+		memcpy(spec, s.start, s.end - s.start);
+		spec[s.end - s.start] = '\0';
+		for (i = 0; i < s.nstars; i++)
+			star[i] = (int)*a++;
+		switch (s.kind) {
+		case BLOG_ARG_NONE:
+			blog_putc('%', o);
+			break;
+		case BLOG_ARG_INT:
+			blog_fmt(o, spec, &s, star, (int)*a);
+			a++;
+			break;
+		case BLOG_ARG_LONG:
+			blog_fmt(o, spec, &s, star, (long)*a);
+			a++;
+			break;
+		case BLOG_ARG_QUAD:
+			memcpy(&q, a, sizeof(q));
+			blog_fmt(o, spec, &s, star, q);
+			a += BLOG_QUAD_WORDS;
+			break;
+		case BLOG_ARG_PTR:
+			blog_fmt(o, spec, &s, star, (void *)*a);
+			a++;
+			break;
+		case BLOG_ARG_BITS:
+			blog_fmt(o, spec, &s, star, (int)a[0], (char *)a[1]);
+			a += 2;
+			break;
+		case BLOG_ARG_STR:
+			blog_fmt(o, spec, &s, star, (char *)a);
+			a += (strlen((char *)a) + sizeof(unsigned long)) /
+				sizeof(unsigned long);
+			break;
+		}
+	}
+
+ out:
+	if (rec->tag != BLOG_TAG_KERNEL && o->last != '\n')
+		blog_putc('\n', o);
+}
+
+/**
+ * blog_drain() - render all committed records through @putc
+ *
+ * Called from klogd and console_flush(). Only one caller walks the ring
+ * at a time; a concurrent caller returns right away.
+ * Returns the number of records rendered.
+ */
+int blog_drain(void (*putc)(int, void *), void *arg)
+{
+	struct blog_out *o = &blog_out;
+	struct blog_rec *rec;
+	unsigned long flags, dropped;
+	int n = 0;
+
+	local_irq_save(flags);
+	if (blog.draining) {
+		local_irq_restore(flags);
+		return 0;
+	}
+	blog.draining = 1;
+	local_irq_restore(flags);
+
+	o->putc = putc;
+	o->arg = arg;
+
+	while (blog.tail != blog.head) {
+		rec = (struct blog_rec *)&blog.ring[BLOG_IDX(blog.tail)];
+		if (!(rec->flags & BLOG_F_COMMIT))
+			break;
+		barrier();
+		if (!(rec->flags & BLOG_F_PAD)) {
+			blog_render(o, rec);
+			n++;
+		}
+		rec->flags = 0;
+		barrier();
+		blog.tail += rec->size;
+	}
+
+	local_irq_save(flags);
+	dropped = blog.dropped;
+	blog.dropped = 0;
+	local_irq_restore(flags);
+
+	if (dropped) {
+		if (o->last != '\n')
+			blog_putc('\n', o);
+		blog_printf(o, "<%lu log records dropped>\n", dropped);
+	}
+
+	blog.draining = 0;
+
+	return n;
+}
@@ -21,6 +21,7 @@
 #include <string.h>
 
 #include <bug.h>
+#include <blog.h>
 
 #define LOG_LINE_MAX 128
 
@@ -471,6 +472,7 @@ static void printk_putc(int c, void *arg)
 
 
 
+#ifndef CONFIG_BLOG
 static int kprintf(const char *const fmt, ...)
 {
 	va_list ap;
@@ -482,16 +484,36 @@ static int kprintf(const char *const fmt, ...)
 
 	return len;
 }
+#endif
 
 #include <cmsis_os.h>
 
 static osSemaphoreId_t printk_sem;
 
+#ifdef CONFIG_BLOG
+static void printk_count(int ch, void *arg)
+{
+}
+#endif
+
 int _printk(const char *const fmt, ...)
 {
 	va_list ap;
-	unsigned timestamp = 0;
 	int len = 0;
+
+#ifdef CONFIG_BLOG
+	/*
+	 * Output is left to klogd, but callers still get the length of
+	 * the message, as they did when it was printed here.
+	 */
+	va_start(ap, fmt);
+	len = kvprintf(fmt, printk_count, NULL, 10, ap);
+	va_end(ap);
+	va_start(ap, fmt);
+	blog_vwrite(0, BLOG_TAG_KERNEL, fmt, ap);
+	va_end(ap);
+#else
+	unsigned timestamp = 0;
 	unsigned long flags;
 
 	local_irq_save(flags);
@@ -503,13 +525,19 @@ int _printk(const char *const fmt, ...)
 	len += kvprintf(fmt, printk_putc, NULL, 10, ap);
 	va_end(ap);
 	local_irq_restore(flags);
+#endif
+
+	klogd_kick();
+
+	return len;
+}
 
+void klogd_kick(void)
+{
 	if (kernel_in_panic())
 		console_flush();
 	else
 		osSemaphoreRelease(printk_sem);
-
-	return len;
 }
 
 #ifdef CONFIG_LINK_TO_ROM
@@ -645,6 +673,8 @@ void console_flush(void)
 {
 	char c;
 
+	blog_drain(printk_putc, NULL);
+
 	/* Overflow */
 	if (printk_head - printk_tail > PRINTK_BUFSIZ)
 		printk_tail  = printk_head - PRINTK_BUFSIZ;
@@ -682,6 +712,10 @@ int _printk(const char *const fmt, ...)
 	return 0;
 }
 
+void klogd_kick(void)
+{
+}
+
 #ifdef CONFIG_LINK_TO_ROM
 PROVIDE(printk, &printk, &_printk);
 #else
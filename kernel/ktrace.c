@@ -0,0 +1,182 @@
+/*
+ * Copyright 2024-2024 Senscomm Semiconductor Co., Ltd.	All rights reserved.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <hal/kernel.h>
+#include <hal/kmem.h>
+#include <cli.h>
+
+#include "ktrace.h"
+
+_Static_assert((KTRACE_ENTRIES & (KTRACE_ENTRIES - 1)) == 0,
+	       "CONFIG_KTRACE_ENTRIES must be a power of 2");
+_Static_assert(KTRACE_MAX <= 32, "too many trace events for the mask");
+
+__kernel__ struct ktrace_ev ktrace_ring[KTRACE_ENTRIES];
+volatile u32 ktrace_head;
+volatile u32 ktrace_mask;
+
+static const char *const ktrace_name[KTRACE_MAX] = {
+	[KTRACE_MAC_ISR]	= "mac_isr",
+	[KTRACE_WLAN_RX]	= "wlan_rx",
+	[KTRACE_WLAN_REFILL]	= "wlan_refill",
+	[KTRACE_ETHER_INPUT]	= "ether_input",
+	[KTRACE_TCPIP_MSG]	= "tcpip_msg",
+	[KTRACE_SCDC_DATA]	= "scdc_data",
+	[KTRACE_SDIO_WRITE]	= "sdio_write",
+};
+
+static const char ktrace_ph[] = { 'B', 'E', 'i' };
+
+static int ktrace_lookup(const char *name)
+{
+	int i;
+
+	for (i = 0; i < KTRACE_MAX; i++)
+		if (!strcmp(name, ktrace_name[i]))
+			return i;
+
+	return -1;
+}
+
+static int ktrace_start(int argc, char *argv[])
+{
+	u32 mask = 0;
+	int i, id;
+
+	for (i = 1; i < argc; i++) {
+		id = ktrace_lookup(argv[i]);
+		if (id < 0) {
+			printf("unknown event %s\n", argv[i]);
+			return CMD_RET_FAILURE;
+		}
+		mask |= 1 << id;
+	}
+
+	ktrace_mask = mask ? mask : (1 << KTRACE_MAX) - 1;
+
+	return CMD_RET_SUCCESS;
+}
+
+static int ktrace_stop(int argc, char *argv[])
+{
+	ktrace_mask = 0;
+
+	return CMD_RET_SUCCESS;
+}
+
+static int ktrace_clear(int argc, char *argv[])
+{
+	u32 mask = ktrace_mask;
+
+	ktrace_mask = 0;
+	ktrace_head = 0;
+	memset(ktrace_ring, 0, sizeof(ktrace_ring));
+	ktrace_mask = mask;
+
+	return CMD_RET_SUCCESS;
+}
+
+static int ktrace_stat(int argc, char *argv[])
+{
+	int i;
+
+	printf("%s, %u events recorded, ring of %u\n",
+	       ktrace_mask ? "running" : "stopped",
+	       ktrace_head, KTRACE_ENTRIES);
+	for (i = 0; i < KTRACE_MAX; i++)
+		printf("  %c %s\n", ktrace_mask & (1 << i) ? '*' : ' ',
+		       ktrace_name[i]);
+
+	return CMD_RET_SUCCESS;
+}
+
+/*
+ * Text dump, one record per line:
+ *
+ *   T <task> <pid> <name>			live tasks
+ *   E <us> <B|E|i> <event> <task> <arg>	events, oldest first
+ *
+ * Interrupt events have task 0. Tracing is stopped while dumping.
+ */
+static int ktrace_dump(int argc, char *argv[])
+{
+	TaskStatus_t *tasks;
+	struct ktrace_ev *ev;
+	u32 mask = ktrace_mask;
+	u32 head, n, i;
+	int nr_task;
+
+	ktrace_mask = 0;
+
+	nr_task = uxTaskGetNumberOfTasks();
+	tasks = kmalloc(nr_task * sizeof(*tasks));
+	if (tasks) {
+		nr_task = uxTaskGetSystemState(tasks, nr_task, NULL);
+		for (i = 0; i < nr_task; i++)
+			printf("T %p %u %s\n", tasks[i].xHandle,
+			       (unsigned)tasks[i].xTaskNumber,
+			       tasks[i].pcTaskName);
+		kfree(tasks);
+	}
+
+	head = ktrace_head;
+	n = min(head, (u32)KTRACE_ENTRIES);
+	for (i = head - n; i != head; i++) {
+		ev = &ktrace_ring[i & (KTRACE_ENTRIES - 1)];
+		if (ev->id >= KTRACE_MAX || ev->ph >= sizeof(ktrace_ph))
+			continue;
+		printf("E %u %c %s %p 0x%x\n", tick_to_us(ev->ts),
+		       ktrace_ph[ev->ph], ktrace_name[ev->id],
+		       ev->ctx, ev->arg);
+	}
+
+	ktrace_mask = mask;
+
+	return CMD_RET_SUCCESS;
+}
+
+static const struct cli_cmd ktrace_cmd[] = {
+	CMDENTRY(start, ktrace_start, "", ""),
+	CMDENTRY(stop, ktrace_stop, "", ""),
+	CMDENTRY(clear, ktrace_clear, "", ""),
+	CMDENTRY(dump, ktrace_dump, "", ""),
+	CMDENTRY(stat, ktrace_stat, "", ""),
+};
+
+static int do_ktrace(int argc, char *argv[])
+{
+	const struct cli_cmd *cmd;
+
+	argc--;
+	argv++;
+
+	if (argc == 0)
+		return CMD_RET_USAGE;
+
+	cmd = cli_find_cmd(argv[0], ktrace_cmd, ARRAY_SIZE(ktrace_cmd));
+	if (cmd == NULL)
+		return CMD_RET_USAGE;
+
+	return cmd->handler(argc, argv);
+}
+
+CMD(ktrace, do_ktrace,
+	"hot path event tracer",
+	"ktrace start [event...]" OR
+	"ktrace stop" OR
+	"ktrace clear" OR
+	"ktrace stat" OR
+	"ktrace dump"
+);
@@ -32,11 +32,38 @@
 #include "hal/init.h"
 #include "hal/timer.h"
 
+#include <cli.h>
+
 #include "mem_slab.h"
 
 /* The list of defined memory slabs */
 LIST_HEAD_DEF(memslabs);
 
+/*
+ * The free list is a stack of block indices, so that it can be popped
+ * and pushed with a single compare-and-swap from tasks and interrupt
+ * handlers alike. The head packs a 16-bit modification tag above the
+ * index (1-based, 0 being the empty list) of the top block, which keeps
+ * a stale head from being swapped back in (ABA). Every free block holds
+ * the index of the next one in its first word.
+ */
+#define SLAB_IDX_MASK   0xffffU
+#define SLAB_TAG_ONE    (SLAB_IDX_MASK + 1)
+
+static inline char *slab_block(struct mem_slab *slab, uint32_t idx)
+{
+    return slab->buffer + (idx - 1) * slab->info.block_size;
+}
+
+static inline uint32_t slab_index(struct mem_slab *slab, const void *mem)
+{
+    return ((const char *)mem - slab->buffer) / slab->info.block_size + 1;
+}
+
+static inline uint32_t slab_head(uint32_t old, uint32_t idx)
+{
+    return ((old + SLAB_TAG_ONE) & ~SLAB_IDX_MASK) | idx;
+}
 
 /**
  * @brief Initialize kernel memory slab subsystem.
@@ -50,7 +77,7 @@ LIST_HEAD_DEF(memslabs);
 
 static int create_free_list(struct mem_slab *slab)
 {
-    char *p;
+    uint32_t i;
 
     /* blocks must be word aligned */
     if (((slab->info.block_size | (uintptr_t)slab->buffer) &
@@ -58,28 +85,32 @@ static int create_free_list(struct mem_slab *slab)
         return -EINVAL;
     }
 
-    slab->free_list = NULL;
-    p = slab->buffer + slab->info.block_size * (slab->info.num_blocks - 1);
+    if (slab->info.num_blocks > SLAB_IDX_MASK) {
+        return -EINVAL;
+    }
 
-    while (p >= slab->buffer) {
-        *(char **)p = slab->free_list;
-        slab->free_list = p;
-        p -= slab->info.block_size;
+    for (i = 1; i < slab->info.num_blocks; i++) {
+        *(uint32_t *)slab_block(slab, i) = i + 1;
     }
+    if (slab->info.num_blocks) {
+        *(uint32_t *)slab_block(slab, slab->info.num_blocks) = 0;
+    }
+
+    slab->free_head = slab->info.num_blocks ? 1 : 0;
+    slab->waiters = 0;
+
     return 0;
 }
 
 static int create_wait_q(struct mem_slab *slab)
 {
-    osMessageQueueAttr_t attr = {0,};
+    osSemaphoreAttr_t attr = {0,};
 
     attr.cb_mem = &slab->cb;
     attr.cb_size = sizeof(slab->cb);
-    attr.mq_mem = &slab->free_block;
-    attr.mq_size = sizeof(char *);
-    slab->wait_q = osMessageQueueNew(1, sizeof(char *), &attr);
+    slab->wait_sem = osSemaphoreNew(1, 0, &attr);
 
-    if (slab->wait_q == NULL) {
+    if (slab->wait_sem == NULL) {
         return -EINVAL;
     }
 
@@ -91,11 +122,10 @@ int mem_slab_init(struct mem_slab *slab, void *buffer,
 {
     int rc = 0;
 
+    memset(&slab->info, 0, sizeof(slab->info));
     slab->info.num_blocks = num_blocks;
     slab->info.block_size = block_size;
     slab->buffer = buffer;
-    slab->info.num_used = 0U;
-    slab->info.max_used = 0U;
 
     rc = create_free_list(slab);
     if (rc < 0) {
@@ -118,17 +148,17 @@ err:
 
 static int delete_wait_q(struct mem_slab *slab)
 {
-    if (slab->wait_q == NULL) {
+    if (slab->wait_sem == NULL) {
         return 0;
     }
 
-    assert(osMessageQueueGetCount(slab->wait_q) == 0);
+    assert(slab->waiters == 0);
 
-    if (osMessageQueueDelete(slab->wait_q)) {
+    if (osSemaphoreDelete(slab->wait_sem)) {
         return -EINVAL;
     }
 
-    slab->wait_q = NULL;
+    slab->wait_sem = NULL;
 
     return 0;
 }
@@ -144,6 +174,9 @@ int mem_slab_deinit(struct mem_slab *slab)
         goto err;
     }
 
+    /* Dynamic slabs are freed by the owner right after this. */
+    list_del(&slab->list);
+
     return 0;
 
 err:
@@ -162,101 +195,204 @@ static bool slab_ptr_is_good(struct mem_slab *slab, const void *ptr)
         ((offset % slab->info.block_size) == 0);
 }
 
-int mem_slab_alloc(struct mem_slab *slab, void **mem, uint32_t timeout)
+static void slab_account(struct mem_slab *slab, uint32_t n)
 {
-    uint32_t flags;
-    int result;
-    osStatus_t stat;
+    uint32_t used, max;
 
-    local_irq_save(flags);
-
-    if (slab->free_list != NULL) {
-        bool sane = true;
-        /* take a free block */
-        *mem = slab->free_list;
-        slab->free_list = *(char **)(slab->free_list);
-        slab->info.num_used++;
-#if 0
-        assert((slab->free_list == NULL &&
-                    slab->info.num_used == slab->info.num_blocks) ||
-                slab_ptr_is_good(slab, slab->free_list));
-#else
-        sane = ((slab->free_list == NULL &&
-                    slab->info.num_used == slab->info.num_blocks) ||
-                slab_ptr_is_good(slab, slab->free_list));
-        if (!sane) {
-            printk("slab: %p, free_list: %p, num_used: %d, num_blocks: %d, block_size: %d, buffer: %p\n",
-                    slab, slab->free_list, slab->info.num_used, slab->info.num_blocks,
-                    slab->info.block_size, slab->buffer);
-            assert(false);
+    used = __atomic_add_fetch(&slab->info.num_used, n, __ATOMIC_RELAXED);
+    max = __atomic_load_n(&slab->info.max_used, __ATOMIC_RELAXED);
+    while (used > max && !__atomic_compare_exchange_n(&slab->info.max_used,
+                &max, used, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+}
+
+/*
+ * Take up to @n blocks off the free list in one go. The links walked
+ * may be stale if someone else got in first, but then the tag has moved
+ * on and the swap fails; only a link out of range on an unchanged head
+ * is a corrupted list.
+ */
+static int slab_pop(struct mem_slab *slab, void **mem, int n)
+{
+    uint32_t old, idx;
+    int i;
+
+    old = __atomic_load_n(&slab->free_head, __ATOMIC_SEQ_CST);
+    do {
+        idx = old & SLAB_IDX_MASK;
+        for (i = 0; i < n && idx; i++) {
+            mem[i] = slab_block(slab, idx);
+            idx = *(volatile uint32_t *)mem[i];
+            if (idx > slab->info.num_blocks) {
+                break;
+            }
         }
-#endif
-        slab->info.max_used = MAX(slab->info.num_used,
-                slab->info.max_used);
-        result = 0;
-    } else if (!timeout) {
-        /* don't wait for a free block to become available */
-        *mem = NULL;
-        result = -ENOMEM;
-    } else {
-        u32 tick;
+        if (idx > slab->info.num_blocks) {
+            uint32_t now = __atomic_load_n(&slab->free_head, __ATOMIC_SEQ_CST);
+
+            if (now == old) {
+                printk("slab: %p, free_head: %x, num_used: %d, num_blocks: %d, block_size: %d, buffer: %p\n",
+                        slab, old, slab->info.num_used, slab->info.num_blocks,
+                        slab->info.block_size, slab->buffer);
+                assert(false);
+            }
+            old = now;
+            continue;
+        }
+        if (i == 0) {
+            return 0;
+        }
+    } while (!__atomic_compare_exchange_n(&slab->free_head, &old,
+                slab_head(old, idx), false,
+                __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST));
+
+    slab_account(slab, i);
+
+    return i;
+}
 
-        local_irq_restore(flags);
+/* Only the free that refills an empty slab can have anyone waiting. */
+static void slab_wake(struct mem_slab *slab)
+{
+    if (__atomic_load_n(&slab->waiters, __ATOMIC_SEQ_CST)) {
+        osSemaphoreRelease(slab->wait_sem);
+    }
+}
 
-        if (timeout == osWaitForever) {
-            tick = timeout;
-        } else {
-            tick = pdMS_TO_TICKS(timeout);
+static void slab_push(struct mem_slab *slab, void **mem, int n)
+{
+    uint32_t old, first;
+    int i;
+
+    for (i = 0; i < n; i++) {
+        assert(slab_ptr_is_good(slab, mem[i]));
+        if (i > 0) {
+            *(uint32_t *)mem[i - 1] = slab_index(slab, mem[i]);
         }
+    }
+    first = slab_index(slab, mem[0]);
 
-        /* wait for a free block or timeout (ms) */
-        stat = osMessageQueueGet(slab->wait_q, mem, NULL, tick);
-        switch (stat) {
-            case osErrorParameter:
-            case osErrorResource:
-                result = -EINVAL;
-                break;
-            case osErrorTimeout:
-                result = -ETIME;
-                break;
-            default:
-                result = 0;
-#if 0
-                printk("Directly sent.\n");
-#endif
-                break;
+    __atomic_sub_fetch(&slab->info.num_used, n, __ATOMIC_RELAXED);
+
+    old = __atomic_load_n(&slab->free_head, __ATOMIC_SEQ_CST);
+    do {
+        *(volatile uint32_t *)mem[n - 1] = old & SLAB_IDX_MASK;
+    } while (!__atomic_compare_exchange_n(&slab->free_head, &old,
+                slab_head(old, first), false,
+                __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST));
+
+    if ((old & SLAB_IDX_MASK) == 0) {
+        slab_wake(slab);
+    }
+}
+
+int mem_slab_alloc_isr(struct mem_slab *slab, void **mem)
+{
+    if (slab_pop(slab, mem, 1)) {
+        return 0;
+    }
+
+    __atomic_add_fetch(&slab->info.num_fail, 1, __ATOMIC_RELAXED);
+    *mem = NULL;
+
+    return -ENOMEM;
+}
+
+void mem_slab_free_isr(struct mem_slab *slab, void *mem)
+{
+    slab_push(slab, &mem, 1);
+}
+
+int mem_slab_alloc_batch(struct mem_slab *slab, void **mem, int n)
+{
+    int got = 0;
+
+    if (n > 0) {
+        got = slab_pop(slab, mem, n);
+        if (got < n) {
+            __atomic_add_fetch(&slab->info.num_fail, 1, __ATOMIC_RELAXED);
         }
-        return result;
     }
 
-    local_irq_restore(flags);
+    return got;
+}
 
-    return result;
+void mem_slab_free_batch(struct mem_slab *slab, void **mem, int n)
+{
+    if (n > 0) {
+        slab_push(slab, mem, n);
+    }
 }
 
-void mem_slab_free(struct mem_slab *slab, void *mem)
+int mem_slab_alloc(struct mem_slab *slab, void **mem, uint32_t timeout)
 {
-    uint32_t flags;
+    uint32_t tick, start, elapsed, wait;
+    uint32_t waiters;
+    osStatus_t stat;
     int result;
 
-    local_irq_save(flags);
+    if (slab_pop(slab, mem, 1)) {
+        return 0;
+    }
+
+    if (!timeout) {
+        /* don't wait for a free block to become available */
+        return mem_slab_alloc_isr(slab, mem);
+    }
+
+    if (timeout == osWaitForever) {
+        tick = timeout;
+    } else {
+        tick = pdMS_TO_TICKS(timeout);
+    }
+    start = osKernelGetTickCount();
+
+    __atomic_add_fetch(&slab->info.num_wait, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&slab->waiters, 1, __ATOMIC_SEQ_CST);
+
+    /* wait for a free block or timeout (ms) */
+    for (;;) {
+        /* Retry after registering, or a free in between goes unnoticed. */
+        if (slab_pop(slab, mem, 1)) {
+            result = 0;
+            break;
+        }
+
+        wait = tick;
+        if (tick != osWaitForever) {
+            elapsed = osKernelGetTickCount() - start;
+            if (elapsed >= tick) {
+                result = -ETIME;
+                break;
+            }
+            wait = tick - elapsed;
+        }
 
-    if (slab->free_list == NULL
-            && osMessageQueueGetNumberOfTasksWaitingToReceive(slab->wait_q) != 0
-            && osMessageQueueGetSpace(slab->wait_q) != 0) {
-        result = osMessageQueuePut(slab->wait_q, &mem, 0, 0);
-        assert(result == osOK || result == osErrorNeedSched);
-        local_irq_restore(flags);
-        return;
+        stat = osSemaphoreAcquire(slab->wait_sem, wait);
+        if (stat == osErrorParameter || stat == osErrorResource) {
+            result = -EINVAL;
+            break;
+        }
     }
 
-    *(char **) mem = slab->free_list;
-    slab->free_list = (char *) mem;
-    slab->info.num_used--;
+    waiters = __atomic_sub_fetch(&slab->waiters, 1, __ATOMIC_SEQ_CST);
+
+    if (result < 0) {
+        __atomic_add_fetch(&slab->info.num_fail, 1, __ATOMIC_RELAXED);
+        *mem = NULL;
+    } else if (waiters && (__atomic_load_n(&slab->free_head,
+                    __ATOMIC_SEQ_CST) & SLAB_IDX_MASK)) {
+        /* More than one block came back; pass the wakeup on. */
+        osSemaphoreRelease(slab->wait_sem);
+    }
 
-    local_irq_restore(flags);
+    return result;
 }
 
+void mem_slab_free(struct mem_slab *slab, void *mem)
+{
+    slab_push(slab, &mem, 1);
+}
 
 /**
  * mem_slab_init() - initialize mem_slab subsystem
@@ -304,3 +440,44 @@ __iram__ static int memory_slab_fini(void)
 }
 
 __finicall__ (subsystem, memory_slab_fini);
+
+static int do_slab(int argc, char *argv[])
+{
+    struct mem_slab *s;
+    bool reset = false;
+
+    if (argc > 2) {
+        return CMD_RET_USAGE;
+    } else if (argc == 2) {
+        if (strcmp(argv[1], "reset")) {
+            return CMD_RET_USAGE;
+        }
+        reset = true;
+    }
+
+    if (!reset) {
+        printf("%-10s %6s %6s %6s %6s %8s %8s\n",
+                "slab", "size", "blocks", "used", "max", "wait", "fail");
+    }
+
+    list_for_each_entry(s, &memslabs, list) {
+        if (reset) {
+            s->info.max_used = s->info.num_used;
+            s->info.num_wait = 0;
+            s->info.num_fail = 0;
+            continue;
+        }
+        printf("%-10p %6d %6d %6d %6d %8d %8d\n", s,
+                s->info.block_size, s->info.num_blocks,
+                s->info.num_used, s->info.max_used,
+                s->info.num_wait, s->info.num_fail);
+    }
+
+    return CMD_RET_SUCCESS;
+}
+
+CMD(slab, do_slab,
+    "show memory slab usage",
+    "slab" OR
+    "slab reset"
+);
@@ -14,83 +14,253 @@
 #include <string.h>
 #include <stdlib.h>
 #include <hal/kernel.h>
+#include <hal/timer.h>
 #include <cli.h>
 
+#include "mbuf.h"
+
 #include "mtsmp.h"
 
-struct m_timestamp mbuf_timestamp = {0};
+#define MTSMP_COOKIE	0x6d74736d	/* "mtsm" */
+#define MTSMP_POOL	32		/* packets in flight, one bit each */
+#define MTSMP_PAIRS	12
+
+/*
+ * Log-linear buckets: exact below 4us, then 4 buckets per power of 2,
+ * up to about 1.8s.
+ */
+#define MTSMP_SUB	4
+#define MTSMP_BUCKETS	80
+
+struct mtsmp_tag {
+	struct m_tag tag;
+	u32 t[MTSMP_STAGES];
+	u8 mask;
+};
+
+struct mtsmp_hist {
+	u8 from;
+	u8 to;
+	u32 n;
+	u32 max;
+	u32 bucket[MTSMP_BUCKETS];
+};
+
+static struct mtsmp_tag mtsmp_pool[MTSMP_POOL];
+static u32 mtsmp_used;
+static u32 mtsmp_missed;
+static struct mtsmp_hist mtsmp_hist[MTSMP_PAIRS];
+
+static const char *const mtsmp_name[MTSMP_STAGES] = {
+	[MTSMP_RX_DRV]	= "rx_drv",
+	[MTSMP_RX_LWIP]	= "rx_lwip",
+	[MTSMP_RX_SOCK]	= "rx_sock",
+	[MTSMP_RX_HOST]	= "rx_host",
+	[MTSMP_TX_HOST]	= "tx_host",
+	[MTSMP_TX_LWIP]	= "tx_lwip",
+	[MTSMP_DONE]	= "done",
+};
+
+static int mtsmp_bucket(u32 us)
+{
+	int msb, idx;
+
+	if (us < MTSMP_SUB)
+		return us;
+
+	msb = ilog2(us);
+	idx = (msb - 1) * MTSMP_SUB + ((us >> (msb - 2)) & (MTSMP_SUB - 1));
+
+	return min(idx, MTSMP_BUCKETS - 1);
+}
+
+static u32 mtsmp_bucket_floor(int idx)
+{
+	if (idx < MTSMP_SUB)
+		return idx;
+
+	return (MTSMP_SUB + idx % MTSMP_SUB) << (idx / MTSMP_SUB - 1);
+}
+
+/* Called with interrupts disabled. */
+static void mtsmp_add(int from, int to, u32 us)
+{
+	struct mtsmp_hist *h;
+	int i;
+
+	for (i = 0; i < MTSMP_PAIRS; i++) {
+		h = &mtsmp_hist[i];
+		if (h->n == 0 || (h->from == from && h->to == to))
+			break;
+	}
+	if (i == MTSMP_PAIRS) {
+		mtsmp_missed++;
+		return;
+	}
+
+	h->from = from;
+	h->to = to;
+	h->n++;
+	h->max = max(h->max, us);
+	h->bucket[mtsmp_bucket(us)]++;
+}
+
+static void mtsmp_tag_free(struct m_tag *t)
+{
+	struct mtsmp_tag *mt = container_of(t, struct mtsmp_tag, tag);
+	unsigned long flags;
+	int i, first = -1, prev = -1;
+
+	mt->t[MTSMP_DONE] = ktime();
+	mt->mask |= 1 << MTSMP_DONE;
+
+	local_irq_save(flags);
+	for (i = 0; i < MTSMP_STAGES; i++) {
+		if (!(mt->mask & (1 << i)))
+			continue;
+		if (prev >= 0)
+			mtsmp_add(prev, i, tick_to_us(mt->t[i] - mt->t[prev]));
+		else
+			first = i;
+		prev = i;
+	}
+	/* End to end, unless that is the only pair anyway. */
+	if (first >= 0 && __builtin_popcount(mt->mask) > 2)
+		mtsmp_add(first, MTSMP_DONE,
+			  tick_to_us(mt->t[MTSMP_DONE] - mt->t[first]));
+	mtsmp_used &= ~(1U << (mt - mtsmp_pool));
+	local_irq_restore(flags);
+}
+
+static struct mtsmp_tag *mtsmp_lookup(struct mbuf *m)
+{
+	struct m_tag *t;
+
+	if (!(m->m_flags & M_PKTHDR) || SLIST_EMPTY(&m->m_pkthdr.tags))
+		return NULL;
+
+	t = m_tag_locate(m, MTSMP_COOKIE, 0, NULL);
 
-int mtsmp_clean(int argc, char *argv[])
+	return t ? container_of(t, struct mtsmp_tag, tag) : NULL;
+}
+
+/**
+ * mtsmp_start() - start following a packet at @stage
+ */
+void mtsmp_start(struct mbuf *m, enum mtsmp_stage stage)
 {
-  tsmp_set(0, outcount, 0);
-  tsmp_set(0, incount, 0);
-  tsmp_init();
-  return 0;
+	struct mtsmp_tag *mt;
+	unsigned long flags;
+	int i;
+
+	if (!(m->m_flags & M_PKTHDR) || m->m_pkthdr.len <= MTSMP_LEN_THR)
+		return;
+
+	if (mtsmp_lookup(m)) {
+		mtsmp_stamp(m, stage);
+		return;
+	}
+
+	local_irq_save(flags);
+	if (mtsmp_used == ~0U) {
+		mtsmp_missed++;
+		local_irq_restore(flags);
+		return;
+	}
+	i = ffz(mtsmp_used);
+	mtsmp_used |= 1U << i;
+	local_irq_restore(flags);
+
+	mt = &mtsmp_pool[i];
+	m_tag_setup(&mt->tag, MTSMP_COOKIE, 0, sizeof(*mt) - sizeof(mt->tag));
+	mt->tag.m_tag_free = mtsmp_tag_free;
+	mt->t[stage] = ktime();
+	mt->mask = 1 << stage;
+	m_tag_prepend(m, &mt->tag);
 }
 
-int mtsmp_out(int argc, char *argv[])
+/**
+ * mtsmp_stamp() - record that a followed packet reached @stage
+ */
+void mtsmp_stamp(struct mbuf *m, enum mtsmp_stage stage)
 {
-  int idx;
-  uint8_t count = 0;
-  uint32_t avg_start_to_end = 0;
-
-  for(idx = 0; idx < COUNT_NUM; idx++)
-  {
-    if (tsmp_valid(out[idx]))
-    {
-      count++;
-      avg_start_to_end += tsmp_diff_out(idx, start_t, end_t);
-
-      printf("idx: %d sf: %d m: %p start: %06u end: %06u\n", idx,
-              tsmp_get_out(idx, subframes), tsmp_get_out(idx, m_out),
-              tsmp_get_out(idx, start_t), tsmp_get_out(idx, end_t));
-      printf("star->end: %06u us\n", tsmp_diff_out(idx, start_t, end_t));
-    }
-  }
-  if (count)
-    tsmp_avg(avg_start_to_end, count);
-
-  printf("\n\n");
-  printf("%d avg start->end: %06u us\n", count, avg_start_to_end);
-
-  return 0;
+	struct mtsmp_tag *mt = mtsmp_lookup(m);
+
+	if (mt == NULL || (mt->mask & (1 << stage)))
+		return;
+
+	mt->t[stage] = ktime();
+	mt->mask |= 1 << stage;
 }
 
-int mtsmp_in(int argc, char *argv[])
+/**
+ * mtsmp_stamp_pbuf() - same as mtsmp_stamp() for a pbuf lent by an mbuf
+ */
+void mtsmp_stamp_pbuf(struct pbuf *p, enum mtsmp_stage stage)
 {
-  int idx;
-  uint8_t count = 0;
-  uint32_t avg_start_to_end = 0;
-
-  for(idx = 0; idx < COUNT_NUM; idx++)
-  {
-    if (tsmp_valid(in[idx]))
-    {
-      count++;
-      avg_start_to_end += tsmp_diff_in(idx, start_t, end_t);
-
-      printf("idx: %d m: %p start: %06u end: %06u\n", idx, tsmp_get_in(idx, m_in),
-              tsmp_get_in(idx, start_t), tsmp_get_in(idx, end_t));
-
-      printf("start->end: %06u us\n", tsmp_diff_in(idx, start_t, end_t));
-    }
-  }
-
-  if (count)
-    tsmp_avg(avg_start_to_end, count);
-
-  printf("\n\n");
-  printf("%d avg start->end: %06u us\n", count, avg_start_to_end);
-  return 0;
+#ifdef CONFIG_FREEBSD_MBUF_PBUF_ZEROCOPY
+	struct mbuf *m = m_pbuf_getm(p);
+
+	if (m)
+		mtsmp_stamp(m, stage);
+#endif
+}
+
+/* Smallest bucket floor at or above the @pct percentile. */
+static u32 mtsmp_pct(struct mtsmp_hist *h, int pct)
+{
+	u32 target = (h->n * pct + 99) / 100, sum = 0;
+	int i;
+
+	for (i = 0; i < MTSMP_BUCKETS; i++) {
+		sum += h->bucket[i];
+		if (sum >= target)
+			return mtsmp_bucket_floor(i);
+	}
+
+	return h->max;
 }
 
 /**
- * mbuf timestamp CLI commands
+ * mbuf stage latency CLI commands
  */
 
+static int mtsmp_show(int argc, char *argv[])
+{
+	struct mtsmp_hist *h;
+	int i;
+
+	printf("%-8s %-8s %8s %8s %8s %8s %8s (us)\n",
+	       "from", "to", "count", "p50", "p90", "p99", "max");
+	for (i = 0; i < MTSMP_PAIRS; i++) {
+		h = &mtsmp_hist[i];
+		if (h->n == 0)
+			break;
+		printf("%-8s %-8s %8u %8u %8u %8u %8u\n",
+		       mtsmp_name[h->from], mtsmp_name[h->to], h->n,
+		       mtsmp_pct(h, 50), mtsmp_pct(h, 90), mtsmp_pct(h, 99),
+		       h->max);
+	}
+	printf("in flight: %d, missed: %u\n",
+	       __builtin_popcount(mtsmp_used), mtsmp_missed);
+
+	return 0;
+}
+
+static int mtsmp_clean(int argc, char *argv[])
+{
+	unsigned long flags;
+
+	local_irq_save(flags);
+	memset(mtsmp_hist, 0, sizeof(mtsmp_hist));
+	mtsmp_missed = 0;
+	local_irq_restore(flags);
+
+	return 0;
+}
+
 static const struct cli_cmd mtsmp_cmd[] = {
-	CMDENTRY(out, mtsmp_out, "", ""),
-	CMDENTRY(in, mtsmp_in, "", ""),
+	CMDENTRY(show, mtsmp_show, "", ""),
 	CMDENTRY(clean, mtsmp_clean, "", ""),
 	CMDENTRY(c, mtsmp_clean, "", ""),
 };
@@ -102,6 +272,9 @@ static int do_mtsmp(int argc, char *argv[])
 	argc--;
 	argv++;
 
+	if (argc == 0)
+		return mtsmp_show(argc, argv);
+
 	cmd = cli_find_cmd(argv[0], mtsmp_cmd, ARRAY_SIZE(mtsmp_cmd));
 	if (cmd == NULL)
 		return CMD_RET_USAGE;
@@ -110,8 +283,7 @@ static int do_mtsmp(int argc, char *argv[])
 }
 
 CMD(mtsmp, do_mtsmp,
-	"timestamp for out/in path",
-	"mtsmp out" OR
-	"mtsmp in" OR
-	"mtsmp <clean|c>" OR
+	"per packet stage latency",
+	"mtsmp [show]" OR
+	"mtsmp <clean|c>"
 );
@@ -0,0 +1,260 @@
+/*
+ * Copyright 2024-2024 Senscomm Semiconductor Co., Ltd.	All rights reserved.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * PC sampling profiler.
+ *
+ * A channel of an ATCPIT timer interrupts every 'period' usec and the
+ * handler records the interrupted PC (mepc) and the current task into
+ * a buffer until it is full. 'prof dump' writes the samples as text,
+ * to the console or to a file, and scripts/prof2sym.py symbolizes them
+ * against the ELF into flat and folded (task;function) profiles.
+ *
+ * Code running with interrupts disabled is not sampled until it enables
+ * them again, so its time shows up on the instruction that does that.
+ */
+
+#include <FreeRTOS/FreeRTOS.h>
+#include <FreeRTOS/task.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <getopt.h>
+
+#include <hal/kernel.h>
+#include <hal/device.h>
+#include <hal/timer.h>
+#include <hal/kmem.h>
+#include <hal/ndsv5/core_v5.h>
+#include <cli.h>
+
+#define str(s)		#s
+#define xstr(s)		str(s)
+
+struct prof_sample {
+	u32 pc;
+	void *task;
+};
+
+static struct {
+	struct device *timer;
+	struct prof_sample *buf;
+	u32 max;
+	volatile u32 n;
+	u32 period;
+	volatile bool running;
+} prof;
+
+extern void * volatile pxCurrentTCB;
+
+static int prof_tick(enum timer_event_type type, void *ctx)
+{
+	struct prof_sample *s;
+
+	if (!prof.running)
+		return 0;
+
+	if (prof.n == prof.max) {
+		timer_stop(prof.timer, CONFIG_PROF_TIMER_CH);
+		prof.running = false;
+		return 0;
+	}
+
+	s = &prof.buf[prof.n++];
+	s->pc = read_csr(NDS_MEPC);
+	s->task = pxCurrentTCB;
+
+	return 0;
+}
+
+static int prof_start(int argc, char *argv[])
+{
+	u32 max = CONFIG_PROF_SAMPLES, period = CONFIG_PROF_PERIOD;
+	int opt, ret;
+
+	if (prof.running) {
+		printf("already running\n");
+		return CMD_RET_FAILURE;
+	}
+
+	optind = 1;
+	while ((opt = getopt(argc, argv, "n:p:")) != -1) {
+		switch (opt) {
+		case 'n':
+			max = atoi(optarg);
+			break;
+		case 'p':
+			period = atoi(optarg);
+			break;
+		default:
+			return CMD_RET_USAGE;
+		}
+	}
+	if (max == 0 || period == 0)
+		return CMD_RET_USAGE;
+
+	if (prof.timer == NULL) {
+		prof.timer = device_get_by_name("timer." xstr(CONFIG_PROF_TIMER_ID));
+		if (prof.timer == NULL) {
+			printf("no timer\n");
+			return CMD_RET_FAILURE;
+		}
+	}
+
+	if (prof.buf == NULL || prof.max != max) {
+		kfree(prof.buf);
+		prof.buf = kmalloc(max * sizeof(*prof.buf));
+		if (prof.buf == NULL) {
+			prof.max = 0;
+			printf("no memory for %u samples\n", max);
+			return CMD_RET_FAILURE;
+		}
+		prof.max = max;
+	}
+
+	ret = timer_setup(prof.timer, CONFIG_PROF_TIMER_CH,
+			  HAL_TIMER_PERIODIC | HAL_TIMER_IRQ, period,
+			  prof_tick, NULL);
+	if (ret) {
+		printf("timer setup failed (%d)\n", ret);
+		return CMD_RET_FAILURE;
+	}
+
+	prof.n = 0;
+	prof.period = period;
+	prof.running = true;
+	timer_start(prof.timer, CONFIG_PROF_TIMER_CH);
+
+	return CMD_RET_SUCCESS;
+}
+
+static int prof_stop(int argc, char *argv[])
+{
+	if (prof.running) {
+		timer_stop(prof.timer, CONFIG_PROF_TIMER_CH);
+		prof.running = false;
+	}
+
+	return CMD_RET_SUCCESS;
+}
+
+static int prof_stat(int argc, char *argv[])
+{
+	printf("%s, %u/%u samples every %u us\n",
+	       prof.running ? "running" : "stopped",
+	       prof.n, prof.max, prof.period);
+
+	return CMD_RET_SUCCESS;
+}
+
+/* To the console if @fd < 0. */
+static void prof_emit(int fd, const char *fmt, ...)
+{
+	char line[64];
+	va_list ap;
+	int len;
+
+	va_start(ap, fmt);
+	len = vsnprintf(line, sizeof(line), fmt, ap);
+	va_end(ap);
+
+	len = min(len, (int)sizeof(line) - 1);
+	if (fd < 0)
+		printf("%s", line);
+	else
+		write(fd, line, len);
+}
+
+/*
+ * Text dump, one record per line:
+ *
+ *   P <period us>
+ *   T <task> <pid> <name>	live tasks
+ *   S <pc> <task>		samples, oldest first
+ */
+static int prof_dump(int argc, char *argv[])
+{
+	TaskStatus_t *tasks;
+	int fd = -1, nr_task;
+	u32 i;
+
+	if (prof.running) {
+		printf("stop first\n");
+		return CMD_RET_FAILURE;
+	}
+
+	if (argc > 1) {
+		fd = open(argv[1], O_RDWR | O_CREAT | O_TRUNC, 0);
+		if (fd < 0) {
+			printf("%s: %s\n", argv[1], strerror(errno));
+			return CMD_RET_FAILURE;
+		}
+	}
+
+	prof_emit(fd, "P %u\n", prof.period);
+
+	nr_task = uxTaskGetNumberOfTasks();
+	tasks = kmalloc(nr_task * sizeof(*tasks));
+	if (tasks) {
+		nr_task = uxTaskGetSystemState(tasks, nr_task, NULL);
+		for (i = 0; i < nr_task; i++)
+			prof_emit(fd, "T %p %u %s\n", tasks[i].xHandle,
+				  (unsigned)tasks[i].xTaskNumber,
+				  tasks[i].pcTaskName);
+		kfree(tasks);
+	}
+
+	for (i = 0; i < prof.n; i++)
+		prof_emit(fd, "S %x %p\n", prof.buf[i].pc, prof.buf[i].task);
+
+	if (fd >= 0)
+		close(fd);
+
+	return CMD_RET_SUCCESS;
+}
+
+static const struct cli_cmd prof_cmd[] = {
+	CMDENTRY(start, prof_start, "", ""),
+	CMDENTRY(stop, prof_stop, "", ""),
+	CMDENTRY(stat, prof_stat, "", ""),
+	CMDENTRY(dump, prof_dump, "", ""),
+};
+
+static int do_prof(int argc, char *argv[])
+{
+	const struct cli_cmd *cmd;
+
+	argc--;
+	argv++;
+
+	if (argc == 0)
+		return CMD_RET_USAGE;
+
+	cmd = cli_find_cmd(argv[0], prof_cmd, ARRAY_SIZE(prof_cmd));
+	if (cmd == NULL)
+		return CMD_RET_USAGE;
+
+	return cmd->handler(argc, argv);
+}
+
+CMD(prof, do_prof,
+	"PC sampling profiler",
+	"prof start [-n samples] [-p period_us]" OR
+	"prof stop" OR
+	"prof stat" OR
+	"prof dump [file]"
+);
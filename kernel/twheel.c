@@ -0,0 +1,567 @@
+/*
+ * Copyright 2024-2024 Senscomm Semiconductor Co., Ltd.	All rights reserved.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Hierarchical timer wheel.
+ *
+ * Time is counted in wheel ticks of CONFIG_TWHEEL_TICK_US. There are
+ * TW_LEVELS levels of TW_SIZE slots; level n holds the timers due in
+ * less than TW_SIZE^(n+1) ticks, in the slot picked by the n-th group
+ * of TW_BITS bits of their expiry. When level 0 comes round to slot 0,
+ * the next slot of level 1 is cascaded down into level 0, and so on
+ * upwards. Timers further out than the wheel spans wait in the last
+ * slot of the top level and go round again.
+ *
+ * Nothing runs periodically. A single system timer entry is armed at
+ * the earliest expiry and its interrupt catches the wheel up with the
+ * system timer counter, skipping over ticks with nothing to do by means
+ * of the per level bitmaps of occupied slots. Being an ordinary
+ * SYSTIMER_TYPE_WAKEUP_FULL entry, the next expiry is also what the
+ * power management sees when it decides how long to sleep.
+ *
+ * Arming and cancelling do not rearm the system timer unless the timer
+ * becomes the earliest one, so both are O(1); a cancelled timer may
+ * cost one spurious interrupt at most.
+ */
+
+#include <FreeRTOS/FreeRTOS.h>
+#include <FreeRTOS/task.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include <sys/queue.h>
+
+#include <hal/kernel.h>
+#include <hal/init.h>
+#include <hal/irq.h>
+#include <hal/device.h>
+#include <hal/systimer.h>
+
+#include <cli.h>
+
+#include "twheel.h"
+
+#define TW_BITS		6
+#define TW_SIZE		(1 << TW_BITS)
+#define TW_MASK		(TW_SIZE - 1)
+#define TW_LEVELS	4
+#define TW_SHIFT(l)	(TW_BITS * (l))
+#define TW_SPAN(l)	(1UL << TW_SHIFT(l))
+#define TW_MAX_DELTA	(TW_SPAN(TW_LEVELS) - 1)
+
+/* system timer counts per wheel tick */
+#define TW_TPJ		SYSTIMER_USECS_TO_TICKS(CONFIG_TWHEEL_TICK_US)
+
+/* Arm the system timer no further out than this (about 53 sec.). */
+#define TW_MAX_ARM	(0x40000000 / TW_TPJ)
+
+/* Keep expiries well within the range of signed comparison. */
+#define TW_MAX_TICKS	0x3fffffffUL
+
+/* struct twheel_timer::state */
+enum {
+	TW_IDLE,
+	TW_ARMED,	/* on the wheel */
+	TW_EXPIRED,	/* due, waiting for its callback */
+};
+
+static struct {
+	struct list_head slot[TW_LEVELS][TW_SIZE];
+	uint64_t occupied[TW_LEVELS];
+	struct list_head expired;
+	uint32_t clk;		/* next tick to process */
+	uint32_t base;		/* system timer count at the start of tick clk */
+	uint32_t count;		/* timers on the wheel */
+	struct device *dev;
+	struct systimer hw;
+	uint32_t hw_tick;	/* tick the system timer is armed for */
+	bool in_isr;
+	TaskHandle_t task;
+	struct {
+		uint32_t started;
+		uint32_t expired;
+		uint32_t cascaded;
+		uint32_t wakeups;
+		uint32_t max_batch;
+	} stats;
+} tw;
+
+static inline bool tw_before(uint32_t a, uint32_t b)
+{
+	return (int32_t)(a - b) < 0;
+}
+
+/*
+ * The tick the system timer counter is in. Having processed a tick, the
+ * wheel is already at the start of the next one, ahead of the counter,
+ * so elapsed time is signed here.
+ */
+static uint32_t tw_now(void)
+{
+	int32_t elapsed = systimer_get_counter(tw.dev) - tw.base;
+
+	if (elapsed < 0)
+		return tw.clk - 1 - (uint32_t)(-(elapsed + 1)) / TW_TPJ;
+
+	return tw.clk + (uint32_t)elapsed / TW_TPJ;
+}
+
+static void tw_advance(uint32_t tick)
+{
+	tw.base += (tick - tw.clk) * TW_TPJ;
+	tw.clk = tick;
+}
+
+static void tw_enqueue(struct twheel_timer *t)
+{
+	uint32_t delta = t->expires - tw.clk;
+	uint32_t exp = t->expires;
+	int lvl, idx;
+
+	if ((int32_t)delta < 0) {
+		delta = 0;
+		exp = tw.clk;
+	} else if (delta > TW_MAX_DELTA) {
+		/* It will be looked at again when this slot cascades. */
+		delta = TW_MAX_DELTA;
+		exp = tw.clk + delta;
+	}
+
+	for (lvl = 0; lvl < TW_LEVELS - 1; lvl++)
+		if (delta < TW_SPAN(lvl + 1))
+			break;
+
+	idx = (exp >> TW_SHIFT(lvl)) & TW_MASK;
+	list_add_tail(&t->list, &tw.slot[lvl][idx]);
+	tw.occupied[lvl] |= 1ULL << idx;
+	tw.count++;
+	t->state = TW_ARMED;
+}
+
+static void tw_unlink(struct twheel_timer *t)
+{
+	struct list_head *head = t->list.next;
+	int n;
+
+	if (head == t->list.prev) {
+		/* The last one in its slot, of which head is the list. */
+		n = head - &tw.slot[0][0];
+		tw.occupied[n / TW_SIZE] &= ~(1ULL << (n % TW_SIZE));
+	}
+	list_del(&t->list);
+	tw.count--;
+}
+
+static void tw_detach(struct twheel_timer *t)
+{
+	if (t->state == TW_ARMED)
+		tw_unlink(t);
+	else if (t->state == TW_EXPIRED)
+		list_del(&t->list);
+
+	t->state = TW_IDLE;
+}
+
+/*
+ * The first occupied slot of level @lvl from the current position on,
+ * and the tick at which it is due (level 0) or cascades (others).
+ */
+static int tw_first(int lvl, uint32_t *tick)
+{
+	uint32_t c0 = (tw.clk + TW_SPAN(lvl) - 1) & ~(TW_SPAN(lvl) - 1);
+	int cur = (c0 >> TW_SHIFT(lvl)) & TW_MASK;
+	uint64_t occ = tw.occupied[lvl];
+	int d;
+
+	if (!occ)
+		return -1;
+
+	if (cur)
+		occ = (occ >> cur) | (occ << (TW_SIZE - cur));
+	d = __builtin_ctzll(occ);
+	*tick = c0 + (d << TW_SHIFT(lvl));
+
+	return (cur + d) & TW_MASK;
+}
+
+/* The next tick at which something has to be done. */
+static bool tw_next_event(uint32_t *tick)
+{
+	uint32_t t;
+	bool found = false;
+	int lvl;
+
+	for (lvl = 0; lvl < TW_LEVELS; lvl++) {
+		if (tw_first(lvl, &t) < 0)
+			continue;
+		if (!found || tw_before(t, *tick))
+			*tick = t;
+		found = true;
+	}
+
+	return found;
+}
+
+/* The earliest expiry of all. */
+static bool tw_deadline(uint32_t *tick)
+{
+	struct twheel_timer *t;
+	uint32_t first;
+	bool found = false;
+	int lvl, idx;
+
+	for (lvl = 0; lvl < TW_LEVELS; lvl++) {
+		idx = tw_first(lvl, &first);
+		if (idx < 0)
+			continue;
+		if (lvl == 0) {
+			*tick = first;
+			found = true;
+			continue;
+		}
+		list_for_each_entry(t, &tw.slot[lvl][idx], list) {
+			if (!found || tw_before(t->expires, *tick))
+				*tick = t->expires;
+			found = true;
+		}
+	}
+
+	return found;
+}
+
+static void tw_arm(uint32_t tick)
+{
+	uint32_t d = tick - tw.clk;
+
+	if ((int32_t)d < 0)
+		d = 0;
+	else if (d > TW_MAX_ARM)
+		d = TW_MAX_ARM;
+
+	if (tw.hw.enqueued)
+		systimer_stop(tw.dev, &tw.hw);
+	systimer_start_at(tw.dev, &tw.hw, tw.base + d * TW_TPJ);
+	tw.hw_tick = tw.clk + d;
+}
+
+/* A timer due at @tick is on the wheel; see if it is the earliest. */
+static void tw_kick(uint32_t tick)
+{
+	if (tw.in_isr)
+		return;
+
+	if (!tw.hw.enqueued || tw_before(tick, tw.hw_tick))
+		tw_arm(tick);
+}
+
+static int tw_cascade(int lvl)
+{
+	struct twheel_timer *t, *n;
+	struct list_head list;
+	int idx = (tw.clk >> TW_SHIFT(lvl)) & TW_MASK;
+
+	INIT_LIST_HEAD(&list);
+	list_splice_init(&tw.slot[lvl][idx], &list);
+	tw.occupied[lvl] &= ~(1ULL << idx);
+
+	list_for_each_entry_safe(t, n, &list, list) {
+		list_del(&t->list);
+		tw.count--;
+		tw_enqueue(t);
+		tw.stats.cascaded++;
+	}
+
+	return idx;
+}
+
+/* Process tick clk; returns the number of timers that expired. */
+static int tw_tick(bool *notify)
+{
+	struct twheel_timer *t;
+	struct list_head work;
+	int idx = tw.clk & TW_MASK;
+	int lvl, n = 0;
+
+	if (!idx)
+		for (lvl = 1; lvl < TW_LEVELS; lvl++)
+			if (tw_cascade(lvl))
+				break;
+
+	INIT_LIST_HEAD(&work);
+	list_splice_init(&tw.slot[0][idx], &work);
+	tw.occupied[0] &= ~(1ULL << idx);
+	list_for_each_entry(t, &work, list) {
+		tw.count--;
+		t->state = TW_EXPIRED;
+	}
+
+	tw_advance(tw.clk + 1);
+
+	/* Callbacks may start or stop any timer, those in work included. */
+	while (!list_empty(&work)) {
+		t = list_first_entry(&work, struct twheel_timer, list);
+		list_del(&t->list);
+		t->state = TW_IDLE;
+		n++;
+
+		if (!(t->flags & TWHEEL_ISR)) {
+			list_add_tail(&t->list, &tw.expired);
+			t->state = TW_EXPIRED;
+			*notify = true;
+			continue;
+		}
+
+		if (t->flags & TWHEEL_PERIODIC) {
+			t->expires += t->period;
+			tw_enqueue(t);
+		}
+		t->func(t->arg);
+	}
+
+	return n;
+}
+
+/* system timer interrupt, with interrupts disabled */
+static void tw_isr(void *arg)
+{
+	BaseType_t woken = pdFALSE;
+	bool notify = false;
+	uint32_t now, tick;
+	uint32_t batch = 0;
+
+	tw.in_isr = true;
+	tw.stats.wakeups++;
+
+	now = tw_now();
+	while (tw_next_event(&tick) && !tw_before(now, tick)) {
+		tw_advance(tick);
+		batch += tw_tick(&notify);
+	}
+	/* Nothing else is due up to now. */
+	if (tw_before(tw.clk, now + 1))
+		tw_advance(now + 1);
+
+	tw.in_isr = false;
+
+	tw.stats.expired += batch;
+	if (batch > tw.stats.max_batch)
+		tw.stats.max_batch = batch;
+
+	if (tw_deadline(&tick))
+		tw_arm(tick);
+
+	if (notify) {
+		vTaskNotifyGiveFromISR(tw.task, &woken);
+		portYIELD_FROM_ISR(woken);
+	}
+}
+
+static void twheel_task(void *arg)
+{
+	struct twheel_timer *t;
+	twheel_func_t func;
+	void *data;
+	unsigned long flags;
+
+	for (;;) {
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+		for (;;) {
+			local_irq_save(flags);
+			if (list_empty(&tw.expired)) {
+				local_irq_restore(flags);
+				break;
+			}
+			t = list_first_entry(&tw.expired, struct twheel_timer, list);
+			list_del(&t->list);
+			t->state = TW_IDLE;
+			if (t->flags & TWHEEL_PERIODIC) {
+				/* from when it was due, so as not to drift */
+				t->expires += t->period;
+				tw_enqueue(t);
+				tw_kick(t->expires);
+			}
+			func = t->func;
+			data = t->arg;
+			local_irq_restore(flags);
+
+			func(data);
+		}
+	}
+}
+
+static int tw_attach(void)
+{
+	struct device *dev;
+	unsigned long flags;
+
+	dev = device_get_by_name("systimer");
+	if (!dev)
+		return -ENODEV;
+
+	local_irq_save(flags);
+	if (!tw.dev) {
+		systimer_set_cmp_cb(dev, &tw.hw, SYSTIMER_TYPE_WAKEUP_FULL,
+				    tw_isr, NULL);
+		tw.base = systimer_get_counter(dev);
+		tw.dev = dev;
+	}
+	local_irq_restore(flags);
+
+	return 0;
+}
+
+void twheel_timer_init(struct twheel_timer *t, twheel_func_t func, void *arg,
+		       unsigned flags)
+{
+	memset(t, 0, sizeof(*t));
+	t->func = func;
+	t->arg = arg;
+	t->flags = flags;
+	t->state = TW_IDLE;
+	INIT_LIST_HEAD(&t->list);
+}
+
+/*
+ * (Re)start @t to expire in @ms, or every @ms if it is periodic.
+ * It never expires early, and at most one wheel tick late.
+ */
+int twheel_timer_start(struct twheel_timer *t, uint32_t ms)
+{
+	unsigned long flags;
+	uint64_t ticks;
+
+	if (!t->func)
+		return -EINVAL;
+
+	if (!tw.dev && tw_attach())
+		return -ENODEV;
+
+	ticks = ((uint64_t)ms * 1000 + CONFIG_TWHEEL_TICK_US - 1)
+		/ CONFIG_TWHEEL_TICK_US;
+	if (ticks > TW_MAX_TICKS)
+		ticks = TW_MAX_TICKS;
+
+	local_irq_save(flags);
+
+	tw_detach(t);
+
+	if (!tw.count && !tw.in_isr) {
+		/*
+		 * The wheel has been idle, for long enough that base may
+		 * have fallen out of range; have tick clk start right now.
+		 */
+		tw.base = systimer_get_counter(tw.dev) + 1;
+	}
+
+	t->expires = tw_now() + ticks + 1;
+	t->period = (t->flags & TWHEEL_PERIODIC) ? (ticks ? ticks : 1) : 0;
+	tw_enqueue(t);
+	tw.stats.started++;
+
+	tw_kick(t->expires);
+
+	local_irq_restore(flags);
+
+	return 0;
+}
+
+int twheel_timer_stop(struct twheel_timer *t)
+{
+	unsigned long flags;
+
+	local_irq_save(flags);
+	tw_detach(t);
+	local_irq_restore(flags);
+
+	return 0;
+}
+
+bool twheel_timer_is_running(struct twheel_timer *t)
+{
+	return t->state != TW_IDLE;
+}
+
+static int twheel_init(void)
+{
+	int i, j;
+
+	for (i = 0; i < TW_LEVELS; i++)
+		for (j = 0; j < TW_SIZE; j++)
+			INIT_LIST_HEAD(&tw.slot[i][j]);
+	INIT_LIST_HEAD(&tw.expired);
+
+	if (xTaskCreate(twheel_task, "twheel", configTIMER_TASK_STACK_DEPTH,
+			NULL, configTIMER_TASK_PRIORITY, &tw.task) != pdPASS)
+		return -ENOMEM;
+
+	return 0;
+}
+__initcall__(subsystem, twheel_init);
+
+#ifdef CONFIG_CMD_TWHEEL
+
+static int do_twheel(int argc, char *argv[])
+{
+	unsigned long flags;
+	uint32_t clk, tick, count;
+	uint64_t occupied[TW_LEVELS];
+	bool armed;
+	int i;
+
+	if (argc > 2)
+		return CMD_RET_USAGE;
+
+	if (argc == 2) {
+		if (strcmp(argv[1], "reset"))
+			return CMD_RET_USAGE;
+		memset(&tw.stats, 0, sizeof(tw.stats));
+		return CMD_RET_SUCCESS;
+	}
+
+	local_irq_save(flags);
+	clk = tw.clk;
+	count = tw.count;
+	memcpy(occupied, tw.occupied, sizeof(occupied));
+	armed = tw.hw.enqueued;
+	tick = tw.hw_tick;
+	local_irq_restore(flags);
+
+	printf("tick     : %d us\n", CONFIG_TWHEEL_TICK_US);
+	printf("clk      : %u\n", (unsigned)clk);
+	printf("timers   : %u\n", (unsigned)count);
+	if (armed)
+		printf("next     : %u (+%d)\n", (unsigned)tick, (int)(tick - clk));
+	else
+		printf("next     : -\n");
+	printf("slots    :");
+	for (i = 0; i < TW_LEVELS; i++)
+		printf(" %d", __builtin_popcountll(occupied[i]));
+	printf("\n");
+	printf("started  : %u\n", (unsigned)tw.stats.started);
+	printf("expired  : %u\n", (unsigned)tw.stats.expired);
+	printf("cascaded : %u\n", (unsigned)tw.stats.cascaded);
+	printf("wakeups  : %u\n", (unsigned)tw.stats.wakeups);
+	printf("max batch: %u\n", (unsigned)tw.stats.max_batch);
+
+	return CMD_RET_SUCCESS;
+}
+
+CMD(twheel, do_twheel,
+	"show timer wheel status",
+	"twheel" OR
+	"twheel reset"
+);
+
+#endif
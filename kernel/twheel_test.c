@@ -0,0 +1,143 @@
+/*
+ * Copyright 2024-2024 Senscomm Semiconductor Co., Ltd.	All rights reserved.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Timer wheel tests, run with 'twt'.
+ *
+ * Each case starts a timer from a different context and checks, against
+ * the system timer counter, that it expires neither early nor later
+ * than one wheel tick after it was due.
+ */
+
+#include <FreeRTOS/FreeRTOS.h>
+#include <FreeRTOS/semphr.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <sys/queue.h>
+
+#include <hal/kernel.h>
+#include <hal/device.h>
+#include <hal/systimer.h>
+
+#include <cli.h>
+
+#include "twheel.h"
+
+#define TWT_FIRST_MS		3
+#define TWT_SECOND_MS		5
+#define TWT_FAR_MS		10000
+
+/* interrupt latency allowed on top of one wheel tick */
+#define TWT_SLACK_US		100
+
+static struct {
+	struct device *dev;
+	SemaphoreHandle_t done;
+	struct twheel_timer first;
+	struct twheel_timer second;
+	struct twheel_timer far;
+	uint32_t started;
+	uint32_t fired;
+} twt;
+
+static void twt_second(void *arg)
+{
+	BaseType_t woken = pdFALSE;
+
+	twt.fired = systimer_get_counter(twt.dev);
+	xSemaphoreGiveFromISR(twt.done, &woken);
+	portYIELD_FROM_ISR(woken);
+}
+
+/* only there to keep the wheel busy */
+static void twt_nop(void *arg)
+{
+}
+
+/* Start the second timer right after the first one has expired. */
+static void twt_first(void *arg)
+{
+	twt.started = systimer_get_counter(twt.dev);
+	twheel_timer_start(&twt.second, TWT_SECOND_MS);
+}
+
+static int twt_run(const char *name, unsigned flags, bool others)
+{
+	uint32_t us, min, max;
+	int ret = 0;
+
+	twheel_timer_init(&twt.first, twt_first, NULL, flags);
+	twheel_timer_init(&twt.second, twt_second, NULL, TWHEEL_ISR);
+	twheel_timer_init(&twt.far, twt_nop, NULL, 0);
+
+	if (others)
+		twheel_timer_start(&twt.far, TWT_FAR_MS);
+
+	if (flags & TWHEEL_ISR || others) {
+		twheel_timer_start(&twt.first, TWT_FIRST_MS);
+	} else {
+		/* from here, with nothing else on the wheel */
+		twt_first(NULL);
+	}
+
+	if (xSemaphoreTake(twt.done, pdMS_TO_TICKS(TWT_FAR_MS / 2)) != pdTRUE) {
+		printf("%-24s: FAIL (no expiry)\n", name);
+		ret = -1;
+		goto out;
+	}
+
+	us = SYSTIMER_TICKS_TO_USECS(twt.fired - twt.started);
+	min = TWT_SECOND_MS * 1000;
+	max = min + CONFIG_TWHEEL_TICK_US + TWT_SLACK_US;
+	if (us < min || us > max)
+		ret = -1;
+
+	printf("%-24s: %s (%u us, expected %u..%u)\n", name,
+	       ret ? "FAIL" : "PASS", (unsigned)us, (unsigned)min,
+	       (unsigned)max);
+
+ out:
+	twheel_timer_stop(&twt.first);
+	twheel_timer_stop(&twt.second);
+	twheel_timer_stop(&twt.far);
+
+	return ret;
+}
+
+static int do_twheel_test(int argc, char *argv[])
+{
+	int fail = 0;
+
+	twt.dev = device_get_by_name("systimer");
+	if (!twt.dev)
+		return CMD_RET_FAILURE;
+
+	if (!twt.done) {
+		twt.done = xSemaphoreCreateBinary();
+		if (!twt.done)
+			return CMD_RET_FAILURE;
+	}
+
+	fail |= twt_run("idle wheel", 0, false);
+	fail |= twt_run("from isr callback", TWHEEL_ISR, false);
+	fail |= twt_run("from isr, others armed", TWHEEL_ISR, true);
+	fail |= twt_run("from task, others armed", 0, true);
+
+	return fail ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}
+
+CMD(twt, do_twheel_test,
+	"run timer wheel tests",
+	"twt"
+);
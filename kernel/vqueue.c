@@ -20,10 +20,14 @@
 #include <hal/init.h>
 #include <hal/kernel.h>
 
+#include <FreeRTOS/FreeRTOS.h>
+#include <FreeRTOS/task.h>
+#include <FreeRTOS/semphr.h>
+
 #include "sys/ioctl.h"
 #include "vfs.h"
-#include "mmap.h"
 #include "cmsis_os.h"
+#include "vqueue.h"
 
 #define IOCTL_VQUEUE_PUT            (1)
 #define IOCTL_VQUEUE_GET            (2)
@@ -54,9 +58,30 @@ struct vqueue_query_arg {
     uint32_t val;
 };
 
+/*
+ * Messages live in a ring of @count slots of @size bytes, guarded by
+ * @lock. A binary semaphore on either side stands for "not empty" and
+ * "not full": it is given once per put (get) that takes the ring out of
+ * the empty (full) state, however many messages that moved, so a
+ * batch wakes a reader or poll() once. Whoever is woken passes it on
+ * if there is still something left for the next one.
+ *
+ * A zero-copy queue carries struct vqueue_msg, i.e., only a pointer
+ * and a length whose ownership goes with the message; the payloads can
+ * come from a mem_slab that belongs to the queue.
+ */
 struct vqueue {
     struct file file;
-    osMessageQueueId_t qid;
+    char *buf;
+    uint32_t count;
+    uint32_t size;
+    uint32_t head;
+    uint32_t used;
+    SemaphoreHandle_t lock;
+    SemaphoreHandle_t rd_wait;
+    SemaphoreHandle_t wr_wait;
+    bool zc;
+    struct mem_slab *slab;
 };
 
 static struct fops vqueue_fops;
@@ -87,11 +112,30 @@ static struct vqueue *vqueue_alloc(int count, int size)
     struct vqueue *vq;
     struct file *file;
 
+    if (count <= 0 || size <= 0)
+        return NULL;
+
     /* Allocate a vqueue object and initialize it */
     if ((vq = zalloc(sizeof(*vq))) == NULL)
         return NULL;
 
-    vq->qid = osMessageQueueNew(count, size, NULL);
+    vq->buf = malloc(count * size);
+    vq->count = count;
+    vq->size = size;
+    vq->lock = xSemaphoreCreateMutex();
+    vq->rd_wait = xSemaphoreCreateBinary();
+    vq->wr_wait = xSemaphoreCreateBinary();
+    if (!vq->buf || !vq->lock || !vq->rd_wait || !vq->wr_wait) {
+        if (vq->lock)
+            vSemaphoreDelete(vq->lock);
+        if (vq->rd_wait)
+            vSemaphoreDelete(vq->rd_wait);
+        if (vq->wr_wait)
+            vSemaphoreDelete(vq->wr_wait);
+        free(vq->buf);
+        free(vq);
+        return NULL;
+    }
 
     file = &vq->file;
     vfs_init_file(file);
@@ -102,14 +146,20 @@ static struct vqueue *vqueue_alloc(int count, int size)
     return vq;
 }
 
+static void vq_drop(struct vqueue *vq);
+
 /**
  * vqueue_free() - free a struct vqueue object
  * @vq: vqueue to free
  */
 static void vqueue_free(struct vqueue* vq)
 {
-    osMessageQueueDelete(vq->qid);
-    vq->qid = NULL;
+    vq_drop(vq);
+    vSemaphoreDelete(vq->lock);
+    vSemaphoreDelete(vq->rd_wait);
+    vSemaphoreDelete(vq->wr_wait);
+    free(vq->buf);
+    vq->buf = NULL;
     vfs_destroy_file(&vq->file);
     free(vq);
 }
@@ -130,6 +180,127 @@ static struct vqueue *fd_to_vqueue(int fd)
     return vq;
 }
 
+/*
+ * Ring operations, all with @lock held.
+ * Each moves as many of @n messages as it can, in at most two copies.
+ */
+
+static int vq_copy_in(struct vqueue *vq, const char *msgs, int n)
+{
+    uint32_t tail, k;
+
+    n = min((uint32_t)n, vq->count - vq->used);
+    tail = (vq->head + vq->used) % vq->count;
+    k = min((uint32_t)n, vq->count - tail);
+
+    memcpy(vq->buf + tail * vq->size, msgs, k * vq->size);
+    memcpy(vq->buf, msgs + k * vq->size, (n - k) * vq->size);
+    vq->used += n;
+
+    return n;
+}
+
+static int vq_copy_out(struct vqueue *vq, char *msgs, int n)
+{
+    uint32_t k;
+
+    n = min((uint32_t)n, vq->used);
+    k = min((uint32_t)n, vq->count - vq->head);
+
+    memcpy(msgs, vq->buf + vq->head * vq->size, k * vq->size);
+    memcpy(msgs + k * vq->size, vq->buf, (n - k) * vq->size);
+    vq->head = (vq->head + n) % vq->count;
+    vq->used -= n;
+
+    return n;
+}
+
+/* Return the payloads still queued to the slab they came from. */
+static void vq_drop(struct vqueue *vq)
+{
+#ifdef CONFIG_SUPPORT_MEM_SLAB
+    struct vqueue_msg msg;
+
+    while (vq->zc && vq->slab && vq->used) {
+        vq_copy_out(vq, (char *)&msg, 1);
+        if (msg.ptr)
+            mem_slab_free(vq->slab, msg.ptr);
+    }
+#endif
+    vq->head = 0;
+    vq->used = 0;
+}
+
+/*
+ * Wait on @sem for what is left of @timeout (ticks) since @start.
+ * Returns false if there is no time left.
+ */
+static bool vq_wait(SemaphoreHandle_t sem, TickType_t start, uint32_t timeout)
+{
+    TickType_t elapsed;
+
+    if (timeout == 0)
+        return false;
+
+    if (timeout == osWaitForever)
+        return xSemaphoreTake(sem, portMAX_DELAY) == pdTRUE;
+
+    elapsed = xTaskGetTickCount() - start;
+    if (elapsed >= timeout)
+        return false;
+
+    xSemaphoreTake(sem, timeout - elapsed);
+    return true;
+}
+
+/*
+ * vq_xfer() - move up to @n messages in or out of the ring, waiting up to
+ * @timeout ticks in total for room, or for the first message.
+ * Returns the number of messages moved.
+ */
+static int vq_xfer(struct vqueue *vq, void *msgs, int n, uint32_t timeout,
+        bool in)
+{
+    SemaphoreHandle_t mine = in ? vq->wr_wait : vq->rd_wait;
+    SemaphoreHandle_t peer = in ? vq->rd_wait : vq->wr_wait;
+    TickType_t start = xTaskGetTickCount();
+    char *p = msgs;
+    int done = 0, k;
+    bool wake, more, waited = false;
+
+    while (done < n) {
+        xSemaphoreTake(vq->lock, portMAX_DELAY);
+        if (in) {
+            k = vq_copy_in(vq, p + done * vq->size, n - done);
+            wake = k && vq->used == k;
+            more = vq->used < vq->count;
+        } else {
+            k = vq_copy_out(vq, p + done * vq->size, n - done);
+            wake = k && vq->used + k == vq->count;
+            more = vq->used > 0;
+        }
+        xSemaphoreGive(vq->lock);
+
+        if (wake)
+            xSemaphoreGive(peer);
+
+        done += k;
+        /* A reader takes whatever there is once there is something. */
+        if (done == n || (!in && done)) {
+            /* Leave the rest to the next one in line. */
+            if (more && waited)
+                xSemaphoreGive(mine);
+            break;
+        }
+
+        if (!vq_wait(mine, start, timeout))
+            break;
+        waited = true;
+    }
+
+    return done;
+}
+
 /*
  * vqueue file operations
  */
@@ -151,16 +322,18 @@ static int vqueue_ioctl(struct file *file, unsigned int cmd, void *argp)
     switch (cmd) {
         case IOCTL_VQUEUE_PUT: {
                                    struct vqueue_put_arg *put_arg = argp;
-                                   if (osMessageQueuePut(vq->qid, put_arg->msg_ptr, put_arg->msg_prio,
-                                               put_arg->timeout)) {
+                                   if (vq_xfer(vq, (void *)put_arg->msg_ptr, 1,
+                                               put_arg->timeout, true) != 1) {
                                        ret =  -EINVAL;
                                    }
                                    break;
                                }
         case IOCTL_VQUEUE_GET: {
                                    struct vqueue_get_arg *get_arg = argp;
-                                   if (osMessageQueueGet(vq->qid, get_arg->msg_ptr, &get_arg->msg_prio,
-                                               get_arg->timeout)) {
+                                   /* There is only one priority level. */
+                                   get_arg->msg_prio = 0;
+                                   if (vq_xfer(vq, get_arg->msg_ptr, 1,
+                                               get_arg->timeout, false) != 1) {
                                        ret = -ENOMEM;
                                    }
                                    break;
@@ -168,30 +341,32 @@ static int vqueue_ioctl(struct file *file, unsigned int cmd, void *argp)
         case IOCTL_VQUEUE_QUERY: {
                                      struct vqueue_query_arg *query_arg = argp;
                                      enum vqueue_query_item item = query_arg->item;
-#if 0
+
                                      if (item == VQUEUE_CAPACITY) {
-                                         query_arg->val = osMessageQueueGetCapacity(vq->qid);
+                                         query_arg->val = vq->count;
                                      } else if (item == VQUEUE_MSGSIZE) {
-                                         query_arg->val = osMessageQueueGetMsgSize(vq->qid);
-                                     } else
-#endif
-                                         if (item == VQUEUE_COUNT) {
-                                             query_arg->val = osMessageQueueGetCount(vq->qid);
-                                         } else if (item == VQUEUE_SPACE) {
-                                             query_arg->val = osMessageQueueGetSpace(vq->qid);
-                                         } else {
-                                             ret = -EINVAL;
-                                         }
+                                         query_arg->val = vq->size;
+                                     } else if (item == VQUEUE_COUNT) {
+                                         query_arg->val = vq->used;
+                                     } else if (item == VQUEUE_SPACE) {
+                                         query_arg->val = vq->count - vq->used;
+                                     } else {
+                                         ret = -EINVAL;
+                                     }
                                      break;
                                  }
-#if 0
         case IOCTL_VQUEUE_RESET: {
-                                     if (osMessageQueueReset(vq->qid)) {
-                                         ret = -EINVAL;
+                                     bool was_full;
+
+                                     xSemaphoreTake(vq->lock, portMAX_DELAY);
+                                     was_full = vq->used == vq->count;
+                                     vq_drop(vq);
+                                     xSemaphoreGive(vq->lock);
+                                     if (was_full) {
+                                         xSemaphoreGive(vq->wr_wait);
                                      }
                                      break;
                                  }
-#endif
         default:
                                  break;
     }
@@ -208,11 +383,16 @@ unsigned vqueue_poll(struct file *file, struct poll_table *pt, struct pollfd *pf
     assert((pfd->events & POLLOUT) == 0);
     assert((pfd->events & POLLIN) != 0);
 
+    /*
+     * A stale token would keep the semaphore from being added to the
+     * queue set, and the level is checked below anyway.
+     */
     if (pfd->events & POLLIN) {
-        poll_add_wait(file, vq->qid, pt);
+        xSemaphoreTake(vq->rd_wait, 0);
+        poll_add_wait(file, vq->rd_wait, pt);
     }
 
-    mask |= osMessageQueueGetCount(vq->qid) ? POLLIN : 0;
+    mask |= vq->used ? POLLIN : 0;
 
     return mask;
 }
@@ -266,6 +446,32 @@ error:
     return ret;
 }
 
+/**
+ * vqueue_zc() - create a zero-copy vqueue
+ * @count: maximum number of messages to hold
+ * @slab: slab for the payloads, or NULL if the caller manages them
+ *
+ * Messages are struct vqueue_msg, and whoever gets one owns its payload.
+ * Payloads from @slab still queued when the vqueue is closed or reset
+ * are freed back to it; any others are the caller's to drain.
+ */
+
+int vqueue_zc(int count, struct mem_slab *slab)
+{
+    struct vqueue *vq;
+    int fd;
+
+    fd = vqueue(count, sizeof(struct vqueue_msg));
+    if (fd < 0)
+        return fd;
+
+    vq = fd_to_vqueue(fd);
+    vq->zc = true;
+    vq->slab = slab;
+
+    return fd;
+}
+
 /**
  * vqueue_put() - put a message into vqueue
  */
@@ -273,18 +479,13 @@ error:
 int vqueue_put(int fd, const void *msg_ptr, uint8_t msg_prio, uint32_t timeout)
 {
     struct vqueue *vq = fd_to_vqueue(fd);
-    struct vqueue_put_arg arg;
     int ret;
 
     assert(vq);
 
     vq_get(vq);
 
-    arg.msg_ptr = msg_ptr;
-    arg.msg_prio = msg_prio;
-    arg.timeout = timeout;
-
-    ret = ioctl(fd, IOCTL_VQUEUE_PUT, &arg);
+    ret = vq_xfer(vq, (void *)msg_ptr, 1, timeout, true) == 1 ? 0 : -EINVAL;
 
     vq_put(vq);
 
@@ -298,20 +499,16 @@ int vqueue_put(int fd, const void *msg_ptr, uint8_t msg_prio, uint32_t timeout)
 int vqueue_get(int fd, void *msg_ptr, uint8_t *msg_prio, uint32_t timeout)
 {
     struct vqueue *vq = fd_to_vqueue(fd);
-    struct vqueue_get_arg arg;
     int ret;
 
     assert(vq);
 
     vq_get(vq);
 
-    arg.msg_ptr = msg_ptr;
-    arg.timeout = timeout;
-
-    ret = ioctl(fd, IOCTL_VQUEUE_GET, &arg);
+    ret = vq_xfer(vq, msg_ptr, 1, timeout, false) == 1 ? 0 : -ENOMEM;
 
     if (msg_prio) {
-        *msg_prio = arg.msg_prio;
+        *msg_prio = 0;
     }
 
     vq_put(vq);
@@ -320,9 +517,130 @@ int vqueue_get(int fd, void *msg_ptr, uint8_t *msg_prio, uint32_t timeout)
 }
 
 /**
- * vqueue_capacity() - get capacity of vqueue
+ * vqueue_put_batch() - put up to @n messages into vqueue
+ * @msgs: array of @n messages
+ * @timeout: ticks to wait in total for room
+ *
+ * Returns the number of messages put, which is short of @n only if
+ * @timeout expired. Readers and poll() are woken once for all of them.
+ */
+
+int vqueue_put_batch(int fd, const void *msgs, int n, uint32_t timeout)
+{
+    struct vqueue *vq = fd_to_vqueue(fd);
+    int ret;
+
+    assert(vq);
+
+    vq_get(vq);
+
+    ret = vq_xfer(vq, (void *)msgs, n, timeout, true);
+
+    vq_put(vq);
+
+    return ret;
+}
+
+/**
+ * vqueue_get_batch() - get up to @n messages from vqueue
+ * @msgs: array for @n messages
+ * @timeout: ticks to wait for the first message
+ *
+ * Returns the number of messages got, which is whatever was queued, up
+ * to @n, once there was at least one.
+ */
+
+int vqueue_get_batch(int fd, void *msgs, int n, uint32_t timeout)
+{
+    struct vqueue *vq = fd_to_vqueue(fd);
+    int ret;
+
+    assert(vq);
+
+    vq_get(vq);
+
+    ret = vq_xfer(vq, msgs, n, timeout, false);
+
+    vq_put(vq);
+
+    return ret;
+}
+
+/**
+ * vqueue_send() - pass a payload on a zero-copy vqueue
+ *
+ * Ownership of @ptr goes with the message; large payloads are never
+ * copied at all.
+ */
+
+int vqueue_send(int fd, void *ptr, size_t len, uint32_t timeout)
+{
+    struct vqueue_msg msg = { .ptr = ptr, .len = len };
+
+    assert(fd_to_vqueue(fd)->zc);
+
+    return vqueue_put(fd, &msg, 0, timeout);
+}
+
+/**
+ * vqueue_recv() - take a payload from a zero-copy vqueue
  */
 
+int vqueue_recv(int fd, void **ptr, size_t *len, uint32_t timeout)
+{
+    struct vqueue_msg msg;
+    int ret;
+
+    assert(fd_to_vqueue(fd)->zc);
+
+    ret = vqueue_get(fd, &msg, NULL, timeout);
+    if (ret == 0) {
+        *ptr = msg.ptr;
+        if (len)
+            *len = msg.len;
+    }
+
+    return ret;
+}
+
+#ifdef CONFIG_SUPPORT_MEM_SLAB
+
+/**
+ * vqueue_msg_alloc() - allocate a payload from the slab of a zero-copy vqueue
+ * @timeout: ms to wait, as for mem_slab_alloc()
+ */
+
+void *vqueue_msg_alloc(int fd, uint32_t timeout)
+{
+    struct vqueue *vq = fd_to_vqueue(fd);
+    void *mem = NULL;
+
+    assert(vq && vq->slab);
+
+    if (mem_slab_alloc(vq->slab, &mem, timeout) < 0)
+        return NULL;
+
+    return mem;
+}
+
+/**
+ * vqueue_msg_free() - free a payload got from a zero-copy vqueue
+ */
+
+void vqueue_msg_free(int fd, void *ptr)
+{
+    struct vqueue *vq = fd_to_vqueue(fd);
+
+    assert(vq && vq->slab);
+
+    mem_slab_free(vq->slab, ptr);
+}
+
+#endif
+
+/**
+ * vqueue_capacity() - get capacity of vqueue
+ */
 int vqueue_capacity(int fd)
 {
     struct vqueue *vq = fd_to_vqueue(fd);
@@ -28,6 +28,13 @@
 
 #include "cmsis_os.h"
 
+#ifdef CONFIG_AT_CIPSEND_DMA
+#include <hal/device.h>
+#include <hal/uart.h>
+#include <sys/termios.h>
+#include <sys/ioctl.h>
+#endif
+
 #include "compat_param.h"
 #include "compat_if.h"
 #include "if_dl.h"
@@ -100,6 +107,14 @@ struct conn {
 	esp_transport_handle_t ssl;
 	int (*at_write) (struct conn *connn, const char *buffer, int len, int timeout_ms);
 	int (*at_read) (struct conn *connn, struct sockaddr_storage *from, char *buffer, int len, int timeout_ms);
+#ifdef CONFIG_ATCMD_AT_CIPRECVMODE
+	int passive;		/* 1 : data is held until AT+CIPRECVDATA */
+	char *rxbuf;		/* CONFIG_AT_RECVBUF_SIZE bytes, allocated on first use */
+	int rxhead;		/* offset of the oldest byte in rxbuf */
+	int rxlen;		/* bytes held in rxbuf */
+	int parked;		/* socket taken off the event loop */
+	int rxeof;		/* peer has closed, close once rxbuf is drained */
+#endif
 	struct list_head list;
 };
 
@@ -110,6 +125,12 @@ static struct addrinfo * at_build_remote_ai(char *r_host,
 
 static int ipdinfo = 0; 	/* 0 : default, 1 : show remote addr, port */
 #endif
+
+#ifdef CONFIG_ATCMD_AT_CIPRECVMODE
+
+static int recvmode = 0;	/* 0 : active, 1 : passive, for new links */
+static osMutexId_t recv_lock;	/* rxhead/rxlen of all links */
+#endif
 extern int wise_wpas_cli(int argc, char *argv[]);
 extern void eloop_unregister_read_sock(int sock);
 
@@ -525,111 +546,200 @@ void at_close_conn(struct conn *conn){
 		esp_transport_list_destroy(conn->tlist);
 	if (conn->fd > 0 && type == CONN_UDP)
 		close(conn->fd);
+#ifdef CONFIG_ATCMD_AT_CIPRECVMODE
+	if (conn->rxbuf)
+		free(conn->rxbuf);
+#endif
 	free(conn);
 	g_socket_free_count++;
 }
 
 #ifdef CONFIG_ATCMD_AT_CIPSTART
 
-static void at_tcpip_receive(int sock, void *eloop_ctx, void *sock_ctx)
+static char ipd_buf[CONFIG_AT_IPD_CHUNK];
+
+/* Only take data from the peer this link was set up with. */
+static int at_tcpip_from_peer(struct conn *conn, struct sockaddr_storage *from)
 {
-#define BUFSIZ	1024
-	struct conn *c, *conn = NULL;
-	struct sockaddr_storage from;
-	struct sockaddr_in *sa_in;
-	socklen_t addrlen = sizeof(struct sockaddr);
-	char tmp[BUFSIZ], *buf = NULL, *pos;
-	int len;
-	int res, tot = 0, bufpos = 0, i;
+	struct sockaddr *ai_addr = conn->ai->ai_addr;
 
-	list_for_each_entry(c, &conns, list) {
-		if (c->fd == sock) {
-			conn = c;
-			break;
-		}
+	if (conn->ai->ai_family == AF_INET) {
+
+		struct sockaddr_in *in1 = (struct sockaddr_in *)ai_addr;
+		struct sockaddr_in *in2 = (struct sockaddr_in *)from;
+
+		if (memcmp(&in1->sin_addr, &in2->sin_addr, sizeof(struct in_addr)) ||
+				in1->sin_port != in2->sin_port)
+			return 0;
 	}
+#if LWIP_IPV6
+	else if (conn->ai->ai_family == AF_INET6) {
 
-	if (conn == NULL) {
-		return;
+		struct sockaddr_in6 *in6_1 = (struct sockaddr_in6 *)ai_addr;
+		struct sockaddr_in6 *in6_2 = (struct sockaddr_in6 *)from;
+		if (memcmp(&in6_1->sin6_addr, &in6_2->sin6_addr, sizeof(struct in6_addr)) ||
+			in6_1->sin6_port != in6_2->sin6_port)
+			return 0;
 	}
+#endif
 
-	len = BUFSIZ;
-	pos = tmp;
-	do {
-		res = conn->at_read(conn, &from, pos, len, 0);
-		if (res > 0) {
-			pos += res;
-			len -= res;
-			tot += res;
-			if (len == 0) {
-				buf = realloc(buf, tot);
-				memcpy(buf + bufpos, tmp, BUFSIZ);
-				bufpos += BUFSIZ;
-				pos = tmp;
-				len = BUFSIZ;
-			}
+	return 1;
+}
+
+static void at_tcpip_update_remote(struct conn *conn, struct sockaddr_storage *from)
+{
+	if (conn->type == CONN_UDP && conn->udp_mode != REMOTE_FIXED) {
+		if (conn->udp_mode == REMOTE_LAST_RX || !conn->remote_changed) {
+			memcpy(conn->ai->ai_addr, from, sizeof(*from));
+			conn->ai->ai_addrlen = sizeof(struct sockaddr);
+			conn->remote_changed = 1;
 		}
-	} while (res > 0);
-
-	if (tot > 0) {
-		if (bufpos > 0) {
-			/* Get the last data in tmp[], if any. */
-			if (tot % BUFSIZ != 0) {
-				buf = realloc(buf, tot);
-				memcpy(buf + bufpos, tmp, tot % BUFSIZ);
-			}
+	}
+}
+
+static void at_tcpip_ipd(struct conn *conn, struct sockaddr_storage *from,
+		const char *data, int len)
+{
+	struct sockaddr_in *sa_in;
+
+	if (!conn->pass) {
+		at_printf("+IPD:%d,%d", conn->id, len);
+		if (ipdinfo) {
+			struct aftype *ap = &inet_aftype;
+
+			sa_in = (struct sockaddr_in *)from;
+#if LWIP_IPV6
+			if (sa_in->sin_family == AF_INET6)
+				ap = &inet6_aftype;
+#endif
+			at_printf(",%s,%d:", ap->sprint((struct sockaddr *)sa_in, 1), ntohs(sa_in->sin_port));
+
 		} else
-			buf = tmp;
+			at_printf(":");
+	}
 
+	at_write(data, len);
+}
 
-		struct sockaddr *ai_addr = conn->ai->ai_addr;
-		if (conn->ai->ai_family == AF_INET) {
+#ifdef CONFIG_ATCMD_AT_CIPRECVMODE
 
-			struct sockaddr_in *in1 = (struct sockaddr_in *)ai_addr;
-			struct sockaddr_in *in2 = (struct sockaddr_in *)&from;
+static void at_tcpip_park(struct conn *conn)
+{
+	eloop_unregister_read_sock(conn->fd);
+	conn->parked = 1;
+}
 
-			if (memcmp(&in1->sin_addr, &in2->sin_addr, sizeof(struct in_addr)) ||
-					in1->sin_port != in2->sin_port)
-				return;
+/*
+ * Passive mode: move socket data into the link's buffer and tell the
+ * host how much is waiting. A full buffer takes the socket off the event
+ * loop until AT+CIPRECVDATA makes room again.
+ */
+static void at_tcpip_receive_passive(struct conn *conn)
+{
+	struct sockaddr_storage from;
+	int res, room, tail, part, held = 0, tot = 0;
+
+	if (conn->rxbuf == NULL) {
+		conn->rxbuf = malloc(CONFIG_AT_RECVBUF_SIZE);
+		if (conn->rxbuf == NULL) {
+			at_tcpip_park(conn);
+			return;
 		}
-#if LWIP_IPV6
-		else if (conn->ai->ai_family == AF_INET6) {
+	}
 
-			struct sockaddr_in6 *in6_1 = (struct sockaddr_in6 *)ai_addr;
-			struct sockaddr_in6 *in6_2 = (struct sockaddr_in6 *)&from;
-			if (memcmp(&in6_1->sin6_addr, &in6_2->sin6_addr, sizeof(struct in6_addr)) ||
-				in6_1->sin6_port != in6_2->sin6_port)
-				return;
+	do {
+		room = CONFIG_AT_RECVBUF_SIZE - conn->rxlen;
+		if (room == 0)
+			break;
+		res = conn->at_read(conn, &from, ipd_buf, min(room, (int)sizeof(ipd_buf)), 0);
+		if (res <= 0)
+			break;
+		tot += res;
+
+		if (!at_tcpip_from_peer(conn, &from))
+			continue;
+
+		/* Only we append; AT+CIPRECVDATA may consume meanwhile. */
+		osMutexAcquire(recv_lock, osWaitForever);
+		tail = (conn->rxhead + conn->rxlen) % CONFIG_AT_RECVBUF_SIZE;
+		part = min(res, CONFIG_AT_RECVBUF_SIZE - tail);
+		memcpy(conn->rxbuf + tail, ipd_buf, part);
+		memcpy(conn->rxbuf, ipd_buf + part, res - part);
+		conn->rxlen += res;
+		held = conn->rxlen;
+		osMutexRelease(recv_lock);
+
+		at_tcpip_update_remote(conn, &from);
+	} while (tot < CONFIG_AT_IPD_BURST);
+
+	if (held > 0)
+		at_printf("+IPD,%d,%d\r\n", conn->id, held);
+
+	if (room == 0) {
+		at_tcpip_park(conn);
+	} else if (tot == 0) {
+		osMutexAcquire(recv_lock, osWaitForever);
+		held = conn->rxlen;
+		if (held)
+			conn->rxeof = 1;
+		osMutexRelease(recv_lock);
+
+		if (held) {
+			/* Let the host fetch what is left, then close. */
+			at_tcpip_park(conn);
+			return;
 		}
+
+		eloop_unregister_read_sock(conn->fd);
+		list_del(&conn->list);
+		at_close_conn(conn);
+	}
+}
 #endif
 
-		if (!conn->pass) {
-			at_printf("+IPD:%d,%d", conn->id, tot);
-			if (ipdinfo) {
-				struct aftype *ap = &inet_aftype;
+/*
+ * Forward received data to the AT UART one +IPD block at a time. The UART
+ * write blocks while the port drains, so a slow host leaves data queued in
+ * the socket rather than piling it up here.
+ */
+static void at_tcpip_receive(int sock, void *eloop_ctx, void *sock_ctx)
+{
+	struct conn *c, *conn = NULL;
+	struct sockaddr_storage from;
+	int res, tot = 0;
+
+	list_for_each_entry(c, &conns, list) {
+		if (c->fd == sock) {
+			conn = c;
+			break;
+		}
+	}
 
-				sa_in = (struct sockaddr_in *)&from;
-#if LWIP_IPV6
-				if (sa_in->sin_family == AF_INET6)
-					ap = &inet6_aftype;
+	if (conn == NULL) {
+		return;
+	}
+
+#ifdef CONFIG_ATCMD_AT_CIPRECVMODE
+	if (conn->passive) {
+		at_tcpip_receive_passive(conn);
+		return;
+	}
 #endif
-				at_printf(",%s,%d:", ap->sprint((struct sockaddr *)sa_in, 1), ntohs(sa_in->sin_port));
 
-			} else
-				at_printf(":");
-		}
+	do {
+		res = conn->at_read(conn, &from, ipd_buf, sizeof(ipd_buf), 0);
+		if (res <= 0)
+			break;
+		tot += res;
 
-		for (i = 0; i < tot; i++)
-			at_printf("%c", buf[i]);
+		if (!at_tcpip_from_peer(conn, &from))
+			continue;
 
-		if (conn->type == CONN_UDP && conn->udp_mode != REMOTE_FIXED) {
-			if (conn->udp_mode == REMOTE_LAST_RX || !conn->remote_changed) {
-				memcpy(conn->ai->ai_addr, &from, sizeof(from));
-				conn->ai->ai_addrlen = addrlen;
-				conn->remote_changed = 1;
-			}
-		}
-	} else if (res <= 0) {
+		at_tcpip_ipd(conn, &from, ipd_buf, res);
+		at_tcpip_update_remote(conn, &from);
+	} while (tot < CONFIG_AT_IPD_BURST);
+
+	if (tot == 0) {
 		/*
 		 * It occurs because the peer has disconnected.
 		 * This is inside eloop handler where it is safe to unregister directly
@@ -639,8 +749,6 @@ static void at_tcpip_receive(int sock, void *eloop_ctx, void *sock_ctx)
 		list_del(&conn->list);
 		at_close_conn(conn);
 	}
-
-#undef BUFSIZ
 }
 #endif
 #ifdef CONFIG_ATCMD_AT_CIFSR
@@ -1402,6 +1510,15 @@ static int at_cipstart_set(int argc, char *argv[])
 	conn = (struct conn *)zalloc(sizeof(*conn));
 	g_socket_free_count--;
 	conn->type = type;
+#ifdef CONFIG_ATCMD_AT_CIPRECVMODE
+	if (recvmode) {
+		if (recv_lock == NULL)
+			recv_lock = osMutexNew(NULL);
+		if (recv_lock == NULL)
+			err_exit(err, AT_RESULT_CODE_ERROR);
+		conn->passive = 1;
+	}
+#endif
 
 	if ((conn->ai = at_build_remote_ai(r_host, r_port)) == NULL)
 		err_exit(err, AT_RESULT_CODE_ERROR);
@@ -1467,7 +1584,12 @@ static int at_cipclose_set(int argc, char *argv[])
 		err_exit(err, AT_RESULT_CODE_ERROR);
 	}
 
+#ifdef CONFIG_ATCMD_AT_CIPRECVMODE
+	/* A parked socket is already off the event loop. */
+	if (!conn->parked && unregister_socket(conn->fd) < 0)
+#else
 	if (unregister_socket(conn->fd) < 0)
+#endif
 		err_exit(err, AT_RESULT_CODE_ERROR);
 
 	list_del(&conn->list);
@@ -1497,7 +1619,294 @@ static int at_cipdinfo_set(int argc, char *argv[])
 ATPLUS(CIPDINFO, NULL, at_cipdinfo_query, at_cipdinfo_set, NULL);
 #endif
 
+#ifdef CONFIG_ATCMD_AT_CIPRECVMODE
+static struct conn *at_find_conn(int id)
+{
+	struct conn *c;
+
+	list_for_each_entry(c, &conns, list) {
+		if (c->id == id)
+			return c;
+	}
+
+	return NULL;
+}
+
+static int at_ciprecvmode_query(int argc, char *argv[])
+{
+	at_printf("%s:%d\r\n", argv[AT_CMD_NAME], recvmode);
+	return AT_RESULT_CODE_OK;
+}
+
+/*
+ * AT+CIPRECVMODE=<mode>
+ *
+ * 0 : active, data is pushed with +IPD as it arrives.
+ * 1 : passive, data is held and fetched with AT+CIPRECVDATA.
+ *
+ * Applies to links opened afterwards.
+ */
+static int at_ciprecvmode_set(int argc, char *argv[])
+{
+	int mode = atoi(argv[AT_CMD_PARAM]);
+
+	if (mode != 0 && mode != 1)
+		return AT_RESULT_CODE_ERROR;
+
+	recvmode = mode;
+	return AT_RESULT_CODE_OK;
+}
+
+ATPLUS(CIPRECVMODE, NULL, at_ciprecvmode_query, at_ciprecvmode_set, NULL);
+
+/*
+ * AT+CIPRECVDATA=<link ID>,<len>
+ *
+ * +CIPRECVDATA:<actual len>,<data>
+ */
+static int at_ciprecvdata_set(int argc, char *argv[])
+{
+	struct conn *conn;
+	int id, len, head, part, rearm = 0, eof = 0;
+
+	if (argc < AT_CMD_PARAM + 2)
+		return AT_RESULT_CODE_ERROR;
+
+	id = atoi(argv[AT_CMD_PARAM]);
+	len = atoi(argv[AT_CMD_PARAM + 1]);
+
+	conn = at_find_conn(id);
+	if (conn == NULL || !conn->passive || len <= 0)
+		return AT_RESULT_CODE_ERROR;
+
+	osMutexAcquire(recv_lock, osWaitForever);
+	len = min(len, conn->rxlen);
+	head = conn->rxhead;
+	osMutexRelease(recv_lock);
+
+	/* The receive side only appends, so [head, head + len) is ours. */
+	at_printf("%s:%d,", argv[AT_CMD_NAME], len);
+	part = min(len, CONFIG_AT_RECVBUF_SIZE - head);
+	if (part)
+		at_write(conn->rxbuf + head, part);
+	if (len - part)
+		at_write(conn->rxbuf, len - part);
+	at_printf("\r\n");
+
+	osMutexAcquire(recv_lock, osWaitForever);
+	conn->rxhead = (head + len) % CONFIG_AT_RECVBUF_SIZE;
+	conn->rxlen -= len;
+	if (conn->rxeof) {
+		eof = (conn->rxlen == 0);
+	} else if (conn->parked && conn->rxlen < CONFIG_AT_RECVBUF_SIZE) {
+		conn->parked = 0;
+		rearm = 1;
+	}
+	osMutexRelease(recv_lock);
+
+	if (rearm && register_socket(conn->fd, at_tcpip_receive) < 0)
+		conn->parked = 1;
+
+	if (eof) {
+		list_del(&conn->list);
+		at_close_conn(conn);
+	}
+
+	return AT_RESULT_CODE_OK;
+}
+
+ATPLUS(CIPRECVDATA, NULL, NULL, at_ciprecvdata_set, NULL);
+
+/*
+ * AT+CIPRECVLEN?
+ *
+ * +CIPRECVLEN:<len of link 0>,...,<len of link 4>, -1 when the link is
+ * not open in passive mode.
+ */
+static int at_ciprecvlen_query(int argc, char *argv[])
+{
+	struct conn *conn;
+	int id, len;
+
+	at_printf("%s:", argv[AT_CMD_NAME]);
+	for (id = 0; id < AT_SOCKET_MAX_CONN_NUM; id++) {
+		conn = at_find_conn(id);
+		len = (conn && conn->passive) ? conn->rxlen : -1;
+		at_printf(id ? ",%d" : "%d", len);
+	}
+	at_printf("\r\n");
+
+	return AT_RESULT_CODE_OK;
+}
+
+ATPLUS(CIPRECVLEN, NULL, at_ciprecvlen_query, NULL, NULL);
+#endif /* CONFIG_ATCMD_AT_CIPRECVMODE */
+
 #ifdef CONFIG_ATCMD_AT_CIPSEND
+
+#ifdef CONFIG_AT_CIPSEND_DMA
+
+#define PT_BUF_SIZE	CONFIG_AT_CIPSEND_DMA_BUF
+
+static uint8_t pt_buf[2][PT_BUF_SIZE] __attribute__((section(".dma_buffer")));
+
+struct pt_msg {
+	int idx;
+	int len;
+};
+
+static struct {
+	struct device *dev;
+	osMessageQueueId_t full;	/* buffers handed over, in order */
+	int rx;				/* buffer being filled, or -1 */
+	int spare;			/* buffer ready to be filled, or -1 */
+} pt;
+
+/*
+ * Runs from the UART and DMA interrupts. The spare buffer is armed right
+ * away, so the line keeps being received while the task sends.
+ */
+static void at_pt_uart_cb(struct uart_event *event, void *ctx)
+{
+	struct pt_msg msg;
+
+	if (event->type == UART_EVENT_TX_CMPL || pt.rx < 0)
+		return;
+
+	if (event->err) {
+		/* The driver has reset the FIFO; start over in the same buffer. */
+		uart_rx(pt.dev, pt_buf[pt.rx], PT_BUF_SIZE);
+		return;
+	}
+
+	msg.idx = pt.rx;
+	msg.len = uart_get_rx_len(pt.dev);
+
+	pt.rx = pt.spare;
+	pt.spare = -1;
+	if (pt.rx >= 0)
+		uart_rx(pt.dev, pt_buf[pt.rx], PT_BUF_SIZE);
+
+	osMessageQueuePut(pt.full, &msg, 0, 0);
+}
+
+/* Give a sent buffer back, arming it if the UART has run dry. */
+static void at_pt_release(int idx)
+{
+	unsigned long flags;
+
+	local_irq_save(flags);
+	if (pt.rx < 0) {
+		pt.rx = idx;
+		uart_rx(pt.dev, pt_buf[idx], PT_BUF_SIZE);
+	} else {
+		pt.spare = idx;
+	}
+	local_irq_restore(flags);
+}
+
+static int at_pt_uart_init(struct device *dev)
+{
+	struct termios termios;
+	struct uart_cfg cfg;
+
+	if (ioctl(at_term_fd(), TCGETS, &termios))
+		return -EIO;
+
+	cfg.baudrate = termios.c_ispeed;
+	switch (termios.c_cflag & CSIZE) {
+	case CS5:
+		cfg.data_bits = UART_DATA_BITS_5;
+		break;
+	case CS6:
+		cfg.data_bits = UART_DATA_BITS_6;
+		break;
+	case CS7:
+		cfg.data_bits = UART_DATA_BITS_7;
+		break;
+	default:
+		cfg.data_bits = UART_DATA_BITS_8;
+		break;
+	}
+	if (!(termios.c_cflag & PARENB))
+		cfg.parity = UART_NO_PARITY;
+	else if (termios.c_cflag & PARODD)
+		cfg.parity = UART_ODD_PARITY;
+	else
+		cfg.parity = UART_EVENT_PARITY;
+	cfg.stop_bits = (termios.c_cflag & CSTOPB) ? UART_STOP_BIT_2 : UART_STOP_BIT_1;
+	cfg.dma_en = 1;
+	cfg.rx_idle = 1;
+
+	return uart_init(dev, &cfg, at_pt_uart_cb, NULL);
+}
+
+/*
+ * Passthrough over the raw UART DMA path. The UART fills one buffer while
+ * the other one is being sent. A buffer is handed over when it is full,
+ * or when the RX timeout interrupt says the line has gone quiet, so "+++"
+ * is recognized when it comes as a buffer of its own, with idle time on
+ * both sides. If both buffers are waiting to be sent, the UART FIFO and
+ * flow control hold the line until one is given back.
+ *
+ * Returns -ENODEV if the AT UART cannot be taken over, in which case the
+ * caller should use the character path.
+ */
+static int at_cipsend_dma(struct conn *conn)
+{
+	struct device *dev;
+	struct pt_msg msg;
+	char name[16];
+	int len, b, err = 0;
+
+	snprintf(name, sizeof(name), "atcuart.%d", CONFIG_AT_UART_PORT);
+	dev = device_get_by_name(name);
+	if (dev == NULL)
+		return -ENODEV;
+
+	if (pt.full == NULL &&
+	    (pt.full = osMessageQueueNew(2, sizeof(struct pt_msg), NULL)) == NULL)
+		return -ENODEV;
+
+	if (at_pt_uart_init(dev))
+		return -ENODEV;
+
+	/* Whatever arrived before the switch is still in the serial queue. */
+	len = 0;
+	while (len < PT_BUF_SIZE && (b = at_getchar_timeout(0)) >= 0)
+		pt_buf[1][len++] = (uint8_t)b;
+	if (len && conn->at_write(conn, (char *)pt_buf[1], len, 0) < len) {
+		uart_deinit(dev);
+		return -EIO;
+	}
+
+	osMessageQueueReset(pt.full);
+	pt.dev = dev;
+	pt.rx = -1;
+	pt.spare = 1;
+	at_pt_release(0);
+
+	while (osMessageQueueGet(pt.full, &msg, NULL, osWaitForever) == osOK) {
+		if (msg.len == 3 && !memcmp(pt_buf[msg.idx], "+++", msg.len))
+			break;
+
+		if (conn->at_write(conn, (char *)pt_buf[msg.idx], msg.len, 0) < msg.len) {
+			err = -EIO;
+			break;
+		}
+
+		at_pt_release(msg.idx);
+	}
+
+	uart_rx_stop(dev);
+	uart_deinit(dev);
+	pt.rx = pt.spare = -1;
+
+	return err;
+}
+
+#endif /* CONFIG_AT_CIPSEND_DMA */
+
 /*
  * AT+CIPSEND=<link ID>,<length>
  *
@@ -1606,6 +2015,15 @@ static int at_cipsend_set(int argc, char *argv[])
 		}
 		at_printf("\r\nSEND OK\r\n");
 	} else {
+#ifdef CONFIG_AT_CIPSEND_DMA
+		ret = at_cipsend_dma(temp_conn ? temp_conn : conn);
+		if (ret == -EIO) {
+			at_printf("\r\nSEND FAIL\r\n");
+			err_exit(err, AT_RESULT_CODE_ERROR);
+		} else if (ret == 0) {
+			goto exit;
+		}
+#endif
 		do {
 			size = CONFIG_AT_CIPSEND_MAX;
 			while (len < size) {
@@ -310,6 +310,12 @@ int at_printf(const char *fmt, ...)
     return ret;
 }
 
+/* Write a block of raw data, e.g. a socket payload, in one go. */
+int at_write(const void *buf, size_t len)
+{
+    return fwrite(buf, 1, len, term);
+}
+
 
 #ifdef CONFIG_AT_OVER_IPC
 ipc_listener_t g_wlan_ctrl_listener;
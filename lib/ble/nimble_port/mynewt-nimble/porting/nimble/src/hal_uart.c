@@ -159,6 +159,7 @@ hal_uart_config(int port, int32_t baudrate, uint8_t databits, uint8_t stopbits,
     cfg.stop_bits = UART_STOP_BIT_1;
     cfg.parity = UART_NO_PARITY;
     cfg.dma_en = 0;
+    cfg.rx_idle = 0;
     (void)flow_ctl;
 
     ret = uart_init(u->dev, &cfg, hal_uart_cb, (void *)u);
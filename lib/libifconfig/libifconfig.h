@@ -160,31 +160,3 @@ int ifconfig_get80211val(ifconfig_handle_t *h, const char *name,
 		int type, int len, int *val); /* len : for optional argument ex. WME */
 int ifconfig_get80211len(ifconfig_handle_t *h, const char *name,
 		int type, void *data, int len, int *plen);
-
-#ifdef CONFIG_SANDBOX
-/*
- * BSD strlcpy
- * size of 'dst' is assumed to be equal to or larger than size
- */
-static inline size_t
-strlcpy(char *dst, const char *src, size_t size)
-{
-	int clen = strlen(src) >= size ? size : strlen(src);
-	strncpy(dst, src, clen);
-	dst[clen] = '\0';
-
-	return strlen(src);
-}
-
-/*
- * BSD strlcat
- * size of 'dst' is assumed to be equal to or larger than size
- */
-static inline size_t
-strlcat(char *dst, const char *src, size_t size)
-{
-	int ldst = strlen(dst);
-	return (strlcpy(dst + ldst, src, size - ldst)
-			+ ldst);
-}
-#endif
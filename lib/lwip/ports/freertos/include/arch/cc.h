@@ -39,6 +39,16 @@
 #define BYTE_ORDER LITTLE_ENDIAN
 #endif /* BYTE_ORDER */
 
+#ifdef CONFIG_SANDBOX
+/*
+ * The host <limits.h> has SSIZE_MAX, which makes lwip/arch.h include
+ * <unistd.h>. That is the vfs one here, whose read()/write() macros
+ * would catch every ops->write() in lwIP users. The target has no
+ * SSIZE_MAX and never includes it.
+ */
+#define LWIP_NO_UNISTD_H 1
+#endif
+
 #define LWIP_ERROR(message, expr, handler) do {		\
 	if (!(expr)) {					\
 		handler;				\
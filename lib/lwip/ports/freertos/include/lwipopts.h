@@ -419,6 +419,11 @@
  */
 #define PBUF_LINK_HLEN                  (14 + ETH_PAD_SIZE)
 
+#ifdef CONFIG_FREEBSD_MBUF_PBUF_ZEROCOPY
+/* Received mbufs are handed over as custom PBUF_REF pbufs. */
+#define LWIP_SUPPORT_CUSTOM_PBUF        1
+#endif
+
 #if 0
 /**
  * PBUF_LINK_ENCAPSULATION_HLEN: the number of bytes that should be allocated
@@ -17,6 +17,10 @@
 #include <freebsd/mbuf.h>
 #endif
 
+#ifdef CONFIG_FREEBSD_MBUF_PBUF_ZEROCOPY
+#include <freebsd/lwip-glue.h>
+#endif
+
 #ifdef CONFIG_IEEE80211_HOSTED
 /*
  * Some condition buffer* will be located in d25
@@ -36,3 +40,7 @@ LWIP_MEMPOOL_SECTION(MBUF_CHUNK, MEMP_NUM_MBUF_CHUNK, LWIP_MEM_ALIGN_SIZE(__MCLB
 LWIP_MEMPOOL_SECTION(MBUF_EXT_NODE, MEMP_NUM_MBUF_DYNA_EXT, LWIP_MEM_ALIGN_SIZE(sizeof(struct mbuf3)), "MBUF_EXT_NODE", .buffer_ext)
 #endif
 #endif
+
+#ifdef CONFIG_FREEBSD_MBUF_PBUF_ZEROCOPY
+LWIP_MEMPOOL(MBUF_PBUF, CONFIG_FREEBSD_MBUF_PBUF_ZEROCOPY_NUM, sizeof(struct m_pbuf), "MBUF_PBUF")
+#endif
@@ -69,6 +69,7 @@
 #include "lwip/stats.h"
 
 #include <string.h>
+#include <stdio.h>
 
 /* Make sure we include everything we need for size calculation required by memp_std.h */
 #include "lwip/pbuf.h"
@@ -398,6 +399,265 @@ void memp_init_pool_region(const struct memp_desc *desc, uint16_t reg_num)
 #endif /* !MEMP_MEM_MALLOC */
 }
 
+#ifdef CONFIG_MEMP_ARENA
+
+/*
+ * Shared packet buffer arena.
+ *
+ * PBUF_POOL and the mbuf clusters (MBUF_CHUNK) used to be sized
+ * separately, so one side could run dry on RX while the other sat
+ * idle. Each of them still gets its own static pool, and when that is
+ * empty it takes a slot from one arena shared between them.
+ *
+ * The static pools stay first in line on purpose. MBUF_CHUNK lives in
+ * the .bufreloc output section (.buffer_chunk) next to the DMA
+ * descriptors, and the WLAN power management resume path rebuilds it in
+ * place with memp_reset(). The prebuilt and ROM code that reaches these
+ * pools only ever sees memp_malloc()/memp_free() by pool index, so the
+ * arena can only extend the pools, not replace where they live.
+ *
+ * A user's reservation is the number of arena slots nobody else may
+ * take from it. It starts at the Kconfig minimum, which is what keeps
+ * a user from starving. It then follows pressure: a user that fails
+ * grows its reservation, out of the unreserved slots or out of an idle
+ * user's extra reservation. A user that holds less than half of its
+ * reservation gives some of it back on free, down to the minimum.
+ *
+ * Everything here runs under SYS_ARCH_PROTECT, like the pool lists.
+ */
+
+#define ARENA_FREE	0xff
+
+struct memp_arena_user {
+	memp_t type;
+	u16_t base;
+	u16_t reserve;
+	u16_t held;
+	u16_t peak;
+	u32_t fail;
+	u32_t steal;
+};
+
+static struct memp_arena_user arena_users[] = {
+	{ .type = MEMP_PBUF_POOL, .base = CONFIG_MEMP_ARENA_RESERVE_PBUF },
+#ifdef CONFIG_MEMP_NUM_MBUF_CHUNK
+	{ .type = MEMP_MBUF_CHUNK, .base = CONFIG_MEMP_ARENA_RESERVE_MBUF },
+#endif
+};
+
+static struct {
+	u8_t *base, *end;
+	u8_t *owner;
+	struct memp *free;
+	u16_t slot;
+	u16_t num;
+	u16_t nfree;
+	u16_t min_free;
+} arena;
+
+static struct memp_arena_user *memp_arena_user(const struct memp_desc *desc)
+{
+	int i;
+
+	for (i = 0; i < LWIP_ARRAYSIZE(arena_users); i++)
+		if (memp_pools[arena_users[i].type] == desc)
+			return &arena_users[i];
+
+	return NULL;
+}
+
+static int memp_arena_in(void *memp)
+{
+	return (u8_t *)memp >= arena.base && (u8_t *)memp < arena.end;
+}
+
+/* Slots that @u may take without eating into somebody else's reservation */
+static u16_t memp_arena_room(struct memp_arena_user *u)
+{
+	struct memp_arena_user *v;
+	u16_t blocked = 0;
+
+	for (v = arena_users; v < arena_users + LWIP_ARRAYSIZE(arena_users); v++)
+		if (v != u && v->reserve > v->held)
+			blocked += v->reserve - v->held;
+
+	return arena.nfree > blocked ? arena.nfree - blocked : 0;
+}
+
+static void memp_arena_rebalance(struct memp_arena_user *u)
+{
+	struct memp_arena_user *v;
+	u16_t reserved = 0;
+
+	for (v = arena_users; v < arena_users + LWIP_ARRAYSIZE(arena_users); v++)
+		reserved += v->reserve;
+
+	if (reserved < arena.num) {
+		u->reserve++;
+		return;
+	}
+
+	for (v = arena_users; v < arena_users + LWIP_ARRAYSIZE(arena_users); v++) {
+		if (v != u && v->reserve > v->base && v->held < v->reserve) {
+			v->reserve--;
+			u->reserve++;
+			u->steal++;
+			return;
+		}
+	}
+}
+
+static struct memp *memp_arena_get(const struct memp_desc *desc)
+{
+	struct memp_arena_user *u = memp_arena_user(desc);
+	struct memp *memp;
+
+	if (u == NULL || arena.base == NULL)
+		return NULL;
+
+	if (!memp_arena_room(u)) {
+		u->fail++;
+		memp_arena_rebalance(u);
+		if (!memp_arena_room(u))
+			return NULL;
+	}
+
+	memp = arena.free;
+	arena.free = memp->next;
+	arena.owner[((u8_t *)memp - arena.base) / arena.slot] = u - arena_users;
+	if (--arena.nfree < arena.min_free)
+		arena.min_free = arena.nfree;
+	if (++u->held > u->peak)
+		u->peak = u->held;
+
+	return memp;
+}
+
+static void memp_arena_put(const struct memp_desc *desc, struct memp *memp)
+{
+	u16_t i = ((u8_t *)memp - arena.base) / arena.slot;
+	struct memp_arena_user *u;
+
+	/* a double free, or a free of a slot memp_reset() took back */
+	if (arena.owner[i] == ARENA_FREE) {
+		LWIP_ASSERT("memp_arena_put: slot is not in use", 0);
+		return;
+	}
+
+	u = &arena_users[arena.owner[i]];
+
+	LWIP_ASSERT("memp_arena_put: wrong pool", memp_pools[u->type] == desc);
+
+	arena.owner[i] = ARENA_FREE;
+	memp->next = arena.free;
+	arena.free = memp;
+	arena.nfree++;
+
+	u->held--;
+	if (u->reserve > u->base && u->held < u->reserve / 2)
+		u->reserve--;
+}
+
+/* A pool that gets reset forgets what it had, so do we. */
+static void memp_arena_reclaim(const struct memp_desc *desc)
+{
+	struct memp_arena_user *u = memp_arena_user(desc);
+	SYS_ARCH_DECL_PROTECT(flags);
+	u16_t i;
+
+	if (u == NULL || arena.base == NULL)
+		return;
+
+	SYS_ARCH_PROTECT(flags);
+	for (i = 0; i < arena.num; i++) {
+		if (arena.owner[i] != u - arena_users)
+			continue;
+		memp_arena_put(desc, (struct memp *)(arena.base + i * arena.slot));
+	}
+	SYS_ARCH_UNPROTECT(flags);
+}
+
+static void memp_arena_init(void)
+{
+	struct memp_arena_user *u;
+	struct memp *memp;
+	u16_t size = 0, i;
+
+	if (arena.base != NULL)
+		return;
+
+	for (u = arena_users; u < arena_users + LWIP_ARRAYSIZE(arena_users); u++) {
+		u->reserve = u->base;
+		if (memp_pools[u->type] != &memp_dummy)
+			size = LWIP_MAX(size, memp_pools[u->type]->size);
+	}
+
+	arena.slot = LWIP_MEM_ALIGN_SIZE(MEMP_SIZE + size);
+	arena.num = CONFIG_MEMP_ARENA_NUM;
+	arena.base = mem_malloc(arena.num * arena.slot + MEM_ALIGNMENT - 1);
+	arena.owner = mem_malloc(arena.num);
+	if (arena.base == NULL || arena.owner == NULL) {
+		mem_free(arena.base);
+		mem_free(arena.owner);
+		arena.base = NULL;
+		LWIP_DEBUGF(MEMP_DEBUG | LWIP_DBG_LEVEL_SERIOUS,
+			    ("memp_arena_init: out of memory\n"));
+		return;
+	}
+	arena.base = (u8_t *)LWIP_MEM_ALIGN(arena.base);
+	arena.end = arena.base + arena.num * arena.slot;
+
+	arena.free = NULL;
+	for (i = arena.num; i-- > 0; ) {
+		memp = (struct memp *)(void *)(arena.base + i * arena.slot);
+		memp->next = arena.free;
+		arena.free = memp;
+		arena.owner[i] = ARENA_FREE;
+	}
+	arena.nfree = arena.min_free = arena.num;
+}
+
+/**
+ * Print the shared arena and its users' reservations and watermarks.
+ */
+int memp_arena_stat(char *buf, size_t size)
+{
+	struct memp_arena_user *u;
+	char *end = buf + size;
+	int n;
+
+	if (arena.base == NULL) {
+		snprintf(buf, size, "arena: not initialized\n");
+		return 0;
+	}
+
+	n = snprintf(buf, end - buf, "arena: %u x %u B, free %u (min %u)\n",
+			arena.num, arena.slot, arena.nfree, arena.min_free);
+	if (n < 0 || n >= end - buf)
+		return -1;
+	buf += n;
+
+	n = snprintf(buf, end - buf, "%-12s%6s%6s%6s%6s%8s%8s\n",
+			"POOL", "MIN", "RSV", "HELD", "PEAK", "FAIL", "STEAL");
+	if (n < 0 || n >= end - buf)
+		return -1;
+	buf += n;
+
+	for (u = arena_users; u < arena_users + LWIP_ARRAYSIZE(arena_users); u++) {
+		n = snprintf(buf, end - buf, "%-12s%6u%6u%6u%6u%8lu%8lu\n",
+				memp_pools[u->type]->desc ? : "?",
+				u->base, u->reserve, u->held, u->peak,
+				(unsigned long)u->fail, (unsigned long)u->steal);
+		if (n < 0 || n >= end - buf)
+			return -1;
+		buf += n;
+	}
+
+	return 0;
+}
+
+#endif /* CONFIG_MEMP_ARENA */
+
 /**
  * Initializes lwIP built-in pools.
  * Related functions: memp_malloc, memp_free
@@ -421,6 +681,10 @@ memp_init(void)
 	/* check everything a first time to see if it worked */
 	memp_overflow_check_all();
 #endif /* MEMP_OVERFLOW_CHECK >= 2 */
+
+#ifdef CONFIG_MEMP_ARENA
+	memp_arena_init();
+#endif
 }
 
 #if !MEMP_OVERFLOW_CHECK && !MEMP_OWNER_CHECK
@@ -438,12 +702,22 @@ __ilm__ static void *do_memp_malloc_pool(const struct memp_desc *desc)
 #else
 	/* Zero-size descriptor */
 	if (desc->num == 0) {
+#ifdef CONFIG_MEMP_ARENA
+		SYS_ARCH_PROTECT(flags);
+		memp = memp_arena_get(desc);
+		SYS_ARCH_UNPROTECT(flags);
+		if (memp == NULL)
+#endif
 		memp = (struct memp *) mem_malloc(MEMP_SIZE + MEMP_ALIGN_SIZE(desc->size));
 		SYS_ARCH_PROTECT(flags);
 	} else {
 		SYS_ARCH_PROTECT(flags);
 		if ((memp = *desc->tab) != NULL)
 			*desc->tab = memp->next;
+#ifdef CONFIG_MEMP_ARENA
+		else
+			memp = memp_arena_get(desc);
+#endif
 	}
 #endif
 
@@ -486,12 +760,22 @@ static void *do_memp_malloc_pool_fn(const struct memp_desc *desc,
 #else
 	/* Zero-size descriptor */
 	if (desc->num == 0) {
+#ifdef CONFIG_MEMP_ARENA
+		SYS_ARCH_PROTECT(flags);
+		memp = memp_arena_get(desc);
+		SYS_ARCH_UNPROTECT(flags);
+		if (memp == NULL)
+#endif
 		memp = (struct memp *) mem_malloc(MEMP_SIZE + MEMP_ALIGN_SIZE(desc->size));
 		SYS_ARCH_PROTECT(flags);
 	} else {
 		SYS_ARCH_PROTECT(flags);
 		if ((memp = *desc->tab) != NULL)
 			*desc->tab = memp->next;
+#ifdef CONFIG_MEMP_ARENA
+		else
+			memp = memp_arena_get(desc);
+#endif
 	}
 #endif
 
@@ -641,6 +925,13 @@ do_memp_free_pool(const struct memp_desc *desc, void *mem)
 	SYS_ARCH_UNPROTECT(old_level);
 	mem_free(memp);
 #else /* MEMP_MEM_MALLOC */
+#ifdef CONFIG_MEMP_ARENA
+	if (memp_arena_in(memp)) {
+		memp_arena_put(desc, memp);
+		SYS_ARCH_UNPROTECT(old_level);
+		return;
+	}
+#endif
 	if (desc->num == 0) {
 		SYS_ARCH_UNPROTECT(old_level);
 		mem_free(memp);
@@ -731,10 +1022,26 @@ mem_size_t memp_available(memp_t type)
 {
 
 	const struct memp_desc *desc = memp_pools[type];
-	if (desc != &memp_dummy && (desc->stats->avail > desc->stats->used))
-		return (desc->stats->avail - desc->stats->used);
-	else
+	mem_size_t used, n = 0;
+#ifdef CONFIG_MEMP_ARENA
+	struct memp_arena_user *u = memp_arena_user(desc);
+#endif
+
+	if (desc == &memp_dummy)
 		return 0;
+
+	used = desc->stats->used;
+#ifdef CONFIG_MEMP_ARENA
+	/* Arena slots in use are not taken from the pool itself. */
+	if (u != NULL && arena.base != NULL) {
+		used -= u->held;
+		n = memp_arena_room(u);
+	}
+#endif
+	if (desc->stats->avail > used)
+		n += desc->stats->avail - used;
+
+	return n;
 }
 
 #if defined(__WISE__)
@@ -759,6 +1066,9 @@ memp_reset(memp_t type)
 	desc = memp_pools[type];
 
 	memp_init_pool(desc);
+#ifdef CONFIG_MEMP_ARENA
+	memp_arena_reclaim(desc);
+#endif
 }
 
 /**
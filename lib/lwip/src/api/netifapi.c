@@ -220,7 +220,7 @@ netifapi_do_netif_ioctl(struct tcpip_api_call_data *m)
 #endif
 }
 
-#if defined(__WISE__) && defined(LWIP_NETIF_EXT_STATUS_CALLBACK)
+#if defined(__WISE__) && LWIP_NETIF_EXT_STATUS_CALLBACK
 
 /**
  * Call netif_add_ext_callback() inside the tcpip_thread context.
@@ -467,7 +467,7 @@ netifapi_netif_ioctl(const long cmd,
   return err;
 }
 
-#if defined(__WISE__) && defined(LWIP_NETIF_EXT_STATUS_CALLBACK)
+#if defined(__WISE__) && LWIP_NETIF_EXT_STATUS_CALLBACK
 
 /**
  * @ingroup netifapi_netif
@@ -68,6 +68,10 @@
 #include LWIP_HOOK_FILENAME
 #endif
 
+#ifdef __WISE__
+#include "mtsmp.h"
+#endif
+
 /* If the netconn API is not required publicly, then we include the necessary
    files here to get the implementation */
 #if !LWIP_NETCONN
@@ -1001,6 +1005,9 @@ lwip_recv_tcp(struct lwip_sock *sock, void *mem, size_t len, int flags)
         }
       }
       LWIP_ASSERT("p != NULL", p != NULL);
+#ifdef __WISE__
+      mtsmp_stamp_pbuf(p, MTSMP_RX_SOCK);
+#endif
       sock->lastdata.pbuf = p;
     }
 
@@ -1154,6 +1161,9 @@ lwip_recvfrom_udp_raw(struct lwip_sock *sock, int flags, struct msghdr *msg, u16
       return err;
     }
     LWIP_ASSERT("buf != NULL", buf != NULL);
+#ifdef __WISE__
+    mtsmp_stamp_pbuf(buf->p, MTSMP_RX_SOCK);
+#endif
     sock->lastdata.netbuf = buf;
   }
   buflen = buf->p->tot_len;
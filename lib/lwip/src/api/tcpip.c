@@ -50,6 +50,11 @@
 #include "lwip/etharp.h"
 #include "netif/ethernet.h"
 
+#ifdef __WISE__
+#include "ktrace.h"
+#include "mtsmp.h"
+#endif
+
 #define TCPIP_MSG_VAR_REF(name)     API_VAR_REF(name)
 #define TCPIP_MSG_VAR_DECLARE(name) API_VAR_DECLARE(struct tcpip_msg, name)
 #define TCPIP_MSG_VAR_ALLOC(name)   API_VAR_ALLOC(struct tcpip_msg, MEMP_TCPIP_MSG_API, name, ERR_MEM)
@@ -145,7 +150,13 @@ tcpip_thread(void *arg)
       LWIP_ASSERT("tcpip_thread: invalid message", 0);
       continue;
     }
+#ifdef __WISE__
+    ktrace_begin(KTRACE_TCPIP_MSG, msg->type);
     tcpip_thread_handle_msg(msg);
+    ktrace_end(KTRACE_TCPIP_MSG, 0);
+#else
+    tcpip_thread_handle_msg(msg);
+#endif
   }
 }
 
@@ -181,6 +192,9 @@ tcpip_thread_handle_msg(struct tcpip_msg *msg)
 #if !LWIP_TCPIP_CORE_LOCKING_INPUT
     case TCPIP_MSG_INPKT:
       LWIP_DEBUGF(TCPIP_DEBUG, ("tcpip_thread: PACKET %p\n", (void *)msg));
+#ifdef __WISE__
+      mtsmp_stamp_pbuf(msg->msg.inp.p, MTSMP_RX_LWIP);
+#endif
       if (msg->msg.inp.input_fn(msg->msg.inp.p, msg->msg.inp.netif) != ERR_OK) {
         pbuf_free(msg->msg.inp.p);
       }
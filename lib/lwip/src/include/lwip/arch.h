@@ -80,6 +80,7 @@
 #ifndef LWIP_PLATFORM_DIAG
 #define LWIP_PLATFORM_DIAG(x) do {printk x;} while(0)
 #include <stdio.h>
+#include <hal/console.h>
 #include <stdlib.h>
 
 #endif
@@ -169,6 +169,9 @@ void  memp_reset(memp_t type);
 u16_t memp_num(memp_t type);
 u16_t memp_size(memp_t type);
 int memp_is_dummy(memp_t type);
+#ifdef CONFIG_MEMP_ARENA
+int memp_arena_stat(char *buf, size_t size);
+#endif
 #endif
 
 #if MEMP_OVERFLOW_CHECK || MEMP_OWNER_CHECK
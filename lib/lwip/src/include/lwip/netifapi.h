@@ -81,7 +81,7 @@ err_t netifapi_netif_common(struct netif *netif, netifapi_void_fn voidfunc,
 							netifapi_args_fn argsfunc, void *arg);
 err_t netifapi_netif_ioctl(const long cmd, const void *argp);
 
-#if defined(__WISE__) && defined(LWIP_NETIF_EXT_STATUS_CALLBACK)
+#if defined(__WISE__) && LWIP_NETIF_EXT_STATUS_CALLBACK
 /** @ingroup netifapi_netif */
 err_t netifapi_add_ext_callback(netif_ext_callback_t *callback, netif_ext_callback_fn fn);
 /** @ingroup netifapi_netif */
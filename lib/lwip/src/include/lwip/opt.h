@@ -1617,7 +1617,11 @@
 #if defined(__WISE__)
 #if defined CONFIG_PBUF_LINK_ENCAPSULATION_HLEN
 #undef PBUF_LINK_ENCAPSULATION_HLEN
+#ifdef CONFIG_WLAN
 #define SCM_BDS_HDR_SIZE (CONFIG_MAX_AMSDU_NUM * (12/*sizeof(struct bdesc)*/ * CONFIG_BDS_HDR_NUM))
+#else
+#define SCM_BDS_HDR_SIZE 0
+#endif
 #define PBUF_LINK_ENCAPSULATION_HLEN CONFIG_PBUF_LINK_ENCAPSULATION_HLEN + SCM_BDS_HDR_SIZE
 #endif
 #endif
@@ -3000,7 +3004,7 @@
 #ifdef __DOXYGEN__
 #define LWIP_HOOK_IP4_ROUTE()
 #endif
-#if defined(__WISE__)
+#if defined(__WISE__) && defined(CONFIG_WLAN)
 extern void *wlan_default_netif(int);
 #define LWIP_HOOK_IP4_ROUTE(dest) ((struct netif *)wlan_default_netif(0))
 #endif
@@ -3101,7 +3105,7 @@ extern void *wlan_default_netif(int);
 #ifdef __DOXYGEN__
 #define LWIP_HOOK_IP6_ROUTE(src, dest)
 #endif
-#if defined(__WISE__)
+#if defined(__WISE__) && defined(CONFIG_WLAN)
 extern void *wlan_default_netif(int);
 #define LWIP_HOOK_IP6_ROUTE(src, dest) ((struct netif *)wlan_default_netif(0))
 #endif
@@ -264,7 +264,7 @@ struct netifapi_msg {
 	  netifapi_args_fn argsfunc;
 	  void *arg;
     } common;
-#if defined(__WISE__) && defined(LWIP_NETIF_EXT_STATUS_CALLBACK)
+#if defined(__WISE__) && LWIP_NETIF_EXT_STATUS_CALLBACK
 	struct {
 	  netif_ext_callback_t *callback;
 	  netif_ext_callback_fn callback_fn;
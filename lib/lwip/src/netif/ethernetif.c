@@ -46,16 +46,15 @@
 
 #include "net80211/ieee80211_var.h"
 
-#ifdef CONFIG_SUPPORT_MTSMP
 #include "mtsmp.h"
-#endif
 
 /* Define those to better describe your network interface. */
 #define IFNAME0 'w'
 #define IFNAME1 'l'
 
 
-#ifndef CONFIG_FREEBSD_MBUF_DYNA_EXT
+/* The WLAN RX ring takes its buffers from the mbuf cache pool as well. */
+#if !defined(CONFIG_FREEBSD_MBUF_DYNA_EXT) && defined(CONFIG_WLAN)
 #define LOW_LEVEL_TRX_MEM_SHARE
 #endif
 
@@ -184,18 +183,7 @@ try_alloc:
 		return ERR_OK;
 	}
 
-#ifdef CONFIG_SUPPORT_MTSMP
-	if (m->m_pkthdr.len > PACKET_LEN_THR) {
-		if (tsmp_get_count(outcount) >= COUNT_NUM)
-			tsmp_set_count(outcount, 0);
-		if (!tsmp_valid(out[tsmp_get_count(outcount)])) {
-			tsmp_set_idx(m, tsmp_get_count(outcount) + 1);
-			tsmp_set_out(m, m_out, (void * )m);
-			tsmp_time_out(m, start_t);
-		}
-		tsmp_inc_count(outcount);
-	}
-#endif
+	mtsmp_start(m, MTSMP_TX_LWIP);
 
 	ifp->if_output(ifp, m, &dst, NULL);
 
@@ -274,13 +262,6 @@ ethernetif_input(struct netif *netif, struct mbuf *m)
 	p = low_level_input(netif, m);
 	/* if no packet could be read, silently ignore this */
 	if (p != NULL) {
-
-#ifdef CONFIG_SUPPORT_MTSMP
-		tsmp_time_in(m, end_t);
-		tsmp_set_idx(m, 0);
-		tsmp_clean_in(m);
-#endif
-
 		/* pass all packets to ethernet_input, which decides what packets it supports */
 		if (netif->input(p, netif) != ERR_OK) {
 			LWIP_DEBUGF(NETIF_DEBUG, ("ethernetif_input: IP input error\n"));
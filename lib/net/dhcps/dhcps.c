@@ -13,6 +13,9 @@
 #include <hal/kernel.h>
 #include <hal/console.h>
 #include <cmsis_os.h>
+#ifdef CONFIG_TWHEEL
+#include <twheel.h>
+#endif
 #include "lwip/opt.h"
 #include "lwip/stats.h"
 #include "lwip/mem.h"
@@ -59,7 +62,12 @@ bool dhcps_started = false;
 static struct udp_pcb *dhcps_pcb;
 /** track PCB ref count */
 static u8_t dhcps_pcb_refcount;
+#ifdef CONFIG_TWHEEL
+static struct twheel_timer dhcps_twheel;
+static struct twheel_timer *dhcps_timer = NULL;
+#else
 static osTimerId_t dhcps_timer = (osTimerId_t)NULL;
+#endif
 
 #define netif_dhcps_data(netif) ((struct dhcps*)netif_get_client_data(netif, dhcps_client_id))
 
@@ -299,8 +307,13 @@ void dhcps_cleanup(struct netif *netif)
 			netif_set_client_data(netif, dhcps_client_id, NULL);
 		}
 		if (dhcps_timer != NULL) {
+#ifdef CONFIG_TWHEEL
+			twheel_timer_stop(dhcps_timer);
+			dhcps_timer = NULL;
+#else
 			osTimerDelete(dhcps_timer);
 			dhcps_timer = (osTimerId_t)NULL;
+#endif
 		}
 	}
 }
@@ -313,9 +326,16 @@ dhcps_create(struct netif *netif)
 	if (dhcps_client_id == -1)
 		dhcps_client_id = netif_alloc_client_data_id();
 
-	if (dhcps_timer == NULL)
+	if (dhcps_timer == NULL) {
+#ifdef CONFIG_TWHEEL
+		twheel_timer_init(&dhcps_twheel, dhcps_coarse_tmr, netif,
+				TWHEEL_PERIODIC);
+		dhcps_timer = &dhcps_twheel;
+#else
 		dhcps_timer = osTimerNew(dhcps_coarse_tmr, osTimerPeriodic,
 				netif, NULL);
+#endif
+	}
 
 	if ((dhcps = netif_dhcps_data(netif)) == NULL) {
 		dhcps = (struct dhcps *)mem_malloc(sizeof(struct dhcps));
@@ -381,7 +401,11 @@ err_t dhcps_start(struct netif *netif)
 		return ERR_ARG;
 #endif
 
+#ifdef CONFIG_TWHEEL
+	twheel_timer_start(dhcps_timer, DHCP_COARSE_TIMER_MSECS);
+#else
 	osTimerStart(dhcps_timer, msecs_to_ticks(DHCP_COARSE_TIMER_MSECS));
+#endif
 
 
 	ip_addr_copy(dhcps->server_ip, *netif_ip_addr4(netif));
@@ -481,8 +505,13 @@ err_t dhcps_stop(struct netif *netif)
 		dhcps->pcb_allocated = 0;
 	}
 
+#ifdef CONFIG_TWHEEL
+	if (twheel_timer_is_running(dhcps_timer))
+		twheel_timer_stop(dhcps_timer);
+#else
 	if (osTimerIsRunning(dhcps_timer))
 		osTimerStop(dhcps_timer);
+#endif
 
 	return ERR_OK;
 }
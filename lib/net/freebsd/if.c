@@ -51,6 +51,8 @@
 #endif
 
 #include "cmsis_os.h"
+#include "ktrace.h"
+#include "mtsmp.h"
 
 /**
  * FIXME: remove this memo later
@@ -670,6 +672,8 @@ static void ether_input(struct ifnet *ifp, struct mbuf *m)
 {
 #ifdef CONFIG_LWIP
 	struct netif *netif = &ifp->etherif;
+
+	mtsmp_start(m, MTSMP_RX_DRV);
 	ethernetif_input(netif, m);
 #else
 	m_freem(m);
@@ -679,7 +683,9 @@ static void ether_input(struct ifnet *ifp, struct mbuf *m)
 #ifdef CONFIG_LWIP
 void ether_inputpbuf(struct ifnet *ifp, struct pbuf *p)
 {
+	ktrace_begin(KTRACE_ETHER_INPUT, p->tot_len);
 	ethernetif_inputpbuf(&ifp->etherif, p);
+	ktrace_end(KTRACE_ETHER_INPUT, 0);
 }
 #endif
 
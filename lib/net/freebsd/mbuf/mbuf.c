@@ -18,6 +18,19 @@
 #include "lwip/stats.h"
 
 #include "hal/types.h"
+#include "hal/rom.h"
+
+#ifdef CONFIG_FREEBSD_MBUF_PBUF_ZEROCOPY
+#include "lwip-glue.h"
+#include "lwip/def.h"
+#include "lwip/prot/ethernet.h"
+#include "lwip/prot/ip.h"
+#include "lwip/prot/ip4.h"
+#include "lwip/prot/icmp.h"
+
+static struct pbuf *m_topbuf_ref(struct mbuf *mb);
+static struct mbuf *m_frompbuf_ref(struct pbuf *p, int mhdrm);
+#endif
 
 int MSIZE 			= __MSIZE__;
 int MLEN			= __MLEN__;
@@ -139,8 +152,9 @@ _m_frompbuf(struct pbuf *p0, int mhdrm);
 __romfunc__ struct mbuf *
 (*m_frompbuf)(struct pbuf *p0, int mhdrm) = _m_frompbuf;
 
+/* Copy @p0 into a fresh mbuf chain, keeping the same headroom. */
 static struct mbuf *
-_m_frompbuf(struct pbuf *p0, int mhdrm)
+m_frompbuf_copy(struct pbuf *p0, int mhdrm)
 {
 	const struct pbuf *p;
 	struct mbuf *m;
@@ -174,6 +188,20 @@ _m_frompbuf(struct pbuf *p0, int mhdrm)
 	return m;
 }
 
+static struct mbuf *
+_m_frompbuf(struct pbuf *p0, int mhdrm)
+{
+#ifdef CONFIG_FREEBSD_MBUF_PBUF_ZEROCOPY
+	struct mbuf *m;
+
+	m = m_frompbuf_ref(p0, mhdrm);
+	if (m)
+		return m;
+#endif
+
+	return m_frompbuf_copy(p0, mhdrm);
+}
+
 static struct pbuf *
 _m_topbuf(struct mbuf *mb);
 
@@ -186,6 +214,12 @@ _m_topbuf(struct mbuf *mb)
 	struct pbuf *p, *q;
 	int len, totlen, offset;
 
+#ifdef CONFIG_FREEBSD_MBUF_PBUF_ZEROCOPY
+	p = m_topbuf_ref(mb);
+	if (p)
+		return p;
+#endif
+
   	/*
 	 * Obtain the size of the packet and put it into
 	 * the "totlen" variable.
@@ -349,16 +383,16 @@ _m_freem(struct mbuf *memoryBuffer)
 
 static void
 _m_dyna_extadd(struct mbuf *memoryBuffer, caddr_t buffer, u_int size,
-	m_ext_free_t freef, uint32_t arg1, uint32_t arg2, int flags, int type);
+	m_ext_free_t freef, uintptr_t arg1, uintptr_t arg2, int flags, int type);
 
 __romfunc__ void
 (*m_dyna_extadd)(struct mbuf *memoryBuffer, caddr_t buffer, u_int size,
-	m_ext_free_t freef, uint32_t arg1, uint32_t arg2, int flags,
+	m_ext_free_t freef, uintptr_t arg1, uintptr_t arg2, int flags,
 	int type) = _m_dyna_extadd;
 
 static void
 _m_dyna_extadd(struct mbuf *memoryBuffer, caddr_t buffer, u_int size,
-	m_ext_free_t freef, uint32_t arg1, uint32_t arg2, int flags, int type)
+	m_ext_free_t freef, uintptr_t arg1, uintptr_t arg2, int flags, int type)
 {
 	struct mbuf3 *mbuf = (struct mbuf3 *)memoryBuffer;
 
@@ -479,6 +513,15 @@ _m_free_ext(struct mbuf *memoryBuffer)
 		memp_free(MEMP_MBUF_EXT_NODE, memoryBuffer);
 #endif
 		break;
+#ifdef CONFIG_FREEBSD_MBUF_PBUF_ZEROCOPY
+	case EXT_PBUF:
+		memoryBuffer->m_ext.ext_free(memoryBuffer);
+		memoryBuffer->m_ext.ext_buf = NULL;
+#ifdef CONFIG_MEMP_NUM_MBUF_DYNA_EXT
+		memp_free(MEMP_MBUF_EXT_NODE, memoryBuffer);
+#endif
+		break;
+#endif
 	default:
 		printk("unknown type(%d)\n", memoryBuffer->m_ext.ext_type);
 		return -1;
@@ -610,3 +653,230 @@ m_topbuf_nofreem(struct mbuf *mb)
 
 	return p;
 }
+
+#ifdef CONFIG_FREEBSD_MBUF_PBUF_ZEROCOPY
+
+/*
+ * Zero-copy conversion between mbufs and pbufs.
+ *
+ * In the RX direction a single-segment mbuf is handed to lwIP as a custom
+ * PBUF_REF pbuf pointing at m_data; the mbuf is freed once lwIP frees the
+ * pbuf.  In the TX direction a single RAM or POOL pbuf with enough headroom
+ * for the driver is wrapped into an EXT_PBUF mbuf that holds a reference to
+ * the pbuf until the driver frees the mbuf.
+ *
+ * Anything else (chains, misaligned data, no wrapper available) makes the
+ * functions below return NULL, and the caller falls back to copying.
+ */
+
+#define M_ZEROCOPY_ALIGNED(ptr) \
+	(((uintptr_t)(ptr) & (CONFIG_FREEBSD_MBUF_PBUF_ZEROCOPY_ALIGN - 1)) == 0)
+
+static void
+m_pbuf_free(struct pbuf *p)
+{
+	struct m_pbuf *mp = (struct m_pbuf *)p;
+
+	m_freem(mp->m);
+	memp_free(MEMP_MBUF_PBUF, mp);
+}
+
+/*
+ * lwIP answers an ICMP echo request in the request's own pbuf, growing it
+ * back over the IP and link headers.  A PBUF_REF pbuf has no headroom to
+ * grow into, so the reply would only go out if icmp_input() copies the
+ * frame itself, and a shared frame must not be written to at all.  Such
+ * frames take the copy path instead; a pool pbuf has the room.
+ */
+static int
+m_pbuf_answered_in_place(struct mbuf *mb)
+{
+	const struct eth_hdr *eh = mtod(mb, const struct eth_hdr *);
+	const struct ip_hdr *iph;
+	const struct icmp_echo_hdr *ih;
+	u16_t hlen;
+
+	if (mb->m_len < SIZEOF_ETH_HDR + IP_HLEN
+			|| eh->type != PP_HTONS(ETHTYPE_IP))
+		return 0;
+
+	iph = (const struct ip_hdr *)((const u8_t *)eh + SIZEOF_ETH_HDR);
+	hlen = IPH_HL_BYTES(iph);
+	if (IPH_PROTO(iph) != IP_PROTO_ICMP
+			|| mb->m_len < (int)(SIZEOF_ETH_HDR + hlen + sizeof(*ih)))
+		return 0;
+
+	ih = (const struct icmp_echo_hdr *)((const u8_t *)iph + hlen);
+
+	return ICMPH_TYPE(ih) == ICMP_ECHO;
+}
+
+static struct pbuf *
+m_topbuf_ref(struct mbuf *mb)
+{
+	struct m_pbuf *mp;
+
+#if ETH_PAD_SIZE
+	/* No room for the padding word in front of the frame. */
+	return NULL;
+#endif
+
+	if (mb->m_next != NULL || !M_ZEROCOPY_ALIGNED(mb->m_data)
+			|| mb->m_len > 0xffff || m_pbuf_answered_in_place(mb))
+		return NULL;
+
+	mp = memp_malloc(MEMP_MBUF_PBUF);
+	if (mp == NULL)
+		return NULL;
+
+	mp->pc.custom_free_function = m_pbuf_free;
+	mp->m = mb;
+
+	return pbuf_alloced_custom(PBUF_RAW, mb->m_len, PBUF_REF, &mp->pc,
+			mb->m_data, mb->m_len);
+}
+
+static void
+m_pbuf_ext_free(struct mbuf *m)
+{
+	pbuf_free((struct pbuf *)m->m_ext.ext_arg1);
+}
+
+static struct mbuf *
+m_frompbuf_ref(struct pbuf *p, int mhdrm)
+{
+	struct mbuf *m;
+	int phdrm;
+
+	/* The payload must be ordinary RAM that outlives the pbuf reference,
+	 * i.e. not PBUF_ROM/PBUF_REF, and must have room for the driver
+	 * headers right in front of it. A custom pbuf is laid out and freed
+	 * by its owner, so the headroom cannot be worked out from it.
+	 */
+	if (p->next != NULL || !M_ZEROCOPY_ALIGNED(p->payload)
+			|| (p->flags & PBUF_FLAG_IS_CUSTOM))
+		return NULL;
+
+	if (!pbuf_match_allocsrc(p, PBUF_TYPE_ALLOC_SRC_MASK_STD_HEAP)
+			&& !pbuf_match_allocsrc(p, PBUF_TYPE_ALLOC_SRC_MASK_STD_MEMP_PBUF_POOL))
+		return NULL;
+
+	phdrm = (int)((u8_t *)p->payload - ((u8_t *)p + LWIP_MEM_ALIGN_SIZE(sizeof(struct pbuf))));
+	if (phdrm < mhdrm)
+		return NULL;
+
+	m = m_getexthdr(M_NOWAIT, MT_DATA);
+	if (m == NULL)
+		return NULL;
+
+	pbuf_ref(p);
+	m_dyna_extadd(m, (caddr_t)p->payload - phdrm, phdrm + p->len,
+			m_pbuf_ext_free, (uintptr_t)p, 0, 0, EXT_PBUF);
+	m->m_data += phdrm;
+	m->m_len = p->len;
+	m->m_pkthdr.len = p->len;
+
+	return m;
+}
+
+/*
+ * Share a received frame between lwIP and another consumer without copying
+ * it.  lwIP gets a PBUF_REF pbuf wrapping @mb as m_topbuf() would hand out,
+ * and *@mo is set to an EXT_PBUF mbuf that takes over the packet header of
+ * @mb and refers to the same frame, headroom included, by holding a
+ * reference to that pbuf.  @mb is freed once both have been freed.
+ *
+ * The frame itself is read-only to both sides from here on; the headroom
+ * belongs to *@mo, as lwIP never grows a PBUF_REF pbuf into it, and frames
+ * lwIP would answer in place are not shared.
+ * Returns NULL, leaving @mb untouched, if the frame cannot be shared.
+ */
+struct pbuf *
+m_topbuf_share(struct mbuf *mb, struct mbuf **mo)
+{
+	struct pbuf *p;
+	struct mbuf *m;
+	int lead;
+
+	if (!(mb->m_flags & M_PKTHDR))
+		return NULL;
+
+	p = m_topbuf_ref(mb);
+	if (p == NULL)
+		return NULL;
+
+	m = m_getexthdr(M_NOWAIT, MT_DATA);
+	if (m == NULL) {
+		/* Nothing refers to the wrapper yet. */
+		memp_free(MEMP_MBUF_PBUF, p);
+		return NULL;
+	}
+
+	lead = M_LEADINGSPACE(mb);
+
+	pbuf_ref(p);
+	m_dyna_extadd(m, mb->m_data - lead, lead + mb->m_len,
+			m_pbuf_ext_free, (uintptr_t)p, 0, 0, EXT_PBUF);
+	m->m_data += lead;
+	m->m_len = mb->m_len;
+	m_move_pkthdr(m, mb);
+
+	*mo = m;
+
+	return p;
+}
+
+/*
+ * The mbuf behind a pbuf handed out by m_topbuf(), or NULL if @p does not
+ * wrap one.
+ */
+struct mbuf *
+m_pbuf_getm(struct pbuf *p)
+{
+	struct pbuf_custom *pc = (struct pbuf_custom *)p;
+
+	if (!(p->flags & PBUF_FLAG_IS_CUSTOM)
+			|| pc->custom_free_function != m_pbuf_free)
+		return NULL;
+
+	return ((struct m_pbuf *)p)->m;
+}
+
+#ifdef CONFIG_LINK_TO_ROM
+
+/*
+ * m_topbuf and m_frompbuf live in ROM; patch them with versions that try
+ * the zero-copy path first and copy as the ROM ones do otherwise.
+ */
+
+static struct pbuf *
+patch_m_topbuf(struct mbuf *mb)
+{
+	struct pbuf *p;
+
+	p = m_topbuf_ref(mb);
+	if (p == NULL) {
+		p = m_topbuf_nofreem(mb);
+		m_freem(mb);
+	}
+
+	return p;
+}
+PATCH(m_topbuf, &m_topbuf, &patch_m_topbuf);
+
+static struct mbuf *
+patch_m_frompbuf(struct pbuf *p0, int mhdrm)
+{
+	struct mbuf *m;
+
+	m = m_frompbuf_ref(p0, mhdrm);
+	if (m)
+		return m;
+
+	return m_frompbuf_copy(p0, mhdrm);
+}
+PATCH(m_frompbuf, &m_frompbuf, &patch_m_frompbuf);
+
+#endif /* CONFIG_LINK_TO_ROM */
+
+#endif /* CONFIG_FREEBSD_MBUF_PBUF_ZEROCOPY */
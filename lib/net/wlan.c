@@ -182,6 +182,16 @@ int do_net_memp(int argc, char *argv[])
 	argc--;
 	argv++;
 
+#ifdef CONFIG_MEMP_ARENA
+	if (argc == 0) {
+		char buf[512];
+
+		memp_arena_stat(buf, sizeof(buf));
+		printf("%s", buf);
+		return 0;
+	}
+#endif
+
 #if MEMP_OWNER_CHECK
 	memp_check_owners(argv[0]);
 #endif
@@ -214,6 +224,6 @@ static int do_net(int argc, char *argv[])
 CMD(net, do_net,
 	"test routines for net (lwIP/net80211/driver)",
 	"net stats" OR
-	"net memp"
+	"net memp [pool]"
 );
 #endif
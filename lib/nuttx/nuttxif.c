@@ -17,6 +17,11 @@
 #include <hal/dma.h>
 #endif
 #include <hal/console.h>
+#ifdef CONFIG_NUTTX_IPC_RING
+#include <hal/cpu.h>
+#include <stdio.h>
+#include <cli.h>
+#endif
 #include "compat_param.h"
 #include "systm.h"
 #include "kernel.h"
@@ -33,6 +38,8 @@
 
 #include <net80211/ieee80211_var.h>
 
+#include "nuttxif.h"
+
 ipc_listener_t g_wlan_data_listener;
 
 #define WLAN_HDRLEN               76  /* HW HDR 28 + Qos HDR 26 + Cipher 8 + AMSDU HDR 14 */
@@ -104,44 +111,346 @@ inline void nuttx_rx_runtask(void) {
 
 }
 
+/*
+ * Copy the frame at the head of rx_queue into its own IPC payload.
+ * The frame is left queued if no payload is available.
+ */
 __ilm__ static
-void nuttx_rx_task(void *data, int pending)
+int nuttx_rx_copy(struct device *ipc_dev)
 {
-	struct device * ipc_dev = g_nx_rx.ipc_dev;
 	struct ifnet *ifp;
 	uint32_t len = CONFIG_NET_ETH_PKTSIZE;
 	struct mbuf *m;
 	ipc_payload_t *payload;
 
-	while((m = ifq_peek(&g_nx_rx.rx_queue))) {
-		len = len < m->m_pkthdr.len ? m->m_pkthdr.len : len;
-		payload = ipc_alloc(ipc_dev, len, true, false, IPC_MODULE_WLAN,
-			IPC_CHAN_DATA, IPC_TYPE_REQUEST);
+	m = ifq_peek(&g_nx_rx.rx_queue);
+	len = len < m->m_pkthdr.len ? m->m_pkthdr.len : len;
+	payload = ipc_alloc(ipc_dev, len, true, false, IPC_MODULE_WLAN,
+		IPC_CHAN_DATA, IPC_TYPE_REQUEST);
 
-		/* avoid drop this mbuf */
-		if (!payload) {
-			nuttx_rx_runtask();
-			return;
+	/* avoid drop this mbuf */
+	if (!payload)
+		return -ENOMEM;
+
+	m = ifq_dequeue(&g_nx_rx.rx_queue);
+
+	ifp = (struct ifnet *) m->m_pkthdr.rcvif;
+	if (ifp == g_wlan_ifnet[0]) {
+		IPC_SET_WLAN(payload->flag, 0);
+	} else {
+		IPC_SET_WLAN(payload->flag, 1);
+	}
+
+#ifdef CONFIG_IPC_DMA
+	if (nuttx_dma_copydata(m, m->m_pkthdr.len, (caddr_t)payload->data)) {
+		m_copydata(m, 0, m->m_pkthdr.len, (caddr_t)payload->data);
+	}
+#else
+	m_copydata(m, 0, m->m_pkthdr.len, (caddr_t)payload->data);
+#endif
+	m_freem(m);
+	ipc_transmit(ipc_dev, payload);
+
+	return 0;
+}
+
+#ifdef CONFIG_NUTTX_IPC_RING
+
+#define NUTTX_RING_SIZE		CONFIG_NUTTX_IPC_RING_SIZE
+#define NUTTX_RING_MASK		(NUTTX_RING_SIZE - 1)
+
+#if (NUTTX_RING_SIZE & NUTTX_RING_MASK)
+#error "CONFIG_NUTTX_IPC_RING_SIZE must be a power of two"
+#endif
+
+__ram_dma_desc__ __aligned(NUTTX_RING_LINE)
+static struct nuttx_ring g_nx_ring;
+
+struct nuttx_ring_ctx
+{
+	bool			active;
+	bool			kick;	/* descriptors posted, doorbell not sent yet */
+	volatile uint16_t	req;	/* request from the host, if any */
+	uint16_t		pending; /* OPEN or CLOSE waiting for RESET_ACK */
+	uint32_t		tx_prod;
+	uint32_t		cpl_cons;
+	uint32_t		kicked;	/* tx_prod at the last doorbell */
+	uint32_t		inflight;
+	struct mbuf		*lent[NUTTX_RING_SIZE];
+
+	/* statistics */
+	uint32_t		posted;
+	uint32_t		completed;
+	uint32_t		doorbells;
+	uint32_t		max_batch;
+	uint32_t		copied;
+	uint32_t		full;
+};
+
+static struct nuttx_ring_ctx g_nx_rctx;
+
+#define nuttx_ring_flush(s, e) \
+	dcache_flush_range((unsigned long)(s), (unsigned long)(e))
+#define nuttx_ring_inval(s, e) \
+	dcache_invalidate_range((unsigned long)(s), (unsigned long)(e))
+
+__ilm__ static
+int nuttx_ring_send(struct device *ipc_dev, uint16_t op, uint32_t arg)
+{
+	ipc_payload_t *payload;
+	struct nuttx_ring_msg *msg;
+
+	payload = ipc_alloc(ipc_dev, sizeof(*msg), true, false, IPC_MODULE_WLAN,
+		IPC_CHAN_DATA, IPC_TYPE_REQUEST);
+	if (!payload)
+		return -ENOMEM;
+
+	msg = (struct nuttx_ring_msg *)payload->data;
+	msg->magic = NUTTX_RING_MAGIC;
+	msg->op = op;
+	msg->rsvd = 0;
+	msg->arg = arg;
+
+	return ipc_transmit(ipc_dev, payload);
+}
+
+static void nuttx_ring_reset(void)
+{
+	struct nuttx_ring *r = &g_nx_ring;
+	struct nuttx_ring_ctx *ctx = &g_nx_rctx;
+	int i;
+
+	for (i = 0; i < NUTTX_RING_SIZE; i++) {
+		if (ctx->lent[i]) {
+			m_freem(ctx->lent[i]);
+			ctx->lent[i] = NULL;
 		}
-		else
-			m = ifq_dequeue(&g_nx_rx.rx_queue);
-
-		ifp = (struct ifnet *) m->m_pkthdr.rcvif;
-		if (ifp == g_wlan_ifnet[0]) {
-			IPC_SET_WLAN(payload->flag, 0);
-		} else {
-			IPC_SET_WLAN(payload->flag, 1);
+	}
+
+	ctx->tx_prod = ctx->cpl_cons = ctx->kicked = 0;
+	ctx->inflight = 0;
+	ctx->kick = false;
+
+	memset(r, 0, sizeof(*r));
+	r->magic = NUTTX_RING_MAGIC;
+	r->version = NUTTX_RING_VERSION;
+	r->size = NUTTX_RING_SIZE;
+	nuttx_ring_flush(r, r + 1);
+}
+
+/* Take back the buffers the host has completed. */
+__ilm__ static
+void nuttx_ring_reap(void)
+{
+	struct nuttx_ring *r = &g_nx_ring;
+	struct nuttx_ring_ctx *ctx = &g_nx_rctx;
+	uint32_t prod, slot;
+	struct mbuf *m;
+
+	nuttx_ring_inval(&r->tx_cons, &r->tx_cons + NUTTX_RING_LINE / 4);
+	prod = r->cpl_prod;
+	if (prod == ctx->cpl_cons)
+		return;
+
+	nuttx_ring_inval(&r->cpl[0], &r->cpl[NUTTX_RING_SIZE]);
+	while (ctx->cpl_cons != prod) {
+		slot = r->cpl[ctx->cpl_cons++ & NUTTX_RING_MASK] & NUTTX_RING_MASK;
+		m = ctx->lent[slot];
+		if (m) {
+			ctx->lent[slot] = NULL;
+			ctx->inflight--;
+			ctx->completed++;
+			m_freem(m);
 		}
+	}
 
-#ifdef CONFIG_IPC_DMA
-		if (nuttx_dma_copydata(m, m->m_pkthdr.len, (caddr_t)payload->data)) {
-			m_copydata(m, 0, m->m_pkthdr.len, (caddr_t)payload->data);
+	r->cpl_cons = ctx->cpl_cons;
+	nuttx_ring_flush(r, &r->tx_cons);
+}
+
+/*
+ * Act on OPEN/CLOSE/RESET_ACK from the host. Only the rx task touches the
+ * ring, so the IPC callback just records the request here.
+ */
+static int nuttx_ring_ctrl(struct device *ipc_dev)
+{
+	struct nuttx_ring_ctx *ctx = &g_nx_rctx;
+	uint16_t op = ctx->req;
+
+	if (!op)
+		return 0;
+
+	ctx->req = 0;
+
+	if (op == NUTTX_RING_RESET_ACK) {
+		if (!ctx->pending)
+			return 0;
+		op = ctx->pending;
+	} else {
+		ctx->active = false;
+		if (ctx->inflight)
+			nuttx_ring_reap();
+		if (ctx->inflight) {
+			/* The host still has some; reclaim them once it lets go. */
+			if (nuttx_ring_send(ipc_dev, NUTTX_RING_RESET, ctx->tx_prod)) {
+				ctx->req = op;
+				return -ENOMEM;
+			}
+			ctx->pending = op;
+			return 0;
 		}
-#else
-		m_copydata(m, 0, m->m_pkthdr.len, (caddr_t)payload->data);
+	}
+
+	ctx->pending = 0;
+	nuttx_ring_reset();
+
+	if (op == NUTTX_RING_OPEN) {
+		if (nuttx_ring_send(ipc_dev, NUTTX_RING_READY, (uint32_t)&g_nx_ring)) {
+			ctx->req = op;
+			return -ENOMEM;
+		}
+		ctx->active = true;
+	}
+
+	return 0;
+}
+
+/* Publish tx_prod and ring the doorbell once for everything posted. */
+__ilm__ static
+int nuttx_ring_kick(struct device *ipc_dev)
+{
+	struct nuttx_ring *r = &g_nx_ring;
+	struct nuttx_ring_ctx *ctx = &g_nx_rctx;
+
+	if (!ctx->kick)
+		return 0;
+
+	r->tx_prod = ctx->tx_prod;
+	nuttx_ring_flush(r, &r->tx_cons);
+
+	if (nuttx_ring_send(ipc_dev, NUTTX_RING_KICK, ctx->tx_prod))
+		return -ENOMEM;
+
+	ctx->max_batch = max(ctx->max_batch, ctx->tx_prod - ctx->kicked);
+	ctx->kicked = ctx->tx_prod;
+	ctx->kick = false;
+	ctx->doorbells++;
+
+	return 0;
+}
+
+__ilm__ static
+void nuttx_ring_rx(struct device *ipc_dev)
+{
+	struct nuttx_ring *r = &g_nx_ring;
+	struct nuttx_ring_ctx *ctx = &g_nx_rctx;
+	struct nuttx_ring_desc *d;
+	struct mbuf *m;
+	uint32_t slot, batch = 0;
+
+	nuttx_ring_reap();
+
+	while ((m = ifq_peek(&g_nx_rx.rx_queue))) {
+		if (m->m_next) {
+			/*
+			 * Chained frames are rare; copy them as before, after
+			 * ringing for what is already posted so that the host
+			 * still sees frames in order.
+			 */
+			if (nuttx_ring_kick(ipc_dev) || nuttx_rx_copy(ipc_dev))
+				goto retry;
+			ctx->copied++;
+			batch = 0;
+			continue;
+		}
+
+		slot = ctx->tx_prod & NUTTX_RING_MASK;
+		if (ctx->lent[slot]) {
+			/* The host's completion doorbell restarts us. */
+			ctx->full++;
+			break;
+		}
+
+		m = ifq_dequeue(&g_nx_rx.rx_queue);
+
+		d = &r->desc[slot];
+		d->addr = mtod(m, uint32_t);
+		d->len = m->m_len;
+		d->wlan = (m->m_pkthdr.rcvif == g_wlan_ifnet[0]) ? 0 : 1;
+		d->flags = 0;
+		nuttx_ring_flush(d->addr, d->addr + d->len);
+		nuttx_ring_flush(d, d + 1);
+
+		ctx->lent[slot] = m;
+		ctx->tx_prod++;
+		ctx->inflight++;
+		ctx->posted++;
+		ctx->kick = true;
+
+		if (++batch == CONFIG_NUTTX_IPC_RING_BATCH) {
+			if (nuttx_ring_kick(ipc_dev))
+				goto retry;
+			batch = 0;
+		}
+	}
+
+	if (!nuttx_ring_kick(ipc_dev))
+		return;
+
+retry:
+	nuttx_rx_runtask();
+}
+
+/* A ring message has exactly this size and carries the magic. */
+static inline bool nuttx_ring_is_msg(ipc_payload_t *payload)
+{
+	struct nuttx_ring_msg *msg = (struct nuttx_ring_msg *)payload->data;
+
+	return payload->size == sizeof(*msg) && msg->magic == NUTTX_RING_MAGIC;
+}
+
+__ilm__ static
+void nuttx_ring_recvd(struct nuttx_ring_msg *msg)
+{
+	switch (msg->op) {
+	case NUTTX_RING_OPEN:
+	case NUTTX_RING_CLOSE:
+	case NUTTX_RING_RESET_ACK:
+		g_nx_rctx.req = msg->op;
+		break;
+	case NUTTX_RING_KICK:
+		break;
+	default:
+		return;
+	}
+
+	nuttx_rx_runtask();
+}
+
+#endif /* CONFIG_NUTTX_IPC_RING */
+
+__ilm__ static
+void nuttx_rx_task(void *data, int pending)
+{
+	struct device * ipc_dev = g_nx_rx.ipc_dev;
+
+#ifdef CONFIG_NUTTX_IPC_RING
+	if (nuttx_ring_ctrl(ipc_dev)) {
+		nuttx_rx_runtask();
+		return;
+	}
+
+	if (g_nx_rctx.active) {
+		nuttx_ring_rx(ipc_dev);
+		return;
+	}
 #endif
-		m_freem(m);
-		ipc_transmit(ipc_dev, payload);
+
+	while (ifq_peek(&g_nx_rx.rx_queue)) {
+		if (nuttx_rx_copy(ipc_dev)) {
+			nuttx_rx_runtask();
+			return;
+		}
 	}
 
 }
@@ -191,6 +500,14 @@ static int nuttx_ipc_data_recvd(ipc_payload_t *payload, void *priv)
 	struct device *dev = (struct device *)priv;
 	struct ieee80211vap *vap;
 
+#ifdef CONFIG_NUTTX_IPC_RING
+	if (nuttx_ring_is_msg(payload)) {
+		nuttx_ring_recvd((struct nuttx_ring_msg *)payload->data);
+		ipc_free(dev, payload);
+		return 0;
+	}
+#endif
+
 	if (IPC_GET_WLAN(payload->flag) == 0) {
 		ifp = g_wlan_ifnet[0];
 		vap = ifp->if_softc;
@@ -211,7 +528,7 @@ static int nuttx_ipc_data_recvd(ipc_payload_t *payload, void *priv)
 	}
 
 	m_dyna_extadd(m, (caddr_t)(payload->data), payload->size,
-		mbuf_ipc_free, (u32)payload, (u32)dev, 0, EXT_IPCRING);
+		mbuf_ipc_free, (uintptr_t)payload, (uintptr_t)dev, 0, EXT_IPCRING);
 	m->m_data += WLAN_HDRLEN;
 	m->m_len = *(uint16_t *)payload->data;
 
@@ -312,3 +629,28 @@ nuttx_ifdetach(struct ifnet *ifp)
 		g_wlan_ifnet[1] = NULL;
 	}
 }
+
+#ifdef CONFIG_NUTTX_IPC_RING
+
+static int do_nxring(int argc, char *argv[])
+{
+	struct nuttx_ring_ctx *ctx = &g_nx_rctx;
+
+	printf("state    : %s\n", ctx->active ? "active" : "copy");
+	printf("ring     : %p, %d slots, batch %d\n", &g_nx_ring,
+			NUTTX_RING_SIZE, CONFIG_NUTTX_IPC_RING_BATCH);
+	printf("tx_prod  : %u, cpl_cons %u, inflight %u\n",
+			ctx->tx_prod, ctx->cpl_cons, ctx->inflight);
+	printf("posted   : %u, completed %u\n", ctx->posted, ctx->completed);
+	printf("doorbell : %u (max batch %u)\n", ctx->doorbells, ctx->max_batch);
+	printf("copied   : %u, ring full %u\n", ctx->copied, ctx->full);
+
+	return 0;
+}
+
+CMD(nxring, do_nxring,
+	"show NuttX data ring statistics",
+	"nxring"
+);
+
+#endif
@@ -16,8 +16,87 @@
 void nuttx_ifattach(struct ifnet *ifp);
 void nuttx_ifdetach(struct ifnet *ifp);
 
-#ifdef CONFIG_IPC_DMA
-void nuttx_rx_runtask(void);
-#endif
+#ifdef CONFIG_NUTTX_IPC_RING
+
+#include <stdint.h>
+
+/*
+ * Zero-copy Wi-Fi to host data path.
+ *
+ * Instead of copying each received frame into an IPC payload, WISE lends
+ * the mbuf holding the frame to the host through a descriptor ring that
+ * lives in shared SRAM, and the host hands the slot back through a
+ * completion ring once it is done with the buffer.  Both rings are
+ * single-producer/single-consumer and indices are free running; a slot
+ * is (index & (size - 1)).
+ *
+ * Control messages travel on IPC_CHAN_DATA as struct nuttx_ring_msg.
+ * A payload is one only if it has exactly that size and starts with
+ * NUTTX_RING_MAGIC; anything else is data.
+ *
+ *   host -> WISE  OPEN       ask for a (new) ring, arg is ignored
+ *   WISE -> host  READY      arg is the address of struct nuttx_ring
+ *   WISE -> host  KICK       new descriptors, arg is tx_prod
+ *   host -> WISE  KICK       new completions, arg is cpl_prod
+ *   host -> WISE  CLOSE      go back to copying frames into IPC payloads
+ *   WISE -> host  RESET      answer to OPEN or CLOSE while buffers are
+ *                            still lent, arg is tx_prod; the host must
+ *                            drop every descriptor it holds
+ *   host -> WISE  RESET_ACK  the host holds no descriptor any more and
+ *                            will not touch the old ring again
+ *
+ * Lent buffers are reclaimed, and the ring is reset, only once the host
+ * has nothing lent or has acknowledged the reset.
+ *
+ * The host must mirror this layout exactly.
+ */
+
+#define NUTTX_RING_MAGIC	0x4e58524eU	/* "NRXN" */
+#define NUTTX_RING_VERSION	2
+#define NUTTX_RING_LINE		32	/* D-cache line size */
+
+enum nuttx_ring_op {
+	NUTTX_RING_OPEN		= 1,
+	NUTTX_RING_READY	= 2,
+	NUTTX_RING_KICK		= 3,
+	NUTTX_RING_CLOSE	= 4,
+	NUTTX_RING_RESET	= 5,
+	NUTTX_RING_RESET_ACK	= 6,
+};
+
+struct nuttx_ring_msg {
+	uint32_t magic;
+	uint16_t op;
+	uint16_t rsvd;
+	uint32_t arg;
+};
+
+struct nuttx_ring_desc {
+	uint32_t addr;		/* start of the Ethernet frame */
+	uint16_t len;		/* frame length */
+	uint8_t  wlan;		/* interface index, as IPC_GET_WLAN() */
+	uint8_t  flags;
+};
+
+struct nuttx_ring {
+	/* Written by WISE only. */
+	uint32_t magic;
+	uint16_t version;
+	uint16_t size;		/* number of slots, power of two */
+	volatile uint32_t tx_prod;
+	volatile uint32_t cpl_cons;
+	uint8_t  pad0[NUTTX_RING_LINE - 16];
+
+	/* Written by the host only. */
+	volatile uint32_t tx_cons;
+	volatile uint32_t cpl_prod;
+	uint8_t  pad1[NUTTX_RING_LINE - 8];
+
+	struct nuttx_ring_desc desc[CONFIG_NUTTX_IPC_RING_SIZE];
+	/* Slot number of each descriptor the host is done with. */
+	volatile uint32_t cpl[CONFIG_NUTTX_IPC_RING_SIZE];
+};
+
+#endif /* CONFIG_NUTTX_IPC_RING */
 
 #endif	/* __NUTTXIF_H__ */
@@ -0,0 +1,167 @@
+/*
+ * Copyright 2024-2024 Senscomm Semiconductor Co., Ltd.	All rights reserved.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <FreeRTOS/FreeRTOS.h>
+#include <FreeRTOS/task.h>
+
+#include <string.h>
+
+#include <hal/kernel.h>
+#include <hal/compiler.h>
+#include <hal/irq.h>
+#include <hal/timer.h>
+#include <proc.h>
+
+/*
+ * CPU time accounting.
+ *
+ * Every return from trap (see portASM.S) calls cpu_acct_switch(), which
+ * notices a context switch by comparing pxCurrentTCB with the task seen
+ * last time, and charges the time since the previous switch, minus the
+ * time spent in interrupt handlers meanwhile (irq_time, kept by the
+ * interrupt dispatcher), to the task that was switched out.
+ *
+ * Per task totals are kept in a small open addressed table keyed by the
+ * task handle, in ktime() ticks.
+ */
+
+#define ACCT_SLOTS	CONFIG_CPU_ACCT_TASKS
+
+struct task_acct {
+	void *task;
+	u64 run;
+};
+
+extern void * volatile pxCurrentTCB;
+
+static struct task_acct acct_tab[ACCT_SLOTS];
+static u64 acct_irq;		/* irq_time folded in at the last switch */
+static void *acct_cur;
+static u32 acct_ts;
+static u32 acct_irq_at;
+
+static __ilm__ struct task_acct *acct_slot(void *task, bool create)
+{
+	u32 h = ((u32)task >> 3) % ACCT_SLOTS;
+	int i;
+
+	for (i = 0; i < ACCT_SLOTS; i++) {
+		struct task_acct *a = &acct_tab[(h + i) % ACCT_SLOTS];
+
+		if (a->task == task)
+			return a;
+		if (a->task == NULL) {
+			if (!create)
+				return NULL;
+			a->task = task;
+			a->run = 0;
+			return a;
+		}
+	}
+
+	return NULL;
+}
+
+/* Time since the last switch, interrupts excluded; called with irqs off. */
+static __ilm__ u32 acct_pending(u32 now, u32 irq)
+{
+	return (now - acct_ts) - (irq - acct_irq_at);
+}
+
+__ilm__ void cpu_acct_switch(void)
+{
+	struct task_acct *a;
+	void *cur = pxCurrentTCB;
+	u32 now, irq;
+
+	if (cur == acct_cur)
+		return;
+
+	now = ktime();
+	irq = irq_time;
+
+	if (acct_cur) {
+		/* Tasks that do not fit in the table are not accounted. */
+		a = acct_slot(acct_cur, true);
+		if (a)
+			a->run += acct_pending(now, irq);
+	}
+	acct_irq += irq - acct_irq_at;
+
+	acct_cur = cur;
+	acct_ts = now;
+	acct_irq_at = irq;
+}
+
+static u64 acct_to_us(u64 t)
+{
+	return t * (1000000 / time_hz);
+}
+
+/**
+ * task_cpu_time() - run time of @task in usec, interrupt handlers excluded
+ */
+u64 task_cpu_time(thread_t task)
+{
+	struct task_acct *a;
+	unsigned long flags;
+	u64 run = 0;
+
+	local_irq_save(flags);
+	a = acct_slot(task, false);
+	if (a)
+		run = a->run;
+	if (task == acct_cur)
+		run += acct_pending(ktime(), irq_time);
+	local_irq_restore(flags);
+
+	return acct_to_us(run);
+}
+
+/**
+ * irq_cpu_time() - time spent in interrupt handlers in usec
+ */
+u64 irq_cpu_time(void)
+{
+	unsigned long flags;
+	u64 irq;
+
+	local_irq_save(flags);
+	irq = acct_irq + (irq_time - acct_irq_at);
+	local_irq_restore(flags);
+
+	return acct_to_us(irq);
+}
+
+/**
+ * task_cpu_time_prune() - forget tasks that are not in @tasks any more
+ */
+void task_cpu_time_prune(threadinfo_t *tasks, int n)
+{
+	struct task_acct keep[ACCT_SLOTS];
+	unsigned long flags;
+	int i, j;
+
+	local_irq_save(flags);
+	memcpy(keep, acct_tab, sizeof(keep));
+	memset(acct_tab, 0, sizeof(acct_tab));
+	for (i = 0; i < ACCT_SLOTS; i++) {
+		if (keep[i].task == NULL)
+			continue;
+		for (j = 0; j < n; j++)
+			if (tasks[j].xHandle == keep[i].task)
+				break;
+		if (j < n)
+			acct_slot(keep[i].task, true)->run = keep[i].run;
+	}
+	local_irq_restore(flags);
+}
@@ -372,6 +372,9 @@ CMD(memcmp, do_memcmp,
 #ifdef CONFIG_CMD_HEAP
 #include <string.h>
 #include "cmsis_os.h"
+#ifdef CONFIG_MEMP_ARENA
+#include "lwip/memp.h"
+#endif
 
 int do_heap(int argc, char *argv[])
 {
@@ -384,6 +387,15 @@ int do_heap(int argc, char *argv[])
 #endif
 		printf("Free:\t\t%12ld B\n", (long)osKernelGetFreeHeapSize());
 		printf("Total:  \t%12ld B\n", (long)configTOTAL_HEAP_SIZE);
+#ifdef CONFIG_MEMP_ARENA
+		do {
+			char buf[512];
+
+			/* The packet buffer arena comes out of the heap. */
+			memp_arena_stat(buf, sizeof(buf));
+			printf("%s", buf);
+		} while (0);
+#endif
 	} else if (!strcmp(argv[0], "list")) {
 #ifdef CONFIG_USE_MALLOC_DEBUG
 extern void vPortMemoryScan( void );
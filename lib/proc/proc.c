@@ -122,6 +122,13 @@ int show_irq(int argc, char *argv[])
 {
 	char buf[1024];
 
+#ifdef CONFIG_CPU_ACCT
+	if (argc > 1 && !strcmp(argv[1], "-h")) {
+		get_irq_hist(buf, sizeof(buf));
+		fputs(buf, stdout);
+		return CMD_RET_SUCCESS;
+	}
+#endif
 	get_irq_stat(buf, sizeof(buf));
 	fputs(buf, stdout);
 #if (CONFIG_NR_SW_IRQ > 0)
@@ -133,7 +140,11 @@ int show_irq(int argc, char *argv[])
 
 CMD(irq, show_irq,
 	"display irq information",
+#ifdef CONFIG_CPU_ACCT
+	"irq [-h]"
+#else
 	"irq"
+#endif
 );
 #endif /* CONFIG_CMD_IRQ */
 
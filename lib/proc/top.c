@@ -60,6 +60,29 @@ static void ddhhmmss(long seconds, struct xtime *time) {
 	time->ss = seconds;
 };
 
+#ifdef CONFIG_CPU_ACCT
+/*
+ * With CONFIG_CPU_ACCT, %CPU+ is the share of the last interval and
+ * TIME+ the usec total, both with interrupt time taken out of tasks.
+ */
+struct top_acct {
+	thread_t task;
+	uint64_t us;
+};
+
+/* usec run by @task since it was last seen in @prev */
+static uint64_t top_delta(struct top_acct *prev, int n, thread_t task, uint64_t us)
+{
+	int i;
+
+	for (i = 0; i < n; i++)
+		if (prev[i].task == task)
+			return us - prev[i].us;
+
+	return us;
+}
+#endif
+
 static int do_top(int argc, char *argv[])
 {
 	TaskStatus_t *table, *task;
@@ -69,6 +92,11 @@ static int do_top(int argc, char *argv[])
 	unsigned long ratio;
 	uint32_t jiffies;
 	struct xtime time;
+#ifdef CONFIG_CPU_ACCT
+	struct top_acct *prev = NULL, *cur;
+	int n_prev = 0;
+	uint64_t irq_prev = 0, irq_now, total;
+#endif
 
 	optind = 1;
 	while ((opt = getopt(argc, argv, "d:")) != -1) {
@@ -91,6 +119,25 @@ static int do_top(int argc, char *argv[])
 
 		n_task = uxTaskGetSystemState(table, n_task, &jiffies);
 
+#ifdef CONFIG_CPU_ACCT
+		cur = malloc(n_task * sizeof(*cur));
+		if (!cur) {
+			vPortFree(table);
+			free(prev);
+			return CMD_RET_FAILURE;
+		}
+
+		irq_now = irq_cpu_time();
+		total = irq_now - irq_prev;
+		for (i = 0; i < n_task; i++) {
+			cur[i].task = table[i].xHandle;
+			cur[i].us = task_cpu_time(cur[i].task);
+			total += top_delta(prev, n_prev, cur[i].task, cur[i].us);
+		}
+		if (total == 0)
+			total = 1;
+#endif
+
 		ddhhmmss(tick_to_second(jiffies), &time);
 
 		/* Print heading */
@@ -101,14 +148,25 @@ static int do_top(int argc, char *argv[])
 			   (unsigned long) configTOTAL_HEAP_SIZE/1024,
 			   (unsigned long) xPortGetFreeHeapSize()/1024);
 
+#ifdef CONFIG_CPU_ACCT
+		ratio = (irq_now - irq_prev) * 1000 / total;
+		printf("Irq: %3lu.%1d%% cpu, %llu us total\n",
+			   ratio / 10, (int) ratio % 10, irq_now);
+#endif
+
 		printf("\n\x1b[7m%4s%5s%6s%3s%7s%11s   %-44s\x1b[0m\n",
 			   "PID", "PR", "STWM", "S", "%CPU+", "TIME+", "TASK");
 
 		for (i = 0; i < n_task; i++) {
 			task = table + i;
 
+#ifdef CONFIG_CPU_ACCT
+			ratio = top_delta(prev, n_prev, cur[i].task, cur[i].us) * 1000 / total;
+			ddhhmmss(cur[i].us / 1000000, &time);
+#else
 			ratio = ((uint64_t)task->ulRunTimeCounter) * 1000 / jiffies;
 			ddhhmmss(tick_to_second(task->ulRunTimeCounter), &time);
+#endif
 
 			printf("%4lu%5lu%6d%3s%5lu.%1d%5d:%02d:%02d   "FMT"\n",
 				   task->xTaskNumber,
@@ -127,12 +185,22 @@ static int do_top(int argc, char *argv[])
 			   "\x1b[u",
 			   n_task, stat[0] + stat[1], stat[3], stat[2]);
 
+#ifdef CONFIG_CPU_ACCT
+		task_cpu_time_prune(table, n_task);
+		free(prev);
+		prev = cur;
+		n_prev = n_task;
+		irq_prev = irq_now;
+#endif
 		vPortFree(table);
 
 		/* Can we detect the serial input? */
 		c = getchar_timeout(interval);
 		if (c >= 0) {
 			ungetc(c, stdin);
+#ifdef CONFIG_CPU_ACCT
+			free(prev);
+#endif
 			return CMD_RET_SUCCESS;
 		}
 	}
@@ -151,8 +219,15 @@ static void print_task_info(threadinfo_t *ti, uint32_t *jiffies, void *data)
 	struct xtime time;
 	unsigned long ratio;
 
+#ifdef CONFIG_CPU_ACCT
+	uint64_t us = task_cpu_time(ti->xHandle);
+
+	ratio = us * 1000 / *(uint64_t *)data;
+	ddhhmmss(us / 1000000, &time);
+#else
 	ratio = ((uint64_t)ti->ulRunTimeCounter) * 1000 / *jiffies;
 	ddhhmmss(tick_to_second(ti->ulRunTimeCounter), &time);
+#endif
 
 	printf("%4lu%5lu%6d%3s%5lu.%1d%5d:%02d:%02d "FMT" (0x%x-0x%x, 0x%x)""\n",
 	       ti->xTaskNumber,
@@ -177,13 +252,29 @@ static int do_ps(int argc, char *argv[])
 	uint32_t jiffies;
 	threadinfo_t info[20];
 	int nr_task = sizeof(info)/sizeof(info[0]);
+#ifdef CONFIG_CPU_ACCT
+	uint64_t total;
+	int i;
+#endif
 
 	nr_task = uxTaskGetSystemState(info, nr_task, &jiffies);
 
+#ifdef CONFIG_CPU_ACCT
+	total = irq_cpu_time();
+	for (i = 0; i < nr_task; i++)
+		total += task_cpu_time(info[i].xHandle);
+	if (total == 0)
+		total = 1;
+#endif
+
 	printf("%4s%5s%6s%3s%7s%11s   %-44s\n",
 	       "PID", "PR", "STWM", "S", "%CPU+", "TIME+", "TASK");
 
+#ifdef CONFIG_CPU_ACCT
+	iterate_task(print_task_info, &jiffies, &total);
+#else
 	iterate_task(print_task_info, &jiffies, NULL);
+#endif
 
 	return 0;
 }
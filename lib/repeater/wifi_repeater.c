@@ -35,6 +35,7 @@
 #define IPv4BUF ((const struct ip_hdr *)mtodo(m, ETHER_HDR_LEN))
 #define UDPIPv4BUF(iphdr) ((const struct udp_hdr *)mtodo(m, (ETHER_HDR_LEN + (iphdr))))
 #define TCPIPv4BUF(iphdr) ((const struct tcp_hdr *)mtodo(m, (ETHER_HDR_LEN + (iphdr))))
+#define IPv6BUF ((const struct ip6_hdr *)mtodo(m, ETHER_HDR_LEN))
 
 #define swap_portnum(x) ((((x)&0xff00) >> 8) | (((x)&0x00ff) << 8))
 #define swap_ipaddr(x) ((((x)&0xff000000) >> 24) | (((x)&0x00ff0000) >> 8) | (((x)&0x0000ff00) << 8) | (((x)&0x000000ff) << 24))
@@ -63,6 +64,8 @@
 #define REPEATER_IS_HOST_CARRIER_ON() repeater_ctx.host_carrier_on
 typedef void (*interface_inputpbuf)(struct ifnet *ifp, struct pbuf *p);
 
+struct repeater_cls;
+
 extern void ether_inputpbuf(struct ifnet *ifp, struct pbuf *p);
 
 struct wifi_filter_config {
@@ -73,10 +76,12 @@ struct wifi_filter_config {
 	int max_ipv4_num;
 	int ipv4_used;
 	struct wifi_ipv4_filter *ipv4_filters;
+	struct repeater_cls *cls;	/* compiled ipv4_filters */
 #ifdef CONFIG_SUPPORT_REPEATER_IPV6
 	int max_ipv6_num;
 	int ipv6_used;
 	struct wifi_ipv6_filter *ipv6_filters;
+	struct repeater_cls *cls6;	/* compiled ipv6_filters */
 #endif
 };
 
@@ -145,6 +150,746 @@ static void filter_mtx_free(void)
 	mtx_destroy(&filter_mtx);
 }
 
+/*
+ * Compiled filter classifier
+ *
+ * Every time a filter table changes it is compiled into a read-only
+ * snapshot (struct repeater_cls) in which each rule is indexed exactly once:
+ *
+ *  - a rule with an exact local port (or, failing that, an exact remote
+ *    port) and no range on that side is hashed on (side, protocol, port),
+ *  - a rule with a local (or remote) port range goes into an interval list
+ *    sorted by the low end of the range,
+ *  - anything else (source IP and/or protocol only) is a wildcard rule.
+ *
+ * A packet probes each structure and the lowest matching rule index wins,
+ * which gives the same result as walking the table in order.  An LRU cache
+ * of recent flows sits in front of all this, so established flows are
+ * classified with a single hash lookup.  IPv4 and IPv6 filters are compiled
+ * into separate snapshots but share the rule semantics.
+ *
+ * The RX path never sees a half-built snapshot: a new one is compiled next
+ * to the current one and swapped in with interrupts disabled, and whoever
+ * drops the last reference to the old one frees it.  The flow cache is
+ * only touched from repeater_input(), i.e. from the wlan RX context.
+ */
+
+#ifdef CONFIG_SUPPORT_REPEATER_IPV6
+#define CLS_ADDR_WORDS		(WIFI_IPV6_ADDR_LEN / 4)
+#if CONFIG_SUPPORT_WIFI_REPEATER_IPV6_CNT > CONFIG_SUPPORT_WIFI_REPEATER_IPV4_CNT
+#define CLS_MAX_RULES		CONFIG_SUPPORT_WIFI_REPEATER_IPV6_CNT
+#else
+#define CLS_MAX_RULES		CONFIG_SUPPORT_WIFI_REPEATER_IPV4_CNT
+#endif
+#else
+#define CLS_ADDR_WORDS		1
+#define CLS_MAX_RULES		CONFIG_SUPPORT_WIFI_REPEATER_IPV4_CNT
+#endif
+
+#define CLS_NIL			0xffff
+#define CLS_HASH_BITS		6
+#define CLS_HASH_SIZE		(1 << CLS_HASH_BITS)
+#define CLS_PROTO_ANY		0x100
+
+#define CLS_KEY(remote, proto, port) \
+	(((uint32_t)(remote) << 25) | ((uint32_t)(proto) << 16) | (port))
+
+/* What the compiled rule checks, see cls_rule_match(). */
+#define CLS_F_IP		0x01
+#define CLS_F_PROTO		0x02
+#define CLS_F_LPORT		0x04	/* some local port condition */
+#define CLS_F_LRANGE		0x08
+#define CLS_F_RPORT		0x10	/* some remote port condition */
+#define CLS_F_RRANGE		0x20
+#define CLS_F_HASHED		0x40	/* indexed in the port hash */
+
+struct cls_rule {
+	uint32_t ip[CLS_ADDR_WORDS];	/* network order */
+	uint16_t lport, lmin, lmax;
+	uint16_t rport, rmin, rmax;
+	uint8_t proto;
+	uint8_t flags;
+	uint8_t dir;
+};
+
+struct cls_ival {
+	uint16_t lo, hi;
+	uint16_t maxhi;		/* max(hi) over this and all lower entries */
+	uint16_t rule;
+};
+
+struct cls_pkt {
+	uint32_t src[CLS_ADDR_WORDS];	/* network order */
+	uint32_t dst[CLS_ADDR_WORDS];
+	uint16_t sport, dport;
+	uint8_t proto;
+	uint8_t has_ports;
+};
+
+#if CONFIG_WIFI_REPEATER_FLOW_CACHE_CNT > 0
+#define CLS_FLOW_NIL		0xff
+#define CLS_FLOW_HASH_BITS	4
+#define CLS_FLOW_HASH_SIZE	(1 << CLS_FLOW_HASH_BITS)
+
+struct cls_flow {
+	struct cls_pkt key;
+	uint8_t dir;
+	uint8_t hnext;
+	uint8_t prev, next;	/* LRU list, most recent first */
+};
+#endif
+
+struct repeater_cls {
+	int ref;
+	wifi_filter_type type;
+	int nrules;
+	struct cls_rule rules[CLS_MAX_RULES];
+	uint32_t keys[CLS_MAX_RULES];
+	uint16_t hnext[CLS_MAX_RULES];
+	uint16_t heads[CLS_HASH_SIZE];
+	struct cls_ival livals[CLS_MAX_RULES];
+	struct cls_ival rivals[CLS_MAX_RULES];
+	uint16_t wild[CLS_MAX_RULES];
+	int nlivals, nrivals, nwild;
+#if CONFIG_WIFI_REPEATER_FLOW_CACHE_CNT > 0
+	struct cls_flow flows[CONFIG_WIFI_REPEATER_FLOW_CACHE_CNT];
+	uint8_t fheads[CLS_FLOW_HASH_SIZE];
+	uint8_t lru_head, lru_tail;
+	int nflows;
+	uint32_t hits, misses;
+#endif
+};
+
+static inline uint32_t cls_hash(uint32_t v, int bits)
+{
+	return (v * 0x9e3779b1) >> (32 - bits);
+}
+
+/* The port and protocol fields, which are the same in both filter types */
+struct cls_port_cond {
+	uint8_t mask;		/* WIFI_FILTER_MASK_xxx */
+	uint8_t dir;
+	uint8_t proto;
+	uint16_t lport, lmin, lmax;
+	uint16_t rport, rmin, rmax;
+};
+
+static void cls_compile_ports(struct cls_rule *r, const struct cls_port_cond *c)
+{
+	r->dir = c->dir;
+	if (c->mask & WIFI_FILTER_MASK_PROTOCOL) {
+		r->flags |= CLS_F_PROTO;
+		r->proto = c->proto;
+	}
+	if (c->mask & (WIFI_FILTER_MASK_LOCAL_PORT | WIFI_FILTER_MASK_LOCAL_PORT_RANGE)) {
+		r->flags |= CLS_F_LPORT;
+		r->lport = c->lport;
+		if (c->mask & WIFI_FILTER_MASK_LOCAL_PORT_RANGE) {
+			r->flags |= CLS_F_LRANGE;
+			r->lmin = c->lmin;
+			r->lmax = c->lmax;
+		}
+	}
+	if (c->mask & (WIFI_FILTER_MASK_REMOTE_PORT | WIFI_FILTER_MASK_REMOTE_PORT_RANGE)) {
+		r->flags |= CLS_F_RPORT;
+		r->rport = c->rport;
+		if (c->mask & WIFI_FILTER_MASK_REMOTE_PORT_RANGE) {
+			r->flags |= CLS_F_RRANGE;
+			r->rmin = c->rmin;
+			r->rmax = c->rmax;
+		}
+	}
+}
+
+static void cls_compile_rule(struct cls_rule *r, wifi_filter_type type,
+							 const void *filters, int i)
+{
+	memset(r, 0, sizeof(*r));
+
+	if (type == WIFI_FILTER_TYPE_IPV4) {
+		const struct wifi_ipv4_filter *f =
+			&((const struct wifi_ipv4_filter *)filters)[i];
+
+		if (f->match_mask & WIFI_FILTER_MASK_IP) {
+			r->flags |= CLS_F_IP;
+			r->ip[0] = swap_ipaddr(f->remote_ip);
+		}
+		cls_compile_ports(r, &(struct cls_port_cond) {
+			.mask = f->match_mask,
+			.dir = f->config_type,
+			.proto = f->packet_type,
+			.lport = f->local_port,
+			.lmin = f->localp_min,
+			.lmax = f->localp_max,
+			.rport = f->remote_port,
+			.rmin = f->remotep_min,
+			.rmax = f->remotep_max,
+		});
+	}
+#ifdef CONFIG_SUPPORT_REPEATER_IPV6
+	else {
+		const struct wifi_ipv6_filter *f =
+			&((const struct wifi_ipv6_filter *)filters)[i];
+
+		if (f->match_mask & WIFI_FILTER_MASK_IP) {
+			r->flags |= CLS_F_IP;
+			memcpy(r->ip, f->remote_ip, WIFI_IPV6_ADDR_LEN);
+		}
+		cls_compile_ports(r, &(struct cls_port_cond) {
+			.mask = f->match_mask,
+			.dir = f->config_type,
+			.proto = f->packet_type,
+			.lport = f->local_port,
+			.lmin = f->localp_min,
+			.lmax = f->localp_max,
+			.rport = f->remote_port,
+			.rmin = f->remotep_min,
+			.rmax = f->remotep_max,
+		});
+	}
+#endif
+}
+
+/*
+ * A port condition is met if the port equals the exact port, or if a range
+ * is given and the port falls within it, like the table walk always did.
+ */
+static bool cls_rule_match(const struct cls_rule *r, const struct cls_pkt *k)
+{
+	if ((r->flags & CLS_F_IP) && memcmp(r->ip, k->src, sizeof(r->ip)))
+		return false;
+	if ((r->flags & CLS_F_PROTO) && r->proto != k->proto)
+		return false;
+	if (r->flags & CLS_F_LPORT) {
+		if (!k->has_ports)
+			return false;
+		if (r->lport != k->dport && !((r->flags & CLS_F_LRANGE)
+				&& r->lmin <= k->dport && k->dport <= r->lmax))
+			return false;
+	}
+	if (r->flags & CLS_F_RPORT) {
+		if (!k->has_ports)
+			return false;
+		if (r->rport != k->sport && !((r->flags & CLS_F_RRANGE)
+				&& r->rmin <= k->sport && k->sport <= r->rmax))
+			return false;
+	}
+	return true;
+}
+
+static void cls_add_ival(struct cls_ival *ivals, int *n, uint16_t port,
+						 uint16_t min, uint16_t max, int rule)
+{
+	struct cls_ival *iv;
+	int i;
+
+	/* The exact port, if any, may lie outside of the range. */
+	if (port && port < min)
+		min = port;
+	if (port > max)
+		max = port;
+
+	/* Insertion sort on lo; the tables are small. */
+	for (i = *n; i > 0 && ivals[i - 1].lo > min; i--)
+		ivals[i] = ivals[i - 1];
+	iv = &ivals[i];
+	iv->lo = min;
+	iv->hi = max;
+	iv->rule = rule;
+	(*n)++;
+}
+
+static void cls_fixup_ivals(struct cls_ival *ivals, int n)
+{
+	uint16_t maxhi = 0;
+	int i;
+
+	for (i = 0; i < n; i++) {
+		if (ivals[i].hi > maxhi)
+			maxhi = ivals[i].hi;
+		ivals[i].maxhi = maxhi;
+	}
+}
+
+static struct repeater_cls *cls_compile(wifi_filter_type type,
+										const void *filters, int num)
+{
+	struct repeater_cls *cls;
+	struct cls_rule *r;
+	uint32_t key;
+	int i, h;
+
+	cls = kzalloc(sizeof(*cls));
+	if (!cls)
+		return NULL;
+
+	cls->ref = 1;
+	cls->type = type;
+	cls->nrules = num;
+	memset(cls->heads, 0xff, sizeof(cls->heads));
+
+	/*
+	 * Going backwards and pushing to the bucket heads keeps every hash
+	 * chain sorted by rule index.
+	 */
+	for (i = num - 1; i >= 0; i--) {
+		r = &cls->rules[i];
+		cls_compile_rule(r, type, filters, i);
+
+		if ((r->flags & CLS_F_LPORT) && !(r->flags & CLS_F_LRANGE)) {
+			key = CLS_KEY(0, (r->flags & CLS_F_PROTO) ? r->proto : CLS_PROTO_ANY,
+						  r->lport);
+		} else if ((r->flags & CLS_F_RPORT) && !(r->flags & CLS_F_RRANGE)) {
+			key = CLS_KEY(1, (r->flags & CLS_F_PROTO) ? r->proto : CLS_PROTO_ANY,
+						  r->rport);
+		} else {
+			continue;
+		}
+
+		h = cls_hash(key, CLS_HASH_BITS);
+		r->flags |= CLS_F_HASHED;
+		cls->keys[i] = key;
+		cls->hnext[i] = cls->heads[h];
+		cls->heads[h] = i;
+	}
+
+	for (i = 0; i < num; i++) {
+		r = &cls->rules[i];
+
+		if (r->flags & CLS_F_HASHED)
+			continue;
+		if (r->flags & CLS_F_LRANGE)
+			cls_add_ival(cls->livals, &cls->nlivals, r->lport,
+						 r->lmin, r->lmax, i);
+		else if (r->flags & CLS_F_RRANGE)
+			cls_add_ival(cls->rivals, &cls->nrivals, r->rport,
+						 r->rmin, r->rmax, i);
+		else
+			cls->wild[cls->nwild++] = i;
+	}
+
+	cls_fixup_ivals(cls->livals, cls->nlivals);
+	cls_fixup_ivals(cls->rivals, cls->nrivals);
+
+#if CONFIG_WIFI_REPEATER_FLOW_CACHE_CNT > 0
+	memset(cls->fheads, CLS_FLOW_NIL, sizeof(cls->fheads));
+	cls->lru_head = cls->lru_tail = CLS_FLOW_NIL;
+#endif
+
+	return cls;
+}
+
+static int cls_probe_hash(const struct repeater_cls *cls, uint32_t key,
+						  const struct cls_pkt *k, int best)
+{
+	int i;
+
+	for (i = cls->heads[cls_hash(key, CLS_HASH_BITS)];
+			i != CLS_NIL && i < best; i = cls->hnext[i]) {
+		if (cls->keys[i] == key && cls_rule_match(&cls->rules[i], k))
+			return i;
+	}
+	return best;
+}
+
+static int cls_probe_ivals(const struct repeater_cls *cls,
+						   const struct cls_ival *ivals, int n,
+						   uint16_t port, const struct cls_pkt *k, int best)
+{
+	int lo = 0, hi = n, mid;
+
+	/* Find the first entry whose range starts above the port... */
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (ivals[mid].lo <= port)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	/* ...and walk down as long as some range can still reach it. */
+	while (--lo >= 0 && ivals[lo].maxhi >= port) {
+		if (ivals[lo].hi >= port && ivals[lo].rule < best
+				&& cls_rule_match(&cls->rules[ivals[lo].rule], k))
+			best = ivals[lo].rule;
+	}
+	return best;
+}
+
+static int cls_lookup(const struct repeater_cls *cls, const struct cls_pkt *k)
+{
+	int best = cls->nrules;
+	int i;
+
+	if (k->has_ports) {
+		best = cls_probe_hash(cls, CLS_KEY(0, k->proto, k->dport), k, best);
+		best = cls_probe_hash(cls, CLS_KEY(0, CLS_PROTO_ANY, k->dport), k, best);
+		best = cls_probe_hash(cls, CLS_KEY(1, k->proto, k->sport), k, best);
+		best = cls_probe_hash(cls, CLS_KEY(1, CLS_PROTO_ANY, k->sport), k, best);
+		best = cls_probe_ivals(cls, cls->livals, cls->nlivals, k->dport, k, best);
+		best = cls_probe_ivals(cls, cls->rivals, cls->nrivals, k->sport, k, best);
+	}
+
+	for (i = 0; i < cls->nwild && cls->wild[i] < best; i++) {
+		if (cls_rule_match(&cls->rules[cls->wild[i]], k)) {
+			best = cls->wild[i];
+			break;
+		}
+	}
+
+	if (best == cls->nrules)
+		return WIFI_FILTER_TO_BUTT;
+
+	REPEATER_LOG2("Matching Found Reg(%d) type(%d) proto(%d) port(%d <- %d)\n",
+				  best, cls->type, k->proto, k->dport, k->sport);
+	return cls->rules[best].dir;
+}
+
+#if CONFIG_WIFI_REPEATER_FLOW_CACHE_CNT > 0
+
+static inline int cls_flow_hash(const struct cls_pkt *k)
+{
+	uint32_t v = ((uint32_t)k->sport << 16 | k->dport) ^ k->proto;
+	int i;
+
+	for (i = 0; i < CLS_ADDR_WORDS; i++)
+		v ^= k->src[i] ^ k->dst[i];
+
+	return cls_hash(v, CLS_FLOW_HASH_BITS);
+}
+
+static inline bool cls_flow_equal(const struct cls_pkt *a,
+								  const struct cls_pkt *b)
+{
+	return a->sport == b->sport && a->dport == b->dport
+		&& a->proto == b->proto
+		&& !memcmp(a->src, b->src, sizeof(a->src))
+		&& !memcmp(a->dst, b->dst, sizeof(a->dst));
+}
+
+static void cls_lru_unlink(struct repeater_cls *cls, int i)
+{
+	struct cls_flow *f = &cls->flows[i];
+
+	if (f->prev != CLS_FLOW_NIL)
+		cls->flows[f->prev].next = f->next;
+	else
+		cls->lru_head = f->next;
+	if (f->next != CLS_FLOW_NIL)
+		cls->flows[f->next].prev = f->prev;
+	else
+		cls->lru_tail = f->prev;
+}
+
+static void cls_lru_push(struct repeater_cls *cls, int i)
+{
+	struct cls_flow *f = &cls->flows[i];
+
+	f->prev = CLS_FLOW_NIL;
+	f->next = cls->lru_head;
+	if (cls->lru_head != CLS_FLOW_NIL)
+		cls->flows[cls->lru_head].prev = i;
+	else
+		cls->lru_tail = i;
+	cls->lru_head = i;
+}
+
+static int cls_flow_lookup(struct repeater_cls *cls, const struct cls_pkt *k)
+{
+	int i;
+
+	for (i = cls->fheads[cls_flow_hash(k)]; i != CLS_FLOW_NIL;
+			i = cls->flows[i].hnext) {
+		if (cls_flow_equal(&cls->flows[i].key, k)) {
+			if (cls->lru_head != i) {
+				cls_lru_unlink(cls, i);
+				cls_lru_push(cls, i);
+			}
+			return cls->flows[i].dir;
+		}
+	}
+	return -1;
+}
+
+static void cls_flow_insert(struct repeater_cls *cls, const struct cls_pkt *k,
+							int dir)
+{
+	struct cls_flow *f;
+	uint8_t *pp;
+	int i, h;
+
+	if (cls->nflows < CONFIG_WIFI_REPEATER_FLOW_CACHE_CNT) {
+		i = cls->nflows++;
+	} else {
+		/* Recycle the least recently used flow. */
+		i = cls->lru_tail;
+		cls_lru_unlink(cls, i);
+		for (pp = &cls->fheads[cls_flow_hash(&cls->flows[i].key)];
+				*pp != i; pp = &cls->flows[*pp].hnext)
+			;
+		*pp = cls->flows[i].hnext;
+	}
+
+	f = &cls->flows[i];
+	f->key = *k;
+	f->dir = dir;
+	h = cls_flow_hash(k);
+	f->hnext = cls->fheads[h];
+	cls->fheads[h] = i;
+	cls_lru_push(cls, i);
+}
+
+#endif /* CONFIG_WIFI_REPEATER_FLOW_CACHE_CNT > 0 */
+
+static void cls_parse_ipv4(struct mbuf *m, struct cls_pkt *k)
+{
+	const struct ip_hdr *ipv4 = IPv4BUF;
+	const struct tcp_hdr *tcp;
+	const struct udp_hdr *udp;
+	uint16_t iphdr_hlen = IPH_HL_BYTES(ipv4);
+
+	k->src[0] = ipv4->src.addr;
+	k->dst[0] = ipv4->dest.addr;
+	k->proto = IPH_PROTO(ipv4);
+
+	if (k->proto == IP_PROTO_TCP) {
+		tcp = TCPIPv4BUF(iphdr_hlen);
+		k->sport = swap_portnum(tcp->src);
+		k->dport = swap_portnum(tcp->dest);
+		k->has_ports = 1;
+	} else if (k->proto == IP_PROTO_UDP) {
+		udp = UDPIPv4BUF(iphdr_hlen);
+		k->sport = swap_portnum(udp->src);
+		k->dport = swap_portnum(udp->dest);
+		k->has_ports = 1;
+	}
+}
+
+#ifdef CONFIG_SUPPORT_REPEATER_IPV6
+
+#define IP6_NEXTH_ESP		50
+#define IP6_NEXTH_AH		51
+#define IP6_MAX_EXTHDRS		8
+
+/*
+ * Walk the IPv6 extension headers up to the upper-layer header.
+ * Returns the offset of that header in the frame, or -1 if the header chain
+ * is malformed or does not fit in the first mbuf.  *proto is set to the
+ * upper-layer protocol and *frag to whether a fragment header was found.
+ * The offset of a non-first fragment is returned as 0, as it carries no
+ * upper-layer header at all.
+ */
+static int ipv6_upper_layer(struct mbuf *m, uint8_t *proto, bool *frag)
+{
+	const struct ip6_hdr *ip6 = IPv6BUF;
+	const struct ip6_frag_hdr *fh;
+	const uint8_t *eh;
+	int off = ETHER_HDR_LEN + IP6_HLEN;
+	uint8_t nexth = IP6H_NEXTH(ip6);
+	int n, len;
+
+	*frag = false;
+
+	for (n = 0; n < IP6_MAX_EXTHDRS; n++) {
+		if (nexth != IP6_NEXTH_HOPBYHOP && nexth != IP6_NEXTH_ROUTING
+			&& nexth != IP6_NEXTH_DESTOPTS && nexth != IP6_NEXTH_FRAGMENT
+			&& nexth != IP6_NEXTH_AH)
+			break;
+
+		if (off + 8 > m->m_len)
+			return -1;
+
+		eh = mtodo(m, off);
+		if (nexth == IP6_NEXTH_FRAGMENT) {
+			fh = (const struct ip6_frag_hdr *)eh;
+			*frag = true;
+			nexth = IP6_FRAG_NEXTH(fh);
+			if (lwip_ntohs(fh->_fragment_offset) & IP6_FRAG_OFFSET_MASK) {
+				*proto = nexth;
+				return 0;
+			}
+			len = IP6_FRAG_HLEN;
+		} else if (nexth == IP6_NEXTH_AH) {
+			nexth = eh[0];
+			len = (eh[1] + 2) * 4;
+		} else {
+			nexth = eh[0];
+			len = (eh[1] + 1) * 8;
+		}
+		off += len;
+	}
+
+	*proto = nexth;
+
+	if (n == IP6_MAX_EXTHDRS || off > m->m_len)
+		return -1;
+
+	return off;
+}
+
+static void cls_parse_ipv6(struct mbuf *m, struct cls_pkt *k)
+{
+	const struct ip6_hdr *ip6 = IPv6BUF;
+	const struct udp_hdr *udp;
+	bool frag;
+	int off;
+
+	memcpy(k->src, &ip6->src, sizeof(k->src));
+	memcpy(k->dst, &ip6->dest, sizeof(k->dst));
+
+	off = ipv6_upper_layer(m, &k->proto, &frag);
+	if (off <= 0)
+		return;
+
+	/* TCP and UDP both start with the source and destination ports. */
+	if ((k->proto == IP6_NEXTH_TCP || k->proto == IP6_NEXTH_UDP)
+		&& off + 4 <= m->m_len) {
+		udp = mtodo(m, off);
+		k->sport = swap_portnum(udp->src);
+		k->dport = swap_portnum(udp->dest);
+		k->has_ports = 1;
+	}
+}
+
+#endif /* CONFIG_SUPPORT_REPEATER_IPV6 */
+
+static int cls_classify(struct repeater_cls *cls, struct mbuf *m)
+{
+	struct cls_pkt k;
+	int dir;
+
+	memset(&k, 0, sizeof(k));
+#ifdef CONFIG_SUPPORT_REPEATER_IPV6
+	if (cls->type == WIFI_FILTER_TYPE_IPV6)
+		cls_parse_ipv6(m, &k);
+	else
+#endif
+		cls_parse_ipv4(m, &k);
+
+#if CONFIG_WIFI_REPEATER_FLOW_CACHE_CNT > 0
+	dir = cls_flow_lookup(cls, &k);
+	if (dir >= 0) {
+		cls->hits++;
+		return dir;
+	}
+	cls->misses++;
+	dir = cls_lookup(cls, &k);
+	cls_flow_insert(cls, &k, dir);
+#else
+	dir = cls_lookup(cls, &k);
+#endif
+
+	return dir;
+}
+
+static struct repeater_cls **repeater_cls_slot(struct wifi_filter_config *cfg,
+											   wifi_filter_type type)
+{
+	if (type == WIFI_FILTER_TYPE_IPV6) {
+#ifdef CONFIG_SUPPORT_REPEATER_IPV6
+		return &cfg->cls6;
+#else
+		return NULL;
+#endif
+	}
+	return &cfg->cls;
+}
+
+static struct repeater_cls *repeater_cls_get(struct wifi_filter_config *cfg,
+											 wifi_filter_type type)
+{
+	struct repeater_cls **slot = repeater_cls_slot(cfg, type);
+	struct repeater_cls *cls;
+	unsigned long flags;
+
+	if (!slot)
+		return NULL;
+
+	local_irq_save(flags);
+	cls = *slot;
+	if (cls)
+		cls->ref++;
+	local_irq_restore(flags);
+
+	return cls;
+}
+
+static void repeater_cls_put(struct repeater_cls *cls)
+{
+	unsigned long flags;
+	int ref;
+
+	if (!cls)
+		return;
+
+	local_irq_save(flags);
+	ref = --cls->ref;
+	local_irq_restore(flags);
+
+	if (ref == 0)
+		kfree(cls);
+}
+
+static void repeater_cls_publish(struct wifi_filter_config *cfg,
+								 wifi_filter_type type,
+								 struct repeater_cls *cls)
+{
+	struct repeater_cls **slot = repeater_cls_slot(cfg, type);
+	struct repeater_cls *old;
+	unsigned long flags;
+
+	local_irq_save(flags);
+	old = *slot;
+	*slot = cls;
+	local_irq_restore(flags);
+
+	repeater_cls_put(old);
+}
+
+/* Must be called with filter_mtx held. */
+static int repeater_cls_rebuild(struct wifi_filter_config *cfg,
+								wifi_filter_type type)
+{
+	struct repeater_cls *cls = NULL;
+	const void *filters = cfg->ipv4_filters;
+	int num = cfg->ipv4_used;
+
+#ifdef CONFIG_SUPPORT_REPEATER_IPV6
+	if (type == WIFI_FILTER_TYPE_IPV6) {
+		filters = cfg->ipv6_filters;
+		num = cfg->ipv6_used;
+	}
+#endif
+
+	if (num > 0) {
+		cls = cls_compile(type, filters, num);
+		if (!cls) {
+			REPEATER_LOG1("%s classifier allocation failed\n", __func__);
+			return FAIL;
+		}
+	}
+
+	repeater_cls_publish(cfg, type, cls);
+
+	return OK;
+}
+
+static int match_filter(struct wifi_filter_config *cfg, struct mbuf *m,
+						wifi_filter_type type)
+{
+	struct repeater_cls *cls;
+	int dir;
+
+	cls = repeater_cls_get(cfg, type);
+	if (!cls)
+		return WIFI_FILTER_TO_BUTT;
+
+	dir = cls_classify(cls, m);
+	repeater_cls_put(cls);
+
+	return dir;
+}
+
 
 static int wifi_repeater_ops_set_def_dir(wifi_repeater_id idx,
 										 wifi_packet_filter direction)
@@ -228,11 +973,141 @@ static int wifi_add_ipv4_filter(struct wifi_filter_config *cfg,
 	memcpy(wlan_filter, new_filter, sizeof(*wlan_filter));
 	cfg->ipv4_used++;
 
+	if (repeater_cls_rebuild(cfg, WIFI_FILTER_TYPE_IPV4) != OK) {
+		cfg->ipv4_used--;
+		memset(wlan_filter, 0, sizeof(*wlan_filter));
+		filter_mtx_unlock();
+		return FAIL;
+	}
+
 	filter_mtx_unlock();
 
 	return OK;
 }
 
+#ifdef CONFIG_SUPPORT_REPEATER_IPV6
+static int is_ipv6_filter_duplicate(struct wifi_filter_config *cfg,
+								struct wifi_ipv6_filter *new_filter)
+{
+	int i;
+
+	for (i = 0; i < cfg->ipv6_used; i++) {
+		if (memcmp(&cfg->ipv6_filters[i], new_filter,
+				   sizeof(struct wifi_ipv6_filter)) == 0)
+			return FAIL;
+	}
+
+	return OK;
+}
+
+static int wifi_adddel_ipv6_filter_check_param(struct wifi_ipv6_filter *filter)
+{
+	/* Same dependencies as for IPv4 filters */
+	if ((filter->match_mask & WIFI_FILTER_MASK_LOCAL_PORT) && !filter->local_port) {
+		REPEATER_LOG1("L-port filter dependency\n");
+		return FAIL;
+	}
+	if (filter->match_mask & WIFI_FILTER_MASK_REMOTE_PORT && !filter->remote_port) {
+		REPEATER_LOG1("R-port filter dependency\n");
+		return FAIL;
+	}
+	if ((filter->match_mask & WIFI_FILTER_MASK_LOCAL_PORT_RANGE) && (filter->localp_min >= filter->localp_max)) {
+		REPEATER_LOG1("L-port range filter dependency\n");
+		return FAIL;
+	}
+	if ((filter->match_mask & WIFI_FILTER_MASK_REMOTE_PORT_RANGE) && (filter->remotep_min >= filter->remotep_max)) {
+		REPEATER_LOG1("R-port range filter dependency\n");
+		return FAIL;
+	}
+
+	return OK;
+}
+
+static int wifi_add_ipv6_filter(struct wifi_filter_config *cfg,
+								struct wifi_ipv6_filter *new_filter)
+{
+	struct wifi_ipv6_filter *wlan_filter;
+
+	if (cfg == NULL || new_filter == NULL
+		|| cfg->ipv6_used >= cfg->max_ipv6_num) {
+		REPEATER_LOG1("Add Failed (Filter is full)...\n");
+		return FAIL;
+	}
+
+	if (wifi_adddel_ipv6_filter_check_param(new_filter) != OK) {
+		return FAIL;
+	}
+
+	filter_mtx_lock();
+
+	if (is_ipv6_filter_duplicate(cfg, new_filter)) {
+		filter_mtx_unlock();
+		return FAIL;
+	}
+
+	wlan_filter = &cfg->ipv6_filters[cfg->ipv6_used];
+	memcpy(wlan_filter, new_filter, sizeof(*wlan_filter));
+	cfg->ipv6_used++;
+
+	if (repeater_cls_rebuild(cfg, WIFI_FILTER_TYPE_IPV6) != OK) {
+		cfg->ipv6_used--;
+		memset(wlan_filter, 0, sizeof(*wlan_filter));
+		filter_mtx_unlock();
+		return FAIL;
+	}
+
+	filter_mtx_unlock();
+
+	return OK;
+}
+
+static int wifi_del_ipv6_filter(struct wifi_filter_config *cfg,
+								struct wifi_ipv6_filter *del_filter)
+{
+	struct wifi_ipv6_filter *filter_table = cfg->ipv6_filters;
+	int i;
+
+	if (cfg == NULL || del_filter == NULL)
+		return FAIL;
+
+	if (wifi_adddel_ipv6_filter_check_param(del_filter) != OK) {
+		return FAIL;
+	}
+
+	filter_mtx_lock();
+
+	for (i = 0; i < cfg->ipv6_used; i++) {
+		if (memcmp(&filter_table[i], del_filter, sizeof(struct wifi_ipv6_filter)))
+			continue;
+
+		memmove(&filter_table[i],
+				&filter_table[i + 1],
+				(cfg->ipv6_used - i - 1) * sizeof(struct wifi_ipv6_filter));
+
+		cfg->ipv6_used--;
+
+		if (repeater_cls_rebuild(cfg, WIFI_FILTER_TYPE_IPV6) != OK) {
+			memmove(&filter_table[i + 1],
+					&filter_table[i],
+					(cfg->ipv6_used - i) * sizeof(struct wifi_ipv6_filter));
+			memcpy(&filter_table[i], del_filter, sizeof(*del_filter));
+			cfg->ipv6_used++;
+			filter_mtx_unlock();
+			return FAIL;
+		}
+
+		filter_mtx_unlock();
+
+		return OK;
+	}
+
+	filter_mtx_unlock();
+
+	REPEATER_LOG1("Can't found matching Filter\n");
+	return FAIL;
+}
+#endif
+
 /* Adds the filtering rules to the forwarding table of the repeater. */
 static int wifi_repeater_ops_add_filter(wifi_repeater_id idx, char *filter,
 										wifi_filter_type type)
@@ -245,6 +1120,11 @@ static int wifi_repeater_ops_add_filter(wifi_repeater_id idx, char *filter,
 	if (type == WIFI_FILTER_TYPE_IPV4 && REPEATER_GET_IPV4_FILTERS(idx))
 		return wifi_add_ipv4_filter(cfg,
 									(struct wifi_ipv4_filter *) filter);
+#ifdef CONFIG_SUPPORT_REPEATER_IPV6
+	else if (type == WIFI_FILTER_TYPE_IPV6 && REPEATER_GET_IPV6_FILTERS(idx))
+		return wifi_add_ipv6_filter(cfg,
+									(struct wifi_ipv6_filter *) filter);
+#endif
 	else
 		return FAIL;
 
@@ -275,6 +1155,20 @@ static int wifi_del_ipv4_filter(struct wifi_filter_config *cfg,
 					(cfg->ipv4_used - i - 1) * sizeof(struct wifi_ipv4_filter));
 
 			cfg->ipv4_used--;
+
+			if (repeater_cls_rebuild(cfg, WIFI_FILTER_TYPE_IPV4) != OK) {
+				/* Put the filter back so that the table and the
+				 * classifier in use still agree.
+				 */
+				memmove(&filter_table[i + 1],
+						&filter_table[i],
+						(cfg->ipv4_used - i) * sizeof(struct wifi_ipv4_filter));
+				memcpy(&filter_table[i], del_filter, sizeof(*del_filter));
+				cfg->ipv4_used++;
+				filter_mtx_unlock();
+				return FAIL;
+			}
+
 			filter_mtx_unlock();
 
 			return OK;
@@ -298,6 +1192,11 @@ static int wifi_repeater_ops_del_filter(wifi_repeater_id idx, char *filter,
 	if (type == WIFI_FILTER_TYPE_IPV4 && REPEATER_GET_IPV4_FILTERS(idx))
 		return wifi_del_ipv4_filter(cfg,
 									(struct wifi_ipv4_filter *) filter);
+#ifdef CONFIG_SUPPORT_REPEATER_IPV6
+	else if (type == WIFI_FILTER_TYPE_IPV6 && REPEATER_GET_IPV6_FILTERS(idx))
+		return wifi_del_ipv6_filter(cfg,
+									(struct wifi_ipv6_filter *) filter);
+#endif
 	else
 		return FAIL;
 
@@ -316,6 +1215,11 @@ static int wifi_repeater_ops_query_filter(wifi_repeater_id idx,
 	if (type == WIFI_FILTER_TYPE_IPV4 && REPEATER_GET_IPV4_FILTERS(idx)) {
 		*num = cfg->ipv4_used;
 		*filter = (char *) cfg->ipv4_filters;
+#ifdef CONFIG_SUPPORT_REPEATER_IPV6
+	} else if (type == WIFI_FILTER_TYPE_IPV6 && REPEATER_GET_IPV6_FILTERS(idx)) {
+		*num = cfg->ipv6_used;
+		*filter = (char *) cfg->ipv6_filters;
+#endif
 	} else
 		return FAIL;
 
@@ -342,7 +1246,18 @@ static int wifi_repeater_ops_free_filters(wifi_repeater_id idx, wifi_filter_type
 		filter_mtx_lock();
 		cfg->ipv4_used = 0;
 		memset(cfg->ipv4_filters, 0, sizeof(struct wifi_ipv4_filter) * cfg->max_ipv4_num);
+		repeater_cls_publish(cfg, WIFI_FILTER_TYPE_IPV4, NULL);
+		filter_mtx_unlock();
+#ifdef CONFIG_SUPPORT_REPEATER_IPV6
+	} else if (type == WIFI_FILTER_TYPE_IPV6) {
+		if (cfg->ipv6_filters == NULL)
+			return FAIL;
+		filter_mtx_lock();
+		cfg->ipv6_used = 0;
+		memset(cfg->ipv6_filters, 0, sizeof(struct wifi_ipv6_filter) * cfg->max_ipv6_num);
+		repeater_cls_publish(cfg, WIFI_FILTER_TYPE_IPV6, NULL);
 		filter_mtx_unlock();
+#endif
 	} else {
 		return FAIL;
 	}
@@ -370,9 +1285,11 @@ static int wifi_repeater_ops_deinit(wifi_repeater_id idx)
 
 	repeater_if_deattach(cfg);
 	filter_mtx_lock();
+	repeater_cls_publish(cfg, WIFI_FILTER_TYPE_IPV4, NULL);
 	if (cfg->ipv4_filters)
 		kfree(cfg->ipv4_filters);
 #ifdef CONFIG_SUPPORT_REPEATER_IPV6
+	repeater_cls_publish(cfg, WIFI_FILTER_TYPE_IPV6, NULL);
 	if (cfg->ipv6_filters)
 		kfree(cfg->ipv6_filters);
 #endif
@@ -402,203 +1319,25 @@ static int wifi_ipv4_filter_init(struct wifi_filter_config *cfg)
 	return OK;
 }
 
-bool match_ip(struct wifi_ipv4_filter *filter, const struct ip_hdr *ipv4,
-			  const struct tcp_hdr *tcp, const struct udp_hdr *udp,
-			  int index, int len)
-{
-	unsigned long srcipaddr = ipv4->src.addr;
-	if (filter->remote_ip == swap_ipaddr(srcipaddr)) {
-		REPEATER_LOG2
-			("Matching Found Reg(%d) by src ip(0x%08x), len(%d)\n", index,
-			 filter->remote_ip, len);
-		return true;
-	}
-	return false;
-}
-
-bool match_protocol(struct wifi_ipv4_filter *filter,
-					const struct ip_hdr *ipv4, const struct tcp_hdr *tcp,
-					const struct udp_hdr *udp, int index, int len)
-{
-	if (filter->packet_type == ipv4->_proto) {
-		REPEATER_LOG2
-			("Matching Found Reg(%d) by protocol(%d), len(%d)\n", index,
-			 filter->packet_type, len);
-		return true;
-	}
-	return false;
-}
-
-bool match_local_port_and_range(struct wifi_ipv4_filter *filter,
-								const struct ip_hdr *ipv4,
-								const struct tcp_hdr *tcp,
-								const struct udp_hdr *udp, int index,
-								int len)
-{
-	uint16_t port_number;
-	bool matched = false;
-
-	if (udp) {
-		port_number = swap_portnum(udp->dest);
-	} else if (tcp) {
-		port_number = swap_portnum(tcp->dest);
-	} else {
-		return false;
-	}
-
-	if (filter->local_port == port_number) {
-		REPEATER_LOG2
-			("Matching Found Reg(%d) by dest port(%d), len(%d)\n", index,
-			 filter->local_port, len);
-		matched = true;
-	}
-
-	/*
-	 * if both the source port number and source port number range are specified in a rule, the
-	 * Repeater preferentially compares the source port numbers.
-	 *      1) If the source port numbers do not match, the source port number ranges are compared.
-	 *       2) If the source port numbers match, the source port number ranges are also considered to match.
-	 */
-	if ((filter->match_mask & WIFI_FILTER_MASK_LOCAL_PORT_RANGE) &&
-		(filter->localp_min <= port_number) &&
-		(port_number <= filter->localp_max)) {
-		REPEATER_LOG2
-			("Matching Found Reg(%d) UDP by dest port range(%d ~ %d), len(%d)\n",
-			 index, filter->localp_min, filter->localp_min, len);
-		matched = true;
-	}
-	return matched;
-}
-
-bool match_remote_port_and_range(struct wifi_ipv4_filter *filter,
-								 const struct ip_hdr *ipv4,
-								 const struct tcp_hdr *tcp,
-								 const struct udp_hdr *udp, int index,
-								 int len)
-{
-	uint16_t port_number;
-	bool matched = false;
-
-	if (udp) {
-		port_number = swap_portnum(udp->src);
-	} else if (tcp) {
-		port_number = swap_portnum(tcp->src);
-	} else {
-		return false;
-	}
-
-	if (filter->remote_port == port_number) {
-		REPEATER_LOG2
-			("Matching Found Reg(%d) by src port(%d), len(%d)\n", index,
-			 filter->remote_port, len);
-		matched = true;
-	}
-
-	/*
-	 * if both the dest port number and dest port number range are specified in a rule, the
-	 * Repeater preferentially compares the dest port numbers.
-	 *      1) If the dest port numbers do not match, the dest port number ranges are compared.
-	 *      2) If the dest port numbers match, the dest port number ranges are also considered to match.
-	 */
-
-	if ((filter->match_mask & WIFI_FILTER_MASK_REMOTE_PORT_RANGE) &&
-		(filter->remotep_min <= port_number) &&
-		(port_number <= filter->remotep_max)) {
-		REPEATER_LOG2
-			("Matching Found Reg(%d) by src port(%d ~ %d), len(%d)\n",
-			 index, filter->remotep_min, filter->remotep_min, len);
-		return true;
-	}
-	return matched;
-}
-
-
-bool match_remote_port_range(struct wifi_ipv4_filter *filter,
-							 const struct ip_hdr *ipv4,
-							 const struct tcp_hdr *tcp,
-							 const struct udp_hdr *udp, int index, int len)
-{
-	uint16_t port_number;
-	if (udp) {
-		port_number = swap_portnum(udp->src);
-	} else if (tcp) {
-		port_number = swap_portnum(tcp->src);
-	} else {
-		return false;
-	}
-
-	if ((filter->remotep_min <= port_number) &&
-		(port_number <= filter->remotep_max)) {
-		REPEATER_LOG2
-			("Matching Found Reg(%d) by src port(%d ~ %d), len(%d)\n",
-			 index, filter->remotep_min, filter->remotep_min, len);
-		return true;
-	}
-	return false;
-}
-
-typedef bool (*match_func)(struct wifi_ipv4_filter *,
-						   const struct ip_hdr *, const struct tcp_hdr *,
-						   const struct udp_hdr *, int, int);
-
-match_func match_funcs[] = {
-	[0] = match_ip,				//  WIFI_FILTER_MASK_IP
-	[1] = match_protocol,		//  WIFI_FILTER_MASK_PROTOCOL
-	[2] = match_local_port_and_range,	//  WIFI_FILTER_MASK_LOCAL_PORT
-	[3] = match_local_port_and_range,	//  WIFI_FILTER_MASK_LOCAL_PORT_RANGE
-	[4] = match_remote_port_and_range,	// WIFI_FILTER_MASK_REMOTE_PORT
-	[5] = match_remote_port_and_range,	// WIFI_FILTER_MASK_REMOTE_PORT_RANGE
-};
-
-static int ipv4_match_filter(struct wifi_filter_config *cfg,
-											struct mbuf *m)
+#ifdef CONFIG_SUPPORT_REPEATER_IPV6
+static int wifi_ipv6_filter_init(struct wifi_filter_config *cfg)
 {
-	struct wifi_ipv4_filter *wlan_filter;
-	int index;
-	uint16_t iphdr_hlen;
-	const struct tcp_hdr *tcp = NULL;
-	const struct udp_hdr *udp = NULL;
-	const struct ip_hdr *ipv4 = IPv4BUF;
-	int len = m->m_len;
-	uint8_t mask_bit;
+	struct wifi_ipv6_filter *wlan_filters;
 
-	iphdr_hlen = IPH_HL_BYTES(ipv4);
-
-	if (ipv4->_proto == IP_PROTO_TCP)
-		tcp = TCPIPv4BUF(iphdr_hlen);
-	else if (ipv4->_proto == IP_PROTO_UDP)
-		udp = UDPIPv4BUF(iphdr_hlen);
-
-	for (index = 0; index < cfg->ipv4_used; index++) {
-		wlan_filter = &cfg->ipv4_filters[index];
-		uint8_t config_type = wlan_filter->config_type;
-		bool match_result = true;
-
-		for (mask_bit = 0; mask_bit < ARRAY_SIZE(match_funcs); mask_bit++) {
-			if (wlan_filter->match_mask & (1 << mask_bit)) {
-				match_func func = match_funcs[mask_bit];
-				if (func) {
-					match_result =
-						func(wlan_filter, ipv4, tcp, udp, index, len);
-					if (!match_result)
-						break;
-				}
-			}
-		}
-		if (match_result)
-			return config_type;
+	cfg->max_ipv6_num = CONFIG_SUPPORT_WIFI_REPEATER_IPV6_CNT;
+	wlan_filters =
+		kzalloc(sizeof(struct wifi_ipv6_filter) * cfg->max_ipv6_num);
+	if (!wlan_filters) {
+		REPEATER_LOG1("%s filter table allocation failed\n", __func__);
+		return FAIL;
 	}
 
-	return WIFI_FILTER_TO_BUTT;
-}
+	cfg->ipv6_filters = wlan_filters;
+	cfg->ipv6_used = 0;
 
-static int match_filter(struct wifi_filter_config *cfg, struct mbuf *m)
-{
-	if (cfg->ipv4_used > 0)
-		return ipv4_match_filter(cfg, m);
-	else
-		return WIFI_FILTER_TO_BUTT;
+	return OK;
 }
+#endif
 
 #if CONFIG_WIFI_REPEATER_DEBUG >= 3
 void wifi_repeater_dump_pkt(struct mbuf *m)
@@ -633,6 +1372,35 @@ void wifi_repeater_dump_pkt(struct mbuf *m)
 }
 #endif
 
+#ifdef CONFIG_WIFI_REPEATER_SHARED_BOTH
+/*
+ * lwIP reassembles fragments in place, overwriting the IP and fragment
+ * headers, so fragments must still be copied before the host gets to see
+ * them.
+ */
+static bool repeater_can_share(struct mbuf *m)
+{
+	const struct ether_header *eh = mtod(m, struct ether_header *);
+	const struct ip_hdr *ipv4 = IPv4BUF;
+
+	if (eh->ether_type == htons(ETHERTYPE_IP)
+		&& (IPH_OFFSET(ipv4) & PP_HTONS(IP_OFFMASK | IP_MF)))
+		return false;
+
+#ifdef CONFIG_SUPPORT_REPEATER_IPV6
+	if (eh->ether_type == htons(ETHERTYPE_IPV6)) {
+		uint8_t proto;
+		bool frag;
+
+		if (ipv6_upper_layer(m, &proto, &frag) < 0 || frag)
+			return false;
+	}
+#endif
+
+	return true;
+}
+#endif
+
 static void repeater_forward_packet(struct wifi_filter_config *cfg, wifi_packet_filter direction,struct mbuf *m)
 {
 	struct pbuf *p;
@@ -656,6 +1424,22 @@ static void repeater_forward_packet(struct wifi_filter_config *cfg, wifi_packet_
 		return;
 	} else { /* Both/Invalid: WIFI_FILTER_TO_BOTH */
 		REPEATER_LOG2("Data To BOTH(%d)\n", m->m_len);
+#ifdef CONFIG_WIFI_REPEATER_SHARED_BOTH
+		/* Both sides read the same frame; the host gets an mbuf
+		 * referring to the pbuf handed to lwIP, and the frame is
+		 * released when both are done with it.
+		 */
+		if (repeater_can_share(m)) {
+			struct mbuf *mh;
+
+			p = m_topbuf_share(m, &mh);
+			if (p) {
+				cfg->host_input(ifp, mh);
+				cfg->lwip_input(ifp, p);
+				return;
+			}
+		}
+#endif
 		/* m_dup here is redundant, directly copy to pbuf
 		 * host_input will free the mbuf */
 		p = m_topbuf_nofreem(m);
@@ -699,9 +1483,26 @@ static void repeater_input(struct ifnet *ifp, struct mbuf *m)
 	eh = mtod(m, struct ether_header *);
 
 	/* Default filter rule */
-	if (eh->ether_type == htons(ETHERTYPE_PAE)
-		|| eh->ether_type == htons(ETHERTYPE_IPV6)) {
+	if (eh->ether_type == htons(ETHERTYPE_PAE)) {
+		direction = WIFI_FILTER_TO_LWIP;
+		goto forward_pkt;
+	}
+
+	if (eh->ether_type == htons(ETHERTYPE_IPV6)) {
+#ifdef CONFIG_SUPPORT_REPEATER_IPV6
+		uint8_t proto;
+		bool frag;
+
+		/* ICMPv6, including ND and MLD, to both side */
+		if (ipv6_upper_layer(m, &proto, &frag) < 0)
+			direction = WIFI_FILTER_TO_LWIP;
+		else if (proto == IP6_NEXTH_ICMP6)
+			direction = WIFI_FILTER_TO_BOTH;
+		else
+			direction = match_filter(cfg, m, WIFI_FILTER_TYPE_IPV6);
+#else
 		direction = WIFI_FILTER_TO_LWIP;
+#endif
 		goto forward_pkt;
 	}
 
@@ -722,7 +1523,7 @@ static void repeater_input(struct ifnet *ifp, struct mbuf *m)
 	if (eh->ether_type == htons(ETHERTYPE_IP)) {
 
 		/* Check Filter & forwarding rule of Table */
-		direction = match_filter(cfg, m);
+		direction = match_filter(cfg, m, WIFI_FILTER_TYPE_IPV4);
 		goto forward_pkt;
 	}
 
@@ -793,7 +1594,7 @@ static int wifi_repeater_ops_init(wifi_repeater_id idx,
 	if (wifi_ipv4_filter_init(cfg))
 		return FAIL;
 
-#if CONFIG_SUPPORT_REPEATER_IPV6
+#ifdef CONFIG_SUPPORT_REPEATER_IPV6
 	if (wifi_ipv6_filter_init(cfg))
 		return FAIL;
 #endif
@@ -853,6 +1654,41 @@ static void repeater_show_filter_cmd(void)
 			 wlan_filter->match_mask);
 		wlan_filter++;
 	}
+
+#ifdef CONFIG_SUPPORT_REPEATER_IPV6
+	struct wifi_ipv6_filter *wlan_filter6;
+
+	if (wifi_repeater_query_filter(WIFI_REPEATER_WLAN0, (char **) &wlan_filter6,
+								   &num, WIFI_FILTER_TYPE_IPV6) == OK) {
+		REPEATER_LOG1("\n----- Total IPv6 Filter Count %d -----\n", num);
+
+		for (filter_index = 0; filter_index < num; filter_index++) {
+			REPEATER_LOG1
+				("[%d] protocol(%d) dest port(%d) config_type(%d) match_mask(0x%x)\n",
+				 filter_index, wlan_filter6->packet_type,
+				 wlan_filter6->local_port, wlan_filter6->config_type,
+				 wlan_filter6->match_mask);
+			wlan_filter6++;
+		}
+	}
+#endif
+
+#if CONFIG_WIFI_REPEATER_FLOW_CACHE_CNT > 0
+	wifi_filter_type type;
+
+	for (type = WIFI_FILTER_TYPE_IPV4; type <= WIFI_FILTER_TYPE_IPV6; type++) {
+		struct repeater_cls *cls = repeater_cls_get(&repeater_ctx.filter_cfg[0],
+													type);
+
+		if (cls) {
+			REPEATER_LOG1("%s flow cache: %d/%d flows, hit %u miss %u\n",
+				   type == WIFI_FILTER_TYPE_IPV4 ? "IPv4" : "IPv6",
+				   cls->nflows, CONFIG_WIFI_REPEATER_FLOW_CACHE_CNT,
+				   cls->hits, cls->misses);
+			repeater_cls_put(cls);
+		}
+	}
+#endif
 }
 
 /* add : "repeater" "filter" "add" protocol port_num to(1:lwip/2:sdio/3:both) OR*/
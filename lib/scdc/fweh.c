@@ -485,7 +485,7 @@ void ieee80211_tx_mgt_cb_fweh(struct ieee80211_node *ni, void *arg,
 
   ifidx = get_vap_idx(dev, vap);
 
-  mh = (struct ieee80211_frame *)M_AGE_GET(m);
+  mh = (struct ieee80211_frame *)(uintptr_t)M_AGE_GET(m);
   subtype = mh->i_fc[0] & IEEE80211_FC0_SUBTYPE_MASK;
   len = (int)M_SEQNO_GET(m);
 
@@ -576,12 +576,14 @@ notify_scan_entry(void *arg, const struct ieee80211_scan_entry *se)
   int ssid_len;
   int nr, nxr;
 
+#ifdef CONFIG_SUPPORT_MBSSID
   /* Do not indicate nontransmitted entry but
    * enable support mbssid in host driver.
    * Cfg80211 process mbssid via ie
    */
   if (se->se_nontransmitted == 1)
     return;
+#endif
 
   if (escan_result_le != NULL
         && escan_result_le->buflen < sizeof(*escan_result_le) + ielen)
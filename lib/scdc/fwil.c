@@ -541,23 +541,19 @@ static int wsec_set_key(struct device *dev, struct ieee80211vap *vap,
 
   wk.ik_flags = IEEE80211_KEY_RECV | IEEE80211_KEY_XMIT;
 
-  if (key->ea == NULL) {
-    memset(wk.ik_macaddr, 0xff, IEEE80211_ADDR_LEN);
+  /* key->ea is an array; there is always an address. */
+  memcpy(wk.ik_macaddr, key->ea, IEEE80211_ADDR_LEN);
+  /*
+   * Deduce whether group/global or unicast key by checking
+   * the address (yech).  Note also that we can only mark global
+   * keys default; doing this for a unicast key is an error.
+   */
+  if (is_broadcast_ether_addr(key->ea)) {
+    wk.ik_flags |= IEEE80211_KEY_GROUP;
     wk.ik_keyix = key->index;
   } else {
-    memcpy(wk.ik_macaddr, key->ea, IEEE80211_ADDR_LEN);
-    /*
-     * Deduce whether group/global or unicast key by checking
-     * the address (yech).  Note also that we can only mark global
-     * keys default; doing this for a unicast key is an error.
-     */
-    if (is_broadcast_ether_addr(key->ea)) {
-      wk.ik_flags |= IEEE80211_KEY_GROUP;
-      wk.ik_keyix = key->index;
-    } else {
-      wk.ik_keyix = key->index == 0 ? IEEE80211_KEYIX_NONE :
-        key->index;
-    }
+    wk.ik_keyix = key->index == 0 ? IEEE80211_KEYIX_NONE :
+      key->index;
   }
 
   if (wk.ik_keyix != IEEE80211_KEYIX_NONE)
@@ -660,6 +656,7 @@ failed:
   return -1;
 }
 
+#ifdef CONFIG_SUPPORT_HE
 static int fwil_bss_ltfgi_ctl(fwil_bss_handler_t *fbh)
 {
   fwil_handler_t *fh = fbh->fvh->fh;
@@ -693,6 +690,7 @@ static int fwil_bss_ltfgi_ctl(fwil_bss_handler_t *fbh)
 failed:
   return -1;
 }
+#endif
 
 static int fwil_bss_powersave_ctl(fwil_bss_handler_t *fbh)
 {
@@ -745,6 +743,7 @@ struct wpa_twt_params {
   u8	twt_channel;			/* 1 Octets*/
 }__packed;
 
+#ifdef CONFIG_SUPPORT_TWT
 static int fwil_bss_twt_ctl(fwil_bss_handler_t *fbh)
 {
   fwil_handler_t *fh = fbh->fvh->fh;
@@ -785,6 +784,7 @@ static int fwil_bss_twt_ctl(fwil_bss_handler_t *fbh)
 failed:
   return -1;
 }
+#endif
 
 FWIL_BSS_HANDLER(ssid, fwil_bss_ssid);
 FWIL_BSS_HANDLER(interface_remove, fwil_bss_interface_remove);
@@ -796,9 +796,13 @@ FWIL_BSS_HANDLER(wsec_key, fwil_bss_wsec_key);
 FWIL_BSS_HANDLER(wsec, fwil_bss_wsec);
 FWIL_BSS_HANDLER(drop_unencrypted, fwil_bss_drop_unencrypted);
 
+#ifdef CONFIG_SUPPORT_HE
 FWIL_BSS_HANDLER(ltfgi, fwil_bss_ltfgi_ctl);
+#endif
 FWIL_BSS_HANDLER(powersave, fwil_bss_powersave_ctl);
+#ifdef CONFIG_SUPPORT_TWT
 FWIL_BSS_HANDLER(twt, fwil_bss_twt_ctl);
+#endif
 
 /* iovar */
 static int fwil_var_fwmachdrlen(fwil_var_handler_t *fvh)
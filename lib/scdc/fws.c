@@ -9,6 +9,9 @@
  * THE SOFTWARE.
  */
 
+#include <stdio.h>
+#include <string.h>
+
 #include <hal/kernel.h>
 #include <hal/console.h>
 #include <hal/wlan.h>
@@ -18,7 +21,11 @@
 
 #include "compat_param.h"
 #include "mutex.h"
+#include "kernel.h"
 #include "compat_if.h"
+#include "if_media.h"
+#include <net80211/ieee80211_var.h>
+#include <lwip/memp.h>
 
 #include "fwil_types.h"
 #include "fweh.h"
@@ -200,6 +207,186 @@ int fws_credit_en(void)
   return SNCMF_FWS_CREDIT_EN(_sncmf_fws.flag);
 }
 
+#ifdef CONFIG_FWS_ADAPTIVE_CREDIT
+/*
+ * Adaptive credit controller.
+ *
+ * The host only gets credits back through the in-order txstatus stream,
+ * so the controller works on when that stream moves. Every period it
+ * sizes a per-AC budget of host frames the device should hold. The budget
+ * comes from the AC's recent share of completions (a proxy for airtime)
+ * scaled by the free mbuf pool. It then
+ *  - holds credit returns back while an AC is over budget with a deep
+ *    driver queue, or the pool runs low, and
+ *  - returns credits in small batches while the driver queues are
+ *    shallow, so the host refills the link sooner.
+ * A forced report (nothing left from the host) is never held back.
+ */
+#define FWS_CC_NUM_AC      4
+#define FWS_CC_SHARE_ONE   256
+#define FWS_CC_SHARE_FLOOR (FWS_CC_SHARE_ONE / 16)
+#define FWS_CC_MIN_BUDGET  4
+
+static const char *const fws_cc_ac_name[FWS_CC_NUM_AC] = {"BK", "BE", "VI", "VO"};
+static const uint8_t fws_cc_wme_ac[FWS_CC_NUM_AC] = {
+  WME_AC_BK, WME_AC_BE, WME_AC_VI, WME_AC_VO
+};
+
+struct fws_cc
+{
+  uint32_t stamp;
+  uint32_t total;                    /* credits granted, in packets */
+  uint16_t inflight[FWS_CC_NUM_AC];  /* host frames not completed yet */
+  uint16_t done[FWS_CC_NUM_AC];      /* completions in this period */
+  uint16_t share[FWS_CC_NUM_AC];     /* completion share, 1/256 units */
+  uint16_t budget[FWS_CC_NUM_AC];
+  int16_t  depth[FWS_CC_NUM_AC];     /* driver queue depth */
+  uint8_t  pool;                     /* free mbuf pool in percent */
+  uint8_t  piggy_expect;
+  uint8_t  event_expect;
+  bool     hold;
+  uint32_t updates;
+  uint32_t held;                     /* reports held back */
+};
+
+static struct fws_cc _fws_cc;
+
+static inline int fws_cc_fifo(uint8_t *tlv)
+{
+  uint32_t tag = *(uint32_t *)&tlv[2];
+  int fifo = (tag & SNCMF_SKB_HTOD_TAG_FIFO_MASK) >> SNCMF_SKB_HTOD_TAG_FIFO_SHIFT;
+
+  /* BCMC and ATIM frames ride on the best effort queue. */
+  return fifo < FWS_CC_NUM_AC ? fifo : SNCMF_FWS_FIFO_AC_BE;
+}
+
+static void fws_cc_reset(void)
+{
+  int ac;
+
+  memset(&_fws_cc, 0, sizeof(_fws_cc));
+  _fws_cc.total = scdc_get_out_size(true);
+  _fws_cc.pool = 100;
+  _fws_cc.piggy_expect = SNCMF_FWS_PIGGYBACK_COMP_TXSTATUS_CNT;
+  _fws_cc.event_expect = SNCMF_FWS_EVENT_COMP_TXSTATUS_CNT;
+  for (ac = 0; ac < FWS_CC_NUM_AC; ac++)
+    _fws_cc.share[ac] = FWS_CC_SHARE_ONE / FWS_CC_NUM_AC;
+}
+
+static uint8_t fws_cc_pool_level(void)
+{
+  uint32_t pct = 100;
+
+#ifdef CONFIG_MEMP_NUM_MBUF_DYNA_EXT
+  pct = min(pct, memp_available(MEMP_MBUF_EXT_NODE) * 100 / CONFIG_MEMP_NUM_MBUF_DYNA_EXT);
+#endif
+  pct = min(pct, memp_available(MEMP_MBUF_CACHE) * 100 / CONFIG_MEMP_NUM_MBUF_CACHE);
+
+  return pct;
+}
+
+/* Called with mtx_hslot held. */
+static void fws_cc_update(void)
+{
+  struct device *dev = wlandev(0);
+  uint32_t period = max(1U, CONFIG_FWS_CC_PERIOD_MS * osKernelGetTickFreq() / 1000);
+  uint32_t now = osKernelGetTickCount();
+  uint32_t total_done = 0, sum_depth = 0, share, budget;
+  int ac, depth;
+
+  if (_fws_cc.updates && now - _fws_cc.stamp < period)
+    return;
+
+  _fws_cc.stamp = now;
+  _fws_cc.updates++;
+  _fws_cc.pool = fws_cc_pool_level();
+  _fws_cc.hold = _fws_cc.pool < CONFIG_FWS_CC_POOL_LOW;
+
+  for (ac = 0; ac < FWS_CC_NUM_AC; ac++)
+    total_done += _fws_cc.done[ac];
+
+  for (ac = 0; ac < FWS_CC_NUM_AC; ac++)
+  {
+    if (total_done)
+      _fws_cc.share[ac] = (3 * _fws_cc.share[ac] +
+          FWS_CC_SHARE_ONE * _fws_cc.done[ac] / total_done) / 4;
+    _fws_cc.done[ac] = 0;
+
+    depth = wlan_txq_depth(dev, fws_cc_wme_ac[ac]);
+    _fws_cc.depth[ac] = max(depth, 0);
+    sum_depth += _fws_cc.depth[ac];
+
+    share = max(_fws_cc.share[ac], (uint16_t)FWS_CC_SHARE_FLOOR);
+    budget = _fws_cc.total * share / FWS_CC_SHARE_ONE * _fws_cc.pool / 100;
+    _fws_cc.budget[ac] = max(budget, (uint32_t)FWS_CC_MIN_BUDGET);
+
+    if (_fws_cc.inflight[ac] > _fws_cc.budget[ac] &&
+        _fws_cc.depth[ac] > CONFIG_FWS_CC_TXQ_TARGET)
+      _fws_cc.hold = true;
+  }
+
+  /* Small batches while the radio is hungry, full ones when backlogged. */
+  _fws_cc.piggy_expect = min(max(sum_depth / 4, 1U),
+      (uint32_t)SNCMF_FWS_PIGGYBACK_COMP_TXSTATUS_CNT);
+  _fws_cc.event_expect = min(max(sum_depth / 2,
+      max(1U, (uint32_t)SNCMF_FWS_EVENT_COMP_TXSTATUS_CNT / 4)),
+      (uint32_t)SNCMF_FWS_EVENT_COMP_TXSTATUS_CNT);
+}
+
+/* Returns false if this (unforced) report should be held back. */
+static bool fws_cc_admit(bool event_mode, uint32_t *expect)
+{
+  bool admit;
+
+  osMutexAcquire(_sncmf_fws.mtx_hslot, osWaitForever);
+  fws_cc_update();
+  *expect = event_mode ? _fws_cc.event_expect : _fws_cc.piggy_expect;
+  admit = !_fws_cc.hold;
+  if (!admit && _sncmf_fws.available_hslot >= *expect)
+    _fws_cc.held++;
+  osMutexRelease(_sncmf_fws.mtx_hslot);
+
+  return admit;
+}
+
+void fws_track_pkttag(uint8_t *tlv)
+{
+  if (!fws_credit_en() || tlv[0] != SNCMF_FWS_TYPE_PKTTAG)
+    return;
+
+  osMutexAcquire(_sncmf_fws.mtx_hslot, osWaitForever);
+  _fws_cc.inflight[fws_cc_fifo(tlv)]++;
+  osMutexRelease(_sncmf_fws.mtx_hslot);
+}
+
+/* Called with mtx_hslot held. */
+static void fws_cc_done(uint8_t *tlv)
+{
+  int ac = fws_cc_fifo(tlv);
+
+  if (_fws_cc.inflight[ac])
+    _fws_cc.inflight[ac]--;
+  _fws_cc.done[ac]++;
+}
+
+static void fws_cc_dump(void)
+{
+  int ac;
+
+  printf("ctrl  : pool %u%% %s expect piggy %u event %u, held %u, updates %u\n",
+      _fws_cc.pool, _fws_cc.hold ? "hold" : "open", _fws_cc.piggy_expect,
+      _fws_cc.event_expect, _fws_cc.held, _fws_cc.updates);
+  printf("AC  inflight budget share depth\n");
+  for (ac = 0; ac < FWS_CC_NUM_AC; ac++)
+    printf("%s  %8u %6u %5u %5d\n", fws_cc_ac_name[ac], _fws_cc.inflight[ac],
+        _fws_cc.budget[ac], _fws_cc.share[ac], _fws_cc.depth[ac]);
+}
+#else
+#define fws_cc_reset()
+#define fws_cc_admit(event_mode, expect) (true)
+#define fws_cc_done(tlv)
+#endif
+
 static inline uint8_t *fws_txstatus_indicate(uint8_t *buf)
 {
   uint32_t *report_fws_hdr_tag = (uint32_t *) buf;
@@ -291,6 +478,7 @@ void fws_update_done_hslot(uint8_t* _wlh)
   osMutexAcquire(_sncmf_fws.mtx_hslot, osWaitForever);
   _sncmf_fws.hslot_tab[Quotient] |= BIT(Remainder);
   _sncmf_fws.available_hslot++;
+  fws_cc_done(wlh);
   osMutexRelease(_sncmf_fws.mtx_hslot);
 
   FWS_LOG2("%s h:%d R:%d _sncmf_fws.hslot_tab[%d] = 0x%X\n", __func__, hslot, Remainder, Quotient, _sncmf_fws.hslot_tab[Quotient]);
@@ -324,6 +512,13 @@ uint8_t fws_report_txstatus(bool force_report, bool event_mode,uint8_t *piggy_bu
     expect = SNCMF_FWS_PIGGYBACK_COMP_TXSTATUS_CNT;
   }
 
+  if (!force_report)
+  {
+    if (!fws_cc_admit(event_mode, &expect))
+      return 0;
+    bits_remainder = expect;
+  }
+
   if (!force_report && _sncmf_fws.available_hslot < expect)
     return 0;
 
@@ -465,6 +660,7 @@ void fws_enable_credit_mgmt(void)
       memset(_sncmf_fws.hslot_tab, 0, sizeof(_sncmf_fws.hslot_tab));
       /* host start from 1*/
       _sncmf_fws.indicate_hslot = 1;
+      fws_cc_reset();
       if (!!fws_get_credit_quota())
         fweh_send_fws_credit((uint32_t *)&_sncmf_fws.fifo_credit, sizeof(_sncmf_fws.fifo_credit));
       else
@@ -557,15 +753,59 @@ void fws_dump_dbg_info(void)
   }
 }
 
+#endif /* CFG_FWS_DBG */
+
+#if CFG_SUPPORT_CREDIT_MGMT || CFG_FWS_DBG
+#define FWS_CMD_INFO 1
+
 static int do_fws_info(int argc, char *argv[])
 {
-	fws_dump_dbg_info();
-	return 0;
+#if CFG_SUPPORT_CREDIT_MGMT
+  printf("credit: %s quota %u avail %u next hslot %d\n",
+      fws_credit_en() ? "on" : "off",
+      _sncmf_fws.fifo_credit.fifo_credit_data[SNCMF_FWS_FIFO_AC_BK],
+      _sncmf_fws.available_hslot, _sncmf_fws.indicate_hslot);
+#endif
+#ifdef CONFIG_FWS_ADAPTIVE_CREDIT
+  fws_cc_dump();
+#endif
+#if CFG_FWS_DBG
+  fws_dump_dbg_info();
+#endif
+  return 0;
+}
+#endif
+#endif /* CFG_SUPPORT_FWS */
+
+#ifdef CONFIG_SCDC_DATA_REORDER
+static int do_fws_reorder(int argc, char *argv[])
+{
+  struct scdc_reorder_stats st;
+  bool reset = (argc > 1 && !strcmp(argv[1], "reset"));
+
+  scdc_reorder_get_stats(&st, reset);
+
+  printf("window   : %u (head %u, parked %u)\n", st.window, st.head, st.parked);
+  printf("in order : %u\n", st.in_order);
+  printf("reordered: %u\n", st.reordered);
+  printf("holes    : %u (timeouts %u)\n", st.holes, st.timeouts);
+  printf("late     : %u\n", st.late);
+  printf("overrun  : %u\n", st.overrun);
+  printf("batches  : %u (max %u)\n", st.batches, st.max_batch);
+
+  return 0;
 }
+#endif
 
+#if defined(FWS_CMD_INFO) || defined(CONFIG_SCDC_DATA_REORDER)
 static const struct cli_cmd fws_cmd[] =
 {
+#ifdef FWS_CMD_INFO
   CMDENTRY(info, do_fws_info, "", ""),
+#endif
+#ifdef CONFIG_SCDC_DATA_REORDER
+  CMDENTRY(reorder, do_fws_reorder, "", ""),
+#endif
 };
 
 static int do_fws(int argc, char *argv[])
@@ -584,9 +824,16 @@ static int do_fws(int argc, char *argv[])
   return cmd->handler(argc, argv);
 }
 
+#if defined(FWS_CMD_INFO) && defined(CONFIG_SCDC_DATA_REORDER)
+#define FWS_CMD_USAGE "fws info" OR "fws reorder [reset]"
+#elif defined(FWS_CMD_INFO)
+#define FWS_CMD_USAGE "fws info"
+#else
+#define FWS_CMD_USAGE "fws reorder [reset]"
+#endif
+
 CMD(fws, do_fws,
   "test routines for FWS",
-  "fws info"
+  FWS_CMD_USAGE
 );
-#endif /* CFG_FWS_DBG */
-#endif /* CFG_SUPPORT_FWS */
+#endif
@@ -60,7 +60,13 @@ uint8_t fws_comp_txstatus_len(void);
 void    fws_update_done_hslot(uint8_t* _wlh);
 uint8_t fws_report_txstatus(bool force_report, bool event_mode, uint8_t *piggy_buf);
 void    fws_enable_credit_mgmt(void);
+#ifdef CONFIG_FWS_ADAPTIVE_CREDIT
+void    fws_track_pkttag(uint8_t *tlv);
 #else
+#define fws_track_pkttag(tlv)
+#endif
+#else
+#define fws_track_pkttag(tlv)
 #define fws_piggyback_txstatus(buf) 0
 #define fws_comp_txstatus_len() 0
 #define fws_update_done_hslot(_wlh)
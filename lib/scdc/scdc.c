@@ -60,6 +60,7 @@
 #include "fws.h"
 
 #include "mtsmp.h"
+#include "ktrace.h"
 
 #include "sdio/sdioif.h"
 
@@ -174,8 +175,6 @@ typedef struct
   uint8_t out_pipe_num;
   struct list_head *out_pkts;
   osMutexId_t *mtx_out_pkts;
-  struct list_head reorder_q;
-  uint32_t out_next_seqno;
   u32 in_seqno;
   bool in_seq_sync_req;
   struct scdc_ops *ops;
@@ -197,14 +196,6 @@ typedef struct
   struct list_head list;
 } out_pkt_t;
 
-/* A list entry for a mbuf set aside due to reordering based on seqno. */
-typedef struct
-{
-  struct mbuf *m;
-  uint32_t seqno;
-  struct list_head list;
-} seq_mbuf;
-
 /* NB: consider multiple wlan instances. */
 
 /*
@@ -487,6 +478,8 @@ static int scdc_data(struct mbuf *m)
   uint8_t ext_hdr_len = 0;
   uint8_t ext_hdr_buf[SCDC_EXT_HDR_LEN] = {0};
 
+  ktrace_begin(KTRACE_SCDC_DATA, m->m_pkthdr.len);
+
   SCDC_ASSERT(ifp && vap);
 
   ifidx = get_vap_idx(dev, vap);
@@ -525,9 +518,34 @@ static int scdc_data(struct mbuf *m)
 
   osSemaphoreRelease(_scdc_ctx.sync);
 
+  ktrace_end(KTRACE_SCDC_DATA, 0);
+
   return 0;
 }
 
+/*
+ * Block until more data is queued or the kernel tick count reaches
+ * @deadline. This is for a chainwrite op that wants to aggregate, and so
+ * runs on the scdc thread; a wakeup meant for anything else is passed on
+ * to scdc_main() once we return.
+ */
+void scdc_wait_data(uint32_t deadline)
+{
+  bool woken = false;
+  int32_t left;
+
+  while (ifq_len(&_scdc_ctx.data_queue) == 0)
+  {
+    left = (int32_t)(deadline - osKernelGetTickCount());
+    if (left <= 0 || osSemaphoreAcquire(_scdc_ctx.sync, left) != osOK)
+      break;
+    woken = true;
+  }
+
+  if (woken)
+    osSemaphoreRelease(_scdc_ctx.sync);
+}
+
 static void scdc_data_handler(void)
 {
   scdc_ctx_t *sctx = &_scdc_ctx;
@@ -545,10 +563,7 @@ static void scdc_data_handler(void)
   {
     totlen = m->m_pkthdr.len;
     scdc_write(m, totlen, false);
-
-    tsmp_time_in(m, end_t);
-    tsmp_set_idx(m, 0);
-    tsmp_clean_in(m);
+    mtsmp_stamp(m, MTSMP_RX_HOST);
 
     m_freem(m);
   }
@@ -562,6 +577,7 @@ static void scdc_del_rxs(struct mbuf *m)
 void scdc_input(struct ifnet *ifp, struct mbuf *m)
 {
   SCDC_ASSERT(ifp == m->m_pkthdr.rcvif,);
+  mtsmp_start(m, MTSMP_RX_DRV);
   scdc_del_rxs(m);
   scdc_data(m);
 }
@@ -728,7 +744,7 @@ static void scdc_mbuf_free_cb(struct mbuf *m)
   out_pkt_t *outp = (out_pkt_t *)m->m_ext.ext_arg1;
   out_pkt_t local_outp = {0};
 
-  SCDC_LOG2("[%s] credit:%d(0x%x) \n", __func__, credit(outp), (uint32_t)m);
+  SCDC_LOG2("[%s] credit:%d(%p) \n", __func__, credit(outp), m);
   if (outp == NULL) {
     local_outp.ext_buf = (uint8_t *)m->m_ext.ext_arg2;
     assert(local_outp.ext_buf);
@@ -739,138 +755,345 @@ static void scdc_mbuf_free_cb(struct mbuf *m)
 }
 
 #ifdef CONFIG_SCDC_DATA_REORDER
-static seq_mbuf *find_seq(uint32_t seqno)
+/*
+ * Host-to-device data reordering.
+ *
+ * Frames are parked in a fixed ring indexed by the low bits of their
+ * seqno, relative to the next seqno we owe to the stack (the head).
+ * An occupancy bitmap tells which slots hold a frame; a slot may be
+ * occupied by a NULL mbuf when the frame could not be allocated, which
+ * still lets the sequence advance past it.
+ *
+ * A frame behind the head is late and dropped, one beyond the window
+ * pushes the head forward, and a hole that stays open for longer than
+ * CONFIG_SCDC_REORDER_HOLE_TIMEOUT ms is skipped by the scdc thread.
+ */
+
+#define SCDC_REORDER_WIN	(1 << CONFIG_SCDC_REORDER_WIN_BITS)
+#define SCDC_REORDER_MASK	(SCDC_REORDER_WIN - 1)
+#define SCDC_REORDER_WORDS	((SCDC_REORDER_WIN + 31) / 32)
+
+static struct
+{
+  struct mbuf *slot[SCDC_REORDER_WIN];
+  uint32_t occupied[SCDC_REORDER_WORDS];
+  uint32_t head;    /* next seqno to deliver */
+  uint32_t count;   /* occupied slots */
+  uint32_t hole;    /* head seqno when the hole timer was armed */
+  bool armed;
+  bool expired;
+  osTimerId_t timer;
+  osMutexId_t mtx;
+  struct scdc_reorder_stats stats;
+} _scdc_ro;
+
+static inline bool ro_test(uint32_t seqno)
+{
+  uint32_t idx = seqno & SCDC_REORDER_MASK;
+
+  return !!(_scdc_ro.occupied[idx >> 5] & BIT(idx & 31));
+}
+
+static inline void ro_set(uint32_t seqno, struct mbuf *m)
 {
-  seq_mbuf *leq = NULL, *iter;
+  uint32_t idx = seqno & SCDC_REORDER_MASK;
+
+  _scdc_ro.slot[idx] = m;
+  _scdc_ro.occupied[idx >> 5] |= BIT(idx & 31);
+  _scdc_ro.count++;
+}
 
-  list_for_each_entry(iter, &_scdc_ctx.reorder_q, list)
+static inline struct mbuf *ro_take(uint32_t seqno)
+{
+  uint32_t idx = seqno & SCDC_REORDER_MASK;
+  struct mbuf *m = _scdc_ro.slot[idx];
+
+  _scdc_ro.slot[idx] = NULL;
+  _scdc_ro.occupied[idx >> 5] &= ~BIT(idx & 31);
+  _scdc_ro.count--;
+
+  return m;
+}
+
+/* Distance from the head to the first occupied slot; count must be > 0. */
+static uint32_t ro_first_occupied(void)
+{
+  uint32_t idx = _scdc_ro.head & SCDC_REORDER_MASK;
+  uint32_t dist = 0, word;
+
+  while (dist < SCDC_REORDER_WIN)
   {
-    /* Find seq_mbuf with a seqno less than or equal. */
-    if (iter->seqno <= seqno)
+    word = _scdc_ro.occupied[idx >> 5] >> (idx & 31);
+    if (word)
     {
-      leq = iter;
+      dist += __builtin_ctz(word);
+      break;
     }
+    dist += 32 - (idx & 31);
+    idx = (idx + 32 - (idx & 31)) & SCDC_REORDER_MASK;
   }
 
-  return leq;
+  return min(dist, (uint32_t)SCDC_REORDER_WIN);
 }
 
-static void insert_pkt(seq_mbuf *smbuf)
+/* Append a frame to the batch being built for delivery. */
+static inline void ro_batch_add(struct mbuf ***tail, struct mbuf *m)
 {
-  seq_mbuf *pred = find_seq(smbuf->seqno);
+  if (m)
+  {
+    m->m_nextpkt = NULL;
+    **tail = m;
+    *tail = &m->m_nextpkt;
+  }
+}
 
-  /* Should not be duplicate. */
-  SCDC_ASSERT(!(pred && pred->seqno == smbuf->seqno),);
+/* Move the consecutive run at the head into the batch. */
+static uint32_t ro_collect_run(struct mbuf ***tail)
+{
+  uint32_t n = 0;
 
-  if (pred)
+  while (_scdc_ro.count && ro_test(_scdc_ro.head))
   {
-    list_add(&smbuf->list, &pred->list);
+    ro_batch_add(tail, ro_take(_scdc_ro.head));
+    _scdc_ro.head++;
+    n++;
   }
-  else
+
+  return n;
+}
+
+/*
+ * Advance the head to @seqno, moving whatever is still parked in between
+ * into the batch and counting the rest as holes.
+ */
+static void ro_advance(uint32_t seqno, struct mbuf ***tail)
+{
+  uint32_t gap = seqno - _scdc_ro.head;
+  uint32_t i, n = min(gap, (uint32_t)SCDC_REORDER_WIN);
+
+  for (i = 0; i < n && _scdc_ro.count; i++)
   {
-    list_add(&smbuf->list, &_scdc_ctx.reorder_q);
+    if (ro_test(_scdc_ro.head + i))
+    {
+      ro_batch_add(tail, ro_take(_scdc_ro.head + i));
+      gap--;
+    }
   }
+  _scdc_ro.stats.holes += gap;
+  _scdc_ro.head = seqno;
 }
 
-static void flush_reorderq(bool discard)
+static void ro_timer_update(void)
+{
+  if (!_scdc_ro.count)
+  {
+    if (_scdc_ro.armed)
+    {
+      osTimerStop(_scdc_ro.timer);
+      _scdc_ro.armed = false;
+    }
+    _scdc_ro.expired = false;
+    return;
+  }
+
+  /* (Re)start the clock whenever the head is waiting on a new hole. */
+  if (!_scdc_ro.armed || _scdc_ro.hole != _scdc_ro.head)
+  {
+    _scdc_ro.hole = _scdc_ro.head;
+    _scdc_ro.armed = true;
+    _scdc_ro.expired = false;
+    osTimerStart(_scdc_ro.timer,
+        max(1U, CONFIG_SCDC_REORDER_HOLE_TIMEOUT * osKernelGetTickFreq() / 1000));
+  }
+}
+
+static inline void ro_account(uint32_t n)
+{
+  if (n)
+  {
+    _scdc_ro.stats.batches++;
+    if (n > _scdc_ro.stats.max_batch)
+      _scdc_ro.stats.max_batch = n;
+  }
+}
+
+/*
+ * Hand a batch of in-order frames to the stack. This runs outside of the
+ * reorder lock so that the rx path can keep parking frames meanwhile.
+ *
+ * if_output is still called once per frame: it is ether_output(), which
+ * queues exactly one packet (_IF_ENQUEUE() clears m_nextpkt), so a chain
+ * would lose all but its head. The batch saves the lock round trips.
+ */
+static void ro_deliver(struct mbuf *batch)
 {
-  seq_mbuf *smbuf, *tmp;
   struct ifnet *ifp;
   struct mbuf *m;
 
-  list_for_each_entry_safe(smbuf, tmp, &_scdc_ctx.reorder_q, list)
+  while ((m = batch) != NULL)
   {
-    list_del(&smbuf->list);
-    m = smbuf->m;
-    if (discard)
-    {
-      m_freem(m);
-    }
-    else
+    batch = m->m_nextpkt;
+    m->m_nextpkt = NULL;
+    ifp = m->m_pkthdr.rcvif;
+    ifp->if_output(ifp, m, NULL, NULL);
+  }
+}
+
+static void ro_hole_timeout(void *arg)
+{
+  (void)arg;
+
+  /* Skip the hole from the scdc thread rather than the timer daemon. */
+  _scdc_ro.expired = true;
+  osSemaphoreRelease(_scdc_ctx.sync);
+}
+
+/* Drop everything parked; called with the reorder lock held. */
+static void ro_discard(void)
+{
+  while (_scdc_ro.count)
+  {
+    if (ro_test(_scdc_ro.head))
+      m_freem(ro_take(_scdc_ro.head));
+    _scdc_ro.head++;
+  }
+  ro_timer_update();
+}
+
+static void scdc_reorder_expire(void)
+{
+  struct mbuf *batch = NULL, **tail = &batch;
+
+  if (!_scdc_ro.expired)
+    return;
+
+  osMutexAcquire(_scdc_ro.mtx, osWaitForever);
+  if (_scdc_ro.expired)
+  {
+    _scdc_ro.expired = false;
+    _scdc_ro.armed = false;
+    if (_scdc_ro.count && _scdc_ro.hole == _scdc_ro.head)
     {
-      ifp = m->m_pkthdr.rcvif;
-      ifp->if_output(ifp, m, NULL, NULL);
-      /* how about out_next_seqno? */
+      _scdc_ro.stats.timeouts++;
+      ro_advance(_scdc_ro.head + ro_first_occupied(), &tail);
+      ro_account(ro_collect_run(&tail));
     }
-    free(smbuf);
+    ro_timer_update();
   }
+  osMutexRelease(_scdc_ro.mtx);
+
+  ro_deliver(batch);
 }
 
 static void print_reorder_q(uint32_t seqno) __maybe_unused;
 static void print_reorder_q(uint32_t seqno)
 {
-  seq_mbuf *smbuf;
+  uint32_t i;
 
-  SCDC_LOG1("[%s] new:0x%X\n", __func__, seqno);
-  list_for_each_entry(smbuf, &_scdc_ctx.reorder_q, list)
+  SCDC_LOG1("[%s] new:0x%X head:0x%X\n", __func__, seqno, _scdc_ro.head);
+  for (i = 0; i < SCDC_REORDER_WIN; i++)
   {
-    SCDC_LOG1("(0x%x)", smbuf->seqno);
+    if (ro_test(_scdc_ro.head + i))
+      SCDC_LOG1("(0x%x)", _scdc_ro.head + i);
   }
   SCDC_LOG1("\n");
 }
 
 static void reorder_pkt(struct mbuf *m, uint32_t seqno, bool sync)
 {
-  seq_mbuf *smbuf;
+  struct mbuf *batch = NULL, **tail = &batch;
+  uint32_t n = 0;
+  int32_t off;
 
-  /* We will include a smbuf node even if mbuf couldn't be allocated
-   * for it. It will make things simpler especially in terms of maintain
-   * sequence numbers.
+  /* A slot is taken even if mbuf couldn't be allocated for this frame,
+   * so that the sequence can move past it.
    */
 
+  osMutexAcquire(_scdc_ro.mtx, osWaitForever);
+
   if (sync)
   {
-    flush_reorderq(true);
-    _scdc_ctx.out_next_seqno = seqno;
+    ro_discard();
+    _scdc_ro.head = seqno;
   }
 
-  if (seqno == _scdc_ctx.out_next_seqno)
-  {
-    /* Now we can deliver this one and all queued packets
-     * until we meet a hole.
-     */
+  off = (int32_t)(seqno - _scdc_ro.head);
 
-    struct ifnet *ifp;
-    seq_mbuf *tmp;
-
-    if (m)
-    {
-      ifp = m->m_pkthdr.rcvif;
-      ifp->if_output(ifp, m, NULL, NULL);
-    }
+  if (off < 0 || (off < SCDC_REORDER_WIN && ro_test(seqno)))
+  {
+    /* Already delivered, skipped or parked. */
+    _scdc_ro.stats.late++;
+    osMutexRelease(_scdc_ro.mtx);
+    m_freem(m);
+    return;
+  }
 
-    _scdc_ctx.out_next_seqno++;
+  if (off >= SCDC_REORDER_WIN)
+  {
+    /* Slide the window so that this frame is its last slot. */
+    _scdc_ro.stats.overrun++;
+    ro_advance(seqno - SCDC_REORDER_WIN + 1, &tail);
+    n = ro_collect_run(&tail);
+  }
 
-    list_for_each_entry_safe(smbuf, tmp, &_scdc_ctx.reorder_q, list)
-    {
-      if (smbuf->seqno == _scdc_ctx.out_next_seqno)
-      {
-        list_del(&smbuf->list);
-        if (smbuf->m)
-        {
-          ifp = smbuf->m->m_pkthdr.rcvif;
-          ifp->if_output(ifp, smbuf->m, NULL, NULL);
-        }
-        free(smbuf);
-        _scdc_ctx.out_next_seqno++;
-      }
-    }
+  if (seqno == _scdc_ro.head && !_scdc_ro.count)
+  {
+    /* Fast path: nothing is parked, hand it straight over. */
+    _scdc_ro.stats.in_order++;
+    ro_batch_add(&tail, m);
+    _scdc_ro.head++;
+    n++;
   }
   else
   {
-    /* Add this packet to the right position in the
-     * reorder queue.
-     */
-    smbuf = kzalloc(sizeof(*smbuf));
-    smbuf->m = m;
-    smbuf->seqno = seqno;
-    insert_pkt(smbuf);
+    if (seqno != _scdc_ro.head)
+      _scdc_ro.stats.reordered++;
+    ro_set(seqno, m);
+    n += ro_collect_run(&tail);
   }
 
+  ro_account(n);
+  ro_timer_update();
+
 #if 0
   print_reorder_q(seqno);
 #endif
+
+  osMutexRelease(_scdc_ro.mtx);
+
+  ro_deliver(batch);
 }
+
+static void scdc_reorder_init(void)
+{
+  memset(&_scdc_ro, 0, sizeof(_scdc_ro));
+
+  _scdc_ro.mtx = osMutexNew(NULL);
+  SCDC_ASSERT(_scdc_ro.mtx);
+
+  _scdc_ro.timer = osTimerNew(ro_hole_timeout, osTimerOnce, NULL, NULL);
+  SCDC_ASSERT(_scdc_ro.timer);
+}
+
+int scdc_reorder_get_stats(struct scdc_reorder_stats *stats, bool reset)
+{
+  osMutexAcquire(_scdc_ro.mtx, osWaitForever);
+  if (stats)
+  {
+    *stats = _scdc_ro.stats;
+    stats->parked = _scdc_ro.count;
+    stats->head = _scdc_ro.head;
+    stats->window = SCDC_REORDER_WIN;
+  }
+  if (reset)
+    memset(&_scdc_ro.stats, 0, sizeof(_scdc_ro.stats));
+  osMutexRelease(_scdc_ro.mtx);
+
+  return 0;
+}
+#else
+#define scdc_reorder_init()
+#define scdc_reorder_expire()
 #endif
 
 static void scdc_main(void *argument)
@@ -884,6 +1107,7 @@ static void scdc_main(void *argument)
     scdc_awake_host();
     scdc_event_handler();
     scdc_data_handler();
+    scdc_reorder_expire();
   }
 }
 
@@ -914,7 +1138,7 @@ int scdc_init(void)
   ifq_init(&_scdc_ctx.data_queue, NULL);
   IFQ_SET_MAX_LEN(&_scdc_ctx.data_queue, CONFIG_MEMP_NUM_MBUF_CACHE);
 
-  INIT_LIST_HEAD(&_scdc_ctx.reorder_q);
+  scdc_reorder_init();
 
   fwil_init();
   fweh_init();
@@ -1089,6 +1313,7 @@ void scdc_vendor_rx_cb(uint8_t itf, int outidx, uint16_t len, void *priv)
   pfinfo->ptr_lin -= pfinfo->pre_len;
 
   fws_update_dbg_info(pkt->finfo.ptr_lin + sizeof(hdr), pkt->seqno, outidx);
+  fws_track_pkttag(pkt->finfo.ptr_lin + sizeof(hdr));
 
   SCDC_ASSERT(((hdr.flags & SCDC_FLAG_VER_MASK) >> SCDC_FLAG_VER_SHIFT) ==
     SCDC_PROTO_VER,);
@@ -1156,7 +1381,7 @@ void scdc_vendor_rx_cb(uint8_t itf, int outidx, uint16_t len, void *priv)
   {
     m_dyna_extadd(m, (caddr_t)(pfinfo->ptr_lin + pfinfo->pre_len),
     pfinfo->len_lin - pfinfo->pad_len - pfinfo->pre_len,
-    scdc_mbuf_free_cb, pkt->ext_buf ? 0 : (uint32_t)pkt, (uint32_t)pkt->ext_buf, 0, EXT_IPCRING);
+    scdc_mbuf_free_cb, pkt->ext_buf ? 0 : (uintptr_t)pkt, (uintptr_t)pkt->ext_buf, 0, EXT_IPCRING);
   }
   else
   {
@@ -1214,22 +1439,10 @@ reorder:
   if (!m_cache)
     osMutexRelease(_scdc_ctx.mtx_out_pkts[outidx]);
 
-  SCDC_LOG2("[%s, %d] m:0x%08x   (%04d, 0x%08x), seqno:%08d\n", __func__, __LINE__,
-    (uint32_t)m, m_length(m, NULL), m->m_flags, hdr.seqno);
-
-#ifdef CONFIG_SUPPORT_MTSMP
-  if (m->m_pkthdr.len > PACKET_LEN_THR) {
-    if (tsmp_get_count(outcount) >= COUNT_NUM)
-      tsmp_set_count(outcount, 0);
-      SCDC_LOG2("[%s, %d] len: %d m: %p\n", __func__, __LINE__, m->m_pkthdr.len, m);
-      if (!tsmp_valid(out[tsmp_get_count(outcount)])) {
-        tsmp_set_idx(m, tsmp_get_count(outcount) + 1);
-        tsmp_set_out(m, m_out, (void * )m);
-        tsmp_time_out(m, start_t);
-      }
-      tsmp_inc_count(outcount);
-  }
-#endif
+  SCDC_LOG2("[%s, %d] m:%p   (%04d, 0x%08x), seqno:%08d\n", __func__, __LINE__,
+    m, m_length(m, NULL), m->m_flags, hdr.seqno);
+
+  mtsmp_start(m, MTSMP_TX_HOST);
 
 #ifdef CONFIG_SCDC_DATA_REORDER
   reorder_pkt(m, hdr.seqno, !!(hdr.flags & SCDC_FLAG_SEQ_SYNC));
@@ -1359,9 +1572,6 @@ int scdc_vendor_get_buf(int size, uint32_t *offset, uint8_t **buf, uint8_t **buf
 int scdc_vendor_dump_out_pkts(void)
 {
   int outidx = 0;
-  int count __maybe_unused = 0;
-  seq_mbuf *smbuf;
-
 
   for(outidx = 0; outidx < _scdc_ctx.out_pipe_num; outidx++)
   {
@@ -1380,13 +1590,10 @@ int scdc_vendor_dump_out_pkts(void)
     osMutexRelease(_scdc_ctx.mtx_out_pkts[outidx]);
   }
 
-  count  = 0;
-  SCDC_LOG1("next_seqno (%4d) \n", _scdc_ctx.out_next_seqno);
-
-  list_for_each_entry(smbuf, &_scdc_ctx.reorder_q, list)
-  {
-    SCDC_LOG1("reorder_q[%2d] seqno (%4d) \n", count++, smbuf->seqno);
-  }
+#ifdef CONFIG_SCDC_DATA_REORDER
+  SCDC_LOG1("next_seqno (%4d) parked (%d) \n", _scdc_ro.head, _scdc_ro.count);
+  print_reorder_q(_scdc_ro.head);
+#endif
 
   return 0;
 }
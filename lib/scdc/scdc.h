@@ -60,7 +60,11 @@
  * hardware header, 802.11 header, cipher header, and A-MSDU header.
  * 28 (HW HDR) + 26 (QoS HDR) + 8 (Cipher) + 14 (A-MSDU HDR) + (CONFIG_MAX_AMSDU_NUM * Buffer descriptor * CONFIG_BDS_HDR_NUM) (BDS head)
  */
+#ifdef CONFIG_WLAN
 #define SCM_BDS_HDR_SIZE (CONFIG_MAX_AMSDU_NUM * (12/*sizeof(struct bdesc)*/ * CONFIG_BDS_HDR_NUM))
+#else
+#define SCM_BDS_HDR_SIZE 0
+#endif
 
 #ifdef CONFIG_SUPPORT_BDS_ADJ
 #define SCM_BDS_ADJ_SIZE SCM_BDS_HDR_SIZE
@@ -108,6 +112,25 @@ struct scdc_buffer *scdc_alloc_buffer(uint32_t payloadlen);
 int scdc_event(int ifidx, struct scdc_buffer *scdc_buf, uint8_t data_offset);
 int scdc_init(void);
 uint32_t scdc_get_out_size(bool cnt_in_pkts);
+void scdc_wait_data(uint32_t deadline);
+
+#ifdef CONFIG_SCDC_DATA_REORDER
+struct scdc_reorder_stats {
+  uint32_t in_order;  ///< frames delivered without being parked
+  uint32_t reordered; ///< frames parked ahead of a hole
+  uint32_t holes;     ///< seqnos given up on (timeout or overrun)
+  uint32_t late;      ///< frames behind the head or duplicated, dropped
+  uint32_t overrun;   ///< frames beyond the window, pushing the head
+  uint32_t timeouts;  ///< hole timer expirations that skipped a hole
+  uint32_t batches;   ///< runs handed to the stack
+  uint32_t max_batch; ///< longest run handed over at once
+  uint32_t parked;    ///< frames currently in the window
+  uint32_t head;      ///< next seqno to be delivered
+  uint32_t window;    ///< window size in frames
+};
+
+int scdc_reorder_get_stats(struct scdc_reorder_stats *stats, bool reset);
+#endif
 
 //--------------------------------------------------------------------+
 // Application Callback API (weak is optional)
@@ -48,12 +48,16 @@
 #include <scm2020_var.h>
 #include <hal/sdio.h>
 #include <scdc.h>
+#include <fwil_types.h>
+#include <fwil.h>
 #include <hal/kmem.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include "sdioif.h"
 #include "sdio-fifo.h"
 #include "sdio-filter.h"
+#include "ktrace.h"
+#include "mtsmp.h"
 
 #define SDIO_FN_TX 1
 #define SDIO_FN_RX 2
@@ -260,6 +264,7 @@ void sdio_vendor_write(void *buffer, uint32_t bufsize, bool isevent)
 		sdio_hdr_fill_firstfrag(mtod(m0, u8 *), m0->m_pkthdr.len);
 	}
 
+	ktrace_begin(KTRACE_SDIO_WRITE, m0->m_pkthdr.len);
 	for (m = m0; (m != NULL) && (m->m_len != 0); m = m->m_next) {
 		len = m->m_len;
 		buf = mtod(m, u8 *);
@@ -267,6 +272,7 @@ void sdio_vendor_write(void *buffer, uint32_t bufsize, bool isevent)
 		sdio_dump_data(buf, len);
 		sdio_tx(dev, SDIO_FN_TX, buf, len);
 	}
+	ktrace_end(KTRACE_SDIO_WRITE, 0);
 
 	/* allocated mbuf should be released */
 	if (isevent)
@@ -337,6 +343,7 @@ void sdio_vendor_chainwrite(struct ifqueue *data_queue)
 		while ((m0 = freem_list) != NULL) {
 			freem_list = freem_list->m_nextpkt;
 			m0->m_nextpkt = NULL;
+			mtsmp_stamp(m0, MTSMP_RX_HOST);
 			m_freem(m0);
 		}
 	} else {
@@ -345,6 +352,171 @@ void sdio_vendor_chainwrite(struct ifqueue *data_queue)
 }
 #endif
 
+#ifdef CONFIG_SDIO_TXGLOM
+/*
+ * TX aggregation (glom) for the non-chained path.
+ *
+ * Data frames waiting in the scdc queue are copied back to back into a
+ * superframe that goes out with a single sdio_tx(). The superframe carries
+ * an outer SDPCM header on SDPCM_GLOM_CHANNEL, and each subframe keeps the
+ * SDPCM header it would have had on its own, starting on a 4-byte boundary.
+ * A zero-length subframe header or the end of the superframe ends the walk.
+ * Transfers longer than one block are padded to a block multiple.
+ *
+ * Glomming stays off until the host sets the "txglom" iovar to the glom
+ * protocol version it understands. Older hosts never do, and keep getting
+ * one frame per transfer.
+ */
+
+static struct sdio_txglom {
+	u8 buf[CONFIG_SDIO_TXGLOM_MAX_SIZE] __aligned(SDIO_DMA_ALIGNMENT);
+	u16 version;	/* negotiated with the host, 0 if disabled */
+	u16 max_size;
+	u32 supers;	/* superframes sent */
+	u32 frames;	/* frames sent within superframes */
+	u32 singles;	/* frames sent on their own */
+	u32 pad;	/* block padding bytes */
+} sdio_glom;
+
+static void sdio_glom_flush(u16 off, u8 nframes)
+{
+	struct sdio_netif_context *ctx = &sdio_netif_ctx;
+	u8 *buf = sdio_glom.buf;
+	u16 len;
+
+	if (nframes == 1) {
+		/* Not worth the outer header, send the subframe as is. */
+		len = le16toh(*(u16 *)(buf + SDPCM_HDRLEN));
+		sdio_dump_data(buf + SDPCM_HDRLEN, len);
+		sdio_tx(ctx->dev, SDIO_FN_TX, buf + SDPCM_HDRLEN, len);
+		sdio_glom.singles++;
+		return;
+	}
+
+	len = off > SDIO_BLOCK_SIZE ? roundup(off, SDIO_BLOCK_SIZE) : off;
+	if (len > sizeof(sdio_glom.buf))
+		len = sizeof(sdio_glom.buf);
+	memset(buf + off, 0, len - off);
+
+	sdio_hdr_pack(buf, len, SDPCM_GLOM_CHANNEL, 0);
+
+	sdio_dump_data(buf, len);
+	sdio_tx(ctx->dev, SDIO_FN_TX, buf, len);
+
+	sdio_glom.supers++;
+	sdio_glom.frames += nframes;
+	sdio_glom.pad += len - off;
+}
+
+/* Give more frames a chance to arrive within the latency budget. */
+static void sdio_glom_linger(struct ifqueue *data_queue, u32 start)
+{
+#if CONFIG_SDIO_TXGLOM_LATENCY_MS > 0
+	u32 budget = max(1U, CONFIG_SDIO_TXGLOM_LATENCY_MS * osKernelGetTickFreq() / 1000);
+
+	if (ifq_len(data_queue) == 0)
+		scdc_wait_data(start + budget);
+#endif
+}
+
+void sdio_vendor_glomwrite(struct ifqueue *data_queue)
+{
+	struct sdio_netif_context *ctx __maybe_unused = &sdio_netif_ctx;
+	u8 *buf = sdio_glom.buf;
+	u16 off = SDPCM_HDRLEN;
+	u8 nframes = 0;
+	u32 start = 0;
+	struct mbuf *m;
+	u16 len;
+
+	if (!sdio_glom.version) {
+		while ((m = ifq_dequeue(data_queue))) {
+			sdio_vendor_write(m, m->m_pkthdr.len, false);
+			mtsmp_stamp(m, MTSMP_RX_HOST);
+			m_freem(m);
+		}
+		return;
+	}
+
+#ifdef CONFIG_SDIO_RECOVERY
+	/* block until recover done */
+	while (ctx->recover == true) {
+		osDelay(1);
+	}
+#endif
+
+	while ((m = ifq_dequeue(data_queue))) {
+		len = SDPCM_HDRLEN + m->m_pkthdr.len;
+
+		if (nframes == 0) {
+			start = osKernelGetTickCount();
+			if (ifq_len(data_queue) == 0)
+				sdio_glom_linger(data_queue, start);
+		}
+
+		if (nframes == 0 && (ifq_len(data_queue) == 0 ||
+				SDPCM_HDRLEN + len > sdio_glom.max_size)) {
+			/* Nothing to glom with, or too big: send it in place. */
+			sdio_vendor_write(m, m->m_pkthdr.len, false);
+			sdio_glom.singles++;
+			mtsmp_stamp(m, MTSMP_RX_HOST);
+			m_freem(m);
+			continue;
+		}
+
+		if (off + len > sdio_glom.max_size ||
+				nframes == CONFIG_SDIO_TXGLOM_MAX_FRAMES) {
+			sdio_glom_flush(off, nframes);
+			off = SDPCM_HDRLEN;
+			nframes = 0;
+			/* Reconsider this frame as the head of a new superframe. */
+			IF_PREPEND(data_queue, m);
+			continue;
+		}
+
+		sdio_hdr_pack(buf + off, len, SDPCM_DATA_CHANNEL, 0);
+		m_copydata(m, 0, m->m_pkthdr.len, (caddr_t)(buf + off + SDPCM_HDRLEN));
+		/* on its way to the host with the superframe */
+		mtsmp_stamp(m, MTSMP_RX_HOST);
+		m_freem(m);
+
+		off += roundup2(len, SDIO_DMA_ALIGNMENT);
+		nframes++;
+
+		if (ifq_len(data_queue) == 0)
+			sdio_glom_linger(data_queue, start);
+	}
+
+	if (nframes)
+		sdio_glom_flush(off, nframes);
+}
+
+static int fwil_var_txglom(fwil_var_handler_t *fvh)
+{
+	fwil_handler_t *fh = fvh->fh;
+	u32 val;
+	u16 ver, size;
+
+	if (fh->set) {
+		/* host glom version in [15:0], its max superframe size in [31:16] */
+		memcpy(&val, &fh->buf[fh->off], sizeof(val));
+		ver = val & 0xffff;
+		size = val >> 16;
+		sdio_glom.version = min(ver, (u16)SDIO_TXGLOM_VERSION);
+		sdio_glom.max_size = sizeof(sdio_glom.buf);
+		if (size && size < sdio_glom.max_size)
+			sdio_glom.max_size = size & ~(SDIO_DMA_ALIGNMENT - 1);
+	} else {
+		val = SDIO_TXGLOM_VERSION | ((u32)sizeof(sdio_glom.buf) << 16);
+		memcpy(fh->buf, &val, sizeof(val));
+	}
+
+	return 0;
+}
+
+FWIL_VAR_HANDLER(txglom, fwil_var_txglom);
+#endif
+
 void sdio_vendor_get_read_info(u8 itf, u8 outidx, void *pinfo)
 {
 	struct sdio_netif_context *ctx = &sdio_netif_ctx;
@@ -418,6 +590,8 @@ struct scdc_ops sdio_scdc_ops = {
 	.prep_in = sdio_vendor_pre_in,
 #ifdef CONFIG_SDIO_TXCHAIN
 	.chainwrite = sdio_vendor_chainwrite,
+#elif defined(CONFIG_SDIO_TXGLOM)
+	.chainwrite = sdio_vendor_glomwrite,
 #endif
 #ifdef CONFIG_SDIO_PM
 	.awake_host = sdio_notify_host_reenum,
@@ -994,6 +1168,16 @@ static int do_sdio_fifo_status(int argc, char *argv[])
 	return CMD_RET_SUCCESS;
 }
 
+#ifdef CONFIG_SDIO_TXGLOM
+static int do_sdio_glom(int argc, char *argv[])
+{
+	printk("glom version %u max %u\n", sdio_glom.version, sdio_glom.max_size);
+	printk("superframes %u frames %u singles %u pad %u\n", sdio_glom.supers,
+		sdio_glom.frames, sdio_glom.singles, sdio_glom.pad);
+	return CMD_RET_SUCCESS;
+}
+#endif
+
 extern int do_sdio_read_status(int argc, char *argv[]);
 extern int do_sdio_write_status(int argc, char *argv[]);
 extern int do_sdio_read_reg(int argc, char *argv[]);
@@ -1022,6 +1206,9 @@ static const struct cli_cmd sdio_cmd[] = {
 #ifdef CONFIG_SDIO_TXCHAIN
 	CMDENTRY(txchain, do_sdio_txchain, "", ""),
 #endif
+#ifdef CONFIG_SDIO_TXGLOM
+	CMDENTRY(glom, do_sdio_glom, "", ""),
+#endif
 };
 
 static int do_sdio(int argc, char *argv[])
@@ -1046,6 +1233,9 @@ CMD(sdio, do_sdio, "CLI comamands for SDIO",
 #endif
 #ifdef CONFIG_SDIO_RECOVERY
 	"sdio recover" OR
+#endif
+#ifdef CONFIG_SDIO_TXGLOM
+	"sdio glom" OR
 #endif
 	"sdio to" OR "sdio filter" OR "sdio status" OR "sdio rx_info" OR
 	"sdio fifo_status" OR "sdio r_status" OR "sdio w_status");
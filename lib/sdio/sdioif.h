@@ -33,9 +33,17 @@
 #define SDPCM_CONTROL_CHANNEL 0 /* Control */
 #define SDPCM_EVENT_CHANNEL 1	/* Asyc Event Indication */
 #define SDPCM_DATA_CHANNEL 2	/* Data Xmit/Recv */
+#define SDPCM_GLOM_CHANNEL 3	/* Superframe of SDPCM subframes */
 #define SDPCM_DOFFSET_MASK 0xff000000
 #define SDPCM_DOFFSET_SHIFT 24
 
+/*
+ * Version of the superframe layout sent on SDPCM_GLOM_CHANNEL, exchanged
+ * with the host through the "txglom" iovar. Bump it whenever the layout
+ * changes; the firmware never sends a layout newer than the host's.
+ */
+#define SDIO_TXGLOM_VERSION 1
+
 #define SCDC_REQUEST_SET (0)
 #define SCDC_REQUEST_GET (1)
 
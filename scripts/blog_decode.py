@@ -0,0 +1,178 @@
+#!/usr/bin/env python3
+#
+# Copyright 2024-2024 Senscomm Semiconductor Co., Ltd.	All rights reserved.
+#
+# Render a dump of the kernel binary log ring (CONFIG_BLOG) on the host.
+#
+# The ring only holds format string pointers, so the ELF the target was
+# running is needed to look them up. Dump the control block, e.g. from gdb:
+#
+#   dump binary memory blog.bin &blog (char *)&blog + sizeof(blog)
+#   dump binary memory tags.bin &s_log_tags (char *)&s_log_tags + sizeof(s_log_tags)
+#
+# and run:
+#
+#   scripts/blog_decode.py wise.elf blog.bin [tags.bin]
+#
+# The tag table dump is optional; without it WISE_LOGx() tags are shown
+# by ID.
+
+import re
+import struct
+import sys
+
+from elftools.elf.elffile import ELFFile
+
+F_COMMIT = 1 << 0
+F_PAD = 1 << 1
+F_TEXT = 1 << 2
+
+LEVELS = 'NEWIDV'
+
+SPEC = re.compile(r'%([-+#.0-9*]*)(hh|h|ll|l|q|j|z|t)?([%cdiouxXrypsb])')
+
+
+class Image:
+    def __init__(self, path):
+        self.elf = ELFFile(open(path, 'rb'))
+        self.word = self.elf.elfclass // 8
+        self.endian = '<'
+
+    def cstr(self, addr):
+        for sec in self.elf.iter_sections():
+            start = sec['sh_addr']
+            if sec['sh_type'] == 'SHT_NOBITS' or not start:
+                continue
+            if start <= addr < start + sec['sh_size']:
+                data = sec.data()[addr - start:]
+                return data[:data.index(b'\0')].decode(errors='replace')
+        return '<%#x?>' % addr
+
+
+def render(fmt, args, img):
+    out = []
+    pos = 0
+    a = 0
+
+    def take(n=1):
+        nonlocal a
+        v = args[a:a + n]
+        a += n
+        return v
+
+    for m in SPEC.finditer(fmt):
+        out.append(fmt[pos:m.start()])
+        pos = m.end()
+        flags, size, conv = m.groups()
+        while '*' in flags:
+            flags = flags.replace('*', str(struct.unpack('i', struct.pack('I', take()[0]))[0]), 1)
+        if conv == '%':
+            out.append('%')
+            continue
+        if conv == 's':
+            s, n = args_str(args, a, img.word)
+            a += n
+            out.append(('%' + flags + 's') % s)
+            continue
+        if conv == 'p':
+            out.append('%#x' % take()[0])
+            continue
+        if conv == 'b':
+            v, desc = take(2)
+            desc = img.cstr(desc).encode('latin-1')
+            out.append(bits(v, desc))
+            continue
+        if size in ('ll', 'q', 'j') and img.word == 4:
+            lo, hi = take(2)
+            v = lo | hi << 32
+            bitsz = 64
+        else:
+            v = take()[0]
+            bitsz = 64 if size in ('ll', 'q', 'j') else img.word * 8 if size in ('l', 'z', 't') else 32
+            v &= (1 << bitsz) - 1
+        if conv in 'diy' and v >> (bitsz - 1):
+            v -= 1 << bitsz
+        py = {'r': 'd', 'y': 'x', 'c': 'c'}.get(conv, conv)
+        out.append(('%' + flags + py) % v)
+    out.append(fmt[pos:])
+    return ''.join(out)
+
+
+def args_str(args, a, word):
+    raw = b''.join(struct.pack('<I' if word == 4 else '<Q', w) for w in args[a:])
+    s = raw[:raw.index(b'\0')]
+    return s.decode(errors='replace'), (len(s) + word) // word
+
+
+def bits(v, desc):
+    base, desc = desc[0], desc[1:]
+    s = {8: '%o', 10: '%d', 16: '%x'}.get(base, '%d') % v
+    names = []
+    for m in re.finditer(rb'([\x01-\x20])([^\x01-\x20]*)', desc):
+        if v & (1 << (m.group(1)[0] - 1)):
+            names.append(m.group(2).decode())
+    return s + ('<' + ','.join(names) + '>' if v and names else '')
+
+
+def main():
+    if len(sys.argv) < 3:
+        sys.exit('usage: %s ELF BLOG_DUMP [TAGS_DUMP]' % sys.argv[0])
+
+    img = Image(sys.argv[1])
+    w = img.word
+    wfmt = img.endian + ('I' if w == 4 else 'Q')
+    data = open(sys.argv[2], 'rb').read()
+    head, tail, dropped, _ = struct.unpack_from(img.endian + ('4I' if w == 4 else '4Q'), data)
+    ring = [struct.unpack_from(wfmt, data, off)[0] for off in range(4 * w, len(data), w)]
+    nwords = len(ring)
+
+    tags = []
+    if len(sys.argv) > 3:
+        raw = open(sys.argv[3], 'rb').read()
+        for off in range(0, len(raw), 2 * w):
+            name = struct.unpack_from(wfmt, raw, off)[0]
+            tags.append(img.cstr(name) if name else None)
+
+    hdr = 3 if w == 8 else 4
+    # Whatever is older than one ring size has been overwritten.
+    tail = max(tail, head - nwords)
+    last = '\n'
+    while tail < head:
+        i = tail % nwords
+        w0 = ring[i]
+        size = w0 & 0xffff
+        flags = (w0 >> 24) & 0xff
+        level = (w0 >> 16) & 0xff
+        if size == 0 or not flags & F_COMMIT:
+            break
+        if not flags & F_PAD:
+            rec = ring[i:i + size]
+            if w == 8:
+                tag, ts = rec[0] >> 32 & 0xffff, rec[1] & 0xffffffff
+            else:
+                tag, ts = rec[1] & 0xffff, rec[2]
+            fmt_ptr = rec[hdr - 1]
+            args = rec[hdr:]
+            if flags & F_TEXT:
+                text, _ = args_str(args, 0, w)
+            else:
+                text = render(img.cstr(fmt_ptr), args, img)
+            if tag == 0:
+                line = ('[%06u.%06u] ' % (ts // 1000000, ts % 1000000) if last == '\n' else '') + text
+            else:
+                name = tags[tag - 1] if tag - 1 < len(tags) and tags[tag - 1] else '#%d' % tag
+                line = ('' if last == '\n' else '\n') + '%c (%u) %s: %s' % (
+                    LEVELS[level] if level < len(LEVELS) else 'N', ts // 1000, name, text)
+                if not line.endswith('\n'):
+                    line += '\n'
+            sys.stdout.write(line)
+            if line:
+                last = line[-1]
+        tail += size
+
+    if dropped:
+        print('<%u log records dropped>' % dropped)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,64 @@
+#!/usr/bin/env python3
+#
+# Copyright 2024-2024 Senscomm Semiconductor Co., Ltd.	All rights reserved.
+#
+# Convert the output of the 'ktrace dump' command (CONFIG_KTRACE) into
+# Chrome trace event JSON, which chrome://tracing and ui.perfetto.dev load.
+#
+#   scripts/ktrace2json.py console.log > trace.json
+#
+# Lines that are not part of the dump (prompt, other output) are ignored.
+
+import json
+import sys
+
+PID = 1
+IRQ_TID = 0
+
+
+def main():
+    src = open(sys.argv[1]) if len(sys.argv) > 1 else sys.stdin
+    tasks = {}
+    events = []
+    last = None
+    wrap = 0
+
+    for line in src:
+        f = line.split()
+        if len(f) >= 4 and f[0] == 'T':
+            tasks[int(f[1], 16)] = (int(f[2]), ' '.join(f[3:]))
+        elif len(f) == 6 and f[0] == 'E':
+            ts = int(f[1])
+            # The microsecond stamp is 32 bits wide; only a jump back
+            # by more than half its range is a wrap, anything smaller is
+            # events that were stamped slightly out of order.
+            if last is not None and last - (ts + wrap) > 1 << 31:
+                wrap += 1 << 32
+            ts += wrap
+            last = ts
+            ctx = int(f[4], 16)
+            events.append((ts, f[2], f[3], ctx, int(f[5], 16)))
+
+    out = [{'ph': 'M', 'name': 'process_name', 'pid': PID,
+            'args': {'name': 'wise'}},
+           {'ph': 'M', 'name': 'thread_name', 'pid': PID, 'tid': IRQ_TID,
+            'args': {'name': 'irq'}}]
+    seen = set()
+    for ts, ph, name, ctx, arg in events:
+        tid = tasks.get(ctx, (ctx, None))[0] if ctx else IRQ_TID
+        if ctx and tid not in seen:
+            seen.add(tid)
+            label = tasks.get(ctx, (None, '%#x' % ctx))[1]
+            out.append({'ph': 'M', 'name': 'thread_name', 'pid': PID,
+                        'tid': tid, 'args': {'name': label}})
+        ev = {'ph': ph, 'name': name, 'ts': ts, 'pid': PID, 'tid': tid,
+              'args': {'arg': '%#x' % arg}}
+        if ph == 'i':
+            ev['s'] = 't'
+        out.append(ev)
+
+    json.dump({'traceEvents': out}, sys.stdout)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,122 @@
+#!/usr/bin/env python3
+#
+# Copyright 2024-2024 Senscomm Semiconductor Co., Ltd.	All rights reserved.
+#
+# Symbolize the output of the 'prof dump' command (CONFIG_PROF).
+#
+#   scripts/prof2sym.py console.log wise.elf [hal/soc/scm2010/wise.rom_v2.ld]
+#
+# prints a flat profile, functions sorted by sample count, and
+#
+#   scripts/prof2sym.py --folded console.log wise.elf ... > prof.folded
+#
+# prints 'task;function count' lines that flamegraph.pl or speedscope
+# take as they are. Any number of ELF files and linker scripts with
+# 'symbol = 0xaddress;' assignments (the ROM symbol tables) can be given;
+# lines of the dump that are not samples are ignored.
+
+import argparse
+import bisect
+import collections
+import re
+
+from elftools.elf.elffile import ELFFile
+from elftools.elf.sections import SymbolTableSection
+
+LDSYM = re.compile(r'^\s*([A-Za-z_][\w.$]*)\s*=\s*(0x[0-9a-fA-F]+)\s*;')
+
+
+class Symbols:
+    def __init__(self):
+        self.syms = {}
+
+    def add_elf(self, path):
+        elf = ELFFile(open(path, 'rb'))
+        for sec in elf.iter_sections():
+            if not isinstance(sec, SymbolTableSection):
+                continue
+            for sym in sec.iter_symbols():
+                if sym['st_info']['type'] not in ('STT_FUNC', 'STT_NOTYPE'):
+                    continue
+                if not sym.name or sym.name.startswith('$'):
+                    continue
+                # Clear the Thumb/compressed bit some toolchains set.
+                addr = sym['st_value'] & ~1
+                if addr and (addr not in self.syms or sym['st_size']):
+                    self.syms[addr] = (sym.name, sym['st_size'])
+
+    def add_ld(self, path):
+        for line in open(path):
+            m = LDSYM.match(line)
+            if m:
+                self.syms.setdefault(int(m.group(2), 16) & ~1,
+                                     (m.group(1), 0))
+
+    def freeze(self):
+        self.addrs = sorted(self.syms)
+
+    def lookup(self, pc):
+        i = bisect.bisect_right(self.addrs, pc) - 1
+        if i < 0:
+            return '%#x' % pc
+        start = self.addrs[i]
+        name, size = self.syms[start]
+        if size and pc >= start + size:
+            return '%#x' % pc
+        return name
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument('--folded', action='store_true',
+                    help='print task;function folded stacks')
+    ap.add_argument('-n', type=int, default=40,
+                    help='number of functions in the flat profile')
+    ap.add_argument('dump')
+    ap.add_argument('symfile', nargs='+',
+                    help='ELF file or linker script with symbol values')
+    args = ap.parse_args()
+
+    syms = Symbols()
+    for path in args.symfile:
+        if path.endswith('.ld') or path.endswith('.lds'):
+            syms.add_ld(path)
+        else:
+            syms.add_elf(path)
+    syms.freeze()
+
+    tasks = {}
+    period = 0
+    samples = []
+    for line in open(args.dump, errors='replace'):
+        f = line.split()
+        if len(f) == 2 and f[0] == 'P':
+            period = int(f[1])
+        elif len(f) >= 4 and f[0] == 'T':
+            tasks[int(f[1], 16)] = ' '.join(f[3:])
+        elif len(f) == 3 and f[0] == 'S':
+            samples.append((int(f[1], 16), int(f[2], 16)))
+
+    if not samples:
+        return
+
+    if args.folded:
+        stacks = collections.Counter()
+        for pc, task in samples:
+            name = tasks.get(task, '%#x' % task) if task else 'notask'
+            stacks[name + ';' + syms.lookup(pc)] += 1
+        for stack, n in sorted(stacks.items()):
+            print(stack, n)
+        return
+
+    funcs = collections.Counter(syms.lookup(pc) for pc, _ in samples)
+    total = len(samples)
+    print('%d samples' % total
+          + (', %d us apart' % period if period else ''))
+    print('%8s %7s  %s' % ('samples', '%', 'function'))
+    for name, n in funcs.most_common(args.n):
+        print('%8d %6.2f%%  %s' % (n, 100.0 * n / total, name))
+
+
+if __name__ == '__main__':
+    main()